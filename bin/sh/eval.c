@@ -95,6 +95,9 @@ static void exphere(union node *, struct arglist *);
 static void expredir(union node *);
 static void evalpipe(union node *);
 static int is_valid_fast_cmdsubst(union node *n);
+static int is_fast_cmdsubst_tree(union node *n);
+static void fast_cmdsubst_done(struct backcmd *, struct output *,
+    struct output *);
 static void evalcommand(union node *, int, struct backcmd *);
 static void prehash(union node *);
 
@@ -631,6 +634,107 @@ is_valid_fast_cmdsubst(union node *n)
 	return (n->type == NCMD);
 }
 
+/*
+ * Extract a word that needs no expansion into buf, as in mustexpandto().
+ * Returns zero if the word is not literal or does not fit.
+ */
+static int
+get_literal_text(const char *argtext, char *buf, size_t bufsize)
+{
+	size_t i = 0;
+
+	for (;;) {
+		if (*argtext == CTLQUOTEMARK || *argtext == CTLQUOTEEND) {
+			argtext++;
+			continue;
+		}
+		if (*argtext == CTLESC)
+			argtext++;
+		else if (BASESYNTAX[(int)*argtext] == CCTL)
+			return (0);
+		if (i >= bufsize - 1)
+			return (0);
+		if ((buf[i++] = *argtext) == '\0')
+			return (1);
+		argtext++;
+	}
+}
+
+/*
+ * Check if a simple command in a multi-command substitution is certain
+ * to resolve to a builtin that can run in this process.  Unlike the
+ * single-command case, a command that turns out to need a subshell
+ * cannot fall back to a fork once its siblings have written to the
+ * in-memory stdout, so only literal command words naming always-safe
+ * builtins not shadowed by a function are accepted, and redirections
+ * and leading assignments are not.  "builtin" and "command" are
+ * excluded since they may re-dispatch to an external command.
+ */
+static int
+is_fast_cmdsubst_cmd(union node *n)
+{
+	char name[16];
+	int idx, spec;
+
+	if (n->ncmd.redirect != NULL || n->ncmd.args == NULL)
+		return (0);
+	if (!get_literal_text(n->ncmd.args->narg.text, name, sizeof(name)))
+		return (0);
+	if (isfunc(name))
+		return (0);
+	idx = find_builtin(name, &spec);
+	if (idx < 0 || !safe_builtin_always(idx) ||
+	    idx == BLTINCMD || idx == COMMANDCMD)
+		return (0);
+	return (1);
+}
+
+/*
+ * Check if a command substitution containing more than one command can
+ * be evaluated in this process with standard output captured in memory,
+ * which requires every command in the tree to pass
+ * is_fast_cmdsubst_cmd().  -e aborts a subshell without killing the
+ * main shell, which cannot be imitated here, so require it to be off.
+ */
+static int
+is_fast_cmdsubst_tree(union node *n)
+{
+
+	if (eflag)
+		return (0);
+	switch (n->type) {
+	case NSEMI:
+	case NAND:
+	case NOR:
+		return (is_fast_cmdsubst_tree(n->nbinary.ch1) &&
+		    is_fast_cmdsubst_tree(n->nbinary.ch2));
+	case NNOT:
+		return (is_fast_cmdsubst_tree(n->nnot.com));
+	case NCMD:
+		return (is_fast_cmdsubst_cmd(n));
+	default:
+		return (0);
+	}
+}
+
+/*
+ * Hand the memory-captured output of a multi-command substitution to
+ * the result and restore the previous capture state, which may belong
+ * to an enclosing substitution still being evaluated.
+ */
+static void
+fast_cmdsubst_done(struct backcmd *result, struct output *saveout1,
+    struct output *savememout)
+{
+
+	out1 = saveout1;
+	if (memout.buf != NULL) {
+		result->buf = memout.buf;
+		result->nleft = memout.nextc - memout.buf;
+	}
+	memout = *savememout;
+}
+
 /*
  * Execute a command inside back quotes.  If it's a builtin command, we
  * want to save its output in a block obtained from malloc.  Otherwise
@@ -647,6 +751,8 @@ evalbackcmd(union node *n, struct backcmd *result)
 	struct jmploc jmploc;
 	struct jmploc *savehandler;
 	struct localvar *savelocalvars;
+	struct output *saveout1;
+	struct output savememout;
 	unsigned char saveoptreset;
 
 	result->fd = -1;
@@ -659,13 +765,32 @@ evalbackcmd(union node *n, struct backcmd *result)
 	}
 	setstackmark(&smark);
 	exitstatus = oexitstatus;
-	if (is_valid_fast_cmdsubst(n)) {
+	if (is_valid_fast_cmdsubst(n) || is_fast_cmdsubst_tree(n)) {
 		savelocalvars = localvars;
 		localvars = NULL;
 		saveoptreset = shellparam.reset;
 		forcelocal++;
+		/*
+		 * Stack the capture state: an enclosing multi-command
+		 * substitution may already be collecting output in memout,
+		 * and nested substitutions in our own arguments will do
+		 * the same.
+		 */
+		saveout1 = out1;
+		savememout = memout;
+		memout.buf = NULL;
+		memout.nextc = NULL;
+		memout.bufend = NULL;
+		memout.bufsize = 64;
 		savehandler = handler;
 		if (setjmp(jmploc.loc)) {
+			/*
+			 * If an exception interrupted a multi-command
+			 * substitution, hand over the output collected so
+			 * far.  A single command has already done its own
+			 * transfer and left memout empty.
+			 */
+			fast_cmdsubst_done(result, saveout1, &savememout);
 			if (exception == EXERROR)
 				/* nothing */;
 			else if (exception != 0) {
@@ -678,7 +803,20 @@ evalbackcmd(union node *n, struct backcmd *result)
 			}
 		} else {
 			handler = &jmploc;
-			evalcommand(n, EV_BACKCMD, result);
+			if (n->type == NCMD)
+				evalcommand(n, EV_BACKCMD, result);
+			else {
+				/*
+				 * Point stdout at the memory buffer and
+				 * let evaltree() handle the control flow;
+				 * each builtin appends to the buffer, as
+				 * evalcommand() restores out1 to its value
+				 * on entry around every command.
+				 */
+				out1 = &memout;
+				evaltree(n, 0);
+			}
+			fast_cmdsubst_done(result, saveout1, &savememout);
 		}
 		handler = savehandler;
 		forcelocal--;
@@ -831,6 +969,7 @@ evalcommand(union node *cmd, int flags, struct backcmd *backcmd)
 	struct jmploc jmploc;
 	struct jmploc *savehandler;
 	char *savecmdname;
+	struct output *saveout1, *saveout2;
 	struct shparam saveparam;
 	struct localvar *savelocalvars;
 	struct parsefile *savetopfile;
@@ -1078,6 +1217,13 @@ evalcommand(union node *cmd, int flags, struct backcmd *backcmd)
 			mode |= REDIR_BACKQ;
 		}
 		savecmdname = commandname;
+		/*
+		 * During a multi-command substitution out1 already points
+		 * at memout; restore that rather than &output so the
+		 * capture survives across the commands of the tree.
+		 */
+		saveout1 = out1;
+		saveout2 = out2;
 		savetopfile = getcurrentfile();
 		cmdenviron = &varlist;
 		e = -1;
@@ -1115,8 +1261,8 @@ cmddone:
 		if (argc > 0)
 			bltinunsetlocale();
 		cmdenviron = NULL;
-		out1 = &output;
-		out2 = &errout;
+		out1 = saveout1;
+		out2 = saveout2;
 		freestdout();
 		handler = savehandler;
 		commandname = savecmdname;
@@ -43,6 +43,7 @@
 
 #include <signal.h>
 #include <syslog.h>
+#include <time.h>
 
 #include <climits>
 #include <list>
@@ -60,8 +61,25 @@
 #include "zfsd.h"
 #include "zfsd_exception.h"
 
-std::list<Callout *> Callout::s_activeCallouts;
-bool		     Callout::s_alarmFired(false);
+Callout::CalloutTable Callout::s_activeCallouts;
+bool		      Callout::s_alarmFired(false);
+
+/**
+ * \brief Report the current time on the monotonic clock.
+ *
+ * Expiration bookkeeping uses the monotonic clock so that steps of the
+ * wall clock neither delay nor prematurely fire callouts.
+ */
+static timeval
+CurrentUptime()
+{
+	struct timespec now;
+	timeval	        uptime;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	TIMESPEC_TO_TIMEVAL(&uptime, &now);
+	return (uptime);
+}
 
 void
 Callout::Init()
@@ -69,76 +87,63 @@ Callout::Init()
 	signal(SIGALRM,  Callout::AlarmSignalHandler);
 }
 
+void
+Callout::ArmTimer()
+{
+	itimerval timerval = { { 0, 0 }, { 0, 0 } };
+
+	if (!s_activeCallouts.empty()) {
+		const timeval &expiry(s_activeCallouts.begin()->first);
+		timeval        now(CurrentUptime());
+
+		if (timercmp(&expiry, &now, >)) {
+			timersub(&expiry, &now, &timerval.it_value);
+		} else {
+			/* Already due.  Fire as soon as possible. */
+			timerval.it_value.tv_usec = 1;
+		}
+	}
+	setitimer(ITIMER_REAL, &timerval, NULL);
+}
+
 bool
 Callout::Stop()
 {
+	bool wasNearest;
+
 	if (!IsPending())
 		return (false);
 
-	for (std::list<Callout *>::iterator it(s_activeCallouts.begin());
-	     it != s_activeCallouts.end(); it++) {
-		if (*it != this)
-			continue;
-
-		it = s_activeCallouts.erase(it);
-		if (it != s_activeCallouts.end()) {
-
-			/*
-			 * Maintain correct interval for the
-			 * callouts that follow the just removed
-			 * entry.
-			 */
-			timeradd(&(*it)->m_interval, &m_interval,
-				 &(*it)->m_interval);
-		}
-		break;
-	}
+	wasNearest = (m_entry == s_activeCallouts.begin());
+	s_activeCallouts.erase(m_entry);
 	m_pending = false;
+
+	if (wasNearest)
+		ArmTimer();
 	return (true);
 }
 
 bool
 Callout::Reset(const timeval &interval, CalloutFunc_t *func, void *arg)
 {
-	bool cancelled(false);
+	timeval now;
+	bool	cancelled(false);
 
 	if (!timerisset(&interval))
 		throw ZfsdException("Callout::Reset: interval of 0");
 
 	cancelled = Stop();
 
-	m_interval = interval;
+	now	   = CurrentUptime();
+	timeradd(&now, &interval, &m_expiry);
 	m_func     = func;
 	m_arg      = arg;
 	m_pending  = true;
+	m_entry    = s_activeCallouts.insert(
+	    CalloutTable::value_type(m_expiry, this));
 
-	std::list<Callout *>::iterator it(s_activeCallouts.begin());
-	for (; it != s_activeCallouts.end(); it++) {
-
-		if (timercmp(&(*it)->m_interval, &m_interval, <=)) {
-			/*
-			 * Decrease our interval by those that come
-			 * before us.
-			 */
-			timersub(&m_interval, &(*it)->m_interval, &m_interval);
-		} else {
-			/*
-			 * Account for the time between the newly
-			 * inserted event and those that follow.
-			 */
-			timersub(&(*it)->m_interval, &m_interval,
-				 &(*it)->m_interval);
-			break;
-		}
-	}
-	s_activeCallouts.insert(it, this);
-
-
-	if (s_activeCallouts.front() == this) {
-		itimerval timerval = { {0, 0}, m_interval };
-
-		setitimer(ITIMER_REAL, &timerval, NULL);
-	}
+	if (m_entry == s_activeCallouts.begin())
+		ArmTimer();
 
 	return (cancelled);
 }
@@ -153,49 +158,39 @@ Callout::AlarmSignalHandler(int)
 void
 Callout::ExpireCallouts()
 {
+	timeval now;
+
 	if (!s_alarmFired)
 		return;
 
 	s_alarmFired = false;
-	if (s_activeCallouts.empty()) {
-		/* Callout removal/SIGALRM race was lost. */
-		return;
-	}
 
 	/*
-	 * Expire the first callout (the one we used to set the
-	 * interval timer) as well as any callouts following that
-	 * expire at the same time (have a zero interval from
-	 * the callout before it).
+	 * Expire every callout that is due.  Callbacks are free to
+	 * establish new callouts, so the nearest entry is refetched on
+	 * each iteration.
 	 */
-	do {
-		Callout *cur(s_activeCallouts.front());
-		s_activeCallouts.pop_front();
-		cur->m_pending = false;
-		cur->m_func(cur->m_arg);
-	} while (!s_activeCallouts.empty()
-	      && timerisset(&s_activeCallouts.front()->m_interval) == 0);
+	now = CurrentUptime();
+	while (!s_activeCallouts.empty()) {
+		CalloutTable::iterator nearest(s_activeCallouts.begin());
+		Callout *cur(nearest->second);
 
-	if (!s_activeCallouts.empty()) {
-		Callout *next(s_activeCallouts.front());
-		itimerval timerval = { { 0, 0 }, next->m_interval };
+		if (timercmp(&nearest->first, &now, >))
+			break;
 
-		setitimer(ITIMER_REAL, &timerval, NULL);
+		s_activeCallouts.erase(nearest);
+		cur->m_pending = false;
+		cur->m_func(cur->m_arg);
 	}
+
+	ArmTimer();
 }
 
 timeval
 Callout::TimeRemaining() const
 {
-	/*
-	 * Outline: Add the m_interval for each callout in s_activeCallouts
-	 * ahead of this, except for the first callout.  Add to that the result
-	 * of getitimer (That's because the first callout stores its original
-	 * interval setting while the timer is ticking).
-	 */
-	itimerval timervalToAlarm;
+	timeval now;
 	timeval timeToExpiry;
-	std::list<Callout *>::iterator it;
 
 	if (!IsPending()) {
 		timeToExpiry.tv_sec = INT_MAX;
@@ -203,17 +198,10 @@ Callout::TimeRemaining() const
 		return (timeToExpiry);
 	}
 
-	timerclear(&timeToExpiry);
-	getitimer(ITIMER_REAL, &timervalToAlarm);
-	timeval& timeToAlarm = timervalToAlarm.it_value;
-	timeradd(&timeToExpiry, &timeToAlarm, &timeToExpiry);
-
-	it =s_activeCallouts.begin();
-	it++;	/*skip the first callout in the list*/
-	for (; it != s_activeCallouts.end(); it++) {
-		timeradd(&timeToExpiry, &(*it)->m_interval, &timeToExpiry);
-		if ((*it) == this)
-			break;
-	}
+	now = CurrentUptime();
+	if (timercmp(&m_expiry, &now, >))
+		timersub(&m_expiry, &now, &timeToExpiry);
+	else
+		timerclear(&timeToExpiry);
 	return (timeToExpiry);
 }
@@ -41,7 +41,7 @@
  *
  *     #include <sys/time.h>
  *
- *     #include <list>
+ *     #include <map>
  */
 
 #ifndef _CALLOUT_H_
@@ -84,6 +84,11 @@ public:
 	 */
 	static void ExpireCallouts();
 
+	/**
+	 * Report the number of callouts currently waiting to expire.
+	 */
+	static size_t PendingCount();
+
 	/** Constructor. */
 	Callout();
 
@@ -133,11 +138,34 @@ public:
 	timeval TimeRemaining() const;
 
 private:
+	/** Comparator ordering timevals chronologically. */
+	struct ExpiryLess
+	{
+		bool operator()(const timeval &lhs, const timeval &rhs) const
+		{
+			return (timercmp(&lhs, &rhs, <));
+		}
+	};
+
+	/**
+	 * Table type for the active callouts, keyed and ordered by
+	 * absolute expiration time.
+	 */
+	typedef std::multimap<timeval, Callout *, ExpiryLess> CalloutTable;
+
+	/**
+	 * Arm the interval timer to fire at the nearest pending
+	 * expiration time, or disarm it if no callouts are pending.
+	 */
+	static void ArmTimer();
+
 	/**
-	 * All active callouts sorted by expiration time.  The callout
-	 * with the nearest expiration time is at the head of the list.
+	 * All active callouts.  Each callout is inserted keyed by its
+	 * expiration time and holds an iterator to its own entry, so
+	 * that arming and cancelling a callout cost one tree operation
+	 * regardless of how many cases have timers outstanding.
 	 */
-	static std::list<Callout *> s_activeCallouts;
+	static CalloutTable         s_activeCallouts;
 
 	/**
 	 * The interval timer has expired.  This variable is set from
@@ -147,10 +175,16 @@ private:
 	static bool                 s_alarmFired;
 
 	/**
-	 * Time, relative to others in the active list, until
-	 * this callout is fired.
+	 * Absolute time, on the monotonic clock, at which this callout
+	 * fires.
+	 */
+	timeval                     m_expiry;
+
+	/**
+	 * This callout's entry in s_activeCallouts.  Only valid while
+	 * the callout is pending.
 	 */
-	timeval                     m_interval;
+	CalloutTable::iterator      m_entry;
 
 	/** Callback function argument. */
 	void                       *m_arg;
@@ -165,6 +199,13 @@ private:
 	bool                        m_pending;
 };
 
+//- Callout public static methods ---------------------------------------------
+inline size_t
+Callout::PendingCount()
+{
+	return (s_activeCallouts.size());
+}
+
 //- Callout public const methods ----------------------------------------------
 inline bool
 Callout::IsPending() const
@@ -179,7 +220,7 @@ Callout::Callout()
    m_func(NULL),
    m_pending(false)
 {
-	timerclear(&m_interval);
+	timerclear(&m_expiry);
 }
 
 #endif /* CALLOUT_H_ */
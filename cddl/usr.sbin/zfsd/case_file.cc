@@ -696,7 +696,14 @@ CaseFile::DeSerializeSelector(const struct dirent *dirEntry)
 {
 	uint64_t poolGUID;
 	uint64_t vdevGUID;
+	size_t   nameLen(strlen(dirEntry->d_name));
 
+	/*
+	 * Skip anything that isn't exactly a .case file; in particular a
+	 * .case.tmp left over from a crash mid-Serialize().
+	 */
+	if (nameLen < 5 || strcmp(dirEntry->d_name + nameLen - 5, ".case") != 0)
+		return (0);
 	if (dirEntry->d_type == DT_REG
 	 && sscanf(dirEntry->d_name, "pool_%" PRIu64 "_vdev_%" PRIu64 ".case",
 		   &poolGUID, &vdevGUID) == 2)
@@ -835,19 +842,16 @@ CaseFile::PurgeTentativeEvents()
 }
 
 void
-CaseFile::SerializeEvList(const EventList events, int fd,
+CaseFile::SerializeEvList(const EventList &events, string &buffer,
 		const char* prefix) const
 {
-	if (events.empty())
-		return;
 	for (EventList::const_iterator curEvent = events.begin();
 	     curEvent != events.end(); curEvent++) {
 		const string &eventString((*curEvent)->GetEventString());
 
-		// TODO: replace many write(2) calls with a single writev(2)
 		if (prefix)
-			write(fd, prefix, strlen(prefix));
-		write(fd, eventString.c_str(), eventString.length());
+			buffer.append(prefix);
+		buffer.append(eventString);
 	}
 }
 
@@ -855,6 +859,7 @@ void
 CaseFile::Serialize()
 {
 	stringstream saveFile;
+	string snapshot;
 
 	saveFile << setfill('0')
 		 << s_caseFilePath << "/"
@@ -867,14 +872,30 @@ CaseFile::Serialize()
 		return;
 	}
 
-	int fd(open(saveFile.str().c_str(), O_CREAT|O_TRUNC|O_WRONLY, 0644));
+	/*
+	 * Assemble the complete snapshot in core and commit it with a
+	 * single write to a temporary file that replaces the old case
+	 * atomically, so a crash mid-serialization can never leave a
+	 * truncated or interleaved case on disk.
+	 */
+	SerializeEvList(m_events, snapshot);
+	SerializeEvList(m_tentativeEvents, snapshot, "tentative ");
+
+	string tmpFile(saveFile.str() + ".tmp");
+	int fd(open(tmpFile.c_str(), O_CREAT|O_TRUNC|O_WRONLY, 0644));
 	if (fd == -1) {
 		syslog(LOG_ERR, "CaseFile::Serialize: Unable to open %s.\n",
-		       saveFile.str().c_str());
+		       tmpFile.c_str());
 		return;
 	}
-	SerializeEvList(m_events, fd);
-	SerializeEvList(m_tentativeEvents, fd, "tentative ");
+	if (write(fd, snapshot.c_str(), snapshot.length())
+	 != (ssize_t)snapshot.length()
+	 || fsync(fd) != 0
+	 || rename(tmpFile.c_str(), saveFile.str().c_str()) != 0) {
+		syslog(LOG_ERR, "CaseFile::Serialize: Unable to write %s.\n",
+		       tmpFile.c_str());
+		unlink(tmpFile.c_str());
+	}
 	close(fd);
 }
 
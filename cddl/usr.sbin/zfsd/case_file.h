@@ -292,12 +292,16 @@ protected:
 	void DeSerialize(std::ifstream &caseStream);
 
 	/**
-	 * \brief Serializes the supplied event list and writes it to fd
+	 * \brief Serializes the supplied event list into the snapshot
+	 *        buffer.
 	 *
+	 * \param buffer  The in-core snapshot being assembled; the whole
+	 *                buffer is later committed with a single write.
 	 * \param prefix  If not NULL, this prefix will be prepended to
 	 *                every event in the file.
 	 */
-	void SerializeEvList(const DevdCtl::EventList events, int fd,
+	void SerializeEvList(const DevdCtl::EventList &events,
+			     std::string &buffer,
 			     const char* prefix=NULL) const;
 
 	/**
@@ -0,0 +1,333 @@
+/*-
+ * Copyright (c) 2012, 2013, 2014 Spectra Logic Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions, and the following disclaimer,
+ *    without modification.
+ * 2. Redistributions in binary form must reproduce at minimum a disclaimer
+ *    substantially similar to the "NO WARRANTY" disclaimer below
+ *    ("Disclaimer") and any redistribution must be conditioned upon
+ *    including a substantially similar Disclaimer requirement for further
+ *    binary redistribution.
+ *
+ * NO WARRANTY
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTIBILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDERS OR CONTRIBUTORS BE LIABLE FOR SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+ * STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING
+ * IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGES.
+ */
+
+/**
+ * \file zfsd_replay.cc
+ *
+ * Replay benchmark for the zfsd event pipeline.
+ *
+ * Feeds a recorded devctl event stream through the same event factory
+ * and Process() path the daemon uses, against the libzfs mocks from
+ * libmocks.c, and reports throughput, per-stage latency, and allocation
+ * counts.  Intended for measuring the daemon before deployment on large
+ * installations; a small built-in stream is replayed when no capture
+ * file is supplied so the program also serves as a smoke test.
+ *
+ * Usage: zfsd_replay [-f capture] [-n iterations] [-r rate]
+ *
+ *   -f capture     Replay the devctl event lines in the named file.
+ *   -n iterations  Replay the stream this many times (default 100).
+ *   -r rate        Pace replay at this many events per second
+ *                  (default 0, unpaced).
+ *
+ * Events of type misc.fs.zfs.config_sync are skipped (and counted),
+ * since processing them requires the ZfsDaemon singleton which this
+ * harness does not instantiate.
+ */
+#include <sys/cdefs.h>
+#include <sys/fs/zfs.h>
+#include <sys/time.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libzfs.h>
+
+#include <fstream>
+#include <list>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <devdctl/guid.h>
+#include <devdctl/event.h>
+#include <devdctl/event_factory.h>
+#include <devdctl/exception.h>
+#include <devdctl/consumer.h>
+
+#include <zfsd/callout.h>
+#include <zfsd/vdev_iterator.h>
+#include <zfsd/zfsd_event.h>
+#include <zfsd/case_file.h>
+#include <zfsd/vdev.h>
+#include <zfsd/zfsd.h>
+#include <zfsd/zfsd_exception.h>
+#include <zfsd/zpool_list.h>
+
+#include "libmocks.h"
+
+__FBSDID("$FreeBSD$");
+
+/*================================== Macros ==================================*/
+#define	NUM_ELEMENTS(x) (sizeof(x) / sizeof(*x))
+
+/*============================ Namespace Control =============================*/
+using std::string;
+
+using DevdCtl::Consumer;
+using DevdCtl::Event;
+using DevdCtl::EventFactory;
+using DevdCtl::EventList;
+
+/*============================ Allocation Counting ===========================*/
+static uint64_t g_numAllocs;
+
+void *
+operator new(size_t size)
+{
+	g_numAllocs++;
+	return (malloc(size));
+}
+
+void
+operator delete(void *mem) throw()
+{
+	free(mem);
+}
+
+/*=============================== ReplayConsumer =============================*/
+/**
+ * Consumer with the daemon's factory registry that accepts events from
+ * a replayed stream instead of the devd socket.
+ */
+class ReplayConsumer : public Consumer
+{
+public:
+	ReplayConsumer();
+
+	/** Discard events queued by SaveEvent() during a replay pass. */
+	void DiscardSavedEvents();
+
+private:
+	static EventFactory::Record s_registryEntries[];
+};
+
+EventFactory::Record ReplayConsumer::s_registryEntries[] =
+{
+	{ Event::NOTIFY, "GEOM",  &GeomEvent::Builder },
+	{ Event::NOTIFY, "ZFS",   &ZfsEvent::Builder }
+};
+
+ReplayConsumer::ReplayConsumer()
+ : Consumer(/*defBuilder*/NULL, s_registryEntries,
+	    NUM_ELEMENTS(s_registryEntries))
+{
+}
+
+void
+ReplayConsumer::DiscardSavedEvents()
+{
+	while (!m_unconsumedEvents.empty()) {
+		delete m_unconsumedEvents.front();
+		m_unconsumedEvents.pop_front();
+	}
+}
+
+/*================================ Measurement ===============================*/
+/** Accumulated latency figures for one pipeline stage. */
+struct StageStats
+{
+	uint64_t totalNsec;
+	uint64_t maxNsec;
+	uint64_t samples;
+
+	StageStats() : totalNsec(0), maxNsec(0), samples(0) {}
+
+	void Record(uint64_t nsec)
+	{
+		totalNsec += nsec;
+		if (nsec > maxNsec)
+			maxNsec = nsec;
+		samples++;
+	}
+
+	uint64_t AvgNsec() const
+	{
+		return (samples == 0 ? 0 : totalNsec / samples);
+	}
+};
+
+static uint64_t
+NsecNow()
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec);
+}
+
+/*==================================== main ==================================*/
+/**
+ * A small mixed stream modeled on a capture from a disk shelf loss:
+ * vdev error reports, pool administrative traffic, and DEVFS noise the
+ * factory drops.
+ */
+static const char *s_builtinStream[] = {
+	"!system=ZFS subsystem=ZFS type=misc.fs.zfs.vdev_remove "
+	    "pool_name=tank pool_guid=12345678901234567 "
+	    "vdev_guid=7654321076543210\n",
+	"!system=ZFS subsystem=ZFS type=ereport.fs.zfs.io "
+	    "class=ereport.fs.zfs.io pool_guid=12345678901234567 "
+	    "vdev_guid=7654321076543210\n",
+	"!system=ZFS subsystem=ZFS type=ereport.fs.zfs.checksum "
+	    "class=ereport.fs.zfs.checksum pool_guid=12345678901234567 "
+	    "vdev_guid=7654321076543211\n",
+	"!system=DEVFS subsystem=CDEV type=DESTROY cdev=da12\n",
+	"!system=ZFS subsystem=ZFS type=misc.fs.zfs.resilver_start "
+	    "pool_name=tank pool_guid=12345678901234567\n",
+};
+
+static void
+usage()
+{
+	fprintf(stderr,
+	    "usage: zfsd_replay [-f capture] [-n iterations] [-r rate]\n");
+	exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+	std::vector<string> stream;
+	const char	   *captureFile(NULL);
+	uint64_t	    iterations(100);
+	uint64_t	    rate(0);
+	int		    ch;
+
+	while ((ch = getopt(argc, argv, "f:n:r:")) != -1) {
+		switch (ch) {
+		case 'f':
+			captureFile = optarg;
+			break;
+		case 'n':
+			iterations = strtoull(optarg, NULL, 10);
+			break;
+		case 'r':
+			rate = strtoull(optarg, NULL, 10);
+			break;
+		default:
+			usage();
+		}
+	}
+
+	if (captureFile != NULL) {
+		std::ifstream input(captureFile);
+		string	      line;
+
+		if (!input)
+			err(1, "%s", captureFile);
+		while (std::getline(input, line)) {
+			if (line.empty())
+				continue;
+			stream.push_back(line + "\n");
+		}
+	} else {
+		for (size_t i(0); i < NUM_ELEMENTS(s_builtinStream); i++)
+			stream.push_back(s_builtinStream[i]);
+	}
+
+	if (stream.empty())
+		errx(1, "empty event stream");
+
+	ReplayConsumer consumer;
+	StageStats     parseStats;
+	StageStats     processStats;
+	uint64_t       numReplayed(0);
+	uint64_t       numDropped(0);
+	uint64_t       numSkipped(0);
+	uint64_t       allocsBefore(g_numAllocs);
+	uint64_t       startNsec(NsecNow());
+
+	for (uint64_t pass(0); pass < iterations; pass++) {
+		for (size_t i(0); i < stream.size(); i++) {
+			const string &evString(stream[i]);
+			uint64_t      stageStart;
+			Event	     *event;
+
+			if (evString.find("type=misc.fs.zfs.config_sync")
+			    != string::npos) {
+				numSkipped++;
+				continue;
+			}
+
+			stageStart = NsecNow();
+			event = Event::CreateEvent(consumer.GetFactory(),
+						   evString);
+			parseStats.Record(NsecNow() - stageStart);
+
+			if (event == NULL) {
+				numDropped++;
+				continue;
+			}
+
+			stageStart = NsecNow();
+			if (event->Process())
+				consumer.SaveEvent(*event);
+			processStats.Record(NsecNow() - stageStart);
+			delete event;
+			numReplayed++;
+
+			if (rate != 0)
+				usleep(1000000 / rate);
+		}
+		consumer.DiscardSavedEvents();
+	}
+
+	uint64_t elapsedNsec(NsecNow() - startNsec);
+	uint64_t numAllocs(g_numAllocs - allocsBefore);
+	uint64_t numEvents(numReplayed + numDropped);
+	double	 elapsedSec((double)elapsedNsec / 1e9);
+
+	printf("events replayed:     %ju (%ju dropped by factory, "
+	       "%ju config_sync skipped)\n",
+	       (uintmax_t)numReplayed, (uintmax_t)numDropped,
+	       (uintmax_t)numSkipped);
+	printf("elapsed:             %.3f s\n", elapsedSec);
+	printf("throughput:          %.0f events/sec\n",
+	       elapsedSec == 0 ? 0 : (double)numEvents / elapsedSec);
+	printf("parse latency:       avg %ju ns, max %ju ns\n",
+	       (uintmax_t)parseStats.AvgNsec(), (uintmax_t)parseStats.maxNsec);
+	printf("process latency:     avg %ju ns, max %ju ns\n",
+	       (uintmax_t)processStats.AvgNsec(),
+	       (uintmax_t)processStats.maxNsec);
+	printf("allocations:         %ju total, %.1f per event\n",
+	       (uintmax_t)numAllocs,
+	       numEvents == 0 ? 0 : (double)numAllocs / numEvents);
+
+	return (0);
+}
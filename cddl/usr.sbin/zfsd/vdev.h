@@ -59,6 +59,12 @@ typedef struct nvlist nvlist_t;
 /**
  * \brief Wrapper class for a vdev's name/value configuration list
  *        simplifying access to commonly used vdev attributes.
+ *
+ * Vdev is a non-owning view: it borrows the configuration lists it is
+ * handed rather than duplicating them, so constructing a Vdev costs a
+ * pair of GUID lookups and no allocation.  The borrowed data remains
+ * owned by its producer, typically the zpool_handle_t the config was
+ * fetched from, and a Vdev must not outlive it.
  */
 class Vdev
 {
@@ -143,7 +149,11 @@ private:
 	bool			 VdevLookupPoolGuid();
 	DevdCtl::Guid		 m_poolGUID;
 	DevdCtl::Guid		 m_vdevGUID;
+
+	/** Borrowed pool configuration data.  Not freed on destruction. */
 	nvlist_t		*m_poolConfig;
+
+	/** Borrowed vdev configuration data.  Not freed on destruction. */
 	nvlist_t		*m_config;
 };
 
@@ -41,12 +41,16 @@
 #include <sys/fs/zfs.h>
 
 #include <stdint.h>
+#include <string.h>
 #include <syslog.h>
 
 #include <libzfs.h>
 
 #include <list>
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <devdctl/exception.h>
 #include <devdctl/guid.h>
@@ -58,6 +62,24 @@
 /*============================ Namespace Control =============================*/
 using DevdCtl::Guid;
 
+/*================================ Private Data ==============================*/
+/**
+ * Location of a leaf vdev within a pool's vdev tree, expressed as the
+ * sequence of child array indices leading from the root vdev to the
+ * leaf.  Unlike an nvlist pointer, a location remains meaningful across
+ * re-fetches of the pool configuration, making it safe to cache for the
+ * lifetime of the daemon.
+ */
+typedef std::vector<uint32_t> VdevLocation;
+
+/**
+ * Cache of leaf vdev locations, keyed by pool and vdev GUID and
+ * populated by successful VdevIterator::Find() calls.  Entries are
+ * verified against the current pool configuration before use, so a
+ * stale entry costs one extra tree walk rather than a wrong answer.
+ */
+static std::map<std::pair<uint64_t, uint64_t>, VdevLocation> s_vdevLocations;
+
 /*=========================== Class Implementations ==========================*/
 /*------------------------------- VdevIterator -------------------------------*/
 VdevIterator::VdevIterator(zpool_handle_t *pool)
@@ -146,11 +168,141 @@ VdevIterator::Each(VdevCallback_t *callBack, void *callBackArg)
 	}
 }
 
+void
+VdevIterator::FlushLocationCache()
+{
+	s_vdevLocations.clear();
+}
+
+/**
+ * \brief Resolve a cached vdev location against the given root vdev.
+ *
+ * \param rootVdev  The root of the pool's vdev tree.
+ * \param location  The sequence of child indices to follow.
+ * \param vdevGUID  The GUID the located vdev must have.
+ *
+ * \return  The config of the vdev at the given location if it exists
+ *          and carries the expected GUID.  Otherwise NULL.
+ */
+static nvlist_t *
+vdev_location_resolve(nvlist_t *rootVdev, const VdevLocation &location,
+		      uint64_t vdevGUID)
+{
+	nvlist_t *vdevConfig(rootVdev);
+	uint64_t  guid;
+
+	for (VdevLocation::const_iterator it(location.begin());
+	     it != location.end(); it++) {
+		nvlist_t **vdevChildren;
+		u_int	   numChildren;
+
+		if (nvlist_lookup_nvlist_array(vdevConfig,
+		    ZPOOL_CONFIG_CHILDREN, &vdevChildren, &numChildren) != 0
+		 || *it >= numChildren)
+			return (NULL);
+		vdevConfig = vdevChildren[*it];
+	}
+
+	if (nvlist_lookup_uint64(vdevConfig, ZPOOL_CONFIG_GUID, &guid) != 0
+	 || guid != vdevGUID)
+		return (NULL);
+
+	return (vdevConfig);
+}
+
+/**
+ * \brief Search the vdev tree rooted at vdevConfig for a leaf vdev,
+ *        recording the location of the match.
+ *
+ * \param vdevConfig  Root of the (sub)tree to search.
+ * \param vdevGUID    The GUID of the desired leaf vdev.
+ * \param location    Accumulates the child indices traversed to reach
+ *                    the returned vdev.
+ *
+ * \return  The config of the matching leaf vdev, or NULL.
+ */
+static nvlist_t *
+vdev_location_search(nvlist_t *vdevConfig, uint64_t vdevGUID,
+		     VdevLocation &location)
+{
+	nvlist_t **vdevChildren;
+	u_int	   numChildren;
+	uint64_t   guid;
+
+	if (nvlist_lookup_nvlist_array(vdevConfig, ZPOOL_CONFIG_CHILDREN,
+	    &vdevChildren, &numChildren) == 0) {
+		for (u_int c(0); c < numChildren; c++) {
+			nvlist_t *found;
+
+			location.push_back(c);
+			found = vdev_location_search(vdevChildren[c],
+			    vdevGUID, location);
+			if (found != NULL)
+				return (found);
+			location.pop_back();
+		}
+		return (NULL);
+	}
+
+	/* Leaf vdev. */
+	if (nvlist_lookup_uint64(vdevConfig, ZPOOL_CONFIG_GUID, &guid) == 0
+	 && guid == vdevGUID)
+		return (vdevConfig);
+
+	return (NULL);
+}
+
 nvlist_t *
 VdevIterator::Find(Guid vdevGUID)
 {
 	nvlist_t *vdevConfig;
+	nvlist_t *rootVdev;
+	uint64_t  poolGUID;
+	char	 *rootType;
+
+	/*
+	 * When searching a full pool configuration, consult and maintain
+	 * the location cache so that repeated lookups of the same vdev,
+	 * as generated by e.g. the loss of an entire backplane of disks,
+	 * avoid walking the whole vdev tree for every event.  Vdev label
+	 * configs are excluded (their tree is rooted at a top level vdev
+	 * rather than the pool root), since locations recorded from them
+	 * would not resolve against the full configuration.
+	 */
+	if (nvlist_lookup_uint64(m_poolConfig, ZPOOL_CONFIG_POOL_GUID,
+	    &poolGUID) == 0
+	 && nvlist_lookup_nvlist(m_poolConfig, ZPOOL_CONFIG_VDEV_TREE,
+	    &rootVdev) == 0
+	 && nvlist_lookup_string(rootVdev, ZPOOL_CONFIG_TYPE,
+	    &rootType) == 0
+	 && strcmp(rootType, VDEV_TYPE_ROOT) == 0) {
+		std::pair<uint64_t, uint64_t> key(poolGUID,
+		    (uint64_t)vdevGUID);
+		std::map<std::pair<uint64_t, uint64_t>,
+		    VdevLocation>::iterator entry(s_vdevLocations.find(key));
+		VdevLocation location;
+
+		if (entry != s_vdevLocations.end()) {
+			vdevConfig = vdev_location_resolve(rootVdev,
+			    entry->second, (uint64_t)vdevGUID);
+			if (vdevConfig != NULL)
+				return (vdevConfig);
+			s_vdevLocations.erase(entry);
+		}
+
+		vdevConfig = vdev_location_search(rootVdev,
+		    (uint64_t)vdevGUID, location);
+		if (vdevConfig != NULL) {
+			s_vdevLocations[key] = location;
+			return (vdevConfig);
+		}
+	}
 
+	/*
+	 * Fall back to the linear scan for label configs lacking pool
+	 * wide data and for vdevs, such as cache devices, that live
+	 * outside the vdev tree proper.
+	 */
 	Reset();
 	while ((vdevConfig = Next()) != NULL) {
 		Vdev vdev(m_poolConfig, vdevConfig);
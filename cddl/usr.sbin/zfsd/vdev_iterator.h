@@ -101,8 +101,8 @@ public:
 	 * \return  A Vdev object for the matching vdev if found.  Otherwise
 	 *          NULL.
 	 *
-	 * Upon return, the VdevIterator's cursor points to the vdev just
-	 * past the returned vdev or end() if no matching vdev is found.
+	 * Upon return, the position of the VdevIterator's cursor is
+	 * unspecified.
 	 */
 	nvlist_t *Find(DevdCtl::Guid vdevGUID);
 
@@ -115,6 +115,16 @@ public:
 	 */
 	void	  Each(VdevCallback_t *cb, void *cbArg);
 
+	/**
+	 * \brief Discard all cached vdev locations.
+	 *
+	 * Invoked whenever a ZFS configuration change event is received.
+	 * Flushing is purely an optimization; cache entries are verified
+	 * against the current pool configuration before use, so stale
+	 * entries are detected and replaced as they are encountered.
+	 */
+	static void FlushLocationCache();
+
 private:
 	nvlist_t                *m_poolConfig;
 	std::list<nvlist_t *>	 m_vdevQueue;
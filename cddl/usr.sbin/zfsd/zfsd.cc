@@ -96,6 +96,7 @@ char		     ZfsDaemon::s_pidFilePath[] = "/var/run/zfsd.pid";
 pidfh		    *ZfsDaemon::s_pidFH;
 int		     ZfsDaemon::s_signalPipeFD[2];
 bool		     ZfsDaemon::s_systemRescanRequested(false);
+uint64_t	     ZfsDaemon::s_coalescedEvents(0);
 EventFactory::Record ZfsDaemon::s_registryEntries[] =
 {
 	{ Event::NOTIFY, "GEOM",  &GeomEvent::Builder },
@@ -320,7 +321,92 @@ ZfsDaemon::DetectMissedEvents()
 		 */
 	} while (s_terminateEventLoop == false && EventsPending());
 
-	RescanSystem();
+	/*
+	 * Walking every GEOM provider and reading its label can take
+	 * tens of seconds on large installations.  Cases restored from
+	 * their serialized state are already registered and their grace
+	 * timers re-armed (from the timestamps of the serialized
+	 * events), so defer the rescan to the event loop rather than
+	 * holding up fault handling while it runs.
+	 */
+	RequestSystemRescan();
+}
+
+bool
+ZfsDaemon::EventsCoalesce(const Event *queued, const Event *next)
+{
+	const string &type(next->Value("type"));
+
+	/*
+	 * Only pool administrative events are idempotent enough to
+	 * collapse.  Error reports carry a "class" instead of a "type"
+	 * and are left alone.
+	 */
+	if (type.find("misc.fs.zfs.") != 0)
+		return (false);
+
+	return (queued->Value("type") == type
+	     && queued->Value("vdev_guid") == next->Value("vdev_guid"));
+}
+
+void
+ZfsDaemon::ProcessEventsByPool()
+{
+	std::map<string, EventList> poolQueues;
+	EventList events;
+	bool	  queuesDrained;
+
+	/*
+	 * Partition the pending events by originating pool.  Events that
+	 * carry no pool guid, such as DEVFS device arrivals, land in a
+	 * queue of their own and are serviced alongside the others.
+	 */
+	NextEvents(events);
+	while (!events.empty()) {
+		Event *event(events.front());
+
+		events.pop_front();
+
+		EventList &queue(poolQueues[event->Value("pool_guid")]);
+
+		/*
+		 * Collapse runs of duplicate administrative events onto
+		 * their most recent instance.  During resilvers this
+		 * reduces a storm of case re-evaluations to one per
+		 * batch per (pool, vdev) pair.
+		 */
+		if (!queue.empty() && EventsCoalesce(queue.back(), event)) {
+			delete queue.back();
+			queue.pop_back();
+			s_coalescedEvents++;
+		}
+		queue.push_back(event);
+	}
+
+	/*
+	 * Service the queues round-robin, one event at a time, so that
+	 * pools make progress independently of each other.  Per-pool
+	 * event ordering is unaffected.
+	 */
+	do {
+		std::map<string, EventList>::iterator queue;
+
+		queuesDrained = true;
+		for (queue = poolQueues.begin();
+		     queue != poolQueues.end(); queue++) {
+			Event *event;
+
+			if (queue->second.empty())
+				continue;
+
+			event = queue->second.front();
+			queue->second.pop_front();
+			if (event->Process())
+				SaveEvent(*event);
+			delete event;
+			queuesDrained = false;
+		}
+	} while (!queuesDrained);
 }
 
 void
@@ -336,6 +422,10 @@ ZfsDaemon::EventLoop()
 			CaseFile::LogAll();
 			while (event != m_unconsumedEvents.end())
 				(*event++)->Log(LOG_INFO);
+			syslog(LOG_INFO, "%ju duplicate events coalesced",
+			       (uintmax_t)s_coalescedEvents);
+			syslog(LOG_INFO, "%zu callouts pending",
+			       Callout::PendingCount());
 		}
 
 		Callout::ExpireCallouts();
@@ -358,7 +448,7 @@ ZfsDaemon::EventLoop()
 		}
 
 		if ((fds[0].revents & POLLIN) != 0)
-			ProcessEvents();
+			ProcessEventsByPool();
 
 		if ((fds[1].revents & POLLIN) != 0) {
 			static char discardBuf[128];
@@ -134,6 +134,36 @@ private:
 	 */
 	void EventLoop();
 
+	/**
+	 * Drain all pending events and process them grouped by pool.
+	 *
+	 * Events are partitioned into per-pool queues which are serviced
+	 * round-robin, one event at a time.  Processing order within a
+	 * pool is preserved, but a storm of events against a single pool
+	 * can no longer starve the handling, and in particular the hot
+	 * spare activation, of every other pool in the system.
+	 */
+	void ProcessEventsByPool();
+
+	/**
+	 * Determine whether two queued events may be coalesced into one.
+	 *
+	 * Resilvers and scrubs flood the daemon with near identical pool
+	 * administrative events, each of which triggers a CaseFile
+	 * re-evaluation and re-serialization.  Adjacent events of the
+	 * same type for the same (pool, vdev) pair are collapsed to the
+	 * most recent instance before processing.  Error report events
+	 * are never coalesced, since CaseFile applies thresholds to
+	 * their exact counts.
+	 *
+	 * \param queued  The event most recently added to a pool's queue.
+	 * \param next    The event about to be added to the same queue.
+	 *
+	 * \return  True if queued may be discarded in favor of next.
+	 */
+	static bool EventsCoalesce(const DevdCtl::Event *queued,
+				   const DevdCtl::Event *next);
+
 	/**
 	 * Signal handler for which our response is to
 	 * log the current state of the daemon.
@@ -215,6 +245,13 @@ private:
 	 */
 	static bool				s_systemRescanRequested;
 
+	/**
+	 * Count of events dropped in favor of a newer duplicate by
+	 * EventsCoalesce().  Reported alongside the CaseFile state in
+	 * response to SIGINFO.
+	 */
+	static uint64_t				s_coalescedEvents;
+
 	/**
 	 * Flag controlling whether events can be queued.  This boolean
 	 * is set during event replay to ensure that events for pools or
@@ -279,6 +279,9 @@ ZfsEvent::Process() const
 
 	/* On config syncs, replay any queued events first. */
 	if (Value("type").find("misc.fs.zfs.config_sync") == 0) {
+		/* The set of imported pools may have changed. */
+		ZpoolList::InvalidateCache();
+		VdevIterator::FlushLocationCache();
 		/*
 		 * Even if saved events are unconsumed the second time
 		 * around, drop them.  Any events that still can't be
@@ -403,6 +406,8 @@ ZfsEvent::ProcessPoolEvent() const
 
 	/* The pool is destroyed.  Discard any open cases */
 	if (Value("type") == "misc.fs.zfs.pool_destroy") {
+		ZpoolList::InvalidateCache();
+		VdevIterator::FlushLocationCache();
 		Log(LOG_INFO);
 		CaseFile::ReEvaluateByGuid(PoolGUID(), *this);
 		return;
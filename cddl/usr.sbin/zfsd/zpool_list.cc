@@ -92,11 +92,28 @@ ZpoolList::ZpoolByName(zpool_handle_t *pool, nvlist_t *poolConfig, void *cbArg)
 	return (desiredPoolName == zpool_get_name(pool));
 }
 
+std::map<uint64_t, std::string> ZpoolList::s_poolNames;
+
+void
+ZpoolList::InvalidateCache()
+{
+	s_poolNames.clear();
+}
+
 int
 ZpoolList::LoadIterator(zpool_handle_t *pool, void *data)
 {
 	ZpoolList *zpl(reinterpret_cast<ZpoolList *>(data));
 	nvlist_t  *poolConfig(zpool_get_config(pool, NULL));
+	uint64_t   poolGUID;
+
+	/*
+	 * Record the GUID to name translation of every pool we visit, so
+	 * that subsequent by-GUID lookups can skip the full enumeration.
+	 */
+	if (nvlist_lookup_uint64(poolConfig, ZPOOL_CONFIG_POOL_GUID,
+	    &poolGUID) == 0)
+		s_poolNames[poolGUID] = zpool_get_name(pool);
 
 	if (zpl->m_filter(pool, poolConfig, zpl->m_filterArg))
 		zpl->push_back(pool);
@@ -105,10 +122,51 @@ ZpoolList::LoadIterator(zpool_handle_t *pool, void *data)
 	return (0);
 }
 
+bool
+ZpoolList::LoadCachedPool(uint64_t poolGUID)
+{
+	std::map<uint64_t, std::string>::iterator it(
+	    s_poolNames.find(poolGUID));
+	zpool_handle_t *pool;
+	nvlist_t       *poolConfig;
+	uint64_t	foundGUID;
+
+	if (it == s_poolNames.end())
+		return (false);
+
+	pool = zpool_open_canfail(g_zfsHandle, it->second.c_str());
+	if (pool == NULL) {
+		s_poolNames.erase(it);
+		return (false);
+	}
+
+	/*
+	 * The cache may be stale if the pool has been destroyed and its
+	 * name reused since the entry was recorded.  Verify the GUID and
+	 * fall back to a full enumeration on any mismatch.
+	 */
+	poolConfig = zpool_get_config(pool, NULL);
+	if (poolConfig == NULL
+	 || nvlist_lookup_uint64(poolConfig, ZPOOL_CONFIG_POOL_GUID,
+				 &foundGUID) != 0
+	 || foundGUID != poolGUID) {
+		zpool_close(pool);
+		s_poolNames.erase(it);
+		return (false);
+	}
+
+	push_back(pool);
+	return (true);
+}
+
 ZpoolList::ZpoolList(PoolFilter_t *filter, void * filterArg)
  : m_filter(filter),
    m_filterArg(filterArg)
 {
+	if (filter == ZpoolByGUID
+	 && LoadCachedPool((uint64_t)*static_cast<Guid *>(filterArg)))
+		return;
+
 	zpool_iter(g_zfsHandle, LoadIterator, this);
 }
 
@@ -41,6 +41,7 @@
  * Header requirements:
  *
  *    #include <list>
+ *    #include <map>
  *    #include <string>
  */
 #ifndef	_ZPOOL_LIST_H_
@@ -107,6 +108,15 @@ public:
 	ZpoolList(PoolFilter_t *filter = ZpoolAll, void *filterArg = NULL);
 	~ZpoolList();
 
+	/**
+	 * \brief Discard all cached pool GUID to pool name translations.
+	 *
+	 * Invoked whenever a ZFS configuration change event is received,
+	 * since such events may signal the creation, destruction, or
+	 * renaming of a pool.
+	 */
+	static void InvalidateCache();
+
 private:
 	/**
 	 * \brief Helper routine used to populate the internal
@@ -118,6 +128,25 @@ private:
 	 */
 	static int LoadIterator(zpool_handle_t *pool, void *data);
 
+	/**
+	 * \brief Attempt to populate this list using the pool name cache,
+	 *        avoiding a full libzfs pool enumeration.
+	 *
+	 * \param poolGUID  The GUID of the desired pool.
+	 *
+	 * \return  True if the cache held a valid entry for poolGUID and
+	 *          the pool was opened and added to this list.  False if
+	 *          the caller must fall back to zpool_iter().
+	 */
+	bool LoadCachedPool(uint64_t poolGUID);
+
+	/**
+	 * \brief Daemon lifetime cache of pool GUID to pool name
+	 *        translations, populated as a side effect of full pool
+	 *        enumerations and flushed by InvalidateCache().
+	 */
+	static std::map<uint64_t, std::string> s_poolNames;
+
 	/**
 	 * \brief The filter with which this ZpoolList was constructed.
 	 */
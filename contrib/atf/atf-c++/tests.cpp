@@ -523,13 +523,9 @@ process_tcarg(const std::string& tcarg)
     }
 }
 
-static int
-run_tc(tc_vector& tcs, const std::string& tcarg, const atf::fs::path& resfile)
+static void
+warn_if_unsupported(void)
 {
-    const std::pair< std::string, tc_part > fields = process_tcarg(tcarg);
-
-    impl::tc* tc = find_tc(tcs, fields.first);
-
     if (!atf::env::has("__RUNNING_INSIDE_ATF_RUN") || atf::env::get(
         "__RUNNING_INSIDE_ATF_RUN") != "internal-yes-value")
     {
@@ -539,6 +535,16 @@ run_tc(tc_vector& tcs, const std::string& tcarg, const atf::fs::path& resfile)
             "control is being applied; you may get unexpected failures; see "
             "atf-test-case(4)\n";
     }
+}
+
+static int
+run_tc(tc_vector& tcs, const std::string& tcarg, const atf::fs::path& resfile)
+{
+    const std::pair< std::string, tc_part > fields = process_tcarg(tcarg);
+
+    impl::tc* tc = find_tc(tcs, fields.first);
+
+    warn_if_unsupported();
 
     switch (fields.second) {
     case BODY:
@@ -553,12 +559,168 @@ run_tc(tc_vector& tcs, const std::string& tcarg, const atf::fs::path& resfile)
     return EXIT_SUCCESS;
 }
 
+static long
+now_usec(void)
+{
+    struct timeval tv;
+    (void)::gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000L + tv.tv_usec;
+}
+
+// Result reporting in atf-c exits the process from within the test case
+// body, so the child cannot take a timestamp after run() returns.  The
+// body time is instead written from an atexit(3) hook, armed only in
+// children that are asked to collect timings.
+static std::string timing_file;
+static long timing_start = 0;
+
+static void
+write_timing(void)
+{
+    std::ofstream tout(timing_file.c_str());
+    if (tout)
+        tout << (now_usec() - timing_start) << "\n";
+}
+
+static int
+run_tcs_parallel(tc_vector& tcs, const std::vector< std::string >& tcnames,
+                 const std::size_t njobs, const atf::fs::path& resfile)
+{
+    // Resolve the cases up front so the merged output has a stable,
+    // caller-controlled order regardless of completion order.
+    tc_vector torun;
+    if (tcnames.empty())
+        torun = tcs;
+    else {
+        for (std::vector< std::string >::const_iterator iter = tcnames.begin();
+             iter != tcnames.end(); iter++)
+            torun.push_back(find_tc(tcs, *iter));
+    }
+
+    warn_if_unsupported();
+
+    // Per-case result files live in a private directory; the cases
+    // themselves run in the inherited working directory, exactly like
+    // a direct single-case invocation would.
+    std::string dirtmpl = atf::env::get("TMPDIR", "/tmp") +
+        "/atf.parallel.XXXXXX";
+    std::vector< char > dirbuf(dirtmpl.begin(), dirtmpl.end());
+    dirbuf.push_back('\0');
+    if (::mkdtemp(&dirbuf[0]) == NULL)
+        throw std::runtime_error("Cannot create temporary directory");
+    const std::string resdir(&dirbuf[0]);
+
+    const bool timing = atf::env::has("ATF_TIMING");
+
+    std::vector< pid_t > pids(torun.size(), -1);
+    std::vector< int > codes(torun.size(), EXIT_FAILURE);
+    std::vector< long > starts(torun.size(), 0);
+    std::vector< long > walls(torun.size(), 0);
+    std::size_t spawned = 0, running = 0, collected = 0;
+
+    std::cout.flush();
+    std::cerr.flush();
+
+    while (collected < torun.size()) {
+        while (running < njobs && spawned < torun.size()) {
+            const std::size_t i = spawned;
+            const std::string case_resfile = resdir + "/" +
+                torun[i]->get_md_var("ident");
+
+            const pid_t pid = ::fork();
+            if (pid == -1)
+                throw std::runtime_error("Cannot fork test case process");
+            if (pid == 0) {
+                int errcode = EXIT_FAILURE;
+                if (timing) {
+                    timing_file = case_resfile + ".time";
+                    timing_start = now_usec();
+                    (void)::atexit(write_timing);
+                }
+                try {
+                    torun[i]->run(case_resfile);
+                    errcode = EXIT_SUCCESS;
+                } catch (...) {
+                }
+                ::exit(errcode);
+            }
+            pids[i] = pid;
+            starts[i] = now_usec();
+            spawned++;
+            running++;
+        }
+
+        int status;
+        const pid_t pid = ::waitpid(-1, &status, 0);
+        if (pid == -1) {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("Failed to wait for test case process");
+        }
+        for (std::size_t i = 0; i < torun.size(); i++) {
+            if (pids[i] == pid) {
+                codes[i] = WIFEXITED(status) ? WEXITSTATUS(status) :
+                    EXIT_FAILURE;
+                walls[i] = now_usec() - starts[i];
+                running--;
+                collected++;
+                break;
+            }
+        }
+    }
+
+    // Merge the per-case results, one line per case, in resolution order.
+    std::ofstream out(resfile.c_str());
+    if (!out)
+        throw std::runtime_error("Cannot open results file `" +
+                                 resfile.str() + "'");
+
+    int errcode = EXIT_SUCCESS;
+    for (std::size_t i = 0; i < torun.size(); i++) {
+        const std::string ident = torun[i]->get_md_var("ident");
+        const std::string case_resfile = resdir + "/" + ident;
+        std::string result = "failed: Test case did not report a result";
+
+        std::ifstream in(case_resfile.c_str());
+        if (in)
+            std::getline(in, result);
+
+        if (codes[i] != EXIT_SUCCESS ||
+            result.compare(0, 6, "failed") == 0)
+            errcode = EXIT_FAILURE;
+
+        out << ident << ": " << result << "\n";
+        (void)::unlink(case_resfile.c_str());
+
+        // With ATF_TIMING set in the environment, report how much of each
+        // case's wall time went into the body and how much was process
+        // setup and teardown, so spawning overhead can be tracked.
+        if (timing) {
+            const std::string timefile = case_resfile + ".time";
+            long body = -1;
+            std::ifstream tin(timefile.c_str());
+            if (tin)
+                tin >> body;
+            if (body >= 0)
+                std::cerr << Program_Name << ": TIMING: " << ident
+                          << ": body " << body << "us, overhead "
+                          << (walls[i] > body ? walls[i] - body : 0)
+                          << "us\n";
+            (void)::unlink(timefile.c_str());
+        }
+    }
+    (void)::rmdir(resdir.c_str());
+
+    return errcode;
+}
+
 static int
 safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
 {
     const char* argv0 = argv[0];
 
     bool lflag = false;
+    std::size_t njobs = 0;
     atf::fs::path resfile("/dev/stdout");
     std::string srcdir_arg;
     atf::tests::vars_map vars;
@@ -568,8 +730,18 @@ safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
 
     old_opterr = opterr;
     ::opterr = 0;
-    while ((ch = ::getopt(argc, argv, GETOPT_POSIX ":lr:s:v:")) != -1) {
+    while ((ch = ::getopt(argc, argv, GETOPT_POSIX ":j:lr:s:v:")) != -1) {
         switch (ch) {
+        case 'j':
+            try {
+                njobs = atf::text::to_type< std::size_t >(::optarg);
+            } catch (const std::runtime_error&) {
+                throw usage_error("Invalid -j argument `%s'", ::optarg);
+            }
+            if (njobs == 0)
+                throw usage_error("-j requires a positive number of jobs");
+            break;
+
         case 'l':
             lflag = true;
             break;
@@ -613,9 +785,21 @@ safe_main(int argc, char** argv, void (*add_tcs)(tc_vector&))
     if (lflag) {
         if (argc > 0)
             throw usage_error("Cannot provide test case names with -l");
+        if (njobs > 0)
+            throw usage_error("Cannot combine -j with -l");
 
         init_tcs(add_tcs, tcs, vars);
         errcode = list_tcs(tcs);
+    } else if (njobs > 0) {
+        // Run several (or all) test case bodies concurrently, relying
+        // on the cases' own isolation; results are merged in a stable
+        // order once every case has finished.
+        std::vector< std::string > tcnames;
+        for (int i = 0; i < argc; i++)
+            tcnames.push_back(argv[i]);
+
+        init_tcs(add_tcs, tcs, vars);
+        errcode = run_tcs_parallel(tcs, tcnames, njobs, resfile);
     } else {
         if (argc == 0)
             throw usage_error("Must provide a test case name");
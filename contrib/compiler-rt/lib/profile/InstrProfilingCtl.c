@@ -0,0 +1,136 @@
+/*===- InstrProfilingCtl.c - On-demand profile dump control socket --------===*\
+|*
+|*                     The LLVM Compiler Infrastructure
+|*
+|* This file is distributed under the University of Illinois Open Source
+|* License. See LICENSE.TXT for details.
+|*
+\*===----------------------------------------------------------------------===*/
+
+/* Optional control channel for instrumented long-lived binaries.  When the
+ * LLVM_PROFILE_CTL_SOCKET environment variable names a path, the runtime
+ * binds a unix datagram socket there and services two commands:
+ *
+ *   dump    write the profile using the current filename pattern, then
+ *           reset the counters so the next dump covers a fresh window
+ *   reset   discard the counters collected so far
+ *
+ * A short "ok" or "error" reply is sent back when the sender's socket is
+ * bound.  This allows harvesting real-traffic profile windows from
+ * production services at chosen moments, without restarting them or
+ * waiting for exit.  The listener thread is created through a weak
+ * reference to pthread_create, so binaries that are not linked against a
+ * threading library simply do not get the channel.
+ */
+
+#include "InstrProfiling.h"
+#include "InstrProfilingInternal.h"
+
+#if !defined(_WIN32)
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#pragma weak pthread_create
+#pragma weak pthread_detach
+
+static int DumpSocketFd = -1;
+
+static void *dumpSocketLoop(void *Arg) {
+  struct sockaddr_un Peer;
+  socklen_t PeerLen;
+  const char *Reply;
+  char Cmd[16];
+  ssize_t Len;
+
+  (void)Arg;
+  for (;;) {
+    PeerLen = sizeof(Peer);
+    Len = recvfrom(DumpSocketFd, Cmd, sizeof(Cmd) - 1, 0,
+                   (struct sockaddr *)&Peer, &PeerLen);
+    if (Len < 0) {
+      if (errno == EINTR)
+        continue;
+      return NULL;
+    }
+    while (Len > 0 && (Cmd[Len - 1] == '\n' || Cmd[Len - 1] == '\0'))
+      Len--;
+    Cmd[Len] = '\0';
+
+    if (strcmp(Cmd, "dump") == 0) {
+      Reply = __llvm_profile_write_file() == 0 ? "ok\n" : "error\n";
+      __llvm_profile_reset_counters();
+    } else if (strcmp(Cmd, "reset") == 0) {
+      __llvm_profile_reset_counters();
+      Reply = "ok\n";
+    } else {
+      Reply = "error\n";
+    }
+    /* Fails harmlessly when the sender's socket is unbound. */
+    (void)sendto(DumpSocketFd, Reply, strlen(Reply), 0,
+                 (struct sockaddr *)&Peer, PeerLen);
+  }
+  return NULL;
+}
+
+COMPILER_RT_VISIBILITY
+int lprofSetupDumpSocket(void) {
+  struct sockaddr_un Addr;
+  const char *Path;
+  pthread_t Tid;
+  int Fd;
+
+  Path = getenv("LLVM_PROFILE_CTL_SOCKET");
+  if (!Path || !Path[0])
+    return 0;
+
+  if (pthread_create == 0 || pthread_detach == 0) {
+    PROF_WARN("Control socket %s not created: %s.\n", Path,
+              "no threading library linked in");
+    return -1;
+  }
+  if (strlen(Path) >= sizeof(Addr.sun_path)) {
+    PROF_WARN("Control socket path too long: %s.\n", Path);
+    return -1;
+  }
+
+  Fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+  if (Fd < 0) {
+    PROF_WARN("Failed to create control socket %s: %s.\n", Path,
+              strerror(errno));
+    return -1;
+  }
+  memset(&Addr, 0, sizeof(Addr));
+  Addr.sun_family = AF_UNIX;
+  strncpy(Addr.sun_path, Path, sizeof(Addr.sun_path) - 1);
+  (void)unlink(Path);
+  if (bind(Fd, (struct sockaddr *)&Addr, sizeof(Addr)) != 0) {
+    PROF_WARN("Failed to bind control socket %s: %s.\n", Path,
+              strerror(errno));
+    close(Fd);
+    return -1;
+  }
+
+  DumpSocketFd = Fd;
+  if (pthread_create(&Tid, NULL, dumpSocketLoop, NULL) != 0) {
+    PROF_WARN("Failed to create control socket thread: %s.\n",
+              strerror(errno));
+    close(Fd);
+    DumpSocketFd = -1;
+    return -1;
+  }
+  pthread_detach(Tid);
+  return 0;
+}
+
+#else
+
+COMPILER_RT_VISIBILITY
+int lprofSetupDumpSocket(void) { return 0; }
+
+#endif
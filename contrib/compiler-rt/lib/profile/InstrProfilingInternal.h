@@ -178,6 +178,12 @@ uint64_t lprofGetLoadModuleSignature();
 unsigned lprofProfileDumped();
 void lprofSetProfileDumped();
 
+/*
+ * Bind the on-demand dump control socket if LLVM_PROFILE_CTL_SOCKET is
+ * set in the environment.
+ */
+int lprofSetupDumpSocket(void);
+
 COMPILER_RT_VISIBILITY extern void (*FreeHook)(void *);
 COMPILER_RT_VISIBILITY extern uint8_t *DynamicBufferIOBuffer;
 COMPILER_RT_VISIBILITY extern uint32_t VPBufferSize;
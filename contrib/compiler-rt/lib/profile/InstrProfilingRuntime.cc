@@ -10,6 +10,7 @@
 extern "C" {
 
 #include "InstrProfiling.h"
+#include "InstrProfilingInternal.h"
 
 /* int __llvm_profile_runtime  */
 COMPILER_RT_VISIBILITY int INSTR_PROF_PROFILE_RUNTIME_VAR;
@@ -22,6 +23,7 @@ public:
   RegisterRuntime() {
     __llvm_profile_register_write_file_atexit();
     __llvm_profile_initialize_file();
+    lprofSetupDumpSocket();
   }
 };
 
@@ -110,7 +110,12 @@ main (int argc, char *argv[])
                           searcher._alpha_inc,
                           searcher._total_duplicates,
                           searcher._alpha_size,
-                          searcher._asso_values);
+                          searcher._asso_values,
+                          searcher._hash_seed1,
+                          searcher._hash_seed2,
+                          searcher._disp_size,
+                          searcher._displacements,
+                          searcher._table_size);
         outputter.output ();
 
         /* Check for write error on stdout.  */
@@ -121,8 +121,9 @@ Options::long_usage (FILE * stream)
   fprintf (stream,
            "  -L, --language=LANGUAGE-NAME\n"
            "                         Generates code in the specified language. Languages\n"
-           "                         handled are currently C++, ANSI-C, C, and KR-C. The\n"
-           "                         default is C.\n");
+           "                         handled are currently C++17, C++, ANSI-C, C, and\n"
+           "                         KR-C. C++17 makes the generated tables and functions\n"
+           "                         constexpr. The default is C.\n");
   fprintf (stream, "\n");
   fprintf (stream,
            "Details in the output code:\n");
@@ -240,6 +241,12 @@ Options::long_usage (FILE * stream)
   fprintf (stream,
            "  -r, --random           Utilizes randomness to initialize the associated\n"
            "                         values table.\n");
+  fprintf (stream,
+           "      --scalable         Compute a displacement-based hash function instead\n"
+           "                         of searching for associated values. This scales to\n"
+           "                         very large keyword sets where the ordinary search\n"
+           "                         becomes too slow, at the cost of two string hashes\n"
+           "                         and an extra table lookup per query.\n");
   fprintf (stream,
            "  -s, --size-multiple=N  Affects the size of the generated hash table. The\n"
            "                         numeric argument N indicates \"how many times larger\n"
@@ -487,6 +494,7 @@ Options::~Options ()
                "\nC is...........: %s"
                "\nANSIC is.......: %s"
                "\nCPLUSPLUS is...: %s"
+               "\nCONSTEXPR is...: %s"
                "\nSEVENBIT is....: %s"
                "\nLENTABLE is....: %s"
                "\nCOMP is........: %s"
@@ -501,6 +509,7 @@ Options::~Options ()
                "\nDUP is.........: %s"
                "\nNOLENGTH is....: %s"
                "\nRANDOM is......: %s"
+               "\nSCALABLE is....: %s"
                "\nDEBUG is.......: %s"
                "\nlookup function name = %s"
                "\nhash function name = %s"
@@ -521,6 +530,7 @@ Options::~Options ()
                _option_word & C ? "enabled" : "disabled",
                _option_word & ANSIC ? "enabled" : "disabled",
                _option_word & CPLUSPLUS ? "enabled" : "disabled",
+               _option_word & CONSTEXPR ? "enabled" : "disabled",
                _option_word & SEVENBIT ? "enabled" : "disabled",
                _option_word & LENTABLE ? "enabled" : "disabled",
                _option_word & COMP ? "enabled" : "disabled",
@@ -535,6 +545,7 @@ Options::~Options ()
                _option_word & DUP ? "enabled" : "disabled",
                _option_word & NOLENGTH ? "enabled" : "disabled",
                _option_word & RANDOM ? "enabled" : "disabled",
+               _option_word & SCALABLE ? "enabled" : "disabled",
                _option_word & DEBUG ? "enabled" : "disabled",
                _function_name, _hash_name, _wordlist_name, _lengthtable_name,
                _stringpool_name, _slot_name, _initializer_suffix,
@@ -567,7 +578,7 @@ Options::set_language (const char *language)
   if (_language == NULL)
     {
       _language = language;
-      _option_word &= ~(KRC | C | ANSIC | CPLUSPLUS);
+      _option_word &= ~(KRC | C | ANSIC | CPLUSPLUS | CONSTEXPR);
       if (!strcmp (language, "KR-C"))
         _option_word |= KRC;
       else if (!strcmp (language, "C"))
@@ -576,6 +587,10 @@ Options::set_language (const char *language)
         _option_word |= ANSIC;
       else if (!strcmp (language, "C++"))
         _option_word |= CPLUSPLUS;
+      else if (!strcmp (language, "C++17"))
+        /* The constexpr functions cannot contain static local tables, so
+           the tables go to the file scope, like with option -G.  */
+        _option_word |= CPLUSPLUS | CONSTEXPR | GLOBAL;
       else
         {
           fprintf (stderr, "unsupported language option %s, defaulting to C\n",
@@ -710,6 +725,7 @@ static const struct option long_options[] =
   { "string-pool-name", required_argument, NULL, 'Q' },
   { "null-strings", no_argument, NULL, CHAR_MAX + 3 },
   { "random", no_argument, NULL, 'r' },
+  { "scalable", no_argument, NULL, CHAR_MAX + 5 },
   { "size-multiple", required_argument, NULL, 's' },
   { "help", no_argument, NULL, 'h' },
   { "version", no_argument, NULL, 'v' },
@@ -1046,6 +1062,11 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\
             _lengthtable_name = /*getopt*/optarg;
             break;
           }
+        case CHAR_MAX + 5:      /* Use the scalable displacement strategy.  */
+          {
+            _option_word |= SCALABLE;
+            break;
+          }
         default:
           short_usage (stderr);
           exit (1);
@@ -40,6 +40,14 @@ static const char *const_readonly_array;
 /* The "const " qualifier, for the array type.  */
 static const char *const_for_struct;
 
+/* The "register " storage-class specifier.  Empty in C++17 mode, where
+   'register' is no longer a valid storage class.  */
+static const char *register_scs;
+
+/* The qualifier for the generated tables: "constexpr " in C++17 mode,
+   otherwise like const_readonly_array.  */
+static const char *const_tables;
+
 /* Returns the smallest unsigned C type capable of holding integers
    up to N.  */
 
@@ -86,7 +94,9 @@ Output::Output (KeywordExt_List *head, const char *struct_decl,
                 int total_keys, int max_key_len, int min_key_len,
                 const Positions& positions, const unsigned int *alpha_inc,
                 int total_duplicates, unsigned int alpha_size,
-                const int *asso_values)
+                const int *asso_values, unsigned int hash_seed1,
+                unsigned int hash_seed2, unsigned int disp_size,
+                const unsigned int *displacements, unsigned int table_size)
   : _head (head), _struct_decl (struct_decl),
     _struct_decl_lineno (struct_decl_lineno), _return_type (return_type),
     _struct_tag (struct_tag),
@@ -101,7 +111,10 @@ Output::Output (KeywordExt_List *head, const char *struct_decl,
     _max_key_len (max_key_len), _min_key_len (min_key_len),
     _key_positions (positions), _alpha_inc (alpha_inc),
     _total_duplicates (total_duplicates), _alpha_size (alpha_size),
-    _asso_values (asso_values)
+    _asso_values (asso_values),
+    _hash_seed1 (hash_seed1), _hash_seed2 (hash_seed2),
+    _disp_size (disp_size), _displacements (displacements),
+    _table_size (table_size)
 {
 }
 
@@ -250,8 +263,9 @@ output_upperlower_table ()
 
   printf ("#ifndef GPERF_DOWNCASE\n"
           "#define GPERF_DOWNCASE 1\n"
-          "static unsigned char gperf_downcase[256] =\n"
-          "  {");
+          "static %sunsigned char gperf_downcase[256] =\n"
+          "  {",
+          option[CONSTEXPR] ? "constexpr " : "");
   for (c = 0; c < 256; c++)
     {
       if ((c % 15) == 0)
@@ -274,8 +288,9 @@ output_upperlower_strcmp ()
 {
   printf ("#ifndef GPERF_CASE_STRCMP\n"
           "#define GPERF_CASE_STRCMP 1\n"
-          "static int\n"
-          "gperf_case_strcmp ");
+          "static %sint\n"
+          "gperf_case_strcmp ",
+          option[CONSTEXPR] ? "constexpr " : "");
   printf (option[KRC] ?
                "(s1, s2)\n"
           "     register char *s1;\n"
@@ -285,8 +300,9 @@ output_upperlower_strcmp ()
           "     register const char *s1;\n"
           "     register const char *s2;\n" :
           option[ANSIC] | option[CPLUSPLUS] ?
-               "(register const char *s1, register const char *s2)\n" :
-          "");
+               "(%sconst char *s1, %sconst char *s2)\n" :
+          "",
+          register_scs, register_scs);
   #if USE_DOWNCASE_TABLE
   printf ("{\n"
           "  for (;;)\n"
@@ -324,8 +340,9 @@ output_upperlower_strncmp ()
 {
   printf ("#ifndef GPERF_CASE_STRNCMP\n"
           "#define GPERF_CASE_STRNCMP 1\n"
-          "static int\n"
-          "gperf_case_strncmp ");
+          "static %sint\n"
+          "gperf_case_strncmp ",
+          option[CONSTEXPR] ? "constexpr " : "");
   printf (option[KRC] ?
                "(s1, s2, n)\n"
           "     register char *s1;\n"
@@ -337,8 +354,9 @@ output_upperlower_strncmp ()
           "     register const char *s2;\n"
           "     register unsigned int n;\n" :
           option[ANSIC] | option[CPLUSPLUS] ?
-               "(register const char *s1, register const char *s2, register unsigned int n)\n" :
-          "");
+               "(%sconst char *s1, %sconst char *s2, %sunsigned int n)\n" :
+          "",
+          register_scs, register_scs, register_scs);
   #if USE_DOWNCASE_TABLE
   printf ("{\n"
           "  for (; n > 0;)\n"
@@ -384,8 +402,9 @@ output_upperlower_memcmp ()
 {
   printf ("#ifndef GPERF_CASE_MEMCMP\n"
           "#define GPERF_CASE_MEMCMP 1\n"
-          "static int\n"
-          "gperf_case_memcmp ");
+          "static %sint\n"
+          "gperf_case_memcmp ",
+          option[CONSTEXPR] ? "constexpr " : "");
   printf (option[KRC] ?
                "(s1, s2, n)\n"
           "     register char *s1;\n"
@@ -397,8 +416,9 @@ output_upperlower_memcmp ()
           "     register const char *s2;\n"
           "     register unsigned int n;\n" :
           option[ANSIC] | option[CPLUSPLUS] ?
-               "(register const char *s1, register const char *s2, register unsigned int n)\n" :
-          "");
+               "(%sconst char *s1, %sconst char *s2, %sunsigned int n)\n" :
+          "",
+          register_scs, register_scs, register_scs);
   #if USE_DOWNCASE_TABLE
   printf ("{\n"
           "  for (; n > 0;)\n"
@@ -618,6 +638,10 @@ void Output_Compare_Strcmp::output_comparison (const Output_Expr& expr1,
   printf (" && !");
   if (option[UPPERLOWER])
     printf ("gperf_case_");
+  else if (option[CONSTEXPR])
+    /* The library functions are not constexpr, but the corresponding
+       GCC/clang builtins fold in constant expressions.  */
+    printf ("__builtin_");
   printf ("strcmp (");
   if (firstchar_done)
     {
@@ -654,6 +678,8 @@ void Output_Compare_Strncmp::output_comparison (const Output_Expr& expr1,
   printf (" && !");
   if (option[UPPERLOWER])
     printf ("gperf_case_");
+  else if (option[CONSTEXPR])
+    printf ("__builtin_");
   printf ("strncmp (");
   if (firstchar_done)
     {
@@ -694,6 +720,8 @@ void Output_Compare_Memcmp::output_comparison (const Output_Expr& expr1,
   printf (" && !");
   if (option[UPPERLOWER])
     printf ("gperf_case_");
+  else if (option[CONSTEXPR])
+    printf ("__builtin_");
   printf ("memcmp (");
   if (firstchar_done)
     {
@@ -734,6 +762,43 @@ Output::output_asso_values_ref (int pos) const
   printf ("]");
 }
 
+/* Prints out the array of asso_values.  Normally it is a static local
+   table of the hash function; in C++17 mode it is emitted at file scope,
+   because a constexpr function cannot contain static local variables.  */
+
+void
+Output::output_asso_values_table () const
+{
+  const char * const indent = option[CONSTEXPR] ? "" : "  ";
+
+  printf ("%sstatic %s%s asso_values[] =\n"
+          "%s  {",
+          indent, const_tables,
+          smallest_integral_type (_max_hash_value + 1),
+          indent);
+
+  const int columns = 10;
+
+  /* Calculate maximum number of digits required for MAX_HASH_VALUE.  */
+  int field_width = 2;
+  for (int trunc = _max_hash_value; (trunc /= 10) > 0;)
+    field_width++;
+
+  for (unsigned int count = 0; count < _alpha_size; count++)
+    {
+      if (count > 0)
+        printf (",");
+      if ((count % columns) == 0)
+        printf ("\n%s   ", indent);
+      printf ("%*d", field_width, _asso_values[count]);
+    }
+
+  printf ("\n"
+          "%s  };\n", indent);
+  if (option[CONSTEXPR])
+    printf ("\n");
+}
+
 /* Generates C code for the hash function that returns the
    proper encoding for each keyword.
    The hash function has the signature
@@ -742,9 +807,19 @@ Output::output_asso_values_ref (int pos) const
 void
 Output::output_hash_function () const
 {
+  /* In C++17 mode the function is constexpr and cannot contain static
+     local tables; emit them at file scope first.  */
+  if (option[CONSTEXPR])
+    {
+      if (option[SCALABLE])
+        output_displacements_table ();
+      else if (_key_positions.get_size() > 0)
+        output_asso_values_table ();
+    }
+
   /* Output the function's head.  */
   if (option[CPLUSPLUS])
-    printf ("inline ");
+    printf (option[CONSTEXPR] ? "constexpr " : "inline ");
   else if (option[KRC] | option[C] | option[ANSIC])
     printf ("#ifdef __GNUC__\n"
             "__inline\n"
@@ -754,12 +829,13 @@ Output::output_hash_function () const
             "#endif\n"
             "#endif\n");
 
-  if (/* The function does not use the 'str' argument?  */
-      _key_positions.get_size() == 0
-      || /* The function uses 'str', but not the 'len' argument?  */
-         (option[NOLENGTH]
-          && _key_positions[0] < _min_key_len
-          && _key_positions[_key_positions.get_size() - 1] != Positions::LASTCHAR))
+  if (!option[SCALABLE]
+      && (/* The function does not use the 'str' argument?  */
+          _key_positions.get_size() == 0
+          || /* The function uses 'str', but not the 'len' argument?  */
+             (option[NOLENGTH]
+              && _key_positions[0] < _min_key_len
+              && _key_positions[_key_positions.get_size() - 1] != Positions::LASTCHAR)))
     /* Pacify lint.  */
     printf ("/*ARGSUSED*/\n");
 
@@ -778,8 +854,9 @@ Output::output_hash_function () const
             "     register const char *str;\n"
             "     register unsigned int len;\n" :
           option[ANSIC] | option[CPLUSPLUS] ?
-                 "(register const char *str, register unsigned int len)\n" :
-          "");
+                 "(%sconst char *str, %sunsigned int len)\n" :
+          "",
+          register_scs, register_scs);
 
   /* Note that when the hash function is called, it has already been verified
      that  min_key_len <= len <= max_key_len.  */
@@ -787,34 +864,17 @@ Output::output_hash_function () const
   /* Output the function's body.  */
   printf ("{\n");
 
-  /* First the asso_values array.  */
-  if (_key_positions.get_size() > 0)
+  if (option[SCALABLE])
     {
-      printf ("  static %s%s asso_values[] =\n"
-              "    {",
-              const_readonly_array,
-              smallest_integral_type (_max_hash_value + 1));
-
-      const int columns = 10;
-
-      /* Calculate maximum number of digits required for MAX_HASH_VALUE.  */
-      int field_width = 2;
-      for (int trunc = _max_hash_value; (trunc /= 10) > 0;)
-        field_width++;
-
-      for (unsigned int count = 0; count < _alpha_size; count++)
-        {
-          if (count > 0)
-            printf (",");
-          if ((count % columns) == 0)
-            printf ("\n     ");
-          printf ("%*d", field_width, _asso_values[count]);
-        }
-
-      printf ("\n"
-              "    };\n");
+      output_hash_function_scalable ();
+      printf ("}\n\n");
+      return;
     }
 
+  /* First the asso_values array.  */
+  if (_key_positions.get_size() > 0 && !option[CONSTEXPR])
+    output_asso_values_table ();
+
   if (_key_positions.get_size() == 0)
     {
       /* Trivial case: No key positions at all.  */
@@ -871,10 +931,11 @@ Output::output_hash_function () const
       else
         {
           /* We've got to use the correct, but brute force, technique.  */
-          printf ("  register int hval = %s;\n\n"
+          printf ("  %sint hval = %s;\n\n"
                   "  switch (%s)\n"
                   "    {\n"
                   "      default:\n",
+                  register_scs,
                   option[NOLENGTH] ? "0" : "len",
                   option[NOLENGTH] ? "len" : "hval");
 
@@ -920,6 +981,80 @@ Output::output_hash_function () const
   printf ("}\n\n");
 }
 
+/* Prints out the array of displacements for the --scalable backend.
+   Normally it is a static local table of the hash function; in C++17 mode
+   it is emitted at file scope, because a constexpr function cannot
+   contain static local variables.  */
+
+void
+Output::output_displacements_table () const
+{
+  const char * const indent = option[CONSTEXPR] ? "" : "  ";
+  unsigned int max_disp = 0;
+  for (unsigned int b = 0; b < _disp_size; b++)
+    if (max_disp < _displacements[b])
+      max_disp = _displacements[b];
+
+  printf ("%sstatic %s%s displacements[] =\n"
+          "%s  {",
+          indent, const_tables,
+          smallest_integral_type (max_disp),
+          indent);
+
+  const int columns = 10;
+
+  /* Calculate maximum number of digits required for max_disp.  */
+  int field_width = 2;
+  for (unsigned int trunc = max_disp; (trunc /= 10) > 0;)
+    field_width++;
+
+  for (unsigned int b = 0; b < _disp_size; b++)
+    {
+      if (b > 0)
+        printf (",");
+      if ((b % columns) == 0)
+        printf ("\n%s   ", indent);
+      printf ("%*u", field_width, _displacements[b]);
+    }
+
+  printf ("\n"
+          "%s  };\n", indent);
+  if (option[CONSTEXPR])
+    printf ("\n");
+}
+
+/* Generates the body of the hash function for the --scalable backend:
+   two byte mixers over the whole key, a displacement table indexed by the
+   first one, and the second one displaced accordingly.  The mixers must
+   match Search's mix_hash().  */
+
+void
+Output::output_hash_function_scalable () const
+{
+  /* First the displacements array, unless it was already emitted at file
+     scope for C++17.  */
+  if (!option[CONSTEXPR])
+    output_displacements_table ();
+
+  printf ("  %sunsigned int h1 = %uU;\n"
+          "  %sunsigned int h2 = %uU;\n"
+          "  %sunsigned int i = 0;\n"
+          "\n"
+          "  for (i = 0; i < len; i++)\n"
+          "    {\n"
+          "      %sunsigned int c = (unsigned char) str[i];\n",
+          register_scs, _hash_seed1, register_scs, _hash_seed2,
+          register_scs, register_scs);
+  if (option[UPPERLOWER])
+    printf ("      if (c >= 'A' && c <= 'Z')\n"
+            "        c += 'a' - 'A';\n");
+  printf ("      h1 = h1 * 31 + c;\n"
+          "      h2 = h2 * 131 + c;\n"
+          "    }\n"
+          "  return (h2 %% %uU + displacements[h1 %% %uU]) %% %uU;\n",
+          _table_size, _disp_size, _table_size);
+}
+
 /* ------------------------------------------------------------------------- */
 
 /* Prints out a table of keyword lengths, for use with the
@@ -934,7 +1069,7 @@ Output::output_keylength_table () const
 
   printf ("%sstatic %s%s %s[] =\n"
           "%s  {",
-          indent, const_readonly_array,
+          indent, const_tables,
           smallest_integral_type (_max_key_len),
           option.get_lengthtable_name (),
           indent);
@@ -1046,7 +1181,7 @@ Output::output_string_pool () const
 
   printf ("%sstatic %sstruct %s_t %s_contents =\n"
           "%s  {\n",
-          indent, const_readonly_array, option.get_stringpool_name (),
+          indent, const_tables, option.get_stringpool_name (),
           option.get_stringpool_name (), indent);
   for (temp = _head, index = 0; temp; temp = temp->rest())
     {
@@ -1177,7 +1312,12 @@ Output::output_keyword_table () const
 
   printf ("%sstatic ",
           indent);
-  output_const_type (const_readonly_array, _wordlist_eltype);
+  if (option[CONSTEXPR])
+    /* 'constexpr' is a declaration specifier; it goes before the type
+       even for pointer element types.  */
+    printf ("%s%s ", const_tables, _wordlist_eltype);
+  else
+    output_const_type (const_readonly_array, _wordlist_eltype);
   printf ("%s[] =\n"
           "%s  {\n",
           option.get_wordlist_name (),
@@ -1344,7 +1484,7 @@ Output::output_lookup_array () const
       const char *indent = option[GLOBAL] ? "" : "  ";
       printf ("%sstatic %s%s lookup[] =\n"
               "%s  {",
-              indent, const_readonly_array, smallest_integral_type (min, max),
+              indent, const_tables, smallest_integral_type (min, max),
               indent);
 
       int field_width;
@@ -1576,8 +1716,8 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
 {
   printf ("  if (len <= MAX_WORD_LENGTH && len >= MIN_WORD_LENGTH)\n"
           "    {\n"
-          "      register int key = %s (str, len);\n\n",
-          option.get_hash_name ());
+          "      %sint key = %s (str, len);\n\n",
+          register_scs, option.get_hash_name ());
 
   if (option[SWITCH])
     {
@@ -1591,24 +1731,25 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
       if (option[DUP] && _total_duplicates > 0)
         {
           if (option[LENTABLE])
-            printf ("          register %s%s *lengthptr;\n",
-                    const_always, smallest_integral_type (_max_key_len));
-          printf ("          register ");
+            printf ("          %s%s%s *lengthptr;\n",
+                    register_scs, const_always,
+                    smallest_integral_type (_max_key_len));
+          printf ("          %s", register_scs);
           output_const_type (const_readonly_array, _wordlist_eltype);
           printf ("*wordptr;\n");
-          printf ("          register ");
+          printf ("          %s", register_scs);
           output_const_type (const_readonly_array, _wordlist_eltype);
           printf ("*wordendptr;\n");
         }
       if (option[TYPE])
         {
-          printf ("          register ");
+          printf ("          %s", register_scs);
           output_const_type (const_readonly_array, _struct_tag);
           printf ("*resword;\n\n");
         }
       else
-        printf ("          register %sresword;\n\n",
-                _struct_tag);
+        printf ("          %s%sresword;\n\n",
+                register_scs, _struct_tag);
 
       output_switches (_head, num_switches, switch_size, _min_hash_value, _max_hash_value, 10);
 
@@ -1627,8 +1768,8 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
                       indent, "", indent, "");
               indent += 4;
             }
-          printf ("%*s      register %schar *s = ",
-                  indent, "", const_always);
+          printf ("%*s      %s%schar *s = ",
+                  indent, "", register_scs, const_always);
           if (option[TYPE])
             printf ("wordptr->%s", option.get_slot_name ());
           else
@@ -1662,8 +1803,8 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
       if (option[TYPE])
         {
           printf ("          {\n"
-                  "            register %schar *s = resword->%s",
-                  const_always, option.get_slot_name ());
+                  "            %s%schar *s = resword->%s",
+                  register_scs, const_always, option.get_slot_name ());
           if (option[SHAREDLIB])
             printf (" + %s",
                     option.get_stringpool_name ());
@@ -1691,9 +1832,9 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
         {
           int indent = 8;
           printf ("%*s{\n"
-                  "%*s  register int index = lookup[key];\n\n"
+                  "%*s  %sint index = lookup[key];\n\n"
                   "%*s  if (index >= 0)\n",
-                  indent, "", indent, "", indent, "");
+                  indent, "", indent, "", register_scs, indent, "");
           if (option[LENTABLE])
             {
               printf ("%*s    {\n"
@@ -1702,9 +1843,10 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
               indent += 4;
             }
           printf ("%*s    {\n"
-                  "%*s      register %schar *s = %s[index]",
+                  "%*s      %s%schar *s = %s[index]",
                   indent, "",
-                  indent, "", const_always, option.get_wordlist_name ());
+                  indent, "", register_scs, const_always,
+                  option.get_wordlist_name ());
           if (option[TYPE])
             printf (".%s", option.get_slot_name ());
           if (option[SHAREDLIB])
@@ -1733,19 +1875,20 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
             {
               printf ("%*s  else if (index < -TOTAL_KEYWORDS)\n"
                       "%*s    {\n"
-                      "%*s      register int offset = - 1 - TOTAL_KEYWORDS - index;\n",
-                      indent, "", indent, "", indent, "");
+                      "%*s      %sint offset = - 1 - TOTAL_KEYWORDS - index;\n",
+                      indent, "", indent, "", indent, "", register_scs);
               if (option[LENTABLE])
-                printf ("%*s      register %s%s *lengthptr = &%s[TOTAL_KEYWORDS + lookup[offset]];\n",
-                        indent, "", const_always, smallest_integral_type (_max_key_len),
+                printf ("%*s      %s%s%s *lengthptr = &%s[TOTAL_KEYWORDS + lookup[offset]];\n",
+                        indent, "", register_scs, const_always,
+                        smallest_integral_type (_max_key_len),
                         option.get_lengthtable_name ());
-              printf ("%*s      register ",
-                      indent, "");
+              printf ("%*s      %s",
+                      indent, "", register_scs);
               output_const_type (const_readonly_array, _wordlist_eltype);
               printf ("*wordptr = &%s[TOTAL_KEYWORDS + lookup[offset]];\n",
                       option.get_wordlist_name ());
-              printf ("%*s      register ",
-                      indent, "");
+              printf ("%*s      %s",
+                      indent, "", register_scs);
               output_const_type (const_readonly_array, _wordlist_eltype);
               printf ("*wordendptr = wordptr + -lookup[offset + 1];\n\n");
               printf ("%*s      while (wordptr < wordendptr)\n"
@@ -1758,8 +1901,8 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
                           indent, "", indent, "");
                   indent += 4;
                 }
-              printf ("%*s          register %schar *s = ",
-                      indent, "", const_always);
+              printf ("%*s          %s%schar *s = ",
+                      indent, "", register_scs, const_always);
               if (option[TYPE])
                 printf ("wordptr->%s", option.get_slot_name ());
               else
@@ -1807,9 +1950,10 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
               if (!option[LENTABLE])
                 {
                   printf ("%*s{\n"
-                          "%*s  register int o = %s[key]",
+                          "%*s  %sint o = %s[key]",
                           indent, "",
-                          indent, "", option.get_wordlist_name ());
+                          indent, "", register_scs,
+                          option.get_wordlist_name ());
                   if (option[TYPE])
                     printf (".%s", option.get_slot_name ());
                   printf (";\n"
@@ -1818,8 +1962,8 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
                           indent, "",
                           indent, "");
                   indent += 4;
-                  printf ("%*s  register %schar *s = o",
-                          indent, "", const_always);
+                  printf ("%*s  %s%schar *s = o",
+                          indent, "", register_scs, const_always);
                 }
               else
                 {
@@ -1827,9 +1971,9 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
                      (len == lengthtable[key]) test already guarantees that
                      key points to nonempty table entry.  */
                   printf ("%*s{\n"
-                          "%*s  register %schar *s = %s[key]",
+                          "%*s  %s%schar *s = %s[key]",
                           indent, "",
-                          indent, "", const_always,
+                          indent, "", register_scs, const_always,
                           option.get_wordlist_name ());
                   if (option[TYPE])
                     printf (".%s", option.get_slot_name ());
@@ -1840,9 +1984,10 @@ Output::output_lookup_function_body (const Output_Compare& comparison) const
           else
             {
               printf ("%*s{\n"
-                      "%*s  register %schar *s = %s[key]",
+                      "%*s  %s%schar *s = %s[key]",
                       indent, "",
-                      indent, "", const_always, option.get_wordlist_name ());
+                      indent, "", register_scs, const_always,
+                      option.get_wordlist_name ());
               if (option[TYPE])
                 printf (".%s", option.get_slot_name ());
             }
@@ -1892,7 +2037,8 @@ Output::output_lookup_function () const
             "#endif\n"
             "#endif\n");
 
-  printf ("%s%s\n",
+  printf ("%s%s%s\n",
+          option[CONSTEXPR] ? "constexpr " : "",
           const_for_struct, _return_type);
   if (option[CPLUSPLUS])
     printf ("%s::", option.get_class_name ());
@@ -1906,8 +2052,9 @@ Output::output_lookup_function () const
             "     register const char *str;\n"
             "     register unsigned int len;\n" :
           option[ANSIC] | option[CPLUSPLUS] ?
-                 "(register const char *str, register unsigned int len)\n" :
-          "");
+                 "(%sconst char *str, %sunsigned int len)\n" :
+          "",
+          register_scs, register_scs);
 
   /* Output the function's body.  */
   printf ("{\n");
@@ -1949,7 +2096,10 @@ Output::output ()
   if (option[C] | option[ANSIC] | option[CPLUSPLUS])
     {
       const_always = "const ";
-      const_readonly_array = (option[CONST] ? "const " : "");
+      /* The elements of a constexpr table are const, so pointers into it
+         must be pointers to const.  */
+      const_readonly_array =
+        (option[CONST] || option[CONSTEXPR] ? "const " : "");
       const_for_struct = ((option[CONST] && option[TYPE]) ? "const " : "");
     }
   else
@@ -1958,6 +2108,8 @@ Output::output ()
       const_readonly_array = "";
       const_for_struct = "";
     }
+  const_tables = (option[CONSTEXPR] ? "constexpr " : const_readonly_array);
+  register_scs = (option[CONSTEXPR] ? "" : "register ");
 
   if (!option[TYPE])
     {
@@ -1974,6 +2126,8 @@ Output::output ()
     printf ("C");
   else if (option[ANSIC])
     printf ("ANSI-C");
+  else if (option[CONSTEXPR])
+    printf ("C++17");
   else if (option[CPLUSPLUS])
     printf ("C++");
   printf (" code produced by gperf version %s */\n", version_string);
@@ -2074,12 +2228,15 @@ Output::output ()
     printf ("class %s\n"
             "{\n"
             "private:\n"
-            "  static inline unsigned int %s (const char *str, unsigned int len);\n"
+            "  static %sunsigned int %s (const char *str, unsigned int len);\n"
             "public:\n"
-            "  static %s%s%s (const char *str, unsigned int len);\n"
+            "  static %s%s%s%s (const char *str, unsigned int len);\n"
             "};\n"
             "\n",
-            option.get_class_name (), option.get_hash_name (),
+            option.get_class_name (),
+            option[CONSTEXPR] ? "constexpr " : "inline ",
+            option.get_hash_name (),
+            option[CONSTEXPR] ? "constexpr " : "",
             const_for_struct, _return_type, option.get_function_name ());
 
   output_hash_function ();
@@ -55,7 +55,12 @@ public:
                                 const unsigned int *alpha_inc,
                                 int total_duplicates,
                                 unsigned int alpha_size,
-                                const int *asso_values);
+                                const int *asso_values,
+                                unsigned int hash_seed1,
+                                unsigned int hash_seed2,
+                                unsigned int disp_size,
+                                const unsigned int *displacements,
+                                unsigned int table_size);
 
   /* Generates the hash function and the key word recognizer function.  */
   void                  output ();
@@ -75,10 +80,21 @@ private:
   /* Generates a C expression for an asso_values[] reference.  */
   void                  output_asso_values_ref (int pos) const;
 
+  /* Prints out the array of asso_values.  */
+  void                  output_asso_values_table () const;
+
+  /* Prints out the array of displacements, for the --scalable
+     backend.  */
+  void                  output_displacements_table () const;
+
   /* Generates C code for the hash function that returns the
      proper encoding for each keyword.  */
   void                  output_hash_function () const;
 
+  /* Generates the body of the hash function for the --scalable
+     backend.  */
+  void                  output_hash_function_scalable () const;
+
   /* Prints out a table of keyword lengths, for use with the
      comparison code in generated function 'in_word_set'.  */
   void                  output_keylength_table () const;
@@ -149,6 +165,12 @@ private:
   unsigned int const    _alpha_size;
   /* Value associated with each character. */
   const int * const     _asso_values;
+  /* Results of the --scalable backend.  */
+  unsigned int const    _hash_seed1;
+  unsigned int const    _hash_seed2;
+  unsigned int const    _disp_size;
+  const unsigned int * const _displacements;
+  unsigned int const    _table_size;
 };
 
 #endif
@@ -127,7 +127,8 @@
 /* ==================== Initialization and Preparation ===================== */
 
 Search::Search (KeywordExt_List *list)
-  : _head (list)
+  : _head (list),
+    _displacements (NULL)
 {
 }
 
@@ -1566,6 +1567,271 @@ Search::find_good_asso_values ()
     }
 }
 
+/* =============== Computing displacement-based hash tables ================ */
+
+/* With --scalable, the three steps above are replaced with a
+   compress-hash-displace construction, in the spirit of the CHD and BDZ
+   perfect hash families:  Two byte-mixing hash functions h1 and h2 are
+   computed over the whole keyword.  h1 distributes the keywords over
+   about _list_len / 4 buckets; the buckets are then processed in order
+   of decreasing size, and each bucket receives a displacement d such
+   that the slots (h2 + d) % _table_size of its keywords are all still
+   free.  The emitted hash function is
+
+     hash (keyword) = (h2 (keyword)
+                       + displacements[h1 (keyword) % _disp_size])
+                      % _table_size .
+
+   The construction runs in expected linear time, so keyword sets with
+   tens of thousands of entries generate in seconds, whereas the stepwise
+   search for asso_values[] -- with only one associated value per
+   character to play with -- degrades rapidly past a few thousand
+   keywords.  The price is the table of _disp_size displacements and an
+   emitted hash function that reads every byte of the key.  */
+
+/* Case-folds a byte the same way alpha_unify does for --ignore-case.  */
+
+static inline unsigned int
+fold_byte (unsigned int c)
+{
+  if (option[UPPERLOWER] && c >= 'A' && c <= 'Z')
+    c += 'a' - 'A';
+  return c;
+}
+
+/* The byte mixer underlying h1 and h2.  It must match the code emitted
+   by Output::output_hash_function_scalable().  */
+
+static unsigned int
+mix_hash (unsigned int seed, unsigned int multiplier,
+          const KeywordExt *keyword)
+{
+  unsigned int h = seed;
+  const char *k = keyword->_allchars;
+  for (int i = keyword->_allchars_length; i > 0; k++, i--)
+    h = h * multiplier + fold_byte (static_cast<unsigned char>(*k));
+  return h;
+}
+
+/* Comparison function for sorting keywords by their character sequence,
+   modulo case folding.  */
+
+static int
+cmp_keyword_strings (const void *p1, const void *p2)
+{
+  const KeywordExt *keyword1 = *static_cast<KeywordExt *const *>(p1);
+  const KeywordExt *keyword2 = *static_cast<KeywordExt *const *>(p2);
+
+  if (keyword1->_allchars_length != keyword2->_allchars_length)
+    return keyword1->_allchars_length < keyword2->_allchars_length ? -1 : 1;
+  for (int i = 0; i < keyword1->_allchars_length; i++)
+    {
+      unsigned int c1 =
+        fold_byte (static_cast<unsigned char>(keyword1->_allchars[i]));
+      unsigned int c2 =
+        fold_byte (static_cast<unsigned char>(keyword2->_allchars[i]));
+      if (c1 != c2)
+        return c1 < c2 ? -1 : 1;
+    }
+  return 0;
+}
+
+void
+Search::find_displacements ()
+{
+  /* Index the keywords.  */
+  unsigned int n = _list_len;
+  KeywordExt **keywords = new KeywordExt*[n];
+  {
+    unsigned int i = 0;
+    for (KeywordExt_List *temp = _head; temp; temp = temp->rest())
+      {
+        keywords[i] = temp->first();
+        keywords[i]->_duplicate_link = NULL;
+        /* The selchars machinery is not used by this backend, but the
+           caller deallocates it unconditionally.  */
+        keywords[i]->_selchars = NULL;
+        keywords[i]->_selchars_length = 0;
+        i++;
+      }
+  }
+
+  /* Keywords consisting of the same character sequence can never be told
+     apart by a hash over the whole string.  Report them, like the
+     stepwise search reports duplicate selchars.  */
+  {
+    KeywordExt **sorted = new KeywordExt*[n];
+    memcpy (sorted, keywords, n * sizeof (*keywords));
+    qsort (sorted, n, sizeof (*sorted), cmp_keyword_strings);
+    for (unsigned int i = 1; i < n; i++)
+      if (cmp_keyword_strings (&sorted[i - 1], &sorted[i]) == 0)
+        {
+          fprintf (stderr, "Duplicate keyword \"%.*s\".\n"
+                   "--scalable hashes the whole keyword and cannot "
+                   "distinguish duplicates;\nremove them from the input.\n",
+                   sorted[i]->_allchars_length, sorted[i]->_allchars);
+          exit (1);
+        }
+    delete[] sorted;
+  }
+
+  _disp_size = n / 4 + 1;
+  _table_size = n;
+
+  unsigned int *h1 = new unsigned int[n];
+  unsigned int *h2 = new unsigned int[n];
+  unsigned int seed = 0x9e3779b9;
+
+  for (unsigned int attempt = 0; ; attempt++)
+    {
+      /* A handful of failures in a row means the table is too tight for
+         this keyword set; give it some slack.  The result is then not
+         minimal, which ordinary gperf tables aren't either.  */
+      if (attempt > 0 && (attempt % 3) == 0)
+        _table_size += _table_size / 16 + 1;
+
+      _hash_seed1 = seed;
+      _hash_seed2 = seed ^ 0x55555555;
+      for (unsigned int i = 0; i < n; i++)
+        {
+          h1[i] = mix_hash (_hash_seed1, 31, keywords[i]) % _disp_size;
+          h2[i] = mix_hash (_hash_seed2, 131, keywords[i]) % _table_size;
+        }
+
+      /* Group the keywords into buckets according to h1.  */
+      unsigned int *count = new unsigned int[_disp_size];
+      memset (count, 0, _disp_size * sizeof (*count));
+      for (unsigned int i = 0; i < n; i++)
+        count[h1[i]]++;
+      unsigned int *start = new unsigned int[_disp_size + 1];
+      start[0] = 0;
+      for (unsigned int b = 0; b < _disp_size; b++)
+        start[b + 1] = start[b] + count[b];
+      unsigned int *members = new unsigned int[n];
+      {
+        unsigned int *fill = new unsigned int[_disp_size];
+        memcpy (fill, start, _disp_size * sizeof (*start));
+        for (unsigned int i = 0; i < n; i++)
+          members[fill[h1[i]]++] = i;
+        delete[] fill;
+      }
+
+      /* Determine the order in which to place the buckets: decreasing
+         size, so that the hard ones are placed while the table is still
+         mostly empty.  Counting sort on the bucket size.  */
+      unsigned int max_size = 0;
+      for (unsigned int b = 0; b < _disp_size; b++)
+        if (max_size < count[b])
+          max_size = count[b];
+      unsigned int *order = new unsigned int[_disp_size];
+      {
+        unsigned int ordered = 0;
+        unsigned int *size_start = new unsigned int[max_size + 2];
+        memset (size_start, 0, (max_size + 2) * sizeof (*size_start));
+        for (unsigned int b = 0; b < _disp_size; b++)
+          if (count[b] > 0)
+            size_start[max_size - count[b] + 1]++;
+        for (unsigned int s = 1; s <= max_size + 1; s++)
+          size_start[s] += size_start[s - 1];
+        for (unsigned int b = 0; b < _disp_size; b++)
+          if (count[b] > 0)
+            {
+              order[size_start[max_size - count[b]]++] = b;
+              ordered++;
+            }
+        delete[] size_start;
+        /* Empty buckets need no displacement; their entries stay 0.  */
+        while (ordered < _disp_size)
+          order[ordered++] = _disp_size;
+      }
+
+      /* Place the buckets.  */
+      bool *occupied = new bool[_table_size];
+      memset (occupied, 0, _table_size * sizeof (*occupied));
+      unsigned int *disp = new unsigned int[_disp_size];
+      memset (disp, 0, _disp_size * sizeof (*disp));
+      bool success = true;
+      for (unsigned int o = 0; success && o < _disp_size; o++)
+        {
+          unsigned int b = order[o];
+          if (b == _disp_size)
+            break;
+
+          /* Two keywords of this bucket with equal h2 can never be
+             separated; only a different seed can help.  The buckets are
+             small, so the quadratic check is cheap.  */
+          for (unsigned int j = start[b]; success && j < start[b + 1]; j++)
+            for (unsigned int k = j + 1; k < start[b + 1]; k++)
+              if (h2[members[j]] == h2[members[k]])
+                {
+                  success = false;
+                  break;
+                }
+
+          unsigned int d;
+          for (d = 0; success && d < _table_size; d++)
+            {
+              bool fits = true;
+              for (unsigned int j = start[b]; j < start[b + 1]; j++)
+                {
+                  unsigned int slot = h2[members[j]] + d;
+                  if (slot >= _table_size)
+                    slot -= _table_size;
+                  if (occupied[slot])
+                    {
+                      fits = false;
+                      break;
+                    }
+                }
+              if (fits)
+                {
+                  for (unsigned int j = start[b]; j < start[b + 1]; j++)
+                    {
+                      unsigned int slot = h2[members[j]] + d;
+                      if (slot >= _table_size)
+                        slot -= _table_size;
+                      occupied[slot] = true;
+                      keywords[members[j]]->_hash_value = slot;
+                    }
+                  disp[b] = d;
+                  break;
+                }
+            }
+          if (d == _table_size)
+            success = false;
+        }
+
+      delete[] occupied;
+      delete[] order;
+      delete[] members;
+      delete[] start;
+      delete[] count;
+
+      if (success)
+        {
+          _displacements = disp;
+          break;
+        }
+
+      delete[] disp;
+      seed = seed * 1664525 + 1013904223;
+      if (option[DEBUG])
+        fprintf (stderr, "displacement attempt %u failed, "
+                 "retrying with seed %u and table size %u\n",
+                 attempt + 1, seed, _table_size);
+    }
+
+  _max_hash_value = _table_size - 1;
+
+  if (option[DEBUG])
+    fprintf (stderr, "%u keywords, %u displacements, table size %u\n",
+             n, _disp_size, _table_size);
+
+  delete[] h2;
+  delete[] h1;
+  delete[] keywords;
+}
+
 /* ========================================================================= */
 
 /* Comparison function for sorting by increasing _hash_value.  */
@@ -1589,6 +1855,31 @@ Search::optimize ()
   /* Preparations.  */
   prepare ();
 
+  if (option[SCALABLE])
+    {
+      /* The fields of the stepwise search stay unused.  */
+      _alpha_inc = NULL;
+      _alpha_unify = NULL;
+      _occurrences = NULL;
+      _asso_values = NULL;
+      _collision_detector = NULL;
+      _alpha_size = compute_alpha_size ();
+      _key_positions = Positions ();
+      _max_selchars_length = 0;
+      _list_len = _total_keys;
+      _total_duplicates = 0;
+
+      /* Compute a displacement-based hash function instead of the three
+         steps below.  find_displacements() verifies injectivity itself:
+         a keyword set it cannot separate makes it retry with new seeds,
+         so a successful return implies distinct hash values.  */
+      find_displacements ();
+
+      /* Sorts the keyword list by hash value.  */
+      sort ();
+      return;
+    }
+
   /* Step 1: Finding good byte positions.  */
   find_positions ();
 
@@ -1647,8 +1938,9 @@ Search::optimize ()
 
 Search::~Search ()
 {
+  delete[] _displacements;
   delete _collision_detector;
-  if (option[DEBUG])
+  if (option[DEBUG] && !option[SCALABLE])
     {
       fprintf (stderr, "\ndumping occurrence and associated values tables\n");
 
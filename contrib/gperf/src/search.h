@@ -98,6 +98,10 @@ private:
   /* Finds good _asso_values[].  */
   void                  find_good_asso_values ();
 
+  /* Computes the displacement table and every keyword's _hash_value, for
+     the --scalable backend.  */
+  void                  find_displacements ();
+
   /* Sorts the keyword list by hash value.  */
   void                  sort ();
 
@@ -142,6 +146,18 @@ public:
   /* Value associated with each character. */
   int *                 _asso_values;
 
+  /* --- Results of the --scalable backend --- */
+
+  /* Seeds of the two byte-mixing hash functions in the emitted code.  */
+  unsigned int          _hash_seed1;
+  unsigned int          _hash_seed2;
+  /* Number of displacement buckets.  */
+  unsigned int          _disp_size;
+  /* The displacement table, of size _disp_size.  */
+  unsigned int *        _displacements;
+  /* Exclusive upper bound for the emitted hash values.  */
+  unsigned int          _table_size;
+
 private:
 
   /* Length of _head list.  Number of keywords, not counting duplicates.  */
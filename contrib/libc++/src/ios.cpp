@@ -14,6 +14,7 @@
 #include <stdlib.h>
 
 #include "__locale"
+#include "__std_stream"
 #include "algorithm"
 #include "include/config_elast.h"
 #include "istream"
@@ -461,6 +462,8 @@ ios_base::sync_with_stdio(bool sync)
     static bool previous_state = true;
     bool r = previous_state;
     previous_state = sync;
+    if (r != sync)
+        __stdoutbuf_sync_with_stdio(sync);
     return r;
 }
 
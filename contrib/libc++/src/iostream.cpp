@@ -106,6 +106,17 @@ ios_base::Init::Init()
 #endif
 }
 
+void
+__stdoutbuf_sync_with_stdio(bool __sync)
+{
+#ifndef _LIBCPP_HAS_NO_STDOUT
+    reinterpret_cast<__stdoutbuf<char>*>(__cout)->__set_buffered(!__sync);
+    reinterpret_cast<__stdoutbuf<wchar_t>*>(__wcout)->__set_buffered(!__sync);
+#endif
+    reinterpret_cast<__stdoutbuf<char>*>(__cerr)->__set_buffered(!__sync);
+    reinterpret_cast<__stdoutbuf<wchar_t>*>(__wcerr)->__set_buffered(!__sync);
+}
+
 ios_base::Init::~Init()
 {
 #ifndef _LIBCPP_HAS_NO_STDOUT
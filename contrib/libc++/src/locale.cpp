@@ -185,7 +185,24 @@ public:
 
     static const locale& make_classic();
     static       locale& make_global();
+
+    // The classic "C" implementation lives in static storage, is created
+    // with a reference already held and is never torn down.  Handles that
+    // point at it -- every default-constructed stream does while the
+    // global locale is unchanged -- skip the shared-count atomics.
+    static void __acquire(__imp* imp)
+    {
+        if (imp != classic_imp_)
+            imp->__add_shared();
+    }
+    static void __release(__imp* imp)
+    {
+        if (imp != classic_imp_)
+            imp->__release_shared();
+    }
 private:
+    static const __imp* classic_imp_;
+
     void install(facet* f, long id);
     template <class F> void install(F* f) {install(f, f->id.__get());}
     template <class F> void install_from(const __imp& other);
@@ -478,6 +495,8 @@ locale::__imp::use_facet(long id) const
 
 // locale
 
+const locale::__imp* locale::__imp::classic_imp_ = nullptr;
+
 const locale&
 locale::__imp::make_classic()
 {
@@ -485,6 +504,10 @@ locale::__imp::make_classic()
     static aligned_storage<sizeof(locale)>::type buf;
     locale* c = reinterpret_cast<locale*>(&buf);
     c->__locale_ = &make<__imp>(1u);
+    // Later readers are ordered after this store because every path that
+    // copies or destroys a locale first passes through the static guard
+    // of classic() or __global().
+    classic_imp_ = c->__locale_;
     return *c;
 }
 
@@ -514,25 +537,25 @@ locale::__global()
 locale::locale()  _NOEXCEPT
     : __locale_(__global().__locale_)
 {
-    __locale_->__add_shared();
+    __imp::__acquire(__locale_);
 }
 
 locale::locale(const locale& l)  _NOEXCEPT
     : __locale_(l.__locale_)
 {
-    __locale_->__add_shared();
+    __imp::__acquire(__locale_);
 }
 
 locale::~locale()
 {
-    __locale_->__release_shared();
+    __imp::__release(__locale_);
 }
 
 const locale&
 locale::operator=(const locale& other)  _NOEXCEPT
 {
-    other.__locale_->__add_shared();
-    __locale_->__release_shared();
+    __imp::__acquire(other.__locale_);
+    __imp::__release(__locale_);
     __locale_ = other.__locale_;
     return *this;
 }
@@ -545,13 +568,13 @@ locale::locale(const char* name)
     : __locale_(new __imp(name))
 #endif
 {
-    __locale_->__add_shared();
+    __imp::__acquire(__locale_);
 }
 
 locale::locale(const string& name)
     : __locale_(new __imp(name))
 {
-    __locale_->__add_shared();
+    __imp::__acquire(__locale_);
 }
 
 locale::locale(const locale& other, const char* name, category c)
@@ -562,19 +585,19 @@ locale::locale(const locale& other, const char* name, category c)
     : __locale_(new __imp(*other.__locale_, name, c))
 #endif
 {
-    __locale_->__add_shared();
+    __imp::__acquire(__locale_);
 }
 
 locale::locale(const locale& other, const string& name, category c)
     : __locale_(new __imp(*other.__locale_, name, c))
 {
-    __locale_->__add_shared();
+    __imp::__acquire(__locale_);
 }
 
 locale::locale(const locale& other, const locale& one, category c)
     : __locale_(new __imp(*other.__locale_, *one.__locale_, c))
 {
-    __locale_->__add_shared();
+    __imp::__acquire(__locale_);
 }
 
 string
@@ -590,7 +613,7 @@ locale::__install_ctor(const locale& other, facet* f, long id)
         __locale_ = new __imp(*other.__locale_, f, id);
     else
         __locale_ = other.__locale_;
-    __locale_->__add_shared();
+    __imp::__acquire(__locale_);
 }
 
 locale
@@ -136,6 +136,31 @@ RdKafka::Message *RdKafka::ConsumerImpl::consume (Topic *topic,
   return new RdKafka::MessageImpl(topic, rkmessage);
 }
 
+RdKafka::ErrorCode
+RdKafka::ConsumerImpl::consume_batch (Topic *topic, int32_t partition,
+                                      int timeout_ms, size_t max_messages,
+                                      MessageBatch **batchp) {
+  RdKafka::TopicImpl *topicimpl = dynamic_cast<RdKafka::TopicImpl *>(topic);
+  RdKafka::MessageBatchImpl *batchimpl;
+  ssize_t cnt;
+
+  *batchp = NULL;
+
+  batchimpl = new RdKafka::MessageBatchImpl(max_messages);
+
+  cnt = rd_kafka_consume_batch(topicimpl->rkt_, partition, timeout_ms,
+                               batchimpl->rkmessages_, max_messages);
+  if (cnt == -1) {
+    delete batchimpl;
+    return static_cast<RdKafka::ErrorCode>(rd_kafka_last_error());
+  }
+
+  batchimpl->make_views(cnt);
+  *batchp = batchimpl;
+
+  return RdKafka::ERR_NO_ERROR;
+}
+
 namespace {
   /* Helper struct for `consume_callback'.
    * Encapsulates the values we need in order to call `rd_kafka_consume_callback'
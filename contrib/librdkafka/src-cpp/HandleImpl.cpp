@@ -136,12 +136,116 @@ RdKafka::ErrorCode RdKafka::HandleImpl::metadata (bool all_topics,
   const rd_kafka_resp_err_t rc = rd_kafka_metadata(rk_, all_topics, topic,
                                                    &cmetadatap,timeout_ms);
 
-  *metadatap = (rc == RD_KAFKA_RESP_ERR_NO_ERROR) ? 
+  *metadatap = (rc == RD_KAFKA_RESP_ERR_NO_ERROR) ?
     new RdKafka::MetadataImpl(cmetadatap) : NULL;
 
   return static_cast<RdKafka::ErrorCode>(rc);
 }
 
+/**
+ * Find topic \p name in \p md, or NULL.
+ */
+static const rd_kafka_metadata_topic_t *
+find_topic (const rd_kafka_metadata_t *md, const char *name) {
+  for (int i = 0 ; i < md->topic_cnt ; i++)
+    if (!strcmp(md->topics[i].topic, name))
+      return &md->topics[i];
+  return NULL;
+}
+
+/**
+ * Compare the new metadata \p newmd against the cached \p oldmd,
+ * calling \p update_cb (if non-NULL) for each topic whose partition
+ * count changed.
+ *
+ * @returns true if the cluster layout differs.
+ */
+static bool metadata_changed (const rd_kafka_metadata_t *oldmd,
+                              const rd_kafka_metadata_t *newmd,
+                              RdKafka::MetadataUpdateCb *update_cb) {
+  bool changed = false;
+  int i, j;
+
+  if (oldmd->broker_cnt != newmd->broker_cnt)
+    changed = true;
+  else {
+    for (i = 0 ; i < newmd->broker_cnt ; i++)
+      if (oldmd->brokers[i].id != newmd->brokers[i].id) {
+        changed = true;
+        break;
+      }
+  }
+
+  for (i = 0 ; i < newmd->topic_cnt ; i++) {
+    const rd_kafka_metadata_topic_t *newt = &newmd->topics[i];
+    const rd_kafka_metadata_topic_t *oldt = find_topic(oldmd, newt->topic);
+    int32_t old_cnt = oldt ? oldt->partition_cnt : 0;
+
+    if (old_cnt != newt->partition_cnt) {
+      changed = true;
+      if (update_cb)
+        update_cb->metadata_update_cb(std::string(newt->topic),
+                                      old_cnt, newt->partition_cnt);
+      continue;
+    }
+
+    if (!oldt)
+      continue;
+
+    /* Same partition count: check for leadership changes. */
+    for (j = 0 ; j < newt->partition_cnt ; j++)
+      if (oldt->partitions[j].leader != newt->partitions[j].leader) {
+        changed = true;
+        break;
+      }
+  }
+
+  for (i = 0 ; i < oldmd->topic_cnt ; i++) {
+    const rd_kafka_metadata_topic_t *oldt = &oldmd->topics[i];
+
+    if (!find_topic(newmd, oldt->topic)) {
+      changed = true;
+      if (update_cb)
+        update_cb->metadata_update_cb(std::string(oldt->topic),
+                                      oldt->partition_cnt, 0);
+    }
+  }
+
+  return changed;
+}
+
+RdKafka::ErrorCode RdKafka::HandleImpl::metadata_cached (
+        bool all_topics,
+        const Metadata **metadatap,
+        int *generationp,
+        MetadataUpdateCb *update_cb,
+        int timeout_ms) {
+
+  const rd_kafka_metadata_t *cmetadatap = NULL;
+
+  const rd_kafka_resp_err_t rc = rd_kafka_metadata(rk_, all_topics, NULL,
+                                                   &cmetadatap, timeout_ms);
+  if (rc != RD_KAFKA_RESP_ERR_NO_ERROR)
+    return static_cast<RdKafka::ErrorCode>(rc);
+
+  if (cached_metadata_ &&
+      !metadata_changed(cached_c_metadata_, cmetadatap, update_cb)) {
+    /* Unchanged layout: keep the existing snapshot. */
+    rd_kafka_metadata_destroy(cmetadatap);
+  } else {
+    if (cached_metadata_)
+      delete cached_metadata_; /* destroys cached_c_metadata_ too */
+    cached_metadata_ = new RdKafka::MetadataImpl(cmetadatap);
+    cached_c_metadata_ = cmetadatap;
+    metadata_generation_++;
+  }
+
+  *metadatap = cached_metadata_;
+  *generationp = metadata_generation_;
+
+  return RdKafka::ERR_NO_ERROR;
+}
+
 /**
  * Convert a list of C partitions to C++ partitions
  */
@@ -119,6 +119,37 @@ RdKafka::Message *RdKafka::KafkaConsumerImpl::consume (int timeout_ms) {
 }
 
 
+RdKafka::ErrorCode
+RdKafka::KafkaConsumerImpl::consume_batch (int timeout_ms,
+                                           size_t max_messages,
+                                           RdKafka::MessageBatch **batchp) {
+  RdKafka::MessageBatchImpl *batchimpl;
+  rd_kafka_queue_t *rkqu;
+  ssize_t cnt;
+
+  *batchp = NULL;
+
+  rkqu = rd_kafka_queue_get_consumer(rk_);
+  if (!rkqu)
+    return RdKafka::ERR__STATE;
+
+  batchimpl = new RdKafka::MessageBatchImpl(max_messages);
+
+  cnt = rd_kafka_consume_batch_queue(rkqu, timeout_ms,
+                                     batchimpl->rkmessages_, max_messages);
+  rd_kafka_queue_destroy(rkqu);
+  if (cnt == -1) {
+    delete batchimpl;
+    return static_cast<RdKafka::ErrorCode>(rd_kafka_last_error());
+  }
+
+  batchimpl->make_views(cnt);
+  *batchp = batchimpl;
+
+  return RdKafka::ERR_NO_ERROR;
+}
+
+
 
 RdKafka::ErrorCode
 RdKafka::KafkaConsumerImpl::assignment (std::vector<RdKafka::TopicPartition*> &partitions) {
@@ -36,3 +36,76 @@
 
 RdKafka::Message::~Message() {}
 
+RdKafka::MessageBatch::~MessageBatch() {}
+
+
+/*
+ * Bounded free list recycling MessageImpl shells.
+ *
+ * Consumers allocate and delete one fixed-size shell per delivered
+ * message, which makes the allocator the hottest call site in
+ * high-throughput consumer services.  Recycled shells are kept on a
+ * singly-linked list threaded through the freed storage; the list is
+ * guarded by a test-and-set spinlock since the critical section is
+ * only a couple of pointer operations.
+ */
+
+#define MESSAGE_POOL_MAX 512  /* shells kept for reuse */
+
+struct message_pool_ent {
+  struct message_pool_ent *next;
+};
+
+static struct message_pool_ent *message_pool = NULL;
+static int message_pool_cnt = 0;
+static int message_pool_lock = 0;
+
+static void message_pool_acquire () {
+  while (__sync_lock_test_and_set(&message_pool_lock, 1))
+    ;
+}
+
+static void message_pool_release () {
+  __sync_lock_release(&message_pool_lock);
+}
+
+void *RdKafka::MessageImpl::operator new (size_t size) {
+  struct message_pool_ent *ent = NULL;
+
+  if (size == sizeof(RdKafka::MessageImpl)) {
+    message_pool_acquire();
+    if ((ent = message_pool)) {
+      message_pool = ent->next;
+      message_pool_cnt--;
+    }
+    message_pool_release();
+  }
+
+  if (ent)
+    return ent;
+
+  return ::operator new(size);
+}
+
+void RdKafka::MessageImpl::operator delete (void *ptr, size_t size) {
+  struct message_pool_ent *ent;
+
+  if (size == sizeof(RdKafka::MessageImpl)) {
+    ent = static_cast<struct message_pool_ent *>(ptr);
+
+    message_pool_acquire();
+    if (message_pool_cnt < MESSAGE_POOL_MAX) {
+      ent->next = message_pool;
+      message_pool = ent;
+      message_pool_cnt++;
+      ent = NULL;
+    }
+    message_pool_release();
+
+    if (!ent)
+      return;
+  }
+
+  ::operator delete(ptr);
+}
+
@@ -144,8 +144,55 @@ RdKafka::ProducerImpl::produce (RdKafka::Topic *topic,
 }
 
 
+RdKafka::PayloadBuffer::~PayloadBuffer () {
+
+}
+
+RdKafka::PayloadBuffer *RdKafka::PayloadBuffer::create (size_t size) {
+  void *data;
+
+  if (!(data = malloc(size)))
+    return NULL;
+
+  return new RdKafka::PayloadBufferImpl(data, size);
+}
+
+RdKafka::PayloadBuffer *RdKafka::PayloadBuffer::create (void *data,
+                                                        size_t size) {
+  return new RdKafka::PayloadBufferImpl(data, size);
+}
+
+
+RdKafka::ErrorCode
+RdKafka::ProducerImpl::produce (RdKafka::Topic *topic,
+                                int32_t partition,
+                                RdKafka::PayloadBuffer *payload,
+                                const std::string *key,
+                                void *msg_opaque) {
+  RdKafka::TopicImpl *topicimpl = dynamic_cast<RdKafka::TopicImpl *>(topic);
+  RdKafka::PayloadBufferImpl *bufimpl =
+    dynamic_cast<RdKafka::PayloadBufferImpl *>(payload);
+
+  if (!bufimpl || !bufimpl->data_)
+    return RdKafka::ERR__INVALID_ARG;
+
+  if (rd_kafka_produce(topicimpl->rkt_, partition, RD_KAFKA_MSG_F_FREE,
+                       bufimpl->data_, bufimpl->size_,
+                       key ? key->c_str() : NULL, key ? key->size() : 0,
+                       msg_opaque) == -1)
+    return static_cast<RdKafka::ErrorCode>(rd_kafka_last_error());
+
+  /* librdkafka now owns the payload memory and will free(3) it once
+   * the message has been delivered or has failed permanently. */
+  bufimpl->detach();
+  delete bufimpl;
+
+  return RdKafka::ERR_NO_ERROR;
+}
+
+
 RdKafka::ErrorCode
-RdKafka::ProducerImpl::produce (const std::string topic_name,
+RdKafka::ProducerImpl::produce (const std::string &topic_name,
                                 int32_t partition, int msgflags,
                                 void *payload, size_t len,
                                 const void *key, size_t key_len,
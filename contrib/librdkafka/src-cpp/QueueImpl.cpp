@@ -40,6 +40,30 @@ RdKafka::Queue *RdKafka::Queue::create (Handle *base) {
   return queueimpl;
 }
 
+RdKafka::Queue *RdKafka::Queue::get_main (Handle *base) {
+  rd_kafka_queue_t *rkqu;
+
+  rkqu = rd_kafka_queue_get_main(dynamic_cast<HandleImpl*>(base)->rk_);
+  if (!rkqu)
+    return NULL;
+
+  RdKafka::QueueImpl *queueimpl = new RdKafka::QueueImpl;
+  queueimpl->queue_ = rkqu;
+  return queueimpl;
+}
+
+RdKafka::Queue *RdKafka::Queue::get_consumer (Handle *base) {
+  rd_kafka_queue_t *rkqu;
+
+  rkqu = rd_kafka_queue_get_consumer(dynamic_cast<HandleImpl*>(base)->rk_);
+  if (!rkqu)
+    return NULL;
+
+  RdKafka::QueueImpl *queueimpl = new RdKafka::QueueImpl;
+  queueimpl->queue_ = rkqu;
+  return queueimpl;
+}
+
 RdKafka::ErrorCode
 RdKafka::QueueImpl::forward (Queue *queue) {
   if (!queue) {
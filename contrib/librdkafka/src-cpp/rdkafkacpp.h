@@ -716,6 +716,29 @@ public:
 };
 
 
+/**
+ * @brief Metadata update callback class
+ *
+ * Used with RdKafka::Handle::metadata_cached() to be notified of
+ * topic/partition layout changes between metadata refreshes.
+ */
+class RD_EXPORT MetadataUpdateCb {
+ public:
+  /**
+   * @brief Called once per topic whose partition count differs from the
+   *        previously cached metadata snapshot.
+   *
+   * \p old_partition_cnt is 0 for newly appeared topics and
+   * \p new_partition_cnt is 0 for topics no longer present.
+   */
+  virtual void metadata_update_cb (const std::string &topic,
+                                   int32_t old_partition_cnt,
+                                   int32_t new_partition_cnt) = 0;
+
+  virtual ~MetadataUpdateCb() { }
+};
+
+
 
 /**
  * @brief \b Portability: SocketCb callback class
@@ -1022,6 +1045,35 @@ class RD_EXPORT Handle {
                               Metadata **metadatap, int timeout_ms) = 0;
 
 
+  /**
+   * @brief Refresh and return the handle's cached metadata snapshot.
+   *
+   * Unlike metadata(), the returned snapshot is owned by the handle and
+   * is only rebuilt when the cluster layout actually changed since the
+   * previous call; an unchanged cluster costs no allocation beyond the
+   * raw metadata response.  \p *generationp is set to a counter that
+   * increments with each rebuilt snapshot, so periodic discovery timers
+   * can compare it and skip reprocessing an unchanged layout entirely.
+   *
+   * If \p update_cb is non-NULL it is called for every topic whose
+   * partition count differs from the previous snapshot, before this
+   * function returns.
+   *
+   * \p *metadatap remains valid until the next metadata_cached() call
+   * that reports a new generation, or until the handle is destroyed;
+   * it must not be deleted by the application.  Calls on the same
+   * handle must be serialized by the application.
+   *
+   * @returns RdKafka::ERR_NO_ERROR on success, in which case
+   *          \p *metadatap and \p *generationp are set.
+   */
+  virtual ErrorCode metadata_cached (bool all_topics,
+                                     const Metadata **metadatap,
+                                     int *generationp,
+                                     MetadataUpdateCb *update_cb,
+                                     int timeout_ms) = 0;
+
+
   /**
    * @brief Pause producing or consumption for the provided list of partitions.
    *
@@ -1453,6 +1505,71 @@ class RD_EXPORT Message {
   virtual struct rd_kafka_message_s *c_ptr () = 0;
 };
 
+
+/**
+ * @brief Lightweight non-owning view of a single consumed message
+ *        inside a MessageBatch.
+ *
+ * All accessors are non-virtual and simply return fields captured when
+ * the batch was consumed.  A view is only valid for the lifetime of the
+ * MessageBatch it belongs to.
+ */
+class RD_EXPORT MessageView {
+ public:
+  MessageView (ErrorCode err, int32_t partition, int64_t offset,
+               void *payload, size_t len, const void *key, size_t key_len):
+      err_(err), partition_(partition), offset_(offset),
+      payload_(payload), len_(len), key_(key), key_len_(key_len) {}
+
+  /** @returns The error code for this message, else 0. */
+  ErrorCode err () const { return err_; }
+
+  /** @returns Partition (if applicable) */
+  int32_t partition () const { return partition_; }
+
+  /** @returns Message or error offset (if applicable) */
+  int64_t offset () const { return offset_; }
+
+  /** @returns Message payload (if applicable) */
+  void *payload () const { return payload_; }
+
+  /** @returns Message payload length (if applicable) */
+  size_t len () const { return len_; }
+
+  /** @returns Message key as void pointer (if applicable) */
+  const void *key_pointer () const { return key_; }
+
+  /** @returns Message key's binary length (if applicable) */
+  size_t key_len () const { return key_len_; }
+
+ private:
+  ErrorCode err_;
+  int32_t partition_;
+  int64_t offset_;
+  void *payload_;
+  size_t len_;
+  const void *key_;
+  size_t key_len_;
+};
+
+
+/**
+ * @brief A batch of consumed messages as returned by
+ *        RdKafka::Consumer::consume_batch() and
+ *        RdKafka::KafkaConsumer::consume_batch().
+ *
+ * The batch owns the underlying messages; the MessageView objects it
+ * exposes become invalid when the batch is deleted.  The application
+ * must delete the batch when done with it.
+ */
+class RD_EXPORT MessageBatch {
+ public:
+  virtual ~MessageBatch () = 0;
+
+  /** @returns the message views in this batch, in consume order. */
+  virtual const std::vector<MessageView> *messages () const = 0;
+};
+
 /**@}*/
 
 
@@ -1483,6 +1600,28 @@ class RD_EXPORT Queue {
    */
   static Queue *create (Handle *handle);
 
+  /**
+   * @brief Get a Queue object for the main librdkafka event queue of
+   *        \p handle.
+   *
+   * Together with io_event_enable() and poll() this lets an
+   * application serve the handle's callbacks from an IO based event
+   * loop (e.g. kqueue(2) or poll(2)), waking up only when librdkafka
+   * signals the registered file-descriptor, instead of dedicating a
+   * thread to calling Handle::poll().
+   */
+  static Queue *get_main (Handle *handle);
+
+  /**
+   * @brief Get a Queue object for the consumer queue of \p handle.
+   *
+   * @remark This queue carries fetched messages and must be drained
+   *         with consume(), not poll().
+   *
+   * @returns the queue, or NULL if \p handle is not a KafkaConsumer.
+   */
+  static Queue *get_consumer (Handle *handle);
+
   /**
    * @brief Forward/re-route queue to \p dst.
    * If \p dst is \c NULL, the forwarding is removed.
@@ -1650,6 +1789,27 @@ public:
    */
   virtual Message *consume (int timeout_ms) = 0;
 
+  /**
+   * @brief Consume up to \p max_messages messages in a single call,
+   *        waiting at most \p timeout_ms for the first message.
+   *
+   * This is a higher-throughput variant of consume() for applications
+   * processing large message volumes: one call, one batch allocation,
+   * and non-virtual MessageView accessors instead of a heap-allocated
+   * Message object per message.
+   *
+   * The same polling remarks as for consume() apply.
+   *
+   * On success \p *batchp is set to a new MessageBatch, possibly empty,
+   * which must be deleted by the application when the contained views
+   * are no longer referenced.
+   *
+   * @returns ERR_NO_ERROR on success or an error code on failure, in
+   *          which case \p *batchp is set to NULL.
+   */
+  virtual ErrorCode consume_batch (int timeout_ms, size_t max_messages,
+                                   MessageBatch **batchp) = 0;
+
   /**
    * @brief Commit offsets for the current assignment.
    *
@@ -1949,6 +2109,27 @@ class RD_EXPORT Consumer : public virtual Handle {
    */
   virtual Message *consume (Queue *queue, int timeout_ms) = 0;
 
+  /**
+   * @brief Consume up to \p max_messages messages from \p topic and
+   *        \p partition in a single call, waiting at most \p timeout_ms
+   *        for the first message.
+   *
+   * Like consume_callback(), this provides higher throughput than
+   * consume(): one call and one batch allocation instead of a
+   * heap-allocated Message object per message.
+   * Consumer must have been previously started with \p ..->start().
+   *
+   * On success \p *batchp is set to a new MessageBatch, possibly empty,
+   * which must be deleted by the application when the contained views
+   * are no longer referenced.
+   *
+   * @returns ERR_NO_ERROR on success or an error code on failure, in
+   *          which case \p *batchp is set to NULL.
+   */
+  virtual ErrorCode consume_batch (Topic *topic, int32_t partition,
+                                   int timeout_ms, size_t max_messages,
+                                   MessageBatch **batchp) = 0;
+
   /**
    * @brief Consumes messages from \p topic and \p partition, calling
    *        the provided callback for each consumed messsage.
@@ -2005,6 +2186,41 @@ class RD_EXPORT Consumer : public virtual Handle {
  */
 
 
+/**
+ * @brief A malloc(3)-backed message payload that can be handed over to
+ *        the underlying C library without being copied.
+ *
+ * Ownership of the payload memory is transferred to librdkafka by a
+ * successful Producer::produce() call and the memory is released with
+ * free(3) once the message has been delivered or has failed permanently.
+ */
+class RD_EXPORT PayloadBuffer {
+ public:
+  /**
+   * @brief Create a buffer with room for \p size bytes of payload data.
+   *
+   * @returns a new buffer, or NULL if allocation failed.
+   */
+  static PayloadBuffer *create (size_t size);
+
+  /**
+   * @brief Create a buffer that adopts \p data of \p size bytes.
+   *
+   * \p data must have been allocated with malloc(3) (or compatible)
+   * since it will eventually be released with free(3).
+   */
+  static PayloadBuffer *create (void *data, size_t size);
+
+  virtual ~PayloadBuffer () = 0;
+
+  /** @returns pointer to the payload data. */
+  virtual void *data () = 0;
+
+  /** @returns the payload size in bytes. */
+  virtual size_t size () const = 0;
+};
+
+
 /**
  * @brief Producer
  */
@@ -2143,7 +2359,7 @@ class RD_EXPORT Producer : public virtual Handle {
    *        message timestamp (microseconds since beginning of epoch, UTC).
    *        Otherwise identical to produce() above.
    */
-  virtual ErrorCode produce (const std::string topic_name, int32_t partition,
+  virtual ErrorCode produce (const std::string &topic_name, int32_t partition,
                              int msgflags,
                              void *payload, size_t len,
                              const void *key, size_t key_len,
@@ -2161,6 +2377,22 @@ class RD_EXPORT Producer : public virtual Handle {
                              void *msg_opaque) = 0;
 
 
+  /**
+   * @brief Variant produce() that transfers ownership of \p payload to
+   *        the underlying C library instead of copying the data.
+   *
+   * On success the buffer object is deleted and the payload memory is
+   * released by librdkafka once the message has been delivered or has
+   * failed permanently; the application must not reference either again.
+   * On failure the buffer is left untouched and remains the caller's
+   * responsibility, so the call may be retried (e.g. on ERR__QUEUE_FULL).
+   */
+  virtual ErrorCode produce (Topic *topic, int32_t partition,
+                             PayloadBuffer *payload,
+                             const std::string *key,
+                             void *msg_opaque) = 0;
+
+
   /**
    * @brief Wait until all outstanding produce requests, et.al, are completed.
    *        This should typically be done prior to destroying a producer instance
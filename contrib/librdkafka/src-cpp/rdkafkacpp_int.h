@@ -206,6 +206,12 @@ class MessageImpl : public Message {
           return rkmessage_;
   }
 
+  /* Message shells are recycled through a bounded free list to take
+   * the one-allocation-per-message load off the allocator.
+   * See MessageImpl.cpp. */
+  static void *operator new (size_t size);
+  static void operator delete (void *ptr, size_t size);
+
   RdKafka::Topic *topic_;
   rd_kafka_message_t *rkmessage_;
   bool free_rkmessage_;
@@ -221,6 +227,42 @@ private:
 };
 
 
+class MessageBatchImpl : public MessageBatch {
+ public:
+  MessageBatchImpl (size_t max_messages): cnt_(0) {
+    rkmessages_ = new rd_kafka_message_t *[max_messages];
+  }
+  ~MessageBatchImpl () {
+    for (ssize_t i = 0 ; i < cnt_ ; i++)
+      rd_kafka_message_destroy(rkmessages_[i]);
+    delete[] rkmessages_;
+  }
+
+  const std::vector<MessageView> *messages () const { return &views_; }
+
+  /** Build the views from the \p cnt messages filled in by the C API. */
+  void make_views (ssize_t cnt) {
+    cnt_ = cnt;
+    views_.reserve(cnt);
+    for (ssize_t i = 0 ; i < cnt ; i++) {
+      const rd_kafka_message_t *rkmessage = rkmessages_[i];
+      views_.push_back(MessageView(static_cast<ErrorCode>(rkmessage->err),
+                                   rkmessage->partition, rkmessage->offset,
+                                   rkmessage->payload, rkmessage->len,
+                                   rkmessage->key, rkmessage->key_len));
+    }
+  }
+
+  rd_kafka_message_t **rkmessages_;
+  ssize_t cnt_;
+  std::vector<MessageView> views_;
+
+ private:
+  MessageBatchImpl(MessageBatchImpl const&) /*= delete*/;
+  MessageBatchImpl& operator=(MessageBatchImpl const&) /*= delete*/;
+};
+
+
 class ConfImpl : public Conf {
  public:
   ConfImpl()
@@ -537,8 +579,12 @@ class ConfImpl : public Conf {
 
 class HandleImpl : virtual public Handle {
  public:
-  ~HandleImpl() {};
-  HandleImpl () {};
+  ~HandleImpl() {
+    if (cached_metadata_)
+      delete cached_metadata_;
+  };
+  HandleImpl (): cached_metadata_(NULL), cached_c_metadata_(NULL),
+      metadata_generation_(0) {};
   const std::string name () const { return std::string(rd_kafka_name(rk_)); };
   const std::string memberid () const {
 	  char *str = rd_kafka_memberid(rk_);
@@ -555,6 +601,10 @@ class HandleImpl : virtual public Handle {
   RdKafka::ErrorCode metadata (bool all_topics,const Topic *only_rkt,
             Metadata **metadatap, int timeout_ms);
 
+  RdKafka::ErrorCode metadata_cached (bool all_topics,
+            const Metadata **metadatap, int *generationp,
+            MetadataUpdateCb *update_cb, int timeout_ms);
+
   ErrorCode pause (std::vector<TopicPartition*> &partitions);
   ErrorCode resume (std::vector<TopicPartition*> &partitions);
 
@@ -626,6 +676,13 @@ class HandleImpl : virtual public Handle {
   PartitionerKeyPointerCb *partitioner_kp_cb_;
   RebalanceCb *rebalance_cb_;
   OffsetCommitCb *offset_commit_cb_;
+
+  /* Cached metadata snapshot for metadata_cached().  The raw C
+   * metadata is kept alongside the wrapped snapshot for cheap
+   * change detection; the wrapped object owns it. */
+  Metadata *cached_metadata_;
+  const rd_kafka_metadata_t *cached_c_metadata_;
+  int metadata_generation_;
 };
 
 
@@ -725,6 +782,8 @@ public:
   ErrorCode unassign ();
 
   Message *consume (int timeout_ms);
+  ErrorCode consume_batch (int timeout_ms, size_t max_messages,
+                           MessageBatch **batchp);
   ErrorCode commitSync () {
     return static_cast<ErrorCode>(rd_kafka_commit(rk_, NULL, 0/*sync*/));
   }
@@ -862,6 +921,8 @@ class ConsumerImpl : virtual public Consumer, virtual public HandleImpl {
 		  int timeout_ms);
   Message *consume (Topic *topic, int32_t partition, int timeout_ms);
   Message *consume (Queue *queue, int timeout_ms);
+  ErrorCode consume_batch (Topic *topic, int32_t partition, int timeout_ms,
+                           size_t max_messages, MessageBatch **batchp);
   int consume_callback (Topic *topic, int32_t partition, int timeout_ms,
                         ConsumeCb *cb, void *opaque);
   int consume_callback (Queue *queue, int timeout_ms,
@@ -870,6 +931,25 @@ class ConsumerImpl : virtual public Consumer, virtual public HandleImpl {
 
 
 
+class PayloadBufferImpl : public PayloadBuffer {
+ public:
+  PayloadBufferImpl (void *data, size_t size): data_(data), size_(size) {}
+  ~PayloadBufferImpl () {
+    if (data_)
+      free(data_);
+  }
+
+  void *data () { return data_; }
+  size_t size () const { return size_; }
+
+  /** Forget the payload memory once librdkafka has taken ownership. */
+  void detach () { data_ = NULL; }
+
+  void *data_;
+  size_t size_;
+};
+
+
 class ProducerImpl : virtual public Producer, virtual public HandleImpl {
 
  public:
@@ -892,7 +972,12 @@ class ProducerImpl : virtual public Producer, virtual public HandleImpl {
                      const std::vector<char> *key,
                      void *msg_opaque);
 
-  ErrorCode produce (const std::string topic_name, int32_t partition,
+  ErrorCode produce (Topic *topic, int32_t partition,
+                     PayloadBuffer *payload,
+                     const std::string *key,
+                     void *msg_opaque);
+
+  ErrorCode produce (const std::string &topic_name, int32_t partition,
                      int msgflags,
                      void *payload, size_t len,
                      const void *key, size_t key_len,
@@ -0,0 +1,269 @@
+/*
+ * librdkafka - Apache Kafka C library
+ *
+ * Copyright (c) 2018, Magnus Edenhill
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "test.h"
+
+/* Typical include path would be <librdkafka/rdkafka.h>, but this program
+ * is built from within the librdkafka source tree and thus differs. */
+#include "rdkafka.h"  /* for Kafka driver */
+
+
+/**
+ * End-to-end latency and throughput benchmark.
+ *
+ * For each message size, messages carrying their produce timestamp are
+ * produced while the consumer is drained in the same loop, giving two
+ * latency distributions per message:
+ *  + produce() -> delivery report
+ *  + produce() -> consume
+ * p50/p99/p999 and throughput per size are emitted as a JSON report.
+ *
+ * The test does not fail on slow results, only on pipeline errors;
+ * it exists to produce comparable numbers across library versions.
+ */
+
+struct lat_acc {
+        int64_t *lat;   /* microseconds */
+        int cnt;
+        int size;
+};
+
+static struct lat_acc dr_acc;
+
+static void bench_dr_msg_cb (rd_kafka_t *rk,
+                             const rd_kafka_message_t *rkmessage,
+                             void *opaque) {
+        int64_t ts;
+
+        if (rkmessage->err)
+                TEST_FAIL("Message delivery failed: %s",
+                          rd_kafka_err2str(rkmessage->err));
+
+        if (dr_acc.cnt >= dr_acc.size)
+                return; /* warm-up message */
+
+        memcpy(&ts, rkmessage->payload, sizeof(ts));
+        dr_acc.lat[dr_acc.cnt++] = test_clock() - ts;
+}
+
+static int lat_cmp (const void *a, const void *b) {
+        const int64_t *la = a, *lb = b;
+        return (*la < *lb) ? -1 : (*la > *lb) ? 1 : 0;
+}
+
+/**
+ * @returns the \p pct percentile (0..1) of the sorted array \p acc.
+ */
+static int64_t lat_pctile (const struct lat_acc *acc, double pct) {
+        if (acc->cnt == 0)
+                return -1;
+        return acc->lat[(int)(pct * (double)(acc->cnt - 1))];
+}
+
+/**
+ * Benchmark one message size, appending its JSON report entry to \p json.
+ */
+static void bench_msgsize (int msgsize, int msgcnt,
+                           char *json, size_t json_size) {
+        const char *topic = test_mk_topic_name(__FUNCTION__, 1);
+        const int partition = 0;
+        rd_kafka_conf_t *conf;
+        rd_kafka_t *rk_p, *rk_c;
+        rd_kafka_topic_t *rkt_p, *rkt_c;
+        struct lat_acc c_acc;
+        char *buf;
+        int produced, consumed;
+        int64_t t_start, t_produced, t_consumed, ts_now;
+        size_t of;
+
+        TEST_SAY("Benchmarking %d messages of size %d to %s\n",
+                 msgcnt, msgsize, topic);
+
+        TEST_ASSERT(msgsize >= (int)sizeof(int64_t),
+                    "msgsize must fit a timestamp");
+
+        buf = calloc(1, msgsize);
+
+        dr_acc.lat = malloc(sizeof(*dr_acc.lat) * msgcnt);
+        dr_acc.size = 0; /* exclude the warm-up message */
+        dr_acc.cnt = 0;
+
+        c_acc.lat = malloc(sizeof(*c_acc.lat) * msgcnt);
+        c_acc.size = msgcnt;
+        c_acc.cnt = 0;
+
+        test_conf_init(&conf, NULL, 120);
+        rd_kafka_conf_set_dr_msg_cb(conf, bench_dr_msg_cb);
+        test_conf_set(conf, "queue.buffering.max.messages", "1000000");
+        rk_p = test_create_handle(RD_KAFKA_PRODUCER, conf);
+        rkt_p = test_create_producer_topic(rk_p, topic, "acks", "1", NULL);
+
+        /* Create the topic and let the pipeline warm up outside the
+         * measured interval. */
+        ts_now = test_clock();
+        memcpy(buf, &ts_now, sizeof(ts_now));
+        if (rd_kafka_produce(rkt_p, partition, RD_KAFKA_MSG_F_COPY,
+                             buf, msgsize, NULL, 0, NULL) == -1)
+                TEST_FAIL("warm-up produce() failed: %s",
+                          rd_kafka_err2str(rd_kafka_last_error()));
+        while (rd_kafka_outq_len(rk_p) > 0)
+                rd_kafka_poll(rk_p, 10);
+
+        /* Start consuming at the end of the partition so only the
+         * benchmarked messages are fetched. */
+        test_conf_init(&conf, NULL, 120);
+        rk_c = test_create_consumer(NULL, NULL, conf, NULL);
+        rkt_c = rd_kafka_topic_new(rk_c, topic, NULL);
+        test_consumer_start("BENCH", rkt_c, partition, RD_KAFKA_OFFSET_END);
+
+        dr_acc.size = msgcnt;
+
+        t_start = test_clock();
+        produced = consumed = 0;
+        t_produced = t_consumed = 0;
+
+        while (consumed < msgcnt) {
+                rd_kafka_message_t *rkm;
+
+                if (produced < msgcnt) {
+                        ts_now = test_clock();
+                        memcpy(buf, &ts_now, sizeof(ts_now));
+                        if (rd_kafka_produce(rkt_p, partition,
+                                             RD_KAFKA_MSG_F_COPY,
+                                             buf, msgsize,
+                                             NULL, 0, NULL) == -1) {
+                                if (rd_kafka_last_error() !=
+                                    RD_KAFKA_RESP_ERR__QUEUE_FULL)
+                                        TEST_FAIL("produce() failed: %s",
+                                                  rd_kafka_err2str(
+                                                          rd_kafka_last_error()));
+                                rd_kafka_poll(rk_p, 10);
+                        } else if (++produced == msgcnt)
+                                t_produced = test_clock();
+                }
+
+                rd_kafka_poll(rk_p, 0);
+
+                while ((rkm = rd_kafka_consume(rkt_c, partition, 0))) {
+                        int64_t ts;
+
+                        if (rkm->err) {
+                                if (rkm->err !=
+                                    RD_KAFKA_RESP_ERR__PARTITION_EOF)
+                                        TEST_FAIL("consume error: %s",
+                                                  rd_kafka_message_errstr(rkm));
+                                rd_kafka_message_destroy(rkm);
+                                break;
+                        }
+
+                        memcpy(&ts, rkm->payload, sizeof(ts));
+                        c_acc.lat[c_acc.cnt++] = test_clock() - ts;
+                        rd_kafka_message_destroy(rkm);
+                        if (++consumed == msgcnt)
+                                t_consumed = test_clock();
+                }
+        }
+
+        /* Serve remaining delivery reports. */
+        while (dr_acc.cnt < msgcnt)
+                rd_kafka_poll(rk_p, 10);
+
+        test_consumer_stop("BENCH", rkt_c, partition);
+        rd_kafka_topic_destroy(rkt_c);
+        rd_kafka_destroy(rk_c);
+        rd_kafka_topic_destroy(rkt_p);
+        rd_kafka_destroy(rk_p);
+
+        qsort(dr_acc.lat, dr_acc.cnt, sizeof(*dr_acc.lat), lat_cmp);
+        qsort(c_acc.lat, c_acc.cnt, sizeof(*c_acc.lat), lat_cmp);
+
+        of = strlen(json);
+        rd_snprintf(json + of, json_size - of,
+                    "%s{ \"msgsize\": %d, \"msgcnt\": %d, "
+                    "\"produce_dr\": { "
+                    "\"p50_us\": %"PRId64", \"p99_us\": %"PRId64", "
+                    "\"p999_us\": %"PRId64" }, "
+                    "\"produce_consume\": { "
+                    "\"p50_us\": %"PRId64", \"p99_us\": %"PRId64", "
+                    "\"p999_us\": %"PRId64" }, "
+                    "\"produce_msgs_per_sec\": %.1f, "
+                    "\"e2e_msgs_per_sec\": %.1f, "
+                    "\"e2e_mb_per_sec\": %.2f }",
+                    of > 0 ? ", " : "",
+                    msgsize, msgcnt,
+                    lat_pctile(&dr_acc, 0.50),
+                    lat_pctile(&dr_acc, 0.99),
+                    lat_pctile(&dr_acc, 0.999),
+                    lat_pctile(&c_acc, 0.50),
+                    lat_pctile(&c_acc, 0.99),
+                    lat_pctile(&c_acc, 0.999),
+                    (double)msgcnt /
+                    ((double)(t_produced - t_start) / 1000000.0),
+                    (double)msgcnt /
+                    ((double)(t_consumed - t_start) / 1000000.0),
+                    ((double)msgcnt * (double)msgsize) /
+                    ((double)(t_consumed - t_start) / 1000000.0) /
+                    1000000.0);
+
+        TEST_SAY("size %d: dr p50/p99/p999 %"PRId64"/%"PRId64"/%"PRId64" us, "
+                 "e2e p50/p99/p999 %"PRId64"/%"PRId64"/%"PRId64" us\n",
+                 msgsize,
+                 lat_pctile(&dr_acc, 0.50),
+                 lat_pctile(&dr_acc, 0.99),
+                 lat_pctile(&dr_acc, 0.999),
+                 lat_pctile(&c_acc, 0.50),
+                 lat_pctile(&c_acc, 0.99),
+                 lat_pctile(&c_acc, 0.999));
+
+        free(dr_acc.lat);
+        dr_acc.lat = NULL;
+        free(c_acc.lat);
+        free(buf);
+}
+
+int main_0089_latency_bench (int argc, char **argv) {
+        static const int msgsizes[] = { 100, 1024, 65536 };
+        const int totsize = 1024 * 1024 * 32;
+        char json[4096];
+        unsigned int i;
+
+        *json = '\0';
+
+        for (i = 0; i < sizeof(msgsizes) / sizeof(msgsizes[0]); i++) {
+                int msgcnt = totsize / msgsizes[i];
+
+                if (msgcnt > 50000)
+                        msgcnt = 50000;
+
+                bench_msgsize(msgsizes[i], msgcnt, json, sizeof(json));
+        }
+
+        TEST_REPORT("{ \"sizes\": [ %s ] }", json);
+
+        return 0;
+}
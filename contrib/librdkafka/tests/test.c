@@ -176,6 +176,7 @@ _TEST_DECL(0083_cb_event);
 _TEST_DECL(0084_destroy_flags_local);
 _TEST_DECL(0084_destroy_flags);
 _TEST_DECL(0088_produce_metadata_timeout);
+_TEST_DECL(0089_latency_bench);
 
 /* Manual tests */
 _TEST_DECL(8000_idle);
@@ -287,6 +288,8 @@ struct test tests[] = {
 #if WITH_SOCKEM
         _TEST(0088_produce_metadata_timeout, TEST_F_SOCKEM),
 #endif
+        _TEST(0089_latency_bench, 0),
+
         /* Manual tests */
         _TEST(8000_idle, TEST_F_MANUAL),
 
@@ -146,6 +146,7 @@ struct Configuration {
   bool SingleRoRx;
   bool Shared;
   bool Static = false;
+  bool Stats;
   bool SysvHash = false;
   bool Target1Rel;
   bool Trace;
@@ -43,6 +43,7 @@
 #include "lld/Common/ErrorHandler.h"
 #include "lld/Common/Memory.h"
 #include "lld/Common/Threads.h"
+#include "lld/Common/Timer.h"
 #include "lld/Common/Version.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSwitch.h"
@@ -66,6 +67,13 @@ using namespace lld::elf;
 Configuration *elf::Config;
 LinkerDriver *elf::Driver;
 
+// Phase timers reported by --stats.
+static Timer ResolveTimer("Symbol Resolution", Timer::root());
+static Timer LTOTimer("LTO", Timer::root());
+static Timer GCTimer("GC", Timer::root());
+static Timer MergeTimer("Merge Sections", Timer::root());
+static Timer ICFTimer("ICF", Timer::root());
+
 static void setConfigs();
 
 bool elf::link(ArrayRef<const char *> Args, bool CanExitEarly,
@@ -90,6 +98,7 @@ bool elf::link(ArrayRef<const char *> Args, bool CanExitEarly,
   Symtab = make<SymbolTable>();
   Config->Argv = {Args.begin(), Args.end()};
 
+  Timer::root().start();
   Driver->main(Args, CanExitEarly);
 
   // Exit immediately if we don't need to return to the caller.
@@ -650,6 +659,7 @@ void LinkerDriver::readConfigs(opt::InputArgList &Args) {
   Config->SingleRoRx = Args.hasArg(OPT_no_rosegment);
   Config->SoName = Args.getLastArgValue(OPT_soname);
   Config->SortSection = getSortSection(Args);
+  Config->Stats = Args.hasArg(OPT_stats);
   Config->Strip = getStrip(Args);
   Config->Sysroot = Args.getLastArgValue(OPT_sysroot);
   Config->Target1Rel = Args.hasFlag(OPT_target1_rel, OPT_target1_abs, false);
@@ -1008,8 +1018,11 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &Args) {
 
   // Add all files to the symbol table. This will add almost all
   // symbols that we need to the symbol table.
-  for (InputFile *F : Files)
-    Symtab->addFile<ELFT>(F);
+  {
+    ScopedTimer T(ResolveTimer);
+    for (InputFile *F : Files)
+      Symtab->addFile<ELFT>(F);
+  }
 
   // Process -defsym option.
   for (auto *Arg : Args.filtered(OPT_defsym)) {
@@ -1075,7 +1088,10 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &Args) {
   for (auto *Arg : Args.filtered(OPT_wrap))
     Symtab->addSymbolWrap<ELFT>(Arg->getValue());
 
-  Symtab->addCombinedLTOObject<ELFT>();
+  {
+    ScopedTimer T(LTOTimer);
+    Symtab->addCombinedLTOObject<ELFT>();
+  }
   if (errorCount())
     return;
 
@@ -1125,12 +1141,27 @@ template <class ELFT> void LinkerDriver::link(opt::InputArgList &Args) {
 
   // Do size optimizations: garbage collection, merging of SHF_MERGE sections
   // and identical code folding.
-  markLive<ELFT>();
-  decompressSections();
-  mergeSections();
-  if (Config->ICF)
+  {
+    ScopedTimer T(GCTimer);
+    markLive<ELFT>();
+  }
+  {
+    ScopedTimer T(MergeTimer);
+    decompressSections();
+    mergeSections();
+  }
+  if (Config->ICF) {
+    ScopedTimer T(ICFTimer);
     doIcf<ELFT>();
+  }
 
   // Write the result to the file.
   writeResult<ELFT>();
+
+  // Stop the clock and report where the link time went if --stats was
+  // given.  The root timer keeps running from elf::link() until here so
+  // the total includes option and linker script processing as well.
+  Timer::root().stop();
+  if (Config->Stats)
+    Timer::root().print();
 }
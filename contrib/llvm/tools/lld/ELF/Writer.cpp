@@ -22,6 +22,7 @@
 #include "Target.h"
 #include "lld/Common/Memory.h"
 #include "lld/Common/Threads.h"
+#include "lld/Common/Timer.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringSwitch.h"
 #include <climits>
@@ -35,6 +36,10 @@ using namespace llvm::support::endian;
 using namespace lld;
 using namespace lld::elf;
 
+// Phase timers reported by --stats.
+static Timer FinalizeTimer("Finalize Sections", Timer::root());
+static Timer WriteTimer("Write Output File", Timer::root());
+
 namespace {
 // The writer writes a SymbolTable result to a file.
 template <class ELFT> class Writer {
@@ -423,7 +428,10 @@ template <class ELFT> void Writer<ELFT>::run() {
   // completes section contents. For example, we need to add strings
   // to the string table, and add entries to .got and .plt.
   // finalizeSections does that.
-  finalizeSections();
+  {
+    ScopedTimer T(FinalizeTimer);
+    finalizeSections();
+  }
   if (errorCount())
     return;
 
@@ -457,6 +465,9 @@ template <class ELFT> void Writer<ELFT>::run() {
   // It does not make sense try to open the file if we have error already.
   if (errorCount())
     return;
+
+  ScopedTimer T(WriteTimer);
+
   // Write the result down to a file.
   openFile();
   if (errorCount())
@@ -45,7 +45,11 @@ block identification and trace decode.
 #include <assert.h>
 
 
-static ocsd_instr_subtype instr_sub_type = OCSD_S_INSTR_NONE;
+/* Set as a side effect of the classification functions and collected by
+   TrcIDecode::DecodeInstruction().  Thread-local so that independent
+   decode sessions - e.g. one per trace ID - can run concurrently on
+   worker threads without racing on this state.  */
+static thread_local ocsd_instr_subtype instr_sub_type = OCSD_S_INSTR_NONE;
 
 ocsd_instr_subtype get_instr_subtype()
 {
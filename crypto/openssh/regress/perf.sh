@@ -0,0 +1,71 @@
+#	Placed in the Public Domain.
+
+tid="performance benchmark"
+
+# Machine-readable results (tab separated) accumulate here.
+TSV=$OBJ/perf.tsv
+
+# Payload size for the throughput runs and connection count for the
+# setup latency runs.  Both may be overridden from the environment to
+# trade runtime for resolution; the defaults aim for multi-second runs
+# so that whole-second timing is accurate enough.
+PERF_MEGS=${PERF_MEGS:-64}
+PERF_CONNS=${PERF_CONNS:-20}
+
+now ()
+{
+	date +%s
+}
+
+start_sshd
+
+: > $TSV
+
+dd if=/dev/zero of=$OBJ/perf.data bs=1m count=$PERF_MEGS > /dev/null 2>&1
+
+for c in `${SSH} -Q cipher`; do
+	for m in `${SSH} -Q mac`; do
+		trace "throughput cipher $c mac $m"
+		t0=`now`
+		${SSH} -F $OBJ/ssh_config -o 'Compression no' -m $m -c $c \
+		    somehost "dd of=/dev/null obs=32k" \
+		    < $OBJ/perf.data > /dev/null 2>&1
+		if [ $? -ne 0 ]; then
+			fail "ssh transfer failed with mac $m cipher $c"
+		fi
+		t1=`now`
+		awk -v c=$c -v m=$m -v megs=$PERF_MEGS \
+		    -v secs=`expr $t1 - $t0` 'BEGIN {
+			if (secs < 1)
+				secs = 1;
+			printf "throughput\t%s\t%s\t%.1f\tMB/s\n",
+			    c, m, megs / secs
+		}' | tee -a $TSV
+		# AEAD ciphers ignore the MAC; no point iterating them.
+		if ${SSH} -Q cipher-auth | grep "^${c}\$" > /dev/null 2>&1; then
+			break
+		fi
+	done
+done
+
+for k in `${SSH} -Q kex`; do
+	trace "setup latency kex $k"
+	t0=`now`
+	n=0
+	while [ $n -lt $PERF_CONNS ]; do
+		${SSH} -F $OBJ/ssh_config -o "KexAlgorithms $k" somehost true \
+		    > /dev/null 2>&1
+		if [ $? -ne 0 ]; then
+			fail "ssh connect failed with kex $k"
+		fi
+		n=`expr $n + 1`
+	done
+	t1=`now`
+	awk -v k=$k -v conns=$PERF_CONNS -v secs=`expr $t1 - $t0` 'BEGIN {
+		if (secs < 1)
+			secs = 1;
+		printf "setup\t%s\t%.1f\tms/conn\n", k, 1000 * secs / conns
+	}' | tee -a $TSV
+done
+
+verbose "results in $TSV"
@@ -40,6 +40,13 @@ typedef	__pid_t		pid_t;
 #define	_PID_T_DECLARED
 #endif
 
+#if __BSD_VISIBLE
+#ifndef _SIZE_T_DECLARED
+typedef	__size_t	size_t;
+#define	_SIZE_T_DECLARED
+#endif
+#endif
+
 struct utmpx {
 	short		ut_type;	/* Type of entry. */
 	struct timeval	ut_tv;		/* Time entry was made. */
@@ -82,6 +89,7 @@ struct utmpx *pututxline(const struct utmpx *);
 void	setutxent(void);
 
 #if __BSD_VISIBLE
+int	getutxents(struct utmpx **, size_t *);
 struct utmpx *getutxuser(const char *);
 int	setutxdb(int, const char *);
 #endif
@@ -35,6 +35,14 @@ __FBSDID("$FreeBSD$");
 #include "crtbrand.c"
 #include "ignore_init.c"
 
+/*
+ * A binary whose fini handlers never need to run (a short-lived
+ * helper with no cleanup of its own, for instance) may be linked with
+ * -Wl,--defsym,_crt_nofini=1 to skip registering the cleanup
+ * handler passed in by the dynamic linker.
+ */
+extern int _crt_nofini __weak_symbol;
+
 typedef void (*fptr)(void);
 
 extern void _start(char *, ...);
@@ -57,7 +65,8 @@ _start1(fptr cleanup, int argc, char *argv[])
 	env = argv + argc + 1;
 	handle_argv(argc, argv, env);
 	if (&_DYNAMIC != NULL) {
-		atexit(cleanup);
+		if (&_crt_nofini == NULL)
+			atexit(cleanup);
 	} else {
 		process_irelocs();
 		_init_tls();
@@ -43,6 +43,14 @@ __FBSDID("$FreeBSD$");
 #include "crtbrand.c"
 #include "ignore_init.c"
 
+/*
+ * A binary whose fini handlers never need to run (a short-lived
+ * helper with no cleanup of its own, for instance) may be linked with
+ * -Wl,--defsym,_crt_nofini=1 to skip registering the cleanup
+ * handler passed in by the dynamic linker.
+ */
+extern int _crt_nofini __weak_symbol;
+
 struct Struct_Obj_Entry;
 struct ps_strings;
 
@@ -71,9 +79,10 @@ __start(char **ap,
 	env  = ap + 2 + argc;
 	handle_argv(argc, argv, env);
 
-	if (&_DYNAMIC != NULL)
-		atexit(cleanup);
-	else
+	if (&_DYNAMIC != NULL) {
+		if (&_crt_nofini == NULL)
+			atexit(cleanup);
+	} else
 		_init_tls();
 
 #ifdef GCRT
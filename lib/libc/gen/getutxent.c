@@ -35,6 +35,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/stat.h>
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <utmpx.h>
 #include "utxdb.h"
@@ -166,6 +167,103 @@ getutxent(void)
 	return (futx_to_utx(&fu));
 }
 
+/*
+ * Extension: return every remaining record in the database at once,
+ * reading the file in one shot instead of one record at a time.  The
+ * caller releases the array with free().
+ */
+int
+getutxents(struct utmpx **utxp, size_t *nentries)
+{
+	struct stat sb;
+	struct utmpx *ut, *utx, *nutx;
+	struct futx fu;
+	char *buf, *nbuf, *p, *end;
+	size_t blen, bsize, n, nmax;
+	uint16_t len;
+
+	if (uf == NULL)
+		setutxent();
+	if (uf == NULL)
+		return (-1);
+
+	/*
+	 * Slurp the remainder of the file.  fstat() sizes the buffer
+	 * right for the fixed-record databases; utx.log may grow while
+	 * we read it, so keep doubling until a short read marks EOF.
+	 */
+	bsize = BUFSIZ;
+	if (_fstat(fileno(uf), &sb) != -1 && sb.st_size > 0)
+		bsize = sb.st_size;
+	if ((buf = malloc(bsize)) == NULL)
+		return (-1);
+	blen = 0;
+	for (;;) {
+		blen += fread(buf + blen, 1, bsize - blen, uf);
+		if (blen < bsize)
+			break;
+		bsize *= 2;
+		if ((nbuf = reallocf(buf, bsize)) == NULL)
+			return (-1);
+		buf = nbuf;
+	}
+	if (ferror(uf)) {
+		free(buf);
+		return (-1);
+	}
+
+	utx = NULL;
+	n = nmax = 0;
+	p = buf;
+	end = buf + blen;
+	while (p < end) {
+		if (udb == UTXDB_LOG) {
+			if ((size_t)(end - p) < sizeof(len))
+				break;
+			memcpy(&len, p, sizeof(len));
+			p += sizeof(len);
+			len = be16toh(len);
+			if (len == 0) {
+				/*
+				 * Corrupt record; advance one byte, as
+				 * getfutxent() does with ungetc().
+				 */
+				p -= sizeof(len) - 1;
+				continue;
+			}
+			if ((size_t)(end - p) < len)
+				break;
+			memset(&fu, 0, sizeof(fu));
+			memcpy(&fu, p, MIN(len, sizeof(fu)));
+			p += len;
+		} else {
+			if ((size_t)(end - p) < sizeof(fu))
+				break;
+			memcpy(&fu, p, sizeof(fu));
+			p += sizeof(fu);
+		}
+		if ((ut = futx_to_utx(&fu)) == NULL)
+			goto bad;
+		if (n == nmax) {
+			nmax = nmax ? nmax * 2 : 64;
+			nutx = reallocf(utx, nmax * sizeof(*utx));
+			if (nutx == NULL)
+				goto bad;
+			utx = nutx;
+		}
+		utx[n++] = *ut;
+	}
+	free(buf);
+	*utxp = utx;
+	*nentries = n;
+	return (0);
+
+bad:
+	free(utx);
+	free(buf);
+	return (-1);
+}
+
 struct utmpx *
 getutxid(const struct utmpx *id)
 {
@@ -30,11 +30,13 @@
 __FBSDID("$FreeBSD$");
 
 #include "namespace.h"
+#include <sys/param.h>
 #include <sys/queue.h>
 #include <sys/wait.h>
 
 #include <errno.h>
 #include <fcntl.h>
+#include <paths.h>
 #include <sched.h>
 #include <spawn.h>
 #include <signal.h>
@@ -46,6 +48,16 @@ __FBSDID("$FreeBSD$");
 
 extern char **environ;
 
+/*
+ * Only ia32 and x86_64 push the return address onto the stack; every
+ * other architecture passes it in a register, so a child sharing the
+ * parent's stack can run C code without corrupting the parent's frame.
+ * On x86, spawn onto a temporary stack with rfork_thread(3) instead.
+ */
+#if defined(__i386__) || defined(__amd64__)
+#define	_RFORK_THREAD_STACK_SIZE	(4096 * 3)
+#endif
+
 struct __posix_spawnattr {
 	short			sa_flags;
 	pid_t			sa_pgroup;
@@ -194,43 +206,107 @@ process_file_actions(const posix_spawn_file_actions_t fa)
 	return (0);
 }
 
+struct posix_spawn_args {
+	const char *path;
+	const posix_spawn_file_actions_t *fa;
+	const posix_spawnattr_t *sa;
+	char * const * argv;
+	char * const * envp;
+	int use_env_path;
+	volatile int error;
+};
+
+static int
+_posix_spawn_thr(void *data)
+{
+	struct posix_spawn_args *psa;
+	char * const *envp;
+
+	psa = data;
+	if (psa->sa != NULL) {
+		psa->error = process_spawnattr(*psa->sa);
+		if (psa->error)
+			_exit(127);
+	}
+	if (psa->fa != NULL) {
+		psa->error = process_file_actions(*psa->fa);
+		if (psa->error)
+			_exit(127);
+	}
+	envp = psa->envp != NULL ? psa->envp : environ;
+	if (psa->use_env_path)
+		_execvpe(psa->path, psa->argv, envp);
+	else
+		_execve(psa->path, psa->argv, envp);
+	psa->error = errno;
+
+	/* This is called in such a way that it must not return. */
+	_exit(127);
+}
+
 static int
 do_posix_spawn(pid_t *pid, const char *path,
     const posix_spawn_file_actions_t *fa,
     const posix_spawnattr_t *sa,
     char * const argv[], char * const envp[], int use_env_path)
 {
+	struct posix_spawn_args psa;
 	pid_t p;
-	volatile int error = 0;
+#ifdef _RFORK_THREAD_STACK_SIZE
+	const char *searchpath;
+	char *stack;
+	size_t cnt, stacksz;
+
+	stacksz = _RFORK_THREAD_STACK_SIZE;
+	if (use_env_path) {
+		/*
+		 * execvPe() may alloca() a copy of the path list and,
+		 * for the #! fallback, an enlarged argument vector; make
+		 * sure the temporary stack fits the worst case of both.
+		 */
+		searchpath = getenv("PATH");
+		if (searchpath == NULL)
+			searchpath = _PATH_DEFPATH;
+		stacksz += strlen(searchpath) + 1;
+		for (cnt = 0; argv[cnt] != NULL; cnt++)
+			;
+		stacksz += (cnt + 2) * sizeof(char *);
+		stacksz = roundup2(stacksz, 16);
+	}
+	stack = malloc(stacksz);
+	if (stack == NULL)
+		return (ENOMEM);
+#endif
+	psa.path = path;
+	psa.fa = fa;
+	psa.sa = sa;
+	psa.argv = argv;
+	psa.envp = envp;
+	psa.use_env_path = use_env_path;
+	psa.error = 0;
 
-	p = vfork();
-	switch (p) {
-	case -1:
+	/*
+	 * Spawn with rfork(RFSPAWN): vfork(2) memory and stall semantics,
+	 * so no address space is copied, with the signal dispositions of
+	 * the child already reset by the kernel, saving the sigaction(2)
+	 * round trips a vfork()ed child would have to make.
+	 */
+#ifdef _RFORK_THREAD_STACK_SIZE
+	p = rfork_thread(RFSPAWN, stack + stacksz, _posix_spawn_thr, &psa);
+	free(stack);
+#else
+	p = rfork(RFSPAWN);
+	if (p == 0)
+		/* _posix_spawn_thr does not return */
+		_posix_spawn_thr(&psa);
+#endif
+	if (p == -1)
 		return (errno);
-	case 0:
-		if (sa != NULL) {
-			error = process_spawnattr(*sa);
-			if (error)
-				_exit(127);
-		}
-		if (fa != NULL) {
-			error = process_file_actions(*fa);
-			if (error)
-				_exit(127);
-		}
-		if (use_env_path)
-			_execvpe(path, argv, envp != NULL ? envp : environ);
-		else
-			_execve(path, argv, envp != NULL ? envp : environ);
-		error = errno;
-		_exit(127);
-	default:
-		if (error != 0)
-			_waitpid(p, NULL, WNOHANG);
-		else if (pid != NULL)
-			*pid = p;
-		return (error);
-	}
+	if (psa.error != 0)
+		_waitpid(p, NULL, WNOHANG);
+	else if (pid != NULL)
+		*pid = p;
+	return (psa.error);
 }
 
 int
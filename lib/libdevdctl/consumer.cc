@@ -204,12 +204,47 @@ Consumer::NextEvent()
 	return (event);
 }
 
+size_t
+Consumer::NextEvents(EventList &events, size_t maxEvents)
+{
+	size_t numRead(0);
+
+	if (!Connected())
+		return (0);
+
+	try {
+		while (maxEvents == 0 || numRead < maxEvents) {
+			string evString(ReadEvent());
+
+			if (evString.empty())
+				break;
+			Event::TimestampEventString(evString);
+
+			Event *event(Event::CreateEvent(m_eventFactory,
+							evString));
+			if (event != NULL) {
+				events.push_back(event);
+				numRead++;
+			}
+		}
+	} catch (const Exception &exp) {
+		exp.Log();
+		DisconnectFromDevd();
+	}
+	return (numRead);
+}
+
 /* Capture and process buffered events. */
 void
 Consumer::ProcessEvents()
 {
-	Event *event;
-	while ((event = NextEvent()) != NULL) {
+	EventList events;
+
+	NextEvents(events);
+	while (!events.empty()) {
+		Event *event(events.front());
+
+		events.pop_front();
 		if (event->Process())
 			SaveEvent(*event);
 		delete event;
@@ -82,6 +82,22 @@ public:
 	/** Return an event, if one is available.  */
 	Event *NextEvent();
 
+	/**
+	 * Return every event currently pending on the devd socket.
+	 *
+	 * Draining the socket in one call costs a single wakeup for an
+	 * event burst instead of a poll/recv round trip per event.
+	 *
+	 * \param events     List to which constructed events are appended.
+	 *                   Events that fail to parse are skipped.
+	 * \param maxEvents  Maximum number of events to read, or 0 for
+	 *                   no limit.
+	 *
+	 * \return  The number of events appended to the list.  The caller
+	 *          owns the returned event objects.
+	 */
+	size_t NextEvents(EventList &events, size_t maxEvents = 0);
+
 	/**
 	 * Extract events and invoke each event's Process method.
 	 */
@@ -103,22 +103,27 @@ Event::CreateEvent(const EventFactory &factory, const string &eventString)
 {
 	NVPairMap &nvpairs(*new NVPairMap);
 	Type       type(static_cast<Event::Type>(eventString[0]));
+	size_t     offset;
 
-	try {
-		ParseEventString(type, eventString, nvpairs);
-	} catch (const ParseException &exp) {
-		if (exp.GetType() == ParseException::INVALID_FORMAT)
-			exp.Log();
+	switch (TryParseEventString(type, eventString, nvpairs, offset)) {
+	case PARSE_OK:
+		break;
+	case PARSE_INVALID_FORMAT:
+		ParseException(ParseException::INVALID_FORMAT, eventString,
+			       offset).Log();
+		/* FALLTHROUGH */
+	default:
+		delete &nvpairs;
 		return (NULL);
 	}
 
 	/*
 	 * Allow entries in our table for events with no system specified.
-	 * These entries should specify the string "none".
+	 * These entries should specify the string "none".  insert() is a
+	 * no-op when the key already exists, so this costs one lookup
+	 * rather than a find() followed by an assignment.
 	 */
-	NVPairMap::iterator system_item(nvpairs.find("system"));
-	if (system_item == nvpairs.end())
-		nvpairs["system"] = "none";
+	nvpairs.insert(NVPairMap::value_type("system", "none"));
 
 	return (factory.Build(type, nvpairs, eventString));
 }
@@ -199,6 +204,30 @@ Event::Contains(const string &varName) const
 	return (m_nvPairs.find(varName) != m_nvPairs.end());
 }
 
+size_t
+Event::ParseGuids(const char * const names[], Guid *guids, size_t count) const
+{
+	NVPairMap::const_iterator item;
+	size_t found(0);
+
+	for (size_t i = 0; i < count; i++)
+		guids[i] = Guid::InvalidGuid();
+
+	for (item = m_nvPairs.begin(); item != m_nvPairs.end(); ++item) {
+		for (size_t i = 0; i < count; i++) {
+			if (item->first != names[i])
+				continue;
+			guids[i] = Guid::Parse(item->second.c_str(),
+			    item->second.c_str() + item->second.length());
+			if (guids[i].IsValid())
+				found++;
+			break;
+		}
+	}
+
+	return (found);
+}
+
 string
 Event::ToString() const
 {
@@ -332,14 +361,17 @@ Event::Event(const Event &src)
 {
 }
 
-void
-Event::ParseEventString(Event::Type type,
-			      const string &eventString,
-			      NVPairMap& nvpairs)
+Event::ParseStatus
+Event::TryParseEventString(Event::Type type,
+			   const string &eventString,
+			   NVPairMap& nvpairs,
+			   size_t &offset)
 {
 	size_t start;
 	size_t end;
 
+	offset = 0;
+
 	switch (type) {
 	case ATTACH:
 	case DETACH:
@@ -357,16 +389,18 @@ Event::ParseEventString(Event::Type type,
 		 */
 		start = 1;
 		end = eventString.find_first_of(" \t\n", start);
-		if (end == string::npos)
-			throw ParseException(ParseException::INVALID_FORMAT,
-					     eventString, start);
+		if (end == string::npos) {
+			offset = start;
+			return (PARSE_INVALID_FORMAT);
+		}
 
 		nvpairs["device-name"] = eventString.substr(start, end - start);
 
 		start = eventString.find(" on ", end);
-		if (end == string::npos)
-			throw ParseException(ParseException::INVALID_FORMAT,
-					     eventString, start);
+		if (end == string::npos) {
+			offset = start;
+			return (PARSE_INVALID_FORMAT);
+		}
 		start += 4;
 		end = eventString.find_first_of(" \t\n", start);
 		nvpairs["parent"] = eventString.substr(start, end);
@@ -374,48 +408,75 @@ Event::ParseEventString(Event::Type type,
 	case NOTIFY:
 		break;
 	case NOMATCH:
-		throw ParseException(ParseException::DISCARDED_EVENT_TYPE,
-				     eventString);
+		return (PARSE_DISCARDED_EVENT_TYPE);
 	default:
-		throw ParseException(ParseException::UNKNOWN_EVENT_TYPE,
-				     eventString);
+		return (PARSE_UNKNOWN_EVENT_TYPE);
 	}
 
-	/* Process common "key=value" format. */
-	for (start = 1; start < eventString.length(); start = end + 1) {
+	/*
+	 * Process the common "key=value" format in a single forward pass
+	 * over the raw buffer.  Each token is delimited by whitespace; a
+	 * token containing '=' contributes a pair whose key and value
+	 * strings are constructed exactly once, directly from the buffer,
+	 * with no backtracking or intermediate temporaries.
+	 */
+	const char *buf(eventString.c_str());
+	size_t      len(eventString.length());
 
-		/* Find the '=' in the middle of the key/value pair. */
-		end = eventString.find('=', start);
-		if (end == string::npos)
-			break;
+	for (start = 1; start < len; start = end + 1) {
+		size_t eq(0);
 
-		/*
-		 * Find the start of the key by backing up until
-		 * we hit whitespace or '!' (event type "notice").
-		 * Due to the devdctl format, all key/value pair must
-		 * start with one of these two characters.
-		 */
-		start = eventString.find_last_of("! \t\n", end);
-		if (start == string::npos)
-			throw ParseException(ParseException::INVALID_FORMAT,
-					     eventString, end);
-		start++;
-		string key(eventString.substr(start, end - start));
+		/* Skip leading whitespace. */
+		while (start < len && (buf[start] == ' ' || buf[start] == '\t'
+		    || buf[start] == '\n'))
+			start++;
 
 		/*
-		 * Walk forward from the '=' until either we exhaust
-		 * the buffer or we hit whitespace.
+		 * Find the end of this token, remembering the first '='
+		 * within it.
 		 */
-		start = end + 1;
-		if (start >= eventString.length())
-			throw ParseException(ParseException::INVALID_FORMAT,
-					     eventString, end);
-		end = eventString.find_first_of(" \t\n", start);
-		if (end == string::npos)
-			end = eventString.length() - 1;
-		string value(eventString.substr(start, end - start));
+		for (end = start; end < len && buf[end] != ' '
+		    && buf[end] != '\t' && buf[end] != '\n'; end++) {
+			if (buf[end] == '=' && eq == 0)
+				eq = end;
+		}
+
+		/* Tokens without '=' carry no data; skip them. */
+		if (eq == 0 || eq == start)
+			continue;
+
+		/* A pair with nothing at all after the '=' is malformed. */
+		if (eq == len - 1) {
+			offset = eq;
+			return (PARSE_INVALID_FORMAT);
+		}
+
+		nvpairs[string(buf + start, eq - start)] =
+		    string(buf + eq + 1, end - eq - 1);
+	}
+
+	return (PARSE_OK);
+}
+
+void
+Event::ParseEventString(Event::Type type,
+			      const string &eventString,
+			      NVPairMap& nvpairs)
+{
+	size_t offset;
 
-		nvpairs[key] = value;
+	switch (TryParseEventString(type, eventString, nvpairs, offset)) {
+	case PARSE_OK:
+		break;
+	case PARSE_INVALID_FORMAT:
+		throw ParseException(ParseException::INVALID_FORMAT,
+				     eventString, offset);
+	case PARSE_DISCARDED_EVENT_TYPE:
+		throw ParseException(ParseException::DISCARDED_EVENT_TYPE,
+				     eventString);
+	case PARSE_UNKNOWN_EVENT_TYPE:
+		throw ParseException(ParseException::UNKNOWN_EVENT_TYPE,
+				     eventString);
 	}
 }
 
@@ -589,10 +650,15 @@ ZfsEvent::DevName(std::string &name) const
 //- ZfsEvent Protected Methods -------------------------------------------------
 ZfsEvent::ZfsEvent(Event::Type type, NVPairMap &nvpairs,
 		   const string &eventString)
- : Event(type, nvpairs, eventString),
-   m_poolGUID(Guid(Value("pool_guid"))),
-   m_vdevGUID(Guid(Value("vdev_guid")))
+ : Event(type, nvpairs, eventString)
 {
+	static const char * const guidFields[] =
+	    { "pool_guid", "vdev_guid" };
+	Guid guids[2];
+
+	ParseGuids(guidFields, guids, 2);
+	m_poolGUID = guids[0];
+	m_vdevGUID = guids[1];
 }
 
 ZfsEvent::ZfsEvent(const ZfsEvent &src)
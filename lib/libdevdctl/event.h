@@ -87,6 +87,26 @@ public:
 		DETACH  = '-'
 	};
 
+	/**
+	 * Result of the non-throwing event creation/validation paths.
+	 * Malformed and unhandled events are routine in production
+	 * (vendor drivers emit junk), so the hot path reports them by
+	 * value rather than by unwinding.
+	 */
+	enum ParseStatus {
+		/** The event string parsed cleanly. */
+		PARSE_OK,
+
+		/** Improperly formatted event string encountered. */
+		PARSE_INVALID_FORMAT,
+
+		/** Event type that is always discarded unparsed. */
+		PARSE_DISCARDED_EVENT_TYPE,
+
+		/** Unhandled event type. */
+		PARSE_UNKNOWN_EVENT_TYPE
+	};
+
 	/**
 	 * Factory method type to construct an Event given
 	 * the type of event and an NVPairMap populated from
@@ -100,6 +120,23 @@ public:
 	static Event *CreateEvent(const EventFactory &factory,
 				  const std::string &eventString);
 
+	/**
+	 * Ingest event data from the supplied string without throwing.
+	 *
+	 * \param[in]  type         The type of event to parse.
+	 * \param[in]  eventString  The string of devd event data to parse.
+	 * \param[out] nvpairs      Returns the parsed data.
+	 * \param[out] offset       On PARSE_INVALID_FORMAT, the location
+	 *                          in the event string of the problem.
+	 *
+	 * \return  PARSE_OK on success, otherwise the classification of
+	 *          the parse failure.
+	 */
+	static ParseStatus TryParseEventString(Type type,
+					       const std::string &eventString,
+					       NVPairMap &nvpairs,
+					       size_t &offset);
+
 	/**
 	 * Returns the devname, if any, associated with the event
 	 *
@@ -162,6 +199,22 @@ public:
 	 */
 	const std::string &Value(const std::string &key) const;
 
+	/**
+	 * Parse several guid valued fields in a single pass over the
+	 * event's name => value map, instead of one map lookup and one
+	 * string conversion per field.
+	 *
+	 * \param names  Array of count field names to look up.
+	 * \param guids  Array of count guids, filled in positionally.
+	 *               Fields that are absent or unparseable are set
+	 *               to Guid::InvalidGuid().
+	 * \param count  The number of fields to parse.
+	 *
+	 * \return  The number of fields parsed to a valid guid.
+	 */
+	size_t ParseGuids(const char * const names[], Guid *guids,
+			  size_t count)			 const;
+
 	/**
 	 * Get the type of this event instance.
 	 *
@@ -283,6 +336,10 @@ private:
 	 *
 	 * \param[in] eventString  The string of devd event data to parse.
 	 * \param[out] nvpairs     Returns the parsed data
+	 *
+	 * \throw  ParseException on failure; wrapper around
+	 *         TryParseEventString() for callers that want the
+	 *         throwing behavior.
 	 */
 	static void ParseEventString(Type type, const std::string &eventString,
 				     NVPairMap &nvpairs);
@@ -57,10 +57,72 @@ namespace DevdCtl
 /*------------------------------- EventFactory -------------------------------*/
 //- Event Public Methods -------------------------------------------------------
 EventFactory::EventFactory(Event::BuildMethod *defaultBuildMethod)
- : m_defaultBuildMethod(defaultBuildMethod)
+ : m_hashMask(0),
+   m_hashSeed(0),
+   m_defaultBuildMethod(defaultBuildMethod)
 {
 }
 
+uint32_t
+EventFactory::Hash(Event::Type type, const char *subsystem, uint32_t seed)
+{
+	/* FNV-1a over the subsystem name and the event type. */
+	uint32_t hash(seed ^ 2166136261U);
+
+	for (; *subsystem != '\0'; subsystem++) {
+		hash ^= (uint32_t)(unsigned char)*subsystem;
+		hash *= 16777619U;
+	}
+	hash ^= (uint32_t)type;
+	hash *= 16777619U;
+	return (hash);
+}
+
+void
+EventFactory::BuildHashTable()
+{
+	size_t numEntries(m_registry.size());
+	size_t tableSize(4);
+
+	while (tableSize < numEntries * 2)
+		tableSize <<= 1;
+
+	/*
+	 * The registry is tiny and only changes at registration time, so
+	 * simply retry seeds (growing the table if necessary) until every
+	 * key occupies its own slot.  Event dispatch then needs exactly
+	 * one hash and one comparison.
+	 */
+	for (;;) {
+		for (uint32_t seed(0); seed < 64; seed++) {
+			std::vector<HashSlot> table(tableSize);
+			Registry::const_iterator entry(m_registry.begin());
+			bool collided(false);
+
+			for (; entry != m_registry.end(); entry++) {
+				uint32_t slot(Hash(entry->first.first,
+				    entry->first.second.c_str(), seed) &
+				    (tableSize - 1));
+
+				if (table[slot].m_buildMethod != NULL) {
+					collided = true;
+					break;
+				}
+				table[slot].m_type = entry->first.first;
+				table[slot].m_subsystem = entry->first.second;
+				table[slot].m_buildMethod = entry->second;
+			}
+			if (!collided) {
+				m_hashTable.swap(table);
+				m_hashMask = tableSize - 1;
+				m_hashSeed = seed;
+				return;
+			}
+		}
+		tableSize <<= 1;
+	}
+}
+
 void
 EventFactory::UpdateRegistry(Record regEntries[], size_t numEntries)
 {
@@ -75,19 +137,25 @@ EventFactory::UpdateRegistry(Record regEntries[], size_t numEntries)
 		else
 			m_registry[key] = rec->m_buildMethod;
 	}
+	BuildHashTable();
 }
 
 Event *
 EventFactory::Build(Event::Type type, NVPairMap &nvpairs,
 		    const std::string eventString) const
 {
-	Key key(type, nvpairs["system"]);
 	Event::BuildMethod *buildMethod(m_defaultBuildMethod);
+	const std::string &system(nvpairs["system"]);
+
+	if (!m_hashTable.empty()) {
+		const HashSlot &slot(m_hashTable[Hash(type, system.c_str(),
+		    m_hashSeed) & m_hashMask]);
+
+		if (slot.m_buildMethod != NULL && slot.m_type == type &&
+		    slot.m_subsystem == system)
+			buildMethod = slot.m_buildMethod;
+	}
 
-	Registry::const_iterator foundMethod(m_registry.find(key));
-	if (foundMethod != m_registry.end())
-		buildMethod = foundMethod->second;
-	
 	if (buildMethod == NULL) {
 		delete &nvpairs;
 		return (NULL);
@@ -96,4 +164,35 @@ EventFactory::Build(Event::Type type, NVPairMap &nvpairs,
 	return (buildMethod(type, nvpairs, eventString));
 }
 
+Event::ParseStatus
+EventFactory::Create(const std::string &eventString, Event **eventp) const
+{
+	Event::ParseStatus status;
+	size_t offset;
+
+	*eventp = NULL;
+
+	if (eventString.empty())
+		return (Event::PARSE_INVALID_FORMAT);
+
+	NVPairMap &nvpairs(*new NVPairMap);
+	Event::Type type(static_cast<Event::Type>(eventString[0]));
+
+	status = Event::TryParseEventString(type, eventString, nvpairs,
+					    offset);
+	if (status != Event::PARSE_OK) {
+		delete &nvpairs;
+		return (status);
+	}
+
+	/* As in Event::CreateEvent(), default the emitting system. */
+	nvpairs.insert(NVPairMap::value_type("system", "none"));
+
+	*eventp = Build(type, nvpairs, eventString);
+	if (*eventp == NULL)
+		return (Event::PARSE_DISCARDED_EVENT_TYPE);
+
+	return (Event::PARSE_OK);
+}
+
 } // namespace DevdCtl
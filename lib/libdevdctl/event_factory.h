@@ -39,6 +39,10 @@
 #ifndef _DEVDCTL_EVENT_FACTORY_H_
 #define	_DEVDCTL_EVENT_FACTORY_H_
 
+#include <stdint.h>
+
+#include <vector>
+
 /*============================ Namespace Control =============================*/
 namespace DevdCtl
 {
@@ -72,15 +76,64 @@ public:
 	Event *Build(Event::Type type, NVPairMap &nvpairs,
 		     const std::string eventString)		const;
 
+	/**
+	 * Non-throwing counterpart of Event::CreateEvent(): parse,
+	 * validate, and build an event from a raw devd event string,
+	 * reporting failures by status instead of by exception or
+	 * syslog.
+	 *
+	 * \param[in]  eventString  The string of devd event data.
+	 * \param[out] eventp       On Event::PARSE_OK, the newly built
+	 *                          event; NULL otherwise.
+	 *
+	 * \return  Event::PARSE_OK on success, otherwise the
+	 *          classification of the failure.  An event string
+	 *          that parses but has no registered build method
+	 *          yields Event::PARSE_DISCARDED_EVENT_TYPE.
+	 */
+	Event::ParseStatus Create(const std::string &eventString,
+				  Event **eventp)		const;
+
 	EventFactory(Event::BuildMethod *defaultBuildMethod = NULL);
 
 	void UpdateRegistry(Record regEntries[], size_t numEntries);
 
 
 protected:
+	/** A slot in the collision-free dispatch table. */
+	struct HashSlot
+	{
+		Event::Type         m_type;
+		std::string         m_subsystem;
+		Event::BuildMethod *m_buildMethod;
+	};
+
+	/**
+	 * Rebuild the dispatch table from m_registry, picking a seed for
+	 * which no two registered keys share a slot, so Build() costs one
+	 * hash and one comparison per event.
+	 */
+	void BuildHashTable();
+
+	static uint32_t Hash(Event::Type type, const char *subsystem,
+			     uint32_t seed);
+
 	/** Registry of event factory methods providing O(log(n)) lookup. */
 	Registry	    m_registry;
 
+	/**
+	 * Dispatch table derived from m_registry by BuildHashTable().
+	 * Each registered key occupies exactly one slot; unused slots
+	 * have a NULL build method.
+	 */
+	std::vector<HashSlot> m_hashTable;
+
+	/** Mask applied to hashes to index m_hashTable. */
+	uint32_t	    m_hashMask;
+
+	/** Seed for which the registered keys hash collision-free. */
+	uint32_t	    m_hashSeed;
+
 	Event::BuildMethod *m_defaultBuildMethod;
 };
 
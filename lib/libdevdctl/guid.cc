@@ -39,7 +39,7 @@
  */
 #include <sys/cdefs.h>
 
-#include <stdlib.h>
+#include <ctype.h>
 #include <limits.h>
 #include <inttypes.h>
 
@@ -58,15 +58,59 @@ namespace DevdCtl
 /*----------------------------------- Guid -----------------------------------*/
 Guid::Guid(const string &guidString)
 {
-	if (guidString.empty()) {
-		m_GUID = INVALID_GUID;
-	} else {
-		/*
-		 * strtoumax() returns zero on conversion failure
-		 * which nicely matches our choice for INVALID_GUID.
-		 */
-		m_GUID = (uint64_t)strtoumax(guidString.c_str(), NULL, 0);
+	*this = Parse(guidString.c_str(),
+	    guidString.c_str() + guidString.length());
+}
+
+Guid
+Guid::Parse(const char *begin, const char *end)
+{
+	uint64_t value(0);
+	uint64_t base(10);
+	bool any(false);
+
+	while (begin != end && isspace((unsigned char)*begin))
+		begin++;
+
+	if (begin != end && *begin == '+')
+		begin++;
+
+	if (begin != end && *begin == '0') {
+		any = true;
+		base = 8;
+		begin++;
+		if (begin != end && (*begin == 'x' || *begin == 'X')) {
+			any = false;
+			base = 16;
+			begin++;
+		}
 	}
+
+	for (; begin != end; begin++) {
+		uint64_t digit;
+		char c(*begin);
+
+		if (c >= '0' && c <= '9')
+			digit = c - '0';
+		else if (c >= 'a' && c <= 'f')
+			digit = c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			digit = c - 'A' + 10;
+		else
+			break;
+		if (digit >= base)
+			break;
+		/* An overflowing input cannot name a real guid. */
+		if (value > (UINT64_MAX - digit) / base)
+			return (InvalidGuid());
+		value = value * base + digit;
+		any = true;
+	}
+
+	if (!any)
+		return (InvalidGuid());
+
+	return (Guid(value));
 }
 
 std::ostream&
@@ -70,6 +70,17 @@ public:
 	Guid(const std::string &guid);
 	static Guid InvalidGuid();
 
+	/**
+	 * \brief Parse a guid from a character range.
+	 *
+	 * Accepts the same base 8, 10, and 16 encodings as the string
+	 * constructor, but without the locale and errno machinery of
+	 * strtoumax(3); event handling paths parse several guids per
+	 * event.  Empty, malformed, and overflowing input yields
+	 * InvalidGuid().
+	 */
+	static Guid Parse(const char *begin, const char *end);
+
 	/* Assignment */
 	Guid& operator=(const Guid& rhs);
 
@@ -36,6 +36,8 @@ __FBSDID("$FreeBSD$");
 #include <sys/param.h>
 #include <sys/socket.h>
 
+#include <sys/uio.h>
+
 #include <errno.h>
 #include <fcntl.h>
 #include <stdbool.h>
@@ -58,45 +60,63 @@ __FBSDID("$FreeBSD$");
 #define	PJDLOG_ABORT(...)		abort()
 #endif
 
-#define	PKG_MAX_SIZE	(MCLBYTES / CMSG_SPACE(sizeof(int)) - 1)
+/*
+ * All descriptors of one package travel in a single SCM_RIGHTS
+ * control message; the kernel limits the control buffer to MCLBYTES.
+ */
+#define	PKG_MAX_SIZE	((MCLBYTES - CMSG_SPACE(0)) / sizeof(int))
 
-static int
-msghdr_add_fd(struct cmsghdr *cmsg, int fd)
+static void
+msghdr_add_fds(struct cmsghdr *cmsg, const int *fds, size_t nfds)
 {
 
-	PJDLOG_ASSERT(fd >= 0);
+	PJDLOG_ASSERT(fds != NULL);
+	PJDLOG_ASSERT(nfds > 0);
 
 	cmsg->cmsg_level = SOL_SOCKET;
 	cmsg->cmsg_type = SCM_RIGHTS;
-	cmsg->cmsg_len = CMSG_LEN(sizeof(fd));
-	bcopy(&fd, CMSG_DATA(cmsg), sizeof(fd));
-
-	return (0);
+	cmsg->cmsg_len = CMSG_LEN(nfds * sizeof(fds[0]));
+	bcopy(fds, CMSG_DATA(cmsg), nfds * sizeof(fds[0]));
 }
 
-static int
-msghdr_get_fd(struct cmsghdr *cmsg)
+/*
+ * Extract descriptors from one SCM_RIGHTS control message.  The
+ * message may carry any number of descriptors, so both batched
+ * transfers and the historic one-descriptor-per-message layout are
+ * accepted.  Returns the number of descriptors stored into 'fds', or
+ * -1 for a malformed or foreign control message.
+ */
+static ssize_t
+msghdr_get_fds(struct cmsghdr *cmsg, int *fds, size_t maxfds)
 {
-	int fd;
+	size_t nfds;
 
 	if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET ||
 	    cmsg->cmsg_type != SCM_RIGHTS ||
-	    cmsg->cmsg_len != CMSG_LEN(sizeof(fd))) {
+	    cmsg->cmsg_len < CMSG_LEN(sizeof(fds[0])) ||
+	    (cmsg->cmsg_len - CMSG_LEN(0)) % sizeof(fds[0]) != 0) {
 		errno = EINVAL;
 		return (-1);
 	}
 
-	bcopy(CMSG_DATA(cmsg), &fd, sizeof(fd));
+	nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(fds[0]);
+	if (nfds > maxfds) {
+		errno = EINVAL;
+		return (-1);
+	}
+
+	bcopy(CMSG_DATA(cmsg), fds, nfds * sizeof(fds[0]));
 #ifndef MSG_CMSG_CLOEXEC
 	/*
 	 * If the MSG_CMSG_CLOEXEC flag is not available we cannot set the
 	 * close-on-exec flag atomically, but we still want to set it for
 	 * consistency.
 	 */
-	(void) fcntl(fd, F_SETFD, FD_CLOEXEC);
+	for (size_t i = 0; i < nfds; i++)
+		(void) fcntl(fds[i], F_SETFD, FD_CLOEXEC);
 #endif
 
-	return (fd);
+	return ((ssize_t)nfds);
 }
 
 static void
@@ -237,9 +257,7 @@ static int
 fd_package_send(int sock, const int *fds, size_t nfds)
 {
 	struct msghdr msg;
-	struct cmsghdr *cmsg;
 	struct iovec iov;
-	unsigned int i;
 	int serrno, ret;
 	uint8_t dummy;
 
@@ -258,18 +276,14 @@ fd_package_send(int sock, const int *fds, size_t nfds)
 
 	msg.msg_iov = &iov;
 	msg.msg_iovlen = 1;
-	msg.msg_controllen = nfds * CMSG_SPACE(sizeof(int));
+	msg.msg_controllen = CMSG_SPACE(nfds * sizeof(fds[0]));
 	msg.msg_control = calloc(1, msg.msg_controllen);
 	if (msg.msg_control == NULL)
 		return (-1);
 
 	ret = -1;
 
-	for (i = 0, cmsg = CMSG_FIRSTHDR(&msg); i < nfds && cmsg != NULL;
-	    i++, cmsg = CMSG_NXTHDR(&msg, cmsg)) {
-		if (msghdr_add_fd(cmsg, fds[i]) == -1)
-			goto end;
-	}
+	msghdr_add_fds(CMSG_FIRSTHDR(&msg), fds, nfds);
 
 	if (msg_send(sock, &msg) == -1)
 		goto end;
@@ -290,6 +304,7 @@ fd_package_recv(int sock, int *fds, size_t nfds)
 	unsigned int i;
 	int serrno, ret;
 	struct iovec iov;
+	ssize_t got;
 	uint8_t dummy;
 
 	PJDLOG_ASSERT(sock >= 0);
@@ -307,6 +322,10 @@ fd_package_recv(int sock, int *fds, size_t nfds)
 
 	msg.msg_iov = &iov;
 	msg.msg_iovlen = 1;
+	/*
+	 * Large enough for both a single batched SCM_RIGHTS message
+	 * and the historic one-descriptor-per-message layout.
+	 */
 	msg.msg_controllen = nfds * CMSG_SPACE(sizeof(int));
 	msg.msg_control = calloc(1, msg.msg_controllen);
 	if (msg.msg_control == NULL)
@@ -317,25 +336,28 @@ fd_package_recv(int sock, int *fds, size_t nfds)
 	if (msg_recv(sock, &msg) == -1)
 		goto end;
 
-	for (i = 0, cmsg = CMSG_FIRSTHDR(&msg); i < nfds && cmsg != NULL;
-	    i++, cmsg = CMSG_NXTHDR(&msg, cmsg)) {
-		fds[i] = msghdr_get_fd(cmsg);
-		if (fds[i] < 0)
+	i = 0;
+	for (cmsg = CMSG_FIRSTHDR(&msg); i < nfds && cmsg != NULL;
+	    cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		got = msghdr_get_fds(cmsg, fds + i, nfds - i);
+		if (got < 0)
 			break;
+		i += (unsigned int)got;
 	}
 
 	if (cmsg != NULL || i < nfds) {
-		int fd;
-
 		/*
 		 * We need to close all received descriptors, even if we have
 		 * different control message (eg. SCM_CREDS) in between.
 		 */
 		for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
 		    cmsg = CMSG_NXTHDR(&msg, cmsg)) {
-			fd = msghdr_get_fd(cmsg);
-			if (fd >= 0)
-				close(fd);
+			int tmpfds[PKG_MAX_SIZE];
+			ssize_t n;
+
+			n = msghdr_get_fds(cmsg, tmpfds, PKG_MAX_SIZE);
+			for (got = 0; got < n; got++)
+				close(tmpfds[got]);
 		}
 		errno = EINVAL;
 		goto end;
@@ -436,6 +458,45 @@ buf_send(int sock, void *buf, size_t size)
 	return (0);
 }
 
+/*
+ * Send a payload assembled from multiple buffers, moving as much as
+ * possible per writev(2) call instead of one send(2) per buffer.  The
+ * iovec array is advanced in place across partial writes.
+ */
+int
+buf_sendv(int sock, struct iovec *iov, int iovcnt)
+{
+	ssize_t done;
+
+	PJDLOG_ASSERT(sock >= 0);
+	PJDLOG_ASSERT(iov != NULL);
+	PJDLOG_ASSERT(iovcnt > 0);
+
+	while (iovcnt > 0) {
+		fd_wait(sock, false);
+		done = writev(sock, iov, iovcnt);
+		if (done == -1) {
+			if (errno == EINTR)
+				continue;
+			return (-1);
+		} else if (done == 0) {
+			errno = ENOTCONN;
+			return (-1);
+		}
+		while (iovcnt > 0 && (size_t)done >= iov->iov_len) {
+			done -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt > 0) {
+			iov->iov_base = (unsigned char *)iov->iov_base + done;
+			iov->iov_len -= done;
+		}
+	}
+
+	return (0);
+}
+
 int
 buf_recv(int sock, void *buf, size_t size)
 {
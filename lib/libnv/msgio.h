@@ -47,6 +47,7 @@ int fd_send(int sock, const int *fds, size_t nfds);
 int fd_recv(int sock, int *fds, size_t nfds);
 
 int buf_send(int sock, void *buf, size_t size);
+int buf_sendv(int sock, struct iovec *iov, int iovcnt);
 int buf_recv(int sock, void *buf, size_t size);
 
 #endif	/* !_MSGIO_H_ */
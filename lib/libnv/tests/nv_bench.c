@@ -0,0 +1,328 @@
+/*-
+ * SPDX-License-Identifier: BSD-2-Clause-FreeBSD
+ *
+ * Copyright (c) 2026 The FreeBSD Foundation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHORS AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHORS OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * Microbenchmarks for libnv.  This is not a functional test; it prints
+ * throughput figures for the operations the library spends most of its
+ * time in (pair insertion, name lookup, pack/unpack, socket transfer)
+ * so that performance regressions in nvlist.c, nvpair.c and msgio.c
+ * show up as numbers instead of anecdotes.  Run it before and after a
+ * change and compare.
+ */
+
+#include <sys/param.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <sys/nv.h>
+
+#include <err.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Minimum wall-clock time each benchmark loop runs for, in seconds. */
+#define	BENCH_MINTIME	0.5
+
+/* List sizes the per-pair benchmarks are run at. */
+static const size_t bench_sizes[] = { 16, 256, 4096, 65536 };
+
+/* Keeps the compiler from discarding benchmark loop bodies. */
+static volatile uint64_t bench_sink;
+
+static double
+bench_now(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) == -1)
+		err(1, "clock_gettime");
+	return ((double)ts.tv_sec + (double)ts.tv_nsec / 1e9);
+}
+
+static void
+bench_report(const char *what, size_t size, double rate, const char *unit)
+{
+
+	if (size > 0)
+		printf("%-24s %7zu %14.0f %s\n", what, size, rate, unit);
+	else
+		printf("%-24s %7s %14.0f %s\n", what, "-", rate, unit);
+}
+
+static char **
+bench_names(size_t n)
+{
+	char **names;
+	size_t i;
+
+	names = malloc(n * sizeof(names[0]));
+	if (names == NULL)
+		err(1, "malloc");
+	for (i = 0; i < n; i++) {
+		if (asprintf(&names[i], "benchmark/pair/%zu", i) == -1)
+			err(1, "asprintf");
+	}
+	return (names);
+}
+
+static void
+bench_names_free(char **names, size_t n)
+{
+	size_t i;
+
+	for (i = 0; i < n; i++)
+		free(names[i]);
+	free(names);
+}
+
+static nvlist_t *
+bench_build(char **names, size_t size)
+{
+	nvlist_t *nvl;
+	size_t i;
+
+	nvl = nvlist_create(0);
+	for (i = 0; i < size; i++)
+		nvlist_add_number(nvl, names[i], i);
+	if (nvlist_error(nvl) != 0)
+		errc(1, nvlist_error(nvl), "nvlist_add_number");
+	return (nvl);
+}
+
+static void
+bench_adds(size_t size)
+{
+	char **names;
+	nvlist_t *nvl;
+	double start;
+	size_t ops;
+
+	names = bench_names(size);
+	ops = 0;
+	start = bench_now();
+	do {
+		nvl = bench_build(names, size);
+		nvlist_destroy(nvl);
+		ops += size;
+	} while (bench_now() - start < BENCH_MINTIME);
+	bench_report("add_number", size, ops / (bench_now() - start),
+	    "adds/s");
+	bench_names_free(names, size);
+}
+
+static void
+bench_lookups(size_t size)
+{
+	char **names;
+	nvlist_t *nvl;
+	double start;
+	size_t i, idx, ops;
+
+	names = bench_names(size);
+	nvl = bench_build(names, size);
+	idx = 0;
+	ops = 0;
+	start = bench_now();
+	do {
+		for (i = 0; i < 1024; i++) {
+			/* Cheap LCG; lookup cost is what is measured. */
+			idx = (idx * 1103515245 + 12345) % size;
+			bench_sink += nvlist_get_number(nvl, names[idx]);
+		}
+		ops += 1024;
+	} while (bench_now() - start < BENCH_MINTIME);
+	bench_report("get_number", size, ops / (bench_now() - start),
+	    "lookups/s");
+	nvlist_destroy(nvl);
+	bench_names_free(names, size);
+}
+
+/*
+ * A list that is mostly numbers with some string and binary payload,
+ * roughly resembling the configuration blobs libnv is used for.
+ */
+static nvlist_t *
+bench_build_payload(void)
+{
+	nvlist_t *nvl;
+	char name[64], blob[4096];
+	size_t i;
+
+	memset(blob, 'x', sizeof(blob));
+	nvl = nvlist_create(0);
+	for (i = 0; i < 1024; i++) {
+		snprintf(name, sizeof(name), "benchmark/number/%zu", i);
+		nvlist_add_number(nvl, name, i);
+	}
+	for (i = 0; i < 128; i++) {
+		snprintf(name, sizeof(name), "benchmark/string/%zu", i);
+		nvlist_add_string(nvl, name,
+		    "abcdefghijklmnopqrstuvwxyz0123456789");
+	}
+	for (i = 0; i < 64; i++) {
+		snprintf(name, sizeof(name), "benchmark/binary/%zu", i);
+		nvlist_add_binary(nvl, name, blob, sizeof(blob));
+	}
+	if (nvlist_error(nvl) != 0)
+		errc(1, nvlist_error(nvl), "nvlist_add");
+	return (nvl);
+}
+
+static void
+bench_pack(void)
+{
+	nvlist_t *nvl;
+	void *buf;
+	double start;
+	size_t bytes, size;
+
+	nvl = bench_build_payload();
+	bytes = 0;
+	start = bench_now();
+	do {
+		buf = nvlist_pack(nvl, &size);
+		if (buf == NULL)
+			err(1, "nvlist_pack");
+		free(buf);
+		bytes += size;
+	} while (bench_now() - start < BENCH_MINTIME);
+	bench_report("pack", nvlist_size(nvl),
+	    bytes / (bench_now() - start) / (1024 * 1024), "MB/s");
+	nvlist_destroy(nvl);
+}
+
+static void
+bench_unpack(void)
+{
+	nvlist_t *nvl, *unpacked;
+	void *buf;
+	double start;
+	size_t bytes, size;
+
+	nvl = bench_build_payload();
+	buf = nvlist_pack(nvl, &size);
+	if (buf == NULL)
+		err(1, "nvlist_pack");
+	bytes = 0;
+	start = bench_now();
+	do {
+		unpacked = nvlist_unpack(buf, size, 0);
+		if (unpacked == NULL)
+			err(1, "nvlist_unpack");
+		nvlist_destroy(unpacked);
+		bytes += size;
+	} while (bench_now() - start < BENCH_MINTIME);
+	bench_report("unpack", size,
+	    bytes / (bench_now() - start) / (1024 * 1024), "MB/s");
+	free(buf);
+	nvlist_destroy(nvl);
+}
+
+static void
+bench_roundtrip(void)
+{
+	nvlist_t *nvl, *back;
+	double start, elapsed;
+	size_t i, ops;
+	pid_t pid;
+	int socks[2], status;
+
+	if (socketpair(PF_UNIX, SOCK_STREAM, 0, socks) == -1)
+		err(1, "socketpair");
+
+	pid = fork();
+	switch (pid) {
+	case -1:
+		err(1, "fork");
+	case 0:
+		/* Child: echo every received list back until EOF. */
+		close(socks[0]);
+		for (;;) {
+			nvl = nvlist_recv(socks[1], 0);
+			if (nvl == NULL)
+				_exit(0);
+			if (nvlist_send(socks[1], nvl) == -1)
+				_exit(1);
+			nvlist_destroy(nvl);
+		}
+	default:
+		break;
+	}
+	close(socks[1]);
+
+	nvl = nvlist_create(0);
+	for (i = 0; i < 8; i++) {
+		char name[32];
+
+		snprintf(name, sizeof(name), "benchmark/rtt/%zu", i);
+		nvlist_add_number(nvl, name, i);
+	}
+
+	ops = 0;
+	start = bench_now();
+	do {
+		if (nvlist_send(socks[0], nvl) == -1)
+			err(1, "nvlist_send");
+		back = nvlist_recv(socks[0], 0);
+		if (back == NULL)
+			err(1, "nvlist_recv");
+		nvlist_destroy(back);
+		ops++;
+	} while (bench_now() - start < BENCH_MINTIME);
+	elapsed = bench_now() - start;
+
+	nvlist_destroy(nvl);
+	close(socks[0]);
+	if (waitpid(pid, &status, 0) == -1)
+		err(1, "waitpid");
+
+	bench_report("send/recv roundtrip", 8, ops / elapsed, "rt/s");
+	bench_report("send/recv latency", 8, elapsed / ops * 1e6, "us/rt");
+}
+
+int
+main(void)
+{
+	size_t i;
+
+	printf("%-24s %7s %14s\n", "benchmark", "size", "rate");
+	for (i = 0; i < nitems(bench_sizes); i++)
+		bench_adds(bench_sizes[i]);
+	for (i = 0; i < nitems(bench_sizes); i++)
+		bench_lookups(bench_sizes[i]);
+	bench_pack();
+	bench_unpack();
+	bench_roundtrip();
+
+	return (0);
+}
@@ -969,6 +969,115 @@ pmc_match_event_name(const char *name, const char *canonicalname)
 	return (0);
 }
 
+/*
+ * Hashed event name lookup.
+ *
+ * The event vocabulary is fixed once pmc_init() has selected the class
+ * tables for the running CPU, but it used to be searched linearly on
+ * every allocation.  Instead, a hash table over all the class tables is
+ * built lazily on first use.  Keys are the canonical form of an event
+ * name (upper case, with the interchangeable separator characters all
+ * folded to underscores), which encodes the same equivalence as
+ * pmc_match_event_name(), so the hashed path accepts exactly the
+ * spellings the linear search did.
+ */
+
+#define	PMC_EVENT_CANON_MAX	128
+
+struct pmc_event_hash_ent {
+	const struct pmc_event_descr *peh_ev;
+	const struct pmc_class_descr *peh_pcd;
+	char		peh_name[PMC_EVENT_CANON_MAX];
+};
+
+static struct pmc_event_hash_ent *pmc_event_name_hash;
+static size_t pmc_event_hash_size;	/* power of two, or 0 */
+
+static void
+pmc_canonicalize_event_name(const char *name, char *buf, size_t buflen)
+{
+	size_t i;
+	int c;
+
+	for (i = 0; i < buflen - 1 && (c = (unsigned char) name[i]) != '\0';
+	    i++)
+		buf[i] = (c == ' ' || c == '.' || c == '-') ? '_' :
+		    toupper(c);
+	buf[i] = '\0';
+}
+
+static uint32_t
+pmc_event_hash_string(const char *s)
+{
+	uint32_t hash;
+
+	for (hash = 2166136261u; *s != '\0'; s++)
+		hash = (hash ^ (unsigned char) *s) * 16777619u;
+	return (hash);
+}
+
+static int
+pmc_event_hash_build(void)
+{
+	const struct pmc_class_descr *pcd;
+	const struct pmc_event_descr *ev;
+	struct pmc_event_hash_ent *ent;
+	size_t i, n, nevent, size;
+	uint32_t h;
+
+	nevent = 0;
+	for (n = 0; n < PMC_CLASS_TABLE_SIZE; n++)
+		if ((pcd = pmc_class_table[n]) != NULL)
+			nevent += pcd->pm_evc_event_table_size;
+	if (nevent == 0)
+		return (-1);
+
+	/* Keep the load factor below one half. */
+	for (size = 16; size < 2 * nevent; size <<= 1)
+		continue;
+	if ((pmc_event_name_hash = calloc(size,
+	    sizeof(*pmc_event_name_hash))) == NULL)
+		return (-1);
+	pmc_event_hash_size = size;
+
+	for (n = 0; n < PMC_CLASS_TABLE_SIZE; n++) {
+		if ((pcd = pmc_class_table[n]) == NULL)
+			continue;
+		ev = pcd->pm_evc_event_table;
+		for (i = 0; i < pcd->pm_evc_event_table_size; i++, ev++) {
+			char canon[PMC_EVENT_CANON_MAX];
+
+			pmc_canonicalize_event_name(ev->pm_ev_name, canon,
+			    sizeof(canon));
+			h = pmc_event_hash_string(canon) & (size - 1);
+			while (pmc_event_name_hash[h].peh_ev != NULL)
+				h = (h + 1) & (size - 1);
+			ent = &pmc_event_name_hash[h];
+			ent->peh_ev = ev;
+			ent->peh_pcd = pcd;
+			strlcpy(ent->peh_name, canon, sizeof(ent->peh_name));
+		}
+	}
+	return (0);
+}
+
+static const struct pmc_event_descr *
+pmc_event_hash_lookup(const char *name, const struct pmc_class_descr *pcd)
+{
+	char canon[PMC_EVENT_CANON_MAX];
+	uint32_t h;
+
+	pmc_canonicalize_event_name(name, canon, sizeof(canon));
+	for (h = pmc_event_hash_string(canon) & (pmc_event_hash_size - 1);
+	    pmc_event_name_hash[h].peh_ev != NULL;
+	    h = (h + 1) & (pmc_event_hash_size - 1))
+		if (pmc_event_name_hash[h].peh_pcd == pcd &&
+		    strcmp(pmc_event_name_hash[h].peh_name, canon) == 0)
+			return (pmc_event_name_hash[h].peh_ev);
+
+	return (NULL);
+}
+
 /*
  * Match an event name against all the event named supported by a
  * PMC class.
@@ -982,6 +1091,12 @@ pmc_match_event_class(const char *name,
 	size_t n;
 	const struct pmc_event_descr *ev;
 
+	if (pmc_event_hash_size == 0)
+		(void) pmc_event_hash_build();
+	if (pmc_event_hash_size != 0)
+		return (pmc_event_hash_lookup(name, pcd));
+
+	/* Fall back to a linear scan if the hash could not be built. */
 	ev = pcd->pm_evc_event_table;
 	for (n = 0; n < pcd->pm_evc_event_table_size; n++, ev++)
 		if (pmc_match_event_name(name, ev->pm_ev_name))
@@ -1671,6 +1786,18 @@ _pmc_name_of_event(enum pmc_event pe, enum pmc_cputype cpu)
 		evfence = soft_event_table + soft_event_info.pm_nevent;
 	}
 
+	if (ev != evfence) {
+		const struct pmc_event_descr *guess;
+
+		/*
+		 * The generated tables are almost always dense and in
+		 * code order, so try a direct index before scanning.
+		 */
+		guess = ev + ((int) pe - (int) ev->pm_ev_code);
+		if (guess >= ev && guess < evfence && guess->pm_ev_code == pe)
+			return (guess->pm_ev_name);
+	}
+
 	for (; ev != evfence; ev++)
 		if (pe == ev->pm_ev_code)
 			return (ev->pm_ev_name);
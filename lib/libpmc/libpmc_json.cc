@@ -28,6 +28,7 @@
  *
  */
 
+#include <sys/param.h>
 #include <sys/types.h>
 #include <sys/errno.h>
 #include <sys/sysctl.h>
@@ -39,7 +40,10 @@
 #include <pmc.h>
 #include <pmclog.h>
 #include <assert.h>
+#include <unistd.h>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <sysexits.h>
 #include <pmcformat.h>
 
@@ -69,274 +73,315 @@ static const char *typenames[] = {
 	"{\"type\": \"proc_create\"",
 };
 
-static string
-startentry(struct pmclog_ev *ev)
+static void
+append_startentry(struct pmclog_ev *ev, string &out)
 {
-	char eventbuf[128];
+	char eventbuf[64];
+
+	out += typenames[ev->pl_type];
+	snprintf(eventbuf, sizeof(eventbuf), ", \"tsc\": \"%jd\"",
+	    (uintmax_t)ev->pl_ts.tv_sec);
+	out += eventbuf;
+}
 
-	snprintf(eventbuf, sizeof(eventbuf), "%s, \"tsc\": \"%jd\"",
-	    typenames[ev->pl_type], (uintmax_t)ev->pl_ts.tv_sec);
-	return (string(eventbuf));
+/*
+ * Append 's' to 'out' with JSON string escaping applied.  The common
+ * case is a string with nothing to escape, so characters are appended
+ * a run at a time: the inner scan finds the extent of the next clean
+ * run and the whole run is copied at once.
+ */
+static void
+json_append_escaped(string &out, const char *s)
+{
+	char ubuf[8];
+	const char *p, *q;
+
+	for (p = s; *p != '\0'; p = q) {
+		for (q = p; *q != '\0' && (unsigned char)*q >= 0x20 &&
+		    *q != '"' && *q != '\\'; q++)
+			continue;
+		out.append(p, q - p);
+		if (*q == '\0')
+			return;
+		switch (*q) {
+		case '"':
+			out += "\\\"";
+			break;
+		case '\\':
+			out += "\\\\";
+			break;
+		case '\n':
+			out += "\\n";
+			break;
+		case '\r':
+			out += "\\r";
+			break;
+		case '\t':
+			out += "\\t";
+			break;
+		default:
+			snprintf(ubuf, sizeof(ubuf), "\\u%04x", *q & 0xff);
+			out += ubuf;
+			break;
+		}
+		q++;
+	}
 }
 
-static string
-initialize_to_json(struct pmclog_ev *ev)
+static void
+initialize_to_json(struct pmclog_ev *ev, string &out)
 {
 	char eventbuf[256];
-	string startent;
 
-	startent = startentry(ev);
+	append_startentry(ev, out);
 	snprintf(eventbuf, sizeof(eventbuf),
-	    "%s, \"version\": \"0x%08x\", \"arch\": \"0x%08x\", \"cpuid\": \"%s\", "
-		"\"tsc_freq\": \"%jd\", \"sec\": \"%jd\", \"nsec\": \"%jd\"}\n",
-		startent.c_str(), ev->pl_u.pl_i.pl_version, ev->pl_u.pl_i.pl_arch,
-		ev->pl_u.pl_i.pl_cpuid, (uintmax_t)ev->pl_u.pl_i.pl_tsc_freq,
-		(uintmax_t)ev->pl_u.pl_i.pl_ts.tv_sec, (uintmax_t)ev->pl_u.pl_i.pl_ts.tv_nsec);
-	return string(eventbuf);
+	    ", \"version\": \"0x%08x\", \"arch\": \"0x%08x\", \"cpuid\": \"",
+	    ev->pl_u.pl_i.pl_version, ev->pl_u.pl_i.pl_arch);
+	out += eventbuf;
+	json_append_escaped(out, ev->pl_u.pl_i.pl_cpuid);
+	snprintf(eventbuf, sizeof(eventbuf),
+	    "\", \"tsc_freq\": \"%jd\", \"sec\": \"%jd\", \"nsec\": \"%jd\"}\n",
+	    (uintmax_t)ev->pl_u.pl_i.pl_tsc_freq,
+	    (uintmax_t)ev->pl_u.pl_i.pl_ts.tv_sec,
+	    (uintmax_t)ev->pl_u.pl_i.pl_ts.tv_nsec);
+	out += eventbuf;
 }
 
-static string
-pmcallocate_to_json(struct pmclog_ev *ev)
+static void
+pmcallocate_to_json(struct pmclog_ev *ev, string &out)
 {
 	char eventbuf[256];
-	string startent;
 
-	startent = startentry(ev);
+	append_startentry(ev, out);
 	snprintf(eventbuf, sizeof(eventbuf),
-	    "%s, \"pmcid\": \"0x%08x\", \"event\": \"0x%08x\", \"flags\": \"0x%08x\", "
+	    ", \"pmcid\": \"0x%08x\", \"event\": \"0x%08x\", \"flags\": \"0x%08x\", "
 	    "\"rate\": \"%jd\"}\n",
-		startent.c_str(), ev->pl_u.pl_a.pl_pmcid, ev->pl_u.pl_a.pl_event,
+	    ev->pl_u.pl_a.pl_pmcid, ev->pl_u.pl_a.pl_event,
 	    ev->pl_u.pl_a.pl_flags, (intmax_t)ev->pl_u.pl_a.pl_rate);
-	return string(eventbuf);
+	out += eventbuf;
 }
 
-static string
-pmcattach_to_json(struct pmclog_ev *ev)
+static void
+pmcattach_to_json(struct pmclog_ev *ev, string &out)
 {
-	char eventbuf[2048];
-	string startent;
+	char eventbuf[128];
 
-	startent = startentry(ev);
+	append_startentry(ev, out);
 	snprintf(eventbuf, sizeof(eventbuf),
-	    "%s, \"pmcid\": \"0x%08x\", \"pid\": \"%d\", \"pathname\": \"%s\"}\n",
-		startent.c_str(), ev->pl_u.pl_t.pl_pmcid, ev->pl_u.pl_t.pl_pid,
-	    ev->pl_u.pl_t.pl_pathname);
-	return string(eventbuf);
+	    ", \"pmcid\": \"0x%08x\", \"pid\": \"%d\", \"pathname\": \"",
+	    ev->pl_u.pl_t.pl_pmcid, ev->pl_u.pl_t.pl_pid);
+	out += eventbuf;
+	json_append_escaped(out, ev->pl_u.pl_t.pl_pathname);
+	out += "\"}\n";
 }
 
-static string
-pmcdetach_to_json(struct pmclog_ev *ev)
+static void
+pmcdetach_to_json(struct pmclog_ev *ev, string &out)
 {
 	char eventbuf[128];
-	string startent;
 
-	startent = startentry(ev);
+	append_startentry(ev, out);
 	snprintf(eventbuf, sizeof(eventbuf),
-		"%s, \"pmcid\": \"0x%08x\", \"pid\": \"%d\"}\n",
-			 startent.c_str(), ev->pl_u.pl_d.pl_pmcid, ev->pl_u.pl_d.pl_pid);
-	return string(eventbuf);
+	    ", \"pmcid\": \"0x%08x\", \"pid\": \"%d\"}\n",
+	    ev->pl_u.pl_d.pl_pmcid, ev->pl_u.pl_d.pl_pid);
+	out += eventbuf;
 }
 
 
-static string
-proccsw_to_json(struct pmclog_ev *ev)
+static void
+proccsw_to_json(struct pmclog_ev *ev, string &out)
 {
 	char eventbuf[128];
-	string startent;
 
-	startent = startentry(ev);
-	snprintf(eventbuf, sizeof(eventbuf), "%s, \"pmcid\": \"0x%08x\", \"pid\": \"%d\" "
+	append_startentry(ev, out);
+	snprintf(eventbuf, sizeof(eventbuf),
+	    ", \"pmcid\": \"0x%08x\", \"pid\": \"%d\" "
 	    "\"tid\": \"%d\", \"value\": \"0x%016jx\"}\n",
-		startent.c_str(), ev->pl_u.pl_c.pl_pmcid, ev->pl_u.pl_c.pl_pid,
+	    ev->pl_u.pl_c.pl_pmcid, ev->pl_u.pl_c.pl_pid,
 	    ev->pl_u.pl_c.pl_tid, (uintmax_t)ev->pl_u.pl_c.pl_value);
-	return string(eventbuf);
+	out += eventbuf;
 }
 
-static string
-procexec_to_json(struct pmclog_ev *ev)
+static void
+procexec_to_json(struct pmclog_ev *ev, string &out)
 {
-	char eventbuf[2048];
-	string startent;
+	char eventbuf[128];
 
-	startent = startentry(ev);
+	append_startentry(ev, out);
 	snprintf(eventbuf, sizeof(eventbuf),
-		"%s, \"pmcid\": \"0x%08x\", \"pid\": \"%d\", "
-	    "\"start\": \"0x%016jx\", \"pathname\": \"%s\"}\n",
-		startent.c_str(), ev->pl_u.pl_x.pl_pmcid, ev->pl_u.pl_x.pl_pid,
-		(uintmax_t)ev->pl_u.pl_x.pl_entryaddr, ev->pl_u.pl_x.pl_pathname);
-	return string(eventbuf);
+	    ", \"pmcid\": \"0x%08x\", \"pid\": \"%d\", "
+	    "\"start\": \"0x%016jx\", \"pathname\": \"",
+	    ev->pl_u.pl_x.pl_pmcid, ev->pl_u.pl_x.pl_pid,
+	    (uintmax_t)ev->pl_u.pl_x.pl_entryaddr);
+	out += eventbuf;
+	json_append_escaped(out, ev->pl_u.pl_x.pl_pathname);
+	out += "\"}\n";
 }
 
-static string
-procexit_to_json(struct pmclog_ev *ev)
+static void
+procexit_to_json(struct pmclog_ev *ev, string &out)
 {
 	char eventbuf[128];
-	string startent;
 
-	startent = startentry(ev);
+	append_startentry(ev, out);
 	snprintf(eventbuf, sizeof(eventbuf),
-		"%s, \"pmcid\": \"0x%08x\", \"pid\": \"%d\", "
+	    ", \"pmcid\": \"0x%08x\", \"pid\": \"%d\", "
 	    "\"value\": \"0x%016jx\"}\n",
-		startent.c_str(), ev->pl_u.pl_e.pl_pmcid, ev->pl_u.pl_e.pl_pid,
+	    ev->pl_u.pl_e.pl_pmcid, ev->pl_u.pl_e.pl_pid,
 	    (uintmax_t)ev->pl_u.pl_e.pl_value);
-	return string(eventbuf);
+	out += eventbuf;
 }
 
-static string
-procfork_to_json(struct pmclog_ev *ev)
+static void
+procfork_to_json(struct pmclog_ev *ev, string &out)
 {
 	char eventbuf[128];
-	string startent;
 
-	startent = startentry(ev);
+	append_startentry(ev, out);
 	snprintf(eventbuf, sizeof(eventbuf),
-		"%s, \"oldpid\": \"%d\", \"newpid\": \"%d\"}\n",
-		startent.c_str(), ev->pl_u.pl_f.pl_oldpid, ev->pl_u.pl_f.pl_newpid);
-	return string(eventbuf);
+	    ", \"oldpid\": \"%d\", \"newpid\": \"%d\"}\n",
+	    ev->pl_u.pl_f.pl_oldpid, ev->pl_u.pl_f.pl_newpid);
+	out += eventbuf;
 }
 
-static string
-sysexit_to_json(struct pmclog_ev *ev)
+static void
+sysexit_to_json(struct pmclog_ev *ev, string &out)
 {
 	char eventbuf[128];
-	string startent;
 
-	startent = startentry(ev);
-	snprintf(eventbuf, sizeof(eventbuf), "%s, \"pid\": \"%d\"}\n",
-		startent.c_str(), ev->pl_u.pl_se.pl_pid);
-	return string(eventbuf);
+	append_startentry(ev, out);
+	snprintf(eventbuf, sizeof(eventbuf), ", \"pid\": \"%d\"}\n",
+	    ev->pl_u.pl_se.pl_pid);
+	out += eventbuf;
 }
 
-static string
-userdata_to_json(struct pmclog_ev *ev)
+static void
+userdata_to_json(struct pmclog_ev *ev, string &out)
 {
 	char eventbuf[128];
-	string startent;
 
-	startent = startentry(ev);
-	snprintf(eventbuf, sizeof(eventbuf), "%s, \"userdata\": \"0x%08x\"}\n",
-	    startent.c_str(), ev->pl_u.pl_u.pl_userdata);
-	return string(eventbuf);
+	append_startentry(ev, out);
+	snprintf(eventbuf, sizeof(eventbuf), ", \"userdata\": \"0x%08x\"}\n",
+	    ev->pl_u.pl_u.pl_userdata);
+	out += eventbuf;
 }
 
-static string
-map_in_to_json(struct pmclog_ev *ev)
+static void
+map_in_to_json(struct pmclog_ev *ev, string &out)
 {
-	char eventbuf[2048];
-	string startent;
-
-	startent = startentry(ev);
-	snprintf(eventbuf, sizeof(eventbuf), "%s, \"pid\": \"%d\", "
-	    "\"start\": \"0x%016jx\", \"pathname\": \"%s\"}\n",
-	    startent.c_str(), ev->pl_u.pl_mi.pl_pid,
-	    (uintmax_t)ev->pl_u.pl_mi.pl_start, ev->pl_u.pl_mi.pl_pathname);
-	return string(eventbuf);
+	char eventbuf[128];
+
+	append_startentry(ev, out);
+	snprintf(eventbuf, sizeof(eventbuf), ", \"pid\": \"%d\", "
+	    "\"start\": \"0x%016jx\", \"pathname\": \"",
+	    ev->pl_u.pl_mi.pl_pid, (uintmax_t)ev->pl_u.pl_mi.pl_start);
+	out += eventbuf;
+	json_append_escaped(out, ev->pl_u.pl_mi.pl_pathname);
+	out += "\"}\n";
 }
 
-static string
-map_out_to_json(struct pmclog_ev *ev)
+static void
+map_out_to_json(struct pmclog_ev *ev, string &out)
 {
 	char eventbuf[256];
-	string startent;
 
-	startent = startentry(ev);
-	snprintf(eventbuf, sizeof(eventbuf), "%s, \"pid\": \"%d\", "
+	append_startentry(ev, out);
+	snprintf(eventbuf, sizeof(eventbuf), ", \"pid\": \"%d\", "
 	    "\"start\": \"0x%016jx\", \"end\": \"0x%016jx\"}\n",
-	    startent.c_str(), ev->pl_u.pl_mi.pl_pid,
+	    ev->pl_u.pl_mi.pl_pid,
 	    (uintmax_t)ev->pl_u.pl_mi.pl_start,
 	    (uintmax_t)ev->pl_u.pl_mo.pl_end);
-	return string(eventbuf);
+	out += eventbuf;
 }
 
-static string
-callchain_to_json(struct pmclog_ev *ev)
+static void
+callchain_to_json(struct pmclog_ev *ev, string &out)
 {
-	char eventbuf[1024];
-	string result;
+	char eventbuf[256];
 	uint32_t i;
-	string startent;
 
-	startent = startentry(ev);
+	append_startentry(ev, out);
 	snprintf(eventbuf, sizeof(eventbuf),
-	    "%s, \"pmcid\": \"0x%08x\", \"pid\": \"%d\", \"tid\": \"%d\", "
+	    ", \"pmcid\": \"0x%08x\", \"pid\": \"%d\", \"tid\": \"%d\", "
 	    "\"cpuflags\": \"0x%08x\", \"cpuflags2\": \"0x%08x\", \"pc\": [ ",
-		startent.c_str(), ev->pl_u.pl_cc.pl_pmcid, ev->pl_u.pl_cc.pl_pid,
-	    ev->pl_u.pl_cc.pl_tid, ev->pl_u.pl_cc.pl_cpuflags, ev->pl_u.pl_cc.pl_cpuflags2);
-	result = string(eventbuf);
+	    ev->pl_u.pl_cc.pl_pmcid, ev->pl_u.pl_cc.pl_pid,
+	    ev->pl_u.pl_cc.pl_tid, ev->pl_u.pl_cc.pl_cpuflags,
+	    ev->pl_u.pl_cc.pl_cpuflags2);
+	out += eventbuf;
 	for (i = 0; i < ev->pl_u.pl_cc.pl_npc - 1; i++) {
-		snprintf(eventbuf, sizeof(eventbuf), "\"0x%016jx\", ", (uintmax_t)ev->pl_u.pl_cc.pl_pc[i]);
-		result += string(eventbuf);
+		snprintf(eventbuf, sizeof(eventbuf), "\"0x%016jx\", ",
+		    (uintmax_t)ev->pl_u.pl_cc.pl_pc[i]);
+		out += eventbuf;
 	}
-	snprintf(eventbuf, sizeof(eventbuf), "\"0x%016jx\"]}\n", (uintmax_t)ev->pl_u.pl_cc.pl_pc[i]);
-	result += string(eventbuf);
-	return (result);
+	snprintf(eventbuf, sizeof(eventbuf), "\"0x%016jx\"]}\n",
+	    (uintmax_t)ev->pl_u.pl_cc.pl_pc[i]);
+	out += eventbuf;
 }
 
-static string
-pmcallocatedyn_to_json(struct pmclog_ev *ev)
+static void
+pmcallocatedyn_to_json(struct pmclog_ev *ev, string &out)
 {
-	char eventbuf[2048];
-	string startent;
+	char eventbuf[256];
 
-	startent = startentry(ev);
+	append_startentry(ev, out);
 	snprintf(eventbuf, sizeof(eventbuf),
-	    "%s, \"pmcid\": \"0x%08x\", \"event\": \"%d\", \"flags\": \"0x%08x\", \"evname\": \"%s\"}\n",
-	    startent.c_str(), ev->pl_u.pl_ad.pl_pmcid, ev->pl_u.pl_ad.pl_event,
-	    ev->pl_u.pl_ad.pl_flags, ev->pl_u.pl_ad.pl_evname);
-	return string(eventbuf);
+	    ", \"pmcid\": \"0x%08x\", \"event\": \"%d\", \"flags\": \"0x%08x\", \"evname\": \"",
+	    ev->pl_u.pl_ad.pl_pmcid, ev->pl_u.pl_ad.pl_event,
+	    ev->pl_u.pl_ad.pl_flags);
+	out += eventbuf;
+	json_append_escaped(out, ev->pl_u.pl_ad.pl_evname);
+	out += "\"}\n";
 }
 
-static string
-proccreate_to_json(struct pmclog_ev *ev)
+static void
+proccreate_to_json(struct pmclog_ev *ev, string &out)
 {
-	char eventbuf[2048];
-	string startent;
+	char eventbuf[128];
 
-	startent = startentry(ev);
+	append_startentry(ev, out);
 	snprintf(eventbuf, sizeof(eventbuf),
-	    "%s, \"pid\": \"%d\", \"flags\": \"0x%08x\", \"pcomm\": \"%s\"}\n",
-	    startent.c_str(), ev->pl_u.pl_pc.pl_pid,
-	    ev->pl_u.pl_pc.pl_flags, ev->pl_u.pl_pc.pl_pcomm);
-	return string(eventbuf);
+	    ", \"pid\": \"%d\", \"flags\": \"0x%08x\", \"pcomm\": \"",
+	    ev->pl_u.pl_pc.pl_pid, ev->pl_u.pl_pc.pl_flags);
+	out += eventbuf;
+	json_append_escaped(out, ev->pl_u.pl_pc.pl_pcomm);
+	out += "\"}\n";
 }
 
-static string
-threadcreate_to_json(struct pmclog_ev *ev)
+static void
+threadcreate_to_json(struct pmclog_ev *ev, string &out)
 {
-	char eventbuf[2048];
-	string startent;
+	char eventbuf[128];
 
-	startent = startentry(ev);
+	append_startentry(ev, out);
 	snprintf(eventbuf, sizeof(eventbuf),
-	    "%s, \"tid\": \"%d\", \"pid\": \"%d\", \"flags\": \"0x%08x\", \"tdname\": \"%s\"}\n",
-	    startent.c_str(), ev->pl_u.pl_tc.pl_tid, ev->pl_u.pl_tc.pl_pid,
-	    ev->pl_u.pl_tc.pl_flags, ev->pl_u.pl_tc.pl_tdname);
-	return string(eventbuf);
+	    ", \"tid\": \"%d\", \"pid\": \"%d\", \"flags\": \"0x%08x\", \"tdname\": \"",
+	    ev->pl_u.pl_tc.pl_tid, ev->pl_u.pl_tc.pl_pid,
+	    ev->pl_u.pl_tc.pl_flags);
+	out += eventbuf;
+	json_append_escaped(out, ev->pl_u.pl_tc.pl_tdname);
+	out += "\"}\n";
 }
 
-static string
-threadexit_to_json(struct pmclog_ev *ev)
+static void
+threadexit_to_json(struct pmclog_ev *ev, string &out)
 {
 	char eventbuf[256];
-	string startent;
 
-	startent = startentry(ev);
-	snprintf(eventbuf, sizeof(eventbuf), "%s, \"tid\": \"%d\"}\n",
-	    startent.c_str(), ev->pl_u.pl_te.pl_tid);
-	return string(eventbuf);
+	append_startentry(ev, out);
+	snprintf(eventbuf, sizeof(eventbuf), ", \"tid\": \"%d\"}\n",
+	    ev->pl_u.pl_te.pl_tid);
+	out += eventbuf;
 }
 
-static string
-stub_to_json(struct pmclog_ev *ev)
+static void
+stub_to_json(struct pmclog_ev *ev, string &out)
 {
-	string startent;
 
-	startent = startentry(ev);
-	startent += string("}\n");
-	return startent;
+	append_startentry(ev, out);
+	out += "}\n";
 }
 
-typedef string (*jconv) (struct pmclog_ev*);
+typedef void (*jconv) (struct pmclog_ev*, string&);
 
 static jconv jsonconvert[] = {
 	NULL,
@@ -362,32 +407,368 @@ static jconv jsonconvert[] = {
 	proccreate_to_json,
 };
 
+/*
+ * Append the JSON form of an event to a caller provided buffer.  The
+ * buffer may be reused across events, so a caller streaming a log can
+ * amortize the allocation cost over the whole stream rather than
+ * constructing a fresh string per record.
+ */
+void
+event_to_json_buf(struct pmclog_ev *ev, string &out)
+{
+
+	switch (ev->pl_type) {
+	case PMCLOG_TYPE_DROPNOTIFY:
+	case PMCLOG_TYPE_CLOSELOG:
+	case PMCLOG_TYPE_INITIALIZE:
+	case PMCLOG_TYPE_PMCALLOCATE:
+	case PMCLOG_TYPE_PMCATTACH:
+	case PMCLOG_TYPE_PMCDETACH:
+	case PMCLOG_TYPE_PROCCSW:
+	case PMCLOG_TYPE_PROCEXEC:
+	case PMCLOG_TYPE_PROCEXIT:
+	case PMCLOG_TYPE_PROCFORK:
+	case PMCLOG_TYPE_SYSEXIT:
+	case PMCLOG_TYPE_USERDATA:
+	case PMCLOG_TYPE_MAP_IN:
+	case PMCLOG_TYPE_MAP_OUT:
+	case PMCLOG_TYPE_CALLCHAIN:
+	case PMCLOG_TYPE_PMCALLOCATEDYN:
+	case PMCLOG_TYPE_THR_CREATE:
+	case PMCLOG_TYPE_THR_EXIT:
+	case PMCLOG_TYPE_PROC_CREATE:
+		jsonconvert[ev->pl_type](ev, out);
+		break;
+	default:
+		errx(EX_USAGE, "ERROR: unrecognized event type: %d\n", ev->pl_type);
+	}
+}
+
 string
 event_to_json(struct pmclog_ev *ev){
+	string result;
+
+	result.reserve(256);
+	event_to_json_buf(ev, result);
+	return (result);
+}
+
+/*
+ * Columnar output.
+ *
+ * The JSON form above stringifies every field of every record, which
+ * is convenient for interchange but expensive to produce and to parse
+ * back.  The columnar emitter instead accumulates one packed array per
+ * record field, with string values collapsed into a shared dictionary,
+ * and writes the arrays out contiguously on close in the layout
+ * described in pmcformat.h.  Field coverage matches event_to_json().
+ */
+
+static const char *recordnames[] = {
+	"",
+	"closelog",
+	"dropnotify",
+	"initialize",
+	"",
+	"pmcallocate",
+	"pmcattach",
+	"pmcdetach",
+	"proccsw",
+	"procexec",
+	"procexit",
+	"procfork",
+	"sysexit",
+	"userdata",
+	"map_in",
+	"map_out",
+	"callchain",
+	"pmcallocatedyn",
+	"thr_create",
+	"thr_exit",
+	"proc_create",
+};
+
+struct pmc_column {
+	uint32_t	c_type;		/* pmclog record type */
+	uint32_t	c_elemsize;	/* bytes per element on disk */
+	std::vector<uint64_t> c_rows;
+};
+
+struct pmc_columnar_state {
+	int		cs_fd;
+	uint64_t	cs_nevents;
+	std::vector<std::pair<string, pmc_column>> cs_columns;
+	std::unordered_map<string, size_t> cs_colidx;
+	string		cs_dict;	/* NUL separated dictionary bytes */
+	std::unordered_map<string, uint64_t> cs_dictidx;
+};
+
+static void
+column_append(struct pmc_columnar_state *cs, uint32_t type, const char *field,
+    uint32_t elemsize, uint64_t value)
+{
+	string name;
+	size_t idx;
+
+	/* Global columns (one row per record) carry no record prefix. */
+	if (type == 0)
+		name = field;
+	else
+		name = string(recordnames[type]) + "." + field;
+	auto kvpair = cs->cs_colidx.find(name);
+	if (kvpair == cs->cs_colidx.end()) {
+		idx = cs->cs_columns.size();
+		cs->cs_columns.emplace_back(name, pmc_column());
+		cs->cs_columns[idx].second.c_type = type;
+		cs->cs_columns[idx].second.c_elemsize = elemsize;
+		cs->cs_colidx[name] = idx;
+	} else
+		idx = kvpair->second;
+	cs->cs_columns[idx].second.c_rows.push_back(value);
+}
+
+static uint64_t
+dictionary_offset(struct pmc_columnar_state *cs, const char *s)
+{
+	uint64_t offset;
+
+	auto kvpair = cs->cs_dictidx.find(s);
+	if (kvpair != cs->cs_dictidx.end())
+		return (kvpair->second);
+	offset = cs->cs_dict.size();
+	cs->cs_dict.append(s);
+	cs->cs_dict.push_back('\0');
+	cs->cs_dictidx[s] = offset;
+	return (offset);
+}
+
+void *
+pmccolumnar_open(int fd)
+{
+	struct pmc_columnar_state *cs;
+
+	cs = new pmc_columnar_state();
+	cs->cs_fd = fd;
+	cs->cs_nevents = 0;
+	return (cs);
+}
+
+void
+pmccolumnar_append(void *cookie, struct pmclog_ev *ev)
+{
+	struct pmc_columnar_state *cs;
+	uint32_t i, t;
+
+	cs = (struct pmc_columnar_state *) cookie;
+	t = ev->pl_type;
+
+	/* Every record contributes to the global type and tsc columns. */
+	column_append(cs, 0, "type", 4, t);
+	column_append(cs, 0, "tsc", 8, ev->pl_ts.tv_sec);
+	cs->cs_nevents++;
 
 	switch (ev->pl_type) {
 	case PMCLOG_TYPE_DROPNOTIFY:
 	case PMCLOG_TYPE_CLOSELOG:
+		break;
 	case PMCLOG_TYPE_INITIALIZE:
+		column_append(cs, t, "version", 4, ev->pl_u.pl_i.pl_version);
+		column_append(cs, t, "arch", 4, ev->pl_u.pl_i.pl_arch);
+		column_append(cs, t, "tsc_freq", 8, ev->pl_u.pl_i.pl_tsc_freq);
+		column_append(cs, t, "sec", 8, ev->pl_u.pl_i.pl_ts.tv_sec);
+		column_append(cs, t, "nsec", 8, ev->pl_u.pl_i.pl_ts.tv_nsec);
+		column_append(cs, t, "cpuid", 8,
+		    dictionary_offset(cs, ev->pl_u.pl_i.pl_cpuid));
+		break;
 	case PMCLOG_TYPE_PMCALLOCATE:
+		column_append(cs, t, "pmcid", 4, ev->pl_u.pl_a.pl_pmcid);
+		column_append(cs, t, "event", 4, ev->pl_u.pl_a.pl_event);
+		column_append(cs, t, "flags", 4, ev->pl_u.pl_a.pl_flags);
+		column_append(cs, t, "rate", 8, ev->pl_u.pl_a.pl_rate);
+		break;
 	case PMCLOG_TYPE_PMCATTACH:
+		column_append(cs, t, "pmcid", 4, ev->pl_u.pl_t.pl_pmcid);
+		column_append(cs, t, "pid", 4, ev->pl_u.pl_t.pl_pid);
+		column_append(cs, t, "pathname", 8,
+		    dictionary_offset(cs, ev->pl_u.pl_t.pl_pathname));
+		break;
 	case PMCLOG_TYPE_PMCDETACH:
+		column_append(cs, t, "pmcid", 4, ev->pl_u.pl_d.pl_pmcid);
+		column_append(cs, t, "pid", 4, ev->pl_u.pl_d.pl_pid);
+		break;
 	case PMCLOG_TYPE_PROCCSW:
+		column_append(cs, t, "pmcid", 4, ev->pl_u.pl_c.pl_pmcid);
+		column_append(cs, t, "pid", 4, ev->pl_u.pl_c.pl_pid);
+		column_append(cs, t, "tid", 4, ev->pl_u.pl_c.pl_tid);
+		column_append(cs, t, "value", 8, ev->pl_u.pl_c.pl_value);
+		break;
 	case PMCLOG_TYPE_PROCEXEC:
+		column_append(cs, t, "pmcid", 4, ev->pl_u.pl_x.pl_pmcid);
+		column_append(cs, t, "pid", 4, ev->pl_u.pl_x.pl_pid);
+		column_append(cs, t, "start", 8, ev->pl_u.pl_x.pl_entryaddr);
+		column_append(cs, t, "pathname", 8,
+		    dictionary_offset(cs, ev->pl_u.pl_x.pl_pathname));
+		break;
 	case PMCLOG_TYPE_PROCEXIT:
+		column_append(cs, t, "pmcid", 4, ev->pl_u.pl_e.pl_pmcid);
+		column_append(cs, t, "pid", 4, ev->pl_u.pl_e.pl_pid);
+		column_append(cs, t, "value", 8, ev->pl_u.pl_e.pl_value);
+		break;
 	case PMCLOG_TYPE_PROCFORK:
+		column_append(cs, t, "oldpid", 4, ev->pl_u.pl_f.pl_oldpid);
+		column_append(cs, t, "newpid", 4, ev->pl_u.pl_f.pl_newpid);
+		break;
 	case PMCLOG_TYPE_SYSEXIT:
+		column_append(cs, t, "pid", 4, ev->pl_u.pl_se.pl_pid);
+		break;
 	case PMCLOG_TYPE_USERDATA:
+		column_append(cs, t, "userdata", 4, ev->pl_u.pl_u.pl_userdata);
+		break;
 	case PMCLOG_TYPE_MAP_IN:
+		column_append(cs, t, "pid", 4, ev->pl_u.pl_mi.pl_pid);
+		column_append(cs, t, "start", 8, ev->pl_u.pl_mi.pl_start);
+		column_append(cs, t, "pathname", 8,
+		    dictionary_offset(cs, ev->pl_u.pl_mi.pl_pathname));
+		break;
 	case PMCLOG_TYPE_MAP_OUT:
+		column_append(cs, t, "pid", 4, ev->pl_u.pl_mo.pl_pid);
+		column_append(cs, t, "start", 8, ev->pl_u.pl_mo.pl_start);
+		column_append(cs, t, "end", 8, ev->pl_u.pl_mo.pl_end);
+		break;
 	case PMCLOG_TYPE_CALLCHAIN:
+		column_append(cs, t, "pmcid", 4, ev->pl_u.pl_cc.pl_pmcid);
+		column_append(cs, t, "pid", 4, ev->pl_u.pl_cc.pl_pid);
+		column_append(cs, t, "tid", 4, ev->pl_u.pl_cc.pl_tid);
+		column_append(cs, t, "cpuflags", 4, ev->pl_u.pl_cc.pl_cpuflags);
+		column_append(cs, t, "cpuflags2", 4, ev->pl_u.pl_cc.pl_cpuflags2);
+		/*
+		 * Variable length call chains are flattened: "npc" gives
+		 * the per-record frame count and "pc" holds the frames of
+		 * all records back to back.
+		 */
+		column_append(cs, t, "npc", 4, ev->pl_u.pl_cc.pl_npc);
+		for (i = 0; i < ev->pl_u.pl_cc.pl_npc; i++)
+			column_append(cs, t, "pc", 8, ev->pl_u.pl_cc.pl_pc[i]);
+		break;
 	case PMCLOG_TYPE_PMCALLOCATEDYN:
+		column_append(cs, t, "pmcid", 4, ev->pl_u.pl_ad.pl_pmcid);
+		column_append(cs, t, "event", 4, ev->pl_u.pl_ad.pl_event);
+		column_append(cs, t, "flags", 4, ev->pl_u.pl_ad.pl_flags);
+		column_append(cs, t, "evname", 8,
+		    dictionary_offset(cs, ev->pl_u.pl_ad.pl_evname));
+		break;
 	case PMCLOG_TYPE_THR_CREATE:
+		column_append(cs, t, "tid", 4, ev->pl_u.pl_tc.pl_tid);
+		column_append(cs, t, "pid", 4, ev->pl_u.pl_tc.pl_pid);
+		column_append(cs, t, "flags", 4, ev->pl_u.pl_tc.pl_flags);
+		column_append(cs, t, "tdname", 8,
+		    dictionary_offset(cs, ev->pl_u.pl_tc.pl_tdname));
+		break;
 	case PMCLOG_TYPE_THR_EXIT:
+		column_append(cs, t, "tid", 4, ev->pl_u.pl_te.pl_tid);
+		break;
 	case PMCLOG_TYPE_PROC_CREATE:
-		return jsonconvert[ev->pl_type](ev);
+		column_append(cs, t, "pid", 4, ev->pl_u.pl_pc.pl_pid);
+		column_append(cs, t, "flags", 4, ev->pl_u.pl_pc.pl_flags);
+		column_append(cs, t, "pcomm", 8,
+		    dictionary_offset(cs, ev->pl_u.pl_pc.pl_pcomm));
+		break;
 	default:
 		errx(EX_USAGE, "ERROR: unrecognized event type: %d\n", ev->pl_type);
 	}
 }
 
+static int
+columnar_write(int fd, const void *data, size_t len)
+{
+	ssize_t nwritten;
+	const char *p;
+
+	p = (const char *) data;
+	while (len > 0) {
+		if ((nwritten = write(fd, p, len)) < 0)
+			return (-1);
+		p += nwritten;
+		len -= nwritten;
+	}
+	return (0);
+}
+
+int
+pmccolumnar_close(void *cookie)
+{
+	struct pmc_columnar_state *cs;
+	struct pmc_columnar_header header;
+	std::vector<struct pmc_column_desc> descs;
+	uint64_t offset;
+	int error;
+
+	cs = (struct pmc_columnar_state *) cookie;
+	error = 0;
+
+	/* Lay the columns out behind the header and descriptor table. */
+	offset = sizeof(header) +
+	    cs->cs_columns.size() * sizeof(struct pmc_column_desc);
+	offset = roundup2(offset, 8);
+	for (auto &col : cs->cs_columns) {
+		struct pmc_column_desc desc;
+
+		memset(&desc, 0, sizeof(desc));
+		strlcpy(desc.pcd_name, col.first.c_str(),
+		    sizeof(desc.pcd_name));
+		desc.pcd_type = col.second.c_type;
+		desc.pcd_elemsize = col.second.c_elemsize;
+		desc.pcd_nrows = col.second.c_rows.size();
+		desc.pcd_offset = offset;
+		offset = roundup2(offset +
+		    desc.pcd_nrows * desc.pcd_elemsize, 8);
+		descs.push_back(desc);
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.pch_magic = PMC_COLUMNAR_MAGIC;
+	header.pch_version = PMC_COLUMNAR_VERSION;
+	header.pch_nevents = cs->cs_nevents;
+	header.pch_ncolumns = cs->cs_columns.size();
+	header.pch_dictoffset = offset;
+	header.pch_dictlen = cs->cs_dict.size();
+
+	if (columnar_write(cs->cs_fd, &header, sizeof(header)) < 0 ||
+	    columnar_write(cs->cs_fd, descs.data(),
+	    descs.size() * sizeof(struct pmc_column_desc)) < 0)
+		error = -1;
+	offset = sizeof(header) +
+	    descs.size() * sizeof(struct pmc_column_desc);
+	for (size_t i = 0; error == 0 && i < cs->cs_columns.size(); i++) {
+		const struct pmc_column *col = &cs->cs_columns[i].second;
+		string data;
+
+		/* Pad to the 8 byte alignment promised by the layout. */
+		data.append(descs[i].pcd_offset - offset, '\0');
+		for (uint64_t v : col->c_rows) {
+			if (col->c_elemsize == 4) {
+				uint32_t v32 = v;
+
+				data.append((const char *) &v32, sizeof(v32));
+			} else
+				data.append((const char *) &v, sizeof(v));
+		}
+		if (columnar_write(cs->cs_fd, data.data(), data.size()) < 0)
+			error = -1;
+		offset = descs[i].pcd_offset +
+		    descs[i].pcd_nrows * descs[i].pcd_elemsize;
+	}
+	if (error == 0) {
+		string pad;
+
+		pad.append(header.pch_dictoffset - offset, '\0');
+		if (columnar_write(cs->cs_fd, pad.data(), pad.size()) < 0 ||
+		    columnar_write(cs->cs_fd, cs->cs_dict.data(),
+		    cs->cs_dict.size()) < 0)
+			error = -1;
+	}
+
+	delete cs;
+	return (error);
+}
+
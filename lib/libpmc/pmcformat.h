@@ -30,4 +30,44 @@
 #ifndef __PMCFORMAT_H_
 #define __PMCFORMAT_H_
 std::string event_to_json(struct pmclog_ev *ev);
+void event_to_json_buf(struct pmclog_ev *ev, std::string &out);
+
+/*
+ * Columnar event output.
+ *
+ * A columnar file starts with a 'struct pmc_columnar_header', followed
+ * by 'pch_ncolumns' column descriptors, followed by the column data and
+ * finally a string dictionary of NUL terminated strings.  Each column
+ * holds the values of one field for every record of one type, in record
+ * order, as a packed array of 'pcd_elemsize' byte elements in host byte
+ * order; string valued fields store byte offsets into the dictionary.
+ * Readers are expected to mmap(2) the file and address individual
+ * columns directly through the descriptor table.
+ */
+
+#define	PMC_COLUMNAR_MAGIC	0x504d4343	/* "PMCC" */
+#define	PMC_COLUMNAR_VERSION	1
+#define	PMC_COLUMN_NAME_MAX	32
+
+struct pmc_column_desc {
+	char		pcd_name[PMC_COLUMN_NAME_MAX];
+	uint32_t	pcd_type;	/* pmclog record type */
+	uint32_t	pcd_elemsize;	/* bytes per element */
+	uint64_t	pcd_nrows;
+	uint64_t	pcd_offset;	/* from the start of the file */
+};
+
+struct pmc_columnar_header {
+	uint32_t	pch_magic;
+	uint32_t	pch_version;
+	uint64_t	pch_nevents;
+	uint32_t	pch_ncolumns;
+	uint32_t	pch_pad;
+	uint64_t	pch_dictoffset;
+	uint64_t	pch_dictlen;
+};
+
+void	*pmccolumnar_open(int _fd);
+void	pmccolumnar_append(void *_cookie, struct pmclog_ev *_ev);
+int	pmccolumnar_close(void *_cookie);
 #endif
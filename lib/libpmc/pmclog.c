@@ -34,8 +34,11 @@
 __FBSDID("$FreeBSD$");
 
 #include <sys/param.h>
+#include <sys/event.h>
+#include <sys/mman.h>
 #include <sys/pmc.h>
 #include <sys/pmclog.h>
+#include <sys/stat.h>
 
 #include <assert.h>
 #include <errno.h>
@@ -54,6 +57,12 @@ __FBSDID("$FreeBSD$");
 
 #define	PMCLOG_BUFFER_SIZE			512*1024
 
+/*
+ * Size of the madvise(2) readahead window kept ahead of the parse
+ * cursor for parsers created with pmclog_open_mmap().
+ */
+#define	PMCLOG_MMAP_WINDOW			(8*1024*1024)
+
 /*
  * API NOTES
  *
@@ -76,6 +85,11 @@ __FBSDID("$FreeBSD$");
  * event record.  However the parser's state machine would get
  * insanely complicated, and this code is unlikely to be used in
  * performance critical paths.
+ *
+ * Parsers created with 'pmclog_open_mmap()' are backed by a memory
+ * mapping of the whole log file.  Every record is then complete and
+ * 32-bit aligned in place, so the assembly step above is skipped and
+ * records are parsed directly out of the mapping.
  */
 
 #define	PMCLOG_HEADER_FROM_SAVED_STATE(PS)				\
@@ -266,18 +280,43 @@ pmclog_get_event(void *cookie, char **data, ssize_t *len,
 
 	assert(ps->ps_state != PL_STATE_ERROR);
 
-	if ((e = pmclog_get_record(ps,data,len)) == PL_STATE_ERROR) {
-		ev->pl_state = PMCLOG_ERROR;
-		printf("state error\n");
-		return -1;
-	}
+	if (ps->ps_mmap_base != NULL) {
+		/*
+		 * Zero-copy path: the record is complete and aligned
+		 * in the mapping, so parse it in place instead of
+		 * assembling a copy in the work area.
+		 */
+		if (*len < (ssize_t) sizeof(uint32_t)) {
+			ev->pl_state = PMCLOG_EOF;
+			return -1;
+		}
+		le = (uint32_t *)(uintptr_t) *data;
+		evlen = PMCLOG_HEADER_TO_LENGTH(*le);
+		if (evlen <= 0) {
+			ps->ps_state = PL_STATE_ERROR;
+			ev->pl_state = PMCLOG_ERROR;
+			return -1;
+		}
+		if (evlen > *len) {	/* truncated trailing record */
+			ev->pl_state = PMCLOG_EOF;
+			return -1;
+		}
+		*data += evlen;
+		*len -= evlen;
+	} else {
+		if ((e = pmclog_get_record(ps,data,len)) == PL_STATE_ERROR) {
+			ev->pl_state = PMCLOG_ERROR;
+			printf("state error\n");
+			return -1;
+		}
 
-	if (e != PL_STATE_NEW_RECORD) {
-		ev->pl_state = PMCLOG_REQUIRE_DATA;
-		return -1;
-	}
+		if (e != PL_STATE_NEW_RECORD) {
+			ev->pl_state = PMCLOG_REQUIRE_DATA;
+			return -1;
+		}
 
-	PMCLOG_INITIALIZE_READER(le, ps->ps_saved);
+		PMCLOG_INITIALIZE_READER(le, ps->ps_saved);
+	}
 	ev->pl_data = le;
 	ph = (struct pmclog_header *)(uintptr_t)le;
 
@@ -444,6 +483,27 @@ pmclog_get_event(void *cookie, char **data, ssize_t *len,
 	return -1;
 }
 
+/*
+ * Keep a window of the mapping advised as MADV_WILLNEED ahead of the
+ * parse cursor, so that the pager stays ahead of the consumer without
+ * faulting the whole file in at once.
+ */
+
+static void
+pmclog_mmap_readahead(struct pmclog_parse_state *ps)
+{
+	size_t consumed;
+
+	consumed = ps->ps_data - (char *) ps->ps_mmap_base;
+	if (ps->ps_mmap_advised >= ps->ps_mmap_len ||
+	    consumed + PMCLOG_MMAP_WINDOW / 2 < ps->ps_mmap_advised)
+		return;
+	(void) madvise((char *) ps->ps_mmap_base + ps->ps_mmap_advised,
+	    MIN(PMCLOG_MMAP_WINDOW, ps->ps_mmap_len - ps->ps_mmap_advised),
+	    MADV_WILLNEED);
+	ps->ps_mmap_advised += PMCLOG_MMAP_WINDOW;
+}
+
 /*
  * Extract and return the next event from the byte stream.
  *
@@ -468,6 +528,9 @@ pmclog_read(void *cookie, struct pmclog_ev *ev)
 		return -1;
 	}
 
+	if (ps->ps_mmap_base != NULL)
+		pmclog_mmap_readahead(ps);
+
 	/*
 	 * If there isn't enough data left for a new event try and get
 	 * more data.
@@ -497,6 +560,8 @@ pmclog_read(void *cookie, struct pmclog_ev *ev)
 			ps->ps_len = nread;
 			ps->ps_data = ps->ps_buffer;
 		} else {
+			if (ps->ps_mmap_base != NULL)
+				ev->pl_state = PMCLOG_EOF;
 			return -1;
 		}
 	}
@@ -568,6 +633,9 @@ pmclog_open(int fd)
 	ps->ps_data  = NULL;
 	ps->ps_buffer = NULL;
 	ps->ps_len   = 0;
+	ps->ps_mmap_base = NULL;
+	ps->ps_mmap_len = 0;
+	ps->ps_mmap_advised = 0;
 
 	/* allocate space for a work area */
 	if (ps->ps_fd != PMCLOG_FD_NONE) {
@@ -580,6 +648,165 @@ pmclog_open(int fd)
 	return ps;
 }
 
+/*
+ * Allocate and initialize parser state for a memory mapped log file.
+ *
+ * The log file referenced by 'fd' is mapped in its entirety and
+ * records are parsed directly out of the mapping, avoiding the
+ * read-and-copy loop of a file based parser.  If the descriptor
+ * cannot be mapped (it refers to a pipe or socket, say) this falls
+ * back to returning an ordinary file based parser.
+ */
+
+void *
+pmclog_open_mmap(int fd)
+{
+	struct pmclog_parse_state *ps;
+	struct stat sb;
+	void *base;
+
+	if (fstat(fd, &sb) < 0 || !S_ISREG(sb.st_mode) || sb.st_size == 0)
+		return (pmclog_open(fd));
+
+	if ((base = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd,
+	    0)) == MAP_FAILED)
+		return (pmclog_open(fd));
+	(void) madvise(base, sb.st_size, MADV_SEQUENTIAL);
+
+	if ((ps = (struct pmclog_parse_state *)
+	    pmclog_open(PMCLOG_FD_NONE)) == NULL) {
+		(void) munmap(base, sb.st_size);
+		return NULL;
+	}
+
+	ps->ps_mmap_base = base;
+	ps->ps_mmap_len = sb.st_size;
+	ps->ps_data = (char *) base;
+	ps->ps_len = sb.st_size;
+
+	return ps;
+}
+
+/*
+ * Live tailing of a growing log file.
+ *
+ * A tail cursor wraps an ordinary file based parser in a private
+ * kqueue watching the descriptor for growth, so a consumer following
+ * a log as hwpmc appends to it blocks in kevent(2) instead of
+ * sleeping and retrying.  Records are still delivered through the
+ * regular parser, a buffer full at a time.
+ */
+
+struct pmclog_tail_state {
+	struct pmclog_parse_state *pt_ps;	/* underlying parser */
+	int		pt_kq;			/* private kqueue */
+	int		pt_fd;
+};
+
+void *
+pmclog_tail_open(int fd)
+{
+	struct pmclog_tail_state *ts;
+	struct kevent kev;
+
+	if ((ts = (struct pmclog_tail_state *) malloc(sizeof(*ts))) == NULL)
+		return NULL;
+
+	if ((ts->pt_ps = (struct pmclog_parse_state *)
+	    pmclog_open(fd)) == NULL) {
+		free(ts);
+		return NULL;
+	}
+	if ((ts->pt_kq = kqueue()) < 0)
+		goto error;
+	ts->pt_fd = fd;
+
+	/*
+	 * EVFILT_READ covers pipes and sockets; EVFILT_VNODE with
+	 * NOTE_WRITE | NOTE_EXTEND covers a log file being appended
+	 * to.  Register both and accept whichever the descriptor
+	 * supports, failing only if neither can be registered.
+	 */
+	EV_SET(&kev, fd, EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, NULL);
+	if (kevent(ts->pt_kq, &kev, 1, NULL, 0, NULL) < 0) {
+		EV_SET(&kev, fd, EVFILT_VNODE, EV_ADD | EV_CLEAR,
+		    NOTE_WRITE | NOTE_EXTEND, 0, NULL);
+		if (kevent(ts->pt_kq, &kev, 1, NULL, 0, NULL) < 0) {
+			close(ts->pt_kq);
+			goto error;
+		}
+	}
+
+	return ts;
+
+ error:
+	pmclog_close(ts->pt_ps);
+	free(ts);
+	return NULL;
+}
+
+/*
+ * Return the next record from a tailed log, blocking in kevent(2)
+ * when the parser runs out of data.  'timeout' bounds the wait as for
+ * kevent(2); NULL blocks indefinitely.  On timeout -1 is returned
+ * with the event state set to PMCLOG_REQUIRE_DATA.
+ */
+
+int
+pmclog_tail_read(void *cookie, struct pmclog_ev *ev,
+    const struct timespec *timeout)
+{
+	struct pmclog_tail_state *ts;
+	struct kevent kev;
+	int n;
+
+	ts = (struct pmclog_tail_state *) cookie;
+
+	for (;;) {
+		if (pmclog_read(ts->pt_ps, ev) == 0)
+			return 0;
+		if (ev->pl_state != PMCLOG_REQUIRE_DATA &&
+		    ev->pl_state != PMCLOG_EOF)
+			return -1;
+
+		if ((n = kevent(ts->pt_kq, NULL, 0, &kev, 1, timeout)) < 0) {
+			if (errno == EINTR)
+				continue;
+			ev->pl_state = PMCLOG_ERROR;
+			return -1;
+		}
+		if (n == 0) {
+			ev->pl_state = PMCLOG_REQUIRE_DATA;
+			return -1;
+		}
+	}
+}
+
+/*
+ * Return the descriptor of the tail cursor's kqueue.  Kqueues are
+ * themselves pollable, so this lets a caller fold the cursor into its
+ * own event loop and call pmclog_tail_read() with a zero timeout when
+ * the descriptor fires.
+ */
+
+int
+pmclog_tail_fd(void *cookie)
+{
+
+	return ((struct pmclog_tail_state *) cookie)->pt_kq;
+}
+
+void
+pmclog_tail_close(void *cookie)
+{
+	struct pmclog_tail_state *ts;
+
+	ts = (struct pmclog_tail_state *) cookie;
+
+	close(ts->pt_kq);
+	pmclog_close(ts->pt_ps);
+	free(ts);
+}
 
 /*
  * Free up parser state.
@@ -595,5 +822,8 @@ pmclog_close(void *cookie)
 	if (ps->ps_buffer)
 		free(ps->ps_buffer);
 
+	if (ps->ps_mmap_base != NULL)
+		(void) munmap(ps->ps_mmap_base, ps->ps_mmap_len);
+
 	free(ps);
 }
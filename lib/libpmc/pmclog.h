@@ -218,15 +218,26 @@ struct pmclog_parse_state {
 	char			*ps_data;	/* current parse pointer */
 	char			*ps_cpuid;	/* log cpuid */
 	size_t			ps_len;		/* length of buffered data */
+	void			*ps_mmap_base;	/* mapped log file or NULL */
+	size_t			ps_mmap_len;	/* length of the mapping */
+	size_t			ps_mmap_advised; /* bytes of readahead issued */
 };
 
 #define	PMCLOG_FD_NONE				(-1)
 
+struct timespec;
+
 __BEGIN_DECLS
 void	*pmclog_open(int _fd);
+void	*pmclog_open_mmap(int _fd);
 int	pmclog_feed(void *_cookie, char *_data, int _len);
 int	pmclog_read(void *_cookie, struct pmclog_ev *_ev);
 void	pmclog_close(void *_cookie);
+void	*pmclog_tail_open(int _fd);
+int	pmclog_tail_read(void *_cookie, struct pmclog_ev *_ev,
+	    const struct timespec *_timeout);
+int	pmclog_tail_fd(void *_cookie);
+void	pmclog_tail_close(void *_cookie);
 __END_DECLS
 
 #endif
@@ -1711,6 +1711,77 @@ find_library(const char *xname, const Obj_Entry *refobj, int *fdp)
 	return (NULL);
 }
 
+/*
+ * Cross-object symbol resolution cache, active only while
+ * relocate_objects() runs.  The per-object SymCache avoids repeated
+ * lookups of one symbol number within an object, but every object
+ * still pays for its own walk of the global scope, so a binary with a
+ * hundred libraries resolves "memcpy" a hundred times.  While the set
+ * of loaded objects is fixed - which it is for the duration of a
+ * relocation pass - resolution from a non-symbolic object depends only
+ * on the symbol name, its version and the lookup flags, so the result
+ * can be shared across referencing objects.  Weak references resolved
+ * to the zero symbol are never inserted, since a strong reference to
+ * the same name must still fail.
+ */
+typedef struct Struct_SymCacheGlobal {
+    const char *name;		/* key: symbol name */
+    const char *ver;		/* key: version name, or NULL */
+    int flags;			/* key: lookup flags */
+    const Elf_Sym *sym;		/* resolved symbol */
+    const Obj_Entry *defobj;	/* defining object */
+} SymCacheGlobal;
+
+#define SYMCACHE_GLOBAL_SIZE	8192	/* entries; must be a power of two */
+
+static SymCacheGlobal *symcache_global;
+static unsigned int symcache_global_used;
+
+static const Elf_Sym *
+symcache_global_lookup(const char *name, const Ver_Entry *ve, int flags,
+    const Obj_Entry **defobj_out)
+{
+    SymCacheGlobal *entry;
+    unsigned int i;
+
+    if (symcache_global == NULL)
+	return (NULL);
+    for (i = gnu_hash(name) & (SYMCACHE_GLOBAL_SIZE - 1);
+	 (entry = &symcache_global[i])->name != NULL;
+	 i = (i + 1) & (SYMCACHE_GLOBAL_SIZE - 1)) {
+	if (entry->flags == flags && strcmp(entry->name, name) == 0 &&
+	  ((entry->ver == NULL && ve == NULL) || (entry->ver != NULL &&
+	  ve != NULL && strcmp(entry->ver, ve->name) == 0))) {
+	    *defobj_out = entry->defobj;
+	    return (entry->sym);
+	}
+    }
+    return (NULL);
+}
+
+static void
+symcache_global_insert(const char *name, const Ver_Entry *ve, int flags,
+    const Elf_Sym *sym, const Obj_Entry *defobj)
+{
+    SymCacheGlobal *entry;
+    unsigned int i;
+
+    /* Leave slack so the linear probe chains stay short. */
+    if (symcache_global == NULL || symcache_global_used >=
+      SYMCACHE_GLOBAL_SIZE - SYMCACHE_GLOBAL_SIZE / 4)
+	return;
+    for (i = gnu_hash(name) & (SYMCACHE_GLOBAL_SIZE - 1);
+	 (entry = &symcache_global[i])->name != NULL;
+	 i = (i + 1) & (SYMCACHE_GLOBAL_SIZE - 1))
+	continue;
+    entry->name = name;
+    entry->ver = ve != NULL ? ve->name : NULL;
+    entry->flags = flags;
+    entry->sym = sym;
+    entry->defobj = defobj;
+    symcache_global_used++;
+}
+
 /*
  * Given a symbol number in a referencing object, find the corresponding
  * definition of the symbol.  Returns a pointer to the symbol, or NULL if
@@ -1764,10 +1835,16 @@ find_symdef(unsigned long symnum, const Obj_Entry *refobj,
 	req.flags = flags;
 	ve = req.ventry = fetch_ventry(refobj, symnum);
 	req.lockstate = lockstate;
-	res = symlook_default(&req, refobj);
-	if (res == 0) {
-	    def = req.sym_out;
-	    defobj = req.defobj_out;
+	if (!refobj->symbolic)
+	    def = symcache_global_lookup(name, ve, flags, &defobj);
+	if (def == NULL) {
+	    res = symlook_default(&req, refobj);
+	    if (res == 0) {
+		def = req.sym_out;
+		defobj = req.defobj_out;
+		if (!refobj->symbolic)
+		    symcache_global_insert(name, ve, flags, def, defobj);
+	    }
 	}
     } else {
 	def = ref;
@@ -2934,6 +3011,16 @@ relocate_objects(Obj_Entry *first, bool bind_now, Obj_Entry *rtldobj,
 	Obj_Entry *obj;
 	int error;
 
+	/*
+	 * Share symbol resolutions across the objects relocated in this
+	 * pass; see symcache_global_lookup().  rtld's early
+	 * self-relocation runs before malloc is usable, so the cache
+	 * stays off there.
+	 */
+	if (first != rtldobj && symcache_global == NULL)
+		symcache_global = xcalloc(SYMCACHE_GLOBAL_SIZE,
+		    sizeof(*symcache_global));
+
 	for (error = 0, obj = first;  obj != NULL;
 	    obj = TAILQ_NEXT(obj, next)) {
 		if (obj->marker)
@@ -2943,6 +3030,13 @@ relocate_objects(Obj_Entry *first, bool bind_now, Obj_Entry *rtldobj,
 		if (error == -1)
 			break;
 	}
+
+	if (symcache_global != NULL) {
+		dbg("symcache_global: %u entries", symcache_global_used);
+		free(symcache_global);
+		symcache_global = NULL;
+		symcache_global_used = 0;
+	}
 	return (error);
 }
 
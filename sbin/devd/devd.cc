@@ -68,6 +68,7 @@
 __FBSDID("$FreeBSD$");
 
 #include <sys/param.h>
+#include <sys/event.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/sysctl.h>
@@ -91,10 +92,12 @@ __FBSDID("$FreeBSD$");
 #include <poll.h>
 #include <regex.h>
 #include <syslog.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <string>
 #include <list>
 #include <stdexcept>
@@ -105,7 +108,10 @@ __FBSDID("$FreeBSD$");
 
 #define STREAMPIPE "/var/run/devd.pipe"
 #define SEQPACKETPIPE "/var/run/devd.seqpacket.pipe"
+#define TRUSTEDPIPE "/var/run/devd.trusted.pipe"
 #define CF "/etc/devd.conf"
+#define CACHEFILE "/var/db/devd.cache"
+#define STATSFILE "/var/run/devd.stats"
 #define SYSCTL "hw.bus.devctl_queue"
 
 /*
@@ -132,11 +138,39 @@ __FBSDID("$FreeBSD$");
  */
 #define CLIENT_BUFSIZE 262144
 
+/*
+ * Maximum number of events held for a client that has stopped reading.
+ * Beyond this the oldest queued event is dropped (and counted), so one
+ * stuck consumer can neither stall delivery to the others nor consume
+ * unbounded memory.
+ */
+#define CLIENT_QUEUE_MAX 256
+
+/*
+ * Maximum number of action shells run concurrently.  Actions beyond this
+ * wait in FIFO order; the limit keeps an event storm from forking a
+ * process per event while still letting slow actions overlap.
+ */
+#define ACTION_POOL_MAX 4
+
 using namespace std;
 
+/*
+ * Events queued for slow clients share one refcounted buffer no matter
+ * how many clients are backlogged; per-client state is just the list
+ * node and an offset into the front buffer for partially sent stream
+ * messages.
+ */
+typedef std::shared_ptr<const std::string> eventbuf_t;
+
 typedef struct client {
 	int fd;
 	int socktype;
+	int trusted;	/* connected via the root-only socket */
+	std::list<eventbuf_t> outq;	/* events pending transmit */
+	size_t outq_off;	/* bytes of outq front already sent */
+	unsigned queued;	/* total events ever queued */
+	unsigned dropped;	/* events dropped due to a full queue */
 } client_t;
 
 extern FILE *yyin;
@@ -156,10 +190,26 @@ static volatile sig_atomic_t got_siginfo = 0;
 static volatile sig_atomic_t romeo_must_die = 0;
 
 static const char *configfile = CF;
+static int event_kq = -1;
+
+/*
+ * Event pipeline counters, reported on SIGINFO and mirrored to
+ * STATSFILE for monitoring agents.  Userland can't register sysctl
+ * OIDs, so a flat key=value file is the instrumentation surface.
+ * Latency is measured from reading a devctl message to having matched
+ * it and queued its actions.
+ */
+static struct {
+	uintmax_t proc_usec_total;	/* cumulative event handling time */
+	uintmax_t proc_usec_max;	/* worst single event */
+	unsigned actions_spawned;	/* action shells ever forked */
+	unsigned clients_dropped;	/* clients reaped on error */
+} stats;
 
 static void devdlog(int priority, const char* message, ...)
 	__printflike(2, 3);
 static void event_loop(void);
+static void queue_action(const std::string &cmd);
 static void usage(void) __dead2;
 
 template <class T> void
@@ -212,6 +262,20 @@ event_proc::run(config &c) const
 	return (true);
 }
 
+const string *
+event_proc::index_value(const string &var) const
+{
+	vector<eps *>::const_iterator i;
+	const string *val;
+
+	for (i = _epsvec.begin(); i != _epsvec.end(); ++i) {
+		val = (*i)->index_value(var);
+		if (val != NULL)
+			return (val);
+	}
+	return (NULL);
+}
+
 action::action(const char *cmd)
 	: _cmd(cmd)
 {
@@ -277,21 +341,105 @@ my_system(const char *command)
 	return (pid == -1 ? -1 : pstat);
 }
 
+static list<string> action_queue;	/* actions waiting for a pool slot */
+static unsigned action_running;		/* action shells currently forked */
+
+/*
+ * Fork an action shell without waiting for it.  Completion is observed
+ * via an EVFILT_PROC event in the main loop, which reaps the child and
+ * starts the next queued action.
+ */
+static void
+spawn_action(const string &cmd)
+{
+	struct kevent ev;
+	pid_t pid;
+
+	switch (pid = ::fork()) {
+	case -1:			/* error */
+		devdlog(LOG_ERR, "spawn_action: cannot fork\n");
+		break;
+	case 0:				/* child */
+		/*
+		 * Close the PID file, and all other open descriptors.
+		 * Inherit std{in,out,err} only.
+		 */
+		cfg.close_pidfile();
+		::closefrom(3);
+		::execl(_PATH_BSHELL, "sh", "-c", cmd.c_str(), (char *)NULL);
+		::_exit(127);
+	default:			/* parent */
+		EV_SET(&ev, pid, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT,
+		    0, NULL);
+		if (kevent(event_kq, &ev, 1, NULL, 0, NULL) == -1) {
+			/* Can't track it; reap synchronously. */
+			::waitpid(pid, NULL, 0);
+			break;
+		}
+		++action_running;
+		++stats.actions_spawned;
+		break;
+	}
+}
+
+/*
+ * Start queued actions while pool slots are free.  Actions start in the
+ * order events produced them.
+ */
+static void
+run_queued_actions(void)
+{
+	while (action_running < ACTION_POOL_MAX && !action_queue.empty()) {
+		spawn_action(action_queue.front());
+		action_queue.pop_front();
+	}
+}
+
+static void
+queue_action(const string &cmd)
+{
+	/*
+	 * Before the event loop's kqueue exists there is nothing to reap
+	 * children, so run the action the old synchronous way.
+	 */
+	if (event_kq == -1) {
+		my_system(cmd.c_str());
+		return;
+	}
+	action_queue.push_back(cmd);
+	run_queued_actions();
+}
+
 bool
 action::do_action(config &c)
 {
 	string s = c.expand_string(_cmd.c_str());
 	devdlog(LOG_INFO, "Executing '%s'\n", s.c_str());
-	my_system(s.c_str());
+	queue_action(s);
 	return (true);
 }
 
 match::match(config &c, const char *var, const char *re) :
 	_inv(re[0] == '!'),
 	_var(var),
-	_re(c.expand_string(_inv ? re + 1 : re, "^", "$"))
+	_re(c.expand_string(_inv ? re + 1 : re, "^", "$")),
+	_is_literal(false)
 {
 	regcomp(&_regex, _re.c_str(), REG_EXTENDED | REG_NOSUB | REG_ICASE);
+
+	/*
+	 * Most match statements compare against a plain string rather than
+	 * a real pattern.  Detect that case (no regex metacharacters between
+	 * the ^ and $ we added above) so the rule can be indexed by the
+	 * literal value instead of being regexec()ed for every event.
+	 */
+	if (!_inv && _re.length() >= 2 &&
+	    _re.find_first_of("[](){}.*+?|\\^$", 1) == _re.length() - 1) {
+		_literal = _re.substr(1, _re.length() - 2);
+		for (string::size_type i = 0; i < _literal.length(); i++)
+			_literal[i] = tolower(_literal[i]);
+		_is_literal = true;
+	}
 }
 
 match::~match()
@@ -299,6 +447,14 @@ match::~match()
 	regfree(&_regex);
 }
 
+const string *
+match::index_value(const string &var) const
+{
+	if (_is_literal && _var == var)
+		return (&_literal);
+	return (NULL);
+}
+
 bool
 match::do_match(config &c)
 {
@@ -450,16 +606,27 @@ config::reset(void)
 	delete_and_clear(_attach_list);
 	delete_and_clear(_detach_list);
 	delete_and_clear(_nomatch_list);
+	_notify_by_system.clear();
+	_notify_generic.clear();
 	delete_and_clear(_notify_list);
 }
 
 void
 config::parse_one_file(const char *fn)
 {
+	struct stat sb;
+	cache_src src;
+
 	devdlog(LOG_DEBUG, "Parsing %s\n", fn);
 	yyin = fopen(fn, "r");
 	if (yyin == NULL)
 		err(1, "Cannot open config file %s", fn);
+	if (fstat(fileno(yyin), &sb) == 0) {
+		src.path = fn;
+		src.mtime = (intmax_t)sb.st_mtime;
+		src.size = (intmax_t)sb.st_size;
+		_cache_srcs.push_back(src);
+	}
 	lineno = 1;
 	if (yyparse() != 0)
 		errx(1, "Cannot parse %s at line %d", fn, lineno);
@@ -471,12 +638,24 @@ config::parse_files_in_dir(const char *dirname)
 {
 	DIR *dirp;
 	struct dirent *dp;
+	struct stat sb;
+	cache_src src;
 	char path[PATH_MAX];
 
 	devdlog(LOG_DEBUG, "Parsing files in %s\n", dirname);
 	dirp = opendir(dirname);
 	if (dirp == NULL)
 		return;
+	/*
+	 * Remember the directory's mtime so that .conf files added to or
+	 * removed from it invalidate the flattened config cache.
+	 */
+	if (fstat(dirfd(dirp), &sb) == 0) {
+		src.path = dirname;
+		src.mtime = (intmax_t)sb.st_mtime;
+		src.size = -1;
+		_cache_srcs.push_back(src);
+	}
 	readdir(dirp);		/* Skip . */
 	readdir(dirp);		/* Skip .. */
 	while ((dp = readdir(dirp)) != NULL) {
@@ -503,18 +682,169 @@ config::sort_vector(vector<event_proc *> &v)
 	stable_sort(v.begin(), v.end(), epv_greater());
 }
 
+/*
+ * Try to load the flattened config written by write_cache().  The header
+ * lists every file and directory consulted when the cache was written,
+ * with mtimes and sizes; if any of them changed (or the main config file
+ * differs), the cache is stale and a full parse is done instead.
+ * Returns true if the cache was valid and has been parsed.
+ */
+bool
+config::read_cache()
+{
+	FILE *fp;
+	struct stat sb;
+	char line[PATH_MAX + 64];
+	char path[PATH_MAX];
+	intmax_t mtime, size;
+	bool valid;
+
+	fp = fopen(CACHEFILE, "r");
+	if (fp == NULL)
+		return (false);
+	valid = false;
+	if (fgets(line, sizeof(line), fp) != NULL &&
+	    sscanf(line, "#DEVD CACHE 1 %1023s", path) == 1 &&
+	    strcmp(path, configfile) == 0)
+		valid = true;
+	while (valid && fgets(line, sizeof(line), fp) != NULL) {
+		if (strncmp(line, "#end", 4) == 0)
+			break;
+		if (sscanf(line, "#source %jd %jd %1023s", &mtime, &size,
+		    path) == 3) {
+			if (stat(path, &sb) != 0 ||
+			    (intmax_t)sb.st_mtime != mtime ||
+			    (intmax_t)sb.st_size != size)
+				valid = false;
+		} else if (sscanf(line, "#dir %jd %1023s", &mtime, path) == 2) {
+			if (stat(path, &sb) != 0 ||
+			    (intmax_t)sb.st_mtime != mtime)
+				valid = false;
+		} else
+			valid = false;
+	}
+	if (!valid) {
+		fclose(fp);
+		return (false);
+	}
+	/*
+	 * The header lines are comments, so the whole cache file parses as
+	 * ordinary devd.conf input.
+	 */
+	devdlog(LOG_DEBUG, "Parsing config cache %s\n", CACHEFILE);
+	rewind(fp);
+	yyin = fp;
+	lineno = 1;
+	if (yyparse() != 0) {
+		/* A corrupt cache shouldn't wedge devd; fall back. */
+		devdlog(LOG_WARNING, "Cannot parse %s; ignoring cache\n",
+		    CACHEFILE);
+		fclose(fp);
+		reset();
+		push_var_table();
+		return (false);
+	}
+	fclose(fp);
+	return (true);
+}
+
+/*
+ * Flatten everything we just parsed into a single cache file so the next
+ * startup costs one open and one parse instead of a directory walk over
+ * all installed .conf files.  Failure is harmless; we just won't have a
+ * cache next time.
+ */
+void
+config::write_cache() const
+{
+	FILE *out, *in;
+	vector<cache_src>::const_iterator i;
+	char buffer[8192];
+	char tmppath[] = CACHEFILE ".XXXXXX";
+	size_t len;
+	int fd;
+
+	fd = mkstemp(tmppath);
+	if (fd == -1)
+		return;
+	out = fdopen(fd, "w");
+	if (out == NULL) {
+		close(fd);
+		unlink(tmppath);
+		return;
+	}
+	fprintf(out, "#DEVD CACHE 1 %s\n", configfile);
+	for (i = _cache_srcs.begin(); i != _cache_srcs.end(); ++i) {
+		if (i->size == -1)
+			fprintf(out, "#dir %jd %s\n", i->mtime,
+			    i->path.c_str());
+		else
+			fprintf(out, "#source %jd %jd %s\n", i->mtime,
+			    i->size, i->path.c_str());
+	}
+	fprintf(out, "#end\n");
+	for (i = _cache_srcs.begin(); i != _cache_srcs.end(); ++i) {
+		if (i->size == -1)
+			continue;
+		in = fopen(i->path.c_str(), "r");
+		if (in == NULL)
+			continue;
+		while ((len = fread(buffer, 1, sizeof(buffer), in)) > 0)
+			fwrite(buffer, 1, len, out);
+		fclose(in);
+		fprintf(out, "\n");
+	}
+	if (fclose(out) != 0 || chmod(tmppath, 0644) != 0 ||
+	    rename(tmppath, CACHEFILE) != 0)
+		unlink(tmppath);
+}
+
 void
 config::parse(void)
 {
 	vector<string>::const_iterator i;
 
-	parse_one_file(configfile);
-	for (i = _dir_list.begin(); i != _dir_list.end(); ++i)
-		parse_files_in_dir((*i).c_str());
+	if (!read_cache()) {
+		parse_one_file(configfile);
+		for (i = _dir_list.begin(); i != _dir_list.end(); ++i)
+			parse_files_in_dir((*i).c_str());
+		write_cache();
+	}
 	sort_vector(_attach_list);
 	sort_vector(_detach_list);
 	sort_vector(_nomatch_list);
 	sort_vector(_notify_list);
+	build_notify_index();
+}
+
+/*
+ * Bucket the notify rules by the literal $system value they match, where
+ * one exists.  Notify events are by far the most common and the rule list
+ * scales with installed ports, so this turns the common case of
+ * find_and_execute() from a regexec() against every rule into a lookup of
+ * the (usually small) bucket for the event's system plus the handful of
+ * rules that use real patterns.
+ */
+void
+config::build_notify_index()
+{
+	vector<event_proc *>::const_iterator i;
+	const string *val;
+	unsigned seq;
+
+	_notify_by_system.clear();
+	_notify_generic.clear();
+	seq = 0;
+	for (i = _notify_list.begin(); i != _notify_list.end(); ++i, ++seq) {
+		val = (*i)->index_value("system");
+		if (val != NULL)
+			_notify_by_system.insert(make_pair(*val,
+			    make_pair(seq, *i)));
+		else
+			_notify_generic.push_back(make_pair(seq, *i));
+	}
+	devdlog(LOG_DEBUG, "Indexed %zu notify rules, %zu unindexed\n",
+	    _notify_by_system.size(), _notify_generic.size());
 }
 
 void
@@ -796,6 +1126,45 @@ config::set_vars(char *buffer)
 	return (buffer);
 }
 
+/*
+ * Run the highest priority notify rule that matches the current event,
+ * using the $system index built by build_notify_index().  Only the bucket
+ * for the event's system value and the rules that couldn't be indexed are
+ * tested; the two sequences are merged by their position in the sorted
+ * rule list so that priority order is identical to a full scan.
+ */
+bool
+config::find_and_execute_notify()
+{
+	multimap<string, pair<unsigned, event_proc *> >::const_iterator b, be;
+	vector<pair<unsigned, event_proc *> >::const_iterator g;
+	const string &sysval = get_variable("system");
+	event_proc *ep;
+	string key;
+
+	key.reserve(sysval.length());
+	for (string::size_type i = 0; i < sysval.length(); i++)
+		key += tolower(sysval[i]);
+	b = _notify_by_system.lower_bound(key);
+	be = _notify_by_system.upper_bound(key);
+	g = _notify_generic.begin();
+	while (b != be || g != _notify_generic.end()) {
+		if (g == _notify_generic.end() ||
+		    (b != be && b->second.first < g->first)) {
+			ep = b->second.second;
+			++b;
+		} else {
+			ep = g->second;
+			++g;
+		}
+		if (ep->matches(*this)) {
+			ep->run(*this);
+			return (true);
+		}
+	}
+	return (false);
+}
+
 void
 config::find_and_execute(char type)
 {
@@ -807,9 +1176,9 @@ config::find_and_execute(char type)
 	default:
 		return;
 	case notify:
-		l = &_notify_list;
-		s = "notify";
-		break;
+		devdlog(LOG_DEBUG, "Processing notify event\n");
+		find_and_execute_notify();
+		return;
 	case nomatch:
 		l = &_nomatch_list;
 		s = "nomatch";
@@ -905,7 +1274,7 @@ process_event(char *buffer)
 }
 
 static int
-create_socket(const char *name, int socktype)
+create_socket(const char *name, int socktype, mode_t mode)
 {
 	int fd, slen;
 	struct sockaddr_un sun;
@@ -924,7 +1293,7 @@ create_socket(const char *name, int socktype)
 	listen(fd, 4);
 	if (chown(name, 0, 0))	/* XXX - root.wheel */
 		err(1, "chown");
-	if (chmod(name, 0666))
+	if (chmod(name, mode))
 		err(1, "chmod");
 	return (fd);
 }
@@ -934,33 +1303,137 @@ static unsigned int num_clients;
 
 static list<client_t> clients;
 
+/*
+ * Start or stop watching a client socket for writability.  Quietly does
+ * nothing before the event loop has created its kqueue.
+ */
+static void
+watch_client_write(int fd, bool enable)
+{
+	struct kevent ev;
+
+	if (event_kq == -1)
+		return;
+	EV_SET(&ev, fd, EVFILT_WRITE, enable ? EV_ADD : EV_DELETE, 0, 0, NULL);
+	kevent(event_kq, &ev, 1, NULL, 0, NULL);
+}
+
+/*
+ * Append an event to a client's output queue, dropping the oldest
+ * droppable queued event when the bound is hit so the client converges
+ * on the current device state once it resumes reading.  The front entry
+ * is never dropped: it may be partially transmitted, and truncating it
+ * would corrupt the stream framing.
+ */
+static void
+queue_event(client_t &cl, const eventbuf_t &buf, size_t off)
+{
+	if (cl.outq.size() >= CLIENT_QUEUE_MAX) {
+		cl.outq.erase(++cl.outq.begin());
+		++cl.dropped;
+	}
+	if (cl.outq.empty()) {
+		watch_client_write(cl.fd, true);
+		cl.outq_off = off;
+	}
+	cl.outq.push_back(buf);
+	++cl.queued;
+}
+
+/*
+ * Push a client's queued events out.  Returns false on a hard error; the
+ * caller is responsible for dropping the client.  A short write (stream
+ * sockets only) or EAGAIN leaves the remainder queued for the next
+ * writability event.
+ */
+static bool
+flush_client(client_t &cl)
+{
+	ssize_t rv;
+	size_t resid;
+	int flags;
+
+	flags = (cl.socktype == SOCK_SEQPACKET) ? MSG_EOR : 0;
+	while (!cl.outq.empty()) {
+		const string &msg = *cl.outq.front();
+
+		resid = msg.length() - cl.outq_off;
+		rv = send(cl.fd, msg.data() + cl.outq_off, resid, flags);
+		if (rv == (ssize_t)resid) {
+			cl.outq.pop_front();
+			cl.outq_off = 0;
+			continue;
+		}
+		if (rv >= 0) {
+			/* Partial write; can't happen for seqpacket. */
+			if (cl.socktype == SOCK_SEQPACKET)
+				return (false);
+			cl.outq_off += rv;
+			return (true);
+		}
+		if (errno == EAGAIN || errno == ENOBUFS)
+			return (true);
+		return (false);
+	}
+	watch_client_write(cl.fd, false);
+	return (true);
+}
+
 static void
 notify_clients(const char *data, int len)
 {
 	list<client_t>::iterator i;
+	eventbuf_t buf;
 
 	/*
-	 * Deliver the data to all clients.  Throw clients overboard at the
-	 * first sign of trouble.  This reaps clients who've died or closed
-	 * their sockets, and also clients who are alive but failing to keep up
-	 * (or who are maliciously not reading, to consume buffer space in
-	 * kernel memory or tie up the limited number of available connections).
+	 * Deliver the data to all clients.  A client that can't take the
+	 * event right now gets it queued and flushed from the event loop
+	 * when its socket drains, so a slow consumer adds no latency for
+	 * the others.  The buffer is allocated once, lazily, and shared
+	 * by every backlogged client.  Clients are only thrown overboard
+	 * on a hard error, which reaps clients who've died or closed
+	 * their sockets.
 	 */
 	for (i = clients.begin(); i != clients.end(); ) {
-		int flags;
-		if (i->socktype == SOCK_SEQPACKET)
-			flags = MSG_EOR;
-		else
-			flags = 0;
+		ssize_t rv;
 
-		if (send(i->fd, data, len, flags) != len) {
-			--num_clients;
-			close(i->fd);
-			i = clients.erase(i);
-			devdlog(LOG_WARNING, "notify_clients: send() failed; "
-			    "dropping unresponsive client\n");
-		} else
+		if (!i->outq.empty()) {
+			/* Already backlogged; preserve ordering. */
+			if (buf == NULL)
+				buf = make_shared<const string>(data, len);
+			queue_event(*i, buf, 0);
+			++i;
+			continue;
+		}
+		rv = send(i->fd, data, len,
+		    i->socktype == SOCK_SEQPACKET ? MSG_EOR : 0);
+		if (rv == len) {
+			++i;
+			continue;
+		}
+		if (rv >= 0 && i->socktype == SOCK_STREAM) {
+			/* Short write; queue with the sent part skipped. */
+			if (buf == NULL)
+				buf = make_shared<const string>(data, len);
+			queue_event(*i, buf, rv);
+			++i;
+			continue;
+		}
+		if (rv < 0 && (errno == EAGAIN || errno == ENOBUFS)) {
+			if (buf == NULL)
+				buf = make_shared<const string>(data, len);
+			queue_event(*i, buf, 0);
 			++i;
+			continue;
+		}
+		if (!i->trusted)
+			--num_clients;
+		watch_client_write(i->fd, false);
+		close(i->fd);
+		i = clients.erase(i);
+		++stats.clients_dropped;
+		devdlog(LOG_WARNING, "notify_clients: send() failed; "
+		    "dropping unresponsive client\n");
 	}
 }
 
@@ -984,9 +1457,11 @@ check_clients(void)
 		s = poll(&pfd, 1, 0);
 		if ((s < 0 && s != EINTR ) ||
 		    (s > 0 && (pfd.revents & POLLHUP))) {
-			--num_clients;
+			if (!i->trusted)
+				--num_clients;
 			close(i->fd);
 			i = clients.erase(i);
+			++stats.clients_dropped;
 			devdlog(LOG_NOTICE, "check_clients:  "
 			    "dropping disconnected client\n");
 		} else
@@ -995,7 +1470,7 @@ check_clients(void)
 }
 
 static void
-new_client(int fd, int socktype)
+new_client(int fd, int socktype, bool trusted)
 {
 	client_t s;
 	int sndbuf_size;
@@ -1004,9 +1479,17 @@ new_client(int fd, int socktype)
 	 * First go reap any zombie clients, then accept the connection, and
 	 * shut down the read side to stop clients from consuming kernel memory
 	 * by sending large buffers full of data we'll never read.
+	 *
+	 * Trusted clients (root-only socket) go to the front of the client
+	 * list so they receive each event first, and they don't count
+	 * against the connection limit.
 	 */
 	check_clients();
 	s.socktype = socktype;
+	s.trusted = trusted;
+	s.outq_off = 0;
+	s.queued = 0;
+	s.dropped = 0;
 	s.fd = accept(fd, NULL, NULL);
 	if (s.fd != -1) {
 		sndbuf_size = CLIENT_BUFSIZE;
@@ -1014,34 +1497,147 @@ new_client(int fd, int socktype)
 		    sizeof(sndbuf_size)))
 			err(1, "setsockopt");
 		shutdown(s.fd, SHUT_RD);
-		clients.push_back(s);
-		++num_clients;
+		if (trusted) {
+			clients.push_front(s);
+		} else {
+			clients.push_back(s);
+			++num_clients;
+		}
 	} else
 		err(1, "accept");
 }
 
+/*
+ * Drain every message pending in the devctl device.  The device is
+ * opened non-blocking, so a burst of events costs a single wakeup and
+ * one read(2) per message rather than a full poll/read round trip each.
+ * Returns false on EOF or an unexpected error, which terminates the
+ * event loop.
+ */
+static bool
+drain_devctl(int fd)
+{
+	char buffer[DEVCTL_MAXBUF];
+	struct timespec t0, t1;
+	uintmax_t usec;
+	int rv;
+
+	while (!romeo_must_die) {
+		rv = read(fd, buffer, sizeof(buffer) - 1);
+		if (rv > 0) {
+			clock_gettime(CLOCK_MONOTONIC, &t0);
+			total_events++;
+			if (rv == sizeof(buffer) - 1) {
+				devdlog(LOG_WARNING, "Warning: "
+				    "available event data exceeded "
+				    "buffer space\n");
+			}
+			notify_clients(buffer, rv);
+			buffer[rv] = '\0';
+			while (buffer[--rv] == '\n')
+				buffer[rv] = '\0';
+			try {
+				process_event(buffer);
+			}
+			catch (const std::length_error& e) {
+				devdlog(LOG_ERR, "Dropping event %s "
+				    "due to low memory", buffer);
+			}
+			clock_gettime(CLOCK_MONOTONIC, &t1);
+			usec = (t1.tv_sec - t0.tv_sec) * 1000000 +
+			    (t1.tv_nsec - t0.tv_nsec) / 1000;
+			stats.proc_usec_total += usec;
+			if (usec > stats.proc_usec_max)
+				stats.proc_usec_max = usec;
+		} else if (rv < 0) {
+			if (errno == EAGAIN)
+				return (true);
+			if (errno != EINTR)
+				return (false);
+		} else {
+			/* EOF */
+			return (false);
+		}
+	}
+	return (true);
+}
+
+/*
+ * Dump the pipeline counters where a monitoring agent can scrape them.
+ * Written to a temporary file and renamed so readers never see a
+ * partial update.
+ */
+static void
+write_stats(void)
+{
+	FILE *fp;
+	char tmppath[] = STATSFILE ".XXXXXX";
+	int fd;
+
+	fd = mkstemp(tmppath);
+	if (fd == -1)
+		return;
+	fp = fdopen(fd, "w");
+	if (fp == NULL) {
+		close(fd);
+		unlink(tmppath);
+		return;
+	}
+	fprintf(fp, "events=%u\n", total_events);
+	fprintf(fp, "proc_usec_total=%ju\n", stats.proc_usec_total);
+	fprintf(fp, "proc_usec_max=%ju\n", stats.proc_usec_max);
+	fprintf(fp, "proc_usec_avg=%ju\n", total_events == 0 ? 0 :
+	    stats.proc_usec_total / total_events);
+	fprintf(fp, "actions_spawned=%u\n", stats.actions_spawned);
+	fprintf(fp, "actions_running=%u\n", action_running);
+	fprintf(fp, "actions_waiting=%zu\n", action_queue.size());
+	fprintf(fp, "clients=%u\n", num_clients);
+	fprintf(fp, "clients_dropped=%u\n", stats.clients_dropped);
+	for (list<client_t>::const_iterator i = clients.begin();
+	    i != clients.end(); ++i)
+		fprintf(fp, "client.%d=pending:%zu,queued:%u,dropped:%u\n",
+		    i->fd, i->outq.size(), i->queued, i->dropped);
+	if (fclose(fp) != 0 || chmod(tmppath, 0644) != 0 ||
+	    rename(tmppath, STATSFILE) != 0)
+		unlink(tmppath);
+}
+
 static void
 event_loop(void)
 {
-	int rv;
+	int rv, n;
 	int fd;
-	char buffer[DEVCTL_MAXBUF];
 	int once = 0;
-	int stream_fd, seqpacket_fd, max_fd;
+	int kq, stream_fd, seqpacket_fd, trusted_fd;
 	int accepting;
 	timeval tv;
+	timespec ts;
 	fd_set fds;
+	struct kevent ev[8];
+	list<client_t>::iterator ci;
 
-	fd = open(PATH_DEVCTL, O_RDONLY | O_CLOEXEC);
+	fd = open(PATH_DEVCTL, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
 	if (fd == -1)
 		err(1, "Can't open devctl device %s", PATH_DEVCTL);
-	stream_fd = create_socket(STREAMPIPE, SOCK_STREAM);
-	seqpacket_fd = create_socket(SEQPACKETPIPE, SOCK_SEQPACKET);
+	stream_fd = create_socket(STREAMPIPE, SOCK_STREAM, 0666);
+	seqpacket_fd = create_socket(SEQPACKETPIPE, SOCK_SEQPACKET, 0666);
+	trusted_fd = create_socket(TRUSTEDPIPE, SOCK_SEQPACKET, 0600);
+	kq = kqueue();
+	if (kq == -1)
+		err(1, "kqueue");
+	event_kq = kq;
+	EV_SET(&ev[0], fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+	EV_SET(&ev[1], stream_fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+	EV_SET(&ev[2], seqpacket_fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+	EV_SET(&ev[3], trusted_fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+	if (kevent(kq, ev, 4, NULL, 0, NULL) == -1)
+		err(1, "kevent");
 	accepting = 1;
-	max_fd = max(fd, max(stream_fd, seqpacket_fd)) + 1;
 	while (!romeo_must_die) {
 		if (!once && !no_daemon && !daemonize_quick) {
-			// Check to see if we have any events pending.
+			// Check to see if we have any events pending.  Use
+			// select(2) rather than kevent(2) here so that a
+			// pending event isn't consumed by the check.
 			tv.tv_sec = 0;
 			tv.tv_usec = 0;
 			FD_ZERO(&fds);
@@ -1059,83 +1655,118 @@ event_loop(void)
 		}
 		/*
 		 * When we've already got the max number of clients, stop
-		 * accepting new connections (don't put the listening sockets in
-		 * the set), shrink the accept() queue to reject connections
+		 * accepting new connections (disable the listening sockets'
+		 * events), shrink the accept() queue to reject connections
 		 * quickly, and poll the existing clients more often, so that we
 		 * notice more quickly when any of them disappear to free up
 		 * client slots.
 		 */
-		FD_ZERO(&fds);
-		FD_SET(fd, &fds);
 		if (num_clients < max_clients) {
 			if (!accepting) {
 				listen(stream_fd, max_clients);
 				listen(seqpacket_fd, max_clients);
+				EV_SET(&ev[0], stream_fd, EVFILT_READ,
+				    EV_ENABLE, 0, 0, NULL);
+				EV_SET(&ev[1], seqpacket_fd, EVFILT_READ,
+				    EV_ENABLE, 0, 0, NULL);
+				if (kevent(kq, ev, 2, NULL, 0, NULL) == -1)
+					err(1, "kevent");
 				accepting = 1;
 			}
-			FD_SET(stream_fd, &fds);
-			FD_SET(seqpacket_fd, &fds);
-			tv.tv_sec = 60;
-			tv.tv_usec = 0;
+			ts.tv_sec = 60;
+			ts.tv_nsec = 0;
 		} else {
 			if (accepting) {
 				listen(stream_fd, 0);
 				listen(seqpacket_fd, 0);
+				EV_SET(&ev[0], stream_fd, EVFILT_READ,
+				    EV_DISABLE, 0, 0, NULL);
+				EV_SET(&ev[1], seqpacket_fd, EVFILT_READ,
+				    EV_DISABLE, 0, 0, NULL);
+				if (kevent(kq, ev, 2, NULL, 0, NULL) == -1)
+					err(1, "kevent");
 				accepting = 0;
 			}
-			tv.tv_sec = 2;
-			tv.tv_usec = 0;
+			ts.tv_sec = 2;
+			ts.tv_nsec = 0;
 		}
-		rv = select(max_fd, &fds, NULL, NULL, &tv);
+		rv = kevent(kq, NULL, 0, ev, nitems(ev), &ts);
 		if (got_siginfo) {
 			devdlog(LOG_NOTICE, "Events received so far=%u\n",
 			    total_events);
+			for (ci = clients.begin(); ci != clients.end(); ++ci)
+				devdlog(LOG_NOTICE, "client fd=%d pending=%zu "
+				    "queued=%u dropped=%u\n", ci->fd,
+				    ci->outq.size(), ci->queued, ci->dropped);
+			devdlog(LOG_NOTICE, "actions running=%u waiting=%zu\n",
+			    action_running, action_queue.size());
+			devdlog(LOG_NOTICE, "event latency usec "
+			    "avg=%ju max=%ju\n", total_events == 0 ? 0 :
+			    stats.proc_usec_total / total_events,
+			    stats.proc_usec_max);
+			write_stats();
 			got_siginfo = 0;
 		}
 		if (rv == -1) {
 			if (errno == EINTR)
 				continue;
-			err(1, "select");
+			err(1, "kevent");
 		} else if (rv == 0)
 			check_clients();
-		if (FD_ISSET(fd, &fds)) {
-			rv = read(fd, buffer, sizeof(buffer) - 1);
-			if (rv > 0) {
-				total_events++;
-				if (rv == sizeof(buffer) - 1) {
-					devdlog(LOG_WARNING, "Warning: "
-					    "available event data exceeded "
-					    "buffer space\n");
-				}
-				notify_clients(buffer, rv);
-				buffer[rv] = '\0';
-				while (buffer[--rv] == '\n')
-					buffer[rv] = '\0';
-				try {
-					process_event(buffer);
-				}
-				catch (const std::length_error& e) {
-					devdlog(LOG_ERR, "Dropping event %s "
-					    "due to low memory", buffer);
-				}
-			} else if (rv < 0) {
-				if (errno != EINTR)
+		for (n = 0; n < rv; ++n) {
+			if (ev[n].filter == EVFILT_PROC) {
+				/* An action shell finished. */
+				waitpid((pid_t)ev[n].ident, NULL, WNOHANG);
+				if (action_running > 0)
+					--action_running;
+				run_queued_actions();
+			} else if (ev[n].filter == EVFILT_WRITE) {
+				/* A backlogged client's socket drained. */
+				for (ci = clients.begin(); ci != clients.end();
+				    ++ci) {
+					if ((int)ev[n].ident != ci->fd)
+						continue;
+					if (!flush_client(*ci)) {
+						if (!ci->trusted)
+							--num_clients;
+						close(ci->fd);
+						clients.erase(ci);
+						++stats.clients_dropped;
+						devdlog(LOG_WARNING,
+						    "flush_client: send() "
+						    "failed; dropping "
+						    "unresponsive client\n");
+					}
 					break;
-			} else {
-				/* EOF */
-				break;
-			}
+				}
+			} else if ((int)ev[n].ident == fd) {
+				if (!drain_devctl(fd))
+					romeo_must_die = 1;
+			} else if ((int)ev[n].ident == stream_fd)
+				new_client(stream_fd, SOCK_STREAM, false);
+			/*
+			 * Aside from the socket type, all sockets use the same
+			 * protocol, so we can process clients the same way.
+			 */
+			else if ((int)ev[n].ident == seqpacket_fd)
+				new_client(seqpacket_fd, SOCK_SEQPACKET,
+				    false);
+			else if ((int)ev[n].ident == trusted_fd)
+				new_client(trusted_fd, SOCK_SEQPACKET, true);
 		}
-		if (FD_ISSET(stream_fd, &fds))
-			new_client(stream_fd, SOCK_STREAM);
-		/*
-		 * Aside from the socket type, both sockets use the same
-		 * protocol, so we can process clients the same way.
-		 */
-		if (FD_ISSET(seqpacket_fd, &fds))
-			new_client(seqpacket_fd, SOCK_SEQPACKET);
+	}
+	/*
+	 * Run whatever actions are still waiting the old synchronous way;
+	 * the kqueue is about to go away with nothing left to reap them.
+	 */
+	event_kq = -1;
+	while (!action_queue.empty()) {
+		my_system(action_queue.front().c_str());
+		action_queue.pop_front();
 	}
 	cfg.remove_pidfile();
+	close(kq);
+	close(trusted_fd);
 	close(seqpacket_fd);
 	close(stream_fd);
 	close(fd);
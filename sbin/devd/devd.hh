@@ -78,6 +78,16 @@ public:
 	/** Perform some action for this eps.
 	 */
 	virtual bool do_action(config &) = 0;
+	/** If this eps constrains variable %var to exactly one literal
+	 * value, return that value (lower cased, since matching ignores
+	 * case).  Otherwise return NULL.  Used to index rules by the
+	 * variables they can possibly match so that events don't have to
+	 * be tested against every rule.
+	 */
+	virtual const std::string *index_value(const std::string &) const
+	{
+		return (NULL);
+	}
 };
 
 /**
@@ -91,10 +101,13 @@ public:
 	virtual ~match();
 	virtual bool do_match(config &);
 	virtual bool do_action(config &) { return true; }
+	virtual const std::string *index_value(const std::string &var) const;
 private:
 	bool _inv;
 	std::string _var;
 	std::string _re;
+	std::string _literal;
+	bool _is_literal;
 	regex_t _regex;
 };
 
@@ -128,6 +141,17 @@ private:
 	std::string _cmd;
 };
 
+/**
+ * A config source consulted during parsing, remembered so the flattened
+ * config cache can be validated against it on the next startup.
+ */
+struct cache_src
+{
+	std::string path;
+	intmax_t mtime;
+	intmax_t size;		/* -1 for directories */
+};
+
 struct event_proc
 {
 public:
@@ -138,6 +162,7 @@ public:
 	void add(eps *);
 	bool matches(config &) const;
 	bool run(config &) const;
+	const std::string *index_value(const std::string &var) const;
 private:
 	int _prio;
 	std::vector<eps *> _epsvec;
@@ -170,6 +195,10 @@ public:
 	void find_and_execute(char);
 protected:
 	void sort_vector(std::vector<event_proc *> &);
+	void build_notify_index();
+	bool find_and_execute_notify();
+	bool read_cache();
+	void write_cache() const;
 	void parse_one_file(const char *fn);
 	void parse_files_in_dir(const char *dirname);
 	void expand_one(const char *&src, std::string &dst, bool is_shell);
@@ -178,12 +207,23 @@ protected:
 	bool chop_var(char *&buffer, char *&lhs, char *&rhs) const;
 private:
 	std::vector<std::string> _dir_list;
+	std::vector<cache_src> _cache_srcs;
 	std::string _pidfile;
 	std::vector<var_list *> _var_list_table;
 	std::vector<event_proc *> _attach_list;
 	std::vector<event_proc *> _detach_list;
 	std::vector<event_proc *> _nomatch_list;
 	std::vector<event_proc *> _notify_list;
+	/**
+	 * Index over _notify_list: rules that can only fire for a single
+	 * literal value of $system are bucketed by that value; everything
+	 * else goes into the generic list.  Each entry carries the rule's
+	 * position in the sorted _notify_list so that both sequences can
+	 * be merged back into priority order at lookup time.
+	 */
+	std::multimap<std::string, std::pair<unsigned, event_proc *> >
+	    _notify_by_system;
+	std::vector<std::pair<unsigned, event_proc *> > _notify_generic;
 };
 
 #endif /* DEVD_HH */
@@ -1186,6 +1186,29 @@ unsetifdescr(const char *val, int value, int s, const struct afswtch *afp)
 "\17TOE4\20TOE6\21VLAN_HWFILTER\23VLAN_HWTSO\24LINKSTATE\25NETMAP" \
 "\26RXCSUM_IPV6\27TXCSUM_IPV6\31TXRTLMT\32HWRXTSTMP"
 
+/*
+ * Return a datagram socket for status queries, reusing the previous
+ * one when the address family matches.  With thousands of interfaces
+ * to display, a socket/close pair per interface is measurable syscall
+ * overhead; the cached descriptor is left for exit(2) to reclaim.
+ */
+static int
+status_socket(sa_family_t family)
+{
+	static sa_family_t sfamily;
+	static int s = -1;
+
+	if (s != -1 && sfamily != family) {
+		close(s);
+		s = -1;
+	}
+	if (s == -1) {
+		s = socket(family, SOCK_DGRAM, 0);
+		sfamily = family;
+	}
+	return (s);
+}
+
 /*
  * Print the status of the interface.  If an address family was
  * specified, show only it; otherwise, show them all.
@@ -1208,16 +1231,28 @@ status(const struct afswtch *afp, const struct sockaddr_dl *sdl,
 	}
 	strlcpy(ifr.ifr_name, name, sizeof(ifr.ifr_name));
 
-	s = socket(ifr.ifr_addr.sa_family, SOCK_DGRAM, 0);
+	s = status_socket(ifr.ifr_addr.sa_family);
 	if (s < 0)
 		err(1, "socket(family %u,SOCK_DGRAM)", ifr.ifr_addr.sa_family);
 
 	printf("%s: ", name);
 	printb("flags", ifa->ifa_flags, IFFBITS);
-	if (ioctl(s, SIOCGIFMETRIC, &ifr) != -1)
-		printf(" metric %d", ifr.ifr_metric);
-	if (ioctl(s, SIOCGIFMTU, &ifr) != -1)
-		printf(" mtu %d", ifr.ifr_mtu);
+	if (ifa->ifa_addr->sa_family == AF_LINK && ifa->ifa_data != NULL) {
+		/*
+		 * The getifaddrs(3) snapshot already carries the
+		 * metric and MTU; don't make another pair of ioctl
+		 * round trips per interface just to re-fetch them.
+		 */
+		const struct if_data *ifd = ifa->ifa_data;
+
+		printf(" metric %u", ifd->ifi_metric);
+		printf(" mtu %u", ifd->ifi_mtu);
+	} else {
+		if (ioctl(s, SIOCGIFMETRIC, &ifr) != -1)
+			printf(" metric %d", ifr.ifr_metric);
+		if (ioctl(s, SIOCGIFMTU, &ifr) != -1)
+			printf(" mtu %d", ifr.ifr_mtu);
+	}
 	putchar('\n');
 
 	for (;;) {
@@ -1295,7 +1330,6 @@ status(const struct afswtch *afp, const struct sockaddr_dl *sdl,
 	if (verbose > 0)
 		sfp_status(s, &ifr, verbose);
 
-	close(s);
 	return;
 }
 
@@ -87,10 +87,41 @@ static u_int bcache_rablks;
 #define	BCACHE_READAHEAD	256
 #define	BCACHE_MINREADAHEAD	32
 
+static u_int bcache_ra_max = BCACHE_READAHEAD; /* upper bound for bc->ra */
+
 static void	bcache_invalidate(struct bcache *bc, daddr_t blkno);
 static void	bcache_insert(struct bcache *bc, daddr_t blkno);
 static void	bcache_free_instance(struct bcache *bc);
 
+#ifndef BOOT2
+/*
+ * Change the read-ahead limit.
+ *
+ * The user can set the bcache_rasize variable to bound how many 512B blocks
+ * a cache miss will read beyond the end of the request.  Sluggish firmware
+ * disk interfaces benefit from a larger value, while tiny media may want it
+ * clamped down.  The per-request read-ahead is still adapted dynamically and
+ * limited by the free space in the cache; this only sets the ceiling.
+ */
+static int
+bcache_set_ra(struct env_var *ev, int flags, const void *value)
+{
+    u_long ra;
+    char *eptr;
+
+    ra = strtoul(value, &eptr, 0);
+    if (*(const char *)value == 0 || *eptr != 0) {
+	printf("invalid bcache_rasize '%s'\n", (const char *)value);
+	return (CMD_ERROR);
+    }
+    if (ra < BCACHE_MINREADAHEAD)
+	ra = BCACHE_MINREADAHEAD;
+    bcache_ra_max = ra;
+    env_setenv(ev->ev_name, flags | EV_NOHOOK, value, NULL, NULL);
+    return (CMD_OK);
+}
+#endif
+
 /*
  * Initialise the cache for (nblks) of (bsize).
  */
@@ -100,6 +131,10 @@ bcache_init(size_t nblks, size_t bsize)
     /* set up control data */
     bcache_total_nblks = nblks;
     bcache_blksize = bsize;
+#ifndef BOOT2
+    env_setenv("bcache_rasize", EV_VOLATILE, "256", bcache_set_ra,
+	env_nounset);
+#endif
 }
 
 /*
@@ -162,7 +197,7 @@ bcache_allocate(void)
 	bc->bcache_ctl[i].bc_blkno = -1;
     }
     bcache_units++;
-    bc->ra = BCACHE_READAHEAD;	/* optimistic read ahead */
+    bc->ra = bcache_ra_max;	/* optimistic read ahead */
     return (bc);
 }
 
@@ -245,7 +280,7 @@ read_strategy(void *devdata, int rw, daddr_t blk, size_t size,
     }
 
    if (complete) {	/* whole set was in cache, return it */
-	if (bc->ra < BCACHE_READAHEAD)
+	if (bc->ra < bcache_ra_max)
 		bc->ra <<= 1;	/* increase read ahead */
 	bcopy(bc->bcache_data + (bcache_blksize * BHASH(bc, blk)), buf, size);
 	goto done;
@@ -479,6 +514,7 @@ command_bcache(int argc, char *argv[])
     printf("\ncache blocks: %u\n", bcache_total_nblks);
     printf("cache blocksz: %u\n", bcache_blksize);
     printf("cache readahead: %u\n", bcache_rablks);
+    printf("cache readahead limit: %u\n", bcache_ra_max);
     printf("unit cache blocks: %u\n", bcache_unit_nblks);
     printf("cached units: %u\n", bcache_units);
     printf("%u ops %d bypasses %u hits %u misses\n", bcache_ops,
@@ -51,7 +51,12 @@ static inline u_int min(u_int a, u_int b) { return(a < b ? a : b); }
 #include <string.h>
 #include <bzlib.h>
 
-#define BZ_BUFSIZE 2048	/* XXX larger? */
+/*
+ * Each refill of the input buffer costs a full trip through the file
+ * layer, so make it large enough that the underlying disk reads stay
+ * sequential and bcache's read-ahead can run ahead of the decompressor.
+ */
+#define BZ_BUFSIZE 16384
 
 struct bz_file
 {
@@ -33,7 +33,12 @@ __FBSDID("$FreeBSD$");
 #include <string.h>
 #include <zlib.h>
 
-#define Z_BUFSIZE 2048	/* XXX larger? */
+/*
+ * Each refill of the input buffer costs a full trip through the file
+ * layer, so make it large enough that the underlying disk reads stay
+ * sequential and bcache's read-ahead can run ahead of the inflate loop.
+ */
+#define Z_BUFSIZE 16384
 
 struct z_file
 {
@@ -70,6 +70,7 @@ static int tftp_parse_oack(struct tftp_handle *, char *, size_t);
 static int tftp_read(struct open_file *, void *, size_t, size_t *);
 static off_t tftp_seek(struct open_file *, off_t, int);
 static int tftp_set_blksize(struct tftp_handle *, const char *);
+static int tftp_set_windowsize(struct tftp_handle *, const char *);
 static int tftp_stat(struct open_file *, struct stat *);
 
 struct fs_ops tftp_fsops = {
@@ -101,6 +102,14 @@ static int	is_open = 0;
  */
 #define	TFTP_MAX_BLKSIZE 9008
 
+/*
+ * RFC7440 windowsize: number of blocks the server may send per ACK.
+ * The default is deliberately modest; loaders run with small receive
+ * rings and dropped blocks cost a whole window retransmit.
+ */
+#define	TFTP_REQUESTED_WINDOWSIZE 4
+#define	TFTP_MAX_WINDOWSIZE 32
+
 struct tftp_handle {
 	struct iodesc  *iodesc;
 	int		currblock;	/* contents of lastdata */
@@ -109,9 +118,16 @@ struct tftp_handle {
 	int		off;
 	char		*path;	/* saved for re-requests */
 	unsigned int	tftp_blksize;
+	unsigned int	tftp_windowsize;
 	unsigned long	tftp_tsize;
 	void		*pkt;
 	struct tftphdr	*tftp_hdr;
+	/* Blocks received ahead of currblock (RFC7440 windowsize). */
+	void		*w_pkt[TFTP_MAX_WINDOWSIZE];
+	struct tftphdr	*w_hdr[TFTP_MAX_WINDOWSIZE];
+	int		w_size[TFTP_MAX_WINDOWSIZE];
+	int		w_used;
+	int		w_next;
 };
 
 struct tftprecv_extra {
@@ -178,6 +194,17 @@ tftp_sendack(struct tftp_handle *h, u_short block)
 	sendudp(h->iodesc, &wbuf.t, wtail - (char *)&wbuf.t);
 }
 
+/* Discard any blocks that were received ahead of currblock. */
+static void
+tftp_w_flush(struct tftp_handle *h)
+{
+	int i;
+
+	for (i = h->w_next; i < h->w_used; i++)
+		free(h->w_pkt[i]);
+	h->w_next = h->w_used = 0;
+}
+
 static ssize_t
 recvtftp(struct iodesc *d, void **pkt, void **payload, time_t tleft,
     void *recv_extra)
@@ -207,8 +234,13 @@ recvtftp(struct iodesc *d, void **pkt, void **payload, time_t tleft,
 		if (htons(t->th_block) < (u_short)d->xid) {
 			/*
 			 * Apparently our ACK was missed, re-send.
+			 * With a window in flight this is merely an
+			 * out-of-order block; ACKing it here would make
+			 * the server skip ahead, so drop it and let the
+			 * ACK closing the current window resynchronize.
 			 */
-			tftp_sendack(h, htons(t->th_block));
+			if (h->tftp_windowsize <= 1)
+				tftp_sendack(h, htons(t->th_block));
 			free(ptr);
 			return (-1);
 		}
@@ -292,7 +324,7 @@ tftp_makereq(struct tftp_handle *h)
 	struct {
 		u_char header[HEADER_SIZE];
 		struct tftphdr  t;
-		u_char space[FNAME_SIZE + 6];
+		u_char space[FNAME_SIZE + 48];	/* option strings below */
 	} __packed __aligned(4) wbuf;
 	struct tftprecv_extra recv_extra;
 	char *wtail;
@@ -301,7 +333,8 @@ tftp_makereq(struct tftp_handle *h)
 	void *pkt;
 	struct tftphdr *t;
 	char *tftp_blksize = NULL;
-	int blksize_l;
+	char *tftp_windowsize = NULL;
+	int blksize_l, windowsize_l;
 
 	/*
 	 * Allow overriding default TFTP block size by setting
@@ -311,6 +344,11 @@ tftp_makereq(struct tftp_handle *h)
 		tftp_set_blksize(h, tftp_blksize);
 	}
 
+	/* Ditto for the number of blocks the server may send per ACK. */
+	if ((tftp_windowsize = getenv("tftp.windowsize")) != NULL) {
+		tftp_set_windowsize(h, tftp_windowsize);
+	}
+
 	wbuf.t.th_opcode = htons((u_short)RRQ);
 	wtail = wbuf.t.th_stuff;
 	l = strlen(h->path);
@@ -335,11 +373,16 @@ tftp_makereq(struct tftp_handle *h)
 	wtail += 6;
 	bcopy("0", wtail, 2);
 	wtail += 2;
+	bcopy("windowsize", wtail, 11);
+	wtail += 11;
+	windowsize_l = sprintf(wtail, "%d", h->tftp_windowsize);
+	wtail += windowsize_l + 1;
 
 	h->iodesc->myport = htons(tftpport + (getsecs() & 0x3ff));
 	h->iodesc->destport = htons(IPPORT_TFTP);
 	h->iodesc->xid = 1;	/* expected block */
 
+	tftp_w_flush(h);	/* we may be re-requesting after a seek */
 	h->currblock = 0;
 	h->islastblock = 0;
 	h->validsize = 0;
@@ -360,8 +403,9 @@ tftp_makereq(struct tftp_handle *h)
 	if (recv_extra.rtype == OACK)
 		return (tftp_getnextblock(h));
 
-	/* Server ignored our blksize request, revert to TFTP default. */
+	/* Server ignored our option requests, revert to TFTP defaults. */
 	h->tftp_blksize = SEGSIZE;
+	h->tftp_windowsize = 1;
 
 	switch (recv_extra.rtype) {
 		case DATA: {
@@ -395,6 +439,23 @@ tftp_getnextblock(struct tftp_handle *h)
 	void *pkt;
 	struct tftphdr *t;
 
+	/* Satisfy the request from the read-ahead window if we can. */
+	if (h->w_next < h->w_used) {
+		free(h->pkt);
+		h->pkt = h->w_pkt[h->w_next];
+		h->tftp_hdr = h->w_hdr[h->w_next];
+		h->validsize = h->w_size[h->w_next];
+		h->w_next++;
+		if (h->w_next == h->w_used)
+			h->w_next = h->w_used = 0;
+		h->currblock++;
+		if (h->validsize < h->tftp_blksize)
+			h->islastblock = 1;	/* EOF */
+		if (h->islastblock == 1)
+			tftp_sendack(h, h->currblock);
+		return (0);
+	}
+
 	wbuf.t.th_opcode = htons((u_short)ACK);
 	wtail = (char *)&wbuf.t.th_block;
 	wbuf.t.th_block = htons((u_short)h->currblock);
@@ -424,6 +485,30 @@ tftp_getnextblock(struct tftp_handle *h)
 		/* Send an ACK for the last block */
 		wbuf.t.th_block = htons((u_short)h->currblock);
 		sendudp(h->iodesc, &wbuf.t, wtail - (char *)&wbuf.t);
+		return (0);
+	}
+
+	/*
+	 * Pull in the remainder of the window the ACK above opened.  The
+	 * server streams up to windowsize blocks per ACK, so collect the
+	 * consecutive ones that made it; a timeout or gap simply leaves
+	 * the window short, and the ACK sent once it drains tells the
+	 * server where to resume (RFC7440 falls back to go-back-N).
+	 */
+	while (h->w_used < (int)h->tftp_windowsize - 1) {
+		h->iodesc->xid = h->currblock + h->w_used + 1;
+		pkt = NULL;
+		recv_extra.tftp_handle = h;
+		res = recvtftp(h->iodesc, &pkt, (void **)&t, MINTMO,
+		    &recv_extra);
+		if (res == -1)
+			break;
+		h->w_pkt[h->w_used] = pkt;
+		h->w_hdr[h->w_used] = t;
+		h->w_size[h->w_used] = res;
+		h->w_used++;
+		if (res < h->tftp_blksize)
+			break;		/* EOF, ACKed when consumed */
 	}
 
 	return (0);
@@ -452,6 +537,7 @@ tftp_open(const char *path, struct open_file *f)
 		return (ENOMEM);
 
 	tftpfile->tftp_blksize = TFTP_REQUESTED_BLKSIZE;
+	tftpfile->tftp_windowsize = TFTP_REQUESTED_WINDOWSIZE;
 	tftpfile->iodesc = io = socktodesc(*(int *)(f->f_devdata));
 	if (io == NULL) {
 		free(tftpfile);
@@ -583,6 +669,7 @@ tftp_close(struct open_file *f)
 	/* let it time out ... */
 
 	if (tftpfile) {
+		tftp_w_flush(tftpfile);
 		free(tftpfile->path);
 		free(tftpfile->pkt);
 		free(tftpfile);
@@ -652,6 +739,33 @@ tftp_set_blksize(struct tftp_handle *h, const char *str)
 	return (ret);
 }
 
+static int
+tftp_set_windowsize(struct tftp_handle *h, const char *str)
+{
+	char *endptr;
+	int new_windowsize;
+	int ret = 0;
+
+	if (h == NULL || str == NULL)
+		return (ret);
+
+	new_windowsize =
+	    (unsigned int)strtol(str, &endptr, 0);
+
+	/*
+	 * Only accept windowsize value if it is numeric.
+	 * RFC7440 specifies that acceptable values are 1-65535.
+	 * Limit it to what our read-ahead buffers can hold.
+	 */
+	if (*endptr == '\0' && new_windowsize >= 1 &&
+	    new_windowsize <= TFTP_MAX_WINDOWSIZE) {
+		h->tftp_windowsize = new_windowsize;
+		ret = 1;
+	}
+
+	return (ret);
+}
+
 /*
  * In RFC2347, the TFTP Option Acknowledgement package (OACK)
  * is used to acknowledge a client's option negotiation request.
@@ -687,9 +801,11 @@ tftp_parse_oack(struct tftp_handle *h, char *buf, size_t len)
 	int i = 0;
 	int option_idx = 0;
 	int blksize_is_set = 0;
+	int windowsize_is_set = 0;
 	int tsize = 0;
 
 	unsigned int orig_blksize;
+	unsigned int orig_windowsize;
 
 	while (option_idx < 128 && i < len) {
 		if (buf[i] == '\0') {
@@ -702,13 +818,15 @@ tftp_parse_oack(struct tftp_handle *h, char *buf, size_t len)
 		++i;
 	}
 
-	/* Save the block size we requested for sanity check later. */
+	/* Save the option values we requested for sanity check later. */
 	orig_blksize = h->tftp_blksize;
+	orig_windowsize = h->tftp_windowsize;
 
 	/*
 	 * Parse individual TFTP options.
 	 *    * "blksize" is specified in RFC2348.
 	 *    * "tsize" is specified in RFC2349.
+	 *    * "windowsize" is specified in RFC7440.
 	 */
 	for (i = 0; i < option_idx; i += 2) {
 		if (strcasecmp(tftp_options[i], "blksize") == 0) {
@@ -720,6 +838,10 @@ tftp_parse_oack(struct tftp_handle *h, char *buf, size_t len)
 				tsize = strtol(tftp_options[i + 1], NULL, 10);
 			if (tsize != 0)
 				h->tftp_tsize = tsize;
+		} else if (strcasecmp(tftp_options[i], "windowsize") == 0) {
+			if (i + 1 < option_idx)
+				windowsize_is_set =
+				    tftp_set_windowsize(h, tftp_options[i + 1]);
 		} else {
 			/*
 			 * Do not allow any options we did not expect to be
@@ -746,8 +868,24 @@ tftp_parse_oack(struct tftp_handle *h, char *buf, size_t len)
 		return (-1);
 	}
 
+	if (!windowsize_is_set) {
+		/*
+		 * Servers that do not negotiate a window send one
+		 * block per ACK, i.e. the classic lockstep transfer.
+		 */
+		h->tftp_windowsize = 1;
+	} else if (h->tftp_windowsize > orig_windowsize) {
+		/*
+		 * Server should not be proposing window sizes that
+		 * exceed what we said we can handle.
+		 */
+		printf("unexpected windowsize %u\n", h->tftp_windowsize);
+		return (-1);
+	}
+
 #ifdef TFTP_DEBUG
 	printf("tftp_blksize: %u\n", h->tftp_blksize);
+	printf("tftp_windowsize: %u\n", h->tftp_windowsize);
 	printf("tftp_tsize: %lu\n", h->tftp_tsize);
 #endif
 	return (0);
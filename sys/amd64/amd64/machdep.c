@@ -207,6 +207,18 @@ int	_udatasel, _ucodesel, _ucode32sel, _ufssel, _ugssel;
 
 int cold = 1;
 
+/*
+ * rep movsb/stosb throughput varies a lot between microarchitectures
+ * that all advertise ERMS; let operators who have benchmarked their
+ * parts override the CPUID-based selection of the memory primitives.
+ * Fetched by hand in hammer_time() since the ifunc resolvers consulting
+ * it run long before SI_SUB_TUNABLES.
+ */
+int hw_erms_disable;
+SYSCTL_INT(_machdep, OID_AUTO, erms_disable, CTLFLAG_RDTUN | CTLFLAG_NOFETCH,
+    &hw_erms_disable, 0,
+    "Do not use rep movsb/stosb memory routines even if the CPU reports ERMS");
+
 long Maxmem = 0;
 long realmem = 0;
 
@@ -1592,6 +1604,7 @@ hammer_time(u_int64_t modulep, u_int64_t physfree)
 	pti = pti_get_default();
 	TUNABLE_INT_FETCH("vm.pmap.pti", &pti);
 	TUNABLE_INT_FETCH("vm.pmap.pcid_enabled", &pmap_pcid_enabled);
+	TUNABLE_INT_FETCH("machdep.erms_disable", &hw_erms_disable);
 	if ((cpu_feature2 & CPUID2_PCID) != 0 && pmap_pcid_enabled) {
 		invpcid_works = (cpu_stdext_feature &
 		    CPUID_STDEXT_INVPCID) != 0;
@@ -2697,13 +2710,20 @@ outb_(u_short port, u_char data)
 #undef memmove
 #undef memcpy
 
+static bool
+erms_wanted(void)
+{
+
+	return ((cpu_stdext_feature & CPUID_STDEXT_ERMS) != 0 &&
+	    hw_erms_disable == 0);
+}
+
 void	*memset_std(void *buf, int c, size_t len);
 void	*memset_erms(void *buf, int c, size_t len);
 DEFINE_IFUNC(, void *, memset, (void *, int, size_t), static)
 {
 
-	return ((cpu_stdext_feature & CPUID_STDEXT_ERMS) != 0 ?
-	    memset_erms : memset_std);
+	return (erms_wanted() ? memset_erms : memset_std);
 }
 
 void    *memmove_std(void * _Nonnull dst, const void * _Nonnull src,
@@ -2714,8 +2734,7 @@ DEFINE_IFUNC(, void *, memmove, (void * _Nonnull, const void * _Nonnull,
     size_t), static)
 {
 
-	return ((cpu_stdext_feature & CPUID_STDEXT_ERMS) != 0 ?
-	    memmove_erms : memmove_std);
+	return (erms_wanted() ? memmove_erms : memmove_std);
 }
 
 void    *memcpy_std(void * _Nonnull dst, const void * _Nonnull src,
@@ -2726,8 +2745,7 @@ DEFINE_IFUNC(, void *, memcpy, (void * _Nonnull, const void * _Nonnull,size_t),
     static)
 {
 
-	return ((cpu_stdext_feature & CPUID_STDEXT_ERMS) != 0 ?
-	    memcpy_erms : memcpy_std);
+	return (erms_wanted() ? memcpy_erms : memcpy_std);
 }
 
 void	pagezero_std(void *addr);
@@ -2735,6 +2753,5 @@ void	pagezero_erms(void *addr);
 DEFINE_IFUNC(, void , pagezero, (void *), static)
 {
 
-	return ((cpu_stdext_feature & CPUID_STDEXT_ERMS) != 0 ?
-	    pagezero_erms : pagezero_std);
+	return (erms_wanted() ? pagezero_erms : pagezero_std);
 }
@@ -4197,6 +4197,9 @@ pmap_demote_pde_locked(pmap_t pmap, pd_entry_t *pde, vm_offset_t va,
 		pmap_pv_demote_pde(pmap, va, oldpde & PG_PS_FRAME, lockp);
 
 	atomic_add_long(&pmap_pde_demotions, 1);
+	if (pmap != kernel_pmap)
+		__containerof(pmap, struct vmspace,
+		    vm_pmap)->vm_superpage_demotions++;
 	CTR2(KTR_PMAP, "pmap_demote_pde: success for va %#lx"
 	    " in pmap %p", va, pmap);
 	return (TRUE);
@@ -4948,6 +4951,9 @@ setpte:
 		pde_store(pde, PG_PROMOTED | PG_PS | newpde);
 
 	atomic_add_long(&pmap_pde_promotions, 1);
+	if (pmap != kernel_pmap)
+		__containerof(pmap, struct vmspace,
+		    vm_pmap)->vm_superpage_promotions++;
 	CTR2(KTR_PMAP, "pmap_promote_pde: success for va %#lx"
 	    " in pmap %p", va, pmap);
 }
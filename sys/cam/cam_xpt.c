@@ -46,6 +46,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/fcntl.h>
 #include <sys/proc.h>
 #include <sys/sbuf.h>
+#include <sys/sched.h>
 #include <sys/smp.h>
 #include <sys/taskqueue.h>
 
@@ -193,6 +194,56 @@ static struct proc *cam_proc;
 SYSCTL_INT(_kern_cam, OID_AUTO, num_doneqs, CTLFLAG_RDTUN,
            &cam_num_doneqs, 0, "Number of completion queues/threads");
 
+static int cam_percpu_doneqs;
+
+SYSCTL_INT(_kern_cam, OID_AUTO, percpu_doneqs, CTLFLAG_RDTUN,
+           &cam_percpu_doneqs, 0,
+	   "Use a completion queue and bound thread per CPU so completions "
+	   "are processed on the CPU that took the interrupt");
+
+/*
+ * Histogram of time ccbs spend in the SIM, with power-of-two
+ * microsecond buckets.  The counters are updated without
+ * synchronization; an occasional lost increment is preferable to
+ * bouncing a cache line on every completion.
+ */
+#define	CAM_LAT_NBUCKETS	16
+static u_long cam_sim_latency[CAM_LAT_NBUCKETS];
+
+static void
+xpt_record_sim_latency(uintptr_t delta)
+{
+	uint64_t lat;
+	int bucket;
+
+	lat = sbttous(cam_iosched_sbintime_t(delta));
+	bucket = flsll(lat);
+	if (bucket > 0)
+		bucket--;
+	if (bucket >= CAM_LAT_NBUCKETS)
+		bucket = CAM_LAT_NBUCKETS - 1;
+	cam_sim_latency[bucket]++;
+}
+
+static int
+sysctl_cam_sim_latency(SYSCTL_HANDLER_ARGS)
+{
+	struct sbuf sb;
+	int error, i;
+
+	sbuf_new_for_sysctl(&sb, NULL, CAM_LAT_NBUCKETS * 16, req);
+	for (i = 0; i < CAM_LAT_NBUCKETS; i++)
+		sbuf_printf(&sb, "%s%luus:%lu", i == 0 ? "" : " ",
+		    1UL << i, cam_sim_latency[i]);
+	error = sbuf_finish(&sb);
+	sbuf_delete(&sb);
+	return (error);
+}
+SYSCTL_PROC(_kern_cam, OID_AUTO, sim_latency,
+    CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+    sysctl_cam_sim_latency, "A",
+    "Time ccbs spend in the SIM (power-of-two microsecond buckets)");
+
 struct cam_periph *xpt_periph;
 
 static periph_init_t xpt_periph_init;
@@ -959,9 +1010,11 @@ xpt_init(void *dummy)
 	xpt_path_unlock(path);
 	xpt_free_path(path);
 
-	if (cam_num_doneqs < 1)
+	if (cam_percpu_doneqs)
+		cam_num_doneqs = mp_ncpus;
+	else if (cam_num_doneqs < 1)
 		cam_num_doneqs = 1 + mp_ncpus / 6;
-	else if (cam_num_doneqs > MAXCPU)
+	if (cam_num_doneqs > MAXCPU)
 		cam_num_doneqs = MAXCPU;
 	for (i = 0; i < cam_num_doneqs; i++) {
 		mtx_init(&cam_doneqs[i].cam_doneq_mtx, "CAM doneq", NULL,
@@ -4662,8 +4715,12 @@ xpt_done(union ccb *done_ccb)
 
 	/* Store the time the ccb was in the sim */
 	done_ccb->ccb_h.qos.periph_data = cam_iosched_delta_t(done_ccb->ccb_h.qos.periph_data);
-	hash = (done_ccb->ccb_h.path_id + done_ccb->ccb_h.target_id +
-	    done_ccb->ccb_h.target_lun) % cam_num_doneqs;
+	xpt_record_sim_latency(done_ccb->ccb_h.qos.periph_data);
+	if (cam_percpu_doneqs)
+		hash = curcpu % cam_num_doneqs;
+	else
+		hash = (done_ccb->ccb_h.path_id + done_ccb->ccb_h.target_id +
+		    done_ccb->ccb_h.target_lun) % cam_num_doneqs;
 	queue = &cam_doneqs[hash];
 	mtx_lock(&queue->cam_doneq_mtx);
 	run = (queue->cam_doneq_sleep && STAILQ_EMPTY(&queue->cam_doneq));
@@ -4685,6 +4742,7 @@ xpt_done_direct(union ccb *done_ccb)
 
 	/* Store the time the ccb was in the sim */
 	done_ccb->ccb_h.qos.periph_data = cam_iosched_delta_t(done_ccb->ccb_h.qos.periph_data);
+	xpt_record_sim_latency(done_ccb->ccb_h.qos.periph_data);
 	xpt_done_process(&done_ccb->ccb_h);
 }
 
@@ -5496,6 +5554,17 @@ xpt_done_td(void *arg)
 	struct ccb_hdr *ccb_h;
 	STAILQ_HEAD(, ccb_hdr)	doneq;
 
+	/*
+	 * In per-CPU mode each queue is selected by curcpu in xpt_done(),
+	 * so pin its thread to the matching CPU to keep completion
+	 * processing on the CPU that took the interrupt.
+	 */
+	if (cam_percpu_doneqs && cam_num_doneqs == mp_ncpus) {
+		thread_lock(curthread);
+		sched_bind(curthread, queue - cam_doneqs);
+		thread_unlock(curthread);
+	}
+
 	STAILQ_INIT(&doneq);
 	mtx_lock(&queue->cam_doneq_mtx);
 	while (1) {
@@ -50,6 +50,8 @@ typedef struct nvpair nvpair_t;
 
 #define	NV_FLAG_BIG_ENDIAN		0x080
 #define	NV_FLAG_IN_ARRAY		0x100
+/* Pairs and values come from a per-list arena; never leaves the process. */
+#define	NV_FLAG_ARENA			0x200
 
 #ifdef _KERNEL
 #define	nv_malloc(size)			malloc((size), M_NVLIST, M_WAITOK)
@@ -39,6 +39,7 @@ __FBSDID("$FreeBSD$");
 
 #ifdef _KERNEL
 
+#include <sys/ctype.h>
 #include <sys/errno.h>
 #include <sys/kernel.h>
 #include <sys/lock.h>
@@ -50,6 +51,7 @@ __FBSDID("$FreeBSD$");
 #else
 #include <sys/socket.h>
 
+#include <ctype.h>
 #include <errno.h>
 #include <stdarg.h>
 #include <stdbool.h>
@@ -99,11 +101,31 @@ struct nvlist {
 	int		 nvl_magic;
 	int		 nvl_error;
 	int		 nvl_flags;
+	size_t		 nvl_nitems;
+	nvpair_t	**nvl_index;	/* optional name hash, may be NULL */
+	size_t		 nvl_indexsize;
+	struct nvl_arena_chunk *nvl_arena;	/* NULL unless arena-backed */
 	nvpair_t	*nvl_parent;
 	nvpair_t	*nvl_array_next;
 	struct nvl_head	 nvl_head;
 };
 
+/*
+ * Arena-backed lists (nvlist_create_arena()) carve pairs, names, and
+ * scalar values out of a chain of bump-allocated chunks owned by the
+ * list, so a build-pack-destroy cycle costs a handful of allocations
+ * instead of one per pair.  Nothing in a chunk is freed individually;
+ * nvlist_destroy() releases the whole chain.
+ */
+struct nvl_arena_chunk {
+	struct nvl_arena_chunk	*nac_next;
+	size_t			 nac_len;
+	size_t			 nac_used;
+	/* Data follows. */
+};
+
+#define	NVLIST_ARENA_MINCHUNK	4096
+
 #define	NVLIST_ASSERT(nvl)	do {					\
 	PJDLOG_ASSERT((nvl) != NULL);					\
 	PJDLOG_ASSERT((nvl)->nvl_magic == NVLIST_MAGIC);		\
@@ -125,6 +147,126 @@ struct nvlist_header {
 	uint64_t	nvlh_size;
 } __packed;
 
+/*
+ * Large nvlists are indexed by a lazily built open addressing hash of
+ * nvpair names, turning the lookup based API (nvlist_find() and thus
+ * the exists/get/take families) from a linear scan into an O(1)
+ * probe.  The index is built on first lookup once the list holds
+ * NVLIST_INDEX_THRESHOLD pairs, is kept up to date on insertion, and
+ * is dropped (to be rebuilt on the next lookup) on removal or when
+ * the list's flags change.  Iteration and packing are unaffected; an
+ * allocation failure simply leaves the linear scan in place.
+ */
+#define	NVLIST_INDEX_THRESHOLD	32
+
+static uint32_t
+nvlist_index_hash(const nvlist_t *nvl, const char *name)
+{
+	uint32_t hash;
+	unsigned char c;
+
+	/* FNV-1a, folding case when the list ignores it. */
+	hash = 2166136261U;
+	while ((c = (unsigned char)*name++) != '\0') {
+		if ((nvl->nvl_flags & NV_FLAG_IGNORE_CASE) != 0)
+			c = tolower(c);
+		hash = (hash ^ c) * 16777619U;
+	}
+
+	return (hash);
+}
+
+static bool
+nvlist_index_name_equal(const nvlist_t *nvl, const nvpair_t *nvp,
+    const char *name)
+{
+
+	if ((nvl->nvl_flags & NV_FLAG_IGNORE_CASE) != 0)
+		return (strcasecmp(nvpair_name(nvp), name) == 0);
+	return (strcmp(nvpair_name(nvp), name) == 0);
+}
+
+static void
+nvlist_index_drop(nvlist_t *nvl)
+{
+
+	nv_free(nvl->nvl_index);
+	nvl->nvl_index = NULL;
+	nvl->nvl_indexsize = 0;
+}
+
+static void
+nvlist_index_insert(nvlist_t *nvl, nvpair_t *nvp)
+{
+	uint32_t ii;
+
+	ii = nvlist_index_hash(nvl, nvpair_name(nvp)) &
+	    (nvl->nvl_indexsize - 1);
+	while (nvl->nvl_index[ii] != NULL)
+		ii = (ii + 1) & (nvl->nvl_indexsize - 1);
+	nvl->nvl_index[ii] = nvp;
+}
+
+static void
+nvlist_index_build(nvlist_t *nvl)
+{
+	nvpair_t *nvp;
+	size_t size;
+
+	PJDLOG_ASSERT(nvl->nvl_index == NULL);
+
+	/* Keep the load factor below 1/2. */
+	size = 1;
+	while (size < nvl->nvl_nitems * 2)
+		size <<= 1;
+
+	nvl->nvl_index = nv_calloc(size, sizeof(nvpair_t *));
+	if (nvl->nvl_index == NULL)
+		return;
+	nvl->nvl_indexsize = size;
+
+	/*
+	 * Walking in list order makes probe order match list order for
+	 * duplicated names, preserving lookup semantics for lists
+	 * created with NV_FLAG_NO_UNIQUE.
+	 */
+	for (nvp = nvlist_first_nvpair(nvl); nvp != NULL;
+	    nvp = nvlist_next_nvpair(nvl, nvp))
+		nvlist_index_insert(nvl, nvp);
+}
+
+static nvpair_t *
+nvlist_index_lookup(const nvlist_t *nvl, int type, const char *name)
+{
+	nvpair_t *nvp;
+	uint32_t ii;
+
+	ii = nvlist_index_hash(nvl, name) & (nvl->nvl_indexsize - 1);
+	while ((nvp = nvl->nvl_index[ii]) != NULL) {
+		if ((type == NV_TYPE_NONE || nvpair_type(nvp) == type) &&
+		    nvlist_index_name_equal(nvl, nvp, name))
+			return (nvp);
+		ii = (ii + 1) & (nvl->nvl_indexsize - 1);
+	}
+
+	return (NULL);
+}
+
+static void
+nvlist_index_note_insert(nvlist_t *nvl, nvpair_t *nvp)
+{
+
+	nvl->nvl_nitems++;
+	if (nvl->nvl_index == NULL)
+		return;
+	if (nvl->nvl_nitems * 2 > nvl->nvl_indexsize) {
+		/* Too loaded; grow on the next lookup. */
+		nvlist_index_drop(nvl);
+	} else {
+		nvlist_index_insert(nvl, nvp);
+	}
+}
+
 nvlist_t *
 nvlist_create(int flags)
 {
@@ -137,6 +279,10 @@ nvlist_create(int flags)
 		return (NULL);
 	nvl->nvl_error = 0;
 	nvl->nvl_flags = flags;
+	nvl->nvl_nitems = 0;
+	nvl->nvl_index = NULL;
+	nvl->nvl_indexsize = 0;
+	nvl->nvl_arena = NULL;
 	nvl->nvl_parent = NULL;
 	nvl->nvl_array_next = NULL;
 	TAILQ_INIT(&nvl->nvl_head);
@@ -145,6 +291,50 @@ nvlist_create(int flags)
 	return (nvl);
 }
 
+nvlist_t *
+nvlist_create_arena(int flags)
+{
+	nvlist_t *nvl;
+
+	nvl = nvlist_create(flags);
+	if (nvl != NULL)
+		nvl->nvl_flags |= NV_FLAG_ARENA;
+
+	return (nvl);
+}
+
+void *
+nvlist_arena_alloc(nvlist_t *nvl, size_t size)
+{
+	struct nvl_arena_chunk *chunk;
+	size_t chunklen;
+	void *ptr;
+
+	NVLIST_ASSERT(nvl);
+	PJDLOG_ASSERT((nvl->nvl_flags & NV_FLAG_ARENA) != 0);
+
+	/* Keep every allocation pointer-aligned. */
+	size = roundup2(size, sizeof(void *));
+
+	chunk = nvl->nvl_arena;
+	if (chunk == NULL || chunk->nac_len - chunk->nac_used < size) {
+		chunklen = MAX((size_t)NVLIST_ARENA_MINCHUNK,
+		    sizeof(*chunk) + size);
+		chunk = nv_malloc(chunklen);
+		if (chunk == NULL)
+			return (NULL);
+		chunk->nac_next = nvl->nvl_arena;
+		chunk->nac_len = chunklen - sizeof(*chunk);
+		chunk->nac_used = 0;
+		nvl->nvl_arena = chunk;
+	}
+
+	ptr = (unsigned char *)(chunk + 1) + chunk->nac_used;
+	chunk->nac_used += size;
+
+	return (ptr);
+}
+
 void
 nvlist_destroy(nvlist_t *nvl)
 {
@@ -165,6 +355,14 @@ nvlist_destroy(nvlist_t *nvl)
 		nvpair_free_structure(nvl->nvl_array_next);
 	nvl->nvl_array_next = NULL;
 	nvl->nvl_parent = NULL;
+	nvlist_index_drop(nvl);
+	while (nvl->nvl_arena != NULL) {
+		struct nvl_arena_chunk *chunk;
+
+		chunk = nvl->nvl_arena;
+		nvl->nvl_arena = chunk->nac_next;
+		nv_free(chunk);
+	}
 	nvl->nvl_magic = 0;
 	nv_free(nvl);
 
@@ -312,6 +510,8 @@ nvlist_set_flags(nvlist_t *nvl, int flags)
 	NVLIST_ASSERT(nvl);
 	PJDLOG_ASSERT(nvl->nvl_error == 0);
 
+	/* A flag change may affect name comparison; rebuild on demand. */
+	nvlist_index_drop(nvl);
 	nvl->nvl_flags = flags;
 }
 
@@ -333,6 +533,16 @@ nvlist_find(const nvlist_t *nvl, int type, const char *name)
 	PJDLOG_ASSERT(type == NV_TYPE_NONE ||
 	    (type >= NV_TYPE_FIRST && type <= NV_TYPE_LAST));
 
+	if (nvl->nvl_index == NULL &&
+	    nvl->nvl_nitems >= NVLIST_INDEX_THRESHOLD)
+		nvlist_index_build(__DECONST(nvlist_t *, nvl));
+	if (nvl->nvl_index != NULL) {
+		nvp = nvlist_index_lookup(nvl, type, name);
+		if (nvp == NULL)
+			ERRNO_SET(ENOENT);
+		return (nvp);
+	}
+
 	for (nvp = nvlist_first_nvpair(nvl); nvp != NULL;
 	    nvp = nvlist_next_nvpair(nvl, nvp)) {
 		if (type != NV_TYPE_NONE && nvpair_type(nvp) != type)
@@ -850,7 +1060,8 @@ nvlist_pack_header(const nvlist_t *nvl, unsigned char *ptr, size_t *leftp)
 
 	nvlhdr.nvlh_magic = NVLIST_HEADER_MAGIC;
 	nvlhdr.nvlh_version = NVLIST_HEADER_VERSION;
-	nvlhdr.nvlh_flags = nvl->nvl_flags;
+	/* NV_FLAG_ARENA is a process-local property; keep it off the wire. */
+	nvlhdr.nvlh_flags = nvl->nvl_flags & ~NV_FLAG_ARENA;
 #if BYTE_ORDER == BIG_ENDIAN
 	nvlhdr.nvlh_flags |= NV_FLAG_BIG_ENDIAN;
 #endif
@@ -1108,7 +1319,7 @@ fail:
 
 static nvlist_t *
 nvlist_xunpack(const void *buf, size_t size, const int *fds, size_t nfds,
-    int flags)
+    int flags, bool zerocopy)
 {
 	const unsigned char *ptr;
 	nvlist_t *nvl, *retnvl, *tmpnvl, *array;
@@ -1138,6 +1349,8 @@ nvlist_xunpack(const void *buf, size_t size, const int *fds, size_t nfds,
 		ptr = nvpair_unpack(isbe, ptr, &left, &nvp);
 		if (ptr == NULL)
 			goto fail;
+		if (zerocopy)
+			nvpair_set_external(nvp);
 		switch (nvpair_type(nvp)) {
 		case NV_TYPE_NULL:
 			ptr = nvpair_unpack_null(isbe, nvp, ptr, &left);
@@ -1239,7 +1452,23 @@ nvlist_t *
 nvlist_unpack(const void *buf, size_t size, int flags)
 {
 
-	return (nvlist_xunpack(buf, size, NULL, 0, flags));
+	return (nvlist_xunpack(buf, size, NULL, 0, flags, false));
+}
+
+/*
+ * Unpack without copying values out of the buffer: strings and
+ * binaries in the returned nvlist point directly into 'buf', so the
+ * buffer must remain valid (and unmodified) for as long as the nvlist
+ * or any value taken from it is in use.  Receive cost is then bounded
+ * by validation and pair allocation instead of the payload size.
+ * Note that pointers obtained through nvlist_take_string() and
+ * nvlist_take_binary() on such a list must not be passed to free(3).
+ */
+nvlist_t *
+nvlist_unpack_zerocopy(const void *buf, size_t size, int flags)
+{
+
+	return (nvlist_xunpack(buf, size, NULL, 0, flags, true));
 }
 
 #ifndef _KERNEL
@@ -1323,7 +1552,7 @@ nvlist_recv(int sock, int flags)
 			goto out;
 	}
 
-	nvl = nvlist_xunpack(buf, size, fds, nfds, flags);
+	nvl = nvlist_xunpack(buf, size, fds, nfds, flags, false);
 	if (nvl == NULL) {
 		ERRNO_SAVE();
 		for (i = 0; i < nfds; i++)
@@ -1353,170 +1582,774 @@ nvlist_xfer(int sock, nvlist_t *nvl, int flags)
 	nvlist_destroy(nvl);
 	return (nvlist_recv(sock, flags));
 }
-#endif
 
-nvpair_t *
-nvlist_first_nvpair(const nvlist_t *nvl)
-{
+/*
+ * Streaming serialization.  nvlist_pack_fd() and nvlist_unpack_fd()
+ * produce and consume the same wire format as nvlist_pack() and
+ * nvlist_unpack(), but move it through a small reusable window instead
+ * of materializing the whole image, so peak memory is bounded by the
+ * largest single value in the list rather than by its total packed
+ * size.
+ */
 
-	NVLIST_ASSERT(nvl);
+#define	NVLIST_STREAM_MINBUF	4096
 
-	return (TAILQ_FIRST(&nvl->nvl_head));
-}
+struct nvlist_stream {
+	int		 nvs_fd;
+	unsigned char	*nvs_buf;
+	size_t		 nvs_buflen;	/* window capacity */
+	size_t		 nvs_datalen;	/* buffered bytes (unpack only) */
+};
 
-nvpair_t *
-nvlist_next_nvpair(const nvlist_t *nvl, const nvpair_t *nvp)
+static int
+nvlist_stream_grow(struct nvlist_stream *nvs, size_t size)
 {
-	nvpair_t *retnvp;
-
-	NVLIST_ASSERT(nvl);
-	NVPAIR_ASSERT(nvp);
-	PJDLOG_ASSERT(nvpair_nvlist(nvp) == nvl);
+	unsigned char *buf;
 
-	retnvp = nvpair_next(nvp);
-	PJDLOG_ASSERT(retnvp == NULL || nvpair_nvlist(retnvp) == nvl);
+	if (size <= nvs->nvs_buflen)
+		return (0);
 
-	return (retnvp);
+	size = MAX(size, (size_t)NVLIST_STREAM_MINBUF);
+	buf = nv_realloc(nvs->nvs_buf, size);
+	if (buf == NULL)
+		return (-1);
+	nvs->nvs_buf = buf;
+	nvs->nvs_buflen = size;
 
+	return (0);
 }
 
-nvpair_t *
-nvlist_prev_nvpair(const nvlist_t *nvl, const nvpair_t *nvp)
+static int
+nvlist_stream_flush(struct nvlist_stream *nvs, size_t len)
 {
-	nvpair_t *retnvp;
-
-	NVLIST_ASSERT(nvl);
-	NVPAIR_ASSERT(nvp);
-	PJDLOG_ASSERT(nvpair_nvlist(nvp) == nvl);
+	const unsigned char *ptr;
+	ssize_t done;
 
-	retnvp = nvpair_prev(nvp);
-	PJDLOG_ASSERT(nvpair_nvlist(retnvp) == nvl);
+	ptr = nvs->nvs_buf;
+	while (len > 0) {
+		done = write(nvs->nvs_fd, ptr, len);
+		if (done == -1) {
+			if (errno == EINTR)
+				continue;
+			return (-1);
+		}
+		ptr += done;
+		len -= done;
+	}
 
-	return (retnvp);
+	return (0);
 }
 
-const char *
-nvlist_next(const nvlist_t *nvl, int *typep, void **cookiep)
+/*
+ * Flush whatever has been packed into the window so far and make sure
+ * the (empty) window can hold at least 'size' bytes.  Returns the new
+ * write position or NULL on error.
+ */
+static unsigned char *
+nvlist_stream_reserve(struct nvlist_stream *nvs, unsigned char *ptr,
+    size_t size)
 {
-	nvpair_t *nvp;
 
-	NVLIST_ASSERT(nvl);
-
-	if (cookiep == NULL || *cookiep == NULL)
-		nvp = nvlist_first_nvpair(nvl);
-	else
-		nvp = nvlist_next_nvpair(nvl, *cookiep);
-	if (nvp == NULL)
+	if (ptr != NULL && ptr > nvs->nvs_buf) {
+		if (nvlist_stream_flush(nvs, ptr - nvs->nvs_buf) == -1)
+			return (NULL);
+	}
+	if (nvlist_stream_grow(nvs, size) == -1)
 		return (NULL);
-	if (typep != NULL)
-		*typep = nvpair_type(nvp);
-	if (cookiep != NULL)
-		*cookiep = nvp;
-	return (nvpair_name(nvp));
-}
-
-bool
-nvlist_exists(const nvlist_t *nvl, const char *name)
-{
-
-	return (nvlist_find(nvl, NV_TYPE_NONE, name) != NULL);
-}
 
-#define	NVLIST_EXISTS(type, TYPE)					\
-bool									\
-nvlist_exists_##type(const nvlist_t *nvl, const char *name)		\
-{									\
-									\
-	return (nvlist_find(nvl, NV_TYPE_##TYPE, name) != NULL);	\
+	return (nvs->nvs_buf);
 }
 
-NVLIST_EXISTS(null, NULL)
-NVLIST_EXISTS(bool, BOOL)
-NVLIST_EXISTS(number, NUMBER)
-NVLIST_EXISTS(string, STRING)
-NVLIST_EXISTS(nvlist, NVLIST)
-NVLIST_EXISTS(binary, BINARY)
-NVLIST_EXISTS(bool_array, BOOL_ARRAY)
-NVLIST_EXISTS(number_array, NUMBER_ARRAY)
-NVLIST_EXISTS(string_array, STRING_ARRAY)
-NVLIST_EXISTS(nvlist_array, NVLIST_ARRAY)
-#ifndef _KERNEL
-NVLIST_EXISTS(descriptor, DESCRIPTOR)
-NVLIST_EXISTS(descriptor_array, DESCRIPTOR_ARRAY)
-#endif
-
-#undef	NVLIST_EXISTS
-
-void
-nvlist_add_nvpair(nvlist_t *nvl, const nvpair_t *nvp)
+int
+nvlist_pack_fd(const nvlist_t *nvl, int fd)
 {
-	nvpair_t *newnvp;
+	struct nvlist_stream nvs;
+	unsigned char *ptr;
+	size_t left, need;
+	const nvlist_t *tmpnvl;
+	nvpair_t *nvp, *tmpnvp;
+	void *cookie;
+	int ret;
 
-	NVPAIR_ASSERT(nvp);
+	NVLIST_ASSERT(nvl);
 
-	if (nvlist_error(nvl) != 0) {
-		ERRNO_SET(nvlist_error(nvl));
-		return;
-	}
-	if ((nvl->nvl_flags & NV_FLAG_NO_UNIQUE) == 0) {
-		if (nvlist_exists(nvl, nvpair_name(nvp))) {
-			nvl->nvl_error = EEXIST;
-			ERRNO_SET(nvlist_error(nvl));
-			return;
-		}
+	if (nvl->nvl_error != 0) {
+		ERRNO_SET(nvl->nvl_error);
+		return (-1);
 	}
 
-	newnvp = nvpair_clone(nvp);
-	if (newnvp == NULL) {
-		nvl->nvl_error = ERRNO_OR_DEFAULT(ENOMEM);
-		ERRNO_SET(nvlist_error(nvl));
-		return;
+	if (nvlist_ndescriptors(nvl) > 0) {
+		ERRNO_SET(EOPNOTSUPP);
+		return (-1);
 	}
 
-	nvpair_insert(&nvl->nvl_head, newnvp, nvl);
-}
-
-void
-nvlist_add_stringf(nvlist_t *nvl, const char *name, const char *valuefmt, ...)
-{
-	va_list valueap;
+	nvs.nvs_fd = fd;
+	nvs.nvs_buf = NULL;
+	nvs.nvs_buflen = 0;
+	nvs.nvs_datalen = 0;
 
-	va_start(valueap, valuefmt);
-	nvlist_add_stringv(nvl, name, valuefmt, valueap);
-	va_end(valueap);
-}
+	ret = -1;
+	left = nvlist_size(nvl);
 
-void
-nvlist_add_stringv(nvlist_t *nvl, const char *name, const char *valuefmt,
-    va_list valueap)
-{
-	nvpair_t *nvp;
+	ptr = nvlist_stream_reserve(&nvs, NULL, sizeof(struct nvlist_header));
+	if (ptr == NULL)
+		goto fail;
+	ptr = nvlist_pack_header(nvl, ptr, &left);
 
-	if (nvlist_error(nvl) != 0) {
-		ERRNO_SET(nvlist_error(nvl));
-		return;
-	}
+	nvp = nvlist_first_nvpair(nvl);
+	while (nvp != NULL) {
+		NVPAIR_ASSERT(nvp);
 
-	nvp = nvpair_create_stringv(name, valuefmt, valueap);
-	if (nvp == NULL) {
-		nvl->nvl_error = ERRNO_OR_DEFAULT(ENOMEM);
-		ERRNO_SET(nvl->nvl_error);
-	} else {
-		(void)nvlist_move_nvpair(nvl, nvp);
-	}
-}
+		nvpair_init_datasize(nvp);
+		/*
+		 * Header, name, value for value-carrying types, plus
+		 * room for an embedded nvlist header and an NVLIST_UP
+		 * marker for nested lists.
+		 */
+		need = nvpair_header_size() + strlen(nvpair_name(nvp)) + 1 +
+		    sizeof(struct nvlist_header) + nvpair_header_size() + 1;
+		switch (nvpair_type(nvp)) {
+		case NV_TYPE_NULL:
+		case NV_TYPE_BOOL:
+		case NV_TYPE_NUMBER:
+		case NV_TYPE_STRING:
+		case NV_TYPE_BINARY:
+		case NV_TYPE_BOOL_ARRAY:
+		case NV_TYPE_NUMBER_ARRAY:
+		case NV_TYPE_STRING_ARRAY:
+			need += nvpair_size(nvp);
+			break;
+		default:
+			break;
+		}
+		ptr = nvlist_stream_reserve(&nvs, ptr, need);
+		if (ptr == NULL)
+			goto fail;
 
-void
-nvlist_add_null(nvlist_t *nvl, const char *name)
+		ptr = nvpair_pack_header(nvp, ptr, &left);
+		if (ptr == NULL)
+			goto fail;
+		switch (nvpair_type(nvp)) {
+		case NV_TYPE_NULL:
+			ptr = nvpair_pack_null(nvp, ptr, &left);
+			break;
+		case NV_TYPE_BOOL:
+			ptr = nvpair_pack_bool(nvp, ptr, &left);
+			break;
+		case NV_TYPE_NUMBER:
+			ptr = nvpair_pack_number(nvp, ptr, &left);
+			break;
+		case NV_TYPE_STRING:
+			ptr = nvpair_pack_string(nvp, ptr, &left);
+			break;
+		case NV_TYPE_NVLIST:
+			tmpnvl = nvpair_get_nvlist(nvp);
+			ptr = nvlist_pack_header(tmpnvl, ptr, &left);
+			if (ptr == NULL)
+				goto fail;
+			tmpnvp = nvlist_first_nvpair(tmpnvl);
+			if (tmpnvp != NULL) {
+				nvl = tmpnvl;
+				nvp = tmpnvp;
+				continue;
+			}
+			ptr = nvpair_pack_nvlist_up(ptr, &left);
+			break;
+		case NV_TYPE_BINARY:
+			ptr = nvpair_pack_binary(nvp, ptr, &left);
+			break;
+		case NV_TYPE_BOOL_ARRAY:
+			ptr = nvpair_pack_bool_array(nvp, ptr, &left);
+			break;
+		case NV_TYPE_NUMBER_ARRAY:
+			ptr = nvpair_pack_number_array(nvp, ptr, &left);
+			break;
+		case NV_TYPE_STRING_ARRAY:
+			ptr = nvpair_pack_string_array(nvp, ptr, &left);
+			break;
+		case NV_TYPE_NVLIST_ARRAY:
+		    {
+			const nvlist_t * const * value;
+			size_t nitems;
+			unsigned int ii;
+
+			tmpnvl = NULL;
+			value = nvpair_get_nvlist_array(nvp, &nitems);
+			for (ii = 0; ii < nitems; ii++) {
+				ptr = nvlist_stream_reserve(&nvs, ptr,
+				    sizeof(struct nvlist_header) +
+				    nvpair_header_size() + 1);
+				if (ptr == NULL)
+					goto fail;
+				ptr = nvlist_pack_header(value[ii], ptr, &left);
+				if (ptr == NULL)
+					goto fail;
+				tmpnvp = nvlist_first_nvpair(value[ii]);
+				if (tmpnvp != NULL) {
+					tmpnvl = value[ii];
+					break;
+				}
+				ptr = nvpair_pack_nvlist_array_next(ptr, &left);
+				if (ptr == NULL)
+					goto fail;
+			}
+			if (tmpnvl != NULL) {
+				nvl = tmpnvl;
+				nvp = tmpnvp;
+				continue;
+			}
+			break;
+		    }
+		default:
+			PJDLOG_ABORT("Invalid type (%d).", nvpair_type(nvp));
+		}
+		if (ptr == NULL)
+			goto fail;
+		while ((nvp = nvlist_next_nvpair(nvl, nvp)) == NULL) {
+			do {
+				cookie = NULL;
+				ptr = nvlist_stream_reserve(&nvs, ptr,
+				    sizeof(struct nvlist_header) +
+				    2 * (nvpair_header_size() + 1));
+				if (ptr == NULL)
+					goto fail;
+				if (nvlist_in_array(nvl)) {
+					ptr = nvpair_pack_nvlist_array_next(ptr,
+					    &left);
+					if (ptr == NULL)
+						goto fail;
+				}
+				nvl = nvlist_get_pararr(nvl, &cookie);
+				if (nvl == NULL)
+					goto out;
+				if (nvlist_in_array(nvl) && cookie == NULL) {
+					nvp = nvlist_first_nvpair(nvl);
+					ptr = nvlist_pack_header(nvl, ptr,
+					    &left);
+					if (ptr == NULL)
+						goto fail;
+				} else if (nvpair_type((nvpair_t *)cookie) !=
+				    NV_TYPE_NVLIST_ARRAY) {
+					ptr = nvpair_pack_nvlist_up(ptr, &left);
+					if (ptr == NULL)
+						goto fail;
+					nvp = cookie;
+				} else {
+					nvp = cookie;
+				}
+			} while (nvp == NULL);
+			if (nvlist_in_array(nvl) && cookie == NULL)
+				break;
+		}
+	}
+
+out:
+	if (nvlist_stream_flush(&nvs, ptr - nvs.nvs_buf) == -1)
+		goto fail;
+	ret = 0;
+fail:
+	ERRNO_SAVE();
+	nv_free(nvs.nvs_buf);
+	ERRNO_RESTORE();
+	return (ret);
+}
+
+/*
+ * Make sure the window holds at least 'size' buffered bytes, reading
+ * more from the descriptor as needed.  Never reads beyond what is
+ * asked for, so trailing data in the stream is left untouched.
+ */
+static int
+nvlist_stream_fill(struct nvlist_stream *nvs, size_t size)
 {
+	ssize_t done;
+
+	if (size <= nvs->nvs_datalen)
+		return (0);
+
+	if (nvlist_stream_grow(nvs, size) == -1)
+		return (-1);
+
+	while (nvs->nvs_datalen < size) {
+		done = read(nvs->nvs_fd, nvs->nvs_buf + nvs->nvs_datalen,
+		    size - nvs->nvs_datalen);
+		if (done == -1) {
+			if (errno == EINTR)
+				continue;
+			return (-1);
+		}
+		if (done == 0) {
+			/* Truncated stream. */
+			ERRNO_SET(EINVAL);
+			return (-1);
+		}
+		nvs->nvs_datalen += done;
+	}
+
+	return (0);
+}
+
+static void
+nvlist_stream_consume(struct nvlist_stream *nvs, size_t size)
+{
+
+	PJDLOG_ASSERT(size <= nvs->nvs_datalen);
+
+	nvs->nvs_datalen -= size;
+	if (nvs->nvs_datalen > 0)
+		memmove(nvs->nvs_buf, nvs->nvs_buf + size, nvs->nvs_datalen);
+}
+
+nvlist_t *
+nvlist_unpack_fd(int fd, int flags)
+{
+	struct nvlist_header nvlhdr;
+	struct nvlist_stream nvs;
+	const unsigned char *ptr;
+	nvlist_t *nvl, *retnvl, *tmpnvl, *array;
 	nvpair_t *nvp;
+	size_t left, need;
+	int type;
+	bool isbe;
+
+	PJDLOG_ASSERT((flags & ~(NV_FLAG_PUBLIC_MASK)) == 0);
+
+	nvs.nvs_fd = fd;
+	nvs.nvs_buf = NULL;
+	nvs.nvs_buflen = 0;
+	nvs.nvs_datalen = 0;
+
+	tmpnvl = array = NULL;
+	nvl = retnvl = NULL;
+
+	if (nvlist_stream_fill(&nvs, sizeof(nvlhdr)) == -1)
+		goto fail;
+	memcpy(&nvlhdr, nvs.nvs_buf, sizeof(nvlhdr));
+	if (!nvlist_check_header(&nvlhdr))
+		goto fail;
+	if (nvlhdr.nvlh_descriptors > 0) {
+		/* There is no side channel for descriptors here. */
+		ERRNO_SET(EOPNOTSUPP);
+		goto fail;
+	}
+	left = sizeof(nvlhdr) + (size_t)nvlhdr.nvlh_size;
+
+	nvl = retnvl = nvlist_create(0);
+	if (nvl == NULL)
+		goto fail;
+
+	ptr = nvlist_unpack_header(nvl, nvs.nvs_buf, 0, &isbe, &left);
+	if (ptr == NULL)
+		goto fail;
+	if (nvl->nvl_flags != flags) {
+		ERRNO_SET(EILSEQ);
+		goto fail;
+	}
+	nvlist_stream_consume(&nvs, sizeof(nvlhdr));
+
+	while (left > 0) {
+		if (nvlist_stream_fill(&nvs,
+		    MIN(left, nvpair_header_size())) == -1)
+			goto fail;
+		if (!nvpair_unpack_peek(isbe, nvs.nvs_buf, nvs.nvs_datalen,
+		    &type, &need)) {
+			goto fail;
+		}
+		switch (type) {
+		case NV_TYPE_NVLIST:
+		case NV_TYPE_NVLIST_ARRAY:
+			need += sizeof(struct nvlist_header);
+			break;
+		case NV_TYPE_NVLIST_ARRAY_NEXT:
+			if (nvl->nvl_array_next != NULL)
+				need += sizeof(struct nvlist_header);
+			break;
+		}
+		if (need > left) {
+			ERRNO_SET(EINVAL);
+			goto fail;
+		}
+		if (nvlist_stream_fill(&nvs, need) == -1)
+			goto fail;
+
+		ptr = nvpair_unpack(isbe, nvs.nvs_buf, &left, &nvp);
+		if (ptr == NULL)
+			goto fail;
+		switch (nvpair_type(nvp)) {
+		case NV_TYPE_NULL:
+			ptr = nvpair_unpack_null(isbe, nvp, ptr, &left);
+			break;
+		case NV_TYPE_BOOL:
+			ptr = nvpair_unpack_bool(isbe, nvp, ptr, &left);
+			break;
+		case NV_TYPE_NUMBER:
+			ptr = nvpair_unpack_number(isbe, nvp, ptr, &left);
+			break;
+		case NV_TYPE_STRING:
+			ptr = nvpair_unpack_string(isbe, nvp, ptr, &left);
+			break;
+		case NV_TYPE_NVLIST:
+			ptr = nvpair_unpack_nvlist(isbe, nvp, ptr, &left, 0,
+			    &tmpnvl);
+			if (tmpnvl == NULL || ptr == NULL)
+				goto fail;
+			nvlist_set_parent(tmpnvl, nvp);
+			break;
+		case NV_TYPE_DESCRIPTOR:
+			ptr = nvpair_unpack_descriptor(isbe, nvp, ptr, &left,
+			    NULL, 0);
+			break;
+		case NV_TYPE_DESCRIPTOR_ARRAY:
+			ptr = nvpair_unpack_descriptor_array(isbe, nvp, ptr,
+			    &left, NULL, 0);
+			break;
+		case NV_TYPE_BINARY:
+			ptr = nvpair_unpack_binary(isbe, nvp, ptr, &left);
+			break;
+		case NV_TYPE_NVLIST_UP:
+			if (nvl->nvl_parent == NULL)
+				goto fail;
+			nvl = nvpair_nvlist(nvl->nvl_parent);
+			nvpair_free_structure(nvp);
+			nvlist_stream_consume(&nvs, ptr - nvs.nvs_buf);
+			continue;
+		case NV_TYPE_NVLIST_ARRAY_NEXT:
+			if (nvl->nvl_array_next == NULL) {
+				if (nvl->nvl_parent == NULL)
+					goto fail;
+				nvl = nvpair_nvlist(nvl->nvl_parent);
+			} else {
+				nvl = __DECONST(nvlist_t *,
+				    nvlist_get_array_next(nvl));
+				ptr = nvlist_unpack_header(nvl, ptr, 0,
+				    &isbe, &left);
+				if (ptr == NULL)
+					goto fail;
+			}
+			nvpair_free_structure(nvp);
+			nvlist_stream_consume(&nvs, ptr - nvs.nvs_buf);
+			continue;
+		case NV_TYPE_BOOL_ARRAY:
+			ptr = nvpair_unpack_bool_array(isbe, nvp, ptr, &left);
+			break;
+		case NV_TYPE_NUMBER_ARRAY:
+			ptr = nvpair_unpack_number_array(isbe, nvp, ptr, &left);
+			break;
+		case NV_TYPE_STRING_ARRAY:
+			ptr = nvpair_unpack_string_array(isbe, nvp, ptr, &left);
+			break;
+		case NV_TYPE_NVLIST_ARRAY:
+			ptr = nvpair_unpack_nvlist_array(isbe, nvp, ptr, &left,
+			    &array);
+			if (ptr == NULL)
+				goto fail;
+			PJDLOG_ASSERT(array != NULL);
+			tmpnvl = array;
+			do {
+				nvlist_set_parent(array, nvp);
+				array = __DECONST(nvlist_t *,
+				    nvlist_get_array_next(array));
+			} while (array != NULL);
+			ptr = nvlist_unpack_header(tmpnvl, ptr, 0, &isbe,
+			    &left);
+			break;
+		default:
+			PJDLOG_ABORT("Invalid type (%d).", nvpair_type(nvp));
+		}
+		if (ptr == NULL)
+			goto fail;
+		if (!nvlist_move_nvpair(nvl, nvp))
+			goto fail;
+		if (tmpnvl != NULL) {
+			nvl = tmpnvl;
+			tmpnvl = NULL;
+		}
+		nvlist_stream_consume(&nvs, ptr - nvs.nvs_buf);
+	}
+
+	nv_free(nvs.nvs_buf);
+	return (retnvl);
+fail:
+	ERRNO_SAVE();
+	nvlist_destroy(retnvl);
+	nv_free(nvs.nvs_buf);
+	ERRNO_RESTORE();
+	return (NULL);
+}
+#endif
+
+nvpair_t *
+nvlist_first_nvpair(const nvlist_t *nvl)
+{
+
+	NVLIST_ASSERT(nvl);
+
+	return (TAILQ_FIRST(&nvl->nvl_head));
+}
+
+nvpair_t *
+nvlist_next_nvpair(const nvlist_t *nvl, const nvpair_t *nvp)
+{
+	nvpair_t *retnvp;
+
+	NVLIST_ASSERT(nvl);
+	NVPAIR_ASSERT(nvp);
+	PJDLOG_ASSERT(nvpair_nvlist(nvp) == nvl);
+
+	retnvp = nvpair_next(nvp);
+	PJDLOG_ASSERT(retnvp == NULL || nvpair_nvlist(retnvp) == nvl);
+
+	return (retnvp);
+
+}
+
+nvpair_t *
+nvlist_prev_nvpair(const nvlist_t *nvl, const nvpair_t *nvp)
+{
+	nvpair_t *retnvp;
+
+	NVLIST_ASSERT(nvl);
+	NVPAIR_ASSERT(nvp);
+	PJDLOG_ASSERT(nvpair_nvlist(nvp) == nvl);
+
+	retnvp = nvpair_prev(nvp);
+	PJDLOG_ASSERT(nvpair_nvlist(retnvp) == nvl);
+
+	return (retnvp);
+}
+
+const char *
+nvlist_next(const nvlist_t *nvl, int *typep, void **cookiep)
+{
+	nvpair_t *nvp;
+
+	NVLIST_ASSERT(nvl);
+
+	if (cookiep == NULL || *cookiep == NULL)
+		nvp = nvlist_first_nvpair(nvl);
+	else
+		nvp = nvlist_next_nvpair(nvl, *cookiep);
+	if (nvp == NULL)
+		return (NULL);
+	if (typep != NULL)
+		*typep = nvpair_type(nvp);
+	if (cookiep != NULL)
+		*cookiep = nvp;
+	return (nvpair_name(nvp));
+}
+
+static void
+nvlist_item_fill(const nvpair_t *nvp, nvlist_item_t *item)
+{
+
+	item->nvi_name = nvpair_name(nvp);
+	item->nvi_type = nvpair_type(nvp);
+	item->nvi_number = 0;
+	item->nvi_data = NULL;
+	item->nvi_size = 0;
+
+	switch (item->nvi_type) {
+	case NV_TYPE_NULL:
+		break;
+	case NV_TYPE_BOOL:
+		item->nvi_number = nvpair_get_bool(nvp) ? 1 : 0;
+		break;
+	case NV_TYPE_NUMBER:
+		item->nvi_number = nvpair_get_number(nvp);
+		break;
+	case NV_TYPE_STRING:
+		item->nvi_data = nvpair_get_string(nvp);
+		break;
+	case NV_TYPE_NVLIST:
+		item->nvi_data = nvpair_get_nvlist(nvp);
+		break;
+#ifndef _KERNEL
+	case NV_TYPE_DESCRIPTOR:
+		item->nvi_number = (uint64_t)nvpair_get_descriptor(nvp);
+		break;
+	case NV_TYPE_DESCRIPTOR_ARRAY:
+		item->nvi_data = nvpair_get_descriptor_array(nvp,
+		    &item->nvi_size);
+		break;
+#endif
+	case NV_TYPE_BINARY:
+		item->nvi_data = nvpair_get_binary(nvp, &item->nvi_size);
+		break;
+	case NV_TYPE_BOOL_ARRAY:
+		item->nvi_data = nvpair_get_bool_array(nvp, &item->nvi_size);
+		break;
+	case NV_TYPE_NUMBER_ARRAY:
+		item->nvi_data = nvpair_get_number_array(nvp, &item->nvi_size);
+		break;
+	case NV_TYPE_STRING_ARRAY:
+		item->nvi_data = nvpair_get_string_array(nvp, &item->nvi_size);
+		break;
+	case NV_TYPE_NVLIST_ARRAY:
+		item->nvi_data = nvpair_get_nvlist_array(nvp, &item->nvi_size);
+		break;
+	default:
+		PJDLOG_ABORT("Invalid type (%d).", item->nvi_type);
+	}
+}
+
+/*
+ * Cursor-style counterpart of nvlist_next(): advance to the next pair
+ * and fill in its complete (name, type, value) descriptor, so walking
+ * a list does not require a by-name getter call (and thus a second
+ * lookup) per pair.
+ */
+bool
+nvlist_next_item(const nvlist_t *nvl, nvlist_item_t *item, void **cookiep)
+{
+	nvpair_t *nvp;
+
+	NVLIST_ASSERT(nvl);
+	PJDLOG_ASSERT(item != NULL);
+	PJDLOG_ASSERT(cookiep != NULL);
+
+	if (*cookiep == NULL)
+		nvp = nvlist_first_nvpair(nvl);
+	else
+		nvp = nvlist_next_nvpair(nvl, *cookiep);
+	if (nvp == NULL)
+		return (false);
+	nvlist_item_fill(nvp, item);
+	*cookiep = nvp;
+	return (true);
+}
+
+/*
+ * Fill a caller-provided array with descriptors for up to maxitems
+ * pairs in iteration order, in a single traversal of the list.
+ * Returns the total number of pairs in the list, which may exceed
+ * maxitems; calling with maxitems of zero is a cheap way to size the
+ * array.
+ */
+size_t
+nvlist_get_items(const nvlist_t *nvl, nvlist_item_t *items, size_t maxitems)
+{
+	nvpair_t *nvp;
+	size_t nitems;
+
+	NVLIST_ASSERT(nvl);
+
+	nitems = 0;
+	for (nvp = nvlist_first_nvpair(nvl); nvp != NULL;
+	    nvp = nvlist_next_nvpair(nvl, nvp)) {
+		if (nitems < maxitems)
+			nvlist_item_fill(nvp, &items[nitems]);
+		nitems++;
+	}
+
+	return (nitems);
+}
+
+bool
+nvlist_exists(const nvlist_t *nvl, const char *name)
+{
+
+	return (nvlist_find(nvl, NV_TYPE_NONE, name) != NULL);
+}
+
+#define	NVLIST_EXISTS(type, TYPE)					\
+bool									\
+nvlist_exists_##type(const nvlist_t *nvl, const char *name)		\
+{									\
+									\
+	return (nvlist_find(nvl, NV_TYPE_##TYPE, name) != NULL);	\
+}
+
+NVLIST_EXISTS(null, NULL)
+NVLIST_EXISTS(bool, BOOL)
+NVLIST_EXISTS(number, NUMBER)
+NVLIST_EXISTS(string, STRING)
+NVLIST_EXISTS(nvlist, NVLIST)
+NVLIST_EXISTS(binary, BINARY)
+NVLIST_EXISTS(bool_array, BOOL_ARRAY)
+NVLIST_EXISTS(number_array, NUMBER_ARRAY)
+NVLIST_EXISTS(string_array, STRING_ARRAY)
+NVLIST_EXISTS(nvlist_array, NVLIST_ARRAY)
+#ifndef _KERNEL
+NVLIST_EXISTS(descriptor, DESCRIPTOR)
+NVLIST_EXISTS(descriptor_array, DESCRIPTOR_ARRAY)
+#endif
+
+#undef	NVLIST_EXISTS
+
+void
+nvlist_add_nvpair(nvlist_t *nvl, const nvpair_t *nvp)
+{
+	nvpair_t *newnvp;
+
+	NVPAIR_ASSERT(nvp);
 
 	if (nvlist_error(nvl) != 0) {
 		ERRNO_SET(nvlist_error(nvl));
 		return;
 	}
+	if ((nvl->nvl_flags & NV_FLAG_NO_UNIQUE) == 0) {
+		if (nvlist_exists(nvl, nvpair_name(nvp))) {
+			nvl->nvl_error = EEXIST;
+			ERRNO_SET(nvlist_error(nvl));
+			return;
+		}
+	}
+
+	newnvp = nvpair_clone(nvp);
+	if (newnvp == NULL) {
+		nvl->nvl_error = ERRNO_OR_DEFAULT(ENOMEM);
+		ERRNO_SET(nvlist_error(nvl));
+		return;
+	}
 
-	nvp = nvpair_create_null(name);
+	nvpair_insert(&nvl->nvl_head, newnvp, nvl);
+	nvlist_index_note_insert(nvl, newnvp);
+}
+
+void
+nvlist_add_stringf(nvlist_t *nvl, const char *name, const char *valuefmt, ...)
+{
+	va_list valueap;
+
+	va_start(valueap, valuefmt);
+	nvlist_add_stringv(nvl, name, valuefmt, valueap);
+	va_end(valueap);
+}
+
+void
+nvlist_add_stringv(nvlist_t *nvl, const char *name, const char *valuefmt,
+    va_list valueap)
+{
+	nvpair_t *nvp;
+
+	if (nvlist_error(nvl) != 0) {
+		ERRNO_SET(nvlist_error(nvl));
+		return;
+	}
+
+	nvp = nvpair_create_stringv(name, valuefmt, valueap);
+	if (nvp == NULL) {
+		nvl->nvl_error = ERRNO_OR_DEFAULT(ENOMEM);
+		ERRNO_SET(nvl->nvl_error);
+	} else {
+		(void)nvlist_move_nvpair(nvl, nvp);
+	}
+}
+
+void
+nvlist_add_null(nvlist_t *nvl, const char *name)
+{
+	nvpair_t *nvp;
+
+	if (nvlist_error(nvl) != 0) {
+		ERRNO_SET(nvlist_error(nvl));
+		return;
+	}
+
+	if ((nvl->nvl_flags & NV_FLAG_ARENA) != 0)
+		nvp = nvpair_create_null_arena(nvl, name);
+	else
+		nvp = nvpair_create_null(name);
 	if (nvp == NULL) {
 		nvl->nvl_error = ERRNO_OR_DEFAULT(ENOMEM);
 		ERRNO_SET(nvl->nvl_error);
@@ -1536,7 +2369,10 @@ nvlist_add_binary(nvlist_t *nvl, const char *name, const void *value,
 		return;
 	}
 
-	nvp = nvpair_create_binary(name, value, size);
+	if ((nvl->nvl_flags & NV_FLAG_ARENA) != 0)
+		nvp = nvpair_create_binary_arena(nvl, name, value, size);
+	else
+		nvp = nvpair_create_binary(name, value, size);
 	if (nvp == NULL) {
 		nvl->nvl_error = ERRNO_OR_DEFAULT(ENOMEM);
 		ERRNO_SET(nvl->nvl_error);
@@ -1566,9 +2402,6 @@ nvlist_add_##type(nvlist_t *nvl, const char *name, vtype value)		\
 	}								\
 }
 
-NVLIST_ADD(bool, bool)
-NVLIST_ADD(uint64_t, number)
-NVLIST_ADD(const char *, string)
 NVLIST_ADD(const nvlist_t *, nvlist)
 #ifndef _KERNEL
 NVLIST_ADD(int, descriptor);
@@ -1576,6 +2409,39 @@ NVLIST_ADD(int, descriptor);
 
 #undef	NVLIST_ADD
 
+/*
+ * As NVLIST_ADD, but for types whose pairs can be carved out of an
+ * arena-backed list's region instead of being individually malloc'ed.
+ */
+#define	NVLIST_ADD_ARENA(vtype, type)					\
+void									\
+nvlist_add_##type(nvlist_t *nvl, const char *name, vtype value)		\
+{									\
+	nvpair_t *nvp;							\
+									\
+	if (nvlist_error(nvl) != 0) {					\
+		ERRNO_SET(nvlist_error(nvl));				\
+		return;							\
+	}								\
+									\
+	if ((nvl->nvl_flags & NV_FLAG_ARENA) != 0)			\
+		nvp = nvpair_create_##type##_arena(nvl, name, value);	\
+	else								\
+		nvp = nvpair_create_##type(name, value);		\
+	if (nvp == NULL) {						\
+		nvl->nvl_error = ERRNO_OR_DEFAULT(ENOMEM);		\
+		ERRNO_SET(nvl->nvl_error);				\
+	} else {							\
+		(void)nvlist_move_nvpair(nvl, nvp);			\
+	}								\
+}
+
+NVLIST_ADD_ARENA(bool, bool)
+NVLIST_ADD_ARENA(uint64_t, number)
+NVLIST_ADD_ARENA(const char *, string)
+
+#undef	NVLIST_ADD_ARENA
+
 #define	NVLIST_ADD_ARRAY(vtype, type)					\
 void									\
 nvlist_add_##type##_array(nvlist_t *nvl, const char *name, vtype value,	\
@@ -1660,6 +2526,7 @@ nvlist_move_nvpair(nvlist_t *nvl, nvpair_t *nvp)
 	}
 
 	nvpair_insert(&nvl->nvl_head, nvp, nvl);
+	nvlist_index_note_insert(nvl, nvp);
 	return (true);
 }
 
@@ -2011,6 +2878,9 @@ nvlist_remove_nvpair(nvlist_t *nvl, nvpair_t *nvp)
 	PJDLOG_ASSERT(nvpair_nvlist(nvp) == nvl);
 
 	nvpair_remove(&nvl->nvl_head, nvp, nvl);
+	nvl->nvl_nitems--;
+	/* Open addressing cannot delete in place; rebuild on demand. */
+	nvlist_index_drop(nvl);
 }
 
 void
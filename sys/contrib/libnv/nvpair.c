@@ -87,6 +87,7 @@ struct nvpair {
 	int		 nvp_magic;
 	char		*nvp_name;
 	int		 nvp_type;
+	int		 nvp_flags;
 	uint64_t	 nvp_data;
 	size_t		 nvp_datasize;
 	size_t		 nvp_nitems;	/* Used only for array types. */
@@ -94,6 +95,17 @@ struct nvpair {
 	TAILQ_ENTRY(nvpair) nvp_next;
 };
 
+/*
+ * The value points into an external buffer (zero-copy unpack) and
+ * must not be freed together with the pair.
+ */
+#define	NVPAIR_FLAG_EXTERNAL	0x01
+/*
+ * The pair structure and its value live in the owning list's arena
+ * and are reclaimed wholesale when the list is destroyed.
+ */
+#define	NVPAIR_FLAG_ARENA	0x02
+
 #define	NVPAIR_ASSERT(nvp)	do {					\
 	PJDLOG_ASSERT((nvp) != NULL);					\
 	PJDLOG_ASSERT((nvp)->nvp_magic == NVPAIR_MAGIC);		\
@@ -144,6 +156,108 @@ nvpair_allocv(const char *name, int type, uint64_t data, size_t datasize,
 	return (nvp);
 }
 
+/*
+ * Like nvpair_allocv(), but the pair (and, for string and binary
+ * pairs, the value) is carved out of the list's arena instead of
+ * being malloc'ed, so nvpair_free() leaves the memory alone and the
+ * arena reclaims it in one shot.
+ */
+static nvpair_t *
+nvpair_allocv_arena(nvlist_t *nvl, const char *name, int type, uint64_t data,
+    size_t datasize, size_t nitems)
+{
+	nvpair_t *nvp;
+	size_t namelen;
+
+	PJDLOG_ASSERT(type >= NV_TYPE_FIRST && type <= NV_TYPE_LAST);
+
+	namelen = strlen(name);
+	if (namelen >= NV_NAME_MAX) {
+		ERRNO_SET(ENAMETOOLONG);
+		return (NULL);
+	}
+
+	nvp = nvlist_arena_alloc(nvl, sizeof(*nvp) + namelen + 1);
+	if (nvp == NULL)
+		return (NULL);
+	memset(nvp, 0, sizeof(*nvp));
+	nvp->nvp_name = (char *)(nvp + 1);
+	memcpy(nvp->nvp_name, name, namelen);
+	nvp->nvp_name[namelen] = '\0';
+	nvp->nvp_type = type;
+	nvp->nvp_flags = NVPAIR_FLAG_ARENA;
+	nvp->nvp_data = data;
+	nvp->nvp_datasize = datasize;
+	nvp->nvp_nitems = nitems;
+	nvp->nvp_magic = NVPAIR_MAGIC;
+
+	return (nvp);
+}
+
+nvpair_t *
+nvpair_create_null_arena(nvlist_t *nvl, const char *name)
+{
+
+	return (nvpair_allocv_arena(nvl, name, NV_TYPE_NULL, 0, 0, 0));
+}
+
+nvpair_t *
+nvpair_create_bool_arena(nvlist_t *nvl, const char *name, bool value)
+{
+
+	return (nvpair_allocv_arena(nvl, name, NV_TYPE_BOOL, value ? 1 : 0,
+	    sizeof(uint8_t), 0));
+}
+
+nvpair_t *
+nvpair_create_number_arena(nvlist_t *nvl, const char *name, uint64_t value)
+{
+
+	return (nvpair_allocv_arena(nvl, name, NV_TYPE_NUMBER, value,
+	    sizeof(value), 0));
+}
+
+nvpair_t *
+nvpair_create_string_arena(nvlist_t *nvl, const char *name, const char *value)
+{
+	size_t size;
+	char *data;
+
+	if (value == NULL) {
+		ERRNO_SET(EINVAL);
+		return (NULL);
+	}
+
+	size = strlen(value) + 1;
+	data = nvlist_arena_alloc(nvl, size);
+	if (data == NULL)
+		return (NULL);
+	memcpy(data, value, size);
+
+	return (nvpair_allocv_arena(nvl, name, NV_TYPE_STRING,
+	    (uint64_t)(uintptr_t)data, size, 0));
+}
+
+nvpair_t *
+nvpair_create_binary_arena(nvlist_t *nvl, const char *name, const void *value,
+    size_t size)
+{
+	void *data;
+
+	if (value == NULL || size == 0) {
+		ERRNO_SET(EINVAL);
+		return (NULL);
+	}
+
+	data = nvlist_arena_alloc(nvl, size);
+	if (data == NULL)
+		return (NULL);
+	memcpy(data, value, size);
+
+	return (nvpair_allocv_arena(nvl, name, NV_TYPE_BINARY,
+	    (uint64_t)(uintptr_t)data, size, 0));
+}
+
 static int
 nvpair_append(nvpair_t *nvp, const void *value, size_t valsize, size_t datasize)
 {
@@ -633,6 +747,51 @@ nvpair_init_datasize(nvpair_t *nvp)
 	}
 }
 
+/*
+ * Find the first NUL in buf[0..len) using word-sized loads ("SIMD
+ * within a register").  Unpack-time validation scans every name and
+ * every string value of a received list, and a byte loop dominates
+ * the receive path for large lists; unlike ISA-specific vector code,
+ * word-at-a-time scanning works in both the kernel and userland
+ * builds of this file.  Returns the index of the first NUL, or len
+ * if there is none.
+ */
+#define	NVPAIR_SCAN_ONES	((unsigned long)-1 / 0xff)	/* 0x0101... */
+#define	NVPAIR_SCAN_HIGHS	(NVPAIR_SCAN_ONES << 7)		/* 0x8080... */
+
+static size_t
+nvpair_scan_nul(const char *buf, size_t len)
+{
+	const char *ptr;
+	unsigned long word;
+
+	ptr = buf;
+
+	/* Walk to a word boundary byte by byte. */
+	for (; len > 0 && ((uintptr_t)ptr % sizeof(word)) != 0; ptr++, len--) {
+		if (*ptr == '\0')
+			return ((size_t)(ptr - buf));
+	}
+
+	/*
+	 * A word contains a zero byte iff subtracting one from every
+	 * byte borrows into a byte whose high bit was clear.
+	 */
+	for (; len >= sizeof(word); ptr += sizeof(word), len -= sizeof(word)) {
+		memcpy(&word, ptr, sizeof(word));
+		if (((word - NVPAIR_SCAN_ONES) & ~word &
+		    NVPAIR_SCAN_HIGHS) != 0)
+			break;
+	}
+
+	for (; len > 0; ptr++, len--) {
+		if (*ptr == '\0')
+			return ((size_t)(ptr - buf));
+	}
+
+	return ((size_t)(ptr - buf));
+}
+
 const unsigned char *
 nvpair_unpack_header(bool isbe, nvpair_t *nvp, const unsigned char *ptr,
     size_t *leftp)
@@ -674,7 +833,7 @@ nvpair_unpack_header(bool isbe, nvpair_t *nvp, const unsigned char *ptr,
 		goto fail;
 	if (nvphdr.nvph_namesize < 1)
 		goto fail;
-	if (strnlen((const char *)ptr, nvphdr.nvph_namesize) !=
+	if (nvpair_scan_nul((const char *)ptr, nvphdr.nvph_namesize) !=
 	    (size_t)(nvphdr.nvph_namesize - 1)) {
 		goto fail;
 	}
@@ -697,6 +856,54 @@ fail:
 	return (NULL);
 }
 
+/*
+ * Peek at a packed pair header and report the pair's type and how many
+ * bytes it occupies inline in the stream: header, name and value for
+ * value-carrying types, header and name only for nvlists and the
+ * structural markers, whose contents are parsed as separate items.
+ * Full validation is left to nvpair_unpack_header().
+ */
+bool
+nvpair_unpack_peek(bool isbe, const unsigned char *ptr, size_t left,
+    int *typep, size_t *sizep)
+{
+	struct nvpair_header nvphdr;
+
+	if (left < sizeof(nvphdr)) {
+		ERRNO_SET(EINVAL);
+		return (false);
+	}
+
+	memcpy(&nvphdr, ptr, sizeof(nvphdr));
+
+#if BYTE_ORDER == BIG_ENDIAN
+	if (!isbe) {
+		nvphdr.nvph_namesize = le16toh(nvphdr.nvph_namesize);
+		nvphdr.nvph_datasize = le64toh(nvphdr.nvph_datasize);
+	}
+#else
+	if (isbe) {
+		nvphdr.nvph_namesize = be16toh(nvphdr.nvph_namesize);
+		nvphdr.nvph_datasize = be64toh(nvphdr.nvph_datasize);
+	}
+#endif
+
+	*typep = nvphdr.nvph_type;
+	*sizep = sizeof(nvphdr) + nvphdr.nvph_namesize;
+	switch (nvphdr.nvph_type) {
+	case NV_TYPE_NVLIST:
+	case NV_TYPE_NVLIST_ARRAY:
+	case NV_TYPE_NVLIST_UP:
+	case NV_TYPE_NVLIST_ARRAY_NEXT:
+		break;
+	default:
+		*sizep += nvphdr.nvph_datasize;
+		break;
+	}
+
+	return (true);
+}
+
 const unsigned char *
 nvpair_unpack_null(bool isbe __unused, nvpair_t *nvp, const unsigned char *ptr,
     size_t *leftp __unused)
@@ -770,6 +977,15 @@ nvpair_unpack_number(bool isbe, nvpair_t *nvp, const unsigned char *ptr,
 	return (ptr);
 }
 
+void
+nvpair_set_external(nvpair_t *nvp)
+{
+
+	NVPAIR_ASSERT(nvp);
+
+	nvp->nvp_flags |= NVPAIR_FLAG_EXTERNAL;
+}
+
 const unsigned char *
 nvpair_unpack_string(bool isbe __unused, nvpair_t *nvp,
     const unsigned char *ptr, size_t *leftp)
@@ -782,15 +998,21 @@ nvpair_unpack_string(bool isbe __unused, nvpair_t *nvp,
 		return (NULL);
 	}
 
-	if (strnlen((const char *)ptr, nvp->nvp_datasize) !=
+	if (nvpair_scan_nul((const char *)ptr, nvp->nvp_datasize) !=
 	    nvp->nvp_datasize - 1) {
 		ERRNO_SET(EINVAL);
 		return (NULL);
 	}
 
-	nvp->nvp_data = (uint64_t)(uintptr_t)nv_strdup((const char *)ptr);
-	if (nvp->nvp_data == 0)
-		return (NULL);
+	if ((nvp->nvp_flags & NVPAIR_FLAG_EXTERNAL) != 0) {
+		/* Zero-copy: point at the wire buffer. */
+		nvp->nvp_data = (uint64_t)(uintptr_t)ptr;
+	} else {
+		nvp->nvp_data =
+		    (uint64_t)(uintptr_t)nv_strdup((const char *)ptr);
+		if (nvp->nvp_data == 0)
+			return (NULL);
+	}
 
 	ptr += nvp->nvp_datasize;
 	*leftp -= nvp->nvp_datasize;
@@ -880,6 +1102,15 @@ nvpair_unpack_binary(bool isbe __unused, nvpair_t *nvp,
 		return (NULL);
 	}
 
+	if ((nvp->nvp_flags & NVPAIR_FLAG_EXTERNAL) != 0) {
+		/* Zero-copy: point at the wire buffer. */
+		nvp->nvp_data = (uint64_t)(uintptr_t)ptr;
+		ptr += nvp->nvp_datasize;
+		*leftp -= nvp->nvp_datasize;
+
+		return (ptr);
+	}
+
 	value = nv_malloc(nvp->nvp_datasize);
 	if (value == NULL)
 		return (NULL);
@@ -983,7 +1214,7 @@ nvpair_unpack_string_array(bool isbe __unused, nvpair_t *nvp,
 	size = nvp->nvp_datasize;
 	tmp = (const char *)ptr;
 	for (ii = 0; ii < nvp->nvp_nitems; ii++) {
-		len = strnlen(tmp, size - 1) + 1;
+		len = nvpair_scan_nul(tmp, size - 1) + 1;
 		size -= len;
 		if (size < 0) {
 			ERRNO_SET(EINVAL);
@@ -2060,10 +2291,14 @@ nvpair_free(nvpair_t *nvp)
 		nvlist_destroy((nvlist_t *)(intptr_t)nvp->nvp_data);
 		break;
 	case NV_TYPE_STRING:
-		nv_free((char *)(intptr_t)nvp->nvp_data);
+		if ((nvp->nvp_flags &
+		    (NVPAIR_FLAG_EXTERNAL | NVPAIR_FLAG_ARENA)) == 0)
+			nv_free((char *)(intptr_t)nvp->nvp_data);
 		break;
 	case NV_TYPE_BINARY:
-		nv_free((void *)(intptr_t)nvp->nvp_data);
+		if ((nvp->nvp_flags &
+		    (NVPAIR_FLAG_EXTERNAL | NVPAIR_FLAG_ARENA)) == 0)
+			nv_free((void *)(intptr_t)nvp->nvp_data);
 		break;
 	case NV_TYPE_NVLIST_ARRAY:
 		for (i = 0; i < nvp->nvp_nitems; i++) {
@@ -2084,7 +2319,8 @@ nvpair_free(nvpair_t *nvp)
 		nv_free((char **)(intptr_t)nvp->nvp_data);
 		break;
 	}
-	nv_free(nvp);
+	if ((nvp->nvp_flags & NVPAIR_FLAG_ARENA) == 0)
+		nv_free(nvp);
 }
 
 void
@@ -2095,7 +2331,8 @@ nvpair_free_structure(nvpair_t *nvp)
 	PJDLOG_ASSERT(nvp->nvp_list == NULL);
 
 	nvp->nvp_magic = 0;
-	nv_free(nvp);
+	if ((nvp->nvp_flags & NVPAIR_FLAG_ARENA) == 0)
+		nv_free(nvp);
 }
 
 const char *
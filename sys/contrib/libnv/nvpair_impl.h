@@ -54,8 +54,22 @@ size_t nvpair_header_size(void);
 size_t nvpair_size(const nvpair_t *nvp);
 const unsigned char *nvpair_unpack(bool isbe, const unsigned char *ptr,
     size_t *leftp, nvpair_t **nvpp);
+bool nvpair_unpack_peek(bool isbe, const unsigned char *ptr, size_t left,
+    int *typep, size_t *sizep);
 void nvpair_free_structure(nvpair_t *nvp);
 void nvpair_init_datasize(nvpair_t *nvp);
+void nvpair_set_external(nvpair_t *nvp);
+
+/* Arena-backed pair creation (see nvlist_create_arena()). */
+nvpair_t *nvpair_create_null_arena(nvlist_t *nvl, const char *name);
+nvpair_t *nvpair_create_bool_arena(nvlist_t *nvl, const char *name,
+    bool value);
+nvpair_t *nvpair_create_number_arena(nvlist_t *nvl, const char *name,
+    uint64_t value);
+nvpair_t *nvpair_create_string_arena(nvlist_t *nvl, const char *name,
+    const char *value);
+nvpair_t *nvpair_create_binary_arena(nvlist_t *nvl, const char *name,
+    const void *value, size_t size);
 const char *nvpair_type_string(int type);
 
 /* Pack functions. */
@@ -127,6 +127,7 @@ MALLOC_DECLARE(M_DEVFS);
 struct componentname;
 
 TAILQ_HEAD(devfs_dlist_head, devfs_dirent);
+LIST_HEAD(devfs_dhash_head, devfs_dirent);
 
 struct devfs_dirent {
 	struct cdev_priv	*de_cdp;
@@ -141,7 +142,11 @@ struct devfs_dirent {
 	int			de_holdcnt;
 	struct dirent 		*de_dirent;
 	TAILQ_ENTRY(devfs_dirent) de_list;
+	LIST_ENTRY(devfs_dirent) de_hashlink;
 	struct devfs_dlist_head	de_dlist;
+	struct devfs_dhash_head	*de_dirhash;	/* DT_DIR: name hash */
+	u_long			de_dirhashmask;
+	u_int			de_dirhashcnt;	/* hashable entries in dir */
 	struct devfs_dirent	*de_dir;
 	int			de_links;
 	mode_t			de_mode;
@@ -193,6 +198,8 @@ char	*devfs_fqpn(char *, struct devfs_mount *, struct devfs_dirent *,
 	    struct componentname *);
 void	devfs_delete(struct devfs_mount *, struct devfs_dirent *, int);
 void	devfs_dirent_free(struct devfs_dirent *);
+void	devfs_dirhash_add(struct devfs_dirent *, struct devfs_dirent *);
+void	devfs_dirhash_del(struct devfs_dirent *, struct devfs_dirent *);
 void	devfs_populate(struct devfs_mount *);
 void	devfs_cleanup(struct devfs_mount *);
 void	devfs_unmount_final(struct devfs_mount *);
@@ -34,6 +34,7 @@
 #include <sys/systm.h>
 #include <sys/conf.h>
 #include <sys/dirent.h>
+#include <sys/fnv_hash.h>
 #include <sys/kernel.h>
 #include <sys/limits.h>
 #include <sys/lock.h>
@@ -61,6 +62,7 @@ struct unrhdr *devfs_inos;
 
 static MALLOC_DEFINE(M_DEVFS2, "DEVFS2", "DEVFS data 2");
 static MALLOC_DEFINE(M_DEVFS3, "DEVFS3", "DEVFS data 3");
+static MALLOC_DEFINE(M_DEVFS4, "DEVFS4", "DEVFS directory hash");
 static MALLOC_DEFINE(M_CDEVP, "DEVFS1", "DEVFS cdev_priv storage");
 
 SYSCTL_NODE(_vfs, OID_AUTO, devfs, CTLFLAG_RW, 0, "DEVFS filesystem");
@@ -183,29 +185,130 @@ devfs_free(struct cdev *cdev)
 	free(cdp, M_CDEVP);
 }
 
-struct devfs_dirent *
-devfs_find(struct devfs_dirent *dd, const char *name, int namelen, int type)
+static bool
+devfs_find_match(struct devfs_dirent *de, const char *name, int namelen,
+    int type)
+{
+
+	if (namelen != de->de_dirent->d_namlen)
+		return (false);
+	if (type != 0 && type != de->de_dirent->d_type)
+		return (false);
+
+	/*
+	 * The race with finding non-active name is not
+	 * completely closed by the check, but it is similar
+	 * to the devfs_allocv() in making it unlikely enough.
+	 */
+	if (de->de_dirent->d_type == DT_CHR &&
+	    (de->de_cdp->cdp_flags & CDP_ACTIVE) == 0)
+		return (false);
+
+	if (bcmp(name, de->de_dirent->d_name, namelen) != 0)
+		return (false);
+	return (true);
+}
+
+/*
+ * Name hash over the entries of a directory, built once the directory
+ * grows past DEVFS_DIRHASH_NENTRIES entries and maintained by the
+ * de_dlist insert/remove sites from then on.  "." and ".." are never
+ * hashed; lookup resolves them before consulting devfs_find().
+ */
+#define	DEVFS_DIRHASH_NENTRIES	32
+
+static struct devfs_dhash_head *
+devfs_dirhash_bucket(struct devfs_dirent *dd, const char *name, int namelen)
 {
+
+	return (&dd->de_dirhash[fnv_32_buf(name, namelen, FNV1_32_INIT) &
+	    dd->de_dirhashmask]);
+}
+
+/*
+ * (Re)build the name hash of a directory from de_dlist.  Also used to
+ * grow an existing hash once the chains get too long.
+ */
+static void
+devfs_dirhash_build(struct devfs_dirent *dd)
+{
+	struct devfs_dhash_head *tbl;
 	struct devfs_dirent *de;
+	u_long mask;
 
+	tbl = hashinit(dd->de_dirhashcnt, M_DEVFS4, &mask);
+	if (dd->de_dirhash != NULL)
+		hashdestroy(dd->de_dirhash, M_DEVFS4, dd->de_dirhashmask);
+	dd->de_dirhash = tbl;
+	dd->de_dirhashmask = mask;
 	TAILQ_FOREACH(de, &dd->de_dlist, de_list) {
-		if (namelen != de->de_dirent->d_namlen)
-			continue;
-		if (type != 0 && type != de->de_dirent->d_type)
+		if ((de->de_flags & (DE_DOT | DE_DOTDOT)) != 0)
 			continue;
+		LIST_INSERT_HEAD(devfs_dirhash_bucket(dd,
+		    de->de_dirent->d_name, de->de_dirent->d_namlen), de,
+		    de_hashlink);
+	}
+}
+
+void
+devfs_dirhash_add(struct devfs_dirent *dd, struct devfs_dirent *de)
+{
 
+	if ((de->de_flags & (DE_DOT | DE_DOTDOT)) != 0)
+		return;
+	dd->de_dirhashcnt++;
+	if (dd->de_dirhash == NULL) {
+		if (dd->de_dirhashcnt >= DEVFS_DIRHASH_NENTRIES)
+			devfs_dirhash_build(dd);
+		return;
+	}
+	if (dd->de_dirhashcnt > 2 * (dd->de_dirhashmask + 1)) {
+		devfs_dirhash_build(dd);
+		return;
+	}
+	LIST_INSERT_HEAD(devfs_dirhash_bucket(dd, de->de_dirent->d_name,
+	    de->de_dirent->d_namlen), de, de_hashlink);
+}
+
+void
+devfs_dirhash_del(struct devfs_dirent *dd, struct devfs_dirent *de)
+{
+
+	if ((de->de_flags & (DE_DOT | DE_DOTDOT)) != 0)
+		return;
+	dd->de_dirhashcnt--;
+	if (dd->de_dirhash != NULL)
+		LIST_REMOVE(de, de_hashlink);
+}
+
+struct devfs_dirent *
+devfs_find(struct devfs_dirent *dd, const char *name, int namelen, int type)
+{
+	struct devfs_dirent *de, *de_covered;
+
+	if (dd->de_dirhash != NULL) {
 		/*
-		 * The race with finding non-active name is not
-		 * completely closed by the check, but it is similar
-		 * to the devfs_allocv() in making it unlikely enough.
+		 * An entry shadowed by another one of the same name
+		 * (DE_COVERED) sits after the covering entry on
+		 * de_dlist.  Hash chain order does not track list
+		 * order, so prefer an uncovered match explicitly.
 		 */
-		if (de->de_dirent->d_type == DT_CHR &&
-		    (de->de_cdp->cdp_flags & CDP_ACTIVE) == 0)
-			continue;
-
-		if (bcmp(name, de->de_dirent->d_name, namelen) != 0)
-			continue;
-		break;
+		de_covered = NULL;
+		LIST_FOREACH(de, devfs_dirhash_bucket(dd, name, namelen),
+		    de_hashlink) {
+			if (!devfs_find_match(de, name, namelen, type))
+				continue;
+			if ((de->de_flags & DE_COVERED) == 0)
+				break;
+			de_covered = de;
+		}
+		if (de == NULL)
+			de = de_covered;
+	} else {
+		TAILQ_FOREACH(de, &dd->de_dlist, de_list) {
+			if (devfs_find_match(de, name, namelen, type))
+				break;
+		}
 	}
 	KASSERT(de == NULL || (de->de_flags & DE_DOOMED) == 0,
 	    ("devfs_find: returning a doomed entry"));
@@ -307,6 +410,7 @@ devfs_vmkdir(struct devfs_mount *dmp, char *name, int namelen,
 		de->de_dir = dotdot;
 		sx_assert(&dmp->dm_lock, SX_XLOCKED);
 		TAILQ_INSERT_TAIL(&dotdot->de_dlist, dd, de_list);
+		devfs_dirhash_add(dotdot, dd);
 		dotdot->de_links++;
 		devfs_rules_apply(dmp, dd);
 		de->de_uuid = dotdot->de_uuid;
@@ -328,6 +432,8 @@ devfs_dirent_free(struct devfs_dirent *de)
 	if (vp != NULL && vp->v_data == de)
 		vp->v_data = NULL;
 	mtx_unlock(&devfs_de_interlock);
+	if (de->de_dirhash != NULL)
+		hashdestroy(de->de_dirhash, M_DEVFS4, de->de_dirhashmask);
 	free(de, M_DEVFS3);
 }
 
@@ -362,6 +468,7 @@ devfs_rmdir_empty(struct devfs_mount *dm, struct devfs_dirent *de)
 		TAILQ_REMOVE(&de->de_dlist, de_dot, de_list);
 		TAILQ_REMOVE(&de->de_dlist, de_dotdot, de_list);
 		TAILQ_REMOVE(&dd->de_dlist, de, de_list);
+		devfs_dirhash_del(dd, de);
 		DEVFS_DE_HOLD(dd);
 		devfs_delete(dm, de, DEVFS_DEL_NORECURSE);
 		devfs_delete(dm, de_dot, DEVFS_DEL_NORECURSE);
@@ -464,6 +571,7 @@ devfs_purge(struct devfs_mount *dm, struct devfs_dirent *dd)
 		if (de == NULL)
 			break;
 		TAILQ_REMOVE(&dd->de_dlist, de, de_list);
+		devfs_dirhash_del(dd, de);
 		if (de->de_flags & DE_USER)
 			devfs_dir_unref_de(dm, dd);
 		if (de->de_flags & (DE_DOT | DE_DOTDOT))
@@ -547,6 +655,7 @@ devfs_populate_loop(struct devfs_mount *dm, int cleanup)
 			dev_unlock();
 
 			TAILQ_REMOVE(&de->de_dir->de_dlist, de, de_list);
+			devfs_dirhash_del(de->de_dir, de);
 			de->de_cdp = NULL;
 			de->de_inode = 0;
 			devfs_delete(dm, de, 0);
@@ -650,6 +759,7 @@ devfs_populate_loop(struct devfs_mount *dm, int cleanup)
 #endif
 		de->de_dir = dd;
 		TAILQ_INSERT_TAIL(&dd->de_dlist, de, de_list);
+		devfs_dirhash_add(dd, de);
 		devfs_rules_apply(dm, de);
 		dev_lock();
 		/* XXX: could check that cdp is still active here */
@@ -231,7 +231,7 @@ void
 g_eli_crypto_run(struct g_eli_worker *wr, struct bio *bp)
 {
 	struct g_eli_softc *sc;
-	struct cryptop *crp;
+	struct cryptop *crp, **crps;
 	struct cryptodesc *crd;
 	u_int i, nsec, secsize;
 	off_t dstoff;
@@ -255,6 +255,7 @@ g_eli_crypto_run(struct g_eli_worker *wr, struct bio *bp)
 	 */
 	size = sizeof(*crp) * nsec;
 	size += sizeof(*crd) * nsec;
+	size += sizeof(*crps) * nsec;
 	/*
 	 * If we write the data we cannot destroy current bio_data content,
 	 * so we need to allocate more memory for encrypted data.
@@ -267,6 +268,9 @@ g_eli_crypto_run(struct g_eli_worker *wr, struct bio *bp)
 	bp->bio_children = nsec;
 	bp->bio_driver2 = p;
 
+	crps = (struct cryptop **)p;
+	p += sizeof(*crps) * nsec;
+
 	if (bp->bio_cmd == BIO_READ)
 		data = bp->bio_data;
 	else {
@@ -278,6 +282,7 @@ g_eli_crypto_run(struct g_eli_worker *wr, struct bio *bp)
 	for (i = 0, dstoff = bp->bio_offset; i < nsec; i++, dstoff += secsize) {
 		crp = (struct cryptop *)p;	p += sizeof(*crp);
 		crd = (struct cryptodesc *)p;	p += sizeof(*crd);
+		crps[i] = crp;
 
 		crp->crp_session = wr->w_sid;
 		crp->crp_ilen = secsize;
@@ -311,8 +316,12 @@ g_eli_crypto_run(struct g_eli_worker *wr, struct bio *bp)
 		crd->crd_next = NULL;
 
 		crp->crp_etype = 0;
-		error = crypto_dispatch(crp);
-		KASSERT(error == 0, ("crypto_dispatch() failed (error=%d)",
-		    error));
 	}
+	/*
+	 * Hand the whole run of same-session requests to the driver at
+	 * once so it can keep the key schedule loaded across sectors.
+	 */
+	error = crypto_dispatch_batch(crps, nsec);
+	KASSERT(error == 0, ("crypto_dispatch_batch() failed (error=%d)",
+	    error));
 }
@@ -205,6 +205,21 @@ struct g_consumer {
 /*
  * A g_provider is a "logical disk".
  */
+/*
+ * Fixed-size ring of recently completed requests kept by each provider
+ * for continuous monitoring.  Writers claim slots with an atomic index
+ * and fill them without locks; a reader may observe a record that is
+ * concurrently overwritten, which monitoring consumers tolerate.
+ */
+#define	G_PP_NRECORDS	32
+struct g_ioprec {
+	sbintime_t	iop_duration;	/* completion latency */
+	off_t		iop_offset;
+	uint32_t	iop_length;
+	uint16_t	iop_cmd;
+	uint16_t	iop_error;
+};
+
 struct g_provider {
 	char			*name;
 	LIST_ENTRY(g_provider)	provider;
@@ -226,6 +241,9 @@ struct g_provider {
 #define G_PF_DIRECT_SEND	0x10
 #define G_PF_DIRECT_RECEIVE	0x20
 
+	u_int			iorec_idx;
+	struct g_ioprec		iorec[G_PP_NRECORDS];
+
 	/* Two fields for the implementing class to use */
 	void			*private;
 	u_int			index;
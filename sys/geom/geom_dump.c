@@ -41,6 +41,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/param.h>
 #include <sys/sbuf.h>
 #include <sys/systm.h>
+#include <sys/time.h>
 #include <sys/malloc.h>
 #include <machine/stdarg.h>
 
@@ -156,6 +157,51 @@ g_conftxt(void *p, int flag)
 	sbuf_finish(sb);
 }
 
+/*
+ * Dump the rings of recent I/O records kept in each provider.  The
+ * records are written locklessly at completion time, so what we copy
+ * out here may include the odd torn record; that is acceptable for a
+ * debugging aid.
+ */
+void
+g_iostats(void *p, int flag)
+{
+	struct g_ioprec rec;
+	struct g_class *mp;
+	struct g_geom *gp;
+	struct g_provider *pp;
+	struct sbuf *sb;
+	u_int idx, i;
+
+	KASSERT(flag != EV_CANCEL, ("g_iostats was cancelled"));
+	sb = p;
+	g_topology_assert();
+	LIST_FOREACH(mp, &g_classes, class) {
+		LIST_FOREACH(gp, &mp->geom, geom) {
+			if (gp->flags & G_GEOM_WITHER)
+				continue;
+			LIST_FOREACH(pp, &gp->provider, provider) {
+				sbuf_printf(sb, "%s", pp->name);
+				idx = pp->iorec_idx;
+				for (i = 0; i < G_PP_NRECORDS; i++) {
+					rec = pp->iorec[(idx + i) %
+					    G_PP_NRECORDS];
+					if (rec.iop_cmd == 0)
+						continue;
+					sbuf_printf(sb, " %u:%jd:%u:%jd:%u",
+					    rec.iop_cmd,
+					    (intmax_t)rec.iop_offset,
+					    rec.iop_length,
+					    (intmax_t)sbttous(rec.iop_duration),
+					    rec.iop_error);
+				}
+				sbuf_printf(sb, "\n");
+			}
+		}
+	}
+	sbuf_finish(sb);
+}
+
 
 void
 g_conf_printf_escaped(struct sbuf *sb, const char *fmt, ...)
@@ -298,6 +298,12 @@ g_run_events()
 			g_topology_unlock();
 		} else {
 			g_topology_unlock();
+			/*
+			 * g_io_deliver() wakes us up when the last
+			 * in-flight bio on an orphaned provider returns,
+			 * so the timed sleep is only a backstop for a
+			 * lost race on the nstart/nend comparison.
+			 */
 			msleep(&g_wait_event, &g_eventlock, PRIBIO | PDROP,
 			    "-", TAILQ_EMPTY(&g_doorstep) ? 0 : hz / 10);
 		}
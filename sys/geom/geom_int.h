@@ -62,6 +62,7 @@ void g_conf_specific(struct sbuf *sb, struct g_class *mp, struct g_geom *gp, str
 void g_conf_printf_escaped(struct sbuf *sb, const char *fmt, ...);
 void g_confdot(void *, int flag);
 void g_conftxt(void *, int flag);
+void g_iostats(void *, int flag);
 
 /* geom_event.c */
 void g_event_init(void);
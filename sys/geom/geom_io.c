@@ -83,6 +83,14 @@ static struct g_bioq g_bio_run_up;
  */
 static volatile u_int pace;
 
+/*
+ * Counts of bios dispatched directly versus through the g_down/g_up
+ * threads.  Updated without synchronization; an occasional lost
+ * increment is preferable to bouncing a cache line on every bio.
+ */
+static long g_direct_down, g_queued_down;
+static long g_direct_up, g_queued_up;
+
 static uma_zone_t	biozone;
 
 /*
@@ -624,6 +632,7 @@ g_io_request(struct bio *bp, struct g_consumer *cp)
 	mtx_unlock(mtxp);
 
 	if (direct) {
+		g_direct_down++;
 		error = g_io_check(bp);
 		if (error >= 0) {
 			CTR3(KTR_GEOM, "g_io_request g_io_check on bp %p "
@@ -634,6 +643,7 @@ g_io_request(struct bio *bp, struct g_consumer *cp)
 		}
 		bp->bio_to->geom->start(bp);
 	} else {
+		g_queued_down++;
 		g_bioq_lock(&g_bio_run_down);
 		first = TAILQ_EMPTY(&g_bio_run_down.bio_queue);
 		TAILQ_INSERT_TAIL(&g_bio_run_down.bio_queue, bp, bio_queue);
@@ -651,6 +661,7 @@ g_io_deliver(struct bio *bp, int error)
 {
 	struct bintime now;
 	struct g_consumer *cp;
+	struct g_ioprec *prec;
 	struct g_provider *pp;
 	struct mtx *mtxp;
 	int direct, first;
@@ -724,6 +735,8 @@ g_io_deliver(struct bio *bp, int error)
 	if ((g_collectstats & G_STATS_CONSUMERS) != 0 ||
 	    ((g_collectstats & G_STATS_PROVIDERS) != 0 && pp->stat != NULL))
 		binuptime(&now);
+	else
+		getbinuptime(&now);
 	mtxp = mtx_pool_find(mtxpool_sleep, cp);
 	mtx_lock(mtxp);
 	if (g_collectstats & G_STATS_PROVIDERS)
@@ -734,11 +747,36 @@ g_io_deliver(struct bio *bp, int error)
 	pp->nend++;
 	mtx_unlock(mtxp);
 
+	/*
+	 * An orphaned provider cannot be registered until its last
+	 * in-flight bio has returned.  Poke the event thread when that
+	 * happens instead of leaving it to the periodic doorstep poll.
+	 */
+	if (__predict_false((pp->flags & G_PF_ORPHAN) != 0) &&
+	    pp->nstart == pp->nend)
+		wakeup(&g_wait_event);
+
 	if (error != ENOMEM) {
+		/*
+		 * Log the completion in the provider's record ring.
+		 * Slots are claimed with the atomic index and filled
+		 * without locks; see struct g_ioprec.
+		 */
+		bintime_sub(&now, &bp->bio_t0);
+		prec = &pp->iorec[atomic_fetchadd_int(&pp->iorec_idx, 1) %
+		    G_PP_NRECORDS];
+		prec->iop_duration = bttosbt(now);
+		prec->iop_offset = bp->bio_offset;
+		prec->iop_length = bp->bio_length;
+		prec->iop_cmd = bp->bio_cmd;
+		prec->iop_error = error;
+
 		bp->bio_error = error;
 		if (direct) {
+			g_direct_up++;
 			biodone(bp);
 		} else {
+			g_queued_up++;
 			g_bioq_lock(&g_bio_run_up);
 			first = TAILQ_EMPTY(&g_bio_run_up.bio_queue);
 			TAILQ_INSERT_TAIL(&g_bio_run_up.bio_queue, bp, bio_queue);
@@ -765,6 +803,19 @@ g_io_deliver(struct bio *bp, int error)
 
 SYSCTL_DECL(_kern_geom);
 
+SYSCTL_LONG(_kern_geom, OID_AUTO, direct_dispatch_requests, CTLFLAG_RD,
+    &g_direct_down, 0,
+    "Count of bios started from the requester's context");
+SYSCTL_LONG(_kern_geom, OID_AUTO, queued_requests, CTLFLAG_RD,
+    &g_queued_down, 0,
+    "Count of bios started through the g_down thread");
+SYSCTL_LONG(_kern_geom, OID_AUTO, direct_dispatch_completions, CTLFLAG_RD,
+    &g_direct_up, 0,
+    "Count of bios completed from the provider's context");
+SYSCTL_LONG(_kern_geom, OID_AUTO, queued_completions, CTLFLAG_RD,
+    &g_queued_up, 0,
+    "Count of bios completed through the g_up thread");
+
 static long transient_maps;
 SYSCTL_LONG(_kern_geom, OID_AUTO, transient_maps, CTLFLAG_RD,
     &transient_maps, 0,
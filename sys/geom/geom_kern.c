@@ -169,6 +169,19 @@ sysctl_kern_geom_conftxt(SYSCTL_HANDLER_ARGS)
 	return error;
 }
  
+static int
+sysctl_kern_geom_iostats(SYSCTL_HANDLER_ARGS)
+{
+	int error;
+	struct sbuf *sb;
+
+	sb = sbuf_new_auto();
+	g_waitfor_event(g_iostats, sb, M_WAITOK, NULL);
+	error = SYSCTL_OUT(req, sbuf_data(sb), sbuf_len(sb) + 1);
+	sbuf_delete(sb);
+	return error;
+}
+
 static int
 sysctl_kern_geom_confdot(SYSCTL_HANDLER_ARGS)
 {
@@ -209,6 +222,10 @@ SYSCTL_PROC(_kern_geom, OID_AUTO, conftxt, CTLTYPE_STRING|CTLFLAG_RD,
 	0, 0, sysctl_kern_geom_conftxt, "",
 	"Dump the GEOM config in txt");
 
+SYSCTL_PROC(_kern_geom, OID_AUTO, iostats, CTLTYPE_STRING|CTLFLAG_RD,
+	0, 0, sysctl_kern_geom_iostats, "",
+	"Dump recent per-provider I/O records");
+
 SYSCTL_INT(_kern_geom, OID_AUTO, debugflags, CTLFLAG_RWTUN,
 	&g_debugflags, 0, "Set various trace levels for GEOM debugging");
 
@@ -78,6 +78,8 @@ __FBSDID("$FreeBSD$");
 #include <vm/pmap.h>
 #include <vm/vm_map.h>
 #include <vm/vm_object.h>
+#include <vm/vm_page.h>
+#include <vm/vm_pager.h>
 #include <vm/vm_extern.h>
 
 #include <machine/elf.h>
@@ -130,6 +132,26 @@ SYSCTL_INT(__CONCAT(_kern_elf, __ELF_WORD_SIZE), OID_AUTO,
     nxstack, CTLFLAG_RW, &__elfN(nxstack), 0,
     __XSTRING(__CONCAT(ELF, __ELF_WORD_SIZE)) ": enable non-executable stack");
 
+static int __elfN(prefault_max) = 0;
+SYSCTL_INT(__CONCAT(_kern_elf, __ELF_WORD_SIZE), OID_AUTO,
+    prefault_max, CTLFLAG_RWTUN, &__elfN(prefault_max), 0,
+    "maximum pages to prefault per segment at exec time (0 disables)");
+
+static u_long __elfN(prefault_ios);
+SYSCTL_ULONG(__CONCAT(_kern_elf, __ELF_WORD_SIZE), OID_AUTO,
+    prefault_ios, CTLFLAG_RD, &__elfN(prefault_ios), 0,
+    "asynchronous reads issued by exec-time prefault");
+
+static u_long __elfN(prefault_pages_read);
+SYSCTL_ULONG(__CONCAT(_kern_elf, __ELF_WORD_SIZE), OID_AUTO,
+    prefault_pages_read, CTLFLAG_RD, &__elfN(prefault_pages_read), 0,
+    "pages paged in by exec-time prefault");
+
+static u_long __elfN(prefault_pages_valid);
+SYSCTL_ULONG(__CONCAT(_kern_elf, __ELF_WORD_SIZE), OID_AUTO,
+    prefault_pages_valid, CTLFLAG_RD, &__elfN(prefault_pages_valid), 0,
+    "pages found already resident by exec-time prefault");
+
 #if __ELF_WORD_SIZE == 32
 #if defined(__amd64__)
 int i386_read_exec = 0;
@@ -520,6 +542,104 @@ __elfN(map_insert)(struct image_params *imgp, vm_map_t map, vm_object_t object,
 	return (KERN_SUCCESS);
 }
 
+static void
+__elfN(prefault_iodone)(void *arg, vm_page_t *ma, int count, int error)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (error == 0 && ma[i]->valid != 0)
+			vm_page_readahead_finish(ma[i]);
+		else
+			vm_page_xunbusy(ma[i]);
+	}
+}
+
+/*
+ * Opportunistically page in a file-backed segment at exec time.  The
+ * demand-fault path brings text and data in one cluster at a time, so a
+ * cold exec of a large binary takes a long train of synchronous reads.
+ * When kern.elf{32,64}.prefault_max is set, issue asynchronous clustered
+ * reads through the pager for up to that many pages per segment, so the
+ * faults taken during early execution find the pages resident or already
+ * in flight.  This is best effort: low memory simply leaves the rest of
+ * the segment to be demand paged as before.  Filesystems mounted with
+ * noclusterr are skipped.
+ */
+static void
+__elfN(prefault_section)(struct image_params *imgp, vm_ooffset_t offset,
+    size_t filsz)
+{
+	vm_page_t ma[MAXPHYS / PAGE_SIZE];
+	vm_object_t object;
+	vm_pindex_t pindex;
+	int a, c, count, grabbed, i, j, npages, rv __unused;
+
+	object = imgp->object;
+	if (object == NULL || filsz == 0 || __elfN(prefault_max) <= 0 ||
+	    (imgp->vp->v_mount != NULL &&
+	    (imgp->vp->v_mount->mnt_flag & MNT_NOCLUSTERR) != 0))
+		return;
+	pindex = OFF_TO_IDX(trunc_page(offset));
+	npages = OFF_TO_IDX(round_page(offset + filsz)) - pindex;
+	npages = min(npages, __elfN(prefault_max));
+
+	VM_OBJECT_WLOCK(object);
+	while (npages > 0) {
+		c = min(npages, (int)nitems(ma));
+		grabbed = vm_page_grab_pages(object, pindex,
+		    VM_ALLOC_NORMAL | VM_ALLOC_NOWAIT, ma, c);
+		for (i = 0; i < grabbed; ) {
+			/* Skip pages that are already fully resident. */
+			if (ma[i]->valid == VM_PAGE_BITS_ALL) {
+				vm_page_xunbusy(ma[i]);
+				__elfN(prefault_pages_valid)++;
+				i++;
+				continue;
+			}
+
+			/*
+			 * A page the pager does not have is a hole in a
+			 * sparse file and reads as zeroes.
+			 */
+			if (!vm_pager_has_page(object, ma[i]->pindex, NULL,
+			    &a)) {
+				pmap_zero_page(ma[i]);
+				ma[i]->valid = VM_PAGE_BITS_ALL;
+				vm_page_xunbusy(ma[i]);
+				i++;
+				continue;
+			}
+
+			/*
+			 * Page in the longest run of invalid pages that the
+			 * pager can supply in a single I/O, stopping at the
+			 * first valid page rather than reading over it.
+			 */
+			count = min(a + 1, grabbed - i);
+			for (j = 1; j < count; j++)
+				if (ma[i + j]->valid == VM_PAGE_BITS_ALL)
+					break;
+			count = j;
+			rv = vm_pager_get_pages_async(object, &ma[i], count,
+			    NULL, NULL, __elfN(prefault_iodone), NULL);
+			KASSERT(rv == VM_PAGER_OK,
+			    ("%s: pager fail obj %p page %p", __func__,
+			    object, ma[i]));
+			__elfN(prefault_ios)++;
+			__elfN(prefault_pages_read) += count;
+			i += count;
+		}
+		if (grabbed < c) {
+			/* Low memory; leave the rest to demand faults. */
+			break;
+		}
+		pindex += grabbed;
+		npages -= grabbed;
+	}
+	VM_OBJECT_WUNLOCK(object);
+}
+
 static int
 __elfN(load_section)(struct image_params *imgp, vm_ooffset_t offset,
     caddr_t vmaddr, size_t memsz, size_t filsz, vm_prot_t prot,
@@ -582,6 +702,8 @@ __elfN(load_section)(struct image_params *imgp, vm_ooffset_t offset,
 		if (rv != KERN_SUCCESS)
 			return (EINVAL);
 
+		__elfN(prefault_section)(imgp, file_addr, map_len);
+
 		/* we can stop now if we've covered it all */
 		if (memsz == filsz)
 			return (0);
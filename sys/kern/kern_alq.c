@@ -53,6 +53,8 @@ __FBSDID("$FreeBSD$");
 #include <sys/fcntl.h>
 #include <sys/eventhandler.h>
 
+#include <machine/cpu.h>
+
 #include <security/mac/mac_framework.h>
 
 /* Async. Logging Queue */
@@ -76,6 +78,19 @@ struct alq {
 	struct ucred	*aq_cred;	/* Credentials of the opening thread */
 	LIST_ENTRY(alq)	aq_act;		/* List of active queues */
 	LIST_ENTRY(alq)	aq_link;	/* List of all queues */
+
+	/*
+	 * Reserve-then-commit state for AQ_LOCKLESS queues.  The three
+	 * offsets increase monotonically (mod 2^32) and are mapped into
+	 * aq_entbuf with ALQ_LF_IDX(); aq_buflen is a power of two for
+	 * these queues, so that the mapping stays continuous when the
+	 * offsets wrap.
+	 */
+	uint32_t	aq_lf_reserve;	/* Next offset to reserve */
+	uint32_t	aq_lf_commit;	/* Offsets below this are copied in */
+	uint32_t	aq_lf_flushed;	/* Offsets below this are on disk */
+	u_int		aq_lf_active;	/* Queue is on the active list */
+	u_long		aq_lf_drops;	/* Writes dropped, ring was full */
 };
 
 #define	AQ_WANTED	0x0001		/* Wakeup sleeper when io is done */
@@ -84,11 +99,16 @@ struct alq {
 #define	AQ_SHUTDOWN	0x0008		/* Queue no longer valid */
 #define	AQ_ORDERED	0x0010		/* Queue enforces ordered writes */
 #define	AQ_LEGACY	0x0020		/* Legacy queue (fixed length writes) */
+#define	AQ_LOCKLESS	0x0040		/* Lock-free writers (ALQ_LOCKLESS) */
 
 #define	ALQ_LOCK(alq)	mtx_lock_spin(&(alq)->aq_mtx)
 #define	ALQ_UNLOCK(alq)	mtx_unlock_spin(&(alq)->aq_mtx)
 
-#define HAS_PENDING_DATA(alq) ((alq)->aq_freebytes != (alq)->aq_buflen)
+#define	ALQ_LF_IDX(alq, off) ((off) & ((uint32_t)(alq)->aq_buflen - 1))
+
+#define HAS_PENDING_DATA(alq) (((alq)->aq_flags & AQ_LOCKLESS) ?	\
+    ((alq)->aq_lf_commit != (alq)->aq_lf_flushed) :			\
+    ((alq)->aq_freebytes != (alq)->aq_buflen))
 
 static MALLOC_DEFINE(M_ALD, "ALD", "ALD");
 
@@ -120,6 +140,11 @@ static void alq_shutdown(struct alq *);
 static void alq_destroy(struct alq *);
 static int alq_doio(struct alq *);
 
+/* Lock-free queue functions */
+static void alq_activate_lockless(struct alq *);
+static int alq_doio_lockless(struct alq *);
+static int alq_writen_lockless(struct alq *, void *, int, int);
+
 
 /*
  * Add a new queue to the global list.  Fail if we're shutting down.
@@ -192,7 +217,7 @@ ald_startup(void *unused)
 static void
 ald_daemon(void)
 {
-	int needwakeup;
+	int needwakeup, reactivate;
 	struct alq *alq;
 
 	ald_thread = FIRST_THREAD_IN_PROC(ald_proc);
@@ -216,10 +241,33 @@ ald_daemon(void)
 		ALQ_LOCK(alq);
 		ald_deactivate(alq);
 		ALD_UNLOCK();
-		needwakeup = alq_doio(alq);
+		reactivate = 0;
+		if (alq->aq_flags & AQ_LOCKLESS) {
+			/*
+			 * Writers which commit after this point must
+			 * reactivate the queue themselves, so the fence
+			 * pairs with the one in alq_writen_lockless() to
+			 * guarantee the flush below sees every commit
+			 * made by a writer that saw the queue as active.
+			 */
+			atomic_store_rel_int(&alq->aq_lf_active, 0);
+			atomic_thread_fence_seq_cst();
+			needwakeup = alq_doio_lockless(alq);
+			/*
+			 * Note anything committed while the flush was in
+			 * flight.  This must be checked before the queue
+			 * lock is dropped: if there is no pending data,
+			 * a racing alq_shutdown() may free the queue as
+			 * soon as we release it.
+			 */
+			reactivate = HAS_PENDING_DATA(alq);
+		} else
+			needwakeup = alq_doio(alq);
 		ALQ_UNLOCK(alq);
 		if (needwakeup)
 			wakeup_one(alq);
+		if (reactivate)
+			alq_activate_lockless(alq);
 		ALD_LOCK();
 	}
 
@@ -266,12 +314,26 @@ alq_shutdown(struct alq *alq)
 	/* Stop any new writers. */
 	alq->aq_flags |= AQ_SHUTDOWN;
 
+	/*
+	 * Lock-free writers check AQ_SHUTDOWN without the queue lock; wait
+	 * for any writer that raced the flag to finish its commit before
+	 * the final flush.  The reserve-to-commit window is preemption
+	 * free, so this wait is bounded by a copy.
+	 */
+	if (alq->aq_flags & AQ_LOCKLESS) {
+		while (atomic_load_32(&alq->aq_lf_commit) !=
+		    atomic_load_32(&alq->aq_lf_reserve))
+			cpu_spinwait();
+	}
+
 	/*
 	 * If the ALQ isn't active but has unwritten data (possible if
 	 * the ALQ_NOACTIVATE flag has been used), explicitly activate the
 	 * ALQ here so that the pending data gets flushed by the ald_daemon.
 	 */
 	if (!(alq->aq_flags & AQ_ACTIVE) && HAS_PENDING_DATA(alq)) {
+		if (alq->aq_flags & AQ_LOCKLESS)
+			atomic_store_rel_int(&alq->aq_lf_active, 1);
 		alq->aq_flags |= AQ_ACTIVE;
 		ALQ_UNLOCK(alq);
 		ALD_LOCK();
@@ -413,6 +475,83 @@ alq_doio(struct alq *alq)
 	return(0);
 }
 
+/*
+ * Flush the committed portion of an AQ_LOCKLESS ring to disk.  Called
+ * with the queue lock held, which is dropped around the write.  Only the
+ * daemon (or alq_flush() after deactivating the queue) advances
+ * aq_lf_flushed, so no other flusher can race us.
+ */
+static int
+alq_doio_lockless(struct alq *alq)
+{
+	struct thread *td;
+	struct mount *mp;
+	struct vnode *vp;
+	struct uio auio;
+	struct iovec aiov[2];
+	uint32_t commit, idx;
+	int iov, totlen;
+
+	commit = atomic_load_acq_32(&alq->aq_lf_commit);
+	totlen = commit - alq->aq_lf_flushed;
+	if (totlen == 0)
+		return (0);
+
+	vp = alq->aq_vp;
+	td = curthread;
+	iov = 1;
+	idx = ALQ_LF_IDX(alq, alq->aq_lf_flushed);
+
+	bzero(&aiov, sizeof(aiov));
+	bzero(&auio, sizeof(auio));
+
+	aiov[0].iov_base = alq->aq_entbuf + idx;
+	aiov[0].iov_len = totlen;
+	if (idx + totlen > (uint32_t)alq->aq_buflen) {
+		/* Committed data wraps, requiring a second iov. */
+		aiov[0].iov_len = alq->aq_buflen - idx;
+		iov++;
+		aiov[1].iov_base = alq->aq_entbuf;
+		aiov[1].iov_len = totlen - aiov[0].iov_len;
+	}
+
+	alq->aq_flags |= AQ_FLUSHING;
+	ALQ_UNLOCK(alq);
+
+	auio.uio_iov = &aiov[0];
+	auio.uio_offset = 0;
+	auio.uio_segflg = UIO_SYSSPACE;
+	auio.uio_rw = UIO_WRITE;
+	auio.uio_iovcnt = iov;
+	auio.uio_resid = totlen;
+	auio.uio_td = td;
+
+	vn_start_write(vp, &mp, V_WAIT);
+	vn_lock(vp, LK_EXCLUSIVE | LK_RETRY);
+	/*
+	 * XXX: VOP_WRITE error checks are ignored.
+	 */
+#ifdef MAC
+	if (mac_vnode_check_write(alq->aq_cred, NOCRED, vp) == 0)
+#endif
+		VOP_WRITE(vp, &auio, IO_UNIT | IO_APPEND, alq->aq_cred);
+	VOP_UNLOCK(vp, 0);
+	vn_finished_write(mp);
+
+	ALQ_LOCK(alq);
+	alq->aq_flags &= ~AQ_FLUSHING;
+
+	/* Free the flushed region for the writers to reserve again. */
+	atomic_store_rel_32(&alq->aq_lf_flushed, commit);
+
+	if (alq->aq_flags & AQ_WANTED) {
+		alq->aq_flags &= ~AQ_WANTED;
+		return (1);
+	}
+
+	return (0);
+}
+
 static struct kproc_desc ald_kp = {
         "ALQ Daemon",
         ald_daemon,
@@ -440,6 +579,14 @@ alq_open_flags(struct alq **alqp, const char *file, struct ucred *cred, int cmod
 	int error;
 
 	KASSERT((size > 0), ("%s: size <= 0", __func__));
+	KASSERT(((flags & (ALQ_ORDERED | ALQ_LOCKLESS)) !=
+	    (ALQ_ORDERED | ALQ_LOCKLESS)),
+	    ("%s: ALQ_ORDERED and ALQ_LOCKLESS are mutually exclusive",
+	    __func__));
+
+	/* The lock-free index arithmetic needs a power of two buffer. */
+	if ((flags & ALQ_LOCKLESS) && !powerof2(size))
+		size = 1 << fls(size);
 
 	*alqp = NULL;
 	td = curthread;
@@ -470,6 +617,8 @@ alq_open_flags(struct alq **alqp, const char *file, struct ucred *cred, int cmod
 	alq->aq_writehead = alq->aq_writetail = 0;
 	if (flags & ALQ_ORDERED)
 		alq->aq_flags |= AQ_ORDERED;
+	if (flags & ALQ_LOCKLESS)
+		alq->aq_flags |= AQ_LOCKLESS;
 
 	if ((error = ald_add(alq)) != 0) {
 		alq_destroy(alq);
@@ -503,6 +652,95 @@ alq_open(struct alq **alqp, const char *file, struct ucred *cred, int cmode,
 }
 
 
+/*
+ * Put an AQ_LOCKLESS queue on the active list if nobody beat us to it.
+ * The atomic flag makes the common already-active case free of shared
+ * locks; only the writer winning the 0 -> 1 transition takes them.
+ */
+static void
+alq_activate_lockless(struct alq *alq)
+{
+	int activate;
+
+	if (atomic_load_acq_int(&alq->aq_lf_active) != 0 ||
+	    !atomic_cmpset_acq_int(&alq->aq_lf_active, 0, 1))
+		return;
+	ALD_LOCK();
+	ALQ_LOCK(alq);
+	/* alq_shutdown() may activate the queue on its own; don't race it. */
+	activate = !(alq->aq_flags & AQ_ACTIVE);
+	if (activate)
+		alq->aq_flags |= AQ_ACTIVE;
+	ALQ_UNLOCK(alq);
+	if (activate)
+		ald_activate(alq);
+	ALD_UNLOCK();
+}
+
+/*
+ * Lock-free variant of alq_writen() for AQ_LOCKLESS queues.  Space is
+ * reserved with an atomic advance of aq_lf_reserve, the copy proceeds
+ * without any shared state, and the write is published by advancing
+ * aq_lf_commit in reservation order.  Writers never sleep: if the ring
+ * cannot hold the message before the daemon catches up, the write is
+ * dropped and counted in aq_lf_drops.
+ */
+static int
+alq_writen_lockless(struct alq *alq, void *data, int len, int flags)
+{
+	uint32_t idx, res;
+	int copy;
+
+	if (alq->aq_flags & AQ_SHUTDOWN)
+		return (EWOULDBLOCK);
+
+	/*
+	 * Keep the reserve-to-commit window free of preemption and
+	 * interrupts, so that a writer can neither be descheduled while
+	 * later reservations spin waiting for its commit, nor deadlock
+	 * against an interrupt handler logging to the same queue.
+	 */
+	spinlock_enter();
+	res = alq->aq_lf_reserve;
+	for (;;) {
+		if (res + len - atomic_load_acq_32(&alq->aq_lf_flushed) >
+		    (uint32_t)alq->aq_buflen) {
+			spinlock_exit();
+			atomic_add_long(&alq->aq_lf_drops, 1);
+			return (EWOULDBLOCK);
+		}
+		if (atomic_fcmpset_32(&alq->aq_lf_reserve, &res, res + len))
+			break;
+	}
+
+	/* Copy the message, wrapping around the end of the buffer. */
+	idx = ALQ_LF_IDX(alq, res);
+	copy = len;
+	if ((uint32_t)alq->aq_buflen - idx < (uint32_t)len)
+		copy = alq->aq_buflen - idx;
+	bcopy(data, alq->aq_entbuf + idx, copy);
+	if (copy != len)
+		bcopy((uint8_t *)data + copy, alq->aq_entbuf, len - copy);
+
+	/*
+	 * Publish the write.  Commits complete in reservation order so
+	 * that the daemon only ever flushes fully copied data, so wait
+	 * out any writer that reserved ahead of us.
+	 */
+	while (atomic_load_32(&alq->aq_lf_commit) != res)
+		cpu_spinwait();
+	atomic_store_rel_32(&alq->aq_lf_commit, res + len);
+	spinlock_exit();
+
+	/* Pairs with the fence in ald_daemon(); see the comment there. */
+	atomic_thread_fence_seq_cst();
+
+	if (!(flags & ALQ_NOACTIVATE))
+		alq_activate_lockless(alq);
+
+	return (0);
+}
+
 /*
  * Copy a new entry into the queue.  If the operation would block either
  * wait or return an error depending on the value of waitok.
@@ -516,6 +754,9 @@ alq_writen(struct alq *alq, void *data, int len, int flags)
 	KASSERT((len > 0 && len <= alq->aq_buflen),
 	    ("%s: len <= 0 || len > aq_buflen", __func__));
 
+	if (alq->aq_flags & AQ_LOCKLESS)
+		return (alq_writen_lockless(alq, data, len, flags));
+
 	activate = ret = 0;
 	copy = len;
 	waitchan = NULL;
@@ -681,6 +922,9 @@ alq_getn(struct alq *alq, int len, int flags)
 
 	KASSERT((len > 0 && len <= alq->aq_buflen),
 	    ("%s: len <= 0 || len > alq->aq_buflen", __func__));
+	/* The shared get/post ALE can't tolerate concurrent writers. */
+	KASSERT(!(alq->aq_flags & AQ_LOCKLESS),
+	    ("%s: get/post unsupported on lock-free queue", __func__));
 
 	waitchan = NULL;
 
@@ -901,7 +1145,12 @@ alq_flush(struct alq *alq)
 			ald_deactivate(alq);
 
 		ALD_UNLOCK();
-		needwakeup = alq_doio(alq);
+		if (alq->aq_flags & AQ_LOCKLESS) {
+			atomic_store_rel_int(&alq->aq_lf_active, 0);
+			atomic_thread_fence_seq_cst();
+			needwakeup = alq_doio_lockless(alq);
+		} else
+			needwakeup = alq_doio(alq);
 	} else
 		ALD_UNLOCK();
 
@@ -509,8 +509,7 @@ hardclock(int cnt, int usermode)
 	}
 	if (curcpu == CPU_FIRST())
 		cpu_tick_calibration();
-	if (__predict_false(DPCPU_GET(epoch_cb_count)))
-		GROUPTASK_ENQUEUE(DPCPU_PTR(epoch_cb_task));
+	epoch_tick();
 }
 
 void
@@ -45,6 +45,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/mutex.h>
 #include <sys/proc.h>
 #include <sys/kernel.h>
+#include <sys/sbuf.h>
 #include <sys/sched.h>
 #include <sys/smp.h>
 #include <sys/sysctl.h>
@@ -110,6 +111,18 @@ static int		periodic;	/* Periodic or one-shot mode. */
 static int		want_periodic;	/* What mode to prefer. */
 TUNABLE_INT("kern.eventtimer.periodic", &want_periodic);
 
+static u_int		coalesce_us;	/* Deadline coalescing window. */
+SYSCTL_UINT(_kern_eventtimer, OID_AUTO, coalesce_us, CTLFLAG_RWTUN,
+    &coalesce_us, 0,
+    "Coalescing window in microseconds: skip reprogramming the timer for "
+    "a deadline this close before the one already programmed");
+
+/*
+ * Power of two histogram of intervals programmed into the hardware in
+ * one-shot mode: bucket n counts intervals of [2^n, 2^(n+1)) microseconds.
+ */
+#define	ET_IVAL_BUCKETS	24
+
 struct pcpu_state {
 	struct mtx	et_hw_mtx;	/* Per-CPU timer mutex. */
 	u_int		action;		/* Reconfiguration requests. */
@@ -124,6 +137,9 @@ struct pcpu_state {
 	sbintime_t	nextcallopt;	/* Next optional callout event. */
 	int		ipi;		/* This CPU needs IPI. */
 	int		idle;		/* This CPU is in idle mode. */
+	u_long		starts;		/* Hardware timer reprograms. */
+	u_long		coalesced;	/* Reprograms avoided by coalescing. */
+	u_long		ivals[ET_IVAL_BUCKETS]; /* Programmed intervals. */
 };
 
 DPCPU_DEFINE_STATIC(struct pcpu_state, timerstate);
@@ -381,13 +397,13 @@ loadtimer(sbintime_t now, int start)
 	struct pcpu_state *state;
 	sbintime_t new;
 	sbintime_t *next;
-	uint64_t tmp;
-	int eq;
+	uint64_t ival, tmp;
+	int bucket, eq;
 
-	if (timer->et_flags & ET_FLAGS_PERCPU) {
-		state = DPCPU_PTR(timerstate);
+	state = DPCPU_PTR(timerstate);
+	if (timer->et_flags & ET_FLAGS_PERCPU)
 		next = &state->nexttick;
-	} else
+	else
 		next = &nexttick;
 	if (periodic) {
 		if (start) {
@@ -403,15 +419,33 @@ loadtimer(sbintime_t now, int start)
 			    curcpu, (int)(now >> 32), (u_int)(now & 0xffffffff),
 			    (int)(new >> 32), (u_int)(new & 0xffffffff));
 			*next = new + now;
+			state->starts++;
 			et_start(timer, new, timerperiod);
 		}
 	} else {
 		new = getnextevent();
 		eq = (new == *next);
+		/*
+		 * Reprogramming for a slightly earlier deadline only buys
+		 * precision.  If the new deadline falls within the coalescing
+		 * window before the tick already programmed, let that tick
+		 * serve it up to coalesce_us late instead.
+		 */
+		if (!eq && coalesce_us != 0 && *next > now && new < *next &&
+		    *next - new <= (sbintime_t)coalesce_us * SBT_1US) {
+			state->coalesced++;
+			eq = 1;
+		}
 		CTR4(KTR_SPARE2, "load at %d:    next %d.%08x eq %d",
 		    curcpu, (int)(new >> 32), (u_int)(new & 0xffffffff), eq);
 		if (!eq) {
 			*next = new;
+			state->starts++;
+			ival = new > now ? (new - now) / SBT_1US : 0;
+			bucket = ival != 0 ? flsll(ival) - 1 : 0;
+			if (bucket >= ET_IVAL_BUCKETS)
+				bucket = ET_IVAL_BUCKETS - 1;
+			state->ivals[bucket]++;
 			et_start(timer, new - now, 0);
 		}
 	}
@@ -949,6 +983,49 @@ SYSCTL_PROC(_kern_eventtimer, OID_AUTO, periodic,
     CTLTYPE_INT | CTLFLAG_RW | CTLFLAG_MPSAFE,
     0, 0, sysctl_kern_eventtimer_periodic, "I", "Enable event timer periodic mode");
 
+/*
+ * Report the distribution of intervals programmed into the hardware,
+ * along with reprogram and coalescing counters, summed over all CPUs.
+ */
+static int
+sysctl_kern_eventtimer_intervals(SYSCTL_HANDLER_ARGS)
+{
+	struct sbuf sb;
+	struct pcpu_state *state;
+	uint64_t ivals[ET_IVAL_BUCKETS];
+	uint64_t coalesced, starts;
+	int bucket, cpu, error;
+
+	starts = coalesced = 0;
+	bzero(ivals, sizeof(ivals));
+	CPU_FOREACH(cpu) {
+		state = DPCPU_ID_PTR(cpu, timerstate);
+		starts += state->starts;
+		coalesced += state->coalesced;
+		for (bucket = 0; bucket < ET_IVAL_BUCKETS; bucket++)
+			ivals[bucket] += state->ivals[bucket];
+	}
+	sbuf_new(&sb, NULL, 512, SBUF_AUTOEXTEND | SBUF_INCLUDENUL);
+	sbuf_printf(&sb, "starts %ju coalesced %ju",
+	    (uintmax_t)starts, (uintmax_t)coalesced);
+	for (bucket = 0; bucket < ET_IVAL_BUCKETS; bucket++) {
+		if (ivals[bucket] == 0)
+			continue;
+		sbuf_printf(&sb, " %uus:%ju", 1U << bucket,
+		    (uintmax_t)ivals[bucket]);
+	}
+	error = sbuf_finish(&sb);
+	if (error == 0)
+		error = SYSCTL_OUT(req, sbuf_data(&sb), sbuf_len(&sb));
+	sbuf_delete(&sb);
+	return (error);
+}
+SYSCTL_PROC(_kern_eventtimer, OID_AUTO, intervals,
+    CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE,
+    0, 0, sysctl_kern_eventtimer_intervals, "A",
+    "Programmed one-shot interval histogram (power of two buckets, in "
+    "microseconds)");
+
 #include "opt_ddb.h"
 
 #ifdef DDB
@@ -963,11 +1040,13 @@ DB_SHOW_COMMAND(clocksource, db_show_clocksource)
 		st = DPCPU_ID_PTR(c, timerstate);
 		db_printf(
 		    "CPU %2d: action %d handle %d  ipi %d idle %d\n"
+		    "        starts %lu coalesced %lu\n"
 		    "        now %#jx nevent %#jx (%jd)\n"
 		    "        ntick %#jx (%jd) nhard %#jx (%jd)\n"
 		    "        nstat %#jx (%jd) nprof %#jx (%jd)\n"
 		    "        ncall %#jx (%jd) ncallopt %#jx (%jd)\n",
 		    c, st->action, st->handle, st->ipi, st->idle,
+		    st->starts, st->coalesced,
 		    (uintmax_t)st->now,
 		    (uintmax_t)st->nextevent,
 		    (uintmax_t)(st->nextevent - st->now) / tick_sbt,
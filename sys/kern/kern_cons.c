@@ -54,6 +54,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/fcntl.h>
 #include <sys/kdb.h>
 #include <sys/kernel.h>
+#include <sys/kthread.h>
 #include <sys/malloc.h>
 #include <sys/msgbuf.h>
 #include <sys/namei.h>
@@ -77,8 +78,15 @@ static MALLOC_DEFINE(M_TTYCONS, "tty console", "tty console handling");
 struct cn_device {
 	STAILQ_ENTRY(cn_device) cnd_next;
 	struct		consdev *cnd_cn;
+	char		*cnd_abuf;	/* async staging ring, or NULL */
+	u_int		cnd_ahead;	/* free-running producer index */
+	u_int		cnd_atail;	/* free-running consumer index */
+	u_long		cnd_adrops;	/* bytes dropped, ring full */
 };
 
+#define	CN_ASYNC_BUFSIZE	16384	/* must be a power of two */
+#define	CN_ASYNC_MASK		(CN_ASYNC_BUFSIZE - 1)
+
 #define CNDEVPATHMAX	32
 #define CNDEVTAB_SIZE	4
 static struct cn_device cn_devtab[CNDEVTAB_SIZE];
@@ -101,6 +109,17 @@ struct tty *constty;			/* pointer to console "window" tty */
 static struct mtx cnputs_mtx;		/* Mutex for cnputs(). */
 static int use_cnputs_mtx = 0;		/* != 0 if cnputs_mtx locking reqd. */
 
+static int console_async;		/* stage output, drain from a kthread */
+SYSCTL_INT(_kern, OID_AUTO, console_async, CTLFLAG_RDTUN, &console_async, 0,
+    "Buffer console output and write it from a kernel thread");
+static u_long console_async_drops;
+SYSCTL_ULONG(_kern, OID_AUTO, console_async_drops, CTLFLAG_RD,
+    &console_async_drops, 0,
+    "Console output bytes dropped due to a full staging buffer");
+static struct mtx cn_async_mtx;		/* Protects the staging rings. */
+static int cn_async_enabled;		/* Buffers and kthread are in place. */
+
+static void cn_async_flush(void);
 static void constty_timeout(void *arg);
 
 static struct consdev cons_consdev;
@@ -191,6 +210,19 @@ cnadd(struct consdev *cn)
 	if (cnd->cnd_cn != NULL)
 		return (ENOMEM);
 	cnd->cnd_cn = cn;
+	if (cn_async_enabled) {
+		/*
+		 * Discard anything staged by a previous tenant of this
+		 * slot; the buffer itself is kept across remove/add
+		 * cycles so the console thread never sees it go away.
+		 */
+		mtx_lock_spin(&cn_async_mtx);
+		cnd->cnd_atail = cnd->cnd_ahead;
+		mtx_unlock_spin(&cn_async_mtx);
+		if (cnd->cnd_abuf == NULL)
+			cnd->cnd_abuf = malloc(CN_ASYNC_BUFSIZE, M_TTYCONS,
+			    M_WAITOK);
+	}
 	if (cn->cn_name[0] == '\0') {
 		/* XXX: it is unclear if/where this print might output */
 		printf("WARNING: console at %p has no name\n", cn);
@@ -364,6 +396,8 @@ cngrab()
 	struct cn_device *cnd;
 	struct consdev *cn;
 
+	if (cn_async_enabled)
+		cn_async_flush();
 	STAILQ_FOREACH(cnd, &cn_devlist, cnd_next) {
 		cn = cnd->cnd_cn;
 		if (!kdb_active || !(cn->cn_flags & CN_FLAG_NODEBUG))
@@ -499,6 +533,33 @@ cnputc(int c)
 
 	if (cn_mute || c == '\0')
 		return;
+
+	/*
+	 * In async mode, stage the character for the console thread
+	 * instead of waiting on the hardware.  Panic, the debugger and
+	 * the boot-time pause must be synchronous; flush whatever was
+	 * staged first so no output is reordered or lost.
+	 */
+	if (cn_async_enabled) {
+		if (panicstr == NULL && !kdb_active && !console_pausing) {
+			mtx_lock_spin(&cn_async_mtx);
+			STAILQ_FOREACH(cnd, &cn_devlist, cnd_next) {
+				if (cnd->cnd_abuf == NULL ||
+				    cnd->cnd_ahead - cnd->cnd_atail >=
+				    CN_ASYNC_BUFSIZE) {
+					cnd->cnd_adrops++;
+					console_async_drops++;
+					continue;
+				}
+				cnd->cnd_abuf[cnd->cnd_ahead++ &
+				    CN_ASYNC_MASK] = c;
+			}
+			mtx_unlock_spin(&cn_async_mtx);
+			return;
+		}
+		cn_async_flush();
+	}
+
 	STAILQ_FOREACH(cnd, &cn_devlist, cnd_next) {
 		cn = cnd->cnd_cn;
 		if (!kdb_active || !(cn->cn_flags & CN_FLAG_NODEBUG)) {
@@ -552,6 +613,100 @@ cnputs(char *p)
 	cnputsn(p, strlen(p));
 }
 
+/*
+ * Asynchronous console mode.  With kern.console_async set, cnputc()
+ * stages output in a per-console ring and the console thread writes it
+ * to the hardware, so a slow console (a serial line at 115200 baud,
+ * say) no longer stalls callers of printf(9).  Each console drains and
+ * drops independently; bytes arriving at a full ring are counted in
+ * kern.console_async_drops.  Panic and debugger entry flush the rings
+ * and fall back to synchronous output.
+ */
+static void
+cn_async_flush(void)
+{
+	struct cn_device *cnd;
+	struct consdev *cn;
+	int c;
+
+	/*
+	 * If the console thread was stopped mid-drain on another CPU we
+	 * cannot take the lock; losing the staged bytes is preferable
+	 * to deadlocking on the way into panic or the debugger.
+	 */
+	if (!mtx_trylock_spin(&cn_async_mtx))
+		return;
+	STAILQ_FOREACH(cnd, &cn_devlist, cnd_next) {
+		cn = cnd->cnd_cn;
+		while (cnd->cnd_abuf != NULL &&
+		    cnd->cnd_atail != cnd->cnd_ahead) {
+			c = cnd->cnd_abuf[cnd->cnd_atail++ & CN_ASYNC_MASK];
+			if (c == '\n')
+				cn->cn_ops->cn_putc(cn, '\r');
+			cn->cn_ops->cn_putc(cn, c);
+		}
+	}
+	mtx_unlock_spin(&cn_async_mtx);
+}
+
+static void
+cn_async_kthread(void *arg __unused)
+{
+	char chunk[128];
+	struct cn_device *cnd;
+	struct consdev *cn;
+	u_int i, n;
+	int worked;
+
+	for (;;) {
+		worked = 0;
+		STAILQ_FOREACH(cnd, &cn_devlist, cnd_next) {
+			if (cnd->cnd_abuf == NULL)
+				continue;
+			/*
+			 * Pull a bounded chunk under the lock, write it
+			 * to the (possibly slow) hardware without it.
+			 */
+			mtx_lock_spin(&cn_async_mtx);
+			n = 0;
+			while (n < sizeof(chunk) &&
+			    cnd->cnd_atail != cnd->cnd_ahead)
+				chunk[n++] = cnd->cnd_abuf[cnd->cnd_atail++ &
+				    CN_ASYNC_MASK];
+			mtx_unlock_spin(&cn_async_mtx);
+			cn = cnd->cnd_cn;
+			for (i = 0; i < n; i++) {
+				if (chunk[i] == '\n')
+					cn->cn_ops->cn_putc(cn, '\r');
+				cn->cn_ops->cn_putc(cn, chunk[i]);
+			}
+			worked += n;
+		}
+		if (worked == 0)
+			tsleep(&cn_async_enabled, PWAIT, "cnaidl", hz / 10);
+	}
+}
+
+static void
+cn_async_init(void *unused)
+{
+	struct cn_device *cnd;
+	struct proc *p;
+
+	if (!console_async)
+		return;
+	mtx_init(&cn_async_mtx, "cn_async_mtx", NULL,
+	    MTX_SPIN | MTX_NOWITNESS);
+	STAILQ_FOREACH(cnd, &cn_devlist, cnd_next)
+		cnd->cnd_abuf = malloc(CN_ASYNC_BUFSIZE, M_TTYCONS, M_WAITOK);
+	if (kproc_create(cn_async_kthread, NULL, &p, 0, 0, "consoled") != 0) {
+		printf("failed to start the console thread\n");
+		return;
+	}
+	cn_async_enabled = 1;
+}
+SYSINIT(cnasync, SI_SUB_KTHREAD_IDLE, SI_ORDER_ANY, cn_async_init, NULL);
+
 static int consmsgbuf_size = 8192;
 SYSCTL_INT(_kern, OID_AUTO, consmsgbuf_size, CTLFLAG_RW, &consmsgbuf_size, 0,
     "Console tty buffer size");
@@ -37,8 +37,10 @@ __FBSDID("$FreeBSD$");
 #include <sys/lock.h>
 #include <sys/malloc.h>
 #include <sys/module.h>
+#include <sys/pcpu.h>
 #include <sys/proc.h>
 #include <sys/queue.h>
+#include <sys/resource.h>
 #include <sys/sbuf.h>
 #include <sys/sched.h>
 #include <sys/smp.h>
@@ -116,6 +118,9 @@ static struct cf_level *cpufreq_dup_set(struct cpufreq_softc *sc,
 static int	cpufreq_curr_sysctl(SYSCTL_HANDLER_ARGS);
 static int	cpufreq_levels_sysctl(SYSCTL_HANDLER_ARGS);
 static int	cpufreq_settings_sysctl(SYSCTL_HANDLER_ARGS);
+static int	cpufreq_gov_sample(void);
+static void	cpufreq_gov_task_fn(void *arg, int pending);
+static int	cpufreq_gov_busy_sysctl(SYSCTL_HANDLER_ARGS);
 
 static device_method_t cpufreq_methods[] = {
 	DEVMETHOD(device_probe,		bus_generic_probe),
@@ -142,6 +147,49 @@ SYSCTL_INT(_debug_cpufreq, OID_AUTO, lowest, CTLFLAG_RWTUN, &cf_lowest_freq, 1,
 SYSCTL_INT(_debug_cpufreq, OID_AUTO, verbose, CTLFLAG_RWTUN, &cf_verbose, 1,
     "Print verbose debugging messages");
 
+/*
+ * Optional in-kernel load-responsive governor.  When enabled, a periodic
+ * task samples per-CPU time statistics and ramps the frequency directly
+ * from kernel context, reacting within one sampling period instead of the
+ * multi-hundred-millisecond polling cycle of a userland daemon.  Under
+ * load it jumps straight to the fastest level so ramp-up latency is one
+ * period; when idle it drifts down one level at a time.  Levels are
+ * applied with CPUFREQ_PRIO_USER, so it should not be enabled together
+ * with powerd(8).
+ */
+static int		cf_gov_enable;
+static int		cf_gov_interval = 50;	/* Sampling period, in ms. */
+static int		cf_gov_up_load = 75;
+static int		cf_gov_down_load = 25;
+static int		cf_gov_curr_freq;
+static u_long		cf_gov_ramps_up;
+static u_long		cf_gov_ramps_down;
+static long		*cf_gov_cp_prev;	/* Last cp_time, per CPU. */
+static int		*cf_gov_busy;		/* Last busy %, per CPU. */
+static struct cf_level	*cf_gov_levels;
+static struct timeout_task cf_gov_task;
+
+SYSCTL_INT(_debug_cpufreq, OID_AUTO, governor, CTLFLAG_RWTUN, &cf_gov_enable,
+    0, "Enable the in-kernel load-responsive frequency governor");
+SYSCTL_INT(_debug_cpufreq, OID_AUTO, governor_interval, CTLFLAG_RWTUN,
+    &cf_gov_interval, 0, "Governor sampling period (ms)");
+SYSCTL_INT(_debug_cpufreq, OID_AUTO, governor_up_load, CTLFLAG_RWTUN,
+    &cf_gov_up_load, 0,
+    "Busy percentage above which the governor selects the fastest level");
+SYSCTL_INT(_debug_cpufreq, OID_AUTO, governor_down_load, CTLFLAG_RWTUN,
+    &cf_gov_down_load, 0,
+    "Busy percentage below which the governor steps one level down");
+SYSCTL_INT(_debug_cpufreq, OID_AUTO, governor_freq, CTLFLAG_RD,
+    &cf_gov_curr_freq, 0, "Frequency last requested by the governor");
+SYSCTL_ULONG(_debug_cpufreq, OID_AUTO, governor_ramps_up, CTLFLAG_RD,
+    &cf_gov_ramps_up, 0, "Number of governor transitions to a faster level");
+SYSCTL_ULONG(_debug_cpufreq, OID_AUTO, governor_ramps_down, CTLFLAG_RD,
+    &cf_gov_ramps_down, 0, "Number of governor transitions to a slower level");
+SYSCTL_PROC(_debug_cpufreq, OID_AUTO, governor_busy,
+    CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+    cpufreq_gov_busy_sysctl, "A",
+    "Busy percentage per CPU from the governor's last sample");
+
 static int
 cpufreq_attach(device_t dev)
 {
@@ -1011,6 +1059,163 @@ out:
 	return (error);
 }
 
+/*
+ * Sample the per-CPU time counters accumulated since the last call and
+ * return the busy percentage of the busiest CPU.  Sizing for the busiest
+ * CPU rather than the average keeps single-threaded work at full speed.
+ */
+static int
+cpufreq_gov_sample(void)
+{
+	struct pcpu *pcpu;
+	long delta, *prev, total;
+	int busy, c, i, maxbusy;
+
+	maxbusy = 0;
+	CPU_FOREACH(c) {
+		pcpu = pcpu_find(c);
+		prev = cf_gov_cp_prev + c * CPUSTATES;
+		busy = 0;
+		total = 0;
+		for (i = 0; i < CPUSTATES; i++) {
+			delta = pcpu->pc_cp_time[i] - prev[i];
+			prev[i] = pcpu->pc_cp_time[i];
+			total += delta;
+			if (i != CP_IDLE)
+				busy += delta;
+		}
+		if (total > 0)
+			busy = busy * 100 / total;
+		cf_gov_busy[c] = busy;
+		if (busy > maxbusy)
+			maxbusy = busy;
+	}
+	return (maxbusy);
+}
+
+static void
+cpufreq_gov_task_fn(void *arg, int pending)
+{
+	struct cf_level *levels;
+	device_t *devs;
+	int best, bdiff, busy, count, cur, devcount, diff, error, i, n;
+	int freq, period;
+
+	devs = NULL;
+	if (!cf_gov_enable)
+		goto out;
+	busy = cpufreq_gov_sample();
+
+	/*
+	 * As with the freq sysctl, use the first device's levels to pick a
+	 * target frequency and then apply the nearest level on every CPU.
+	 */
+	error = devclass_get_devices(cpufreq_dc, &devs, &devcount);
+	if (error || devcount == 0)
+		goto out;
+	levels = cf_gov_levels;
+	count = CF_MAX_LEVELS;
+	error = CPUFREQ_LEVELS(devs[0], levels, &count);
+	if (error || count == 0)
+		goto out;
+
+	/* Find the level closest to the frequency we last requested. */
+	if (cf_gov_curr_freq == 0)
+		cf_gov_curr_freq = levels[0].total_set.freq;
+	cur = 0;
+	bdiff = 1 << 30;
+	for (i = 0; i < count; i++) {
+		diff = abs(levels[i].total_set.freq - cf_gov_curr_freq);
+		if (diff < bdiff) {
+			bdiff = diff;
+			cur = i;
+		}
+	}
+
+	/* Levels are sorted fastest-first. */
+	if (busy > cf_gov_up_load)
+		best = 0;
+	else if (busy < cf_gov_down_load && cur < count - 1)
+		best = cur + 1;
+	else
+		best = cur;
+	if (best == cur)
+		goto out;
+	freq = levels[best].total_set.freq;
+	CF_DEBUG("governor: %d%% busy, ramping %d -> %d MHz\n", busy,
+	    cf_gov_curr_freq, freq);
+	if (best < cur)
+		cf_gov_ramps_up++;
+	else
+		cf_gov_ramps_down++;
+	for (n = 0; n < devcount; n++) {
+		count = CF_MAX_LEVELS;
+		if (CPUFREQ_LEVELS(devs[n], levels, &count) != 0 || count == 0)
+			continue;
+		best = 0;
+		bdiff = 1 << 30;
+		for (i = 0; i < count; i++) {
+			diff = abs(levels[i].total_set.freq - freq);
+			if (diff < bdiff) {
+				bdiff = diff;
+				best = i;
+			}
+		}
+		(void)CPUFREQ_SET(devs[n], &levels[best], CPUFREQ_PRIO_USER);
+	}
+	cf_gov_curr_freq = freq;
+
+out:
+	if (devs)
+		free(devs, M_TEMP);
+
+	/* Poll slowly while disabled so that re-enabling takes effect. */
+	period = cf_gov_enable ? cf_gov_interval : 1000;
+	if (period < 10)
+		period = 10;
+	taskqueue_enqueue_timeout(taskqueue_thread, &cf_gov_task,
+	    MAX(1, period * hz / 1000));
+}
+
+static int
+cpufreq_gov_busy_sysctl(SYSCTL_HANDLER_ARGS)
+{
+	struct sbuf sb;
+	int c, error;
+
+	if (cf_gov_busy == NULL)
+		return (ENXIO);
+	sbuf_new(&sb, NULL, 128, SBUF_AUTOEXTEND);
+	CPU_FOREACH(c)
+		sbuf_printf(&sb, "%d ", cf_gov_busy[c]);
+	sbuf_trim(&sb);
+	sbuf_finish(&sb);
+	error = sysctl_handle_string(oidp, sbuf_data(&sb), sbuf_len(&sb), req);
+	sbuf_delete(&sb);
+	return (error);
+}
+
+static void
+cpufreq_gov_init(void *arg)
+{
+
+	cf_gov_cp_prev = malloc((mp_maxid + 1) * CPUSTATES *
+	    sizeof(*cf_gov_cp_prev), M_DEVBUF, M_WAITOK | M_ZERO);
+	cf_gov_busy = malloc((mp_maxid + 1) * sizeof(*cf_gov_busy), M_DEVBUF,
+	    M_WAITOK | M_ZERO);
+	cf_gov_levels = malloc(CF_MAX_LEVELS * sizeof(*cf_gov_levels),
+	    M_DEVBUF, M_WAITOK);
+
+	/*
+	 * CPUFREQ_SET may sleep, so run the governor from the thread
+	 * taskqueue rather than from callout context.
+	 */
+	TIMEOUT_TASK_INIT(taskqueue_thread, &cf_gov_task, 0,
+	    cpufreq_gov_task_fn, NULL);
+	taskqueue_enqueue_timeout(taskqueue_thread, &cf_gov_task, hz);
+}
+SYSINIT(cpufreq_gov, SI_SUB_LAST, SI_ORDER_ANY, cpufreq_gov_init, NULL);
+
 int
 cpufreq_register(device_t dev)
 {
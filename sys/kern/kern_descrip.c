@@ -2697,6 +2697,53 @@ fget_unlocked(struct filedesc *fdp, int fd, cap_rights_t *needrightsp,
 	return (0);
 }
 
+/*
+ * Look up a file without taking a reference on it.
+ *
+ * This is only safe when the descriptor table has exactly one user: a
+ * single-threaded process with an unshared table.  Nothing can close
+ * the descriptor behind our back for the duration of the syscall, so
+ * the f_count manipulation, which dirties a cache line shared with
+ * other processes holding the file, can be elided.  The caller must
+ * pair this with fput_only_user() and must not let the file pointer
+ * escape the syscall.
+ */
+int
+fget_only_user(struct filedesc *fdp, int fd, cap_rights_t *needrightsp,
+    struct file **fpp)
+{
+	const struct fdescenttbl *fdt;
+	struct file *fp;
+#ifdef CAPABILITIES
+	int error;
+#endif
+
+	MPASS(FILEDESC_IS_ONLY_USER(fdp));
+
+	fdt = fdp->fd_files;
+	if (__predict_false((u_int)fd >= fdt->fdt_nfiles))
+		return (EBADF);
+	fp = fdt->fdt_ofiles[fd].fde_file;
+	if (__predict_false(fp == NULL))
+		return (EBADF);
+#ifdef CAPABILITIES
+	error = cap_check(cap_rights_fde_inline(&fdt->fdt_ofiles[fd]),
+	    needrightsp);
+	if (__predict_false(error != 0))
+		return (error);
+#endif
+	*fpp = fp;
+	return (0);
+}
+
+void
+fput_only_user(struct filedesc *fdp, struct file *fp)
+{
+
+	MPASS(FILEDESC_IS_ONLY_USER(fdp));
+	MPASS(fp->f_count > 0);
+}
+
 /*
  * Extract the file pointer associated with the specified descriptor for the
  * current user process.
@@ -360,7 +360,7 @@ static struct {
 	{ &fs_filtops, 1 },			/* EVFILT_FS */
 	{ &null_filtops },			/* EVFILT_LIO */
 	{ &user_filtops, 1 },			/* EVFILT_USER */
-	{ &null_filtops },			/* EVFILT_SENDFILE */
+	{ &file_filtops, 1 },			/* EVFILT_SENDFILE */
 	{ &file_filtops, 1 },                   /* EVFILT_EMPTY */
 };
 
@@ -677,10 +677,203 @@ timer2sbintime(intptr_t data, int flags)
 
 struct kq_timer_cb_data {
 	struct callout c;
+	struct knote *kn;	/* backpointer for batched delivery */
+	struct kq_timer_bucket *kb;	/* bucket when coalesced, else NULL */
+	TAILQ_ENTRY(kq_timer_cb_data) link;
 	sbintime_t next;	/* next timer event fires at */
 	sbintime_t to;		/* precalculated timer period, 0 for abs */
+	sbintime_t slop;	/* coalescing slot width, 0 for exact */
 };
 
+/*
+ * Coalescing support.  Timers registered with NOTE_COALESCE may fire up
+ * to a caller-specified slop (ext[0], in the timer's units) late; their
+ * deadlines are rounded up to a multiple of the slop and all timers
+ * landing on the same rounded deadline share a single callout and are
+ * delivered as one batch.  Workloads holding very large numbers of
+ * loose timeouts (per-connection idle timers and the like) then arm a
+ * handful of callouts instead of one per timer.  Emptied buckets are
+ * kept on an idle list for reuse, so steady state allocates nothing.
+ */
+struct kq_timer_bucket {
+	struct callout	kb_c;
+	sbintime_t	kb_deadline;
+	int		kb_count;
+	bool		kb_onidle;
+	LIST_ENTRY(kq_timer_bucket) kb_hash;
+	TAILQ_HEAD(, kq_timer_cb_data) kb_list;
+};
+
+#define	KQ_TIMER_BUCKET_HASH	128
+static LIST_HEAD(, kq_timer_bucket) kq_timer_buckets[KQ_TIMER_BUCKET_HASH];
+static LIST_HEAD(, kq_timer_bucket) kq_timer_buckets_idle =
+    LIST_HEAD_INITIALIZER(kq_timer_buckets_idle);
+static struct mtx kq_timer_coalesce_mtx;
+MTX_SYSINIT(kq_timer_coalesce, &kq_timer_coalesce_mtx, "kqtimerco",
+    MTX_DEF);
+
+static unsigned int kq_timer_coalesced;
+SYSCTL_UINT(_kern, OID_AUTO, kq_timer_coalesced, CTLFLAG_RD,
+    &kq_timer_coalesced, 0, "Number of armed coalesced kqueue timers");
+static u_long kq_timer_batches;
+SYSCTL_ULONG(_kern, OID_AUTO, kq_timer_batches, CTLFLAG_RD,
+    &kq_timer_batches, 0,
+    "Number of coalesced kqueue timer batches fired");
+static u_long kq_timer_batched_events;
+SYSCTL_ULONG(_kern, OID_AUTO, kq_timer_batched_events, CTLFLAG_RD,
+    &kq_timer_batched_events, 0,
+    "Number of kqueue timer events delivered in batches");
+static int kq_timer_coalesce_slop = 100;
+SYSCTL_INT(_kern, OID_AUTO, kq_timer_coalesce_slop, CTLFLAG_RWTUN,
+    &kq_timer_coalesce_slop, 0,
+    "Default slop for NOTE_COALESCE timers with no slop given, in "
+    "milliseconds");
+
+static void	kq_timer_bucket_expire(void *arg);
+
+static u_int
+kq_timer_bucket_hashidx(sbintime_t deadline)
+{
+
+	return ((((uint64_t)deadline * 11400714819323198485ULL) >> 32) &
+	    (KQ_TIMER_BUCKET_HASH - 1));
+}
+
+static struct kq_timer_bucket *
+kq_timer_bucket_alloc(int mflags)
+{
+	struct kq_timer_bucket *kb;
+
+	kb = malloc(sizeof(*kb), M_KQUEUE, mflags | M_ZERO);
+	if (kb != NULL)
+		callout_init_mtx(&kb->kb_c, &kq_timer_coalesce_mtx, 0);
+	return (kb);
+}
+
+/*
+ * Insert a coalesced timer into the bucket for its rounded deadline,
+ * arming the bucket's callout on first use.  A sleeping caller passes a
+ * preallocated bucket via 'kbnewp', which is consumed only if needed;
+ * with no spare and no idle bucket an M_NOWAIT allocation is attempted.
+ * Returns false if a bucket could not be found or created, in which
+ * case the caller falls back to a per-knote callout.
+ */
+static bool
+kq_timer_insert(struct kq_timer_cb_data *kc, struct kq_timer_bucket **kbnewp)
+{
+	struct kq_timer_bucket *kb;
+	sbintime_t deadline;
+	u_int h;
+
+	mtx_assert(&kq_timer_coalesce_mtx, MA_OWNED);
+	deadline = kc->next + kc->slop - 1;
+	deadline -= deadline % kc->slop;
+	if (deadline <= sbinuptime())
+		deadline += kc->slop;
+	h = kq_timer_bucket_hashidx(deadline);
+	LIST_FOREACH(kb, &kq_timer_buckets[h], kb_hash) {
+		if (kb->kb_deadline == deadline)
+			break;
+	}
+	if (kb == NULL) {
+		if ((kb = LIST_FIRST(&kq_timer_buckets_idle)) != NULL) {
+			LIST_REMOVE(kb, kb_hash);
+			kb->kb_onidle = false;
+		} else if (kbnewp != NULL && *kbnewp != NULL) {
+			kb = *kbnewp;
+			*kbnewp = NULL;
+		} else {
+			kb = kq_timer_bucket_alloc(M_NOWAIT);
+			if (kb == NULL)
+				return (false);
+		}
+		kb->kb_deadline = deadline;
+		kb->kb_count = 0;
+		TAILQ_INIT(&kb->kb_list);
+		LIST_INSERT_HEAD(&kq_timer_buckets[h], kb, kb_hash);
+		callout_reset_sbt_on(&kb->kb_c, deadline, kc->slop,
+		    kq_timer_bucket_expire, kb, PCPU_GET(cpuid), C_ABSOLUTE);
+	}
+	TAILQ_INSERT_TAIL(&kb->kb_list, kc, link);
+	kb->kb_count++;
+	kc->kb = kb;
+	kq_timer_coalesced++;
+	return (true);
+}
+
+static void
+kq_timer_remove(struct kq_timer_cb_data *kc)
+{
+	struct kq_timer_bucket *kb;
+
+	mtx_assert(&kq_timer_coalesce_mtx, MA_OWNED);
+	kb = kc->kb;
+	if (kb == NULL)
+		return;
+	TAILQ_REMOVE(&kb->kb_list, kc, link);
+	kb->kb_count--;
+	kc->kb = NULL;
+	kq_timer_coalesced--;
+	if (kb->kb_count == 0 && !kb->kb_onidle) {
+		callout_stop(&kb->kb_c);
+		LIST_REMOVE(kb, kb_hash);
+		LIST_INSERT_HEAD(&kq_timer_buckets_idle, kb, kb_hash);
+		kb->kb_onidle = true;
+	}
+}
+
+/*
+ * Deliver every timer in the bucket in one batch.  Runs with the
+ * coalesce mutex held, courtesy of callout_init_mtx().
+ */
+static void
+kq_timer_bucket_expire(void *arg)
+{
+	struct kq_timer_bucket *kb;
+	struct kq_timer_cb_data *kc;
+	struct knote *kn;
+	u_long n;
+
+	kb = arg;
+	mtx_assert(&kq_timer_coalesce_mtx, MA_OWNED);
+	/*
+	 * The bucket may have been emptied and re-armed for a later
+	 * deadline while this invocation waited for the mutex; the
+	 * rescheduled callout will come back for it.
+	 */
+	if (kb->kb_deadline > sbinuptime())
+		return;
+	n = 0;
+	while ((kc = TAILQ_FIRST(&kb->kb_list)) != NULL) {
+		TAILQ_REMOVE(&kb->kb_list, kc, link);
+		kb->kb_count--;
+		kc->kb = NULL;
+		kq_timer_coalesced--;
+		kn = kc->kn;
+		kn->kn_data++;
+		KNOTE_ACTIVATE(kn, 0);
+		n++;
+		if ((kn->kn_flags & EV_ONESHOT) != 0 || kc->to == 0)
+			continue;
+		kc->next += kc->to;
+		/*
+		 * Re-bucket periodic timers; if that fails under memory
+		 * pressure, fall back to an exact per-knote callout.
+		 */
+		if (!kq_timer_insert(kc, NULL))
+			callout_reset_sbt_on(&kc->c, kc->next, 0,
+			    filt_timerexpire, kn, PCPU_GET(cpuid),
+			    C_ABSOLUTE);
+	}
+	kq_timer_batches++;
+	kq_timer_batched_events += n;
+	if (kb->kb_count == 0 && !kb->kb_onidle) {
+		LIST_REMOVE(kb, kb_hash);
+		LIST_INSERT_HEAD(&kq_timer_buckets_idle, kb, kb_hash);
+		kb->kb_onidle = true;
+	}
+}
+
 static void
 filt_timerexpire(void *knx)
 {
@@ -716,9 +909,14 @@ filt_timervalidate(struct knote *kn, sbintime_t *to)
 		kn->kn_sdata = 1;
 	/*
 	 * The only fflags values supported are the timer unit
-	 * (precision) and the absolute time indicator.
+	 * (precision), the absolute time indicator and the coalescing
+	 * request.
 	 */
-	if ((kn->kn_sfflags & ~(NOTE_TIMER_PRECMASK | NOTE_ABSTIME)) != 0)
+	if ((kn->kn_sfflags & ~(NOTE_TIMER_PRECMASK | NOTE_ABSTIME |
+	    NOTE_COALESCE)) != 0)
+		return (EINVAL);
+	if ((kn->kn_sfflags & NOTE_COALESCE) != 0 &&
+	    (int64_t)kn->kn_kevent.ext[0] < 0)
 		return (EINVAL);
 
 	*to = timer2sbintime(kn->kn_sdata, kn->kn_sfflags);
@@ -754,6 +952,9 @@ filt_timerattach(struct knote *kn)
 		kn->kn_flags |= EV_CLEAR;	/* automatically set */
 	kn->kn_status &= ~KN_DETACHED;		/* knlist_add clears it */
 	kn->kn_ptr.p_v = kc = malloc(sizeof(*kc), M_KQUEUE, M_WAITOK);
+	kc->kn = kn;
+	kc->kb = NULL;
+	kc->slop = 0;
 	callout_init(&kc->c, 1);
 	filt_timerstart(kn, to);
 
@@ -763,6 +964,7 @@ filt_timerattach(struct knote *kn)
 static void
 filt_timerstart(struct knote *kn, sbintime_t to)
 {
+	struct kq_timer_bucket *kbnew;
 	struct kq_timer_cb_data *kc;
 
 	kc = kn->kn_ptr.p_v;
@@ -773,6 +975,25 @@ filt_timerstart(struct knote *kn, sbintime_t to)
 		kc->next = to + sbinuptime();
 		kc->to = to;
 	}
+	if ((kn->kn_sfflags & NOTE_COALESCE) != 0) {
+		kc->slop = kn->kn_kevent.ext[0] != 0 ?
+		    timer2sbintime(kn->kn_kevent.ext[0], kn->kn_sfflags) :
+		    timer2sbintime(kq_timer_coalesce_slop, NOTE_MSECONDS);
+		if (kc->slop > 0) {
+			kbnew = NULL;
+			mtx_lock(&kq_timer_coalesce_mtx);
+			while (!kq_timer_insert(kc, &kbnew)) {
+				mtx_unlock(&kq_timer_coalesce_mtx);
+				kbnew = kq_timer_bucket_alloc(M_WAITOK);
+				mtx_lock(&kq_timer_coalesce_mtx);
+			}
+			mtx_unlock(&kq_timer_coalesce_mtx);
+			if (kbnew != NULL)
+				free(kbnew, M_KQUEUE);
+			return;
+		}
+		kc->slop = 0;
+	}
 	callout_reset_sbt_on(&kc->c, kc->next, 0, filt_timerexpire, kn,
 	    PCPU_GET(cpuid), C_ABSOLUTE);
 }
@@ -784,6 +1005,11 @@ filt_timerdetach(struct knote *kn)
 	unsigned int old __unused;
 
 	kc = kn->kn_ptr.p_v;
+	if (kc->slop != 0) {
+		mtx_lock(&kq_timer_coalesce_mtx);
+		kq_timer_remove(kc);
+		mtx_unlock(&kq_timer_coalesce_mtx);
+	}
 	callout_drain(&kc->c);
 	free(kc, M_KQUEUE);
 	old = atomic_fetchadd_int(&kq_ncallouts, -1);
@@ -805,6 +1031,14 @@ filt_timertouch(struct knote *kn, struct kevent *kev, u_long type)
 		if (kev->flags & EV_ADD) {
 			kc = kn->kn_ptr.p_v;
 
+			/* Leave any coalescing bucket. */
+			if (kc->slop != 0) {
+				mtx_lock(&kq_timer_coalesce_mtx);
+				kq_timer_remove(kc);
+				mtx_unlock(&kq_timer_coalesce_mtx);
+				kc->slop = 0;
+			}
+
 			/* Drain any existing callout. */
 			callout_drain(&kc->c);
 
@@ -835,6 +1069,7 @@ filt_timertouch(struct knote *kn, struct kevent *kev, u_long type)
 			/* Reschedule timer based on new data/fflags */
 			kn->kn_sfflags = kev->fflags;
 			kn->kn_sdata = kev->data;
+			kn->kn_kevent.ext[0] = kev->ext[0];
 			error = filt_timervalidate(kn, &to);
 			if (error != 0) {
 			  	kn->kn_flags |= EV_ERROR;
@@ -1214,6 +1449,48 @@ kern_kevent(struct thread *td, int fd, int nchanges, int nevents,
 	return (error);
 }
 
+/*
+ * Size the kqueue's knote tables for every EV_ADD in a batch of changes
+ * before applying them.  Growing the fd table once to the largest ident
+ * in the batch costs a single allocation and lock acquisition where the
+ * per-change expansion in kqueue_register() would pay one per change;
+ * the latter then reduces to an unlocked size check.  Only the built-in
+ * filters can be examined without taking the filterops lock; changes
+ * using loadable filters are left for kqueue_register() to size as
+ * before.  Allocation failures are ignored here and rediscovered per
+ * change, so that errors are still reported against the kevent that
+ * provoked them.
+ */
+static void
+kqueue_batch_expand(struct kqueue *kq, struct kevent *changes, int n)
+{
+	struct filterops *fops;
+	struct kevent *kevp;
+	uintptr_t maxfd;
+	int i, filt, needhash;
+
+	maxfd = 0;
+	needhash = 0;
+	for (i = 0; i < n; i++) {
+		kevp = &changes[i];
+		filt = kevp->filter;
+		if ((kevp->flags & EV_ADD) == 0 || filt >= 0 ||
+		    filt + EVFILT_SYSCOUNT < 0 ||
+		    !sysfilt_ops[~filt].for_nolock)
+			continue;
+		fops = sysfilt_ops[~filt].for_fop;
+		if (fops->f_isfd) {
+			if (kevp->ident <= INT_MAX && kevp->ident + 1 > maxfd)
+				maxfd = kevp->ident + 1;
+		} else
+			needhash = 1;
+	}
+	if (maxfd != 0)
+		(void)kqueue_expand(kq, &file_filtops, maxfd - 1, M_WAITOK);
+	if (needhash)
+		(void)kqueue_expand(kq, &user_filtops, 0, M_WAITOK);
+}
+
 static int
 kqueue_kevent(struct kqueue *kq, struct thread *td, int nchanges, int nevents,
     struct kevent_copyops *k_ops, const struct timespec *timeout)
@@ -1229,6 +1506,7 @@ kqueue_kevent(struct kqueue *kq, struct thread *td, int nchanges, int nevents,
 		if (error)
 			return (error);
 		changes = keva;
+		kqueue_batch_expand(kq, changes, n);
 		for (i = 0; i < n; i++) {
 			kevp = &changes[i];
 			if (!kevp->filter)
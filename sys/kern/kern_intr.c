@@ -50,6 +50,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/proc.h>
 #include <sys/random.h>
 #include <sys/resourcevar.h>
+#include <sys/sbuf.h>
 #include <sys/sched.h>
 #include <sys/smp.h>
 #include <sys/sysctl.h>
@@ -95,6 +96,12 @@ static int intr_storm_threshold = 1000;
 SYSCTL_INT(_hw, OID_AUTO, intr_storm_threshold, CTLFLAG_RWTUN,
     &intr_storm_threshold, 0,
     "Number of consecutive interrupts before storm protection is enabled");
+static int intr_balance;
+SYSCTL_INT(_hw, OID_AUTO, intr_balance, CTLFLAG_RWTUN, &intr_balance, 0,
+    "Seconds between interrupt load rebalancing passes (0 disables)");
+static u_long intr_balance_moves;
+SYSCTL_ULONG(_hw, OID_AUTO, intr_balance_moves, CTLFLAG_RD,
+    &intr_balance_moves, 0, "Interrupt bindings changed by the balancer");
 static TAILQ_HEAD(, intr_event) event_list =
     TAILQ_HEAD_INITIALIZER(event_list);
 static struct mtx event_lock;
@@ -390,7 +397,7 @@ intr_setaffinity(int irq, int mode, void *m)
 {
 	struct intr_event *ie;
 	cpuset_t *mask;
-	int cpu, n;
+	int cpu, error, n;
 
 	mask = m;
 	cpu = NOCPU;
@@ -412,14 +419,32 @@ intr_setaffinity(int irq, int mode, void *m)
 		return (ESRCH);
 	switch (mode) {
 	case CPU_WHICH_IRQ:
-		return (intr_event_bind(ie, cpu));
+		error = intr_event_bind(ie, cpu);
+		break;
 	case CPU_WHICH_INTRHANDLER:
-		return (intr_event_bind_irqonly(ie, cpu));
+		error = intr_event_bind_irqonly(ie, cpu);
+		break;
 	case CPU_WHICH_ITHREAD:
-		return (intr_event_bind_ithread(ie, cpu));
+		error = intr_event_bind_ithread(ie, cpu);
+		break;
 	default:
 		return (EINVAL);
 	}
+	if (error == 0) {
+		/*
+		 * An explicit binding overrides the balancer; unbinding
+		 * makes the event eligible for balancing again.
+		 */
+		mtx_lock(&ie->ie_lock);
+		if (cpu == NOCPU)
+			ie->ie_flags &= ~(IE_PINNED | IE_BALANCED);
+		else {
+			ie->ie_flags |= IE_PINNED;
+			ie->ie_flags &= ~IE_BALANCED;
+		}
+		mtx_unlock(&ie->ie_lock);
+	}
+	return (error);
 }
 
 int
@@ -1049,13 +1074,18 @@ intr_event_execute_handlers(struct proc *p, struct intr_event *ie)
 static void
 ithread_execute_handlers(struct proc *p, struct intr_event *ie)
 {
+	uint64_t cycles;
 
+	cycles = cpu_ticks();
 	/* Interrupt handlers should not sleep. */
 	if (!(ie->ie_flags & IE_SOFT))
 		THREAD_NO_SLEEPING();
 	intr_event_execute_handlers(p, ie);
 	if (!(ie->ie_flags & IE_SOFT))
 		THREAD_SLEEPING_OK();
+	ie->ie_cycles += cpu_ticks() - cycles;
+	if (ie->ie_flags & IE_SOFT)
+		ie->ie_dispatches++;
 
 	/*
 	 * Interrupt storm handling:
@@ -1178,6 +1208,7 @@ intr_event_handle(struct intr_event *ie, struct trapframe *frame)
 	struct intr_handler *ih;
 	struct trapframe *oldframe;
 	struct thread *td;
+	uint64_t cycles;
 	int ret, thread;
 	int phase;
 
@@ -1204,6 +1235,9 @@ intr_event_handle(struct intr_event *ie, struct trapframe *frame)
 	oldframe = td->td_intr_frame;
 	td->td_intr_frame = frame;
 
+	ie->ie_dispatches++;
+	cycles = cpu_ticks();
+
 	phase = ie->ie_phase;
 	atomic_add_int(&ie->ie_active[phase], 1);
 
@@ -1252,6 +1286,8 @@ intr_event_handle(struct intr_event *ie, struct trapframe *frame)
 	}
 	atomic_add_rel_int(&ie->ie_active[phase], -1);
 
+	ie->ie_cycles += cpu_ticks() - cycles;
+
 	td->td_intr_frame = oldframe;
 
 	if (thread) {
@@ -1274,6 +1310,131 @@ intr_event_handle(struct intr_event *ie, struct trapframe *frame)
 	return (0);
 }
 
+/*
+ * Dynamic interrupt-to-CPU rebalancing.
+ *
+ * When hw.intr_balance is non-zero, a housekeeping thread periodically
+ * compares the cpu_ticks() consumed by each hardware interrupt event
+ * against per-CPU idle time from the statclock, and migrates at most one
+ * binding per pass from the busiest interrupt source onto the idlest CPU.
+ * Events bound explicitly through cpuset(2) are marked IE_PINNED and are
+ * never touched; unbound events and events the balancer placed itself
+ * (IE_BALANCED) are fair game.
+ */
+static struct proc *intr_balance_proc;
+
+static void
+intr_balance_pass(void)
+{
+	static long idlesnap[MAXCPU];
+	static uint64_t cpuload[MAXCPU];
+	static int primed;
+	struct intr_event *ie;
+	struct pcpu *pc;
+	uint64_t delta, hotload;
+	long idle, srcidle, tgtidle;
+	int cpu, hotcpu, hotirq, target;
+
+	bzero(cpuload, sizeof(cpuload));
+	hotload = 0;
+	hotcpu = NOCPU;
+	hotirq = -1;
+
+	/*
+	 * Charge the cycles each event consumed since the previous pass to
+	 * the CPU it is bound to, and remember the hottest movable event.
+	 * Unbound events are not charged anywhere: without MD help we do
+	 * not know where the platform delivers them.
+	 */
+	mtx_lock(&event_lock);
+	TAILQ_FOREACH(ie, &event_list, ie_list) {
+		delta = ie->ie_cycles - ie->ie_oldcycles;
+		ie->ie_oldcycles = ie->ie_cycles;
+		if ((ie->ie_flags & (IE_SOFT | IE_PINNED)) != 0 ||
+		    ie->ie_assign_cpu == NULL ||
+		    CK_SLIST_EMPTY(&ie->ie_handlers))
+			continue;
+		if (ie->ie_cpu != NOCPU)
+			cpuload[ie->ie_cpu] += delta;
+		if (delta > hotload) {
+			hotload = delta;
+			hotcpu = ie->ie_cpu;
+			hotirq = ie->ie_irq;
+		}
+	}
+	mtx_unlock(&event_lock);
+
+	/*
+	 * Find the idlest CPU using the statclock counts the scheduler
+	 * already maintains; the interrupt cycles charged above break ties
+	 * between equally idle CPUs.
+	 */
+	target = NOCPU;
+	srcidle = tgtidle = 0;
+	CPU_FOREACH(cpu) {
+		pc = pcpu_find(cpu);
+		idle = pc->pc_cp_time[CP_IDLE] - idlesnap[cpu];
+		idlesnap[cpu] = pc->pc_cp_time[CP_IDLE];
+		if (cpu == hotcpu)
+			srcidle = idle;
+		if (target == NOCPU || idle > tgtidle ||
+		    (idle == tgtidle && cpuload[cpu] < cpuload[target])) {
+			target = cpu;
+			tgtidle = idle;
+		}
+	}
+
+	/* The first pass only primes the snapshots. */
+	if (!primed) {
+		primed = 1;
+		return;
+	}
+
+	if (hotirq == -1 || hotload == 0 || target == NOCPU ||
+	    target == hotcpu)
+		return;
+
+	/*
+	 * Require the target to have been noticeably idler than the
+	 * current home of the hot vector before churning bindings.
+	 */
+	if (hotcpu != NOCPU &&
+	    tgtidle - srcidle < (long)(stathz * intr_balance) / 4)
+		return;
+
+	/* Look the event up again; it may be gone by now. */
+	ie = intr_lookup(hotirq);
+	if (ie == NULL || (ie->ie_flags & IE_PINNED) != 0)
+		return;
+	if (intr_event_bind(ie, target) == 0) {
+		mtx_lock(&ie->ie_lock);
+		ie->ie_flags |= IE_BALANCED;
+		mtx_unlock(&ie->ie_lock);
+		intr_balance_moves++;
+	}
+}
+
+static void
+intr_balancer(void)
+{
+
+	for (;;) {
+		tsleep(&intr_balance, PWAIT, "intrbal",
+		    hz * (intr_balance > 0 ? intr_balance : 1));
+		if (intr_balance <= 0 || mp_ncpus <= 1)
+			continue;
+		intr_balance_pass();
+	}
+}
+
+static struct kproc_desc intr_balance_kp = {
+	"intrbalance",
+	intr_balancer,
+	&intr_balance_proc
+};
+SYSINIT(intrbalance, SI_SUB_SMP, SI_ORDER_ANY, kproc_start,
+    &intr_balance_kp);
+
 #ifdef DDB
 /*
  * Dump details about an interrupt handler
@@ -1489,6 +1650,50 @@ sysctl_intrcnt(SYSCTL_HANDLER_ARGS)
 SYSCTL_PROC(_hw, OID_AUTO, intrcnt, CTLTYPE_OPAQUE | CTLFLAG_RD,
     NULL, 0, sysctl_intrcnt, "", "Interrupt Counts");
 
+/*
+ * Per-event dispatch and service-time statistics.  One line per event:
+ * name, bound CPU (-1 if unbound), dispatches, and cpu_ticks() spent in
+ * its filters and handlers.  Rates follow from successive samples.
+ */
+static int
+sysctl_intrstats(SYSCTL_HANDLER_ARGS)
+{
+	struct sbuf sb;
+	struct intr_event *ie;
+	char *buf;
+	size_t len;
+	int error;
+
+	len = 1024;
+retry:
+	buf = malloc(len, M_TEMP, M_WAITOK);
+	sbuf_new(&sb, buf, len, SBUF_FIXEDLEN | SBUF_INCLUDENUL);
+	mtx_lock(&event_lock);
+	TAILQ_FOREACH(ie, &event_list, ie_list) {
+		if (CK_SLIST_EMPTY(&ie->ie_handlers))
+			continue;
+		sbuf_printf(&sb, "%s cpu%d %lu %ju\n", ie->ie_fullname,
+		    ie->ie_cpu, ie->ie_dispatches, (uintmax_t)ie->ie_cycles);
+	}
+	mtx_unlock(&event_lock);
+	error = sbuf_finish(&sb);
+	if (error == ENOMEM) {
+		sbuf_delete(&sb);
+		free(buf, M_TEMP);
+		len *= 2;
+		goto retry;
+	}
+	if (error == 0)
+		error = SYSCTL_OUT(req, sbuf_data(&sb), sbuf_len(&sb));
+	sbuf_delete(&sb);
+	free(buf, M_TEMP);
+	return (error);
+}
+
+SYSCTL_PROC(_hw, OID_AUTO, intrstats, CTLTYPE_STRING | CTLFLAG_RD |
+    CTLFLAG_MPSAFE, NULL, 0, sysctl_intrstats, "A",
+    "Interrupt event dispatch counts and handler service time");
+
 #ifdef DDB
 /*
  * DDB command to dump the interrupt statistics.
@@ -39,7 +39,10 @@ __FBSDID("$FreeBSD$");
 #include <sys/types.h>
 #include <sys/kernel.h>
 #include <sys/systm.h>
+#include <sys/ck.h>
+#include <sys/epoch.h>
 #include <sys/errno.h>
+#include <sys/hash.h>
 #include <sys/sysproto.h>
 #include <sys/malloc.h>
 #include <sys/osd.h>
@@ -135,6 +138,72 @@ struct	prisonlist allprison = TAILQ_HEAD_INITIALIZER(allprison);
 LIST_HEAD(, prison_racct) allprison_racct;
 int	lastprid = 0;
 
+/*
+ * Hashes of the prisons, by jid and by full name, so that lookups do not
+ * degrade into a walk of allprison as the jail count grows.  The chains
+ * are built with CK_LIST so that they may also be traversed lock-free
+ * within an epoch section on hot paths; all modifications are made with
+ * allprison_lock exclusively held, and a removed prison is not torn down
+ * until the epoch has been waited out, so an epoch reader may safely
+ * take pr_mtx on any prison it finds on a chain.
+ */
+CK_LIST_HEAD(prisonhashhead, prison);
+#define	PRISON_HASH_SIZE	64	/* must be a power of two */
+static struct prisonhashhead prison_jid_hash[PRISON_HASH_SIZE];
+static struct prisonhashhead prison_name_hash[PRISON_HASH_SIZE];
+static epoch_t prison_epoch;
+
+#define	PRISON_JID_HASH(jid)						\
+	(&prison_jid_hash[(jid) & (PRISON_HASH_SIZE - 1)])
+#define	PRISON_NAME_HASH(name)						\
+	(&prison_name_hash[hash32_str((name), HASHINIT) &		\
+	    (PRISON_HASH_SIZE - 1)])
+
+static void
+prison_hash_sysinit(void *dummy __unused)
+{
+
+	prison_epoch = epoch_alloc(EPOCH_PREEMPT);
+}
+SYSINIT(prison_hash, SI_SUB_TASKQ + 2, SI_ORDER_ANY, prison_hash_sysinit,
+    NULL);
+
+/*
+ * Add a prison to the jid and name hashes.  It is hashed as soon as it
+ * has an ID, i.e. while it may still be half-built; readers are expected
+ * to check pr_ref under pr_mtx, just as with allprison itself.
+ */
+static void
+prison_hash_insert(struct prison *pr)
+{
+
+	sx_assert(&allprison_lock, SX_XLOCKED);
+	CK_LIST_INSERT_HEAD(PRISON_JID_HASH(pr->pr_id), pr, pr_jidhash);
+	CK_LIST_INSERT_HEAD(PRISON_NAME_HASH(pr->pr_name), pr, pr_namehash);
+}
+
+static void
+prison_hash_remove(struct prison *pr)
+{
+
+	sx_assert(&allprison_lock, SX_XLOCKED);
+	CK_LIST_REMOVE(pr, pr_jidhash);
+	CK_LIST_REMOVE(pr, pr_namehash);
+}
+
+/*
+ * Move a prison to the name hash chain matching its current pr_name.
+ * Called after a prison is renamed, for it and each of its descendants.
+ */
+static void
+prison_hash_rename(struct prison *pr)
+{
+
+	sx_assert(&allprison_lock, SX_XLOCKED);
+	CK_LIST_REMOVE(pr, pr_namehash);
+	CK_LIST_INSERT_HEAD(PRISON_NAME_HASH(pr->pr_name), pr, pr_namehash);
+}
+
 static int do_jail_attach(struct thread *td, struct prison *pr);
 static void prison_complete(void *context, int pending);
 static void prison_deref(struct prison *pr, int flags);
@@ -1273,6 +1342,7 @@ kern_jail_set(struct thread *td, struct uio *optuio, int flags)
 		LIST_INIT(&pr->pr_children);
 		mtx_init(&pr->pr_mtx, "jail mutex", NULL, MTX_DEF | MTX_DUPOK);
 		TASK_INIT(&pr->pr_task, 0, prison_complete, pr);
+		prison_hash_insert(pr);
 
 #ifdef VIMAGE
 		/* Allocate a new vnet if specified. */
@@ -1658,11 +1728,13 @@ kern_jail_set(struct thread *td, struct uio *optuio, int flags)
 		else
 			snprintf(pr->pr_name, sizeof(pr->pr_name), "%s.%s",
 			    ppr->pr_name, namelc);
+		prison_hash_rename(pr);
 		/* Change this component of child names. */
 		FOREACH_PRISON_DESCENDANT_LOCKED(pr, tpr, descend) {
 			bcopy(tpr->pr_name + onamelen, tpr->pr_name + namelen,
 			    strlen(tpr->pr_name + onamelen) + 1);
 			bcopy(pr->pr_name, tpr->pr_name, namelen);
+			prison_hash_rename(tpr);
 		}
 	}
 	if (path != NULL) {
@@ -2464,7 +2536,7 @@ prison_find(int prid)
 	struct prison *pr;
 
 	sx_assert(&allprison_lock, SX_LOCKED);
-	TAILQ_FOREACH(pr, &allprison, pr_list) {
+	CK_LIST_FOREACH(pr, PRISON_JID_HASH(prid), pr_jidhash) {
 		if (pr->pr_id == prid) {
 			mtx_lock(&pr->pr_mtx);
 			if (pr->pr_ref > 0)
@@ -2476,23 +2548,54 @@ prison_find(int prid)
 }
 
 /*
- * Find a prison that is a descendant of mypr.  Returns a locked prison or NULL.
+ * As prison_find, but without any requirement on allprison_lock: the jid
+ * hash chain is walked within an epoch section instead.  For hot paths
+ * such as per-packet or per-socket prison checks.
  */
 struct prison *
-prison_find_child(struct prison *mypr, int prid)
+prison_find_unlocked(int prid)
 {
 	struct prison *pr;
-	int descend;
+	struct epoch_tracker et;
 
-	sx_assert(&allprison_lock, SX_LOCKED);
-	FOREACH_PRISON_DESCENDANT(mypr, pr, descend) {
+	epoch_enter_preempt(prison_epoch, &et);
+	CK_LIST_FOREACH(pr, PRISON_JID_HASH(prid), pr_jidhash) {
 		if (pr->pr_id == prid) {
 			mtx_lock(&pr->pr_mtx);
-			if (pr->pr_ref > 0)
+			if (pr->pr_ref > 0) {
+				epoch_exit_preempt(prison_epoch, &et);
 				return (pr);
+			}
 			mtx_unlock(&pr->pr_mtx);
 		}
 	}
+	epoch_exit_preempt(prison_epoch, &et);
+	return (NULL);
+}
+
+/*
+ * Find a prison that is a descendant of mypr.  Returns a locked prison or NULL.
+ */
+struct prison *
+prison_find_child(struct prison *mypr, int prid)
+{
+	struct prison *pr, *tpr;
+
+	sx_assert(&allprison_lock, SX_LOCKED);
+	CK_LIST_FOREACH(pr, PRISON_JID_HASH(prid), pr_jidhash) {
+		if (pr->pr_id != prid)
+			continue;
+		/* The hash spans all jails; make sure this one is ours. */
+		for (tpr = pr->pr_parent; tpr != NULL; tpr = tpr->pr_parent)
+			if (tpr == mypr)
+				break;
+		if (tpr == NULL)
+			continue;
+		mtx_lock(&pr->pr_mtx);
+		if (pr->pr_ref > 0)
+			return (pr);
+		mtx_unlock(&pr->pr_mtx);
+	}
 	return (NULL);
 }
 
@@ -2502,16 +2605,35 @@ prison_find_child(struct prison *mypr, int prid)
 struct prison *
 prison_find_name(struct prison *mypr, const char *name)
 {
-	struct prison *pr, *deadpr;
-	size_t mylen;
-	int descend;
+	struct prison *pr, *deadpr, *tpr;
+	char fullname[sizeof(pr->pr_name)];
 
 	sx_assert(&allprison_lock, SX_LOCKED);
-	mylen = (mypr == &prison0) ? 0 : strlen(mypr->pr_name) + 1;
+	/* Names are stored fully qualified, so look for the whole path. */
+	if (mypr == &prison0) {
+		if (strlcpy(fullname, name, sizeof(fullname)) >=
+		    sizeof(fullname))
+			return (NULL);
+	} else {
+		if (snprintf(fullname, sizeof(fullname), "%s.%s",
+		    mypr->pr_name, name) >= (int)sizeof(fullname))
+			return (NULL);
+	}
  again:
 	deadpr = NULL;
-	FOREACH_PRISON_DESCENDANT(mypr, pr, descend) {
-		if (!strcmp(pr->pr_name + mylen, name)) {
+	CK_LIST_FOREACH(pr, PRISON_NAME_HASH(fullname), pr_namehash) {
+		if (!strcmp(pr->pr_name, fullname)) {
+			/*
+			 * A dying jail may share its name with one in a
+			 * different hierarchy; make sure this one descends
+			 * from mypr.
+			 */
+			for (tpr = pr->pr_parent; tpr != NULL;
+			    tpr = tpr->pr_parent)
+				if (tpr == mypr)
+					break;
+			if (tpr == NULL)
+				continue;
 			mtx_lock(&pr->pr_mtx);
 			if (pr->pr_ref > 0) {
 				if (pr->pr_uref > 0)
@@ -2658,12 +2780,20 @@ prison_deref(struct prison *pr, int flags)
 			sx_xlock(&allprison_lock);
 
 		TAILQ_REMOVE(&allprison, pr, pr_list);
+		prison_hash_remove(pr);
 		LIST_REMOVE(pr, pr_sibling);
 		ppr = pr->pr_parent;
 		for (tpr = ppr; tpr != NULL; tpr = tpr->pr_parent)
 			tpr->pr_childcount--;
 		sx_xunlock(&allprison_lock);
 
+		/*
+		 * Wait for any lock-free hash readers to leave their epoch
+		 * section before tearing the prison down; they may still be
+		 * examining it, in particular holding pr_mtx.
+		 */
+		epoch_wait_preempt(prison_epoch);
+
 #ifdef VIMAGE
 		if (pr->pr_vnet != ppr->pr_vnet)
 			vnet_destroy(pr->pr_vnet);
@@ -50,6 +50,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/lock.h>
 #include <sys/malloc.h>
 #include <sys/mutex.h>
+#include <sys/priv.h>
 #include <sys/proc.h>
 #include <sys/smp.h>
 #include <sys/sysctl.h>
@@ -95,6 +96,7 @@ static MALLOC_DEFINE(M_KTR, "KTR", "KTR");
 FEATURE(ktr, "Kernel support for KTR kernel tracing facility");
 
 volatile int	ktr_idx = 0;
+static volatile u_int ktr_seq = 0;
 uint64_t ktr_mask = KTR_MASK;
 uint64_t ktr_compile = KTR_COMPILE;
 int	ktr_entries = KTR_BOOT_ENTRIES;
@@ -146,6 +148,7 @@ sysctl_debug_ktr_clear(SYSCTL_HANDLER_ARGS)
 
 	if (clear) {
 		bzero(ktr_buf, sizeof(*ktr_buf) * ktr_entries);
+		ktr_seq = 0;
 		ktr_idx = 0;
 	}
 
@@ -199,6 +202,7 @@ ktr_entries_initializer(void *dummy __unused)
 		ktr_idx = KTR_BOOT_ENTRIES;
 	}
 	ktr_entries = KTR_ENTRIES;
+	ktr_seq = ktr_idx;
 	ktr_mask = mask;
 }
 SYSINIT(ktr_entries_initializer, SI_SUB_KMEM, SI_ORDER_ANY,
@@ -235,6 +239,7 @@ sysctl_debug_ktr_entries(SYSCTL_HANDLER_ARGS)
 	/* Install the new buffer and restart ktr. */
 	ktr_buf = buf;
 	ktr_entries = entries;
+	ktr_seq = 0;
 	ktr_idx = 0;
 	ktr_mask = mask;
 	if (oldbuf != NULL)
@@ -246,6 +251,41 @@ sysctl_debug_ktr_entries(SYSCTL_HANDLER_ARGS)
 SYSCTL_PROC(_debug_ktr, OID_AUTO, entries, CTLTYPE_INT|CTLFLAG_RW, 0, 0,
     sysctl_debug_ktr_entries, "I", "Number of entries in the KTR buffer");
 
+static int ktr_normtime = 0;
+SYSCTL_INT(_debug_ktr, OID_AUTO, normtime, CTLFLAG_RWTUN, &ktr_normtime, 0,
+    "Timestamp entries with sbinuptime(), comparable across CPUs");
+
+/*
+ * Stream the trace buffer to userland in binary form, oldest entry
+ * first.  No locking is done against concurrent tracing; an entry
+ * overwritten mid-copy yields a torn record, exactly as when ktrdump(8)
+ * reads the buffer of a live kernel through /dev/kmem.  Serialized as
+ * !MPSAFE with the clear and resize handlers so that ktr_buf cannot be
+ * freed underneath us.
+ */
+static int
+sysctl_debug_ktr_buffer(SYSCTL_HANDLER_ARGS)
+{
+	int error, i, idx;
+
+	error = priv_check(req->td, PRIV_KMEM_READ);
+	if (error != 0)
+		return (error);
+	if (req->oldptr == NULL)
+		return (SYSCTL_OUT(req, NULL,
+		    sizeof(*ktr_buf) * ktr_entries));
+	if (ktr_buf == NULL)
+		return (ENXIO);
+	idx = ktr_idx;
+	for (i = 0; i < ktr_entries && error == 0; i++)
+		error = SYSCTL_OUT(req, &ktr_buf[(idx + i) % ktr_entries],
+		    sizeof(*ktr_buf));
+	return (error);
+}
+SYSCTL_PROC(_debug_ktr, OID_AUTO, buffer, CTLTYPE_OPAQUE | CTLFLAG_RD |
+    CTLFLAG_SKIP, 0, 0, sysctl_debug_ktr_buffer, "",
+    "Binary dump of the KTR buffer, oldest entry first");
+
 #ifdef KTR_VERBOSE
 int	ktr_verbose = KTR_VERBOSE;
 TUNABLE_INT("debug.ktr.verbose", &ktr_verbose);
@@ -357,13 +397,23 @@ ktr_tracepoint(uint64_t mask, const char *file, int line, const char *format,
 	} else
 #endif
 	{
-		do {
-			saveindex = ktr_idx;
-			newindex = (saveindex + 1) % ktr_entries;
-		} while (atomic_cmpset_rel_int(&ktr_idx, saveindex, newindex) == 0);
+		/*
+		 * Reserve a slot with a single wait-free fetchadd instead
+		 * of looping on a compare-and-set of the buffer index;
+		 * under heavy multi-CPU tracing the retry loop itself
+		 * perturbs the races being chased.  The counter runs
+		 * freely and is reduced modulo the buffer size, so its
+		 * 32 bit wraparound may skip a few slots when ktr_entries
+		 * is not a power of 2; that merely leaves a small gap in
+		 * the trace.  ktr_idx is maintained with a plain store
+		 * for ktrdump(8) and ddb; it may lag under contention.
+		 */
+		saveindex = atomic_fetchadd_int(&ktr_seq, 1) % ktr_entries;
+		newindex = (saveindex + 1) % ktr_entries;
+		ktr_idx = newindex;
 		entry = &ktr_buf[saveindex];
 	}
-	entry->ktr_timestamp = KTR_TIME;
+	entry->ktr_timestamp = ktr_normtime ? sbinuptime() : KTR_TIME;
 	entry->ktr_cpu = cpu;
 	entry->ktr_thread = curthread;
 	if (file != NULL)
@@ -76,6 +76,12 @@ __FBSDID("$FreeBSD$");
  * then delivered to disk at a convenient moment -- either immediately, the
  * next traceable event, at system call return, or at process exit.
  *
+ * With the kern.ktrace.async sysctl enabled, traced threads never enter
+ * VFS at all: every record is queued for a dedicated worker thread that
+ * performs the vnode writes, so tracing perturbs the traced workload far
+ * less.  The request pool bounds the backlog; records that cannot get a
+ * request are dropped and accounted in kern.ktrace.drops.
+ *
  * When dealing with multiple threads or processes writing to the same event
  * log, ordering guarantees are weak: specifically, if an event has multiple
  * records (i.e., system call enter and return), they may be interlaced with
@@ -96,6 +102,8 @@ FEATURE(ktrace, "Kernel support for system-call tracing");
 struct ktr_request {
 	struct	ktr_header ktr_header;
 	void	*ktr_buffer;
+	struct	vnode *ktr_vp;		/* async mode: write target */
+	struct	ucred *ktr_cred;	/* async mode: write credential */
 	union {
 		struct	ktr_proc_ctor ktr_proc_ctor;
 		struct	ktr_cap_fail ktr_cap_fail;
@@ -130,6 +138,7 @@ static int data_lengths[] = {
 };
 
 static STAILQ_HEAD(, ktr_request) ktr_free;
+static STAILQ_HEAD(, ktr_request) ktr_async_head;
 
 static SYSCTL_NODE(_kern, OID_AUTO, ktrace, CTLFLAG_RD, 0, "KTRACE options");
 
@@ -140,6 +149,19 @@ u_int ktr_geniosize = PAGE_SIZE;
 SYSCTL_UINT(_kern_ktrace, OID_AUTO, genio_size, CTLFLAG_RWTUN, &ktr_geniosize,
     0, "Maximum size of genio event payload");
 
+static int ktr_async;
+SYSCTL_INT(_kern_ktrace, OID_AUTO, async, CTLFLAG_RWTUN, &ktr_async, 0,
+    "Hand records to a worker thread instead of writing them in-context");
+
+static int ktr_filter_syscall = -1;
+SYSCTL_INT(_kern_ktrace, OID_AUTO, filter_syscall, CTLFLAG_RW,
+    &ktr_filter_syscall, 0,
+    "Only record the system call with this code (-1 records all)");
+
+static u_long ktr_drops;
+SYSCTL_ULONG(_kern_ktrace, OID_AUTO, drops, CTLFLAG_RD, &ktr_drops, 0,
+    "Records dropped because the request pool was exhausted");
+
 static int print_message = 1;
 static struct mtx ktrace_mtx;
 static struct sx ktrace_sx;
@@ -154,7 +176,10 @@ static void ktr_freeproc(struct proc *p, struct ucred **uc,
     struct vnode **vp);
 static void ktr_freerequest(struct ktr_request *req);
 static void ktr_freerequest_locked(struct ktr_request *req);
+static bool ktr_enqueue_async(struct thread *td, struct ktr_request *req);
 static void ktr_writerequest(struct thread *td, struct ktr_request *req);
+static void ktr_writerequest_vp(struct thread *td, struct vnode *vp,
+    struct ucred *cred, struct ktr_request *req);
 static int ktrcanset(struct thread *,struct proc *);
 static int ktrsetchildren(struct thread *,struct proc *,int,int,struct vnode *);
 static int ktrops(struct thread *,struct proc *,int,int,struct vnode *);
@@ -198,6 +223,7 @@ ktrace_init(void *dummy)
 	mtx_init(&ktrace_mtx, "ktrace", NULL, MTX_DEF | MTX_QUIET);
 	sx_init(&ktrace_sx, "ktrace_sx");
 	STAILQ_INIT(&ktr_free);
+	STAILQ_INIT(&ktr_async_head);
 	for (i = 0; i < ktr_requestpool; i++) {
 		req = malloc(sizeof(struct ktr_request), M_KTRACE, M_WAITOK);
 		STAILQ_INSERT_HEAD(&ktr_free, req, ktr_list);
@@ -309,6 +335,7 @@ ktr_getrequest_entered(struct thread *td, int type)
 		req->ktr_header.ktr_len = 0;
 	} else {
 		p->p_traceflag |= KTRFAC_DROP;
+		ktr_drops++;
 		pm = print_message;
 		print_message = 0;
 		mtx_unlock(&ktrace_mtx);
@@ -342,11 +369,84 @@ static void
 ktr_enqueuerequest(struct thread *td, struct ktr_request *req)
 {
 
+	if (ktr_async && ktr_enqueue_async(td, req))
+		return;
 	mtx_lock(&ktrace_mtx);
 	STAILQ_INSERT_TAIL(&td->td_proc->p_ktr, req, ktr_list);
 	mtx_unlock(&ktrace_mtx);
 }
 
+/*
+ * Queue a record for the ktrace worker thread, taking references on the
+ * process's trace vnode and credential so the write can proceed after
+ * tracing is disabled or the process exits.  Fails only if tracing has
+ * already been torn down.  Safe in no-sleep contexts: only mutexes and
+ * reference counts are taken.
+ */
+static bool
+ktr_enqueue_async(struct thread *td, struct ktr_request *req)
+{
+	struct proc *p;
+
+	p = td->td_proc;
+	mtx_lock(&ktrace_mtx);
+	if (p->p_tracevp == NULL) {
+		mtx_unlock(&ktrace_mtx);
+		return (false);
+	}
+	VREF(p->p_tracevp);
+	crhold(p->p_tracecred);
+	req->ktr_vp = p->p_tracevp;
+	req->ktr_cred = p->p_tracecred;
+	STAILQ_INSERT_TAIL(&ktr_async_head, req, ktr_list);
+	mtx_unlock(&ktrace_mtx);
+	wakeup(&ktr_async_head);
+	return (true);
+}
+
+/*
+ * The ktrace worker: drains the async queue and does the vnode writes on
+ * behalf of traced threads, which then never enter VFS themselves.  The
+ * request pool bounds the queue; when it runs dry records are dropped,
+ * counted in kern.ktrace.drops and flagged in-stream with KTR_DROP.
+ */
+static void
+ktr_async_thread(void *arg __unused)
+{
+	STAILQ_HEAD(, ktr_request) local_queue;
+	struct ktr_request *req;
+
+	STAILQ_INIT(&local_queue);
+	mtx_lock(&ktrace_mtx);
+	for (;;) {
+		while (STAILQ_EMPTY(&ktr_async_head))
+			msleep(&ktr_async_head, &ktrace_mtx, PRIBIO,
+			    "ktrasy", 0);
+		STAILQ_CONCAT(&local_queue, &ktr_async_head);
+		mtx_unlock(&ktrace_mtx);
+		while ((req = STAILQ_FIRST(&local_queue)) != NULL) {
+			STAILQ_REMOVE_HEAD(&local_queue, ktr_list);
+			ktr_writerequest_vp(curthread, req->ktr_vp,
+			    req->ktr_cred, req);
+			ktr_freerequest(req);
+		}
+		mtx_lock(&ktrace_mtx);
+	}
+}
+
+static void
+ktr_async_init(void *dummy __unused)
+{
+	struct proc *p;
+	int error;
+
+	error = kproc_create(ktr_async_thread, NULL, &p, 0, 0, "ktrace");
+	if (error != 0)
+		panic("%s: kproc_create returned %d", __func__, error);
+}
+SYSINIT(ktr_async_init, SI_SUB_KTHREAD_INIT, SI_ORDER_ANY, ktr_async_init,
+    NULL);
+
 /*
  * Drain any pending ktrace records from the per-thread queue to disk.  This
  * is used both internally before committing other records, and also on
@@ -389,6 +489,12 @@ ktr_submitrequest(struct thread *td, struct ktr_request *req)
 
 	ktrace_assert(td);
 
+	if (ktr_async) {
+		if (!ktr_enqueue_async(td, req))
+			ktr_freerequest(req);
+		ktrace_exit(td);
+		return;
+	}
 	sx_xlock(&ktrace_sx);
 	ktr_drain(td);
 	ktr_writerequest(td, req);
@@ -450,6 +556,8 @@ ktrsyscall(int code, int narg, register_t args[])
 
 	if (__predict_false(curthread->td_pflags & TDP_INKTRACE))
 		return;
+	if (ktr_filter_syscall != -1 && code != ktr_filter_syscall)
+		return;
 
 	buflen = sizeof(register_t) * narg;
 	if (buflen > 0) {
@@ -480,6 +588,8 @@ ktrsysret(int code, int error, register_t retval)
 
 	if (__predict_false(curthread->td_pflags & TDP_INKTRACE))
 		return;
+	if (ktr_filter_syscall != -1 && code != ktr_filter_syscall)
+		return;
 
 	req = ktr_getrequest(KTR_SYSRET);
 	if (req == NULL)
@@ -1170,15 +1280,8 @@ ktrsetchildren(struct thread *td, struct proc *top, int ops, int facs,
 static void
 ktr_writerequest(struct thread *td, struct ktr_request *req)
 {
-	struct ktr_header *kth;
 	struct vnode *vp;
-	struct proc *p;
 	struct ucred *cred;
-	struct uio auio;
-	struct iovec aiov[3];
-	struct mount *mp;
-	int datalen, buflen, vrele_count;
-	int error;
 
 	/*
 	 * We hold the vnode and credential for use in I/O in case ktrace is
@@ -1206,6 +1309,25 @@ ktr_writerequest(struct thread *td, struct ktr_request *req)
 	crhold(cred);
 	mtx_unlock(&ktrace_mtx);
 
+	ktr_writerequest_vp(td, vp, cred, req);
+}
+
+/*
+ * Write one record to the given trace vnode, consuming the references on
+ * the vnode and credential held by the caller.
+ */
+static void
+ktr_writerequest_vp(struct thread *td, struct vnode *vp, struct ucred *cred,
+    struct ktr_request *req)
+{
+	struct ktr_header *kth;
+	struct proc *p;
+	struct uio auio;
+	struct iovec aiov[3];
+	struct mount *mp;
+	int datalen, buflen, vrele_count;
+	int error;
+
 	kth = &req->ktr_header;
 	KASSERT(((u_short)kth->ktr_type & ~KTR_DROP) < nitems(data_lengths),
 	    ("data_lengths array overflow"));
@@ -55,6 +55,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/systm.h>
 #include <sys/kdb.h>
 #include <sys/kernel.h>
+#include <sys/linker.h>
 #include <sys/lock.h>
 #include <sys/malloc.h>
 #include <sys/mutex.h>
@@ -225,10 +226,8 @@ static int sysctl_kern_malloc_stats(SYSCTL_HANDLER_ARGS);
  */
 static time_t t_malloc_fail;
 
-#if defined(MALLOC_MAKE_FAILURES) || (MALLOC_DEBUG_MAXZONES > 1)
 static SYSCTL_NODE(_debug, OID_AUTO, malloc, CTLFLAG_RD, 0,
     "Kernel malloc debugging options");
-#endif
 
 /*
  * malloc(9) fault injection -- cause malloc failures every (n) mallocs when
@@ -244,6 +243,55 @@ SYSCTL_INT(_debug_malloc, OID_AUTO, failure_count, CTLFLAG_RD,
     &malloc_failure_count, 0, "Number of imposed M_NOWAIT malloc failures");
 #endif
 
+/*
+ * Sampled allocation profiler.  Every sample_rate-th allocation on each
+ * CPU is recorded with its caller's return address, size and allocation
+ * time; when a sampled address is freed its lifetime is folded into a
+ * per-caller table.  The tables are small and fixed so the overhead is
+ * a short mutex section once per sample_rate allocations per CPU, which
+ * lets the profiler stay enabled on production hosts.  The aggregated
+ * profile is exported as text via debug.malloc.sample.
+ */
+#define	MALLOC_SAMPLE_LIVE	1024	/* outstanding sampled allocations */
+#define	MALLOC_SAMPLE_SITES	256	/* distinct callers tracked */
+#define	MALLOC_SAMPLE_NPROBE	8	/* open addressing probe limit */
+
+struct malloc_sample {
+	vm_offset_t	ms_addr;	/* sampled allocation, 0 if unused */
+	void		*ms_caller;
+	size_t		ms_size;
+	u_int		ms_birth;	/* ticks at allocation */
+};
+
+struct malloc_site {
+	void		*msi_caller;	/* return address into the caller */
+	uint64_t	msi_allocs;	/* sampled allocations */
+	uint64_t	msi_bytes;	/* their summed sizes */
+	uint64_t	msi_frees;	/* sampled allocations freed */
+	uint64_t	msi_lifetime;	/* summed lifetime of freed, ticks */
+	size_t		msi_maxsize;
+};
+
+static struct malloc_sample malloc_sample_live[MALLOC_SAMPLE_LIVE];
+static struct malloc_site malloc_sample_sites[MALLOC_SAMPLE_SITES];
+static struct mtx malloc_sample_mtx;	/* initialized in mallocinit() */
+static int malloc_sample_rate = 65536;
+SYSCTL_INT(_debug_malloc, OID_AUTO, sample_rate, CTLFLAG_RWTUN,
+    &malloc_sample_rate, 0,
+    "Sample every (n)th malloc(9) allocation per CPU, 0 disables");
+static u_int malloc_sample_nused;
+static u_long malloc_sample_lost;
+SYSCTL_ULONG(_debug_malloc, OID_AUTO, sample_lost, CTLFLAG_RD,
+    &malloc_sample_lost, 0,
+    "Number of samples dropped because the sample tables were full");
+DPCPU_DEFINE_STATIC(int, malloc_sample_count);
+
+static int sysctl_malloc_sample(SYSCTL_HANDLER_ARGS);
+SYSCTL_PROC(_debug_malloc, OID_AUTO, sample,
+    CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+    sysctl_malloc_sample, "A",
+    "Sampled allocation profile, aggregated by caller");
+
 static int
 sysctl_kmem_map_size(SYSCTL_HANDLER_ARGS)
 {
@@ -431,6 +479,169 @@ malloc_type_freed(struct malloc_type *mtp, unsigned long size)
 	critical_exit();
 }
 
+/*
+ * Look up, and with 'create' set claim, the site slot for a caller.
+ * Collisions past the probe limit are dropped and counted.
+ */
+static struct malloc_site *
+malloc_site_find(void *caller, bool create)
+{
+	struct malloc_site *msi;
+	u_int h, i;
+
+	mtx_assert(&malloc_sample_mtx, MA_OWNED);
+	h = (((uintptr_t)caller >> 2) * 2654435761u) &
+	    (MALLOC_SAMPLE_SITES - 1);
+	for (i = 0; i < MALLOC_SAMPLE_NPROBE; i++) {
+		msi = &malloc_sample_sites[(h + i) &
+		    (MALLOC_SAMPLE_SITES - 1)];
+		if (msi->msi_caller == caller)
+			return (msi);
+		if (msi->msi_caller == NULL) {
+			if (!create)
+				return (NULL);
+			msi->msi_caller = caller;
+			return (msi);
+		}
+	}
+	return (NULL);
+}
+
+static inline u_int
+malloc_sample_hash(void *addr)
+{
+
+	return ((((uintptr_t)addr >> 4) * 2654435761u) &
+	    (MALLOC_SAMPLE_LIVE - 1));
+}
+
+/*
+ * Count down the per-CPU budget and record every sample_rate-th
+ * allocation.  Called from the malloc(9) entry points with the address
+ * the caller will see and the caller's return address.
+ */
+static void
+malloc_sample_alloc(void *addr, size_t size, void *caller)
+{
+	struct malloc_sample *ms;
+	struct malloc_site *msi;
+	int *count;
+	u_int h, i;
+
+	critical_enter();
+	count = DPCPU_PTR(malloc_sample_count);
+	if (__predict_true(--*count > 0)) {
+		critical_exit();
+		return;
+	}
+	*count = malloc_sample_rate;
+	critical_exit();
+
+	mtx_lock(&malloc_sample_mtx);
+	msi = malloc_site_find(caller, true);
+	if (msi == NULL) {
+		malloc_sample_lost++;
+		mtx_unlock(&malloc_sample_mtx);
+		return;
+	}
+	msi->msi_allocs++;
+	msi->msi_bytes += size;
+	if (size > msi->msi_maxsize)
+		msi->msi_maxsize = size;
+	h = malloc_sample_hash(addr);
+	for (i = 0; i < MALLOC_SAMPLE_NPROBE; i++) {
+		ms = &malloc_sample_live[(h + i) & (MALLOC_SAMPLE_LIVE - 1)];
+		if (ms->ms_addr != 0)
+			continue;
+		ms->ms_addr = (vm_offset_t)addr;
+		ms->ms_caller = caller;
+		ms->ms_size = size;
+		ms->ms_birth = ticks;
+		malloc_sample_nused++;
+		break;
+	}
+	if (i == MALLOC_SAMPLE_NPROBE)
+		malloc_sample_lost++;
+	mtx_unlock(&malloc_sample_mtx);
+}
+
+/*
+ * Fold the lifetime of a sampled allocation into its site on free.
+ * The unlocked probe keeps the common case (address was never sampled)
+ * down to a few reads; a live sampled address cannot alias another
+ * allocation, so a match is re-checked and harvested under the lock.
+ */
+static void
+malloc_sample_free(void *addr)
+{
+	struct malloc_sample *ms;
+	struct malloc_site *msi;
+	u_int h, i;
+
+	h = malloc_sample_hash(addr);
+	for (i = 0; i < MALLOC_SAMPLE_NPROBE; i++) {
+		ms = &malloc_sample_live[(h + i) & (MALLOC_SAMPLE_LIVE - 1)];
+		if (ms->ms_addr != (vm_offset_t)addr)
+			continue;
+		mtx_lock(&malloc_sample_mtx);
+		if (ms->ms_addr == (vm_offset_t)addr) {
+			msi = malloc_site_find(ms->ms_caller, false);
+			if (msi != NULL) {
+				msi->msi_frees++;
+				msi->msi_lifetime +=
+				    (u_int)ticks - ms->ms_birth;
+			}
+			ms->ms_addr = 0;
+			malloc_sample_nused--;
+		}
+		mtx_unlock(&malloc_sample_mtx);
+		return;
+	}
+}
+
+static int
+sysctl_malloc_sample(SYSCTL_HANDLER_ARGS)
+{
+	struct malloc_site *msi, *sites;
+	struct sbuf sbuf;
+	char symbuf[64];
+	long offset;
+	int error, i;
+
+	error = sysctl_wire_old_buffer(req, 0);
+	if (error != 0)
+		return (error);
+	sites = malloc(sizeof(malloc_sample_sites), M_TEMP, M_WAITOK);
+	mtx_lock(&malloc_sample_mtx);
+	bcopy(malloc_sample_sites, sites, sizeof(malloc_sample_sites));
+	mtx_unlock(&malloc_sample_mtx);
+
+	sbuf_new_for_sysctl(&sbuf, NULL, 128, req);
+	sbuf_printf(&sbuf, "%18s %10s %14s %10s %10s %12s  %s\n",
+	    "caller", "allocs", "bytes", "maxsize", "frees", "lifetime_ms",
+	    "symbol");
+	for (i = 0; i < MALLOC_SAMPLE_SITES; i++) {
+		msi = &sites[i];
+		if (msi->msi_caller == NULL)
+			continue;
+		sbuf_printf(&sbuf, "%18p %10ju %14ju %10zu %10ju %12ju",
+		    msi->msi_caller, (uintmax_t)msi->msi_allocs,
+		    (uintmax_t)msi->msi_bytes, msi->msi_maxsize,
+		    (uintmax_t)msi->msi_frees,
+		    msi->msi_frees == 0 ? (uintmax_t)0 :
+		    (uintmax_t)(msi->msi_lifetime * 1000 / hz /
+		    msi->msi_frees));
+		if (linker_search_symbol_name((caddr_t)msi->msi_caller,
+		    symbuf, sizeof(symbuf), &offset) == 0)
+			sbuf_printf(&sbuf, "  %s+%#lx", symbuf, offset);
+		sbuf_printf(&sbuf, "\n");
+	}
+	free(sites, M_TEMP);
+	error = sbuf_finish(&sbuf);
+	sbuf_delete(&sbuf);
+	return (error);
+}
+
 /*
  *	contigmalloc:
  *
@@ -593,6 +804,8 @@ void *
 	if (va != NULL)
 		va = redzone_setup(va, osize);
 #endif
+	if (__predict_false(malloc_sample_rate > 0) && va != NULL)
+		malloc_sample_alloc(va, size, __builtin_return_address(0));
 	return ((void *) va);
 }
 
@@ -655,6 +868,8 @@ malloc_domainset(size_t size, struct malloc_type *mtp, struct domainset *ds,
 			break;
 	} while (vm_domainset_iter_policy(&di, &domain) == 0);
 
+	if (__predict_false(malloc_sample_rate > 0) && ret != NULL)
+		malloc_sample_alloc(ret, size, __builtin_return_address(0));
 	return (ret);
 }
 
@@ -741,6 +956,9 @@ free(void *addr, struct malloc_type *mtp)
 	if (addr == NULL)
 		return;
 
+	if (__predict_false(malloc_sample_nused > 0))
+		malloc_sample_free(addr);
+
 	slab = vtoslab((vm_offset_t)addr & (~UMA_SLAB_MASK));
 	if (slab == NULL)
 		panic("free: address %p(%p) has not been allocated.\n",
@@ -774,6 +992,9 @@ free_domain(void *addr, struct malloc_type *mtp)
 	if (addr == NULL)
 		return;
 
+	if (__predict_false(malloc_sample_nused > 0))
+		malloc_sample_free(addr);
+
 	slab = vtoslab((vm_offset_t)addr & (~UMA_SLAB_MASK));
 	if (slab == NULL)
 		panic("free_domain: address %p(%p) has not been allocated.\n",
@@ -967,6 +1188,7 @@ mallocinit(void *dummy)
 	uint8_t indx;
 
 	mtx_init(&malloc_mtx, "malloc", NULL, MTX_DEF);
+	mtx_init(&malloc_sample_mtx, "malloc sample", NULL, MTX_DEF);
 
 	kmeminit();
 
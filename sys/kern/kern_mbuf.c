@@ -34,6 +34,7 @@ __FBSDID("$FreeBSD$");
 
 #include <sys/param.h>
 #include <sys/conf.h>
+#include <sys/counter.h>
 #include <sys/domainset.h>
 #include <sys/malloc.h>
 #include <sys/systm.h>
@@ -45,6 +46,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/lock.h>
 #include <sys/mutex.h>
 #include <sys/protosw.h>
+#include <sys/sbuf.h>
 #include <sys/smp.h>
 #include <sys/sysctl.h>
 
@@ -112,6 +114,19 @@ static quad_t maxmbufmem;	/* overall real memory limit for all mbufs */
 SYSCTL_QUAD(_kern_ipc, OID_AUTO, maxmbufmem, CTLFLAG_RDTUN | CTLFLAG_NOFETCH, &maxmbufmem, 0,
     "Maximum real memory allocatable to various mbuf types");
 
+static int mb_use_numa = 1;	/* steer mbuf slab allocations by domain */
+
+SYSCTL_INT(_kern_ipc, OID_AUTO, mb_use_numa, CTLFLAG_RDTUN | CTLFLAG_NOFETCH,
+    &mb_use_numa, 0,
+    "Prefer domain-local memory when growing the mbuf and cluster zones");
+
+/*
+ * Slab allocations satisfied from, and outside of, the domain of the
+ * requesting CPU.  Indexed by the domain the memory came from.
+ */
+static counter_u64_t mb_numa_local[MAXMEMDOM];
+static counter_u64_t mb_numa_remote[MAXMEMDOM];
+
 /*
  * tunable_mbinit() has to be run before any mbuf allocations are done.
  */
@@ -155,6 +170,8 @@ tunable_mbinit(void *dummy)
 	if (nmbufs < nmbclusters + nmbjumbop + nmbjumbo9 + nmbjumbo16)
 		nmbufs = lmax(maxmbufmem / MSIZE / 5,
 		    nmbclusters + nmbjumbop + nmbjumbo9 + nmbjumbo16);
+
+	TUNABLE_INT_FETCH("kern.ipc.mb_use_numa", &mb_use_numa);
 }
 SYSINIT(tunable_mbinit, SI_SUB_KMEM, SI_ORDER_MIDDLE, tunable_mbinit, NULL);
 
@@ -286,6 +303,8 @@ static int	mb_zinit_pack(void *, int, int);
 static void	mb_zfini_pack(void *, int);
 static void	mb_reclaim(uma_zone_t, int);
 static void    *mbuf_jumbo_alloc(uma_zone_t, vm_size_t, int, uint8_t *, int);
+static void    *mbuf_page_alloc(uma_zone_t, vm_size_t, int, uint8_t *, int);
+static void	mb_numa_count(int);
 
 /* Ensure that MSIZE is a power of 2. */
 CTASSERT((((MSIZE - 1) ^ MSIZE) + 1) >> 1 == MSIZE);
@@ -296,6 +315,19 @@ CTASSERT((((MSIZE - 1) ^ MSIZE) + 1) >> 1 == MSIZE);
 static void
 mbuf_init(void *dummy)
 {
+	int domain, numa_flag;
+
+	/*
+	 * On multi-domain machines steer slab growth of the mbuf and
+	 * cluster zones towards the domain of the allocating CPU; iflib
+	 * binds RX refill to CPUs local to the device, so first-touch
+	 * keeps packet buffers on the device's domain.
+	 */
+	numa_flag = (mb_use_numa && vm_ndomains > 1) ? UMA_ZONE_NUMA : 0;
+	for (domain = 0; domain < vm_ndomains; domain++) {
+		mb_numa_local[domain] = counter_u64_alloc(M_WAITOK);
+		mb_numa_remote[domain] = counter_u64_alloc(M_WAITOK);
+	}
 
 	/*
 	 * Configure UMA zones for Mbufs, Clusters, and Packets.
@@ -307,7 +339,8 @@ mbuf_init(void *dummy)
 #else
 	    NULL, NULL,
 #endif
-	    MSIZE - 1, UMA_ZONE_MAXBUCKET);
+	    MSIZE - 1, UMA_ZONE_MAXBUCKET | numa_flag);
+	uma_zone_set_allocf(zone_mbuf, mbuf_page_alloc);
 	if (nmbufs > 0)
 		nmbufs = uma_zone_set_max(zone_mbuf, nmbufs);
 	uma_zone_set_warning(zone_mbuf, "kern.ipc.nmbufs limit reached");
@@ -320,7 +353,8 @@ mbuf_init(void *dummy)
 #else
 	    NULL, NULL, NULL,
 #endif
-	    UMA_ALIGN_PTR, 0);
+	    UMA_ALIGN_PTR, numa_flag);
+	uma_zone_set_allocf(zone_clust, mbuf_page_alloc);
 	if (nmbclusters > 0)
 		nmbclusters = uma_zone_set_max(zone_clust, nmbclusters);
 	uma_zone_set_warning(zone_clust, "kern.ipc.nmbclusters limit reached");
@@ -337,7 +371,8 @@ mbuf_init(void *dummy)
 #else
 	    NULL, NULL, NULL,
 #endif
-	    UMA_ALIGN_PTR, 0);
+	    UMA_ALIGN_PTR, numa_flag);
+	uma_zone_set_allocf(zone_jumbop, mbuf_page_alloc);
 	if (nmbjumbop > 0)
 		nmbjumbop = uma_zone_set_max(zone_jumbop, nmbjumbop);
 	uma_zone_set_warning(zone_jumbop, "kern.ipc.nmbjumbop limit reached");
@@ -350,7 +385,7 @@ mbuf_init(void *dummy)
 #else
 	    NULL, NULL, NULL,
 #endif
-	    UMA_ALIGN_PTR, 0);
+	    UMA_ALIGN_PTR, numa_flag);
 	uma_zone_set_allocf(zone_jumbo9, mbuf_jumbo_alloc);
 	if (nmbjumbo9 > 0)
 		nmbjumbo9 = uma_zone_set_max(zone_jumbo9, nmbjumbo9);
@@ -364,7 +399,7 @@ mbuf_init(void *dummy)
 #else
 	    NULL, NULL, NULL,
 #endif
-	    UMA_ALIGN_PTR, 0);
+	    UMA_ALIGN_PTR, numa_flag);
 	uma_zone_set_allocf(zone_jumbo16, mbuf_jumbo_alloc);
 	if (nmbjumbo16 > 0)
 		nmbjumbo16 = uma_zone_set_max(zone_jumbo16, nmbjumbo16);
@@ -578,6 +613,42 @@ netdump_mbuf_reinit(int nmbuf, int nclust, int clsize)
 }
 #endif /* NETDUMP */
 
+/*
+ * Account a slab allocation against the domain of the requesting CPU.
+ * This only runs when a zone has to grow, so the overhead is not on the
+ * per-packet path, and a stale CPU lookup merely blurs the statistic.
+ */
+static void
+mb_numa_count(int domain)
+{
+
+	if (domain == PCPU_GET(domain))
+		counter_u64_add(mb_numa_local[domain], 1);
+	else
+		counter_u64_add(mb_numa_remote[domain], 1);
+}
+
+static int
+sysctl_mb_numa_stats(SYSCTL_HANDLER_ARGS)
+{
+	struct sbuf sb;
+	int domain, error;
+
+	sbuf_new_for_sysctl(&sb, NULL, 128, req);
+	for (domain = 0; domain < vm_ndomains; domain++)
+		sbuf_printf(&sb, "%sdomain%d: local %ju remote %ju",
+		    domain == 0 ? "" : ", ", domain,
+		    (uintmax_t)counter_u64_fetch(mb_numa_local[domain]),
+		    (uintmax_t)counter_u64_fetch(mb_numa_remote[domain]));
+	error = sbuf_finish(&sb);
+	sbuf_delete(&sb);
+	return (error);
+}
+SYSCTL_PROC(_kern_ipc, OID_AUTO, mb_numa_stats,
+    CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+    sysctl_mb_numa_stats, "A",
+    "Locality of mbuf and cluster slab allocations, per domain");
+
 /*
  * UMA backend page allocator for the jumbo frame zones.
  *
@@ -589,6 +660,7 @@ mbuf_jumbo_alloc(uma_zone_t zone, vm_size_t bytes, int domain, uint8_t *flags,
     int wait)
 {
 
+	mb_numa_count(domain);
 	/* Inform UMA that this allocator uses kernel_map/object. */
 	*flags = UMA_SLAB_KERNEL;
 	return ((void *)kmem_alloc_contig_domainset(DOMAINSET_FIXED(domain),
@@ -596,6 +668,22 @@ mbuf_jumbo_alloc(uma_zone_t zone, vm_size_t bytes, int domain, uint8_t *flags,
 	    VM_MEMATTR_DEFAULT));
 }
 
+/*
+ * UMA backend page allocator for the mbuf, cluster and page size jumbo
+ * zones.  Equivalent to the stock UMA page allocator, plus locality
+ * accounting for kern.ipc.mb_numa_stats.
+ */
+static void *
+mbuf_page_alloc(uma_zone_t zone, vm_size_t bytes, int domain, uint8_t *flags,
+    int wait)
+{
+
+	mb_numa_count(domain);
+	*flags = UMA_SLAB_KERNEL;
+	return ((void *)kmem_malloc_domainset(DOMAINSET_FIXED(domain), bytes,
+	    wait));
+}
+
 /*
  * Constructor for Mbuf master zone.
  *
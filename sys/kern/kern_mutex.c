@@ -150,6 +150,20 @@ SYSCTL_INT(_debug_mtx, OID_AUTO, delay_max, CTLFLAG_RW, &mtx_delay.max,
     0, "");
 
 LOCK_DELAY_SYSINIT_DEFAULT(mtx_delay);
+
+static u_int __read_frequently mtx_delay_remote_mult = 1;
+static u_long mtx_delay_spin_local;
+static u_long mtx_delay_spin_remote;
+
+SYSCTL_UINT(_debug_mtx, OID_AUTO, delay_remote_mult, CTLFLAG_RW,
+    &mtx_delay_remote_mult, 0,
+    "Backoff multiplier for waiters on a remote memory domain");
+SYSCTL_ULONG(_debug_mtx, OID_AUTO, spin_local, CTLFLAG_RD,
+    &mtx_delay_spin_local, 0,
+    "Adaptive spin episodes against an owner on the local domain");
+SYSCTL_ULONG(_debug_mtx, OID_AUTO, spin_remote, CTLFLAG_RD,
+    &mtx_delay_spin_remote, 0,
+    "Adaptive spin episodes against an owner on a remote domain");
 #endif
 
 static SYSCTL_NODE(_debug, OID_AUTO, mtx_spin, CTLFLAG_RD, NULL,
@@ -164,6 +178,60 @@ SYSCTL_INT(_debug_mtx_spin, OID_AUTO, delay_max, CTLFLAG_RW,
 
 LOCK_DELAY_SYSINIT_DEFAULT(mtx_spin_delay);
 
+static u_int __read_frequently mtx_spin_delay_remote_mult = 1;
+static u_long mtx_spin_spin_local;
+static u_long mtx_spin_spin_remote;
+
+SYSCTL_UINT(_debug_mtx_spin, OID_AUTO, delay_remote_mult, CTLFLAG_RW,
+    &mtx_spin_delay_remote_mult, 0,
+    "Backoff multiplier for waiters on a remote memory domain");
+SYSCTL_ULONG(_debug_mtx_spin, OID_AUTO, spin_local, CTLFLAG_RD,
+    &mtx_spin_spin_local, 0,
+    "Spin episodes against an owner on the local domain");
+SYSCTL_ULONG(_debug_mtx_spin, OID_AUTO, spin_remote, CTLFLAG_RD,
+    &mtx_spin_spin_remote, 0,
+    "Spin episodes against an owner on a remote domain");
+
+/*
+ * On machines with more than one memory domain, a waiter spinning on a
+ * mutex owned by a thread on another domain drags the lock cacheline
+ * across the interconnect on every poll, slowing down the very critical
+ * section it is waiting on.  Remote waiters therefore stretch each
+ * backoff step by a per-class multiplier, leaving the line to the owner
+ * and to local waiters, which can reacquire it cheaply.  The multiplier
+ * defaults to off and is raised at boot once the topology is known.
+ */
+#define	MTX_REMOTE_MULT_DEFAULT	4
+
+static bool
+mtx_owner_remote(struct thread *owner)
+{
+	int cpu;
+
+	cpu = owner->td_oncpu;
+	if (cpu == NOCPU)
+		return (false);
+	return (pcpu_find(cpu)->pc_domain != PCPU_GET(domain));
+}
+
+static void
+mtx_remote_mult_init(void *dummy __unused)
+{
+	int c;
+
+	CPU_FOREACH(c) {
+		if (pcpu_find(c)->pc_domain != 0) {
+#ifdef ADAPTIVE_MUTEXES
+			mtx_delay_remote_mult = MTX_REMOTE_MULT_DEFAULT;
+#endif
+			mtx_spin_delay_remote_mult = MTX_REMOTE_MULT_DEFAULT;
+			break;
+		}
+	}
+}
+SYSINIT(mtx_remote_mult, SI_SUB_SMP, SI_ORDER_ANY, mtx_remote_mult_init,
+    NULL);
+
 /*
  * System-wide mutexes
  */
@@ -480,6 +548,9 @@ __mtx_lock_sleep(volatile uintptr_t *c, uintptr_t v)
 #if defined(ADAPTIVE_MUTEXES) || defined(KDTRACE_HOOKS)
 	struct lock_delay_arg lda;
 #endif
+#ifdef ADAPTIVE_MUTEXES
+	u_int rmult;
+#endif
 #ifdef KDTRACE_HOOKS
 	u_int sleep_cnt = 0;
 	int64_t sleep_time = 0;
@@ -488,6 +559,8 @@ __mtx_lock_sleep(volatile uintptr_t *c, uintptr_t v)
 #if defined(KDTRACE_HOOKS) || defined(LOCK_PROFILING)
 	int doing_lockprof = 0;
 #endif
+	uint64_t csample_start = 0;
+	int csampled = 0;
 
 	td = curthread;
 	tid = (uintptr_t)td;
@@ -542,6 +615,9 @@ __mtx_lock_sleep(volatile uintptr_t *c, uintptr_t v)
 #endif
 	lock_profile_obtain_lock_failed(&m->lock_object,
 		    &contested, &waittime);
+	csampled = lock_csample_enter();
+	if (__predict_false(csampled))
+		csample_start = cpu_ticks();
 	if (LOCK_LOG_TEST(&m->lock_object, opts))
 		CTR4(KTR_LOCK,
 		    "_mtx_lock_sleep: %s contested (lock=%p) at %s:%d",
@@ -571,8 +647,18 @@ __mtx_lock_sleep(volatile uintptr_t *c, uintptr_t v)
 			    sched_tdname((struct thread *)tid),
 			    "spinning", "lockname:\"%s\"",
 			    m->lock_object.lo_name);
+			rmult = 1;
+			if (__predict_false(mtx_delay_remote_mult > 1) &&
+			    mtx_owner_remote(owner)) {
+				rmult = mtx_delay_remote_mult;
+				mtx_delay_spin_remote++;
+			} else
+				mtx_delay_spin_local++;
 			do {
 				lock_delay(&lda);
+				if (__predict_false(rmult > 1))
+					lock_delay_spin(lda.delay *
+					    (rmult - 1));
 				v = MTX_READ_VALUE(m);
 				owner = lv_mtx_owner(v);
 			} while (v != MTX_UNOWNED && TD_IS_RUNNING(owner));
@@ -643,6 +729,9 @@ retry_turnstile:
 #endif
 		v = MTX_READ_VALUE(m);
 	}
+	if (__predict_false(csampled))
+		lock_csample_record(&m->lock_object,
+		    (uintptr_t)__builtin_return_address(0), csample_start);
 #if defined(KDTRACE_HOOKS) || defined(LOCK_PROFILING)
 	if (__predict_true(!doing_lockprof))
 		return;
@@ -682,6 +771,7 @@ _mtx_lock_spin_cookie(volatile uintptr_t *c, uintptr_t v)
 	struct mtx *m;
 	struct lock_delay_arg lda;
 	uintptr_t tid;
+	u_int rmult;
 #ifdef LOCK_PROFILING
 	int contested = 0;
 	uint64_t waittime = 0;
@@ -692,6 +782,8 @@ _mtx_lock_spin_cookie(volatile uintptr_t *c, uintptr_t v)
 #if defined(KDTRACE_HOOKS) || defined(LOCK_PROFILING)
 	int doing_lockprof = 0;
 #endif
+	uint64_t csample_start = 0;
+	int csampled = 0;
 
 	tid = (uintptr_t)curthread;
 	m = mtxlock2mtx(c);
@@ -732,6 +824,9 @@ _mtx_lock_spin_cookie(volatile uintptr_t *c, uintptr_t v)
 	PMC_SOFT_CALL( , , lock, failed);
 #endif
 	lock_profile_obtain_lock_failed(&m->lock_object, &contested, &waittime);
+	csampled = lock_csample_enter();
+	if (__predict_false(csampled))
+		csample_start = cpu_ticks();
 
 	for (;;) {
 		if (v == MTX_UNOWNED) {
@@ -741,9 +836,19 @@ _mtx_lock_spin_cookie(volatile uintptr_t *c, uintptr_t v)
 		}
 		/* Give interrupts a chance while we spin. */
 		spinlock_exit();
+		rmult = 1;
+		if (__predict_false(mtx_spin_delay_remote_mult > 1) &&
+		    mtx_owner_remote(lv_mtx_owner(v))) {
+			rmult = mtx_spin_delay_remote_mult;
+			mtx_spin_spin_remote++;
+		} else
+			mtx_spin_spin_local++;
 		do {
 			if (__predict_true(lda.spin_cnt < 10000000)) {
 				lock_delay(&lda);
+				if (__predict_false(rmult > 1))
+					lock_delay_spin(lda.delay *
+					    (rmult - 1));
 			} else {
 				_mtx_lock_indefinite_check(m, &lda);
 			}
@@ -752,6 +857,10 @@ _mtx_lock_spin_cookie(volatile uintptr_t *c, uintptr_t v)
 		spinlock_enter();
 	}
 
+	if (__predict_false(csampled))
+		lock_csample_record(&m->lock_object,
+		    (uintptr_t)__builtin_return_address(0), csample_start);
+
 	if (LOCK_LOG_TEST(&m->lock_object, opts))
 		CTR1(KTR_LOCK, "_mtx_lock_spin: %p spin done", m);
 	KTR_STATE0(KTR_SCHED, "thread", sched_tdname((struct thread *)tid),
@@ -2895,6 +2895,75 @@ errout:
 	return (error);
 }
 
+/*
+ * Report the number of NUMA-local and NUMA-remote page allocations
+ * charged to a process, as two u_longs: local first, remote second.
+ * Counters of exited threads are kept in the proc.
+ */
+static int
+sysctl_kern_proc_numa(SYSCTL_HANDLER_ARGS)
+{
+	int *name = (int *)arg1;
+	u_int namelen = arg2;
+	struct thread *td;
+	struct proc *p;
+	u_long stats[2];
+	int error;
+
+	if (namelen != 1)
+		return (EINVAL);
+
+	error = pget((pid_t)name[0], PGET_WANTREAD, &p);
+	if (error != 0)
+		return (error);
+
+	PROC_LOCK(p);
+	PROC_STATLOCK(p);
+	stats[0] = p->p_numa_local;
+	stats[1] = p->p_numa_remote;
+	PROC_STATUNLOCK(p);
+	FOREACH_THREAD_IN_PROC(p, td) {
+		stats[0] += td->td_numa_local;
+		stats[1] += td->td_numa_remote;
+	}
+	PROC_UNLOCK(p);
+	PRELE(p);
+
+	return (SYSCTL_OUT(req, stats, sizeof(stats)));
+}
+
+/*
+ * Report the number of superpage mapping promotions and demotions in a
+ * process's address space, as two u_longs: promotions first, demotions
+ * second.  The counters are reset on exec along with the vmspace.
+ */
+static int
+sysctl_kern_proc_superpage(SYSCTL_HANDLER_ARGS)
+{
+	int *name = (int *)arg1;
+	u_int namelen = arg2;
+	struct vmspace *vm;
+	struct proc *p;
+	u_long stats[2];
+	int error;
+
+	if (namelen != 1)
+		return (EINVAL);
+
+	error = pget((pid_t)name[0], PGET_WANTREAD, &p);
+	if (error != 0)
+		return (error);
+	vm = vmspace_acquire_ref(p);
+	PRELE(p);
+	if (vm == NULL)
+		return (ESRCH);
+	stats[0] = vm->vm_superpage_promotions;
+	stats[1] = vm->vm_superpage_demotions;
+	vmspace_free(vm);
+
+	return (SYSCTL_OUT(req, stats, sizeof(stats)));
+}
+
 static int
 sysctl_kern_proc_sigtramp(SYSCTL_HANDLER_ARGS)
 {
@@ -3062,6 +3131,14 @@ static SYSCTL_NODE(_kern_proc, KERN_PROC_SIGTRAMP, sigtramp, CTLFLAG_RD |
 	CTLFLAG_MPSAFE, sysctl_kern_proc_sigtramp,
 	"Process signal trampoline location");
 
+static SYSCTL_NODE(_kern_proc, KERN_PROC_NUMA, numa, CTLFLAG_RD |
+	CTLFLAG_MPSAFE, sysctl_kern_proc_numa,
+	"Process NUMA-local and NUMA-remote page allocation counts");
+
+static SYSCTL_NODE(_kern_proc, KERN_PROC_SUPERPAGE, superpage, CTLFLAG_RD |
+	CTLFLAG_MPSAFE, sysctl_kern_proc_superpage,
+	"Process superpage mapping promotion and demotion counts");
+
 int allproc_gen;
 
 /*
@@ -53,6 +53,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/turnstile.h>
 #include <sys/lock_profile.h>
 #include <machine/cpu.h>
+#include <vm/uma.h>
 
 #ifdef DDB
 #include <ddb/ddb.h>
@@ -806,6 +807,201 @@ _rm_assert(const struct rmlock *rm, int what, const char *file, int line)
 }
 #endif /* INVARIANT_SUPPORT */
 
+/*
+ * Read-mostly sleepable locks.
+ *
+ * These are a distributed-reader counterpart to rw and sx locks for
+ * read-mostly data: each CPU keeps its own reader count, so read
+ * acquisitions touch only a CPU-local cacheline instead of bouncing one
+ * atomic among all readers.  Unlike rm locks, readers do not register
+ * trackers and may sleep while holding the lock.  The price is paid by
+ * writers, which interrupt every CPU to collect the distributed counts
+ * and then wait for the aggregate to drain, so this is only suitable
+ * for data that is reconfigured rarely but read constantly.
+ *
+ * A reader marks itself "in flux" around the read of rms_writers and
+ * the update of its CPU-local count; a writer's rendezvous spins until
+ * the flux flag clears, which bounds the race window to a few
+ * instructions executed inside a critical section.  Once rms_writers is
+ * non-zero, readers fall back to sleeping on the internal mutex.
+ */
+
+static struct rmslock_pcpu *
+rms_int_pcpu(struct rmslock *rms)
+{
+
+	CRITICAL_ASSERT(curthread);
+	return (zpcpu_get(rms->rms_pcpu));
+}
+
+void
+rms_init(struct rmslock *rms, const char *name)
+{
+
+	rms->rms_owner = NULL;
+	rms->rms_writers = 0;
+	rms->rms_readers = 0;
+	mtx_init(&rms->rms_mtx, name, NULL, MTX_DEF | MTX_NEW);
+	rms->rms_pcpu = uma_zalloc_pcpu(pcpu_zone_64, M_WAITOK | M_ZERO);
+}
+
+void
+rms_destroy(struct rmslock *rms)
+{
+
+	MPASS(rms->rms_writers == 0);
+	MPASS(rms->rms_readers == 0);
+	mtx_destroy(&rms->rms_mtx);
+	uma_zfree_pcpu(pcpu_zone_64, rms->rms_pcpu);
+}
+
+static void __noinline
+rms_rlock_fallback(struct rmslock *rms)
+{
+
+	rms_int_pcpu(rms)->rmsp_influx = 0;
+	critical_exit();
+
+	mtx_lock(&rms->rms_mtx);
+	while (rms->rms_writers > 0)
+		msleep(&rms->rms_readers, &rms->rms_mtx, PUSER - 1,
+		    "rmsrlk", 0);
+	/*
+	 * The mutex excludes a concurrent rendezvous, so the local count
+	 * may be updated without the flux protocol.
+	 */
+	critical_enter();
+	rms_int_pcpu(rms)->rmsp_readers++;
+	mtx_unlock(&rms->rms_mtx);
+	critical_exit();
+}
+
+void
+rms_rlock(struct rmslock *rms)
+{
+	struct rmslock_pcpu *pcpu;
+
+	MPASS(rms->rms_owner != curthread);
+
+	critical_enter();
+	pcpu = rms_int_pcpu(rms);
+	pcpu->rmsp_influx = 1;
+	__compiler_membar();
+	if (__predict_false(rms->rms_writers > 0)) {
+		rms_rlock_fallback(rms);
+		return;
+	}
+	pcpu->rmsp_readers++;
+	__compiler_membar();
+	pcpu->rmsp_influx = 0;
+	critical_exit();
+}
+
+static void __noinline
+rms_runlock_fallback(struct rmslock *rms)
+{
+
+	rms_int_pcpu(rms)->rmsp_influx = 0;
+	critical_exit();
+
+	/*
+	 * A pending writer's rendezvous already moved our CPU-local
+	 * count into the aggregate; drop the reference there and wake
+	 * the writer once the last reader is gone.
+	 */
+	mtx_lock(&rms->rms_mtx);
+	MPASS(rms->rms_writers > 0);
+	MPASS(rms->rms_readers > 0);
+	rms->rms_readers--;
+	if (rms->rms_readers == 0)
+		wakeup_one(&rms->rms_writers);
+	mtx_unlock(&rms->rms_mtx);
+}
+
+void
+rms_runlock(struct rmslock *rms)
+{
+	struct rmslock_pcpu *pcpu;
+
+	critical_enter();
+	pcpu = rms_int_pcpu(rms);
+	pcpu->rmsp_influx = 1;
+	__compiler_membar();
+	if (__predict_false(rms->rms_writers > 0)) {
+		rms_runlock_fallback(rms);
+		return;
+	}
+	pcpu->rmsp_readers--;
+	__compiler_membar();
+	pcpu->rmsp_influx = 0;
+	critical_exit();
+}
+
+static void
+rms_wlock_collect(void *arg)
+{
+	struct rmslock *rms;
+	struct rmslock_pcpu *pcpu;
+
+	rms = arg;
+	pcpu = zpcpu_get(rms->rms_pcpu);
+	while (pcpu->rmsp_influx)
+		cpu_spinwait();
+	atomic_add_int(&rms->rms_readers, pcpu->rmsp_readers);
+	pcpu->rmsp_readers = 0;
+}
+
+void
+rms_wlock(struct rmslock *rms)
+{
+
+	MPASS(rms->rms_owner != curthread);
+
+	mtx_lock(&rms->rms_mtx);
+	rms->rms_writers++;
+	if (rms->rms_writers > 1) {
+		/*
+		 * Another writer holds or is draining the lock; readers
+		 * stay in their fallback path until we are done, so the
+		 * aggregate is zero when we are woken.
+		 */
+		msleep(&rms->rms_owner, &rms->rms_mtx, (PUSER - 1) | PDROP,
+		    "rmswlk", 0);
+		MPASS(rms->rms_readers == 0);
+		goto out_grab;
+	}
+
+	MPASS(rms->rms_readers == 0);
+	smp_rendezvous(smp_no_rendezvous_barrier, rms_wlock_collect,
+	    smp_no_rendezvous_barrier, rms);
+
+	if (rms->rms_readers > 0)
+		msleep(&rms->rms_writers, &rms->rms_mtx, (PUSER - 1) | PDROP,
+		    "rmswlk", 0);
+	else
+		mtx_unlock(&rms->rms_mtx);
+out_grab:
+	MPASS(rms->rms_owner == NULL);
+	rms->rms_owner = curthread;
+}
+
+void
+rms_wunlock(struct rmslock *rms)
+{
+
+	mtx_lock(&rms->rms_mtx);
+	MPASS(rms->rms_owner == curthread);
+	MPASS(rms->rms_writers >= 1);
+	MPASS(rms->rms_readers == 0);
+	rms->rms_owner = NULL;
+	rms->rms_writers--;
+	if (rms->rms_writers > 0)
+		wakeup_one(&rms->rms_owner);
+	else
+		wakeup(&rms->rms_readers);
+	mtx_unlock(&rms->rms_mtx);
+}
+
 #ifdef DDB
 static void
 print_tracker(struct rm_priotracker *tr)
@@ -448,6 +448,8 @@ __rw_rlock_hard(struct rwlock *rw, struct thread *td, uintptr_t v
 	uintptr_t state = 0;
 	int doing_lockprof = 0;
 #endif
+	uint64_t csample_start = 0;
+	int csampled = 0;
 
 #ifdef KDTRACE_HOOKS
 	if (LOCKSTAT_PROFILE_ENABLED(rw__acquire)) {
@@ -477,6 +479,9 @@ __rw_rlock_hard(struct rwlock *rw, struct thread *td, uintptr_t v
 #endif
 	lock_profile_obtain_lock_failed(&rw->lock_object,
 	    &contested, &waittime);
+	csampled = lock_csample_enter();
+	if (__predict_false(csampled))
+		csample_start = cpu_ticks();
 
 	for (;;) {
 		if (__rw_rlock_try(rw, td, &v, false LOCK_FILE_LINE_ARG))
@@ -624,6 +629,9 @@ retry_ts:
 			    __func__, rw);
 		v = RW_READ_VALUE(rw);
 	}
+	if (__predict_false(csampled))
+		lock_csample_record(&rw->lock_object,
+		    (uintptr_t)__builtin_return_address(0), csample_start);
 #if defined(KDTRACE_HOOKS) || defined(LOCK_PROFILING)
 	if (__predict_true(!doing_lockprof))
 		return;
@@ -916,7 +924,9 @@ __rw_wlock_hard(volatile uintptr_t *c, uintptr_t v LOCK_FILE_LINE_ARG_DEF)
 	uintptr_t state = 0;
 	int doing_lockprof = 0;
 #endif
+	uint64_t csample_start = 0;
 	int extra_work = 0;
+	int csampled = 0;
 
 	tid = (uintptr_t)curthread;
 	rw = rwlock2rw(c);
@@ -970,6 +980,9 @@ __rw_wlock_hard(volatile uintptr_t *c, uintptr_t v LOCK_FILE_LINE_ARG_DEF)
 #endif
 	lock_profile_obtain_lock_failed(&rw->lock_object,
 	    &contested, &waittime);
+	csampled = lock_csample_enter();
+	if (__predict_false(csampled))
+		csample_start = cpu_ticks();
 
 	for (;;) {
 		if (v == RW_UNLOCKED) {
@@ -1156,6 +1169,9 @@ retry_ts:
 #endif
 		v = RW_READ_VALUE(rw);
 	}
+	if (__predict_false(csampled))
+		lock_csample_record(&rw->lock_object,
+		    (uintptr_t)__builtin_return_address(0), csample_start);
 	if (__predict_true(!extra_work))
 		return;
 #ifdef ADAPTIVE_RWLOCKS
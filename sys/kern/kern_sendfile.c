@@ -44,6 +44,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/param.h>
 #include <sys/systm.h>
 #include <sys/capsicum.h>
+#include <sys/event.h>
 #include <sys/kernel.h>
 #include <sys/lock.h>
 #include <sys/mutex.h>
@@ -93,6 +94,7 @@ struct sf_io {
 	volatile u_int	nios;
 	u_int		error;
 	int		npages;
+	int		pages_read;	/* pages paged in from disk */
 	struct socket	*so;
 	struct mbuf	*m;
 	vm_page_t	pa[];
@@ -318,6 +320,25 @@ sendfile_iodone(void *arg, vm_page_t *pg, int count, int error)
 		(void )(so->so_proto->pr_usrreqs->pru_ready)(so, sfio->m,
 		    sfio->npages);
 
+	/*
+	 * Post the completion to EVFILT_SENDFILE knotes, if any.  The
+	 * filter accumulates completions, so a listener draining many
+	 * concurrent ranges sees them coalesced into single kevents
+	 * instead of taking one wakeup per I/O.
+	 */
+	if (!SOLISTENING(so)) {
+		long hint;
+
+		hint = sfio->pages_read != 0 ?
+		    NOTE_SENDFILE_PAGEIN : NOTE_SENDFILE_CACHE;
+		if (sfio->error)
+			hint |= NOTE_SENDFILE_ERROR;
+		SOCKBUF_LOCK(&so->so_snd);
+		if (so->so_snd.sb_flags & SB_KNOTE)
+			KNOTE_LOCKED(&so->so_wrsel.si_note, hint);
+		SOCKBUF_UNLOCK(&so->so_snd);
+	}
+
 	SOCK_LOCK(so);
 	sorele(so);
 	CURVNET_RESTORE();
@@ -421,6 +442,7 @@ sendfile_swapin(vm_object_t obj, struct sf_io *sfio, off_t off, off_t len,
 
 		SFSTAT_INC(sf_iocnt);
 		SFSTAT_ADD(sf_pages_read, count);
+		sfio->pages_read += count;
 		if (i + count == npages)
 			SFSTAT_ADD(sf_rhpages_read, rhpages);
 
@@ -760,6 +782,7 @@ retry_space:
 		refcount_init(&sfio->nios, 1);
 		sfio->so = so;
 		sfio->error = 0;
+		sfio->pages_read = 0;
 
 		nios = sendfile_swapin(obj, sfio, off, space, npages, rhpages,
 		    flags);
@@ -966,6 +966,28 @@ sigdflt(struct sigacts *ps, int sig)
 	SIGDELSET(ps->ps_siginfo, sig);
 }
 
+/*
+ * Reset caught signals to their default disposition.  Held signals
+ * remain held through td_sigmask (unless they were caught, and are now
+ * ignored by default).
+ */
+void
+sig_drop_caught(struct proc *p)
+{
+	int sig;
+	struct sigacts *ps;
+
+	ps = p->p_sigacts;
+	PROC_LOCK_ASSERT(p, MA_OWNED);
+	mtx_assert(&ps->ps_mtx, MA_OWNED);
+	while (SIGNOTEMPTY(ps->ps_sigcatch)) {
+		sig = sig_ffs(&ps->ps_sigcatch);
+		sigdflt(ps, sig);
+		if ((sigprop(sig) & SIGPROP_IGNORE) != 0)
+			sigqueue_delete_proc(p, sig);
+	}
+}
+
 /*
  * Reset signals for an exec of the specified process.
  */
@@ -977,20 +999,10 @@ execsigs(struct proc *p)
 	int sig;
 	struct thread *td;
 
-	/*
-	 * Reset caught signals.  Held signals remain held
-	 * through td_sigmask (unless they were caught,
-	 * and are now ignored by default).
-	 */
 	PROC_LOCK_ASSERT(p, MA_OWNED);
 	ps = p->p_sigacts;
 	mtx_lock(&ps->ps_mtx);
-	while (SIGNOTEMPTY(ps->ps_sigcatch)) {
-		sig = sig_ffs(&ps->ps_sigcatch);
-		sigdflt(ps, sig);
-		if ((sigprop(sig) & SIGPROP_IGNORE) != 0)
-			sigqueue_delete_proc(p, sig);
-	}
+	sig_drop_caught(p);
 
 	/*
 	 * As CloudABI processes cannot modify signal handlers, fully
@@ -109,6 +109,14 @@ static int sysctl_root(SYSCTL_HANDLER_ARGS);
 /* Root list */
 struct sysctl_oid_list sysctl__children = SLIST_HEAD_INITIALIZER(&sysctl__children);
 
+/*
+ * Bumped under the sysctl write lock on every addition to or removal from
+ * the MIB tree.  Exported as sysctl.generation, so that applications which
+ * cache name to MIB translations can cheaply detect whether their cache is
+ * still valid.
+ */
+static uint64_t sysctl_generation;
+
 static int	sysctl_remove_oid_locked(struct sysctl_oid *oidp, int del,
 		    int recurse);
 static int	sysctl_old_kernel(struct sysctl_req *, const void *, size_t);
@@ -494,6 +502,7 @@ retry:
 		SLIST_INSERT_AFTER(q, oidp, oid_link);
 	else
 		SLIST_INSERT_HEAD(parent, oidp, oid_link);
+	sysctl_generation++;
 
 	if ((oidp->oid_kind & CTLTYPE) != CTLTYPE_NODE &&
 #ifdef VIMAGE
@@ -554,6 +563,7 @@ sysctl_unregister_oid(struct sysctl_oid *oidp)
 			if (p == oidp) {
 				SLIST_REMOVE(oidp->oid_parent, oidp,
 				    sysctl_oid, oid_link);
+				sysctl_generation++;
 				error = 0;
 				break;
 			}
@@ -1331,6 +1341,96 @@ sysctl_sysctl_oidlabel(SYSCTL_HANDLER_ARGS)
 static SYSCTL_NODE(_sysctl, 6, oidlabel,
     CTLFLAG_RD | CTLFLAG_MPSAFE | CTLFLAG_CAPRD, sysctl_sysctl_oidlabel, "");
 
+static int
+sysctl_sysctl_generation(SYSCTL_HANDLER_ARGS)
+{
+
+	return (SYSCTL_OUT(req, &sysctl_generation,
+	    sizeof(sysctl_generation)));
+}
+
+SYSCTL_PROC(_sysctl, 7, generation,
+    CTLTYPE_U64 | CTLFLAG_RD | CTLFLAG_MPSAFE | CTLFLAG_CAPRD, 0, 0,
+    sysctl_sysctl_generation, "QU", "");
+
+/*
+ * Resolve an array of MIBs in a single call; see the description of the
+ * buffer layout in <sys/sysctl.h>.  Each entry is processed exactly as if
+ * it had been passed to sysctl(2) by itself, including all permission
+ * checks, but only reads are possible.  Failure to resolve one entry is
+ * reported in that entry's result header and does not abort the rest of
+ * the batch.
+ */
+static int
+sysctl_sysctl_getbatch(SYSCTL_HANDLER_ARGS)
+{
+	static const uint8_t zeropad[8];
+	struct sysctl_batch_ent ent;
+	struct sysctl_batch_res res;
+	void *buf;
+	size_t buflen, len, outlen;
+	u_int i, nentries;
+	int error, tries;
+
+	if (req->newlen == 0)
+		return (ENOENT);
+	if (req->newlen % sizeof(ent) != 0)
+		return (EINVAL);
+	nentries = req->newlen / sizeof(ent);
+
+	buf = NULL;
+	buflen = 0;
+	error = 0;
+	for (i = 0; i < nentries; i++) {
+		error = SYSCTL_IN(req, &ent, sizeof(ent));
+		if (error != 0)
+			break;
+		res.be_error = (ent.be_namelen < 2 ||
+		    ent.be_namelen > CTL_MAXNAME) ? EINVAL : 0;
+		outlen = 0;
+		for (tries = 0; res.be_error == 0; tries++) {
+			/* Ask the handler how much space it needs. */
+			len = 0;
+			res.be_error = kernel_sysctl(req->td, ent.be_name,
+			    ent.be_namelen, NULL, NULL, NULL, 0, &len, 0);
+			if (res.be_error != 0 || len == 0)
+				break;
+			if (len > buflen) {
+				free(buf, M_SYSCTL);
+				/* Overshoot to absorb growing data. */
+				buflen = len + len / 4;
+				buf = malloc(buflen, M_SYSCTL, M_WAITOK);
+			}
+			outlen = buflen;
+			res.be_error = kernel_sysctl(req->td, ent.be_name,
+			    ent.be_namelen, buf, &outlen, NULL, 0, &outlen, 0);
+			if (res.be_error != ENOMEM)
+				break;
+			/* The data grew in the meantime; take another lap. */
+			outlen = 0;
+			if (tries == 3)
+				break;
+		}
+		if (res.be_error != 0)
+			outlen = 0;
+		res.be_len = outlen;
+		error = SYSCTL_OUT(req, &res, sizeof(res));
+		if (error == 0 && outlen != 0)
+			error = SYSCTL_OUT(req, buf, outlen);
+		if (error == 0 && SYSCTL_BATCH_PAD(outlen) != outlen)
+			error = SYSCTL_OUT(req, zeropad,
+			    SYSCTL_BATCH_PAD(outlen) - outlen);
+		if (error != 0)
+			break;
+	}
+	free(buf, M_SYSCTL);
+	return (error);
+}
+
+SYSCTL_PROC(_sysctl, 8, getbatch,
+    CTLTYPE_OPAQUE | CTLFLAG_RW | CTLFLAG_ANYBODY | CTLFLAG_MPSAFE |
+    CTLFLAG_CAPRW, 0, 0, sysctl_sysctl_getbatch, "", "");
+
 /*
  * Default "handler" functions.
  */
@@ -615,6 +615,8 @@ thread_exit(void)
 	td->td_ru.ru_nvcsw++;
 	ruxagg(p, td);
 	rucollect(&p->p_ru, &td->td_ru);
+	p->p_numa_local += td->td_numa_local;
+	p->p_numa_remote += td->td_numa_remote;
 	PROC_STATUNLOCK(p);
 
 	td->td_state = TDS_INACTIVE;
@@ -130,6 +130,21 @@ SYSCTL_INT(_kern, OID_AUTO, pin_pcpu_swi, CTLFLAG_RDTUN | CTLFLAG_NOFETCH, &pin_
  */
 u_int callwheelsize, callwheelmask;
 
+/*
+ * Callouts scheduled beyond callwheel_far_thresh are kept on a second,
+ * coarser wheel whose buckets are 1 << callwheel_far_shift sbintime_t
+ * units wide, and are cascaded onto the primary wheel as their due time
+ * approaches.  This keeps distant timers out of the buckets that
+ * callout_process() rescans, so scan cost follows the number of
+ * soon-to-fire callouts rather than the total armed count.
+ */
+static sbintime_t callwheel_far_thresh;
+static u_int callwheel_far_shift;
+
+static u_long ncascaded;
+SYSCTL_ULONG(_debug, OID_AUTO, to_cascaded, CTLFLAG_RD, &ncascaded, 0,
+    "Number of callouts cascaded from the far wheel");
+
 /*
  * The callout cpu exec entities represent informations necessary for
  * describing the state of callouts currently running on the CPU and the ones
@@ -164,10 +179,12 @@ struct callout_cpu {
 	struct callout		*cc_next;
 	struct callout		*cc_callout;
 	struct callout_list	*cc_callwheel;
+	struct callout_list	*cc_farwheel;
 	struct callout_tailq	cc_expireq;
 	struct callout_slist	cc_callfree;
 	sbintime_t		cc_firstevent;
 	sbintime_t		cc_lastscan;
+	sbintime_t		cc_lastcascade;
 	void			*cc_cookie;
 	u_int			cc_bucket;
 	u_int			cc_inited;
@@ -288,6 +305,15 @@ callout_callwheel_init(void *dummy)
 	callwheelsize = 1 << fls(ncallout);
 	callwheelmask = callwheelsize - 1;
 
+	/*
+	 * The near wheel's scheduling horizon is half a turn; far wheel
+	 * buckets are an eighth of that so cascaded callouts always land
+	 * well within the near wheel.
+	 */
+	callwheel_far_thresh = (sbintime_t)(callwheelsize / 2) <<
+	    (32 - CC_HASH_SHIFT);
+	callwheel_far_shift = 32 - CC_HASH_SHIFT + fls(callwheelsize) - 4;
+
 	/*
 	 * Fetch whether we're pinning the swi's or not.
 	 */
@@ -324,6 +350,10 @@ callout_cpu_init(struct callout_cpu *cc, int cpu)
 	    M_CALLOUT, M_WAITOK);
 	for (i = 0; i < callwheelsize; i++)
 		LIST_INIT(&cc->cc_callwheel[i]);
+	cc->cc_farwheel = malloc(sizeof(struct callout_list) * callwheelsize,
+	    M_CALLOUT, M_WAITOK);
+	for (i = 0; i < callwheelsize; i++)
+		LIST_INIT(&cc->cc_farwheel[i]);
 	TAILQ_INIT(&cc->cc_expireq);
 	cc->cc_firstevent = SBT_MAX;
 	for (i = 0; i < 2; i++)
@@ -434,15 +464,44 @@ callout_get_bucket(sbintime_t sbt)
 	return (callout_hash(sbt) & callwheelmask);
 }
 
+static inline u_int
+callout_far_hash(sbintime_t sbt)
+{
+
+	return (sbt >> callwheel_far_shift);
+}
+
+/*
+ * Hang a callout on the wheel matching its due time.  Callouts beyond
+ * the near wheel's scheduling horizon go to the far wheel, from where
+ * callout_process() cascades them back once they come within the
+ * horizon; everything else is hashed into the near wheel directly.
+ */
+static void
+callout_wheel_insert(struct callout_cpu *cc, struct callout *c)
+{
+	u_int bucket;
+
+	if (c->c_time - cc->cc_lastscan > callwheel_far_thresh) {
+		bucket = callout_far_hash(c->c_time) & callwheelmask;
+		LIST_INSERT_HEAD(&cc->cc_farwheel[bucket], c, c_links.le);
+		return;
+	}
+	bucket = callout_get_bucket(c->c_time);
+	LIST_INSERT_HEAD(&cc->cc_callwheel[bucket], c, c_links.le);
+	if (cc->cc_bucket == bucket)
+		cc_exec_next(cc) = c;
+}
+
 void
 callout_process(sbintime_t now)
 {
 	struct callout *tmp, *tmpn;
 	struct callout_cpu *cc;
-	struct callout_list *sc;
+	struct callout_list cascade, *sc;
 	sbintime_t first, last, max, tmp_max;
 	uint32_t lookahead;
-	u_int firstb, lastb, nowb;
+	u_int firstb, firstfb, lastb, nowb, nowfb;
 #ifdef CALLOUT_PROFILING
 	int depth_dir = 0, mpcalls_dir = 0, lockcalls_dir = 0;
 #endif
@@ -455,6 +514,31 @@ callout_process(sbintime_t now)
 	cc->cc_lastscan = now;
 	nowb = callout_hash(now);
 
+	/*
+	 * Cascade far wheel buckets that have come within half the near
+	 * wheel's horizon of the present time.  Their callouts rehash
+	 * into the near wheel; entries aliased from beyond the far
+	 * wheel's own horizon simply return to their far bucket and are
+	 * looked at again a turn later.
+	 */
+	firstfb = callout_far_hash(cc->cc_lastcascade);
+	cc->cc_lastcascade = now + callwheel_far_thresh / 2;
+	nowfb = callout_far_hash(cc->cc_lastcascade);
+	if (nowfb - firstfb >= callwheelsize)
+		firstfb = nowfb - callwheelsize;
+	for (firstfb++; (int)(firstfb - nowfb) <= 0; firstfb++) {
+		sc = &cc->cc_farwheel[firstfb & callwheelmask];
+		if (LIST_EMPTY(sc))
+			continue;
+		LIST_INIT(&cascade);
+		LIST_SWAP(sc, &cascade, callout, c_links.le);
+		while ((tmp = LIST_FIRST(&cascade)) != NULL) {
+			LIST_REMOVE(tmp, c_links.le);
+			callout_wheel_insert(cc, tmp);
+			ncascaded++;
+		}
+	}
+
 	/* Compute the last bucket and minimum time of the bucket after it. */
 	if (nowb == firstb)
 		lookahead = (SBT_1S / 16);
@@ -590,7 +674,6 @@ callout_cc_add(struct callout *c, struct callout_cpu *cc,
     sbintime_t sbt, sbintime_t precision, void (*func)(void *),
     void *arg, int cpu, int flags)
 {
-	int bucket;
 
 	CC_LOCK_ASSERT(cc);
 	if (sbt < cc->cc_lastscan)
@@ -604,13 +687,10 @@ callout_cc_add(struct callout *c, struct callout_cpu *cc,
 	c->c_func = func;
 	c->c_time = sbt;
 	c->c_precision = precision;
-	bucket = callout_get_bucket(c->c_time);
 	CTR3(KTR_CALLOUT, "precision set for %p: %d.%08x",
 	    c, (int)(c->c_precision >> 32),
 	    (u_int)(c->c_precision & 0xffffffff));
-	LIST_INSERT_HEAD(&cc->cc_callwheel[bucket], c, c_links.le);
-	if (cc->cc_bucket == bucket)
-		cc_exec_next(cc) = c;
+	callout_wheel_insert(cc, c);
 #ifndef NO_EVENTTIMERS
 	/*
 	 * Inform the eventtimers(4) subsystem there's a new callout
@@ -1547,6 +1627,7 @@ sysctl_kern_callout_stat(SYSCTL_HANDLER_ARGS)
 	sbintime_t maxpr, maxt, medpr, medt, now, spr, st, t;
 	int ct[64], cpr[64], ccpbk[32];
 	int error, val, i, count, tcum, pcum, maxc, c, medc;
+	int fcount, fmaxc;
 #ifdef SMP
 	int cpu;
 #endif
@@ -1556,6 +1637,7 @@ sysctl_kern_callout_stat(SYSCTL_HANDLER_ARGS)
 	if (error != 0 || req->newptr == NULL)
 		return (error);
 	count = maxc = 0;
+	fcount = fmaxc = 0;
 	st = spr = maxt = maxpr = 0;
 	bzero(ccpbk, sizeof(ccpbk));
 	bzero(ct, sizeof(ct));
@@ -1590,6 +1672,14 @@ sysctl_kern_callout_stat(SYSCTL_HANDLER_ARGS)
 			ccpbk[fls(c + c / 2)]++;
 			count += c;
 		}
+		for (i = 0; i < callwheelsize; i++) {
+			c = 0;
+			LIST_FOREACH(tmp, &cc->cc_farwheel[i], c_links.le)
+				c++;
+			if (c > fmaxc)
+				fmaxc = c;
+			fcount += c;
+		}
 		CC_UNLOCK(cc);
 #ifdef SMP
 	}
@@ -1608,6 +1698,11 @@ sysctl_kern_callout_stat(SYSCTL_HANDLER_ARGS)
 	printf("Scheduled callouts statistic snapshot:\n");
 	printf("  Callouts: %6d  Buckets: %6d*%-3d  Bucket size: 0.%06ds\n",
 	    count, callwheelsize, mp_ncpus, 1000000 >> CC_HASH_SHIFT);
+	printf("  Far wheel: %5d  Buckets: %6d*%-3d  Bucket size: %ju.%06jus  "
+	    "max/bucket %d\n", fcount, callwheelsize, mp_ncpus,
+	    (uintmax_t)(((sbintime_t)1 << callwheel_far_shift) >> 32),
+	    (uintmax_t)((((sbintime_t)1 << callwheel_far_shift) & 0xffffffff) *
+	    1000000 >> 32), fmaxc);
 	printf("  C/Bk: med %5d         avg %6d.%06jd  max %6d\n",
 	    medc,
 	    count / callwheelsize / mp_ncpus,
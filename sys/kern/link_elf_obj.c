@@ -110,6 +110,9 @@ typedef struct elf_file {
 	caddr_t		ddbstrtab;	/* String table */
 	long		ddbstrcnt;	/* number of bytes in string table */
 
+	Elf_Size	*sortsymtab;	/* Defined symbols sorted by name */
+	long		sortsymcnt;	/* Number of sorted symbols */
+
 	caddr_t		shstrtab;	/* Section name string table */
 	long		shstrcnt;	/* number of bytes in string table */
 
@@ -463,6 +466,57 @@ out:
 	return (error);
 }
 
+static int
+link_elf_sort_symtab_cmp(void *thunk, const void *a, const void *b)
+{
+	elf_file_t ef = thunk;
+	Elf_Size ia, ib;
+	int c;
+
+	ia = *(const Elf_Size *)a;
+	ib = *(const Elf_Size *)b;
+	c = strcmp(ef->ddbstrtab + ef->ddbsymtab[ia].st_name,
+	    ef->ddbstrtab + ef->ddbsymtab[ib].st_name);
+	if (c != 0)
+		return (c);
+
+	/*
+	 * Order duplicate names by symbol table index so that a lookup
+	 * returns the same symbol the old linear scan would have found.
+	 */
+	return (ia < ib ? -1 : ia > ib ? 1 : 0);
+}
+
+/*
+ * Build a name-sorted index of the defined symbols once relocation is
+ * complete, so that lookups from dependent modules and kldsym(2) bisect
+ * the table instead of scanning all of it with strcmp().  The linear
+ * scans are quadratic across a boot that links many interdependent
+ * modules.
+ */
+static void
+link_elf_sort_symtab(elf_file_t ef)
+{
+	const Elf_Sym *symp;
+	long i, n;
+
+	n = 0;
+	for (i = 0, symp = ef->ddbsymtab; i < ef->ddbsymcnt; i++, symp++)
+		if (symp->st_shndx != SHN_UNDEF)
+			n++;
+	if (n == 0)
+		return;
+	ef->sortsymtab = malloc(n * sizeof(*ef->sortsymtab), M_LINKER,
+	    M_WAITOK);
+	n = 0;
+	for (i = 0; i < ef->ddbsymcnt; i++)
+		if (ef->ddbsymtab[i].st_shndx != SHN_UNDEF)
+			ef->sortsymtab[n++] = i;
+	ef->sortsymcnt = n;
+	qsort_r(ef->sortsymtab, n, sizeof(*ef->sortsymtab), ef,
+	    link_elf_sort_symtab_cmp);
+}
+
 static void
 link_elf_invoke_ctors(caddr_t addr, size_t size)
 {
@@ -489,6 +543,7 @@ link_elf_link_preload_finish(linker_file_t lf)
 	error = relocate_file(ef);
 	if (error)
 		return (error);
+	link_elf_sort_symtab(ef);
 
 	/* Notify MD code that a module is being loaded. */
 	error = elf_cpu_load_file(lf);
@@ -1016,6 +1071,7 @@ link_elf_load_file(linker_class_t cls, const char *filename,
 	error = relocate_file(ef);
 	if (error)
 		goto out;
+	link_elf_sort_symtab(ef);
 
 	/* Notify MD code that a module is being loaded. */
 	error = elf_cpu_load_file(lf);
@@ -1077,6 +1133,7 @@ link_elf_unload_file(linker_file_t file)
 		free(ef->ctftab, M_LINKER);
 		free(ef->ctfoff, M_LINKER);
 		free(ef->typoff, M_LINKER);
+		free(ef->sortsymtab, M_LINKER);
 		if (file->pathname != NULL)
 			preload_delete_name(file->pathname);
 		return;
@@ -1098,6 +1155,7 @@ link_elf_unload_file(linker_file_t file)
 	free(ef->e_shdr, M_LINKER);
 	free(ef->ddbsymtab, M_LINKER);
 	free(ef->ddbstrtab, M_LINKER);
+	free(ef->sortsymtab, M_LINKER);
 	free(ef->shstrtab, M_LINKER);
 	free(ef->ctftab, M_LINKER);
 	free(ef->ctfoff, M_LINKER);
@@ -1224,8 +1282,34 @@ link_elf_lookup_symbol(linker_file_t lf, const char *name, c_linker_sym_t *sym)
 	elf_file_t ef = (elf_file_t) lf;
 	const Elf_Sym *symp;
 	const char *strp;
+	long lo, hi, mid;
 	int i;
 
+	/*
+	 * Bisect the sorted index when it has been built; the leftmost
+	 * match is the first one the linear scan below would find.
+	 */
+	if (ef->sortsymtab != NULL) {
+		lo = 0;
+		hi = ef->sortsymcnt;
+		while (lo < hi) {
+			mid = (lo + hi) / 2;
+			symp = ef->ddbsymtab + ef->sortsymtab[mid];
+			if (strcmp(ef->ddbstrtab + symp->st_name, name) < 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if (lo < ef->sortsymcnt) {
+			symp = ef->ddbsymtab + ef->sortsymtab[lo];
+			if (strcmp(ef->ddbstrtab + symp->st_name, name) == 0) {
+				*sym = (c_linker_sym_t) symp;
+				return 0;
+			}
+		}
+		return ENOENT;
+	}
+
 	for (i = 0, symp = ef->ddbsymtab; i < ef->ddbsymcnt; i++, symp++) {
 		strp = ef->ddbstrtab + symp->st_name;
 		if (symp->st_shndx != SHN_UNDEF && strcmp(name, strp) == 0) {
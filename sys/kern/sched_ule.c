@@ -276,6 +276,19 @@ static int steal_idle = 1;
 static int steal_thresh = 2;
 static int always_steal = 0;
 static int trysteal_limit = 2;
+static int steal_2choice = 1;
+
+/*
+ * Idle steal statistics.  The counters and the latency histogram are
+ * updated without synchronization; an increment may occasionally be
+ * lost to a race, which is acceptable for tuning data.  Histogram
+ * bucket i counts steals that took [2^i, 2^(i+1)) microseconds from
+ * idle entry to acquiring a thread.
+ */
+#define	STEAL_LAT_NBUCKETS	16
+static u_long steal_successes;
+static u_long steal_failures;
+static u_long steal_latency[STEAL_LAT_NBUCKETS];
 
 /*
  * One thread queue per processor.
@@ -988,17 +1001,32 @@ tdq_idled(struct tdq *tdq)
 {
 	struct cpu_group *cg;
 	struct tdq *steal;
-	cpuset_t mask;
-	int cpu, switchcnt;
+	cpuset_t mask, mask2;
+	uint64_t lat, stime;
+	int bucket, cpu, cpu2, switchcnt;
 
 	if (smp_started == 0 || steal_idle == 0 || tdq->tdq_cg == NULL)
 		return (1);
+	stime = cpu_ticks();
 	CPU_FILL(&mask);
 	CPU_CLR(PCPU_GET(cpuid), &mask);
     restart:
 	switchcnt = tdq->tdq_switchcnt + tdq->tdq_oldswitchcnt;
 	for (cg = tdq->tdq_cg; ; ) {
 		cpu = sched_highest(cg, mask, steal_thresh);
+		/*
+		 * When many CPUs go idle at once they all elect the same
+		 * most loaded victim and serialize on its queue lock.
+		 * Flipping a coin between the two most loaded CPUs in the
+		 * group spreads the thieves out.
+		 */
+		if (steal_2choice && cpu != -1) {
+			mask2 = mask;
+			CPU_CLR(cpu, &mask2);
+			cpu2 = sched_highest(cg, mask2, steal_thresh);
+			if (cpu2 != -1 && (sched_random() & 1) != 0)
+				cpu = cpu2;
+		}
 		/*
 		 * We were assigned a thread but not preempted.  Returning
 		 * 0 here will cause our caller to switch to it.
@@ -1007,8 +1035,10 @@ tdq_idled(struct tdq *tdq)
 			return (0);
 		if (cpu == -1) {
 			cg = cg->cg_parent;
-			if (cg == NULL)
+			if (cg == NULL) {
+				steal_failures++;
 				return (1);
+			}
 			continue;
 		}
 		steal = TDQ_CPU(cpu);
@@ -1046,8 +1076,17 @@ tdq_idled(struct tdq *tdq)
 		/*
 		 * Steal the thread and switch to it.
 		 */
-		if (tdq_move(steal, tdq) != NULL)
+		if (tdq_move(steal, tdq) != NULL) {
+			steal_successes++;
+			lat = cputick2usec(cpu_ticks() - stime);
+			bucket = flsll(lat);
+			if (bucket > 0)
+				bucket--;
+			if (bucket >= STEAL_LAT_NBUCKETS)
+				bucket = STEAL_LAT_NBUCKETS - 1;
+			steal_latency[bucket]++;
 			break;
+		}
 		/*
 		 * We failed to acquire a thread even though it looked
 		 * like one was available.  This could be due to affinity
@@ -3009,6 +3048,25 @@ sysctl_kern_sched_topology_spec(SYSCTL_HANDLER_ARGS)
 
 #endif
 
+#ifdef SMP
+static int
+sysctl_kern_sched_steal_latency(SYSCTL_HANDLER_ARGS)
+{
+	struct sbuf *sb;
+	int error, i;
+
+	sb = sbuf_new_for_sysctl(NULL, NULL, 256, req);
+	if (sb == NULL)
+		return (ENOMEM);
+	for (i = 0; i < STEAL_LAT_NBUCKETS; i++)
+		sbuf_printf(sb, "%s%luus:%lu", i == 0 ? "" : " ",
+		    1UL << i, steal_latency[i]);
+	error = sbuf_finish(sb);
+	sbuf_delete(sb);
+	return (error);
+}
+#endif
+
 static int
 sysctl_kern_quantum(SYSCTL_HANDLER_ARGS)
 {
@@ -3064,6 +3122,15 @@ SYSCTL_INT(_kern_sched, OID_AUTO, trysteal_limit, CTLFLAG_RW, &trysteal_limit,
     0, "Topological distance limit for stealing threads in sched_switch()");
 SYSCTL_INT(_kern_sched, OID_AUTO, always_steal, CTLFLAG_RW, &always_steal, 0,
     "Always run the stealer from the idle thread");
+SYSCTL_INT(_kern_sched, OID_AUTO, steal_2choice, CTLFLAG_RW, &steal_2choice, 0,
+    "Pick randomly between the two most loaded CPUs when stealing");
+SYSCTL_ULONG(_kern_sched, OID_AUTO, steal_successes, CTLFLAG_RD,
+    &steal_successes, 0, "Threads stolen by idling CPUs");
+SYSCTL_ULONG(_kern_sched, OID_AUTO, steal_failures, CTLFLAG_RD,
+    &steal_failures, 0, "Idle steal attempts that found no thread");
+SYSCTL_PROC(_kern_sched, OID_AUTO, steal_latency, CTLTYPE_STRING |
+    CTLFLAG_MPSAFE | CTLFLAG_RD, NULL, 0, sysctl_kern_sched_steal_latency, "A",
+    "Idle steal latency histogram, power-of-two microsecond buckets");
 SYSCTL_PROC(_kern_sched, OID_AUTO, topology_spec, CTLTYPE_STRING |
     CTLFLAG_MPSAFE | CTLFLAG_RD, NULL, 0, sysctl_kern_sched_topology_spec, "A",
     "XML dump of detected CPU topology");
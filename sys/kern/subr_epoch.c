@@ -42,9 +42,11 @@ __FBSDID("$FreeBSD$");
 #include <sys/mutex.h>
 #include <sys/pcpu.h>
 #include <sys/proc.h>
+#include <sys/sbuf.h>
 #include <sys/sched.h>
 #include <sys/smp.h>
 #include <sys/sysctl.h>
+#include <sys/time.h>
 #include <sys/turnstile.h>
 #include <vm/vm.h>
 #include <vm/vm_extern.h>
@@ -69,11 +71,21 @@ typedef struct epoch_record {
 	uint32_t er_cpuid;
 } __aligned(EPOCH_ALIGN)     *epoch_record_t;
 
+/* Log2 buckets of grace period wait time, in microseconds. */
+#define EPOCH_WAIT_NHIST 16
+
 struct epoch {
 	struct ck_epoch e_epoch __aligned(EPOCH_ALIGN);
 	epoch_record_t e_pcpu_record;
 	int	e_idx;
 	int	e_flags;
+	/* Unlocked; concurrent waiters may lose increments. */
+	uint64_t e_wait_hist[EPOCH_WAIT_NHIST];
+};
+
+struct epoch_wait_state {
+	sbintime_t ews_start;
+	int	ews_reported;
 };
 
 /* arbitrary --- needs benchmarking */
@@ -110,6 +122,17 @@ static counter_u64_t epoch_call_task_count;
 SYSCTL_COUNTER_U64(_kern_epoch_stats, OID_AUTO, epoch_call_tasks, CTLFLAG_RW,
     &epoch_call_task_count, "# of times a callback task was run");
 
+static int epoch_cb_batch = 8;
+SYSCTL_INT(_kern_epoch, OID_AUTO, cb_batch, CTLFLAG_RW, &epoch_cb_batch, 0,
+    "Deferred callbacks on a CPU before its callback task is run at once");
+static int epoch_cb_age = 2;
+SYSCTL_INT(_kern_epoch, OID_AUTO, cb_age, CTLFLAG_RW, &epoch_cb_age, 0,
+    "Ticks a batch smaller than cb_batch may age before being run");
+static int epoch_stall_report_msec = 1000;
+SYSCTL_INT(_kern_epoch, OID_AUTO, stall_report_msec, CTLFLAG_RW,
+    &epoch_stall_report_msec, 0,
+    "Report threads stalling an epoch_wait() longer than this (0 disables)");
+
 TAILQ_HEAD (threadlist, thread);
 
 CK_STACK_CONTAINER(struct ck_epoch_entry, stack_entry,
@@ -119,6 +142,7 @@ epoch_t	allepochs[MAX_EPOCHS];
 
 DPCPU_DEFINE(struct grouptask, epoch_cb_task);
 DPCPU_DEFINE(int, epoch_cb_count);
+DPCPU_DEFINE_STATIC(int, epoch_cb_ticks);
 
 static __read_mostly int inited;
 static __read_mostly int epoch_count;
@@ -328,14 +352,37 @@ epoch_exit(epoch_t epoch)
 	critical_exit();
 }
 
+/*
+ * Identify the threads holding up a grace period.  The thread list may
+ * only be walked safely from its own CPU, which the block handler
+ * migrates to before examining it; for remote records just name the CPU.
+ */
+static void
+epoch_stall_report(epoch_record_t record)
+{
+	struct epoch_tracker *tdwait;
+	struct thread *td;
+
+	printf("epoch: grace period stalled on cpu %d for over %d ms\n",
+	    record->er_cpuid, epoch_stall_report_msec);
+	if (record->er_cpuid != curcpu)
+		return;
+	TAILQ_FOREACH(tdwait, &record->er_tdlist, et_link) {
+		td = tdwait->et_td;
+		printf("epoch: tid %d (%s) pinned in epoch section\n",
+		    td->td_tid, td->td_name);
+	}
+}
+
 /*
  * epoch_block_handler_preempt() is a callback from the CK code when another
  * thread is currently in an epoch section.
  */
 static void
 epoch_block_handler_preempt(struct ck_epoch *global __unused,
-    ck_epoch_record_t *cr, void *arg __unused)
+    ck_epoch_record_t *cr, void *arg)
 {
+	struct epoch_wait_state *ews;
 	epoch_record_t record;
 	struct thread *td, *owner, *curwaittd;
 	struct epoch_tracker *tdwait;
@@ -349,6 +396,13 @@ epoch_block_handler_preempt(struct ck_epoch *global __unused,
 	locksheld = td->td_locks;
 	spincount = 0;
 	counter_u64_add(block_count, 1);
+	ews = arg;
+	if (__predict_false(epoch_stall_report_msec > 0 &&
+	    ews->ews_reported == 0 && sbinuptime() - ews->ews_start >
+	    epoch_stall_report_msec * SBT_1MS)) {
+		ews->ews_reported = 1;
+		epoch_stall_report(record);
+	}
 	/*
 	 * We lost a race and there's no longer any threads
 	 * on the CPU in an epoch section.
@@ -477,9 +531,23 @@ epoch_block_handler_preempt(struct ck_epoch *global __unused,
 	thread_lock(td);
 }
 
+static void
+epoch_wait_hist_record(epoch_t epoch, sbintime_t start)
+{
+	uint64_t usec;
+	int bucket;
+
+	usec = sbttous(sbinuptime() - start);
+	bucket = flsll(usec);
+	if (bucket >= EPOCH_WAIT_NHIST)
+		bucket = EPOCH_WAIT_NHIST - 1;
+	epoch->e_wait_hist[bucket]++;
+}
+
 void
 epoch_wait_preempt(epoch_t epoch)
 {
+	struct epoch_wait_state ews;
 	struct thread *td;
 	int was_bound;
 	int old_cpu;
@@ -499,6 +567,9 @@ epoch_wait_preempt(epoch_t epoch)
 	KASSERT(!in_epoch(epoch), ("epoch_wait_preempt() called in the middle "
 	    "of an epoch section of the same epoch"));
 #endif
+	ews.ews_start = sbinuptime();
+	ews.ews_reported = 0;
+
 	thread_lock(td);
 	DROP_GIANT();
 
@@ -511,7 +582,7 @@ epoch_wait_preempt(epoch_t epoch)
 	sched_bind(td, old_cpu);
 
 	ck_epoch_synchronize_wait(&epoch->e_epoch, epoch_block_handler_preempt,
-	    NULL);
+	    &ews);
 
 	/* restore CPU binding, if any */
 	if (was_bound != 0) {
@@ -529,6 +600,7 @@ epoch_wait_preempt(epoch_t epoch)
 	sched_prio(td, old_prio);
 	thread_unlock(td);
 	PICKUP_GIANT();
+	epoch_wait_hist_record(epoch, ews.ews_start);
 	KASSERT(td->td_locks == locks,
 	    ("%d residual locks held", td->td_locks - locks));
 }
@@ -543,13 +615,16 @@ epoch_block_handler(struct ck_epoch *g __unused, ck_epoch_record_t *c __unused,
 void
 epoch_wait(epoch_t epoch)
 {
+	sbintime_t start;
 
 	MPASS(cold || epoch != NULL);
 	INIT_CHECK(epoch);
 	MPASS(epoch->e_flags == 0);
+	start = sbinuptime();
 	critical_enter();
 	ck_epoch_synchronize_wait(&epoch->e_epoch, epoch_block_handler, NULL);
 	critical_exit();
+	epoch_wait_hist_record(epoch, start);
 }
 
 void
@@ -579,6 +654,28 @@ boottime:
 	callback(ctx);
 }
 
+/*
+ * Called from hardclock on each CPU to schedule the callback task.
+ * Rather than running the task as soon as anything is pending, let
+ * small batches accumulate for up to cb_age ticks so that each task
+ * run amortizes its epoch poll over several callbacks; a backlog of
+ * cb_batch or more is drained immediately.
+ */
+void
+epoch_tick(void)
+{
+	int *age;
+
+	if (__predict_true(DPCPU_GET(epoch_cb_count) == 0))
+		return;
+	age = DPCPU_PTR(epoch_cb_ticks);
+	if (DPCPU_GET(epoch_cb_count) >= epoch_cb_batch ||
+	    ++*age >= epoch_cb_age) {
+		*age = 0;
+		GROUPTASK_ENQUEUE(DPCPU_PTR(epoch_cb_task));
+	}
+}
+
 static void
 epoch_call_task(void *arg __unused)
 {
@@ -657,6 +754,47 @@ in_epoch(epoch_t epoch)
 	return (in_epoch_verbose(epoch, 0));
 }
 
+static int
+sysctl_epoch_pending_cbs(SYSCTL_HANDLER_ARGS)
+{
+	int cpu, pending;
+
+	pending = 0;
+	CPU_FOREACH(cpu)
+		pending += DPCPU_ID_GET(cpu, epoch_cb_count);
+	return (sysctl_handle_int(oidp, &pending, 0, req));
+}
+SYSCTL_PROC(_kern_epoch_stats, OID_AUTO, pending_cbs,
+    CTLTYPE_INT | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+    sysctl_epoch_pending_cbs, "I",
+    "Deferred callbacks not yet run, summed over all CPUs");
+
+static int
+sysctl_epoch_wait_hist(SYSCTL_HANDLER_ARGS)
+{
+	struct sbuf sb;
+	epoch_t epoch;
+	int error, i, j;
+
+	sbuf_new_for_sysctl(&sb, NULL, 128, req);
+	for (i = 0; i < epoch_count; i++) {
+		if ((epoch = allepochs[i]) == NULL)
+			continue;
+		sbuf_printf(&sb, "%d:", i);
+		for (j = 0; j < EPOCH_WAIT_NHIST; j++)
+			sbuf_printf(&sb, " %ju",
+			    (uintmax_t)epoch->e_wait_hist[j]);
+		sbuf_printf(&sb, "\n");
+	}
+	error = sbuf_finish(&sb);
+	sbuf_delete(&sb);
+	return (error);
+}
+SYSCTL_PROC(_kern_epoch_stats, OID_AUTO, wait_hist,
+    CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+    sysctl_epoch_wait_hist, "A",
+    "Per-epoch log2 histograms of epoch_wait() time, in microseconds");
+
 void
 epoch_thread_init(struct thread *td)
 {
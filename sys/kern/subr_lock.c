@@ -141,6 +141,123 @@ lock_delay(struct lock_delay_arg *la)
 	}
 }
 
+/*
+ * Sampled contention telemetry.
+ *
+ * Unlike the LOCK_PROFILING machinery this is always compiled in and is
+ * cheap enough to leave enabled in production: when
+ * debug.lock.csample_rate is set to N, one in N contention events in the
+ * mutex and rwlock slow paths records its lock class, the address the
+ * slow path was called from, and the cpu_ticks() spent waiting into a
+ * small per-CPU ring.  Writers never take locks or fence; a reader
+ * racing an update may observe a torn record, which is acceptable for
+ * telemetry.  The rings are read through debug.lock.csample.
+ */
+#define	LOCK_CSAMPLE_RING	256	/* Per-CPU entries, power of two. */
+
+struct lock_csample {
+	uintptr_t	cs_caller;	/* Slow path return address. */
+	uint64_t	cs_waittick;	/* cpu_ticks() spent waiting. */
+	uint16_t	cs_class;	/* Lock class index. */
+};
+
+struct lock_csample_cpu {
+	u_int		cc_count;	/* Contention events seen. */
+	u_int		cc_head;	/* Next ring slot to fill. */
+	struct lock_csample cc_ring[LOCK_CSAMPLE_RING];
+} __aligned(CACHE_LINE_SIZE);
+
+static struct lock_csample_cpu *lock_csample_cpus[MAXCPU];
+
+u_int __read_frequently lock_csample_rate;
+SYSCTL_UINT(_debug_lock, OID_AUTO, csample_rate, CTLFLAG_RWTUN,
+    &lock_csample_rate, 0,
+    "Sample one in N lock contention events (0 disables)");
+
+int
+lock_csample_enter(void)
+{
+	struct lock_csample_cpu *cc;
+	u_int rate;
+
+	rate = lock_csample_rate;
+	if (__predict_true(rate == 0))
+		return (0);
+	cc = lock_csample_cpus[curcpu];
+	if (__predict_false(cc == NULL))
+		return (0);
+	return (++cc->cc_count % rate == 0);
+}
+
+void
+lock_csample_record(struct lock_object *lo, uintptr_t caller, uint64_t start)
+{
+	struct lock_csample_cpu *cc;
+	struct lock_csample *cs;
+	uint64_t waittick;
+
+	waittick = cpu_ticks() - start;
+	cc = lock_csample_cpus[curcpu];
+	if (__predict_false(cc == NULL))
+		return;
+	cs = &cc->cc_ring[cc->cc_head++ & (LOCK_CSAMPLE_RING - 1)];
+	cs->cs_caller = caller;
+	cs->cs_waittick = waittick;
+	cs->cs_class = LO_CLASSINDEX(lo);
+}
+
+static void
+lock_csample_init(void *dummy __unused)
+{
+	int cpu;
+
+	CPU_FOREACH(cpu)
+		lock_csample_cpus[cpu] = malloc(sizeof(struct lock_csample_cpu),
+		    M_TEMP, M_WAITOK | M_ZERO);
+}
+SYSINIT(lock_csample, SI_SUB_SMP, SI_ORDER_ANY, lock_csample_init, NULL);
+
+static int
+lock_csample_sysctl(SYSCTL_HANDLER_ARGS)
+{
+	struct sbuf sb;
+	struct lock_csample_cpu *cc;
+	struct lock_csample *cs;
+	char *buf;
+	size_t len;
+	int cpu, error, i;
+
+	/* One line per occupied slot; 64 bytes is a comfortable bound. */
+	len = (size_t)(mp_maxid + 1) * LOCK_CSAMPLE_RING * 64 + 1;
+	buf = malloc(len, M_TEMP, M_WAITOK);
+	sbuf_new(&sb, buf, len, SBUF_FIXEDLEN | SBUF_INCLUDENUL);
+	CPU_FOREACH(cpu) {
+		cc = lock_csample_cpus[cpu];
+		if (cc == NULL)
+			continue;
+		for (i = 0; i < LOCK_CSAMPLE_RING; i++) {
+			cs = &cc->cc_ring[i];
+			if (cs->cs_caller == 0)
+				continue;
+			sbuf_printf(&sb, "%d %s %p %ju\n", cpu,
+			    cs->cs_class <= LOCK_CLASS_MAX &&
+			    lock_classes[cs->cs_class] != NULL ?
+			    lock_classes[cs->cs_class]->lc_name : "?",
+			    (void *)cs->cs_caller,
+			    (uintmax_t)cs->cs_waittick);
+		}
+	}
+	error = sbuf_finish(&sb);
+	if (error == 0)
+		error = SYSCTL_OUT(req, sbuf_data(&sb), sbuf_len(&sb));
+	sbuf_delete(&sb);
+	free(buf, M_TEMP);
+	return (error);
+}
+SYSCTL_PROC(_debug_lock, OID_AUTO, csample, CTLTYPE_STRING | CTLFLAG_RD |
+    CTLFLAG_MPSAFE, NULL, 0, lock_csample_sysctl, "A",
+    "Sampled lock contention records: cpu class caller wait-ticks");
+
 static u_int
 lock_roundup_2(u_int val)
 {
@@ -42,7 +42,9 @@ __FBSDID("$FreeBSD$");
 #include <sys/malloc.h>
 #include <sys/mutex.h>
 #include <sys/proc.h>
+#include <sys/sbuf.h>
 #include <sys/sched.h>
+#include <sys/sysctl.h>
 #include <sys/smp.h>
 #include <sys/taskqueue.h>
 #include <sys/unistd.h>
@@ -62,6 +64,49 @@ struct taskqueue_busy {
 
 struct task * const TB_DRAIN_WAITER = (struct task *)0x1;
 
+/*
+ * Enqueue-to-run latency histogram with power-of-two microsecond
+ * buckets, aggregated over all taskqueues.  The counters are updated
+ * without synchronization; losing an occasional increment is
+ * preferable to dirtying a shared cache line on every task.
+ */
+#define	TQ_LAT_NBUCKETS	16
+static u_long taskqueue_latency[TQ_LAT_NBUCKETS];
+
+static void
+taskqueue_record_latency(uint64_t stime)
+{
+	uint64_t lat;
+	int bucket;
+
+	lat = cputick2usec(cpu_ticks() - stime);
+	bucket = flsll(lat);
+	if (bucket > 0)
+		bucket--;
+	if (bucket >= TQ_LAT_NBUCKETS)
+		bucket = TQ_LAT_NBUCKETS - 1;
+	taskqueue_latency[bucket]++;
+}
+
+static int
+sysctl_taskqueue_latency(SYSCTL_HANDLER_ARGS)
+{
+	struct sbuf sb;
+	int error, i;
+
+	sbuf_new_for_sysctl(&sb, NULL, TQ_LAT_NBUCKETS * 16, req);
+	for (i = 0; i < TQ_LAT_NBUCKETS; i++)
+		sbuf_printf(&sb, "%s%luus:%lu", i == 0 ? "" : " ",
+		    1UL << i, taskqueue_latency[i]);
+	error = sbuf_finish(&sb);
+	sbuf_delete(&sb);
+	return (error);
+}
+SYSCTL_PROC(_kern, OID_AUTO, taskqueue_latency,
+    CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+    sysctl_taskqueue_latency, "A",
+    "Task enqueue-to-run latency histogram (power-of-two buckets)");
+
 struct taskqueue {
 	STAILQ_HEAD(, task)	tq_queue;
 	taskqueue_enqueue_fn	tq_enqueue;
@@ -252,6 +297,7 @@ taskqueue_enqueue_locked(struct taskqueue *queue, struct task *task)
 	}
 
 	task->ta_pending = 1;
+	task->ta_tqtime = cpu_ticks();
 	if ((queue->tq_flags & TQ_FLAGS_UNLOCKED_ENQUEUE) != 0)
 		TQ_UNLOCK(queue);
 	if ((queue->tq_flags & TQ_FLAGS_BLOCKED) == 0)
@@ -460,6 +506,7 @@ taskqueue_run_locked(struct taskqueue *queue)
 		STAILQ_REMOVE_HEAD(&queue->tq_queue, ta_link);
 		pending = task->ta_pending;
 		task->ta_pending = 0;
+		taskqueue_record_latency(task->ta_tqtime);
 		tb.tb_running = task;
 		TQ_UNLOCK(queue);
 
@@ -817,6 +864,10 @@ TASKQUEUE_DEFINE(swi_giant, taskqueue_swi_giant_enqueue, NULL,
 
 TASKQUEUE_DEFINE_THREAD(thread);
 
+TASKQUEUE_DEFINE(pool, taskqueue_thread_enqueue, &taskqueue_pool,
+		 taskqueue_start_threads(&taskqueue_pool, mp_ncpus, PWAIT,
+		     "%s taskq", "pool"));
+
 struct taskqueue *
 taskqueue_create_fast(const char *name, int mflags,
 		 taskqueue_enqueue_fn enqueue, void *context)
@@ -104,6 +104,7 @@ static struct ttydevsw terminal_tty_class = {
 static tf_bell_t	termteken_bell;
 static tf_cursor_t	termteken_cursor;
 static tf_putchar_t	termteken_putchar;
+static tf_puttext_t	termteken_puttext;
 static tf_fill_t	termteken_fill;
 static tf_copy_t	termteken_copy;
 static tf_pre_input_t	termteken_pre_input;
@@ -115,6 +116,7 @@ static teken_funcs_t terminal_drawmethods = {
 	.tf_bell	= termteken_bell,
 	.tf_cursor	= termteken_cursor,
 	.tf_putchar	= termteken_putchar,
+	.tf_puttext	= termteken_puttext,
 	.tf_fill	= termteken_fill,
 	.tf_copy	= termteken_copy,
 	.tf_pre_input	= termteken_pre_input,
@@ -613,6 +615,36 @@ termteken_putchar(void *softc, const teken_pos_t *p, teken_char_t c,
 	tm->tm_class->tc_putchar(tm, p, TCHAR_CREATE(c, a));
 }
 
+static void
+termteken_puttext(void *softc, const teken_pos_t *p, const teken_char_t *s,
+    unsigned int n, const teken_attr_t *a)
+{
+	struct terminal *tm = softc;
+	term_char_t text[128];
+	term_pos_t tp;
+	unsigned int i, run;
+
+	tp = *p;
+	if (tm->tm_class->tc_puttext == NULL) {
+		/* Class draws one cell at a time. */
+		for (i = 0; i < n; i++) {
+			tm->tm_class->tc_putchar(tm, &tp,
+			    TCHAR_CREATE(s[i], a));
+			tp.tp_col++;
+		}
+		return;
+	}
+	while (n > 0) {
+		run = MIN(n, nitems(text));
+		for (i = 0; i < run; i++)
+			text[i] = TCHAR_CREATE(s[i], a);
+		tm->tm_class->tc_puttext(tm, &tp, text, run);
+		tp.tp_col += run;
+		s += run;
+		n -= run;
+	}
+}
+
 static void
 termteken_fill(void *softc, const teken_rect_t *r, teken_char_t c,
     const teken_attr_t *a)
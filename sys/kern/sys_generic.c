@@ -292,9 +292,23 @@ sys_readv(struct thread *td, struct readv_args *uap)
 int
 kern_readv(struct thread *td, int fd, struct uio *auio, struct metaio *miop)
 {
+	struct filedesc *fdp;
 	struct file *fp;
 	int error;
 
+	fdp = td->td_proc->p_fd;
+	if (__predict_true(FILEDESC_IS_ONLY_USER(fdp))) {
+		error = fget_only_user(fdp, fd, &cap_read_rights, &fp);
+		if (error != 0)
+			return (error);
+		if (__predict_false((fp->f_flag & FREAD) == 0)) {
+			fput_only_user(fdp, fp);
+			return (EBADF);
+		}
+		error = dofileread(td, fd, fp, auio, (off_t)-1, 0, miop);
+		fput_only_user(fdp, fp);
+		return (error);
+	}
 	error = fget_read(td, fd, &cap_read_rights, &fp);
 	if (error)
 		return (error);
@@ -594,9 +608,23 @@ sys_writev(struct thread *td, struct writev_args *uap)
 int
 kern_writev(struct thread *td, int fd, struct uio *auio)
 {
+	struct filedesc *fdp;
 	struct file *fp;
 	int error;
 
+	fdp = td->td_proc->p_fd;
+	if (__predict_true(FILEDESC_IS_ONLY_USER(fdp))) {
+		error = fget_only_user(fdp, fd, &cap_write_rights, &fp);
+		if (error != 0)
+			return (error);
+		if (__predict_false((fp->f_flag & FWRITE) == 0)) {
+			fput_only_user(fdp, fp);
+			return (EBADF);
+		}
+		error = dofilewrite(td, fd, fp, auio, (off_t)-1, 0);
+		fput_only_user(fdp, fp);
+		return (error);
+	}
 	error = fget_write(td, fd, &cap_write_rights, &fp);
 	if (error)
 		return (error);
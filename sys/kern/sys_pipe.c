@@ -235,6 +235,40 @@ SYSCTL_INT(_kern_ipc, OID_AUTO, piperesizefail, CTLFLAG_RD,
 	  &piperesizefail, 0, "Pipe resize failures");
 SYSCTL_INT(_kern_ipc, OID_AUTO, piperesizeallowed, CTLFLAG_RW,
 	  &piperesizeallowed, 0, "Pipe resizing allowed");
+#ifndef PIPE_NODIRECT
+static long pipe_mindirect = PIPE_MINDIRECT;
+static long pipedirecthits;
+static long pipedirectfallbacks;
+
+static int
+sysctl_handle_pipe_mindirect(SYSCTL_HANDLER_ARGS)
+{
+	long newval;
+	int error;
+
+	newval = pipe_mindirect;
+	error = sysctl_handle_long(oidp, &newval, 0, req);
+	if (error != 0 || req->newptr == NULL)
+		return (error);
+
+	/*
+	 * Don't allow pipe_mindirect to be set so low that we violate
+	 * atomicity requirements.
+	 */
+	if (newval <= MAX(PIPE_BUF, PAGE_SIZE))
+		newval = MAX(PIPE_BUF, PAGE_SIZE);
+	pipe_mindirect = newval;
+	return (0);
+}
+SYSCTL_PROC(_kern_ipc, OID_AUTO, pipe_mindirect, CTLTYPE_LONG | CTLFLAG_RW,
+    NULL, 0, sysctl_handle_pipe_mindirect, "L",
+    "Minimum write size triggering VM optimization");
+SYSCTL_LONG(_kern_ipc, OID_AUTO, pipedirecthits, CTLFLAG_RD,
+	  &pipedirecthits, 0, "Direct (page-loaning) pipe writes completed");
+SYSCTL_LONG(_kern_ipc, OID_AUTO, pipedirectfallbacks, CTLFLAG_RD,
+	  &pipedirectfallbacks, 0,
+	  "Direct pipe writes copied into the pipe buffer instead");
+#endif
 
 static void pipeinit(void *dummy __unused);
 static void pipeclose(struct pipe *cpipe);
@@ -925,6 +959,7 @@ pipe_clone_write_buffer(struct pipe *wpipe)
 	wpipe->pipe_buffer.out = 0;
 	wpipe->pipe_buffer.cnt = size;
 	wpipe->pipe_state &= ~PIPE_DIRECTW;
+	pipedirectfallbacks++;
 
 	PIPE_UNLOCK(wpipe);
 	iov.iov_base = wpipe->pipe_buffer.buffer;
@@ -1036,6 +1071,7 @@ retry:
 		 */
 		pipe_clone_write_buffer(wpipe);
 	} else {
+		pipedirecthits++;
 		pipe_destroy_write_buffer(wpipe);
 	}
 	pipeunlock(wpipe);
@@ -1148,8 +1184,8 @@ pipe_write(struct file *fp, struct uio *uio, struct ucred *active_cred,
 		 * away on us.
 		 */
 		if (uio->uio_segflg == UIO_USERSPACE &&
-		    uio->uio_iov->iov_len >= PIPE_MINDIRECT &&
-		    wpipe->pipe_buffer.size >= PIPE_MINDIRECT &&
+		    uio->uio_iov->iov_len >= (u_long)pipe_mindirect &&
+		    wpipe->pipe_buffer.size >= (u_long)pipe_mindirect &&
 		    (fp->f_flag & FNONBLOCK) == 0) {
 			pipeunlock(wpipe);
 			error = pipe_direct_write(wpipe, uio);
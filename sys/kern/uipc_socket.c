@@ -173,6 +173,7 @@ static int	filt_soread(struct knote *kn, long hint);
 static void	filt_sowdetach(struct knote *kn);
 static int	filt_sowrite(struct knote *kn, long hint);
 static int	filt_soempty(struct knote *kn, long hint);
+static int	filt_sosendfile(struct knote *kn, long hint);
 static int inline hhook_run_socket(struct socket *so, void *hctx, int32_t h_id);
 fo_kqfilter_t	soo_kqfilter;
 
@@ -191,6 +192,11 @@ static struct filterops soempty_filtops = {
 	.f_detach = filt_sowdetach,
 	.f_event = filt_soempty,
 };
+static struct filterops sosendfile_filtops = {
+	.f_isfd = 1,
+	.f_detach = filt_sowdetach,
+	.f_event = filt_sosendfile,
+};
 
 so_gen_t	so_gencnt;	/* generation count for sockets */
 
@@ -2205,7 +2211,7 @@ soreceive_stream(struct socket *so, struct sockaddr **psa, struct uio *uio,
 {
 	int len = 0, error = 0, flags, oresid;
 	struct sockbuf *sb;
-	struct mbuf *m, *n = NULL;
+	struct mbuf *m, *n = NULL, *mfree = NULL;
 
 	/* We only do stream sockets. */
 	if (so->so_type != SOCK_STREAM)
@@ -2364,17 +2370,20 @@ deliver:
 
 	/*
 	 * Remove the delivered data from the socket buffer unless we
-	 * were only peeking.
+	 * were only peeking.  Freeing the detached chain can be a long
+	 * walk, so defer it until the sockbuf lock has been dropped.
 	 */
 	if (!(flags & MSG_PEEK)) {
 		if (len > 0)
-			sbdrop_locked(sb, len);
+			mfree = sbcut_locked(sb, len);
 
 		/* Notify protocol that we drained some data. */
 		if ((so->so_proto->pr_flags & PR_WANTRCVD) &&
 		    (((flags & MSG_WAITALL) && uio->uio_resid > 0) ||
 		     !(flags & MSG_SOCALLBCK))) {
 			SOCKBUF_UNLOCK(sb);
+			m_freem(mfree);
+			mfree = NULL;
 			VNET_SO_ASSERT(so);
 			(*so->so_proto->pr_usrreqs->pru_rcvd)(so, flags);
 			SOCKBUF_LOCK(sb);
@@ -2385,13 +2394,19 @@ deliver:
 	 * For MSG_WAITALL we may have to loop again and wait for
 	 * more data to come in.
 	 */
-	if ((flags & MSG_WAITALL) && uio->uio_resid > 0)
+	if ((flags & MSG_WAITALL) && uio->uio_resid > 0) {
+		if (mfree != NULL) {
+			m_freem(mfree);
+			mfree = NULL;
+		}
 		goto restart;
+	}
 out:
 	SOCKBUF_LOCK_ASSERT(sb);
 	SBLASTRECORDCHK(sb);
 	SBLASTMBUFCHK(sb);
 	SOCKBUF_UNLOCK(sb);
+	m_freem(mfree);
 	sbunlock(sb);
 	return (error);
 }
@@ -3399,6 +3414,11 @@ soo_kqfilter(struct file *fp, struct knote *kn)
 		knl = &so->so_wrsel.si_note;
 		sb = &so->so_snd;
 		break;
+	case EVFILT_SENDFILE:
+		kn->kn_fop = &sosendfile_filtops;
+		knl = &so->so_wrsel.si_note;
+		sb = &so->so_snd;
+		break;
 	default:
 		return (EINVAL);
 	}
@@ -3680,6 +3700,27 @@ filt_sowrite(struct knote *kn, long hint)
 		return (kn->kn_data >= so->so_snd.sb_lowat);
 }
 
+/*
+ * Completed asynchronous sendfile(2) operations post their
+ * classification in the hint (see sendfile_iodone()).  They are
+ * accumulated rather than reported one by one, so any number of
+ * completions between two kevent(2) calls collapse into a single
+ * event: kn_data counts the operations and kn_fflags carries the
+ * NOTE_SENDFILE_* summary.  With EV_CLEAR both reset on delivery.
+ * Plain socket buffer wakeups pass a zero hint and leave the
+ * accumulators untouched.
+ */
+static int
+filt_sosendfile(struct knote *kn, long hint)
+{
+
+	if (hint != 0) {
+		kn->kn_data++;
+		kn->kn_fflags |= (int)hint;
+	}
+	return (kn->kn_data != 0);
+}
+
 static int
 filt_soempty(struct knote *kn, long hint)
 {
@@ -3851,12 +3892,15 @@ soisdisconnected(struct socket *so)
 	so->so_state |= SS_ISDISCONNECTED;
 
 	if (!SOLISTENING(so)) {
+		struct mbuf *mfree;
+
 		SOCK_UNLOCK(so);
 		SOCKBUF_LOCK(&so->so_rcv);
 		socantrcvmore_locked(so);
 		SOCKBUF_LOCK(&so->so_snd);
-		sbdrop_locked(&so->so_snd, sbused(&so->so_snd));
+		mfree = sbcut_locked(&so->so_snd, sbused(&so->so_snd));
 		socantsendmore_locked(so);
+		m_freem(mfree);
 	} else
 		SOCK_UNLOCK(so);
 	wakeup(&so->so_timeo);
@@ -311,8 +311,10 @@ static void	unp_freerights(struct filedescent **, int);
 static void	unp_init(void);
 static int	unp_internalize(struct mbuf **, struct thread *);
 static void	unp_internalize_fp(struct file *);
+static void	unp_internalize_fp_locked(struct file *);
 static int	unp_externalize(struct mbuf *, struct mbuf **, int);
 static int	unp_externalize_fp(struct file *);
+static int	unp_externalize_fp_locked(struct file *);
 static struct mbuf	*unp_addsockcred(struct thread *, struct mbuf *);
 static void	unp_process_defers(void * __unused, int);
 
@@ -2045,9 +2047,19 @@ unp_externalize(struct mbuf *control, struct mbuf **controlp, int flags)
 				_finstall(fdesc, fdep[i]->fde_file, *fdp,
 				    (flags & MSG_CMSG_CLOEXEC) != 0 ? UF_EXCLOSE : 0,
 				    &fdep[i]->fde_caps);
-				unp_externalize_fp(fdep[i]->fde_file);
 			}
 
+			/*
+			 * Adjust the in-flight accounting for the whole
+			 * message with a single acquisition of the global
+			 * linkage lock rather than one per descriptor.
+			 */
+			UNP_LINK_WLOCK();
+			for (i = 0; i < newfds; i++)
+				(void)unp_externalize_fp_locked(
+				    fdep[i]->fde_file);
+			UNP_LINK_WUNLOCK();
+
 			/*
 			 * The new type indicates that the mbuf data refers to
 			 * kernel resources that may need to be released before
@@ -2224,8 +2236,18 @@ unp_internalize(struct mbuf **controlp, struct thread *td)
 				fdep[i]->fde_file = fde->fde_file;
 				filecaps_copy(&fde->fde_caps,
 				    &fdep[i]->fde_caps, true);
-				unp_internalize_fp(fdep[i]->fde_file);
 			}
+
+			/*
+			 * As in unp_externalize(), account for the whole
+			 * message under one hold of the linkage lock.  This
+			 * is kept out of the loop above since filecaps_copy()
+			 * may allocate.
+			 */
+			UNP_LINK_WLOCK();
+			for (i = 0; i < oldfds; i++)
+				unp_internalize_fp_locked(fdep[i]->fde_file);
+			UNP_LINK_WUNLOCK();
 			FILEDESC_SUNLOCK(fdesc);
 			break;
 
@@ -2406,33 +2428,51 @@ unp_process_defers(void *arg __unused, int pending)
 }
 
 static void
-unp_internalize_fp(struct file *fp)
+unp_internalize_fp_locked(struct file *fp)
 {
 	struct unpcb *unp;
 
-	UNP_LINK_WLOCK();
+	UNP_LINK_WLOCK_ASSERT();
 	if ((unp = fptounp(fp)) != NULL) {
 		unp->unp_file = fp;
 		unp->unp_msgcount++;
 	}
 	fhold(fp);
 	unp_rights++;
+}
+
+static void
+unp_internalize_fp(struct file *fp)
+{
+
+	UNP_LINK_WLOCK();
+	unp_internalize_fp_locked(fp);
 	UNP_LINK_WUNLOCK();
 }
 
 static int
-unp_externalize_fp(struct file *fp)
+unp_externalize_fp_locked(struct file *fp)
 {
 	struct unpcb *unp;
 	int ret;
 
-	UNP_LINK_WLOCK();
+	UNP_LINK_WLOCK_ASSERT();
 	if ((unp = fptounp(fp)) != NULL) {
 		unp->unp_msgcount--;
 		ret = 1;
 	} else
 		ret = 0;
 	unp_rights--;
+	return (ret);
+}
+
+static int
+unp_externalize_fp(struct file *fp)
+{
+	int ret;
+
+	UNP_LINK_WLOCK();
+	ret = unp_externalize_fp_locked(fp);
 	UNP_LINK_WUNLOCK();
 	return (ret);
 }
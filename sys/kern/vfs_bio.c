@@ -68,6 +68,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/racct.h>
 #include <sys/resourcevar.h>
 #include <sys/rwlock.h>
+#include <sys/sbuf.h>
 #include <sys/smp.h>
 #include <sys/sysctl.h>
 #include <sys/sysproto.h>
@@ -129,6 +130,10 @@ struct bufdomain {
 	int		bd_lodirtybuffers;
 	int		bd_dirtybufthresh;
 	int		bd_lim;
+	/* bufdaemon state, protected by bdlock */
+	int		bd_request;
+	int		bd_speedupreq;
+	long		bd_flushed;
 	/* atomics */
 	int		bd_wanted;
 	int __aligned(CACHE_LINE_SIZE)	bd_numdirtybuffers;
@@ -172,7 +177,7 @@ static void breada(struct vnode *, daddr_t *, int *, int, struct ucred *, int,
 static int buf_flush(struct vnode *vp, struct bufdomain *, int);
 static int flushbufqueues(struct vnode *, struct bufdomain *, int, int);
 static void buf_daemon(void);
-static __inline void bd_wakeup(void);
+static __inline void bd_wakeup(struct bufdomain *bd);
 static int sysctl_runningspace(SYSCTL_HANDLER_ARGS);
 static void bufkva_reclaim(vmem_t *, int);
 static void bufkva_free(struct buf *);
@@ -318,7 +323,8 @@ SYSCTL_INT(_vfs, OID_AUTO, maxbcachebuf, CTLFLAG_RDTUN, &maxbcachebuf, 0,
     "Maximum size of a buffer cache block");
 
 /*
- * This lock synchronizes access to bd_request.
+ * This lock synchronizes access to the bd_request and bd_speedupreq
+ * fields of each buffer domain.
  */
 static struct mtx_padalign __exclusive_cache_line bdlock;
 
@@ -333,21 +339,6 @@ static struct mtx_padalign __exclusive_cache_line rbreqlock;
  */
 static struct mtx_padalign __exclusive_cache_line bdirtylock;
 
-/*
- * Wakeup point for bufdaemon, as well as indicator of whether it is already
- * active.  Set to 1 when the bufdaemon is already "on" the queue, 0 when it
- * is idling.
- */
-static int bd_request;
-
-/*
- * Request for the buf daemon to write more buffers than is indicated by
- * lodirtybuf.  This may be necessary to push out excess dependencies or
- * defragment the address space where a simple count of the number of dirty
- * buffers is insufficient to characterize the demand for flushing them.
- */
-static int bd_speedupreq;
-
 /*
  * Synchronization (sleep/wakeup) variable for active buffer space requests.
  * Set when wait starts, cleared prior to wakeup().
@@ -505,6 +496,28 @@ sysctl_numdirtybuffers(SYSCTL_HANDLER_ARGS)
 	return (sysctl_handle_int(oidp, &value, 0, req));
 }
 
+static int
+sysctl_domain_flushed(SYSCTL_HANDLER_ARGS)
+{
+	struct bufdomain *bd;
+	struct sbuf sb;
+	int error, i;
+
+	sbuf_new_for_sysctl(&sb, NULL, buf_domains * 32, req);
+	for (i = 0; i < buf_domains; i++) {
+		bd = &bdomain[i];
+		sbuf_printf(&sb, "%s%d:%d:%ld", i == 0 ? "" : " ", i,
+		    bd->bd_numdirtybuffers, bd->bd_flushed);
+	}
+	error = sbuf_finish(&sb);
+	sbuf_delete(&sb);
+	return (error);
+}
+SYSCTL_PROC(_vfs, OID_AUTO, domain_flushed,
+    CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+    sysctl_domain_flushed, "A",
+    "Per-domain domain:numdirty:flushed buf daemon statistics");
+
 /*
  *	bdirtywakeup:
  *
@@ -596,7 +609,7 @@ bdirtyadd(struct buf *bp)
 	bd = bufdomain(bp);
 	num = atomic_fetchadd_int(&bd->bd_numdirtybuffers, 1);
 	if (num == (bd->bd_lodirtybuffers + bd->bd_hidirtybuffers) / 2)
-		bd_wakeup();
+		bd_wakeup(bd);
 	if (num == bd->bd_lodirtybuffers || num == bd->bd_hidirtybuffers)
 		bd_set(bd);
 }
@@ -962,15 +975,15 @@ vfs_buf_test_cache(struct buf *bp, vm_ooffset_t foff, vm_offset_t off,
 	}
 }
 
-/* Wake up the buffer daemon if necessary */
+/* Wake up the domain's buffer daemon if necessary */
 static void
-bd_wakeup(void)
+bd_wakeup(struct bufdomain *bd)
 {
 
 	mtx_lock(&bdlock);
-	if (bd_request == 0) {
-		bd_request = 1;
-		wakeup(&bd_request);
+	if (bd->bd_request == 0) {
+		bd->bd_request = 1;
+		wakeup(&bd->bd_request);
 	}
 	mtx_unlock(&bdlock);
 }
@@ -1004,16 +1017,20 @@ maxbcachebuf_adjust(void)
 void
 bd_speedup(void)
 {
-	int needwake;
+	struct bufdomain *bd;
+	int i, needwake;
 
 	mtx_lock(&bdlock);
-	needwake = 0;
-	if (bd_speedupreq == 0 || bd_request == 0)
-		needwake = 1;
-	bd_speedupreq = 1;
-	bd_request = 1;
-	if (needwake)
-		wakeup(&bd_request);
+	for (i = 0; i < buf_domains; i++) {
+		bd = &bdomain[i];
+		needwake = 0;
+		if (bd->bd_speedupreq == 0 || bd->bd_request == 0)
+			needwake = 1;
+		bd->bd_speedupreq = 1;
+		bd->bd_request = 1;
+		if (needwake)
+			wakeup(&bd->bd_request);
+	}
 	mtx_unlock(&bdlock);
 }
 
@@ -3355,38 +3372,28 @@ buf_flush(struct vnode *vp, struct bufdomain *bd, int target)
 }
 
 static void
-buf_daemon()
+buf_daemon_worker(void *arg)
 {
 	struct bufdomain *bd;
 	int speedupreq;
 	int lodirty;
-	int i;
+	int flushed;
+
+	bd = arg;
 
 	/*
-	 * This process needs to be suspended prior to shutdown sync.
+	 * This thread needs to be suspended prior to shutdown sync.
 	 */
 	EVENTHANDLER_REGISTER(shutdown_pre_sync, kthread_shutdown, curthread,
 	    SHUTDOWN_PRI_LAST + 100);
 
-	/*
-	 * Start the buf clean daemons as children threads.
-	 */
-	for (i = 0 ; i < buf_domains; i++) {
-		int error;
-
-		error = kthread_add((void (*)(void *))bufspace_daemon,
-		    &bdomain[i], curproc, NULL, 0, 0, "bufspacedaemon-%d", i);
-		if (error)
-			panic("error %d spawning bufspace daemon", error);
-	}
-
 	/*
 	 * This process is allowed to take the buffer cache to the limit
 	 */
 	curthread->td_pflags |= TDP_NORUNNINGBUF | TDP_BUFNEED;
 	mtx_lock(&bdlock);
 	for (;;) {
-		bd_request = 0;
+		bd->bd_request = 0;
 		mtx_unlock(&bdlock);
 
 		kthread_suspend_check();
@@ -3395,25 +3402,24 @@ buf_daemon()
 		 * Save speedupreq for this pass and reset to capture new
 		 * requests.
 		 */
-		speedupreq = bd_speedupreq;
-		bd_speedupreq = 0;
+		speedupreq = bd->bd_speedupreq;
+		bd->bd_speedupreq = 0;
 
 		/*
-		 * Flush each domain sequentially according to its level and
-		 * the speedup request.
+		 * Flush the domain according to its level and the speedup
+		 * request.
 		 */
-		for (i = 0; i < buf_domains; i++) {
-			bd = &bdomain[i];
-			if (speedupreq)
-				lodirty = bd->bd_numdirtybuffers / 2;
-			else
-				lodirty = bd->bd_lodirtybuffers;
-			while (bd->bd_numdirtybuffers > lodirty) {
-				if (buf_flush(NULL, bd,
-				    bd->bd_numdirtybuffers - lodirty) == 0)
-					break;
-				kern_yield(PRI_USER);
-			}
+		if (speedupreq)
+			lodirty = bd->bd_numdirtybuffers / 2;
+		else
+			lodirty = bd->bd_lodirtybuffers;
+		while (bd->bd_numdirtybuffers > lodirty) {
+			flushed = buf_flush(NULL, bd,
+			    bd->bd_numdirtybuffers - lodirty);
+			if (flushed == 0)
+				break;
+			bd->bd_flushed += flushed;
+			kern_yield(PRI_USER);
 		}
 
 		/*
@@ -3427,13 +3433,13 @@ buf_daemon()
 		 * to avoid endless loops on unlockable buffers.
 		 */
 		mtx_lock(&bdlock);
-		if (!BIT_EMPTY(BUF_DOMAINS, &bdlodirty)) {
+		if (!BIT_ISSET(BUF_DOMAINS, BD_DOMAIN(bd), &bdlodirty)) {
 			/*
 			 * We reached our low water mark, reset the
 			 * request and sleep until we are needed again.
 			 * The sleep is just so the suspend code works.
 			 */
-			bd_request = 0;
+			bd->bd_request = 0;
 			/*
 			 * Do an extra wakeup in case dirty threshold
 			 * changed via sysctl and the explicit transition
@@ -3442,18 +3448,49 @@ buf_daemon()
 			bdirtywakeup();
 			if (runningbufspace <= lorunningspace)
 				runningwakeup();
-			msleep(&bd_request, &bdlock, PVM, "psleep", hz);
+			msleep(&bd->bd_request, &bdlock, PVM, "psleep", hz);
 		} else {
 			/*
 			 * We couldn't find any flushable dirty buffers but
 			 * still have too many dirty buffers, we
 			 * have to sleep and try again.  (rare)
 			 */
-			msleep(&bd_request, &bdlock, PVM, "qsleep", hz / 10);
+			msleep(&bd->bd_request, &bdlock, PVM, "qsleep",
+			    hz / 10);
 		}
 	}
 }
 
+static void
+buf_daemon()
+{
+	int error;
+	int i;
+
+	/*
+	 * Start the buf clean daemons as children threads.
+	 */
+	for (i = 0 ; i < buf_domains; i++) {
+		error = kthread_add((void (*)(void *))bufspace_daemon,
+		    &bdomain[i], curproc, NULL, 0, 0, "bufspacedaemon-%d", i);
+		if (error)
+			panic("error %d spawning bufspace daemon", error);
+	}
+
+	/*
+	 * Each domain gets its own flushing thread so that a single
+	 * saturated domain does not delay the others.  This thread
+	 * services domain 0 itself.
+	 */
+	for (i = 1; i < buf_domains; i++) {
+		error = kthread_add(buf_daemon_worker, &bdomain[i], curproc,
+		    NULL, 0, 0, "bufdaemon-%d", i);
+		if (error)
+			panic("error %d spawning buf daemon", error);
+	}
+	buf_daemon_worker(&bdomain[0]);
+}
+
 /*
  *	flushbufqueues:
  *
@@ -42,7 +42,9 @@ __FBSDID("$FreeBSD$");
 
 #include <sys/param.h>
 #include <sys/systm.h>
+#include <sys/ck.h>
 #include <sys/counter.h>
+#include <sys/epoch.h>
 #include <sys/filedesc.h>
 #include <sys/fnv_hash.h>
 #include <sys/kernel.h>
@@ -52,6 +54,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/mount.h>
 #include <sys/namei.h>
 #include <sys/proc.h>
+#include <sys/refcount.h>
 #include <sys/rwlock.h>
 #include <sys/sdt.h>
 #include <sys/smp.h>
@@ -102,9 +105,10 @@ SDT_PROBE_DEFINE3(vfs, namecache, shrink_negative, done, "struct vnode *",
  */
 
 struct	namecache {
-	LIST_ENTRY(namecache) nc_hash;	/* hash chain */
+	CK_LIST_ENTRY(namecache) nc_hash;/* hash chain */
 	LIST_ENTRY(namecache) nc_src;	/* source vnode list */
 	TAILQ_ENTRY(namecache) nc_dst;	/* destination vnode list */
+	struct	epoch_context nc_epoch_ctx; /* deferred free */
 	struct	vnode *nc_dvp;		/* vnode of parent of name */
 	union {
 		struct	vnode *nu_vp;	/* vnode the name refers to */
@@ -143,6 +147,7 @@ struct	namecache_ts {
 #define	NCF_DVDROP	0x10
 #define	NCF_NEGATIVE	0x20
 #define	NCF_HOTNEGATIVE	0x40
+#define	NCF_INVALID	0x80
 
 /*
  * Name caching works as follows:
@@ -197,8 +202,16 @@ struct	namecache_ts {
  */
 #define NCHHASH(hash) \
 	(&nchashtbl[(hash) & nchash])
-static __read_mostly LIST_HEAD(nchashhead, namecache) *nchashtbl;/* Hash Table */
+static __read_mostly CK_LIST_HEAD(nchashhead, namecache) *nchashtbl;/* Hash Table */
 static u_long __read_mostly	nchash;			/* size of hash table */
+
+/*
+ * Protects the lockless fast path of cache_lookup().  Hash chain
+ * traversal runs in an epoch section; entries and the vnodes they
+ * point at are freed only once readers have drained, making stale
+ * pointers safe to inspect and reject.
+ */
+__read_mostly epoch_t	vfs_cache_epoch;
 SYSCTL_ULONG(_debug, OID_AUTO, nchash, CTLFLAG_RD, &nchash, 0,
     "Size of namecache hash table");
 static u_long __read_mostly	ncnegfactor = 12; /* ratio of negative entries */
@@ -297,14 +310,12 @@ cache_alloc(int len, int ts)
 }
 
 static void
-cache_free(struct namecache *ncp)
+cache_free_epoch(epoch_context_t ctx)
 {
 	struct namecache_ts *ncp_ts;
+	struct namecache *ncp;
 
-	if (ncp == NULL)
-		return;
-	if ((ncp->nc_flag & NCF_DVDROP) != 0)
-		vdrop(ncp->nc_dvp);
+	ncp = __containerof(ctx, struct namecache, nc_epoch_ctx);
 	if (__predict_false(ncp->nc_flag & NCF_TS)) {
 		ncp_ts = __containerof(ncp, struct namecache_ts, nc_nc);
 		if (ncp->nc_nlen <= CACHE_PATH_CUTOFF)
@@ -319,6 +330,22 @@ cache_free(struct namecache *ncp)
 	}
 }
 
+static void
+cache_free(struct namecache *ncp)
+{
+
+	if (ncp == NULL)
+		return;
+	if ((ncp->nc_flag & NCF_DVDROP) != 0)
+		vdrop(ncp->nc_dvp);
+	/*
+	 * Lockless lookups may still be traversing this entry's hash
+	 * linkage or inspecting its fields; defer the actual free until
+	 * they have drained.
+	 */
+	epoch_call(vfs_cache_epoch, &ncp->nc_epoch_ctx, cache_free_epoch);
+}
+
 static void
 cache_out_ts(struct namecache *ncp, struct timespec *tsp, int *ticksp)
 {
@@ -370,6 +397,10 @@ STATNODE_COUNTER(numposhits, "Number of cache hits (positive)");
 STATNODE_COUNTER(numnegzaps,
     "Number of cache hits (negative) we do not want to cache");
 STATNODE_COUNTER(numneghits, "Number of cache hits (negative)");
+STATNODE_COUNTER(numbatches,
+    "Number of batched lookups that consumed at least one component");
+STATNODE_COUNTER(numbatchcomps,
+    "Number of components consumed by batched lookups");
 /* These count for kern___getcwd(), too. */
 STATNODE_COUNTER(numfullpathcalls, "Number of fullpath search calls");
 STATNODE_COUNTER(numfullpathfail1, "Number of fullpath search errors (ENOTDIR)");
@@ -582,7 +613,7 @@ retry:
 	}
 	/* Scan hash tables counting entries */
 	for (ncpp = nchashtbl, i = 0; i < n_nchash; ncpp++, i++)
-		LIST_FOREACH(ncp, ncpp, nc_hash)
+		CK_LIST_FOREACH(ncp, ncpp, nc_hash)
 			cntbuf[i]++;
 	cache_unlock_all_buckets();
 	for (error = 0, i = 0; i < n_nchash; i++)
@@ -615,7 +646,7 @@ sysctl_debug_hashstat_nchash(SYSCTL_HANDLER_ARGS)
 	/* Scan hash tables for applicable entries */
 	for (ncpp = nchashtbl; n_nchash > 0; n_nchash--, ncpp++) {
 		count = 0;
-		LIST_FOREACH(ncp, ncpp, nc_hash) {
+		CK_LIST_FOREACH(ncp, ncpp, nc_hash) {
 			count++;
 		}
 		if (count)
@@ -858,7 +889,14 @@ cache_zap_locked(struct namecache *ncp, bool neg_locked)
 		SDT_PROBE3(vfs, namecache, zap_negative, done, ncp->nc_dvp,
 		    ncp->nc_name, ncp->nc_neghits);
 	}
-	LIST_REMOVE(ncp, nc_hash);
+	/*
+	 * Mark the entry dead before unlinking it so that lockless
+	 * lookups which raced with the zap can detect it; see the
+	 * revalidation in cache_lookup().
+	 */
+	ncp->nc_flag |= NCF_INVALID;
+	atomic_thread_fence_rel();
+	CK_LIST_REMOVE(ncp, nc_hash);
 	if (!(ncp->nc_flag & NCF_NEGATIVE)) {
 		TAILQ_REMOVE(&ncp->nc_vp->v_cache_dst, ncp, nc_dst);
 		if (ncp == ncp->nc_vp->v_cache_dd)
@@ -1200,7 +1238,7 @@ retry:
 
 	rw_wlock(blp);
 
-	LIST_FOREACH(ncp, (NCHHASH(hash)), nc_hash) {
+	CK_LIST_FOREACH(ncp, (NCHHASH(hash)), nc_hash) {
 		counter_u64_add(numchecks, 1);
 		if (ncp->nc_dvp == dvp && ncp->nc_nlen == cnp->cn_namelen &&
 		    !bcmp(ncp->nc_name, cnp->cn_nameptr, ncp->nc_nlen))
@@ -1253,6 +1291,82 @@ cache_lookup(struct vnode *dvp, struct vnode **vpp, struct componentname *cnp,
 	if ((cnp->cn_flags & MAKEENTRY) == 0)
 		return (cache_lookup_nomakeentry(dvp, vpp, cnp, tsp, ticksp));
 
+	/*
+	 * Try a lockless lookup first.  The hash chain is traversed
+	 * within an epoch section; entries and the vnodes they point at
+	 * are not freed until readers drain, so a racing zap at worst
+	 * makes the revalidation below fail and sends us to the locked
+	 * path.  A hold is acquired on the vnode before revalidating:
+	 * while the entry is still hashed and maps to the same vnode,
+	 * the vnode cannot have been reclaimed, because cache_purge()
+	 * marks and unlinks the entry first.  ".." lookups go through
+	 * v_cache_dd and keep requiring the vnode lock.
+	 */
+	if (__predict_true(cnp->cn_namelen != 2 ||
+	    cnp->cn_nameptr[0] != '.' || cnp->cn_nameptr[1] != '.')) {
+		struct epoch_tracker et;
+		struct vnode *vp;
+
+		hash = cache_get_hash(cnp->cn_nameptr, cnp->cn_namelen, dvp);
+		epoch_enter_preempt(vfs_cache_epoch, &et);
+		CK_LIST_FOREACH(ncp, (NCHHASH(hash)), nc_hash) {
+			counter_u64_add(numchecks, 1);
+			if (ncp->nc_dvp == dvp &&
+			    ncp->nc_nlen == cnp->cn_namelen &&
+			    !bcmp(ncp->nc_name, cnp->cn_nameptr, ncp->nc_nlen))
+				break;
+		}
+		if (ncp == NULL) {
+			epoch_exit_preempt(vfs_cache_epoch, &et);
+			SDT_PROBE3(vfs, namecache, lookup, miss, dvp,
+			    cnp->cn_nameptr, NULL);
+			counter_u64_add(nummiss, 1);
+			return (0);
+		}
+		if (__predict_true((ncp->nc_flag &
+		    (NCF_NEGATIVE | NCF_INVALID)) == 0)) {
+			vp = ncp->nc_vp;
+			if (refcount_acquire_if_not_zero(&vp->v_holdcnt)) {
+				atomic_thread_fence_acq();
+				if (__predict_true((ncp->nc_flag &
+				    NCF_INVALID) == 0 && ncp->nc_vp == vp)) {
+					counter_u64_add(numposhits, 1);
+					CTR4(KTR_VFS,
+				    "cache_lookup(%p, %s) found %p via ncp %p",
+					    dvp, cnp->cn_nameptr, vp, ncp);
+					SDT_PROBE3(vfs, namecache, lookup, hit,
+					    dvp, ncp->nc_name, vp);
+					cache_out_ts(ncp, tsp, ticksp);
+					epoch_exit_preempt(vfs_cache_epoch,
+					    &et);
+					MPASS(dvp != vp);
+					error = vget(vp, cnp->cn_lkflags |
+					    LK_VNHELD, cnp->cn_thread);
+					if (error) {
+						*vpp = NULL;
+						goto retry;
+					}
+					*vpp = vp;
+					if ((cnp->cn_flags & ISLASTCN) &&
+					    (cnp->cn_lkflags & LK_TYPE_MASK) ==
+					    LK_EXCLUSIVE) {
+						ASSERT_VOP_ELOCKED(*vpp,
+						    "cache_lookup");
+					}
+					return (-1);
+				}
+				epoch_exit_preempt(vfs_cache_epoch, &et);
+				vdrop(vp);
+				goto retry;
+			}
+		}
+		/*
+		 * Negative entry, a zap in progress or the vnode is on
+		 * its way out; take the locks and settle it.
+		 */
+		epoch_exit_preempt(vfs_cache_epoch, &et);
+	}
+
 retry:
 	blp = NULL;
 	dvlp = NULL;
@@ -1296,7 +1410,7 @@ retry:
 	blp = HASH2BUCKETLOCK(hash);
 	rw_rlock(blp);
 
-	LIST_FOREACH(ncp, (NCHHASH(hash)), nc_hash) {
+	CK_LIST_FOREACH(ncp, (NCHHASH(hash)), nc_hash) {
 		counter_u64_add(numchecks, 1);
 		if (ncp->nc_dvp == dvp && ncp->nc_nlen == cnp->cn_namelen &&
 		    !bcmp(ncp->nc_name, cnp->cn_nameptr, ncp->nc_nlen))
@@ -1388,6 +1502,109 @@ zap_and_exit:
 	return (0);
 }
 
+/*
+ * Maximum number of components consumed by one cache_lookup_batch() call.
+ */
+#define	CACHE_BATCH_MAX	16
+
+/*
+ * Batched variant of the lockless fast path in cache_lookup(), used by
+ * lookup() to fast forward over runs of cached intermediate components.
+ *
+ * Starting at cnp->cn_nameptr, consume as many consecutive plain
+ * components as can be resolved from the cache within a single epoch
+ * section, without taking any vnode lock.  Only positive entries naming
+ * directories that are not mount points qualify, and the last component
+ * of the path is never consumed, so symlinks, ".", "..", negative
+ * entries and all last-component side effects (lock modes, auditing,
+ * SAVENAME and friends) keep going through the per-component path.
+ * Each vnode along the way is held and its entry revalidated exactly as
+ * in the single-component fast path, making every step as strong as a
+ * locked lookup of that component; the batch adds no atomicity across
+ * steps, but neither has the per-component loop it replaces.
+ *
+ * On success the number of path bytes consumed (names and separating
+ * slashes) is returned and *vpp is the deepest resolved directory with
+ * a hold but no lock; the caller is expected to vget() it and only then
+ * commit to the consumed prefix.  Returns 0 if nothing was consumed.
+ */
+int
+cache_lookup_batch(struct vnode *dvp, struct vnode **vpp,
+    struct componentname *cnp)
+{
+	struct epoch_tracker et;
+	struct namecache *ncp;
+	struct vnode *held[CACHE_BATCH_MAX];
+	struct vnode *nvp, *vp;
+	char *cp, *name;
+	uint32_t hash;
+	int consumed, i, namelen, ncomps, nheld;
+
+	if (__predict_false(!doingcache))
+		return (0);
+
+	consumed = 0;
+	ncomps = 0;
+	nheld = 0;
+	vp = NULL;
+	cp = cnp->cn_nameptr;
+	epoch_enter_preempt(vfs_cache_epoch, &et);
+	while (nheld < CACHE_BATCH_MAX) {
+		name = cp;
+		while (*cp != '\0' && *cp != '/')
+			cp++;
+		namelen = cp - name;
+		if (*cp == '\0' || cp[1] == '\0' || cp[1] == '/')
+			break;	/* Last component, or empty ones ahead. */
+		if (namelen == 0 || namelen > NAME_MAX)
+			break;
+		if (name[0] == '.' && (namelen == 1 ||
+		    (namelen == 2 && name[1] == '.')))
+			break;
+		hash = cache_get_hash(name, namelen, dvp);
+		CK_LIST_FOREACH(ncp, (NCHHASH(hash)), nc_hash) {
+			counter_u64_add(numchecks, 1);
+			if (ncp->nc_dvp == dvp && ncp->nc_nlen == namelen &&
+			    !bcmp(ncp->nc_name, name, namelen))
+				break;
+		}
+		if (ncp == NULL ||
+		    (ncp->nc_flag & (NCF_NEGATIVE | NCF_INVALID)) != 0)
+			break;
+		nvp = ncp->nc_vp;
+		if (nvp->v_type != VDIR || nvp->v_mountedhere != NULL)
+			break;
+		if (!refcount_acquire_if_not_zero(&nvp->v_holdcnt))
+			break;
+		atomic_thread_fence_acq();
+		held[nheld++] = nvp;
+		if ((ncp->nc_flag & NCF_INVALID) != 0 || ncp->nc_vp != nvp)
+			break;
+		SDT_PROBE3(vfs, namecache, lookup, hit, dvp, ncp->nc_name,
+		    nvp);
+		vp = nvp;
+		dvp = nvp;
+		ncomps++;
+		cp++;			/* Skip the slash. */
+		consumed = cp - cnp->cn_nameptr;
+	}
+	epoch_exit_preempt(vfs_cache_epoch, &et);
+
+	/*
+	 * Keep the hold on the final vnode for the caller, drop the rest.
+	 */
+	for (i = 0; i < nheld; i++) {
+		if (held[i] != vp)
+			vdrop(held[i]);
+	}
+	if (vp == NULL)
+		return (0);
+	counter_u64_add(numbatches, 1);
+	counter_u64_add(numbatchcomps, ncomps);
+	*vpp = vp;
+	return (consumed);
+}
+
 struct celockstate {
 	struct mtx *vlp[3];
 	struct rwlock *blp[2];
@@ -1722,7 +1939,7 @@ cache_enter_time(struct vnode *dvp, struct vnode *vp, struct componentname *cnp,
 	 * the same path name.
 	 */
 	ncpp = NCHHASH(hash);
-	LIST_FOREACH(n2, ncpp, nc_hash) {
+	CK_LIST_FOREACH(n2, ncpp, nc_hash) {
 		if (n2->nc_dvp == dvp &&
 		    n2->nc_nlen == cnp->cn_namelen &&
 		    !bcmp(n2->nc_name, cnp->cn_nameptr, n2->nc_nlen)) {
@@ -1790,7 +2007,7 @@ cache_enter_time(struct vnode *dvp, struct vnode *vp, struct componentname *cnp,
 	 * Insert the new namecache entry into the appropriate chain
 	 * within the cache entries table.
 	 */
-	LIST_INSERT_HEAD(ncpp, ncp, nc_hash);
+	CK_LIST_INSERT_HEAD(ncpp, ncp, nc_hash);
 
 	/*
 	 * If the entry is "negative", we place it into the
@@ -1856,6 +2073,8 @@ nchinit(void *dummy __unused)
 	    NULL, NULL, NULL, NULL, UMA_ALIGNOF(struct namecache_ts),
 	    UMA_ZONE_ZINIT);
 
+	vfs_cache_epoch = epoch_alloc(EPOCH_PREEMPT);
+
 	nchashtbl = hashinit(desiredvnodes * 2, M_VFSCACHE, &nchash);
 	ncbuckethash = cache_roundup_2(mp_ncpus * 64) - 1;
 	if (ncbuckethash > nchash)
@@ -1893,6 +2112,8 @@ nchinit(void *dummy __unused)
 	numposhits = counter_u64_alloc(M_WAITOK);
 	numnegzaps = counter_u64_alloc(M_WAITOK);
 	numneghits = counter_u64_alloc(M_WAITOK);
+	numbatches = counter_u64_alloc(M_WAITOK);
+	numbatchcomps = counter_u64_alloc(M_WAITOK);
 	numfullpathcalls = counter_u64_alloc(M_WAITOK);
 	numfullpathfail1 = counter_u64_alloc(M_WAITOK);
 	numfullpathfail2 = counter_u64_alloc(M_WAITOK);
@@ -1932,11 +2153,11 @@ cache_changesize(int newmaxvnodes)
 	nchashtbl = new_nchashtbl;
 	nchash = new_nchash;
 	for (i = 0; i <= old_nchash; i++) {
-		while ((ncp = LIST_FIRST(&old_nchashtbl[i])) != NULL) {
+		while ((ncp = CK_LIST_FIRST(&old_nchashtbl[i])) != NULL) {
 			hash = cache_get_hash(ncp->nc_name, ncp->nc_nlen,
 			    ncp->nc_dvp);
-			LIST_REMOVE(ncp, nc_hash);
-			LIST_INSERT_HEAD(NCHHASH(hash), ncp, nc_hash);
+			CK_LIST_REMOVE(ncp, nc_hash);
+			CK_LIST_INSERT_HEAD(NCHHASH(hash), ncp, nc_hash);
 		}
 	}
 	cache_unlock_all_buckets();
@@ -2049,7 +2270,7 @@ cache_purgevfs(struct mount *mp, bool force)
 		for (j = i; j < n_nchash; j += numbucketlocks) {
 retry:
 			bucket = &nchashtbl[j];
-			LIST_FOREACH_SAFE(ncp, bucket, nc_hash, nnp) {
+			CK_LIST_FOREACH_SAFE(ncp, bucket, nc_hash, nnp) {
 				cache_assert_bucket_locked(ncp, RA_WLOCKED);
 				if (ncp->nc_dvp->v_mount != mp)
 					continue;
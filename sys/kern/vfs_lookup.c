@@ -169,6 +169,10 @@ SYSCTL_INT(_vfs, OID_AUTO, lookup_cap_dotdot_nonlocal, CTLFLAG_RWTUN,
     &lookup_cap_dotdot_nonlocal, 0,
     "enables \"..\" components in path lookup in capability mode "
     "on non-local mount");
+static int lookup_batch = 1;
+SYSCTL_INT(_vfs, OID_AUTO, lookup_batch, CTLFLAG_RWTUN,
+    &lookup_batch, 0,
+    "consume runs of cached path components in a single batch");
 
 static void
 nameicap_tracker_add(struct nameidata *ndp, struct vnode *dp)
@@ -672,6 +676,8 @@ lookup(struct nameidata *ndp)
 	char *prev_ni_next;		/* saved ndp->ni_next */
 	struct vnode *dp = NULL;	/* the directory we are searching */
 	struct vnode *tdp;		/* saved dp */
+	struct vnode *bvp;		/* batched lookup result */
+	int blen;			/* path bytes consumed by the batch */
 	struct mount *mp;		/* mount table entry */
 	struct prison *pr;
 	size_t prev_ni_pathlen;		/* saved ndp->ni_pathlen */
@@ -712,6 +718,41 @@ lookup(struct nameidata *ndp)
 	    cnp->cn_flags));
 
 dirloop:
+	/*
+	 * Try to fast forward over a run of cached intermediate components
+	 * before parsing the next one.  The batch never consumes the last
+	 * component and declines anything unusual, so all the special
+	 * handling below still sees every case it cares about.
+	 * Capability-mode lookups need their per-directory tracker entries
+	 * and MAC kernels their per-component checks, so those stay on the
+	 * per-component path.
+	 */
+	if (lookup_batch && ndp->ni_lcf == 0 &&
+#ifdef MAC
+	    (cnp->cn_flags & NOMACCHECK) != 0 &&
+#endif
+	    dp->v_type == VDIR && (dp->v_iflag & VI_DOOMED) == 0) {
+		blen = cache_lookup_batch(dp, &bvp, cnp);
+		if (blen > 0) {
+			error = vget(bvp, compute_cn_lkflags(bvp->v_mount,
+			    cnp->cn_lkflags, cnp->cn_flags & ~ISDOTDOT) |
+			    LK_VNHELD, cnp->cn_thread);
+			if (error == 0) {
+				cnp->cn_nameptr += blen;
+				ndp->ni_pathlen -= blen;
+				vput(dp);
+				dp = bvp;
+			} else {
+				/*
+				 * vget() dropped the hold; the prefix is
+				 * simply not consumed and the
+				 * per-component loop takes over.
+				 */
+				error = 0;
+			}
+		}
+	}
+
 	/*
 	 * Search a new directory.
 	 *
@@ -111,6 +111,7 @@ static void	v_incr_usecount_locked(struct vnode *);
 static void	v_incr_devcount(struct vnode *);
 static void	v_decr_devcount(struct vnode *);
 static void	vgonel(struct vnode *);
+static void	vnode_free_epoch(epoch_context_t ctx);
 static void	vfs_knllock(void *arg);
 static void	vfs_knlunlock(void *arg);
 static void	vfs_knl_assert_locked(void *arg);
@@ -203,6 +204,20 @@ static counter_u64_t recycles_count;
 SYSCTL_COUNTER_U64(_vfs, OID_AUTO, recycles, CTLFLAG_RD, &recycles_count,
     "Number of vnodes recycled to meet vnode cache targets");
 
+static counter_u64_t recycle_usec;
+SYSCTL_COUNTER_U64(_vfs, OID_AUTO, recycle_usec, CTLFLAG_RD, &recycle_usec,
+    "Total time spent recycling free vnodes, in microseconds");
+
+static u_long recycle_usec_max;
+SYSCTL_ULONG(_vfs, OID_AUTO, recycle_usec_max, CTLFLAG_RW,
+    &recycle_usec_max, 0,
+    "Longest single free vnode recycle seen, in microseconds (writable "
+    "to reset)");
+
+static int vnlru_free_batch = 8;
+SYSCTL_INT(_vfs, OID_AUTO, vnlru_free_batch, CTLFLAG_RW, &vnlru_free_batch,
+    0, "Number of free vnodes reclaimed in one go when the cache is full");
+
 /*
  * Various variables used for debugging the new implementation of
  * reassignbuf().
@@ -493,6 +508,7 @@ vntblinit(void *dummy __unused)
 
 	vnodes_created = counter_u64_alloc(M_WAITOK);
 	recycles_count = counter_u64_alloc(M_WAITOK);
+	recycle_usec = counter_u64_alloc(M_WAITOK);
 	free_owe_inact = counter_u64_alloc(M_WAITOK);
 
 	/*
@@ -979,6 +995,8 @@ vnlru_free_locked(int count, struct vfsops *mnt_op)
 {
 	struct vnode *vp;
 	struct mount *mp;
+	sbintime_t t;
+	u_long usec;
 	bool tried_batches;
 
 	tried_batches = false;
@@ -1040,6 +1058,7 @@ vnlru_free_locked(int count, struct vfsops *mnt_op)
 
 		mtx_unlock(&vnode_free_list_mtx);
 		VI_UNLOCK(vp);
+		t = sbinuptime();
 		vtryrecycle(vp);
 		/*
 		 * If the recycled succeeded this vdrop will actually free
@@ -1047,6 +1066,10 @@ vnlru_free_locked(int count, struct vfsops *mnt_op)
 		 * the free list.
 		 */
 		vdrop(vp);
+		usec = sbttous(sbinuptime() - t);
+		counter_u64_add(recycle_usec, usec);
+		if (usec > recycle_usec_max)
+			recycle_usec_max = usec;	/* races are harmless */
 		mtx_lock(&vnode_free_list_mtx);
 	}
 }
@@ -1423,7 +1446,7 @@ getnewvnode(const char *tag, struct mount *mp, struct vop_vector *vops,
 	struct thread *td;
 	struct lock_object *lo;
 	static int cyclecount;
-	int error __unused;
+	int batch, error __unused;
 
 	CTR3(KTR_VFS, "%s: mp %p with tag %s", __func__, mp, tag);
 	vp = NULL;
@@ -1432,6 +1455,18 @@ getnewvnode(const char *tag, struct mount *mp, struct vop_vector *vops,
 		td->td_vp_reserv -= 1;
 		goto alloc;
 	}
+	/*
+	 * First try to be quick and racy, as in getnewvnode_reserve():
+	 * while the cache may grow without reclaiming, there is no need
+	 * to serialize on the free list lock just to account for the
+	 * new vnode, and vcheckspace() is safe to run unlocked.
+	 */
+	if (atomic_fetchadd_long(&numvnodes, 1) + 1 <= desiredvnodes) {
+		cyclecount = 0;
+		vcheckspace();
+		goto alloc;
+	}
+	atomic_subtract_long(&numvnodes, 1);
 	mtx_lock(&vnode_free_list_mtx);
 	if (numvnodes < desiredvnodes)
 		cyclecount = 0;
@@ -1442,8 +1477,10 @@ getnewvnode(const char *tag, struct mount *mp, struct vop_vector *vops,
 	/*
 	 * Grow the vnode cache if it will not be above its target max
 	 * after growing.  Otherwise, if the free list is nonempty, try
-	 * to reclaim 1 item from it before growing the cache (possibly
-	 * above its target max if the reclamation failed or is delayed).
+	 * to reclaim a small batch from it before growing the cache
+	 * (possibly above its target max if the reclamation failed or is
+	 * delayed).  Reclaiming a batch rather than a single vnode lets
+	 * the next few allocations take the unlocked path above.
 	 * Otherwise, wait for some space.  In all cases, schedule
 	 * vnlru_proc() if we are getting short of space.  The watermarks
 	 * should be chosen so that we never wait or even reclaim from
@@ -1451,9 +1488,13 @@ getnewvnode(const char *tag, struct mount *mp, struct vop_vector *vops,
 	 */
 	if (numvnodes + 1 <= desiredvnodes)
 		;
-	else if (freevnodes > 0)
-		vnlru_free_locked(1, NULL);
-	else {
+	else if (freevnodes > 0) {
+		batch = 1;
+		if (freevnodes > wantfreevnodes)
+			batch = ulmin(vnlru_free_batch,
+			    freevnodes - wantfreevnodes);
+		vnlru_free_locked(batch, NULL);
+	} else {
 		error = getnewvnode_wait(mp != NULL && (mp->mnt_kern_flag &
 		    MNTK_SUSPEND));
 #if 0	/* XXX Not all VFS_VGET/ffs_vget callers check returns. */
@@ -2881,6 +2922,19 @@ _vhold(struct vnode *vp, bool locked)
 		VI_UNLOCK(vp);
 }
 
+/*
+ * Return a destroyed vnode to its zone once concurrent lockless name
+ * cache lookups, which may still be dereferencing it, have drained.
+ */
+static void
+vnode_free_epoch(epoch_context_t ctx)
+{
+	struct vnode *vp;
+
+	vp = __containerof(ctx, struct vnode, v_epoch_ctx);
+	uma_zfree(vnode_zone, vp);
+}
+
 /*
  * Drop the hold count of the vnode.  If this is the last reference to
  * the vnode we place it on the free list unless it has been vgone'd
@@ -3017,7 +3071,12 @@ _vdrop(struct vnode *vp, bool locked)
 		free(vp->v_path, M_VNODE_PATH);
 		vp->v_path = NULL;
 	}
-	uma_zfree(vnode_zone, vp);
+	/*
+	 * Defer the actual free until lockless cache_lookup() callers
+	 * that may have found this vnode through a stale hash entry
+	 * are guaranteed to be done with it.
+	 */
+	epoch_call(vfs_cache_epoch, &vp->v_epoch_ctx, vnode_free_epoch);
 }
 
 /*
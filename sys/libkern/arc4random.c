@@ -30,14 +30,15 @@ __FBSDID("$FreeBSD$");
 
 #include <sys/types.h>
 #include <sys/param.h>
+#include <sys/systm.h>
 #include <sys/kernel.h>
 #include <sys/libkern.h>
 #include <sys/linker.h>
-#include <sys/lock.h>
 #include <sys/malloc.h>
-#include <sys/mutex.h>
 #include <sys/random.h>
+#include <sys/sbuf.h>
 #include <sys/smp.h>
+#include <sys/sysctl.h>
 #include <sys/time.h>
 
 #include <crypto/chacha20/chacha.h>
@@ -53,16 +54,25 @@ int arc4rand_iniseed_state = ARC4_ENTR_NONE;
 
 MALLOC_DEFINE(M_CHACHA20RANDOM, "chacha20random", "chacha20random structures");
 
+/*
+ * Each CPU owns one generator instance outright: all accesses to an
+ * instance happen on its CPU inside a critical section, including
+ * reseeding, so the fast path takes no lock and never bounces a shared
+ * cacheline.  A reseed demanded by another context (new entropy, or an
+ * explicit request from arc4rand()) only raises the per-instance
+ * request flag; the owning CPU honors it the next time it draws.
+ */
 struct chacha20_s {
-	struct mtx mtx;
+	volatile u_int reseed_request;
 	int numbytes;
-	int first_time_done;
 	time_t t_reseed;
+	uint64_t reseeds;
 	u_int8_t m_buffer[CHACHA20_BUFFER_SIZE];
 	struct chacha_ctx ctx;
 } __aligned(CACHE_LINE_SIZE);
 
 static struct chacha20_s *chacha20inst = NULL;
+static int chacha20_preload_done;
 
 #define CHACHA20_FOREACH(_chacha20) \
 	for (_chacha20 = &chacha20inst[0]; \
@@ -70,11 +80,15 @@ static struct chacha20_s *chacha20inst = NULL;
 	     _chacha20++)
 
 /*
- * Mix up the current context.
+ * Rekey the current CPU's context.  The key material is gathered with
+ * no locks held, since read_random() may take the entropy source's
+ * locks; only the final keying of the instance runs in the critical
+ * section, against whatever CPU we ended up on.
  */
 static void
-chacha20_randomstir(struct chacha20_s* chacha20)
+chacha20_randomstir(void)
 {
+	struct chacha20_s *chacha20;
 	struct timeval tv_now;
 	size_t n, size;
 	u_int8_t key[CHACHA20_KEYBYTES], *data;
@@ -88,7 +102,7 @@ chacha20_randomstir(struct chacha20_s* chacha20)
 	 * is an entropy stash at shutdown time.
 	 */
 	(void)read_random(key, CHACHA20_KEYBYTES);
-	if (!chacha20->first_time_done) {
+	if (!chacha20_preload_done) {
 		keyfile = preload_search_by_type(RANDOM_CACHED_BOOT_ENTROPY_MODULE);
 		if (keyfile != NULL) {
 			data = preload_fetch_addr(keyfile);
@@ -100,16 +114,20 @@ chacha20_randomstir(struct chacha20_s* chacha20)
 				printf("arc4random: read %zu bytes from preloaded cache\n", size);
 		} else
 			printf("arc4random: no preloaded entropy cache\n");
-		chacha20->first_time_done = 1;
+		chacha20_preload_done = 1;
 	}
 	getmicrouptime(&tv_now);
-	mtx_lock(&chacha20->mtx);
+	critical_enter();
+	chacha20 = &chacha20inst[curcpu];
 	chacha_keysetup(&chacha20->ctx, key, CHACHA20_KEYBYTES*8);
 	chacha_ivsetup(&chacha20->ctx, (u_char *)&tv_now.tv_sec, (u_char *)&tv_now.tv_usec);
 	/* Reset for next reseed cycle. */
 	chacha20->t_reseed = tv_now.tv_sec + CHACHA20_RESEED_SECONDS;
 	chacha20->numbytes = 0;
-	mtx_unlock(&chacha20->mtx);
+	chacha20->reseed_request = 0;
+	chacha20->reseeds++;
+	critical_exit();
+	explicit_bzero(key, sizeof(key));
 }
 
 /*
@@ -125,10 +143,8 @@ chacha20_init(void)
 	KASSERT(chacha20inst != NULL, ("chacha20_init: memory allocation error"));
 
 	CHACHA20_FOREACH(chacha20) {
-		mtx_init(&chacha20->mtx, "chacha20_mtx", NULL, MTX_DEF);
 		chacha20->t_reseed = -1;
 		chacha20->numbytes = 0;
-		chacha20->first_time_done = 0;
 		explicit_bzero(chacha20->m_buffer, CHACHA20_BUFFER_SIZE);
 		explicit_bzero(&chacha20->ctx, sizeof(chacha20->ctx));
 	}
@@ -139,14 +155,32 @@ SYSINIT(chacha20, SI_SUB_LOCK, SI_ORDER_ANY, chacha20_init, NULL);
 static void
 chacha20_uninit(void)
 {
-	struct chacha20_s *chacha20;
 
-	CHACHA20_FOREACH(chacha20)
-		mtx_destroy(&chacha20->mtx);
 	free(chacha20inst, M_CHACHA20RANDOM);
 }
 SYSUNINIT(chacha20, SI_SUB_LOCK, SI_ORDER_ANY, chacha20_uninit, NULL);
 
+static int
+chacha20_sysctl_reseeds(SYSCTL_HANDLER_ARGS)
+{
+	struct chacha20_s *chacha20;
+	struct sbuf sb;
+	int error;
+
+	if (chacha20inst == NULL)
+		return (ENXIO);
+	sbuf_new_for_sysctl(&sb, NULL, 128, req);
+	CHACHA20_FOREACH(chacha20)
+		sbuf_printf(&sb, "%ju ", (uintmax_t)chacha20->reseeds);
+	sbuf_trim(&sb);
+	error = sbuf_finish(&sb);
+	sbuf_delete(&sb);
+	return (error);
+}
+SYSCTL_PROC(_kern, OID_AUTO, arc4random_reseeds,
+    CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+    chacha20_sysctl_reseeds, "A",
+    "Reseeds of each CPU's arc4random generator instance");
 
 /*
  * MPSAFE
@@ -161,29 +195,32 @@ arc4rand(void *ptr, u_int len, int reseed)
 
 	if (reseed || atomic_cmpset_int(&arc4rand_iniseed_state, ARC4_ENTR_HAVE, ARC4_ENTR_SEED))
 		CHACHA20_FOREACH(chacha20)
-			chacha20_randomstir(chacha20);
+			atomic_store_rel_int(&chacha20->reseed_request, 1);
 
-	chacha20 = &chacha20inst[curcpu];
 	getmicrouptime(&tv);
-	/* We may get unlucky and be migrated off this CPU, but that is expected to be infrequent */
-	if ((chacha20->numbytes > CHACHA20_RESEED_BYTES) || (tv.tv_sec > chacha20->t_reseed))
-		chacha20_randomstir(chacha20);
-
-	mtx_lock(&chacha20->mtx);
 	p = ptr;
-	while (len) {
+	critical_enter();
+	while (len > 0) {
+		/*
+		 * Re-fetch the instance each round: reseeding drops the
+		 * critical section and we may come back on another CPU.
+		 */
+		chacha20 = &chacha20inst[curcpu];
+		if (__predict_false(chacha20->reseed_request != 0 ||
+		    chacha20->numbytes > CHACHA20_RESEED_BYTES ||
+		    tv.tv_sec > chacha20->t_reseed)) {
+			critical_exit();
+			chacha20_randomstir();
+			critical_enter();
+			continue;
+		}
 		length = MIN(CHACHA20_BUFFER_SIZE, len);
 		chacha_encrypt_bytes(&chacha20->ctx, chacha20->m_buffer, p, length);
 		p += length;
 		len -= length;
 		chacha20->numbytes += length;
-		if (chacha20->numbytes > CHACHA20_RESEED_BYTES) {
-			mtx_unlock(&chacha20->mtx);
-			chacha20_randomstir(chacha20);
-			mtx_lock(&chacha20->mtx);
-		}
 	}
-	mtx_unlock(&chacha20->mtx);
+	critical_exit();
 }
 
 uint32_t
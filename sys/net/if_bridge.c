@@ -83,6 +83,8 @@ __FBSDID("$FreeBSD$");
 #include "opt_inet6.h"
 
 #include <sys/param.h>
+#include <sys/ck.h>
+#include <sys/epoch.h>
 #include <sys/eventhandler.h>
 #include <sys/mbuf.h>
 #include <sys/malloc.h>
@@ -188,19 +190,21 @@ struct bridge_iflist {
 	uint32_t		bif_addrmax;	/* max # of addresses */
 	uint32_t		bif_addrcnt;	/* cur. # of addresses */
 	uint32_t		bif_addrexceeded;/* # of address violations */
+	struct epoch_context	bif_epoch_ctx;	/* for deferred free */
 };
 
 /*
  * Bridge route node.
  */
 struct bridge_rtnode {
-	LIST_ENTRY(bridge_rtnode) brt_hash;	/* hash table linkage */
-	LIST_ENTRY(bridge_rtnode) brt_list;	/* list linkage */
+	CK_LIST_ENTRY(bridge_rtnode) brt_hash;	/* hash table linkage */
+	CK_LIST_ENTRY(bridge_rtnode) brt_list;	/* list linkage */
 	struct bridge_iflist	*brt_dst;	/* destination if */
 	unsigned long		brt_expire;	/* expiration time */
 	uint8_t			brt_flags;	/* address flags */
 	uint8_t			brt_addr[ETHER_ADDR_LEN];
 	uint16_t		brt_vlan;	/* vlan id */
+	struct epoch_context	brt_epoch_ctx;	/* for deferred free */
 };
 #define	brt_ifp			brt_dst->bif_ifp
 
@@ -219,8 +223,8 @@ struct bridge_softc {
 	uint32_t		sc_iflist_ref;	/* refcount for sc_iflist */
 	uint32_t		sc_iflist_xcnt;	/* refcount for sc_iflist */
 	LIST_HEAD(, bridge_iflist) sc_iflist;	/* member interface list */
-	LIST_HEAD(, bridge_rtnode) *sc_rthash;	/* our forwarding table */
-	LIST_HEAD(, bridge_rtnode) sc_rtlist;	/* list version of above */
+	CK_LIST_HEAD(, bridge_rtnode) *sc_rthash; /* our forwarding table */
+	CK_LIST_HEAD(, bridge_rtnode) sc_rtlist; /* list version of above */
 	uint32_t		sc_rthash_key;	/* key for hash */
 	LIST_HEAD(, bridge_iflist) sc_spanlist;	/* span ports list */
 	struct bstp_state	sc_stp;		/* STP state */
@@ -990,8 +994,20 @@ bridge_lookup_member_if(struct bridge_softc *sc, struct ifnet *member_ifp)
 /*
  * bridge_delete_member:
  *
- *	Delete the specified member interface.
+ *	Delete the specified member interface.  The free of the bif itself
+ *	is deferred until the current network epoch drains: lockless readers
+ *	in the transmit path reach the member ifnet through brt_dst, so the
+ *	bif must outlive any epoch section that found its rtnode.
  */
+static void
+bridge_delete_member_cb(epoch_context_t ctx)
+{
+	struct bridge_iflist *bif;
+
+	bif = __containerof(ctx, struct bridge_iflist, bif_epoch_ctx);
+	free(bif, M_DEVBUF);
+}
+
 static void
 bridge_delete_member(struct bridge_softc *sc, struct bridge_iflist *bif,
     int gone)
@@ -1065,7 +1081,8 @@ bridge_delete_member(struct bridge_softc *sc, struct bridge_iflist *bif,
 	}
 	bstp_destroy(&bif->bif_stp);	/* prepare to free */
 	BRIDGE_LOCK(sc);
-	free(bif, M_DEVBUF);
+	epoch_call(net_epoch_preempt, &bif->bif_epoch_ctx,
+	    bridge_delete_member_cb);
 }
 
 /*
@@ -1418,7 +1435,7 @@ bridge_ioctl_rts(struct bridge_softc *sc, void *arg)
 		return (0);
 
 	count = 0;
-	LIST_FOREACH(brt, &sc->sc_rtlist, brt_list)
+	CK_LIST_FOREACH(brt, &sc->sc_rtlist, brt_list)
 		count++;
 	buflen = sizeof(bareq) * count;
 
@@ -1430,7 +1447,7 @@ bridge_ioctl_rts(struct bridge_softc *sc, void *arg)
 	buf = outbuf;
 	len = min(bac->ifbac_len, buflen);
 	bzero(&bareq, sizeof(bareq));
-	LIST_FOREACH(brt, &sc->sc_rtlist, brt_list) {
+	CK_LIST_FOREACH(brt, &sc->sc_rtlist, brt_list) {
 		if (len < sizeof(bareq))
 			goto out;
 		strlcpy(bareq.ifba_ifsname, brt->brt_ifp->if_xname,
@@ -2120,13 +2137,23 @@ bridge_transmit(struct ifnet *ifp, struct mbuf *m)
 
 	eh = mtod(m, struct ether_header *);
 
-	BRIDGE_LOCK(sc);
-	if (((m->m_flags & (M_BCAST|M_MCAST)) == 0) &&
-	    (dst_if = bridge_rtlookup(sc, eh->ether_dhost, 1)) != NULL) {
-		BRIDGE_UNLOCK(sc);
+	/*
+	 * The address table is safe to search without the bridge lock
+	 * inside the network epoch, so the common unicast case does not
+	 * contend with the forwarding path.
+	 */
+	dst_if = NULL;
+	if ((m->m_flags & (M_BCAST|M_MCAST)) == 0) {
+		NET_EPOCH_ENTER();
+		dst_if = bridge_rtlookup(sc, eh->ether_dhost, 1);
+		NET_EPOCH_EXIT();
+	}
+	if (dst_if != NULL)
 		error = bridge_enqueue(sc, dst_if, m);
-	} else
+	else {
+		BRIDGE_LOCK(sc);
 		bridge_broadcast(sc, ifp, m, 0);
+	}
 
 	return (error);
 }
@@ -2696,7 +2723,13 @@ bridge_rtupdate(struct bridge_softc *sc, const uint8_t *dst, uint16_t vlan,
 		brt->brt_dst->bif_addrcnt++;
 	}
 
-	if ((flags & IFBAF_TYPEMASK) == IFBAF_DYNAMIC)
+	/*
+	 * Only rewrite the expiry time when it actually moves; with
+	 * time_uptime's one second granularity this keeps a bulk flow
+	 * from dirtying the entry's cache line on every frame.
+	 */
+	if ((flags & IFBAF_TYPEMASK) == IFBAF_DYNAMIC &&
+	    brt->brt_expire != time_uptime + sc->sc_brttimeout)
 		brt->brt_expire = time_uptime + sc->sc_brttimeout;
 	if (setflags)
 		brt->brt_flags = flags;
@@ -2707,15 +2740,16 @@ bridge_rtupdate(struct bridge_softc *sc, const uint8_t *dst, uint16_t vlan,
 /*
  * bridge_rtlookup:
  *
- *	Lookup the destination interface for an address.
+ *	Lookup the destination interface for an address.  Callers must
+ *	either hold the bridge lock or be running within the network
+ *	epoch; in the latter case the returned interface is only
+ *	guaranteed to remain valid for the duration of the epoch section.
  */
 static struct ifnet *
 bridge_rtlookup(struct bridge_softc *sc, const uint8_t *addr, uint16_t vlan)
 {
 	struct bridge_rtnode *brt;
 
-	BRIDGE_LOCK_ASSERT(sc);
-
 	if ((brt = bridge_rtnode_lookup(sc, addr, vlan)) == NULL)
 		return (NULL);
 
@@ -2745,7 +2779,7 @@ bridge_rttrim(struct bridge_softc *sc)
 	if (sc->sc_brtcnt <= sc->sc_brtmax)
 		return;
 
-	LIST_FOREACH_SAFE(brt, &sc->sc_rtlist, brt_list, nbrt) {
+	CK_LIST_FOREACH_SAFE(brt, &sc->sc_rtlist, brt_list, nbrt) {
 		if ((brt->brt_flags & IFBAF_TYPEMASK) == IFBAF_DYNAMIC) {
 			bridge_rtnode_destroy(sc, brt);
 			if (sc->sc_brtcnt <= sc->sc_brtmax)
@@ -2785,7 +2819,7 @@ bridge_rtage(struct bridge_softc *sc)
 
 	BRIDGE_LOCK_ASSERT(sc);
 
-	LIST_FOREACH_SAFE(brt, &sc->sc_rtlist, brt_list, nbrt) {
+	CK_LIST_FOREACH_SAFE(brt, &sc->sc_rtlist, brt_list, nbrt) {
 		if ((brt->brt_flags & IFBAF_TYPEMASK) == IFBAF_DYNAMIC) {
 			if (time_uptime >= brt->brt_expire)
 				bridge_rtnode_destroy(sc, brt);
@@ -2805,7 +2839,7 @@ bridge_rtflush(struct bridge_softc *sc, int full)
 
 	BRIDGE_LOCK_ASSERT(sc);
 
-	LIST_FOREACH_SAFE(brt, &sc->sc_rtlist, brt_list, nbrt) {
+	CK_LIST_FOREACH_SAFE(brt, &sc->sc_rtlist, brt_list, nbrt) {
 		if (full || (brt->brt_flags & IFBAF_TYPEMASK) == IFBAF_DYNAMIC)
 			bridge_rtnode_destroy(sc, brt);
 	}
@@ -2848,7 +2882,7 @@ bridge_rtdelete(struct bridge_softc *sc, struct ifnet *ifp, int full)
 
 	BRIDGE_LOCK_ASSERT(sc);
 
-	LIST_FOREACH_SAFE(brt, &sc->sc_rtlist, brt_list, nbrt) {
+	CK_LIST_FOREACH_SAFE(brt, &sc->sc_rtlist, brt_list, nbrt) {
 		if (brt->brt_ifp == ifp && (full ||
 			    (brt->brt_flags & IFBAF_TYPEMASK) == IFBAF_DYNAMIC))
 			bridge_rtnode_destroy(sc, brt);
@@ -2869,10 +2903,10 @@ bridge_rtable_init(struct bridge_softc *sc)
 	    M_DEVBUF, M_WAITOK);
 
 	for (i = 0; i < BRIDGE_RTHASH_SIZE; i++)
-		LIST_INIT(&sc->sc_rthash[i]);
+		CK_LIST_INIT(&sc->sc_rthash[i]);
 
 	sc->sc_rthash_key = arc4random();
-	LIST_INIT(&sc->sc_rtlist);
+	CK_LIST_INIT(&sc->sc_rtlist);
 }
 
 /*
@@ -2950,10 +2984,10 @@ bridge_rtnode_lookup(struct bridge_softc *sc, const uint8_t *addr, uint16_t vlan
 	uint32_t hash;
 	int dir;
 
-	BRIDGE_LOCK_ASSERT(sc);
+	MPASS(in_epoch(net_epoch_preempt) || mtx_owned(&sc->sc_mtx));
 
 	hash = bridge_rthash(sc, addr);
-	LIST_FOREACH(brt, &sc->sc_rthash[hash], brt_hash) {
+	CK_LIST_FOREACH(brt, &sc->sc_rthash[hash], brt_hash) {
 		dir = bridge_rtnode_addr_cmp(addr, brt->brt_addr);
 		if (dir == 0 && (brt->brt_vlan == vlan || vlan == 0))
 			return (brt);
@@ -2981,9 +3015,9 @@ bridge_rtnode_insert(struct bridge_softc *sc, struct bridge_rtnode *brt)
 
 	hash = bridge_rthash(sc, brt->brt_addr);
 
-	lbrt = LIST_FIRST(&sc->sc_rthash[hash]);
+	lbrt = CK_LIST_FIRST(&sc->sc_rthash[hash]);
 	if (lbrt == NULL) {
-		LIST_INSERT_HEAD(&sc->sc_rthash[hash], brt, brt_hash);
+		CK_LIST_INSERT_HEAD(&sc->sc_rthash[hash], brt, brt_hash);
 		goto out;
 	}
 
@@ -2992,14 +3026,14 @@ bridge_rtnode_insert(struct bridge_softc *sc, struct bridge_rtnode *brt)
 		if (dir == 0 && brt->brt_vlan == lbrt->brt_vlan)
 			return (EEXIST);
 		if (dir > 0) {
-			LIST_INSERT_BEFORE(lbrt, brt, brt_hash);
+			CK_LIST_INSERT_BEFORE(lbrt, brt, brt_hash);
 			goto out;
 		}
-		if (LIST_NEXT(lbrt, brt_hash) == NULL) {
-			LIST_INSERT_AFTER(lbrt, brt, brt_hash);
+		if (CK_LIST_NEXT(lbrt, brt_hash) == NULL) {
+			CK_LIST_INSERT_AFTER(lbrt, brt, brt_hash);
 			goto out;
 		}
-		lbrt = LIST_NEXT(lbrt, brt_hash);
+		lbrt = CK_LIST_NEXT(lbrt, brt_hash);
 	} while (lbrt != NULL);
 
 #ifdef DIAGNOSTIC
@@ -3007,7 +3041,7 @@ bridge_rtnode_insert(struct bridge_softc *sc, struct bridge_rtnode *brt)
 #endif
 
 out:
-	LIST_INSERT_HEAD(&sc->sc_rtlist, brt, brt_list);
+	CK_LIST_INSERT_HEAD(&sc->sc_rtlist, brt, brt_list);
 	sc->sc_brtcnt++;
 
 	return (0);
@@ -3016,19 +3050,31 @@ out:
 /*
  * bridge_rtnode_destroy:
  *
- *	Destroy a bridge rtnode.
+ *	Destroy a bridge rtnode.  The free is deferred until the current
+ *	network epoch drains so that lockless readers traversing the hash
+ *	chains never see freed memory.
  */
+static void
+bridge_rtnode_destroy_cb(epoch_context_t ctx)
+{
+	struct bridge_rtnode *brt;
+
+	brt = __containerof(ctx, struct bridge_rtnode, brt_epoch_ctx);
+	uma_zfree(bridge_rtnode_zone, brt);
+}
+
 static void
 bridge_rtnode_destroy(struct bridge_softc *sc, struct bridge_rtnode *brt)
 {
 	BRIDGE_LOCK_ASSERT(sc);
 
-	LIST_REMOVE(brt, brt_hash);
+	CK_LIST_REMOVE(brt, brt_hash);
 
-	LIST_REMOVE(brt, brt_list);
+	CK_LIST_REMOVE(brt, brt_list);
 	sc->sc_brtcnt--;
 	brt->brt_dst->bif_addrcnt--;
-	uma_zfree(bridge_rtnode_zone, brt);
+	epoch_call(net_epoch_preempt, &brt->brt_epoch_ctx,
+	    bridge_rtnode_destroy_cb);
 }
 
 /*
@@ -3051,7 +3097,7 @@ bridge_rtable_expire(struct ifnet *ifp, int age)
 	if (age == 0)
 		bridge_rtdelete(sc, ifp, IFBF_FLUSHDYN);
 	else {
-		LIST_FOREACH(brt, &sc->sc_rtlist, brt_list) {
+		CK_LIST_FOREACH(brt, &sc->sc_rtlist, brt_list) {
 			/* Cap the expiry time to 'age' */
 			if (brt->brt_ifp == ifp &&
 			    brt->brt_expire > time_uptime + age &&
@@ -77,6 +77,7 @@ __FBSDID("$FreeBSD$");
 #include <netinet6/ip6_var.h>
 
 #include <machine/bus.h>
+#include <machine/cpu.h>
 #include <machine/in_cksum.h>
 
 #include <vm/vm.h>
@@ -336,6 +337,8 @@ struct iflib_txq {
 	uint64_t	ift_map_failed;
 	uint64_t	ift_txd_encap_efbig;
 	uint64_t	ift_pullups;
+	uint64_t	ift_doorbells;
+	uint64_t	ift_db_descs;
 	uint64_t	ift_last_timer_tick;
 
 	struct mtx	ift_mtx;
@@ -437,9 +440,11 @@ struct iflib_rxq {
 	uint64_t	ifr_rx_irq;
 	uint16_t	ifr_id;
 	uint8_t		ifr_lro_enabled;
+	uint8_t		ifr_busy_poll;
 	uint8_t		ifr_nfl;
 	uint8_t		ifr_ntxqirq;
 	uint8_t		ifr_txqid[IFLIB_MAX_TX_SHARED_INTR];
+	uint32_t	ifr_poll_empty;
 	struct lro_ctrl			ifr_lc;
 	struct grouptask        ifr_task;
 	struct iflib_filter_info ifr_filter_info;
@@ -2344,6 +2349,7 @@ iflib_stop(if_ctx_t ctx)
 		txq->ift_closed = txq->ift_mbuf_defrag = txq->ift_mbuf_defrag_failed = 0;
 		txq->ift_no_tx_dma_setup = txq->ift_txd_encap_efbig = txq->ift_map_failed = 0;
 		txq->ift_pullups = 0;
+		txq->ift_doorbells = txq->ift_db_descs = 0;
 		ifmp_ring_reset_stats(txq->ift_br);
 		for (j = 0, di = txq->ift_ifdi; j < sctx->isc_ntxqs; j++, di++)
 			bzero((void *)di->idi_vaddr, di->idi_size);
@@ -2741,7 +2747,8 @@ err:
 	return (false);
 }
 
-#define TXD_NOTIFY_COUNT(txq) (((txq)->ift_size / (txq)->ift_update_freq)-1)
+/* ift_update_freq is settable from userspace - guard against zero */
+#define TXD_NOTIFY_COUNT(txq) (((txq)->ift_size / MAX((txq)->ift_update_freq, 1))-1)
 static inline qidx_t
 txq_max_db_deferred(iflib_txq_t txq, qidx_t in_use)
 {
@@ -2800,6 +2807,8 @@ iflib_txd_db_check(if_ctx_t ctx, iflib_txq_t txq, int ring, qidx_t in_use)
 	if (ring || txq->ift_db_pending >= max) {
 		dbval = txq->ift_npending ? txq->ift_npending : txq->ift_pidx;
 		ctx->isc_txd_flush(ctx->ifc_softc, txq->ift_id, dbval);
+		txq->ift_doorbells++;
+		txq->ift_db_descs += txq->ift_db_pending;
 		txq->ift_db_pending = txq->ift_npending = 0;
 		rang = true;
 	}
@@ -3621,6 +3630,29 @@ _task_fn_rx(void *context)
 	if (budget == 0)
 		budget = 16;	/* XXX */
 	if (more == false || (more = iflib_rxeof(rxq, budget)) == false) {
+		if (rxq->ifr_busy_poll) {
+			uint32_t spins;
+
+			/*
+			 * Busy-poll mode: leave the queue interrupt
+			 * masked and keep the grouptask running on its
+			 * bound CPU, spinning progressively longer
+			 * (up to ~1k pause cycles) while the ring stays
+			 * empty.  Re-enqueueing rather than looping
+			 * here lets other work bound to the same
+			 * taskqueue thread interleave.
+			 */
+			if (__predict_false(!(if_getdrvflags(ctx->ifc_ifp) &
+			    IFF_DRV_RUNNING)))
+				return;
+			if (rxq->ifr_poll_empty < 10)
+				rxq->ifr_poll_empty++;
+			for (spins = 1 << rxq->ifr_poll_empty; spins > 0;
+			    spins--)
+				cpu_spinwait();
+			GROUPTASK_ENQUEUE(&rxq->ifr_task);
+			return;
+		}
 		if (ctx->ifc_flags & IFC_LEGACY)
 			IFDI_INTR_ENABLE(ctx);
 		else {
@@ -3631,7 +3663,8 @@ _task_fn_rx(void *context)
 			KASSERT(rc != ENOTSUP, ("MSI-X support requires queue_intr_enable, but not implemented in driver"));
 			DBG_COUNTER_INC(rx_intr_enables);
 		}
-	}
+	} else
+		rxq->ifr_poll_empty = 0;
 	if (__predict_false(!(if_getdrvflags(ctx->ifc_ifp) & IFF_DRV_RUNNING)))
 		return;
 	if (more)
@@ -6200,6 +6233,17 @@ iflib_add_device_sysctl_post(if_ctx_t ctx)
 		SYSCTL_ADD_QUAD(ctx_list, queue_list, OID_AUTO, "txq_cleaned",
 				   CTLFLAG_RD,
 				   &txq->ift_cleaned, "total cleaned");
+		SYSCTL_ADD_QUAD(ctx_list, queue_list, OID_AUTO, "txq_doorbells",
+				   CTLFLAG_RD,
+				   &txq->ift_doorbells, "# of doorbell writes");
+		SYSCTL_ADD_QUAD(ctx_list, queue_list, OID_AUTO, "txq_doorbell_descs",
+				   CTLFLAG_RD,
+				   &txq->ift_db_descs,
+				   "descriptors posted over all doorbell writes");
+		SYSCTL_ADD_U8(ctx_list, queue_list, OID_AUTO, "txq_update_freq",
+				   CTLFLAG_RW,
+				   &txq->ift_update_freq, 0,
+				   "divisor of queue size bounding deferred doorbells");
 		SYSCTL_ADD_PROC(ctx_list, queue_list, OID_AUTO, "ring_state",
 				CTLTYPE_STRING | CTLFLAG_RD, __DEVOLATILE(uint64_t *, &txq->ift_br->state),
 				0, mp_ring_state_handler, "A", "soft ring state");
@@ -6234,6 +6278,10 @@ iflib_add_device_sysctl_post(if_ctx_t ctx)
 		queue_node = SYSCTL_ADD_NODE(ctx_list, child, OID_AUTO, namebuf,
 					     CTLFLAG_RD, NULL, "Queue Name");
 		queue_list = SYSCTL_CHILDREN(queue_node);
+		SYSCTL_ADD_U8(ctx_list, queue_list, OID_AUTO, "busy_poll",
+			       CTLFLAG_RW,
+			       &rxq->ifr_busy_poll, 0,
+			       "busy-poll this queue with the interrupt masked");
 		if (sctx->isc_flags & IFLIB_HAS_RXCQ) {
 			SYSCTL_ADD_U16(ctx_list, queue_list, OID_AUTO, "rxq_cq_pidx",
 				       CTLFLAG_RD,
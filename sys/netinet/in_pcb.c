@@ -58,6 +58,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/domain.h>
 #include <sys/protosw.h>
 #include <sys/rmlock.h>
+#include <sys/sbuf.h>
 #include <sys/smp.h>
 #include <sys/socket.h>
 #include <sys/socketvar.h>
@@ -139,8 +140,10 @@ VNET_DEFINE(int, ipport_randomtime) = 45;	/* user controlled via sysctl */
 VNET_DEFINE(int, ipport_stoprandom);		/* toggled by ipport_tick */
 VNET_DEFINE(int, ipport_tcpallocs);
 VNET_DEFINE_STATIC(int, ipport_tcplastcount);
+VNET_DEFINE_STATIC(int, ipport_shards) = 1;	/* user controlled via sysctl */
 
 #define	V_ipport_tcplastcount		VNET(ipport_tcplastcount)
+#define	V_ipport_shards			VNET(ipport_shards)
 
 static void	in_pcbremlists(struct inpcb *inp);
 #ifdef INET
@@ -210,6 +213,33 @@ SYSCTL_INT(_net_inet_ip_portrange, OID_AUTO, randomtime,
 	&VNET_NAME(ipport_randomtime), 0,
 	"Minimum time to keep sequental port "
 	"allocation before switching to a random one");
+
+static int
+sysctl_net_ipport_shardstats(SYSCTL_HANDLER_ARGS)
+{
+	struct inpcbinfo *pcbinfo;
+	struct sbuf sb;
+	u_int i;
+	int error;
+
+	pcbinfo = &V_tcbinfo;
+	sbuf_new_for_sysctl(&sb, NULL, 128, req);
+	for (i = 0; i <= mp_maxid; i++)
+		sbuf_printf(&sb, "%u:%lu/%lu ", i,
+		    pcbinfo->ipi_shardallocs[i], pcbinfo->ipi_shardsteals[i]);
+	sbuf_trim(&sb);
+	error = sbuf_finish(&sb);
+	sbuf_delete(&sb);
+	return (error);
+}
+SYSCTL_INT(_net_inet_ip_portrange, OID_AUTO, shards,
+	CTLFLAG_VNET | CTLFLAG_RW,
+	&VNET_NAME(ipport_shards), 0,
+	"Shard sequential port allocation across CPUs");
+SYSCTL_PROC(_net_inet_ip_portrange, OID_AUTO, shardstats,
+	CTLFLAG_VNET | CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+	sysctl_net_ipport_shardstats, "A",
+	"TCP port allocations/steals of each CPU's shard");
 #endif /* INET */
 
 /*
@@ -453,6 +483,12 @@ in_pcbinfo_init(struct inpcbinfo *pcbinfo, const char *name,
 	    &pcbinfo->ipi_porthashmask);
 	pcbinfo->ipi_lbgrouphashbase = hashinit(porthash_nelements, M_PCB,
 	    &pcbinfo->ipi_lbgrouphashmask);
+	pcbinfo->ipi_shardlast = mallocarray(mp_maxid + 1,
+	    sizeof(*pcbinfo->ipi_shardlast), M_PCB, M_WAITOK | M_ZERO);
+	pcbinfo->ipi_shardallocs = mallocarray(mp_maxid + 1,
+	    sizeof(*pcbinfo->ipi_shardallocs), M_PCB, M_WAITOK | M_ZERO);
+	pcbinfo->ipi_shardsteals = mallocarray(mp_maxid + 1,
+	    sizeof(*pcbinfo->ipi_shardsteals), M_PCB, M_WAITOK | M_ZERO);
 #ifdef PCBGROUP
 	in_pcbgroup_init(pcbinfo, hashfields, hash_nelements);
 #endif
@@ -478,6 +514,9 @@ in_pcbinfo_destroy(struct inpcbinfo *pcbinfo)
 	    pcbinfo->ipi_porthashmask);
 	hashdestroy(pcbinfo->ipi_lbgrouphashbase, M_PCB,
 	    pcbinfo->ipi_lbgrouphashmask);
+	free(pcbinfo->ipi_shardlast, M_PCB);
+	free(pcbinfo->ipi_shardallocs, M_PCB);
+	free(pcbinfo->ipi_shardsteals, M_PCB);
 #ifdef PCBGROUP
 	in_pcbgroup_destroy(pcbinfo);
 #endif
@@ -602,8 +641,8 @@ in_pcb_lport(struct inpcb *inp, struct in_addr *laddrp, u_short *lportp,
 	struct inpcbinfo *pcbinfo;
 	struct inpcb *tmpinp;
 	unsigned short *lastport;
-	int count, dorandom, error;
-	u_short aux, first, last, lport;
+	int count, dorandom, error, shard;
+	u_short aux, ffirst, first, flast, last, lport, shardsize;
 #ifdef INET
 	struct in_addr laddr;
 #endif
@@ -680,11 +719,44 @@ in_pcb_lport(struct inpcb *inp, struct in_addr *laddrp, u_short *lportp,
 	if (dorandom)
 		*lastport = first + (arc4random() % (last - first));
 
+	/*
+	 * Once ipport_tick() has suppressed randomization, concurrent
+	 * connects all chase the single ipi_lastport cursor and every
+	 * prober rescans the ports the others just took.  Give each CPU
+	 * its own slice of the default range instead, so simultaneous
+	 * allocations probe disjoint ports; a CPU whose slice fills up
+	 * falls back to scanning the whole range ("stealing").  The CPU
+	 * may change under us, but the slice is only a starting point
+	 * and the lookup below validates every candidate port.
+	 */
+	ffirst = first;
+	flast = last;
+	shard = -1;
+	if (V_ipport_shards && !dorandom &&
+	    lastport == &pcbinfo->ipi_lastport &&
+	    (shardsize = (last - first + 1) / (mp_maxid + 1)) >= 32) {
+		shard = curcpu;
+		first = ffirst + shard * shardsize;
+		last = (shard == mp_maxid) ? flast : first + shardsize - 1;
+		lastport = &pcbinfo->ipi_shardlast[shard];
+	}
+
 	count = last - first;
 
 	do {
-		if (count-- < 0)	/* completely used? */
+		if (count-- < 0) {	/* completely used? */
+			if (shard >= 0) {
+				/* Shard exhausted; steal from the others. */
+				pcbinfo->ipi_shardsteals[shard]++;
+				shard = -1;
+				first = ffirst;
+				last = flast;
+				lastport = &pcbinfo->ipi_lastport;
+				count = last - first;
+				continue;
+			}
 			return (EADDRNOTAVAIL);
+		}
 		++*lastport;
 		if (*lastport < first || *lastport > last)
 			*lastport = first;
@@ -704,6 +776,9 @@ in_pcb_lport(struct inpcb *inp, struct in_addr *laddrp, u_short *lportp,
 #endif
 	} while (tmpinp != NULL);
 
+	if (shard >= 0)
+		pcbinfo->ipi_shardallocs[shard]++;
+
 #ifdef INET
 	if ((inp->inp_vflag & (INP_IPV4|INP_IPV6)) == INP_IPV4)
 		laddrp->s_addr = laddr.s_addr;
@@ -2351,9 +2426,15 @@ in_pcblookup_hash_locked(struct inpcbinfo *pcbinfo, struct in_addr faddr,
 }
 
 /*
- * Lookup PCB in hash list, using pcbinfo tables.  This variation locks the
- * hash list lock, and will return the inpcb locked (i.e., requires
- * INPLOOKUP_LOCKPCB).
+ * Lookup PCB in hash list, using pcbinfo tables, and return the inpcb
+ * locked (i.e., requires INPLOOKUP_LOCKPCB).  The hash chains are
+ * modified only with both the hash lock and the inpcb lock held, and
+ * freed pcbs are reclaimed through the network epoch, so a caller that
+ * is already inside an epoch section (the inbound packet path) can
+ * traverse them without touching the contended hash lock; the INP_FREED
+ * recheck after acquiring the inpcb lock catches a pcb torn down while
+ * we walked the chain.  Callers from outside an epoch section (pfil
+ * hooks on the output path, TOE drivers) still take the read lock.
  */
 static struct inpcb *
 in_pcblookup_hash(struct inpcbinfo *pcbinfo, struct in_addr faddr,
@@ -2361,8 +2442,11 @@ in_pcblookup_hash(struct inpcbinfo *pcbinfo, struct in_addr faddr,
     struct ifnet *ifp)
 {
 	struct inpcb *inp;
+	bool locked;
 
-	INP_HASH_RLOCK(pcbinfo);
+	locked = !in_epoch(net_epoch_preempt);
+	if (locked)
+		INP_HASH_RLOCK(pcbinfo);
 	inp = in_pcblookup_hash_locked(pcbinfo, faddr, fport, laddr, lport,
 	    (lookupflags & ~(INPLOOKUP_RLOCKPCB | INPLOOKUP_WLOCKPCB)), ifp);
 	if (inp != NULL) {
@@ -2389,7 +2473,8 @@ in_pcblookup_hash(struct inpcbinfo *pcbinfo, struct in_addr faddr,
 		}
 #endif
 	}
-	INP_HASH_RUNLOCK(pcbinfo);
+	if (locked)
+		INP_HASH_RUNLOCK(pcbinfo);
 	return (inp);
 }
 
@@ -471,6 +471,14 @@ struct inpcbinfo {
 	u_short			 ipi_lastlow;		/* (x) */
 	u_short			 ipi_lasthi;		/* (x) */
 
+	/*
+	 * Per-CPU shards of the default ephemeral port range, each with its
+	 * own cursor and allocation/steal counts; see in_pcb_lport().
+	 */
+	u_short			*ipi_shardlast;		/* (x) */
+	u_long			*ipi_shardallocs;	/* (x) */
+	u_long			*ipi_shardsteals;	/* (x) */
+
 	/*
 	 * UMA zone from which inpcbs are allocated for this protocol.
 	 */
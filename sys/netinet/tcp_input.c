@@ -562,8 +562,18 @@ tcp6_input(struct mbuf **mp, int *offp, int proto)
 }
 #endif /* INET6 */
 
-int
-tcp_input(struct mbuf **mp, int *offp, int proto)
+/*
+ * Common TCP input path.  If inp_hintp is not NULL it points at the inpcb
+ * delivered to by the previous segment of a batch; when the hint still
+ * matches this segment's flow it is reused in place of the hash lookup,
+ * and on a successful full lookup the hint is updated for the next
+ * segment.  Callers passing a hint must remain in a single network epoch
+ * section for the life of the batch so that the hinted inpcb memory
+ * remains type-stable between segments.
+ */
+static int
+tcp_input_common(struct mbuf **mp, int *offp, int proto,
+    struct inpcb **inp_hintp)
 {
 	struct mbuf *m = *mp;
 	struct tcphdr *th = NULL;
@@ -803,6 +813,45 @@ findpcb:
 		INP_INFO_WUNLOCK_ASSERT(&V_tcbinfo);
 	}
 #endif
+	/*
+	 * In a batch, try the inpcb the previous segment was delivered to
+	 * before paying for a hash lookup.  The hint may have been dropped,
+	 * or even freed and reused for another connection, since we stored
+	 * it; locking it and rechecking the flags and the full 4-tuple
+	 * detects both, in which case we fall back to the normal lookup.
+	 */
+	if (inp_hintp != NULL && *inp_hintp != NULL && fwd_tag == NULL) {
+		bool match;
+
+		inp = *inp_hintp;
+		INP_WLOCK(inp);
+		match = (inp->inp_flags & (INP_TIMEWAIT | INP_DROPPED)) == 0 &&
+		    inp->inp_fport == th->th_sport &&
+		    inp->inp_lport == th->th_dport;
+#ifdef INET6
+		if (match && isipv6)
+			match = (inp->inp_vflag & INP_IPV6) != 0 &&
+			    IN6_ARE_ADDR_EQUAL(&inp->in6p_faddr,
+			    &ip6->ip6_src) &&
+			    IN6_ARE_ADDR_EQUAL(&inp->in6p_laddr,
+			    &ip6->ip6_dst);
+#endif
+#ifdef INET
+#ifdef INET6
+		if (match && !isipv6)
+#else
+		if (match)
+#endif
+			match = (inp->inp_vflag & INP_IPV4) != 0 &&
+			    inp->inp_faddr.s_addr == ip->ip_src.s_addr &&
+			    inp->inp_laddr.s_addr == ip->ip_dst.s_addr;
+#endif
+		if (match)
+			goto foundpcb;
+		INP_WUNLOCK(inp);
+		inp = NULL;
+		*inp_hintp = NULL;
+	}
 #ifdef INET6
 	if (isipv6 && fwd_tag != NULL) {
 		struct sockaddr_in6 *next_hop6;
@@ -868,6 +917,7 @@ findpcb:
 		    m->m_pkthdr.rcvif, m);
 #endif /* INET */
 
+foundpcb:
 	/*
 	 * If the INPCB does not exist then all data in the incoming
 	 * segment is discarded and an appropriate RST is sent back.
@@ -906,6 +956,15 @@ findpcb:
 		inp = NULL;
 		goto findpcb;
 	}
+	/*
+	 * Remember where this segment was delivered so that the remainder
+	 * of a batch can skip the lookup.  Time-wait pcbs are not worth
+	 * hinting; they may be recycled underneath us before the next
+	 * segment and would fail revalidation anyway.
+	 */
+	if (inp_hintp != NULL && fwd_tag == NULL &&
+	    (inp->inp_flags & INP_TIMEWAIT) == 0)
+		*inp_hintp = inp;
 	if ((inp->inp_flowtype == M_HASHTYPE_NONE) &&
 	    (M_HASHTYPE_GET(m) != M_HASHTYPE_NONE) &&
 	    ((inp->inp_socket == NULL) ||
@@ -1445,6 +1504,46 @@ drop:
 	return (IPPROTO_DONE);
 }
 
+int
+tcp_input(struct mbuf **mp, int *offp, int proto)
+{
+
+	return (tcp_input_common(mp, offp, proto, NULL));
+}
+
+/*
+ * Input a train of segments linked through m_nextpkt, all belonging to
+ * the same flow and carrying the same IP header length, as produced by
+ * LRO when it cannot merge segments (e.g. due to timestamps or push
+ * bits).  The inpcb found for one segment is passed as a hint to the
+ * next, so a train of N segments costs one pcb hash lookup instead of
+ * N in the common case.  The caller must hold a network epoch section
+ * across the call; the hint protocol relies on it to keep the hinted
+ * inpcb's memory type-stable between segments.
+ */
+int
+tcp_input_batch(struct mbuf **mp, int *offp, int proto)
+{
+	struct inpcb *inp_hint;
+	struct mbuf *m, *nextpkt;
+	int off, ret;
+
+	MPASS(in_epoch(net_epoch_preempt));
+
+	m = *mp;
+	*mp = NULL;
+	inp_hint = NULL;
+	ret = IPPROTO_DONE;
+	while (m != NULL) {
+		nextpkt = m->m_nextpkt;
+		m->m_nextpkt = NULL;
+		off = *offp;
+		ret = tcp_input_common(&m, &off, proto, &inp_hint);
+		m = nextpkt;
+	}
+	return (ret);
+}
+
 /*
  * Automatic sizing of receive socket buffer.  Often the send
  * buffer size is not optimally adjusted to the actual network
@@ -3485,6 +3584,8 @@ tcp_xmit_timer(struct tcpcb *tp, int rtt)
 	 * and the return path might not be symmetrical).
 	 */
 	tp->t_softerror = 0;
+
+	tcp_conn_stats_update(tp);
 }
 
 /*
@@ -81,6 +81,9 @@ __FBSDID("$FreeBSD$");
 #include <netinet/tcpip.h>
 #include <netinet/cc/cc.h>
 #include <netinet/tcp_fastopen.h>
+#ifdef TCPHPTS
+#include <netinet/tcp_hpts.h>
+#endif
 #ifdef TCPPCAP
 #include <netinet/tcp_pcap.h>
 #endif
@@ -133,6 +136,14 @@ SYSCTL_INT(_net_inet_tcp, OID_AUTO, sendbuf_auto_lowat, CTLFLAG_VNET | CTLFLAG_R
 	&VNET_NAME(tcp_sendbuf_auto_lowat), 0,
 	"Modify threshold for auto send buffer growth to account for SO_SNDLOWAT");
 
+#ifdef TCPHPTS
+VNET_DEFINE_STATIC(int, tcp_pacing_burst) = 2;
+#define	V_tcp_pacing_burst	VNET(tcp_pacing_burst)
+SYSCTL_INT(_net_inet_tcp, OID_AUTO, pacing_burst, CTLFLAG_VNET | CTLFLAG_RW,
+	&VNET_NAME(tcp_pacing_burst), 0,
+	"Segments released per pacing quantum when TCP_PACING_RATE is set");
+#endif
+
 /*
  * Make sure that either retransmit or persist timer is set for SYN, FIN and
  * non-ACK.
@@ -199,6 +210,9 @@ tcp_output(struct tcpcb *tp)
 #endif
 	struct tcphdr *th;
 	u_char opt[TCP_MAXOLEN];
+	u_char cached_opt[TCP_MAXOLEN];
+	struct tcpopt cached_to;
+	int cached_optlen;
 	unsigned ipoptlen, optlen, hdrlen;
 #if defined(IPSEC) || defined(IPSEC_SUPPORT)
 	unsigned ipsec_optlen = 0;
@@ -210,6 +224,9 @@ tcp_output(struct tcpcb *tp)
 	struct tcpopt to;
 	unsigned int wanted_cookie = 0;
 	unsigned int dont_sendalot = 0;
+#ifdef TCPHPTS
+	uint32_t paced_sent = 0;
+#endif
 #if 0
 	int maxburst = TCP_MAXBURST;
 #endif
@@ -227,6 +244,20 @@ tcp_output(struct tcpcb *tp)
 		return (tcp_offload_output(tp));
 #endif
 
+#ifdef TCPHPTS
+	/*
+	 * When pacing, transmission is clocked off the hpts wheel.  While
+	 * this connection is queued on the wheel, any call that is not the
+	 * wheel callback itself would re-burst the data the pacer has
+	 * spread out, so just return; the pending callback will pick up
+	 * whatever work has accumulated by the time it fires.
+	 */
+	if (tp->t_inpcb->inp_hpts_calls)
+		tp->t_inpcb->inp_hpts_calls = 0;
+	else if (tp->t_pacing_rate != 0 && tp->t_inpcb->inp_in_hpts)
+		return (0);
+#endif
+
 	/*
 	 * For TFO connections in SYN_SENT or SYN_RECEIVED,
 	 * only allow the initial SYN or SYN|ACK and those sent
@@ -255,6 +286,7 @@ tcp_output(struct tcpcb *tp)
 			idle = 0;
 		}
 	}
+	cached_optlen = -1;
 again:
 	/*
 	 * If we've recently taken a timeout, snd_max will be greater than
@@ -758,7 +790,7 @@ send:
 	 * segments.  Options for SYN-ACK segments are handled in TCP
 	 * syncache.
 	 */
-	to.to_flags = 0;
+	bzero(&to, sizeof(to));	/* memcmp()ed against cached_to below */
 	if ((tp->t_flags & TF_NOOPT) == 0) {
 		/* Maximum segment size. */
 		if (flags & TH_SYN) {
@@ -842,8 +874,29 @@ send:
 			to.to_flags |= TOF_SIGNATURE;
 #endif /* TCP_SIGNATURE */
 
-		/* Processing the options. */
-		hdrlen += optlen = tcp_addoptions(&to, opt);
+		/*
+		 * Processing the options.  When a send window worth of
+		 * segments is emitted by looping on sendalot, consecutive
+		 * segments usually carry identical options; reuse the
+		 * block formatted for the previous segment instead of
+		 * deriving it again.  Signed segments never match since
+		 * tcp_addoptions() must point to_signature at the fresh
+		 * block for the MD5 digest to be filled in later.
+		 */
+		if (cached_optlen >= 0 && (to.to_flags & TOF_SIGNATURE) == 0 &&
+		    memcmp(&to, &cached_to, sizeof(to)) == 0) {
+			bcopy(cached_opt, opt, cached_optlen);
+			optlen = cached_optlen;
+			hdrlen += optlen;
+		} else {
+			hdrlen += optlen = tcp_addoptions(&to, opt);
+			if ((to.to_flags & TOF_SIGNATURE) == 0) {
+				cached_to = to;
+				bcopy(opt, cached_opt, optlen);
+				cached_optlen = optlen;
+			} else
+				cached_optlen = -1;
+		}
 		/*
 		 * If we wanted a TFO option to be added, but it was unable
 		 * to fit, ensure no data is sent.
@@ -1607,9 +1660,36 @@ timer:
 	 */
 	if (sendalot && --maxburst)
 		goto again;
+#endif
+#ifdef TCPHPTS
+	/*
+	 * With a pacing rate set, release no more than a burst of
+	 * segments per call and queue ourselves on the hpts wheel to
+	 * continue once the released bytes have drained at that rate;
+	 * the wheel callback re-enters this function.  A rate so high
+	 * that the delay rounds below one wheel slot just keeps
+	 * bursting.
+	 */
+	if (sendalot && tp->t_pacing_rate != 0) {
+		paced_sent += len;
+		if (paced_sent >=
+		    (uint32_t)tp->t_maxseg * V_tcp_pacing_burst) {
+			uint32_t slot;
+
+			slot = HPTS_USEC_TO_SLOTS((uint64_t)paced_sent *
+			    HPTS_USEC_IN_SEC / tp->t_pacing_rate);
+			if (slot > HPTS_MS_TO_SLOTS(1000))
+				slot = HPTS_MS_TO_SLOTS(1000);
+			if (slot > 0) {
+				tcp_hpts_insert(tp->t_inpcb, slot);
+				return (0);
+			}
+		}
+	}
 #endif
 	if (sendalot)
 		goto again;
+	tcp_conn_stats_update(tp);
 	return (0);
 }
 
@@ -2257,6 +2257,119 @@ SYSCTL_PROC(_net_inet_tcp, TCPCTL_PCBLIST, pcblist,
     CTLTYPE_OPAQUE | CTLFLAG_RD, NULL, 0,
     tcp_pcblist, "S,xtcpcb", "List of active TCP connections");
 
+/*
+ * Refresh the connection's lock-free statistics block.  Called from the
+ * input and output paths and on state changes, always under the inpcb
+ * lock, so there is a single writer per block; the generation counter
+ * lets readers detect and retry torn snapshots.
+ */
+void
+tcp_conn_stats_update(struct tcpcb *tp)
+{
+	struct tcp_conn_stats *tcs;
+
+	INP_WLOCK_ASSERT(tp->t_inpcb);
+	tcs = &tp->t_constats;
+	tcs->tcs_gen++;
+	atomic_thread_fence_rel();
+	tcs->tcs_state = tp->t_state;
+	tcs->tcs_rtt = ((uint64_t)tp->t_srtt * tick) >> TCP_RTT_SHIFT;
+	tcs->tcs_rttvar = ((uint64_t)tp->t_rttvar * tick) >> TCP_RTTVAR_SHIFT;
+	tcs->tcs_snd_cwnd = tp->snd_cwnd;
+	tcs->tcs_snd_ssthresh = tp->snd_ssthresh;
+	tcs->tcs_snd_wnd = tp->snd_wnd;
+	tcs->tcs_rcv_wnd = tp->rcv_wnd;
+	tcs->tcs_snd_rexmitpack = tp->t_sndrexmitpack;
+	tcs->tcs_rcv_ooopack = tp->t_rcvoopack;
+	atomic_thread_fence_rel();
+	tcs->tcs_gen++;
+}
+
+/*
+ * Copy a statistics block without the inpcb lock, retrying while the
+ * writer is mid-update.  Returns false if no stable snapshot could be
+ * had in a few tries.
+ */
+static bool
+tcp_conn_stats_snap(struct tcp_conn_stats *tcs, struct tcp_conn_stats *out)
+{
+	uint32_t gen;
+	int tries;
+
+	for (tries = 0; tries < 3; tries++) {
+		gen = atomic_load_acq_32(&tcs->tcs_gen);
+		if ((gen & 1) != 0)
+			continue;
+		*out = *tcs;
+		atomic_thread_fence_acq();
+		if (atomic_load_acq_32(&tcs->tcs_gen) == gen) {
+			out->tcs_gen = gen;
+			return (true);
+		}
+	}
+	return (false);
+}
+
+/*
+ * Bulk export of every connection's statistics block.  The pcb list is
+ * walked within the net epoch and the blocks are snapshotted via their
+ * generation counters, so no per-connection lock is taken: monitoring
+ * the whole host does not stall any connection.  Reading a tcpcb that
+ * is concurrently discarded is harmless because the zone is type
+ * stable (see tcp_init()); the inp_ppcb recheck after the copy throws
+ * such snapshots away.
+ */
+static int
+tcp_conn_stats_list(SYSCTL_HANDLER_ARGS)
+{
+	struct epoch_tracker et;
+	struct inpcb *inp;
+	struct tcpcb *tp;
+	struct xtcp_conn_stats xcs;
+	int error, n;
+
+	if (req->oldptr == NULL) {
+		n = V_tcbinfo.ipi_count;
+		n += imax(n / 8, 10);
+		req->oldidx = n * sizeof(struct xtcp_conn_stats);
+		return (0);
+	}
+	if (req->newptr != NULL)
+		return (EPERM);
+
+	error = sysctl_wire_old_buffer(req, 0);
+	if (error != 0)
+		return (error);
+
+	INP_INFO_RLOCK_ET(&V_tcbinfo, et);
+	CK_LIST_FOREACH(inp, V_tcbinfo.ipi_listhead, inp_list) {
+		if ((inp->inp_flags & (INP_TIMEWAIT | INP_DROPPED)) != 0)
+			continue;
+		if (cr_canseeinpcb(req->td->td_ucred, inp) != 0)
+			continue;
+		tp = intotcpcb(inp);
+		if (tp == NULL)
+			continue;
+		bzero(&xcs, sizeof(xcs));
+		xcs.xcs_inc = inp->inp_inc;
+		if (!tcp_conn_stats_snap(&tp->t_constats, &xcs.xcs_stats))
+			continue;
+		atomic_thread_fence_acq();
+		if (intotcpcb(inp) != tp)
+			continue;
+		error = SYSCTL_OUT(req, &xcs, sizeof(xcs));
+		if (error != 0)
+			break;
+	}
+	INP_INFO_RUNLOCK_ET(&V_tcbinfo, et);
+	return (error);
+}
+
+SYSCTL_PROC(_net_inet_tcp, OID_AUTO, conn_stats,
+    CTLTYPE_OPAQUE | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+    tcp_conn_stats_list, "S,xtcp_conn_stats",
+    "Lock-free snapshot of per-connection TCP statistics");
+
 #ifdef INET
 static int
 tcp_getcred(SYSCTL_HANDLER_ARGS)
@@ -3215,6 +3328,7 @@ tcp_state_change(struct tcpcb *tp, int newstate)
 	TCPSTATES_INC(newstate);
 	tp->t_state = newstate;
 	TCP_PROBE6(state__change, NULL, tp, NULL, tp, NULL, pstate);
+	tcp_conn_stats_update(tp);
 }
 
 /*
@@ -1978,6 +1978,22 @@ unlock_and_done:
 				    TP_MAXIDLE(tp));
 			goto unlock_and_done;
 
+#ifdef TCPHPTS
+		case TCP_PACING_RATE: {
+			uint64_t rate;
+
+			INP_WUNLOCK(inp);
+			error = sooptcopyin(sopt, &rate, sizeof(rate),
+			    sizeof(rate));
+			if (error)
+				return (error);
+
+			INP_WLOCK_RECHECK(inp);
+			tp->t_pacing_rate = rate;
+			goto unlock_and_done;
+		}
+#endif
+
 #ifdef TCPPCAP
 		case TCP_PCAP_OUT:
 		case TCP_PCAP_IN:
@@ -2145,6 +2161,16 @@ unlock_and_done:
 			INP_WUNLOCK(inp);
 			error = sooptcopyout(sopt, buf, len + 1);
 			break;
+#ifdef TCPHPTS
+		case TCP_PACING_RATE: {
+			uint64_t rate;
+
+			rate = tp->t_pacing_rate;
+			INP_WUNLOCK(inp);
+			error = sooptcopyout(sopt, &rate, sizeof(rate));
+			break;
+		}
+#endif
 		case TCP_KEEPIDLE:
 		case TCP_KEEPINTVL:
 		case TCP_KEEPINIT:
@@ -43,6 +43,27 @@
 #include <sys/mbuf.h>
 #endif
 
+/*
+ * Lock-free per-connection statistics, embedded in the tcpcb.  The
+ * owning connection updates the block from the input and output paths
+ * under the inpcb lock, moving tcs_gen through an odd value for the
+ * duration of the update; bulk readers snapshot it without the inpcb
+ * lock by retrying while the generation is odd or changes across the
+ * copy.
+ */
+struct tcp_conn_stats {
+	uint32_t	tcs_gen;	/* seqlock generation */
+	uint32_t	tcs_state;	/* TCPS_* connection state */
+	uint32_t	tcs_rtt;	/* smoothed RTT, usec */
+	uint32_t	tcs_rttvar;	/* RTT variance, usec */
+	uint32_t	tcs_snd_cwnd;	/* congestion window, bytes */
+	uint32_t	tcs_snd_ssthresh; /* slow start threshold, bytes */
+	uint32_t	tcs_snd_wnd;	/* send window, bytes */
+	uint32_t	tcs_rcv_wnd;	/* receive window, bytes */
+	uint64_t	tcs_snd_rexmitpack; /* retransmitted packets */
+	uint64_t	tcs_rcv_ooopack; /* out-of-order packets received */
+};
+
 #if defined(_KERNEL) || defined(_WANT_TCPCB)
 /* TCP segment queue entry */
 struct tseg_qent {
@@ -216,6 +237,9 @@ struct tcpcb {
 		uint8_t client[TCP_FASTOPEN_MAX_COOKIE_LEN];
 		uint64_t server;
 	} t_tfo_cookie;			/* TCP Fast Open cookie to send */
+	uint64_t t_pacing_rate;		/* hpts pacing ceiling in bytes/sec,
+					   0 disables pacing */
+	struct tcp_conn_stats t_constats; /* lock-free statistics export */
 #ifdef TCPPCAP
 	struct mbufq t_inpkts;		/* List of saved input packets. */
 	struct mbufq t_outpkts;		/* List of saved output packets. */
@@ -703,8 +727,18 @@ struct xtcpcb {
 	int32_t		spare32[32];
 } __aligned(8);
 
+/*
+ * Per-connection statistics record exported by the
+ * net.inet.tcp.conn_stats sysctl.
+ */
+struct xtcp_conn_stats {
+	struct in_conninfo	xcs_inc;
+	struct tcp_conn_stats	xcs_stats;
+} __aligned(8);
+
 #ifdef _KERNEL
 void	tcp_inptoxtp(const struct inpcb *, struct xtcpcb *);
+void	tcp_conn_stats_update(struct tcpcb *);
 #endif
 #endif
 
@@ -866,6 +900,7 @@ void	hhook_run_tcp_est_in(struct tcpcb *tp,
 #endif
 
 int	 tcp_input(struct mbuf **, int *, int);
+int	 tcp_input_batch(struct mbuf **, int *, int);
 int	 tcp_autorcvbuf(struct mbuf *, struct tcphdr *, struct socket *,
 	    struct tcpcb *, int);
 void	 tcp_do_segment(struct mbuf *, struct tcphdr *,
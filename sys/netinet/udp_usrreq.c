@@ -1070,6 +1070,30 @@ udp_ctloutput(struct socket *so, struct sockopt *sopt)
 				up->u_rxcslen = optval;
 			INP_WUNLOCK(inp);
 			break;
+		case UDP_SEGMENT:
+			if (isudplite) {
+				INP_WUNLOCK(inp);
+				error = ENOPROTOOPT;
+				break;
+			}
+			INP_WUNLOCK(inp);
+			error = sooptcopyin(sopt, &optval, sizeof(optval),
+			    sizeof(optval));
+			if (error != 0)
+				break;
+			if (optval < 0 ||
+			    optval > IP_MAXPACKET - sizeof(struct udpiphdr)) {
+				error = EINVAL;
+				break;
+			}
+			inp = sotoinpcb(so);
+			KASSERT(inp != NULL, ("%s: inp == NULL", __func__));
+			INP_WLOCK(inp);
+			up = intoudpcb(inp);
+			KASSERT(up != NULL, ("%s: up == NULL", __func__));
+			up->u_txsegsize = optval;
+			INP_WUNLOCK(inp);
+			break;
 		default:
 			INP_WUNLOCK(inp);
 			error = ENOPROTOOPT;
@@ -1105,6 +1129,18 @@ udp_ctloutput(struct socket *so, struct sockopt *sopt)
 			INP_WUNLOCK(inp);
 			error = sooptcopyout(sopt, &optval, sizeof(optval));
 			break;
+		case UDP_SEGMENT:
+			if (isudplite) {
+				INP_WUNLOCK(inp);
+				error = ENOPROTOOPT;
+				break;
+			}
+			up = intoudpcb(inp);
+			KASSERT(up != NULL, ("%s: up == NULL", __func__));
+			optval = up->u_txsegsize;
+			INP_WUNLOCK(inp);
+			error = sooptcopyout(sopt, &optval, sizeof(optval));
+			break;
 		default:
 			INP_WUNLOCK(inp);
 			error = ENOPROTOOPT;
@@ -1138,6 +1174,7 @@ udp_output(struct inpcb *inp, struct mbuf *m, struct sockaddr *addr,
 	u_char tos;
 	uint8_t pr;
 	uint16_t cscov = 0;
+	uint16_t segsize = 0;
 	uint32_t flowid = 0;
 	uint8_t flowtype = M_HASHTYPE_NONE;
 
@@ -1146,8 +1183,17 @@ udp_output(struct inpcb *inp, struct mbuf *m, struct sockaddr *addr,
 	 * inpcb.  As such, we don't know up front whether we will need the
 	 * pcbinfo lock or not.  Do any work to decide what is needed up
 	 * front before acquiring any locks.
+	 *
+	 * The UDP_SEGMENT size is sampled without the inpcb lock; the
+	 * field is only ever modified under the write lock, so the read
+	 * cannot tear, and a racing setsockopt() merely decides which of
+	 * the two sends it applies to.  Writes larger than one segment
+	 * are carved into a train of datagrams below, so only unsegmented
+	 * sends are held to the single-datagram limit here.
 	 */
-	if (len + sizeof(struct udpiphdr) > IP_MAXPACKET) {
+	if (inp->inp_socket->so_proto->pr_protocol == IPPROTO_UDP)
+		segsize = intoudpcb(inp)->u_txsegsize;
+	if (segsize == 0 && len + sizeof(struct udpiphdr) > IP_MAXPACKET) {
 		if (control)
 			m_freem(control);
 		m_freem(m);
@@ -1394,6 +1440,146 @@ udp_output(struct inpcb *inp, struct mbuf *m, struct sockaddr *addr,
 		}
 	}
 
+	/*
+	 * If a UDP_SEGMENT size is configured and this write exceeds it,
+	 * carve the payload into a train of segment-sized datagrams, all
+	 * sharing the binding work done above and a single route lookup,
+	 * rather than paying for a full trip through here per datagram.
+	 * The segments reference the payload clusters read-only, so the
+	 * only per-datagram costs left are the header mbuf and ip_output().
+	 */
+	if (segsize != 0 && len > segsize) {
+		struct mbuf *n, *pkts, **pktp;
+		struct in_addr csfaddr;
+		struct route ro;
+		int off, plen;
+
+		ipflags = 0;
+		if (inp->inp_socket->so_options & SO_DONTROUTE)
+			ipflags |= IP_ROUTETOIF;
+		if (inp->inp_socket->so_options & SO_BROADCAST)
+			ipflags |= IP_ALLOWBROADCAST;
+		if (inp->inp_flags & INP_ONESBCAST)
+			ipflags |= IP_SENDONES;
+
+		/* The checksum pseudo-header address may differ from ui_dst. */
+		csfaddr = faddr;
+		if (inp->inp_flags & INP_ONESBCAST)
+			csfaddr.s_addr = INADDR_BROADCAST;
+
+#ifdef	RSS
+		if (flowtype == M_HASHTYPE_NONE) {
+			uint32_t hash_val, hash_type;
+
+			if (rss_proto_software_hash_v4(faddr, laddr, fport,
+			    lport, pr, &hash_val, &hash_type) == 0) {
+				flowid = hash_val;
+				flowtype = hash_type;
+			}
+		}
+		ipflags |= IP_NODEFAULTFLOWID;
+#endif
+
+		pkts = NULL;
+		pktp = &pkts;
+		for (off = 0; off < len; off += plen) {
+			plen = min(len - off, segsize);
+			n = m_gethdr(M_NOWAIT, MT_DATA);
+			if (n != NULL) {
+				n->m_data += max_linkhdr;
+				n->m_len = sizeof(struct udpiphdr);
+				n->m_pkthdr.len = sizeof(struct udpiphdr) +
+				    plen;
+				n->m_next = m_copym(m, off, plen, M_NOWAIT);
+			}
+			if (n == NULL || n->m_next == NULL) {
+				if (n != NULL)
+					m_free(n);
+				while ((n = pkts) != NULL) {
+					pkts = n->m_nextpkt;
+					n->m_nextpkt = NULL;
+					m_freem(n);
+				}
+				error = ENOBUFS;
+				goto release;
+			}
+			/* m_copym() duplicates the pkthdr at offset zero. */
+			if (n->m_next->m_flags & M_PKTHDR)
+				m_demote(n->m_next, 1, 0);
+			ui = mtod(n, struct udpiphdr *);
+			bzero(ui->ui_x1, sizeof(ui->ui_x1));
+			ui->ui_v = IPVERSION << 4;
+			ui->ui_pr = pr;
+			ui->ui_src = laddr;
+			ui->ui_dst = faddr;
+			ui->ui_sport = lport;
+			ui->ui_dport = fport;
+			ui->ui_ulen = htons((u_short)plen +
+			    sizeof(struct udphdr));
+			if (inp->inp_flags & INP_DONTFRAG) {
+				struct ip *ip;
+
+				ip = (struct ip *)&ui->ui_i;
+				ip->ip_off |= htons(IP_DF);
+			}
+#ifdef MAC
+			mac_inpcb_create_mbuf(inp, n);
+#endif
+			ui->ui_sum = 0;
+			if (V_udp_cksum) {
+				ui->ui_sum = in_pseudo(ui->ui_src.s_addr,
+				    csfaddr.s_addr, htons((u_short)plen +
+				    sizeof(struct udphdr) + pr));
+				n->m_pkthdr.csum_flags = CSUM_UDP;
+				n->m_pkthdr.csum_data =
+				    offsetof(struct udphdr, uh_sum);
+			}
+			((struct ip *)ui)->ip_len =
+			    htons(sizeof(struct udpiphdr) + plen);
+			((struct ip *)ui)->ip_ttl = inp->inp_ip_ttl;
+			((struct ip *)ui)->ip_tos = tos;
+			if (flowtype != M_HASHTYPE_NONE) {
+				n->m_pkthdr.flowid = flowid;
+				M_HASHTYPE_SET(n, flowtype);
+			}
+			UDPSTAT_INC(udps_opackets);
+			*pktp = n;
+			pktp = &n->m_nextpkt;
+		}
+		m_freem(m);
+
+		if (unlock_udbinfo == UH_WLOCKED)
+			INP_HASH_WUNLOCK(pcbinfo);
+		else if (unlock_udbinfo == UH_RLOCKED)
+			INP_HASH_RUNLOCK_ET(pcbinfo, et);
+
+		/*
+		 * Resolve the route once and reuse it for every segment.
+		 * The inpcb route cache may only be used under the write
+		 * lock, so read-locked sends use a local cache instead.
+		 */
+		bzero(&ro, sizeof(ro));
+		while ((n = pkts) != NULL) {
+			pkts = n->m_nextpkt;
+			n->m_nextpkt = NULL;
+			if (error != 0) {
+				m_freem(n);
+				continue;
+			}
+			ui = mtod(n, struct udpiphdr *);
+			UDP_PROBE(send, NULL, inp, &ui->ui_i, inp, &ui->ui_u);
+			error = ip_output(n, inp->inp_options,
+			    (unlock_inp == UH_WLOCKED ? &inp->inp_route : &ro),
+			    ipflags, inp->inp_moptions, inp);
+		}
+		RO_RTFREE(&ro);
+		if (unlock_inp == UH_WLOCKED)
+			INP_WUNLOCK(inp);
+		else
+			INP_RUNLOCK(inp);
+		return (error);
+	}
+
 	/*
 	 * Calculate data length and get a mbuf for UDP, IP, and possible
 	 * link-layer headers.  Immediate slide the data pointer back forward
@@ -70,6 +70,7 @@ struct udpcb {
 	u_int		u_flags;	/* Generic UDP flags. */
 	uint16_t	u_rxcslen;	/* Coverage for incoming datagrams. */
 	uint16_t	u_txcslen;	/* Coverage for outgoing datagrams. */
+	uint16_t	u_txsegsize;	/* UDP_SEGMENT payload size per dgram. */
 	void 		*u_tun_ctx;	/* Tunneling callback context. */
 };
 
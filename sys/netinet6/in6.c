@@ -2042,6 +2042,7 @@ struct in6_llentry {
 };
 
 #define	IN6_LLTBL_DEFAULT_HSIZE	32
+#define	IN6_LLTBL_MAX_HSIZE	65536
 #define	IN6_LLTBL_HASH(k, h) \
 	(((((((k >> 8) ^ k) >> 8) ^ k) >> 8) ^ k) & ((h) - 1))
 
@@ -2416,8 +2417,23 @@ static struct lltable *
 in6_lltattach(struct ifnet *ifp)
 {
 	struct lltable *llt;
+	uint32_t hsize;
 
-	llt = lltable_allocate_htbl(IN6_LLTBL_DEFAULT_HSIZE);
+	/*
+	 * Size the neighbor cache hash from the tunable; hosts facing
+	 * very large L2 domains want far more than the default 32
+	 * buckets.  The hash function masks, so round up to a power
+	 * of two.
+	 */
+	hsize = V_nd6_lltable_hsize;
+	if (hsize < IN6_LLTBL_DEFAULT_HSIZE)
+		hsize = IN6_LLTBL_DEFAULT_HSIZE;
+	else if (hsize > IN6_LLTBL_MAX_HSIZE)
+		hsize = IN6_LLTBL_MAX_HSIZE;
+	if (!powerof2(hsize))
+		hsize = 1 << fls(hsize);
+
+	llt = lltable_allocate_htbl(hsize);
 	llt->llt_af = AF_INET6;
 	llt->llt_ifp = ifp;
 
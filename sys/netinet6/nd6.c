@@ -40,6 +40,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/param.h>
 #include <sys/systm.h>
 #include <sys/callout.h>
+#include <sys/counter.h>
 #include <sys/lock.h>
 #include <sys/malloc.h>
 #include <sys/mbuf.h>
@@ -107,6 +108,16 @@ VNET_DEFINE_STATIC(int, nd6_maxqueuelen) = 1; /* max pkts cached in unresolved
 #define	V_nd6_maxndopt			VNET(nd6_maxndopt)
 #define	V_nd6_maxqueuelen		VNET(nd6_maxqueuelen)
 
+VNET_DEFINE(int, nd6_lltable_hsize) = 0; /* cache hash buckets, 0 = default */
+
+/* neighbor cache statistics */
+VNET_DEFINE_STATIC(counter_u64_t, nd6_cache_hits);
+VNET_DEFINE_STATIC(counter_u64_t, nd6_cache_misses);
+VNET_DEFINE_STATIC(counter_u64_t, nd6_cache_evictions);
+#define	V_nd6_cache_hits		VNET(nd6_cache_hits)
+#define	V_nd6_cache_misses		VNET(nd6_cache_misses)
+#define	V_nd6_cache_evictions		VNET(nd6_cache_evictions)
+
 #ifdef ND6_DEBUG
 VNET_DEFINE(int, nd6_debug) = 1;
 #else
@@ -216,6 +227,10 @@ nd6_init(void)
 	mtx_init(&V_nd6_onlink_mtx, "nd6 onlink", NULL, MTX_DEF);
 	rw_init(&V_nd6_lock, "nd6 list");
 
+	V_nd6_cache_hits = counter_u64_alloc(M_WAITOK);
+	V_nd6_cache_misses = counter_u64_alloc(M_WAITOK);
+	V_nd6_cache_evictions = counter_u64_alloc(M_WAITOK);
+
 	LIST_INIT(&V_nd_prefix);
 	TAILQ_INIT(&V_nd_defrouter);
 
@@ -247,6 +262,9 @@ nd6_destroy()
 		EVENTHANDLER_DEREGISTER(lle_event, lle_event_eh);
 		EVENTHANDLER_DEREGISTER(iflladdr_event, iflladdr_event_eh);
 	}
+	counter_u64_free(V_nd6_cache_hits);
+	counter_u64_free(V_nd6_cache_misses);
+	counter_u64_free(V_nd6_cache_evictions);
 	rw_destroy(&V_nd6_lock);
 	mtx_destroy(&V_nd6_onlink_mtx);
 }
@@ -1209,6 +1227,10 @@ nd6_lookup(const struct in6_addr *addr6, int flags, struct ifnet *ifp)
 	IF_AFDATA_LOCK_ASSERT(ifp);
 
 	ln = lla_lookup(LLTABLE6(ifp), flags, (struct sockaddr *)&sin6);
+	if (ln != NULL)
+		counter_u64_add(V_nd6_cache_hits, 1);
+	else
+		counter_u64_add(V_nd6_cache_misses, 1);
 
 	return (ln);
 }
@@ -1418,6 +1440,8 @@ nd6_free(struct llentry **lnp, int gc)
 	LLE_WLOCK_ASSERT(ln);
 	ND6_RLOCK_ASSERT();
 
+	counter_u64_add(V_nd6_cache_evictions, 1);
+
 	ifp = lltable_get_ifp(ln->lle_tbl);
 	if ((ND_IFINFO(ifp)->flags & ND6_IFF_ACCEPT_RTADV) != 0)
 		dr = defrouter_lookup_locked(&ln->r_l3addr.addr6, ifp);
@@ -2628,6 +2652,19 @@ SYSCTL_INT(_net_inet6_icmp6, ICMPV6CTL_ND6_MAXQLEN, nd6_maxqueuelen,
 	CTLFLAG_VNET | CTLFLAG_RW, &VNET_NAME(nd6_maxqueuelen), 1, "");
 SYSCTL_INT(_net_inet6_icmp6, OID_AUTO, nd6_gctimer,
 	CTLFLAG_VNET | CTLFLAG_RW, &VNET_NAME(nd6_gctimer), (60 * 60 * 24), "");
+SYSCTL_INT(_net_inet6_icmp6, OID_AUTO, nd6_lltable_hsize,
+	CTLFLAG_VNET | CTLFLAG_RWTUN, &VNET_NAME(nd6_lltable_hsize), 0,
+	"Neighbor cache hash buckets for subsequently attached interfaces "
+	"(0 for the default, rounded up to a power of 2)");
+SYSCTL_COUNTER_U64(_net_inet6_icmp6, OID_AUTO, nd6_cache_hits,
+	CTLFLAG_VNET | CTLFLAG_RD, &VNET_NAME(nd6_cache_hits),
+	"Neighbor cache lookups that found an entry");
+SYSCTL_COUNTER_U64(_net_inet6_icmp6, OID_AUTO, nd6_cache_misses,
+	CTLFLAG_VNET | CTLFLAG_RD, &VNET_NAME(nd6_cache_misses),
+	"Neighbor cache lookups that found no entry");
+SYSCTL_COUNTER_U64(_net_inet6_icmp6, OID_AUTO, nd6_cache_evictions,
+	CTLFLAG_VNET | CTLFLAG_RD, &VNET_NAME(nd6_cache_evictions),
+	"Neighbor cache entries removed by expiry or garbage collection");
 
 static int
 nd6_sysctl_drlist(SYSCTL_HANDLER_ARGS)
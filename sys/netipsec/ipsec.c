@@ -155,8 +155,14 @@ VNET_DEFINE(int, crypto_support) = CRYPTOCAP_F_HARDWARE | CRYPTOCAP_F_SOFTWARE;
  *
  *  0 - disabled
  *  1 - enabled
+ *
+ * Fans software crypto for consecutive packets of an SA across the
+ * opencrypto worker threads; completions are merged back in submission
+ * order, so sequence numbers and the anti-replay window still advance
+ * monotonically.  Without this a single tunnel is limited to one
+ * core's cipher throughput.
  */
-VNET_DEFINE(int, async_crypto) = 0;
+VNET_DEFINE(int, async_crypto) = 1;
 
 /*
  * TCP/UDP checksum handling policy for transport mode NAT-T (RFC3948)
@@ -968,7 +968,16 @@ crypto_dispatch(struct cryptop *crp)
 		binuptime(&crp->crp_tstamp);
 #endif
 
-	crp->crp_retw_id = ((uintptr_t)crp->crp_session) % crypto_workers_num;
+	/*
+	 * All requests for one session must complete on the same return
+	 * worker to preserve ordering, but distinct sessions should
+	 * spread across all workers.  Sessions come out of a UMA zone,
+	 * so the pointer's low bits carry no entropy; mix the bits with
+	 * a Fibonacci hash before taking the modulus or most sessions
+	 * end up on a single worker.
+	 */
+	crp->crp_retw_id = ((uintptr_t)crp->crp_session * 2654435761UL) %
+	    crypto_workers_num;
 
 	if (CRYPTOP_ASYNC(crp)) {
 		if (crp->crp_flags & CRYPTO_F_ASYNC_KEEPORDER) {
@@ -1022,6 +1031,65 @@ crypto_batch_enqueue(struct cryptop *crp)
 	CRYPTO_Q_UNLOCK();
 }
 
+/*
+ * Dispatch an array of requests belonging to one session in a single
+ * call.  The driver sees CRYPTO_HINT_MORE for every request but the
+ * last, letting software drivers keep the key schedule and context
+ * loaded across the run and hardware drivers coalesce doorbell writes,
+ * without the queue round-trip that CRYPTO_F_BATCH costs.  Completion
+ * is still reported per request through the usual callbacks; requests
+ * the driver cannot take immediately are queued individually.
+ */
+int
+crypto_dispatch_batch(struct cryptop **crps, u_int ncrps)
+{
+	struct cryptocap *cap;
+	struct cryptop *crp;
+	u_int i;
+	int result;
+
+	if (ncrps == 0)
+		return (0);
+	cap = crypto_checkdriver(crypto_ses2hid(crps[0]->crp_session));
+	KASSERT(cap != NULL, ("%s: Driver disappeared.", __func__));
+	for (i = 0; i < ncrps; i++) {
+		crp = crps[i];
+		KASSERT(crp->crp_session == crps[0]->crp_session,
+		    ("%s: batched request for another session", __func__));
+		cryptostats.cs_ops++;
+#ifdef CRYPTO_TIMING
+		if (crypto_timing)
+			binuptime(&crp->crp_tstamp);
+#endif
+		crp->crp_retw_id = ((uintptr_t)crp->crp_session *
+		    2654435761UL) % crypto_workers_num;
+		if (CRYPTOP_ASYNC(crp)) {
+			if (crp->crp_flags & CRYPTO_F_ASYNC_KEEPORDER) {
+				struct crypto_ret_worker *ret_worker;
+
+				ret_worker = CRYPTO_RETW(crp->crp_retw_id);
+
+				CRYPTO_RETW_LOCK(ret_worker);
+				crp->crp_seq = ret_worker->reorder_ops++;
+				CRYPTO_RETW_UNLOCK(ret_worker);
+			}
+
+			TASK_INIT(&crp->crp_task, 0, crypto_task_invoke, crp);
+			taskqueue_enqueue(crypto_tq, &crp->crp_task);
+			continue;
+		}
+		if (cap->cc_qblocked) {
+			crypto_batch_enqueue(crp);
+			continue;
+		}
+		result = crypto_invoke(cap, crp,
+		    i + 1 < ncrps ? CRYPTO_HINT_MORE : 0);
+		if (result == ERESTART)
+			crypto_batch_enqueue(crp);
+	}
+	return (0);
+}
+
 /*
  * Add an asymetric crypto request to a queue,
  * to be processed by the kernel thread.
@@ -52,6 +52,7 @@ struct task {
 	u_short	ta_priority;		/* (c) Priority */
 	task_fn_t *ta_func;		/* (c) task handler */
 	void	*ta_context;		/* (c) argument for handler */
+	uint64_t ta_tqtime;		/* (q) time of first enqueue */
 };
 
 struct gtask {
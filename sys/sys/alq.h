@@ -59,6 +59,7 @@ struct ale {
 #define	ALQ_WAITOK	0x0002	/* ALQ may sleep. */
 #define	ALQ_NOACTIVATE	0x0004	/* Don't activate ALQ after write. */
 #define	ALQ_ORDERED	0x0010	/* Maintain write ordering between threads. */
+#define	ALQ_LOCKLESS	0x0020	/* Lock-free writers; see below. */
 
 /* Suggested mode for file creation. */
 #define	ALQ_DEFAULT_CMODE	0600
@@ -72,9 +73,17 @@ struct ale {
  *	cred	Credential to authorize open and I/O with.
  *	cmode	Creation mode for file, if new.
  *	size	The size of the queue in bytes.
- *	flags	ALQ_ORDERED
+ *	flags	ALQ_ORDERED or ALQ_LOCKLESS
  * Returns:
  *	error from open or 0 on success
+ *
+ * An ALQ_LOCKLESS queue accepts concurrent alq_writen() calls without
+ * taking the queue lock: writers reserve buffer space with an atomic
+ * advance of a reservation offset, copy independently, and commit in
+ * reservation order.  Writes to such a queue never sleep; if there is no
+ * room before the logging daemon catches up, the write is dropped and
+ * EWOULDBLOCK returned.  The buffer size is rounded up to a power of two,
+ * and alq_getn()/alq_post() may not be used.
  */
 struct ucred;
 int alq_open_flags(struct alq **alqp, const char *file, struct ucred *cred, int cmode,
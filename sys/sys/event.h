@@ -178,6 +178,16 @@ struct kevent32_freebsd11 {
 #define NOTE_LOWAT	0x0001			/* low water mark */
 #define NOTE_FILE_POLL	0x0002			/* behave like poll() */
 
+/*
+ * data/hint flags for EVFILT_SENDFILE, shared with userspace.  The
+ * filter accumulates completed asynchronous sendfile(2) operations:
+ * data counts the completions and fflags summarizes them with the
+ * flags below.  Use EV_CLEAR to reset both on delivery.
+ */
+#define	NOTE_SENDFILE_CACHE	0x0001	/* op served from the page cache */
+#define	NOTE_SENDFILE_PAGEIN	0x0002	/* op required disk reads */
+#define	NOTE_SENDFILE_ERROR	0x0004	/* op failed, socket aborted */
+
 /*
  * data/hint flags for EVFILT_VNODE, shared with userspace
  */
@@ -215,6 +225,9 @@ struct kevent32_freebsd11 {
 #define NOTE_USECONDS		0x00000004	/* data is microseconds */
 #define NOTE_NSECONDS		0x00000008	/* data is nanoseconds */
 #define	NOTE_ABSTIME		0x00000010	/* timeout is absolute */
+#define	NOTE_COALESCE		0x00000020	/* timer may be coalesced;
+						   ext[0] is the allowed slop
+						   in the timer's units */
 
 struct knote;
 SLIST_HEAD(klist, knote);
@@ -201,6 +201,23 @@ int	fget_cap(struct thread *td, int fd, cap_rights_t *needrightsp,
 int	fget_unlocked(struct filedesc *fdp, int fd, cap_rights_t *needrightsp,
 	    struct file **fpp, seq_t *seqp);
 
+/*
+ * Test whether the file descriptor table can only be modified by the
+ * calling thread: an unshared table in a single-threaded process.  In
+ * that case syscall-scoped file lookups may elide the f_count bump;
+ * see fget_only_user().
+ */
+#define	FILEDESC_IS_ONLY_USER(fdp)	({				\
+	struct filedesc *_fdp = (fdp);					\
+	MPASS(curproc->p_fd == _fdp);					\
+	(curproc->p_numthreads == 1 && _fdp->fd_refcnt == 1);		\
+})
+
+/* Return an unreferenced file; see FILEDESC_IS_ONLY_USER(). */
+int	fget_only_user(struct filedesc *fdp, int fd,
+	    cap_rights_t *needrightsp, struct file **fpp);
+void	fput_only_user(struct filedesc *fdp, struct file *fp);
+
 /* Requires a FILEDESC_{S,X}LOCK held and returns without a ref. */
 static __inline struct file *
 fget_locked(struct filedesc *fdp, int fd)
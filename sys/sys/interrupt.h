@@ -124,12 +124,17 @@ struct intr_event {
 	int		ie_cpu;		/* CPU this event is bound to. */
 	volatile int	ie_phase;	/* Switched to establish a barrier. */
 	volatile int	ie_active[2];	/* Filters in ISR context. */
+	u_long		ie_dispatches;	/* Dispatches of this event. */
+	uint64_t	ie_cycles;	/* cpu_ticks() spent in handlers. */
+	uint64_t	ie_oldcycles;	/* Balancer snapshot of ie_cycles. */
 };
 
 /* Interrupt event flags kept in ie_flags. */
 #define	IE_SOFT		0x000001	/* Software interrupt. */
 #define	IE_ENTROPY	0x000002	/* Interrupt is an entropy source. */
 #define	IE_ADDING_THREAD 0x000004	/* Currently building an ithread. */
+#define	IE_PINNED	0x000008	/* Bound by an operator; don't move. */
+#define	IE_BALANCED	0x000010	/* Bound by the intr balancer. */
 
 /* Flags to pass to sched_swi. */
 #define	SWI_DELAY	0x2
@@ -133,6 +133,7 @@ MALLOC_DECLARE(M_PRISON);
 
 #if defined(_KERNEL) || defined(_WANT_PRISON)
 
+#include <sys/ck.h>
 #include <sys/osd.h>
 #include <sys/uuid.h>
 
@@ -152,9 +153,13 @@ struct prison_racct;
  *   (p) locked by pr_mtx
  *   (c) set only during creation before the structure is shared, no mutex
  *       required to read
+ *   (e) as (a), but lock-free readers may also traverse within an epoch
+ *       section; see the comment above the prison hash in kern_jail.c
  */
 struct prison {
 	TAILQ_ENTRY(prison) pr_list;			/* (a) all prisons */
+	CK_LIST_ENTRY(prison) pr_jidhash;		/* (e) jid hash chain */
+	CK_LIST_ENTRY(prison) pr_namehash;		/* (e) name hash chain */
 	int		 pr_id;				/* (c) prison id */
 	int		 pr_ref;			/* (p) refcount */
 	int		 pr_uref;			/* (p) user (alive) refcount */
@@ -387,6 +392,7 @@ void prison_enforce_statfs(struct ucred *cred, struct mount *mp,
 struct prison *prison_find(int prid);
 struct prison *prison_find_child(struct prison *, int);
 struct prison *prison_find_name(struct prison *, const char *);
+struct prison *prison_find_unlocked(int prid);
 int prison_flag(struct ucred *, unsigned);
 void prison_free(struct prison *pr);
 void prison_free_locked(struct prison *pr);
@@ -251,6 +251,16 @@ void	lock_init(struct lock_object *, struct lock_class *,
 void	lock_destroy(struct lock_object *);
 void	lock_delay(struct lock_delay_arg *);
 void	lock_delay_default_init(struct lock_delay_config *);
+
+/*
+ * Sampled contention telemetry; see the comment in subr_lock.c.  Lock
+ * slow paths call lock_csample_enter() once contention is certain and,
+ * if it returns non-zero, lock_csample_record() with the cpu_ticks()
+ * value taken at that point once the lock is finally acquired.
+ */
+extern u_int lock_csample_rate;
+int	lock_csample_enter(void);
+void	lock_csample_record(struct lock_object *, uintptr_t, uint64_t);
 void	spinlock_enter(void);
 void	spinlock_exit(void);
 void	witness_init(struct lock_object *, const char *);
@@ -51,6 +51,23 @@ struct nvlist;
 typedef struct nvlist nvlist_t;
 #endif
 
+/*
+ * Descriptor for one name/value pair, filled in by the iteration API
+ * (nvlist_next_item() and nvlist_get_items()) so that a list can be
+ * walked and all of its values fetched in a single traversal.
+ * Scalar values (bool, number, descriptor) are stored in nvi_number;
+ * pointer-valued types are stored in nvi_data, with nvi_size holding
+ * the binary size or the array item count.  Pointers reference the
+ * list's own storage, exactly as with the nvlist_get_*() family.
+ */
+typedef struct nvlist_item {
+	const char	*nvi_name;
+	int		 nvi_type;
+	uint64_t	 nvi_number;
+	const void	*nvi_data;
+	size_t		 nvi_size;
+} nvlist_item_t;
+
 #define	NV_NAME_MAX	2048
 
 #define	NV_TYPE_NONE			0
@@ -84,6 +101,7 @@ MALLOC_DECLARE(M_NVLIST);
 __BEGIN_DECLS
 
 nvlist_t	*nvlist_create(int flags);
+nvlist_t	*nvlist_create_arena(int flags);
 void		 nvlist_destroy(nvlist_t *nvl);
 int		 nvlist_error(const nvlist_t *nvl);
 bool		 nvlist_empty(const nvlist_t *nvl);
@@ -100,12 +118,20 @@ void nvlist_fdump(const nvlist_t *nvl, FILE *fp);
 size_t		 nvlist_size(const nvlist_t *nvl);
 void		*nvlist_pack(const nvlist_t *nvl, size_t *sizep);
 nvlist_t	*nvlist_unpack(const void *buf, size_t size, int flags);
+nvlist_t	*nvlist_unpack_zerocopy(const void *buf, size_t size, int flags);
 
 int nvlist_send(int sock, const nvlist_t *nvl);
 nvlist_t *nvlist_recv(int sock, int flags);
 nvlist_t *nvlist_xfer(int sock, nvlist_t *nvl, int flags);
 
+int nvlist_pack_fd(const nvlist_t *nvl, int fd);
+nvlist_t *nvlist_unpack_fd(int fd, int flags);
+
 const char *nvlist_next(const nvlist_t *nvl, int *typep, void **cookiep);
+bool nvlist_next_item(const nvlist_t *nvl, nvlist_item_t *item,
+    void **cookiep);
+size_t nvlist_get_items(const nvlist_t *nvl, nvlist_item_t *items,
+    size_t maxitems);
 
 const nvlist_t *nvlist_get_parent(const nvlist_t *nvl, void **cookiep);
 
@@ -49,6 +49,34 @@
 #define	RM_SLEEPABLE	0x00000004
 #define	RM_NEW		0x00000008
 
+/*
+ * Read-mostly sleepable locks: a distributed-reader rw lock variant.
+ * Each CPU keeps a local reader count, so read acquisitions do not
+ * bounce a shared cacheline among readers; writers interrupt every CPU
+ * to collect the counts and wait for them to drain.  Both readers and
+ * writers may sleep while holding the lock.  Suitable only for data
+ * that is read constantly but reconfigured rarely.
+ */
+struct rmslock_pcpu {
+	int	rmsp_influx;
+	int	rmsp_readers;
+};
+
+struct rmslock {
+	struct mtx	 rms_mtx;
+	struct thread	*rms_owner;
+	struct rmslock_pcpu *rms_pcpu;
+	int		 rms_writers;
+	int		 rms_readers;
+};
+
+void	rms_init(struct rmslock *rms, const char *name);
+void	rms_destroy(struct rmslock *rms);
+void	rms_rlock(struct rmslock *rms);
+void	rms_runlock(struct rmslock *rms);
+void	rms_wlock(struct rmslock *rms);
+void	rms_wunlock(struct rmslock *rms);
+
 void	rm_init(struct rmlock *rm, const char *name);
 void	rm_init_flags(struct rmlock *rm, const char *name, int opts);
 void	rm_destroy(struct rmlock *rm);
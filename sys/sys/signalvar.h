@@ -376,6 +376,7 @@ int	postsig(int sig);
 void	kern_psignal(struct proc *p, int sig);
 int	ptracestop(struct thread *td, int sig, ksiginfo_t *si);
 void	sendsig(sig_t catcher, ksiginfo_t *ksi, sigset_t *retmask);
+void	sig_drop_caught(struct proc *p);
 struct sigacts *sigacts_alloc(void);
 void	sigacts_copy(struct sigacts *dest, struct sigacts *src);
 void	sigacts_free(struct sigacts *ps);
@@ -54,6 +54,25 @@ struct thread;
 
 #define	CTL_MAXNAME	24	/* largest number of components supported */
 
+/*
+ * Layout of the buffers for sysctl.getbatch, which resolves an array of
+ * MIBs in a single sysctl(2) call.  The new (input) buffer holds an array
+ * of struct sysctl_batch_ent.  The old (output) buffer is filled with one
+ * struct sysctl_batch_res per input entry, each followed by be_len bytes
+ * of data padded out to an 8 byte boundary.
+ */
+struct sysctl_batch_ent {
+	u_int	be_namelen;		/* number of MIB components */
+	int	be_name[CTL_MAXNAME];	/* the MIB itself */
+};
+
+struct sysctl_batch_res {
+	int	be_error;		/* errno for this entry, 0 if ok */
+	u_int	be_len;			/* length of the data that follows */
+};
+
+#define	SYSCTL_BATCH_PAD(len)	(((len) + 7) & ~(size_t)7)
+
 /*
  * Each subsystem defined by sysctl defines a list of variables
  * for that subsystem. Each name is either a node with further
@@ -939,6 +958,8 @@ TAILQ_HEAD(sysctl_ctx_list, sysctl_ctx_entry);
 #define	KERN_PROC_SIGTRAMP	41	/* signal trampoline location */
 #define	KERN_PROC_CWD		42	/* process current working directory */
 #define	KERN_PROC_NFDS		43	/* number of open file descriptors */
+#define	KERN_PROC_NUMA		44	/* NUMA page allocation counters */
+#define	KERN_PROC_SUPERPAGE	45	/* superpage mapping counters */
 
 /*
  * KERN_IPC identifiers
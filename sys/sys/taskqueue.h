@@ -200,6 +200,15 @@ TASKQUEUE_DECLARE(swi);
  */
 TASKQUEUE_DECLARE(thread);
 
+/*
+ * This queue is serviced by a pool of one kernel thread per CPU.  It is
+ * intended for deferred work that does not need a dedicated thread: a
+ * task that blocks in its handler only stalls one worker while the
+ * remaining workers keep servicing the queue.  To enqueue a task, call
+ * taskqueue_enqueue(taskqueue_pool, &task).
+ */
+TASKQUEUE_DECLARE(pool);
+
 /*
  * Queue for swi handlers dispatched from fast interrupt handlers.
  * These are necessarily different from the above because the queue
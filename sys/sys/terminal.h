@@ -147,6 +147,8 @@ typedef teken_rect_t term_rect_t;
 typedef void tc_cursor_t(struct terminal *tm, const term_pos_t *p);
 typedef void tc_putchar_t(struct terminal *tm, const term_pos_t *p,
     term_char_t c);
+typedef void tc_puttext_t(struct terminal *tm, const term_pos_t *p,
+    const term_char_t *s, unsigned int n);
 typedef void tc_fill_t(struct terminal *tm, const term_rect_t *r,
     term_char_t c);
 typedef void tc_copy_t(struct terminal *tm, const term_rect_t *r,
@@ -173,6 +175,8 @@ struct terminal_class {
 	/* Terminal emulator. */
 	tc_cursor_t	*tc_cursor;
 	tc_putchar_t	*tc_putchar;
+	/* Optional: draw a run of characters on one row; may be NULL. */
+	tc_puttext_t	*tc_puttext;
 	tc_fill_t	*tc_fill;
 	tc_copy_t	*tc_copy;
 	tc_pre_input_t	*tc_pre_input;
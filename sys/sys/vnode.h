@@ -37,6 +37,7 @@
 
 #include <sys/bufobj.h>
 #include <sys/queue.h>
+#include <sys/epoch.h>
 #include <sys/lock.h>
 #include <sys/lockmgr.h>
 #include <sys/mutex.h>
@@ -174,6 +175,7 @@ struct vnode {
 	u_int	v_hash;
 	enum	vtype v_type;			/* u vnode type */
 	struct uuid	v_uuid;			/* u per-vnode UUID */
+	struct epoch_context v_epoch_ctx;	/* deferred free via namecache epoch */
 };
 
 #endif /* defined(_KERNEL) || defined(_KVM_VNODE) */
@@ -604,6 +606,7 @@ typedef int (*vn_get_ino_t)(struct mount *, void *, int, struct vnode **);
 int	bnoreuselist(struct bufv *bufv, struct bufobj *bo, daddr_t startn,
 	    daddr_t endn);
 /* cache_* may belong in namei.h. */
+extern epoch_t vfs_cache_epoch;	/* protects lockless cache_lookup() */
 void	cache_changesize(int newhashsize);
 #define	cache_enter(dvp, vp, cnp)					\
 	cache_enter_time(dvp, vp, cnp, NULL, NULL)
@@ -612,6 +615,8 @@ void	cache_enter_time(struct vnode *dvp, struct vnode *vp,
 	    struct timespec *dtsp);
 int	cache_lookup(struct vnode *dvp, struct vnode **vpp,
 	    struct componentname *cnp, struct timespec *tsp, int *ticksp);
+int	cache_lookup_batch(struct vnode *dvp, struct vnode **vpp,
+	    struct componentname *cnp);
 void	cache_purge(struct vnode *vp);
 void	cache_purge_negative(struct vnode *vp);
 void	cache_purgevfs(struct mount *mp, bool force);
@@ -103,6 +103,18 @@ teken_funcs_putchar(const teken_t *t, const teken_pos_t *p, teken_char_t c,
 	t->t_funcs->tf_putchar(t->t_softc, p, c, a);
 }
 
+static inline void
+teken_funcs_puttext(const teken_t *t, const teken_pos_t *p,
+    const teken_char_t *s, unsigned int n, const teken_attr_t *a)
+{
+
+	teken_assert(p->tp_row < t->t_winsize.tp_row);
+	teken_assert(p->tp_col + n <= t->t_winsize.tp_col);
+
+	teken_assert(t->t_funcs->tf_puttext != NULL);
+	t->t_funcs->tf_puttext(t->t_softc, p, s, n, a);
+}
+
 static inline void
 teken_funcs_fill(const teken_t *t, const teken_rect_t *r,
     const teken_char_t c, const teken_attr_t *a)
@@ -303,14 +315,72 @@ teken_input_byte(teken_t *t, unsigned char c)
 	}
 }
 
+/*
+ * Fast path for runs of plain text.  When the terminal is in the ground
+ * state with no partial escape or UTF-8 sequence, insert mode disabled
+ * and the US-ASCII character set selected, printable ASCII characters
+ * occupy exactly one cell each and can be handed to the backend as a
+ * single span instead of one tf_putchar call per cell.  Runs are cut
+ * before the rightmost column, so the line wrapping logic only ever
+ * runs through the per-character path.  Returns the number of input
+ * bytes consumed; zero means the caller should use the slow path.
+ */
+static size_t
+teken_input_text(teken_t *t, const char *buf, size_t len)
+{
+	teken_char_t text[128];
+	teken_pos_t tp;
+	size_t n;
+	unsigned int avail, c;
+
+	if (t->t_nextstate != teken_state_init || t->t_utf8_left != 0 ||
+	    (t->t_stateflags & (TS_INSTRING | TS_INSERT)) != 0 ||
+	    t->t_scs[t->t_curscs] != teken_scs_us_ascii)
+		return (0);
+
+	/* Stay out of the rightmost column; it triggers wrapping. */
+	avail = t->t_winsize.tp_col - t->t_cursor.tp_col;
+	if (avail <= 1)
+		return (0);
+	avail--;
+	if (avail > sizeof(text) / sizeof(text[0]))
+		avail = sizeof(text) / sizeof(text[0]);
+
+	for (n = 0; n < len && n < avail; n++) {
+		c = (unsigned char)buf[n];
+		if (c < 0x20 || c > 0x7e)
+			break;
+		text[n] = c;
+	}
+	if (n < 2)
+		return (0);
+
+	tp = t->t_cursor;
+	teken_funcs_puttext(t, &tp, text, n, &t->t_curattr);
+	t->t_last = text[n - 1];
+	t->t_cursor.tp_col += n;
+	t->t_stateflags &= ~TS_WRAPPED;
+	teken_funcs_cursor(t);
+	return (n);
+}
+
 void
 teken_input(teken_t *t, const void *buf, size_t len)
 {
 	const char *c = buf;
+	size_t n;
 
 	teken_funcs_pre_input(t);
-	while (len-- > 0)
+	while (len > 0) {
+		if (t->t_funcs->tf_puttext != NULL &&
+		    (n = teken_input_text(t, c, len)) != 0) {
+			c += n;
+			len -= n;
+			continue;
+		}
 		teken_input_byte(t, *c++);
+		len--;
+	}
 	teken_funcs_post_input(t);
 }
 
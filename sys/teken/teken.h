@@ -90,6 +90,8 @@ typedef void tf_bell_t(void *);
 typedef void tf_cursor_t(void *, const teken_pos_t *);
 typedef void tf_putchar_t(void *, const teken_pos_t *, teken_char_t,
     const teken_attr_t *);
+typedef void tf_puttext_t(void *, const teken_pos_t *, const teken_char_t *,
+    unsigned int, const teken_attr_t *);
 typedef void tf_fill_t(void *, const teken_rect_t *, teken_char_t,
     const teken_attr_t *);
 typedef void tf_copy_t(void *, const teken_rect_t *, const teken_pos_t *);
@@ -114,6 +116,13 @@ typedef struct {
 	tf_bell_t	*tf_bell;
 	tf_cursor_t	*tf_cursor;
 	tf_putchar_t	*tf_putchar;
+	/*
+	 * Optional batched version of tf_putchar: draw a run of
+	 * single-width characters on one row, all with the same
+	 * attribute.  May be left NULL, in which case runs are drawn
+	 * through tf_putchar one cell at a time.
+	 */
+	tf_puttext_t	*tf_puttext;
 	tf_fill_t	*tf_fill;
 	tf_copy_t	*tf_copy;
 	tf_pre_input_t	*tf_pre_input;
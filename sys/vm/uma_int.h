@@ -207,6 +207,7 @@ typedef struct uma_bucket * uma_bucket_t;
 struct uma_cache {
 	uma_bucket_t	uc_freebucket;	/* Bucket we're freeing to */
 	uma_bucket_t	uc_allocbucket;	/* Bucket to allocate from */
+	uma_bucket_t	uc_sparebucket;	/* Full bucket staged for the zone */
 	uint64_t	uc_allocs;	/* Count of allocations */
 	uint64_t	uc_frees;	/* Count of frees */
 } UMA_ALIGN;
@@ -369,6 +370,10 @@ struct uma_zone {
 	volatile u_long	uz_fails;	/* Total number of alloc failures */
 	volatile u_long	uz_frees;	/* Total number of frees */
 	uint64_t	uz_sleeps;	/* Total number of alloc sleeps */
+	uint64_t	uz_amisses;	/* Allocs that missed the cpu cache */
+	uint64_t	uz_fmisses;	/* Frees that missed the cpu cache */
+	uint64_t	uz_lockfails;	/* Contended zone lock acquisitions */
+	uint64_t	uz_batches;	/* Two-bucket batched cache flushes */
 
 	/*
 	 * This HAS to be the last item because we adjust the zone size
@@ -135,6 +135,8 @@ static void _vm_map_init(vm_map_t map, pmap_t pmap, vm_offset_t min,
 static int vm_map_alignspace(vm_map_t map, vm_object_t object,
     vm_ooffset_t offset, vm_offset_t *addr, vm_size_t length,
     vm_offset_t max_addr, vm_offset_t alignment);
+static int vm_map_eager_superpage(vm_map_t map, vm_offset_t start,
+    vm_offset_t end);
 static void vm_map_entry_deallocate(vm_map_entry_t entry, boolean_t system_map);
 static void vm_map_entry_dispose(vm_map_t map, vm_map_entry_t entry);
 static void vm_map_entry_unwire(vm_map_t map, vm_map_entry_t entry);
@@ -299,6 +301,8 @@ vmspace_alloc(vm_offset_t min, vm_offset_t max, pmap_pinit_t pinit)
 	vm->vm_taddr = 0;
 	vm->vm_daddr = 0;
 	vm->vm_maxsaddr = 0;
+	vm->vm_superpage_promotions = 0;
+	vm->vm_superpage_demotions = 0;
 	return (vm);
 }
 
@@ -2192,6 +2196,30 @@ vm_map_protect(vm_map_t map, vm_offset_t start, vm_offset_t end,
 	return (KERN_SUCCESS);
 }
 
+/*
+ *	vm_map_eager_superpage:
+ *
+ *	Implements MADV_SUPERPAGE.  Fault in every base page of the given
+ *	range.  This fully populates any reservations backing the range,
+ *	which in turn allows the pmap to promote the mappings to superpages
+ *	instead of waiting for the application to touch each page itself.
+ *	The range should be superpage-aligned for full effect; partial
+ *	chunks are still populated but may not be promoted.
+ *
+ *	Individual fault failures (e.g. PROT_NONE entries or unmapped gaps
+ *	in the range) are not errors; the range is populated as well as
+ *	possible.  The map must not be locked on entry.
+ */
+static int
+vm_map_eager_superpage(vm_map_t map, vm_offset_t start, vm_offset_t end)
+{
+	vm_offset_t va;
+
+	for (va = start; va < end; va += PAGE_SIZE)
+		(void)vm_fault(map, va, VM_PROT_READ, VM_FAULT_NORMAL);
+	return (0);
+}
+
 /*
  *	vm_map_madvise:
  *
@@ -2237,6 +2265,10 @@ vm_map_madvise(
 		modify_map = false;
 		vm_map_lock_read(map);
 		break;
+	case MADV_SUPERPAGE:
+		if (start == end)
+			return (0);
+		return (vm_map_eager_superpage(map, start, end));
 	default:
 		return (EINVAL);
 	}
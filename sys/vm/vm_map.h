@@ -262,6 +262,8 @@ struct vmspace {
 	caddr_t vm_daddr;	/* (c) user virtual address of data */
 	caddr_t vm_maxsaddr;	/* user VA at max stack growth */
 	volatile int vm_refcnt;	/* number of references */
+	u_long vm_superpage_promotions;	/* superpage mappings created */
+	u_long vm_superpage_demotions;	/* superpage mappings broken up */
 	/*
 	 * Keep the PMAP last, so that CPU-specific variations of that
 	 * structure on a single architecture don't result in offset
@@ -1800,6 +1800,26 @@ vm_domain_allocate(struct vm_domain *vmd, int req, int npages)
 	return (1);
 }
 
+/*
+ * Charge an allocation from the given domain to the current thread as
+ * NUMA-local or NUMA-remote, depending on where the thread is running.
+ * The counters feed the kern.proc.numa sysctl so that the efficacy of
+ * domain placement policies can be judged per process.
+ */
+static void
+vm_page_alloc_numacnt(int domain, int npages)
+{
+	struct thread *td;
+
+	if (vm_ndomains <= 1)
+		return;
+	td = curthread;
+	if (domain == PCPU_GET(domain))
+		td->td_numa_local += npages;
+	else
+		td->td_numa_remote += npages;
+}
+
 vm_page_t
 vm_page_alloc_domain_after(vm_object_t object, vm_pindex_t pindex, int domain,
     int req, vm_page_t mpred)
@@ -1929,9 +1949,151 @@ found:
 	} else
 		m->pindex = pindex;
 
+	vm_page_alloc_numacnt(domain, 1);
 	return (m);
 }
 
+/*
+ *	vm_page_alloc_pages_after:
+ *
+ *	Allocate a run of "npages" pages into the given object starting at
+ *	"pindex", with "mpred" being the greatest resident page below the
+ *	range, which must be unpopulated.  The run is reserved from the
+ *	per-domain free queues with a single free-queue lock acquisition
+ *	instead of one per page; any physical contiguity is incidental and
+ *	not guaranteed.  Objects entitled to reservations are served by
+ *	the single page allocator so that superpage formation is not
+ *	bypassed.  Returns the number of pages allocated, which may be any
+ *	prefix of the run, including zero.
+ *
+ *	The object must be locked.
+ */
+int
+vm_page_alloc_pages_after(vm_object_t object, vm_pindex_t pindex, int req,
+    vm_page_t *ma, int npages, vm_page_t mpred)
+{
+	struct vm_domainset_iter di;
+	struct vm_domain *vmd;
+	vm_page_t m;
+	int domain, flags, i, j, n;
+
+	KASSERT(object != NULL && (req & VM_ALLOC_NOOBJ) == 0,
+	    ("vm_page_alloc_pages_after: missing object or NOOBJ"));
+	KASSERT((req & (VM_ALLOC_NOBUSY | VM_ALLOC_SBUSY)) !=
+	    (VM_ALLOC_NOBUSY | VM_ALLOC_SBUSY),
+	    ("vm_page_alloc_pages_after: inconsistent req %x", req));
+	KASSERT(((u_int)req >> VM_ALLOC_COUNT_SHIFT) == 0,
+	    ("vm_page_alloc_pages_after: VM_ALLOC_COUNT() is not allowed"));
+	KASSERT(npages > 0,
+	    ("vm_page_alloc_pages_after: npages is zero"));
+	KASSERT(mpred == NULL || mpred->pindex < pindex,
+	    ("mpred %p doesn't precede pindex 0x%jx", mpred,
+	    (uintmax_t)pindex));
+	VM_OBJECT_ASSERT_WLOCKED(object);
+
+	i = 0;
+#if VM_NRESERVLEVEL > 0
+	if (vm_object_reserv(object))
+		goto single;
+#endif
+	vm_domainset_iter_page_init(&di, object, pindex, &domain, &req);
+	do {
+		vmd = VM_DOMAIN(domain);
+		n = 0;
+		if (vm_domain_allocate(vmd, req, npages - i)) {
+			vm_domain_free_lock(vmd);
+			n = vm_phys_alloc_npages(domain, VM_FREEPOOL_DEFAULT,
+			    npages - i, &ma[i]);
+			vm_domain_free_unlock(vmd);
+			if (n < npages - i)
+				vm_domain_freecnt_inc(vmd, npages - i - n);
+		}
+		if (n > 0)
+			vm_page_alloc_numacnt(domain, n);
+		for (; n > 0; n--, i++) {
+			m = ma[i];
+			vm_page_dequeue(m);
+			vm_page_alloc_check(m);
+
+			/*
+			 * Initialize the page as vm_page_alloc_domain_after()
+			 * does.  Only the PG_ZERO flag is inherited.
+			 */
+			flags = 0;
+			if ((req & VM_ALLOC_ZERO) != 0)
+				flags = PG_ZERO;
+			flags &= m->flags;
+			if ((req & VM_ALLOC_NODUMP) != 0)
+				flags |= PG_NODUMP;
+			m->flags = flags;
+			m->aflags = 0;
+			m->oflags = (object->flags & OBJ_UNMANAGED) != 0 ?
+			    VPO_UNMANAGED : 0;
+			m->busy_lock = VPB_UNBUSIED;
+			if ((req & (VM_ALLOC_NOBUSY | VM_ALLOC_SBUSY)) == 0)
+				m->busy_lock = VPB_SINGLE_EXCLUSIVER;
+			if ((req & VM_ALLOC_SBUSY) != 0)
+				m->busy_lock = VPB_SHARERS_WORD(1);
+			if (req & VM_ALLOC_WIRED) {
+				vm_wire_add(1);
+				m->wire_count = 1;
+			}
+			m->act_count = 0;
+
+			if (vm_page_insert_after(m, object, pindex + i,
+			    mpred)) {
+				/*
+				 * Undo this page and hand the untouched
+				 * remainder of the batch straight back to
+				 * the free queues.
+				 */
+				if (req & VM_ALLOC_WIRED) {
+					vm_wire_sub(1);
+					m->wire_count = 0;
+				}
+				m->oflags = VPO_UNMANAGED;
+				m->busy_lock = VPB_UNBUSIED;
+				/* Don't change PG_ZERO. */
+				vm_page_free_toq(m);
+				if (n > 1) {
+					vm_domain_free_lock(vmd);
+					for (j = 1; j < n; j++)
+						vm_phys_free_pages(ma[i + j],
+						    0);
+					vm_domain_free_unlock(vmd);
+					vm_domain_freecnt_inc(vmd, n - 1);
+				}
+				if (i > 0)
+					return (i);
+				goto single;
+			}
+
+			/* Ignore device objects; the pager sets "memattr". */
+			if (object->memattr != VM_MEMATTR_DEFAULT &&
+			    (object->flags & OBJ_FICTITIOUS) == 0)
+				pmap_page_set_memattr(m, object->memattr);
+			mpred = m;
+		}
+	} while (i < npages &&
+	    vm_domainset_iter_page(&di, object, &domain) == 0);
+	if (i > 0)
+		return (i);
+
+	/*
+	 * The batched attempt found no pages; let the single page
+	 * allocator apply the request's sleeping and retry policies.
+	 */
+single:
+	for (; i < npages; i++) {
+		m = vm_page_alloc_after(object, pindex + i,
+		    req | VM_ALLOC_COUNT(npages - i), mpred);
+		if (m == NULL)
+			break;
+		ma[i] = mpred = m;
+	}
+	return (i);
+}
+
 /*
  *	vm_page_alloc_contig:
  *
@@ -2069,6 +2231,7 @@ again:
 #if VM_NRESERVLEVEL > 0
 found:
 #endif
+	vm_page_alloc_numacnt(domain, npages);
 	for (m = m_ret; m < &m_ret[npages]; m++) {
 		vm_page_dequeue(m);
 		vm_page_alloc_check(m);
@@ -3928,9 +4091,9 @@ int
 vm_page_grab_pages(vm_object_t object, vm_pindex_t pindex, int allocflags,
     vm_page_t *ma, int count)
 {
-	vm_page_t m, mpred;
+	vm_page_t m, mnext, mpred;
 	int pflags;
-	int i;
+	int i, n, run;
 	bool sleep;
 
 	VM_OBJECT_ASSERT_WLOCKED(object);
@@ -3987,13 +4150,34 @@ retrylookup:
 			if ((allocflags & VM_ALLOC_SBUSY) != 0)
 				vm_page_sbusy(m);
 		} else {
-			m = vm_page_alloc_after(object, pindex + i,
-			    pflags | VM_ALLOC_COUNT(count - i), mpred);
-			if (m == NULL) {
+			/*
+			 * Batch the allocation of the run of absent pages
+			 * ending at the next resident page, if any.
+			 */
+			mnext = mpred != NULL ? TAILQ_NEXT(mpred, listq) :
+			    TAILQ_FIRST(&object->memq);
+			run = count - i;
+			if (mnext != NULL &&
+			    mnext->pindex - (pindex + i) < (vm_pindex_t)run)
+				run = mnext->pindex - (pindex + i);
+			n = vm_page_alloc_pages_after(object, pindex + i,
+			    pflags, &ma[i], run, mpred);
+			if (n == 0) {
 				if ((allocflags & VM_ALLOC_NOWAIT) != 0)
 					break;
 				goto retrylookup;
 			}
+			for (; n > 1; n--, i++) {
+				m = ma[i];
+				if (m->valid == 0 &&
+				    (allocflags & VM_ALLOC_ZERO) != 0) {
+					if ((m->flags & PG_ZERO) == 0)
+						pmap_zero_page(m);
+					m->valid = VM_PAGE_BITS_ALL;
+				}
+				mpred = m;
+			}
+			m = ma[i];
 		}
 		if (m->valid == 0 && (allocflags & VM_ALLOC_ZERO) != 0) {
 			if ((m->flags & PG_ZERO) == 0)
@@ -91,6 +91,7 @@ __FBSDID("$FreeBSD$");
 #include <sys/mount.h>
 #include <sys/racct.h>
 #include <sys/resourcevar.h>
+#include <sys/sbuf.h>
 #include <sys/sched.h>
 #include <sys/sdt.h>
 #include <sys/signalvar.h>
@@ -167,6 +168,11 @@ SYSCTL_INT(_vm, OID_AUTO, pageout_update_period,
 SYSCTL_INT(_vm, OID_AUTO, lowmem_period, CTLFLAG_RWTUN, &lowmem_period, 0,
 	"Low memory callback period");
 
+static int vm_pageout_scan_cap;
+SYSCTL_INT(_vm, OID_AUTO, pageout_scan_cap,
+	CTLFLAG_RWTUN, &vm_pageout_scan_cap, 0,
+	"Maximum inactive scan target per page daemon wakeup (0 for no cap)");
+
 SYSCTL_INT(_vm, OID_AUTO, disable_swapspace_pageouts,
 	CTLFLAG_RWTUN, &disable_swap_pageouts, 0, "Disallow swapout of dirty pages");
 
@@ -1882,10 +1888,24 @@ vm_pageout_lowmem(void)
 	return (false);
 }
 
+/*
+ * Histogram bucket for the pageout telemetry: bucket n counts values in
+ * [2^n, 2^(n+1)), with the first and last buckets absorbing the extremes.
+ */
+static int
+vm_pageout_hist_bucket(uint64_t val)
+{
+	int bucket;
+
+	bucket = val != 0 ? flsll(val) - 1 : 0;
+	return (bucket < VM_PAGEOUT_NHIST ? bucket : VM_PAGEOUT_NHIST - 1);
+}
+
 static void
 vm_pageout_worker(void *arg)
 {
 	struct vm_domain *vmd;
+	sbintime_t scanstart;
 	u_int ofree;
 	int addl_shortage, domain, shortage;
 	bool target_met;
@@ -1950,13 +1970,31 @@ vm_pageout_worker(void *arg)
 		 * difference from the inactive queue scan target.
 		 */
 		shortage = pidctrl_daemon(&vmd->vmd_pid, vmd->vmd_free_count);
+
+		/*
+		 * Pace the reclaim by capping each pass, spreading a large
+		 * shortfall over several wakeups instead of freezing other
+		 * memory users with one long scan.  The controller keeps
+		 * requesting pages until the target is met, so deferred
+		 * work is not lost.
+		 */
+		if (vm_pageout_scan_cap > 0 &&
+		    shortage > vm_pageout_scan_cap)
+			shortage = vm_pageout_scan_cap;
 		if (shortage > 0) {
 			ofree = vmd->vmd_free_count;
 			if (vm_pageout_lowmem() && vmd->vmd_free_count > ofree)
 				shortage -= min(vmd->vmd_free_count - ofree,
 				    (u_int)shortage);
+			scanstart = sbinuptime();
 			target_met = vm_pageout_scan_inactive(vmd, shortage,
 			    &addl_shortage);
+			vmd->vmd_scanlat_hist[vm_pageout_hist_bucket(
+			    (uint64_t)(sbinuptime() - scanstart) * 1000 >>
+			    32)]++;
+			vmd->vmd_reclaim_hist[vm_pageout_hist_bucket(
+			    vmd->vmd_free_count > ofree ?
+			    vmd->vmd_free_count - ofree : 0)]++;
 		} else
 			addl_shortage = 0;
 
@@ -1970,6 +2008,30 @@ vm_pageout_worker(void *arg)
 	}
 }
 
+/*
+ * Dump a per-domain pageout histogram as a line of space-separated
+ * power-of-two bucket counts.
+ */
+static int
+sysctl_pageout_hist(SYSCTL_HANDLER_ARGS)
+{
+	struct sbuf sbuf;
+	uint64_t *hist;
+	char buf[VM_PAGEOUT_NHIST * 24];
+	int error, i;
+
+	hist = arg1;
+	sbuf_new(&sbuf, buf, sizeof(buf), SBUF_FIXEDLEN | SBUF_INCLUDENUL);
+	for (i = 0; i < VM_PAGEOUT_NHIST; i++)
+		sbuf_printf(&sbuf, "%s%ju", i == 0 ? "" : " ",
+		    (uintmax_t)hist[i]);
+	error = sbuf_finish(&sbuf);
+	if (error == 0)
+		error = SYSCTL_OUT(req, sbuf_data(&sbuf), sbuf_len(&sbuf));
+	sbuf_delete(&sbuf);
+	return (error);
+}
+
 /*
  *	vm_pageout_init initialises basic pageout daemon settings.
  */
@@ -2024,6 +2086,14 @@ vm_pageout_init_domain(int domain)
 	oid = SYSCTL_ADD_NODE(NULL, SYSCTL_CHILDREN(vmd->vmd_oid), OID_AUTO,
 	    "pidctrl", CTLFLAG_RD, NULL, "");
 	pidctrl_init_sysctl(&vmd->vmd_pid, SYSCTL_CHILDREN(oid));
+	SYSCTL_ADD_PROC(NULL, SYSCTL_CHILDREN(vmd->vmd_oid), OID_AUTO,
+	    "scan_latency_hist", CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE,
+	    vmd->vmd_scanlat_hist, 0, sysctl_pageout_hist, "A",
+	    "Histogram of inactive scan latencies (log2 milliseconds)");
+	SYSCTL_ADD_PROC(NULL, SYSCTL_CHILDREN(vmd->vmd_oid), OID_AUTO,
+	    "reclaim_hist", CTLTYPE_STRING | CTLFLAG_RD | CTLFLAG_MPSAFE,
+	    vmd->vmd_reclaim_hist, 0, sysctl_pageout_hist, "A",
+	    "Histogram of pages reclaimed per page daemon wakeup (log2)");
 }
 
 static void
@@ -118,6 +118,15 @@ struct vm_domain {
 	boolean_t vmd_oom;
 	int vmd_oom_seq;
 	int vmd_last_active_scan;
+	/*
+	 * Pageout pacing telemetry, maintained by the page daemon worker:
+	 * power of two histograms of inactive scan latency (bucket n counts
+	 * scans of [2^n, 2^(n+1)) milliseconds) and of pages freed per
+	 * wakeup.
+	 */
+#define	VM_PAGEOUT_NHIST	16
+	uint64_t vmd_scanlat_hist[VM_PAGEOUT_NHIST];
+	uint64_t vmd_reclaim_hist[VM_PAGEOUT_NHIST];
 	struct vm_page vmd_markers[PQ_COUNT]; /* (q) markers for queue scans */
 	struct vm_page vmd_inacthead; /* marker for LRU-defeating insertions */
 	struct vm_page vmd_clock[2]; /* markers for active queue scan */
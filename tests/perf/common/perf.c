@@ -0,0 +1,167 @@
+/*-
+ * SPDX-License-Identifier: BSD-2-Clause-FreeBSD
+ *
+ * Copyright (c) 2026 The FreeBSD Foundation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+
+#include <err.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "perf.h"
+
+/* Wall-clock budget per sample and number of samples kept. */
+#define	PERF_SAMPLE_NSEC	200000000ULL
+#define	PERF_NSAMPLES		7
+
+static int perf_failed;
+
+static uint64_t
+perf_now(void)
+{
+	struct timespec ts;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+		err(1, "clock_gettime");
+	return ((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+static int
+perf_cmp(const void *a, const void *b)
+{
+	double da = *(const double *)a, db = *(const double *)b;
+
+	return ((da > db) - (da < db));
+}
+
+/*
+ * Look the benchmark up in $PERF_BASELINE and flag a regression when it
+ * is more than $PERF_TOLERANCE percent slower than the recorded value.
+ */
+static void
+perf_check_baseline(const char *name, double ns_per_op)
+{
+	FILE *fp;
+	char *line, *p;
+	const char *file;
+	size_t linecap;
+	double base, tolerance;
+
+	if ((file = getenv("PERF_BASELINE")) == NULL)
+		return;
+	tolerance = 10.0;
+	if ((p = getenv("PERF_TOLERANCE")) != NULL)
+		tolerance = strtod(p, NULL);
+	if ((fp = fopen(file, "r")) == NULL)
+		err(1, "%s", file);
+	line = NULL;
+	linecap = 0;
+	while (getline(&line, &linecap, fp) > 0) {
+		p = strchr(line, ' ');
+		if (p == NULL)
+			continue;
+		*p++ = '\0';
+		if (strcmp(line, name) != 0)
+			continue;
+		base = strtod(p, NULL);
+		if (base > 0 && ns_per_op > base * (1.0 + tolerance / 100.0)) {
+			printf("perf: %s REGRESSION ns_per_op=%.1f "
+			    "baseline=%.1f tolerance_pct=%.1f\n",
+			    name, ns_per_op, base, tolerance);
+			perf_failed = 1;
+		}
+		break;
+	}
+	free(line);
+	fclose(fp);
+}
+
+void
+perf_run(const char *name, perf_fn *fn, void *arg)
+{
+	double samples[PERF_NSAMPLES];
+	double mean, median, stddev;
+	uint64_t bytes, elapsed, niter;
+	int i;
+
+	/*
+	 * Grow the iteration count until a run is long enough to trust
+	 * the clock, then scale it to the per-sample budget.
+	 */
+	niter = 1;
+	for (;;) {
+		elapsed = perf_now();
+		(void)fn(arg, niter);
+		elapsed = perf_now() - elapsed;
+		if (elapsed >= PERF_SAMPLE_NSEC / 10)
+			break;
+		niter *= 10;
+	}
+	if (elapsed < PERF_SAMPLE_NSEC)
+		niter = niter * PERF_SAMPLE_NSEC / (elapsed + 1) + 1;
+
+	/* Warmup pass, then the measured samples. */
+	bytes = fn(arg, niter);
+	for (i = 0; i < PERF_NSAMPLES; i++) {
+		elapsed = perf_now();
+		bytes = fn(arg, niter);
+		elapsed = perf_now() - elapsed;
+		samples[i] = (double)elapsed / niter;
+	}
+
+	qsort(samples, PERF_NSAMPLES, sizeof(samples[0]), perf_cmp);
+	median = samples[PERF_NSAMPLES / 2];
+	mean = 0;
+	for (i = 0; i < PERF_NSAMPLES; i++)
+		mean += samples[i];
+	mean /= PERF_NSAMPLES;
+	stddev = 0;
+	for (i = 0; i < PERF_NSAMPLES; i++)
+		stddev += (samples[i] - mean) * (samples[i] - mean);
+	stddev = sqrt(stddev / PERF_NSAMPLES);
+
+	printf("perf: %s ns_per_op=%.1f stddev_pct=%.1f ops_per_sec=%.0f",
+	    name, median, mean > 0 ? stddev * 100.0 / mean : 0.0,
+	    median > 0 ? 1e9 / median : 0.0);
+	if (bytes != 0)
+		printf(" mb_per_sec=%.1f",
+		    (double)bytes / 1048576.0 * 1e9 / (median * niter));
+	printf("\n");
+	fflush(stdout);
+
+	perf_check_baseline(name, median);
+}
+
+int
+perf_exit(void)
+{
+
+	return (perf_failed);
+}
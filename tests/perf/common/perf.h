@@ -0,0 +1,58 @@
+/*-
+ * SPDX-License-Identifier: BSD-2-Clause-FreeBSD
+ *
+ * Copyright (c) 2026 The FreeBSD Foundation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+#ifndef _PERF_H_
+#define	_PERF_H_
+
+#include <stdint.h>
+
+/*
+ * Tiny harness for the benchmarks under tests/perf.
+ *
+ * A benchmark body runs niter iterations of the measured operation and
+ * returns the number of bytes it processed (0 when a byte rate makes no
+ * sense).  perf_run() calibrates niter to a fixed wall-clock budget,
+ * discards a warmup pass, takes several samples and prints one
+ * machine-readable line per benchmark:
+ *
+ *	perf: <name> ns_per_op=<median> stddev_pct=<p> ops_per_sec=<r>
+ *	    [mb_per_sec=<m>]
+ *
+ * When PERF_BASELINE names a file of "<name> <ns_per_op>" lines, each
+ * result is compared against it and perf_exit() fails the test if any
+ * benchmark regressed by more than PERF_TOLERANCE percent (10 by
+ * default), which is what lets kyua gate on performance.
+ */
+
+typedef uint64_t perf_fn(void *arg, uint64_t niter);
+
+void	perf_run(const char *name, perf_fn *fn, void *arg);
+int	perf_exit(void);
+
+#endif /* !_PERF_H_ */
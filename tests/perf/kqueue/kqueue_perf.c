@@ -0,0 +1,90 @@
+/*-
+ * SPDX-License-Identifier: BSD-2-Clause-FreeBSD
+ *
+ * Copyright (c) 2026 The FreeBSD Foundation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+
+#include <sys/event.h>
+#include <sys/time.h>
+
+#include <err.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "perf.h"
+
+/*
+ * kqueue dispatch scaling: time a single trigger/collect round trip on
+ * a queue holding 1, 256 and 4096 registered EVFILT_USER events, to
+ * catch regressions that scale with the size of the registration table.
+ */
+
+static uint64_t
+bench_dispatch(void *arg, uint64_t niter)
+{
+	struct kevent kev;
+	int kq = *(int *)arg;
+	uint64_t i;
+
+	for (i = 0; i < niter; i++) {
+		EV_SET(&kev, 0, EVFILT_USER, 0, NOTE_TRIGGER, 0, NULL);
+		if (kevent(kq, &kev, 1, NULL, 0, NULL) != 0)
+			err(1, "kevent trigger");
+		if (kevent(kq, NULL, 0, &kev, 1, NULL) != 1)
+			err(1, "kevent collect");
+	}
+	return (0);
+}
+
+static void
+run_one(const char *name, int nevents)
+{
+	struct kevent kev;
+	int i, kq;
+
+	kq = kqueue();
+	if (kq == -1)
+		err(1, "kqueue");
+	for (i = 0; i < nevents; i++) {
+		EV_SET(&kev, i, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, NULL);
+		if (kevent(kq, &kev, 1, NULL, 0, NULL) != 0)
+			err(1, "kevent register");
+	}
+	perf_run(name, bench_dispatch, &kq);
+	close(kq);
+}
+
+int
+main(void)
+{
+
+	run_one("kqueue_dispatch_1", 1);
+	run_one("kqueue_dispatch_256", 256);
+	run_one("kqueue_dispatch_4096", 4096);
+
+	return (perf_exit());
+}
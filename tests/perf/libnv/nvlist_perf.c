@@ -0,0 +1,145 @@
+/*-
+ * SPDX-License-Identifier: BSD-2-Clause-FreeBSD
+ *
+ * Copyright (c) 2026 The FreeBSD Foundation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+
+#include <sys/nv.h>
+
+#include <err.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "perf.h"
+
+/*
+ * libnv pack/unpack rates for a typical mixed nvlist: 16 numbers,
+ * 4 strings and a nested list, roughly what Casper services and
+ * libcasper consumers ship around.
+ */
+
+struct packed {
+	void	*buf;
+	size_t	 size;
+};
+
+static nvlist_t *
+build_nvlist(void)
+{
+	nvlist_t *nvl, *child;
+	char name[16];
+	int i;
+
+	nvl = nvlist_create(0);
+	if (nvl == NULL)
+		err(1, "nvlist_create");
+	for (i = 0; i < 16; i++) {
+		snprintf(name, sizeof(name), "number%d", i);
+		nvlist_add_number(nvl, name, (uint64_t)i * 7919);
+	}
+	for (i = 0; i < 4; i++) {
+		snprintf(name, sizeof(name), "string%d", i);
+		nvlist_add_string(nvl, name,
+		    "a typical short configuration string");
+	}
+	child = nvlist_create(0);
+	if (child == NULL)
+		err(1, "nvlist_create");
+	nvlist_add_number(child, "nested", 1);
+	nvlist_move_nvlist(nvl, "child", child);
+	if (nvlist_error(nvl) != 0)
+		errx(1, "building nvlist failed");
+	return (nvl);
+}
+
+static uint64_t
+bench_pack(void *arg, uint64_t niter)
+{
+	nvlist_t *nvl = arg;
+	void *buf;
+	size_t size;
+	uint64_t bytes, i;
+
+	bytes = 0;
+	for (i = 0; i < niter; i++) {
+		buf = nvlist_pack(nvl, &size);
+		if (buf == NULL)
+			err(1, "nvlist_pack");
+		bytes += size;
+		free(buf);
+	}
+	return (bytes);
+}
+
+static uint64_t
+bench_unpack(void *arg, uint64_t niter)
+{
+	struct packed *pk = arg;
+	nvlist_t *nvl;
+	uint64_t i;
+
+	for (i = 0; i < niter; i++) {
+		nvl = nvlist_unpack(pk->buf, pk->size, 0);
+		if (nvl == NULL)
+			err(1, "nvlist_unpack");
+		nvlist_destroy(nvl);
+	}
+	return (niter * pk->size);
+}
+
+static uint64_t
+bench_create_destroy(void *arg __unused, uint64_t niter)
+{
+	nvlist_t *nvl;
+	uint64_t i;
+
+	for (i = 0; i < niter; i++) {
+		nvl = build_nvlist();
+		nvlist_destroy(nvl);
+	}
+	return (0);
+}
+
+int
+main(void)
+{
+	struct packed pk;
+	nvlist_t *nvl;
+
+	nvl = build_nvlist();
+	pk.buf = nvlist_pack(nvl, &pk.size);
+	if (pk.buf == NULL)
+		err(1, "nvlist_pack");
+
+	perf_run("nvlist_pack", bench_pack, nvl);
+	perf_run("nvlist_unpack", bench_unpack, &pk);
+	perf_run("nvlist_create_destroy", bench_create_destroy, NULL);
+
+	free(pk.buf);
+	nvlist_destroy(nvl);
+	return (perf_exit());
+}
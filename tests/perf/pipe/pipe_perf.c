@@ -0,0 +1,120 @@
+/*-
+ * SPDX-License-Identifier: BSD-2-Clause-FreeBSD
+ *
+ * Copyright (c) 2026 The FreeBSD Foundation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#include <err.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "perf.h"
+
+/*
+ * Bulk throughput over a pipe and a UNIX stream socketpair: a forked
+ * child drains the read side while the benchmark writes 8 KiB blocks.
+ */
+
+#define	BLOCKSIZE	8192
+
+static char block[BLOCKSIZE];
+
+/* Fork a child that drains rfd until EOF; the parent keeps wfd. */
+static pid_t
+start_drain(int rfd, int wfd)
+{
+	char buf[BLOCKSIZE];
+	ssize_t n;
+	pid_t pid;
+
+	pid = fork();
+	if (pid == -1)
+		err(1, "fork");
+	if (pid == 0) {
+		close(wfd);
+		do {
+			n = read(rfd, buf, sizeof(buf));
+		} while (n > 0);
+		_exit(n == 0 ? 0 : 1);
+	}
+	close(rfd);
+	return (pid);
+}
+
+static uint64_t
+bench_write(void *arg, uint64_t niter)
+{
+	int wfd = *(int *)arg;
+	ssize_t n;
+	uint64_t i;
+
+	for (i = 0; i < niter; i++) {
+		n = write(wfd, block, sizeof(block));
+		if (n != sizeof(block))
+			err(1, "write");
+	}
+	return (niter * sizeof(block));
+}
+
+static void
+run_one(const char *name, int rfd, int wfd)
+{
+	pid_t pid;
+	int status;
+
+	pid = start_drain(rfd, wfd);
+	perf_run(name, bench_write, &wfd);
+	close(wfd);
+	if (waitpid(pid, &status, 0) != pid)
+		err(1, "waitpid");
+	if (status != 0)
+		errx(1, "%s: drain child failed", name);
+}
+
+int
+main(void)
+{
+	int fd[2];
+
+	signal(SIGPIPE, SIG_DFL);
+	memset(block, 'x', sizeof(block));
+
+	if (pipe(fd) != 0)
+		err(1, "pipe");
+	run_one("pipe_write_8192", fd[0], fd[1]);
+
+	if (socketpair(PF_LOCAL, SOCK_STREAM, 0, fd) != 0)
+		err(1, "socketpair");
+	run_one("socketpair_write_8192", fd[0], fd[1]);
+
+	return (perf_exit());
+}
@@ -0,0 +1,106 @@
+/*-
+ * SPDX-License-Identifier: BSD-2-Clause-FreeBSD
+ *
+ * Copyright (c) 2026 The FreeBSD Foundation
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "perf.h"
+
+/*
+ * libc string/memory primitives at a small (cache line scale) and a
+ * large (page scale) size, the two regimes where their implementations
+ * take different paths.
+ */
+
+#define	SMALL	64
+#define	LARGE	8192
+
+static char src[LARGE + 1], dst[LARGE + 1];
+
+struct op {
+	const char	*name;
+	size_t		 len;
+};
+
+static volatile size_t sink;
+
+static uint64_t
+bench_memcpy(void *arg, uint64_t niter)
+{
+	struct op *op = arg;
+	uint64_t i;
+
+	for (i = 0; i < niter; i++)
+		memcpy(dst, src, op->len);
+	return (niter * op->len);
+}
+
+static uint64_t
+bench_memset(void *arg, uint64_t niter)
+{
+	struct op *op = arg;
+	uint64_t i;
+
+	for (i = 0; i < niter; i++)
+		memset(dst, i & 0xff, op->len);
+	return (niter * op->len);
+}
+
+static uint64_t
+bench_strlen(void *arg, uint64_t niter)
+{
+	struct op *op = arg;
+	uint64_t i;
+
+	src[op->len] = '\0';
+	for (i = 0; i < niter; i++)
+		sink = strlen(src);
+	src[op->len] = 'x';
+	return (niter * op->len);
+}
+
+int
+main(void)
+{
+	struct op small = { "small", SMALL };
+	struct op large = { "large", LARGE };
+
+	memset(src, 'x', LARGE);
+	src[LARGE] = '\0';
+
+	perf_run("memcpy_64", bench_memcpy, &small);
+	perf_run("memcpy_8192", bench_memcpy, &large);
+	perf_run("memset_64", bench_memset, &small);
+	perf_run("memset_8192", bench_memset, &large);
+	perf_run("strlen_64", bench_strlen, &small);
+	perf_run("strlen_8192", bench_strlen, &large);
+
+	return (perf_exit());
+}
@@ -0,0 +1,147 @@
+#!/bin/sh
+# $FreeBSD$
+#
+# Content-addressed compiler cache.  Install symlinks to this script,
+# named after the compilers to wrap, in a directory early in $PATH;
+# building with WITH_OBJCACHE does so under ${WORLDTMP}/objcache.
+#
+# A compilation is keyed by the compiler's version banner, the command
+# line and the preprocessed source, so identical objects are shared
+# between object trees and branches no matter where the sources live.
+# Two backends are consulted:
+#
+#   OBJCACHE_DIR	local cache directory ($HOME/.objcache by default)
+#   OBJCACHE_REMOTE	optional base URL of a read-only network cache;
+#			hits are copied into OBJCACHE_DIR.  Publish the
+#			OBJCACHE_DIR of a build host over HTTP to share
+#			objects across a cluster.
+#
+# Anything that is not a plain "-c ... -o file.o" compilation of a
+# single source file is passed through to the real compiler untouched.
+# Dependency files requested with -MD/-MF are written by the
+# preprocessor run, so .depend tracking and META_MODE stay accurate on
+# cache hits.
+
+OBJCACHE_DIR="${OBJCACHE_DIR:-${HOME}/.objcache}"
+
+progname="${0##*/}"
+wrapperdir=$(dirname "$0")
+
+# Find the real compiler: the next $progname in $PATH outside of the
+# wrapper directory.
+real=
+oldifs="${IFS}"
+IFS=:
+for dir in ${PATH}; do
+	[ "${dir}" = "${wrapperdir}" ] && continue
+	if [ -x "${dir}/${progname}" ]; then
+		real="${dir}/${progname}"
+		break
+	fi
+done
+IFS="${oldifs}"
+if [ -z "${real}" ]; then
+	echo "objcache: ${progname}: real compiler not found in \$PATH" >&2
+	exit 1
+fi
+
+digest()
+{
+	if command -v sha256 >/dev/null 2>&1; then
+		sha256 -q "$1"
+	else
+		sha256sum "$1" | cut -d' ' -f1
+	fi
+}
+
+# Decide whether this invocation is cacheable and collect the argument
+# list with -c and "-o output" stripped, for reuse as the preprocessor
+# command line.
+compile=0
+out=
+src=
+cacheable=1
+grab_out=
+ppargs=
+for arg; do
+	if [ -n "${grab_out}" ]; then
+		out="${arg}"
+		grab_out=
+		continue
+	fi
+	case "${arg}" in
+	-c)
+		compile=1
+		continue
+		;;
+	-o)
+		grab_out=1
+		continue
+		;;
+	-E|-S|-fsyntax-only|-)
+		cacheable=0
+		;;
+	-*)
+		;;
+	*.c|*.cc|*.cpp|*.cxx|*.C|*.m|*.S)
+		if [ -n "${src}" ]; then
+			cacheable=0
+		else
+			src="${arg}"
+		fi
+		;;
+	esac
+	ppargs="${ppargs} '$(printf %s "${arg}" | sed "s/'/'\\\\''/g")'"
+done
+
+if [ "${compile}" -ne 1 ] || [ -z "${out}" ] || [ -z "${src}" ] || \
+    [ "${cacheable}" -ne 1 ]; then
+	exec "${real}" "$@"
+fi
+
+tmppp=$(mktemp "${TMPDIR:-/tmp}/objcache.pp.XXXXXXXX") || exec "${real}" "$@"
+trap 'rm -f "${tmppp}" ${tmpkey:+"${tmpkey}"} ${tmpobj:+"${tmpobj}"}' EXIT
+
+# Preprocess.  This also writes any -MD/-MF dependency file.  If the
+# preprocessor fails, hand the original command to the real compiler so
+# the user sees its diagnostics.
+if ! eval "'${real}' -E ${ppargs} -o '${tmppp}'" 2>/dev/null; then
+	exec "${real}" "$@"
+fi
+
+tmpkey=$(mktemp "${TMPDIR:-/tmp}/objcache.key.XXXXXXXX") || exec "${real}" "$@"
+{
+	"${real}" --version 2>/dev/null
+	printf '%s\n' "${progname}" "$@"
+	cat "${tmppp}"
+} > "${tmpkey}"
+hash=$(digest "${tmpkey}") || exec "${real}" "$@"
+cached="${OBJCACHE_DIR}/$(printf %.2s "${hash}")/${hash}.o"
+
+if [ -f "${cached}" ]; then
+	cp "${cached}" "${out}"
+	exit 0
+fi
+
+if [ -n "${OBJCACHE_REMOTE}" ]; then
+	tmpobj=$(mktemp "${TMPDIR:-/tmp}/objcache.obj.XXXXXXXX")
+	if [ -n "${tmpobj}" ] && \
+	    fetch -q -o "${tmpobj}" \
+	    "${OBJCACHE_REMOTE}/$(printf %.2s "${hash}")/${hash}.o" \
+	    2>/dev/null; then
+		mkdir -p "${cached%/*}"
+		cp "${tmpobj}" "${cached}" 2>/dev/null
+		cp "${tmpobj}" "${out}"
+		exit 0
+	fi
+fi
+
+# Miss: compile for real and store the result.  The temporary file and
+# rename keep concurrent builds from reading a partial object.
+"${real}" "$@" || exit $?
+if mkdir -p "${cached%/*}" 2>/dev/null; then
+	tmpobj=$(mktemp "${cached%/*}/objcache.XXXXXX") &&
+	    cp "${out}" "${tmpobj}" 2>/dev/null &&
+	    mv "${tmpobj}" "${cached}" 2>/dev/null
+fi
+exit 0
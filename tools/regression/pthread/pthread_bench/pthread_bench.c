@@ -0,0 +1,460 @@
+/*-
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Copyright (c) 2019 The FreeBSD Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * Timing benchmarks for the libthr synchronization primitives, in the
+ * spirit of tools/tools/syscall_timing.  The regression tests next to
+ * this program check correctness; this one produces throughput and
+ * latency numbers for uncontended and contended mutexes, condition
+ * variable wakeups, rwlock read scaling and raw _umtx_op(2) calls, so
+ * that libthr and kern_umtx changes can be compared between revisions.
+ *
+ * Output is tab-separated, one line per measurement loop:
+ *
+ *	test	threads	loop	time	iterations	periteration
+ *
+ * Threaded tests report the aggregate iteration count across all
+ * threads.  Tests marked as scaling are repeated for 1, 2, 4, ... up
+ * to the number of configured CPUs (or the -t override).
+ */
+
+#include <sys/types.h>
+#include <sys/time.h>
+#ifdef __FreeBSD__
+#include <sys/umtx.h>
+#endif
+
+#include <assert.h>
+#include <err.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static struct timespec ts_start, ts_end;
+static int alarm_timeout;
+static volatile int alarm_fired;
+
+#define	BENCHMARK_FOREACH(I, NUM) for (I = 0; I < NUM && alarm_fired == 0; I++)
+
+static void
+alarm_handler(int signum __unused)
+{
+
+	alarm_fired = 1;
+}
+
+static void
+benchmark_start(void)
+{
+	int error;
+
+	alarm_fired = 0;
+	if (alarm_timeout) {
+		signal(SIGALRM, alarm_handler);
+		alarm(alarm_timeout);
+	}
+	error = clock_gettime(CLOCK_MONOTONIC, &ts_start);
+	assert(error == 0);
+}
+
+static void
+benchmark_stop(void)
+{
+	int error;
+
+	error = clock_gettime(CLOCK_MONOTONIC, &ts_end);
+	assert(error == 0);
+}
+
+/*
+ * Shared state for the threaded tests.  Worker threads spin on a
+ * barrier so that thread creation cost stays outside the measured
+ * region, run their share of the iterations and publish how many they
+ * completed (the alarm may cut a run short).
+ */
+static pthread_mutex_t bench_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_rwlock_t bench_rwl = PTHREAD_RWLOCK_INITIALIZER;
+static pthread_barrier_t bench_barrier;
+static uint64_t bench_shared;
+
+struct worker {
+	pthread_t w_thread;
+	uintmax_t w_iterations;
+	uintmax_t w_done;
+};
+
+static void *
+worker_mutex(void *arg)
+{
+	struct worker *w = arg;
+	uintmax_t i;
+
+	pthread_barrier_wait(&bench_barrier);
+	BENCHMARK_FOREACH(i, w->w_iterations) {
+		pthread_mutex_lock(&bench_mtx);
+		bench_shared++;
+		pthread_mutex_unlock(&bench_mtx);
+	}
+	w->w_done = i;
+	return (NULL);
+}
+
+static void *
+worker_rwlock_rd(void *arg)
+{
+	struct worker *w = arg;
+	uintmax_t i;
+
+	pthread_barrier_wait(&bench_barrier);
+	BENCHMARK_FOREACH(i, w->w_iterations) {
+		pthread_rwlock_rdlock(&bench_rwl);
+		pthread_rwlock_unlock(&bench_rwl);
+	}
+	w->w_done = i;
+	return (NULL);
+}
+
+/*
+ * Runs nthreads instances of func, each performing its share of num
+ * iterations, and returns the aggregate number of iterations that
+ * completed within the measured window.
+ */
+static uintmax_t
+run_workers(uintmax_t num, int nthreads, void *(*func)(void *))
+{
+	struct worker *workers;
+	uintmax_t done;
+	int error, i;
+
+	workers = calloc(nthreads, sizeof(*workers));
+	if (workers == NULL)
+		err(1, "calloc");
+
+	error = pthread_barrier_init(&bench_barrier, NULL, nthreads + 1);
+	if (error != 0)
+		errc(1, error, "pthread_barrier_init");
+
+	for (i = 0; i < nthreads; i++) {
+		workers[i].w_iterations = num / nthreads;
+		error = pthread_create(&workers[i].w_thread, NULL, func,
+		    &workers[i]);
+		if (error != 0)
+			errc(1, error, "pthread_create");
+	}
+
+	benchmark_start();
+	pthread_barrier_wait(&bench_barrier);
+	done = 0;
+	for (i = 0; i < nthreads; i++) {
+		error = pthread_join(workers[i].w_thread, NULL);
+		if (error != 0)
+			errc(1, error, "pthread_join");
+		done += workers[i].w_done;
+	}
+	benchmark_stop();
+
+	pthread_barrier_destroy(&bench_barrier);
+	free(workers);
+	return (done);
+}
+
+static uintmax_t
+test_mutex_uncontended(uintmax_t num, int nthreads __unused)
+{
+	uintmax_t i;
+
+	benchmark_start();
+	BENCHMARK_FOREACH(i, num) {
+		pthread_mutex_lock(&bench_mtx);
+		bench_shared++;
+		pthread_mutex_unlock(&bench_mtx);
+	}
+	benchmark_stop();
+	return (i);
+}
+
+static uintmax_t
+test_mutex_contended(uintmax_t num, int nthreads)
+{
+
+	return (run_workers(num, nthreads, worker_mutex));
+}
+
+static uintmax_t
+test_rwlock_rdlock(uintmax_t num, int nthreads)
+{
+
+	return (run_workers(num, nthreads, worker_rwlock_rd));
+}
+
+/*
+ * Condition variable wakeup latency.  The main thread and one worker
+ * ping-pong a token over a mutex and two condition variables, so one
+ * iteration covers two signal/wakeup handoffs; periteration therefore
+ * reports the full round trip.
+ */
+static pthread_cond_t cv_ping = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t cv_pong = PTHREAD_COND_INITIALIZER;
+static int cv_token;
+static int cv_done;
+
+static void *
+worker_cv(void *arg __unused)
+{
+
+	pthread_mutex_lock(&bench_mtx);
+	for (;;) {
+		while (cv_token == 0 && cv_done == 0)
+			pthread_cond_wait(&cv_ping, &bench_mtx);
+		if (cv_done)
+			break;
+		cv_token = 0;
+		pthread_cond_signal(&cv_pong);
+	}
+	pthread_mutex_unlock(&bench_mtx);
+	return (NULL);
+}
+
+static uintmax_t
+test_cv_wake(uintmax_t num, int nthreads __unused)
+{
+	pthread_t td;
+	uintmax_t i;
+	int error;
+
+	cv_token = 0;
+	cv_done = 0;
+	error = pthread_create(&td, NULL, worker_cv, NULL);
+	if (error != 0)
+		errc(1, error, "pthread_create");
+
+	benchmark_start();
+	pthread_mutex_lock(&bench_mtx);
+	BENCHMARK_FOREACH(i, num) {
+		cv_token = 1;
+		pthread_cond_signal(&cv_ping);
+		while (cv_token != 0)
+			pthread_cond_wait(&cv_pong, &bench_mtx);
+	}
+	cv_done = 1;
+	pthread_cond_signal(&cv_ping);
+	pthread_mutex_unlock(&bench_mtx);
+	benchmark_stop();
+
+	error = pthread_join(td, NULL);
+	if (error != 0)
+		errc(1, error, "pthread_join");
+	return (i);
+}
+
+#ifdef __FreeBSD__
+/*
+ * Raw umtx syscall rate.  UMTX_OP_WAKE on an address nobody waits on
+ * does the full syscall round trip without blocking, which is the
+ * fixed cost every contended libthr operation pays on top of the
+ * userland fast path.
+ */
+static uintmax_t
+test_umtx_wake(uintmax_t num, int nthreads __unused)
+{
+	u_long word;
+	uintmax_t i;
+
+	word = 0;
+	benchmark_start();
+	BENCHMARK_FOREACH(i, num) {
+		if (_umtx_op(&word, UMTX_OP_WAKE, 1, NULL, NULL) != 0)
+			err(1, "_umtx_op");
+	}
+	benchmark_stop();
+	return (i);
+}
+#endif
+
+#define	FLAG_SCALE	0x00000001
+
+struct test {
+	const char *t_name;
+	uintmax_t (*t_func)(uintmax_t, int);
+	int t_flags;
+};
+
+static const struct test tests[] = {
+	{ "mutex_uncontended", test_mutex_uncontended, .t_flags = 0 },
+	{ "mutex_contended", test_mutex_contended, .t_flags = FLAG_SCALE },
+	{ "cv_wake", test_cv_wake, .t_flags = 0 },
+	{ "rwlock_rdlock", test_rwlock_rdlock, .t_flags = FLAG_SCALE },
+#ifdef __FreeBSD__
+	{ "umtx_wake", test_umtx_wake, .t_flags = 0 },
+#endif
+};
+static const int tests_count = sizeof(tests) / sizeof(tests[0]);
+
+static void
+usage(void)
+{
+	int i;
+
+	fprintf(stderr, "pthread_bench [-i iterations] [-l loops] "
+	    "[-s seconds] [-t threads] test ...\n");
+	for (i = 0; i < tests_count; i++)
+		fprintf(stderr, "  %s\n", tests[i].t_name);
+	exit(-1);
+}
+
+static void
+run_test(const struct test *t, uintmax_t iterations, uintmax_t loops,
+    int nthreads)
+{
+	uintmax_t calls, k, nsecsperit, totalns;
+
+	/*
+	 * Run one warmup, then do the real thing (loops) times.
+	 */
+	t->t_func(iterations, nthreads);
+	for (k = 0; k < loops; k++) {
+		calls = t->t_func(iterations, nthreads);
+		timespecsub(&ts_end, &ts_start, &ts_end);
+		printf("%s\t%d\t%ju\t", t->t_name, nthreads, k);
+		printf("%ju.%09ju\t%ju\t", (uintmax_t)ts_end.tv_sec,
+		    (uintmax_t)ts_end.tv_nsec, calls);
+		totalns = ts_end.tv_sec * 1000000000 + ts_end.tv_nsec;
+		nsecsperit = calls == 0 ? 0 : totalns / calls;
+		printf("%ju.%09ju\n", nsecsperit / 1000000000,
+		    nsecsperit % 1000000000);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct timespec ts_res;
+	const struct test *the_test;
+	long long ll;
+	long ncpu;
+	char *endp;
+	int ch, error, i, j, nthreads;
+	uintmax_t iterations, loops;
+
+	alarm_timeout = 1;
+	iterations = 0;
+	loops = 10;
+	nthreads = 0;
+	while ((ch = getopt(argc, argv, "i:l:s:t:")) != -1) {
+		switch (ch) {
+		case 'i':
+			ll = strtoll(optarg, &endp, 10);
+			if (*endp != 0 || ll < 1)
+				usage();
+			iterations = ll;
+			break;
+
+		case 'l':
+			ll = strtoll(optarg, &endp, 10);
+			if (*endp != 0 || ll < 1 || ll > 100000)
+				usage();
+			loops = ll;
+			break;
+
+		case 's':
+			ll = strtoll(optarg, &endp, 10);
+			if (*endp != 0 || ll < 1 || ll > 60*60)
+				usage();
+			alarm_timeout = ll;
+			break;
+
+		case 't':
+			ll = strtoll(optarg, &endp, 10);
+			if (*endp != 0 || ll < 1 || ll > 1024)
+				usage();
+			nthreads = ll;
+			break;
+
+		case '?':
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+
+	if (iterations < 1 && alarm_timeout < 1)
+		usage();
+	if (iterations < 1)
+		iterations = UINT64_MAX;
+
+	if (argc < 1)
+		usage();
+
+	for (j = 0; j < argc; j++) {
+		the_test = NULL;
+		for (i = 0; i < tests_count; i++) {
+			if (strcmp(argv[j], tests[i].t_name) == 0)
+				the_test = &tests[i];
+		}
+		if (the_test == NULL)
+			usage();
+	}
+
+	ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpu < 1)
+		ncpu = 1;
+
+	error = clock_getres(CLOCK_MONOTONIC, &ts_res);
+	assert(error == 0);
+	printf("Clock resolution: %ju.%09ju\n", (uintmax_t)ts_res.tv_sec,
+	    (uintmax_t)ts_res.tv_nsec);
+	printf("test\tthreads\tloop\ttime\titerations\tperiteration\n");
+
+	for (j = 0; j < argc; j++) {
+		the_test = NULL;
+		for (i = 0; i < tests_count; i++) {
+			if (strcmp(argv[j], tests[i].t_name) == 0)
+				the_test = &tests[i];
+		}
+
+		if ((the_test->t_flags & FLAG_SCALE) && nthreads == 0) {
+			for (i = 1; i <= ncpu; i *= 2)
+				run_test(the_test, iterations, loops, i);
+			if ((ncpu & (ncpu - 1)) != 0)
+				run_test(the_test, iterations, loops, ncpu);
+		} else {
+			run_test(the_test, iterations, loops,
+			    nthreads == 0 ? 1 : nthreads);
+		}
+	}
+
+	exit(0);
+}
@@ -42,9 +42,14 @@ __FBSDID("$FreeBSD$");
 // Operating System and other C based includes
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
 #include <sys/types.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/ioctl.h>
 #include <netinet/in.h>
 #include <net/if.h>
@@ -52,6 +57,7 @@ __FBSDID("$FreeBSD$");
 
 // Private include files
 #include "mctest.h"
+#include "mcring.h"
 
 using namespace std;
 
@@ -61,7 +67,7 @@ using namespace std;
 //
 void usage()
 {
-    cout << "mcgrab -i interface -g multicast group -n number of groups\n";
+    cout << "mcgrab -i interface -g multicast group -n number of groups [-o ring file -p port -S slots -s slot size]\n";
     exit(-1);
 }
 
@@ -85,26 +91,26 @@ void usage(string message)
 // @param interface             ///< text name of the interface (em0 etc.)
 // @param group			///< multicast group
 // @param number		///< number of addresses to grab
-// 
-// @return 0 for 0K, -1 for error, sets errno
 //
-void grab(char *interface, struct in_addr *group, int number, int block) {
+// @return the socket holding the memberships, -1 for error, sets errno
+//
+int grab(char *interface, struct in_addr *group, int number, int block) {
+
 
-    
     int sock;
     struct ip_mreq mreq;
     struct ifreq ifreq;
     struct in_addr lgroup;
-    
+
     if (group == NULL) {
 	group = &lgroup;
 	if (inet_pton(AF_INET, DEFAULT_GROUP, group) < 1)
-	    return;
+	    return (-1);
     }
-    
+
     if ((sock = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
 	perror("failed to open datagram socket");
-	return;
+	return (-1);
     }
 
     for (int i = 0; i < number; i++) {
@@ -114,28 +120,28 @@ void grab(char *interface, struct in_addr *group, int number, int block) {
 	strncpy(ifreq.ifr_name, interface, IFNAMSIZ);
 	if (ioctl(sock, SIOCGIFADDR, &ifreq) < 0) {
 	    perror("no such interface");
-	    return;
+	    return (-1);
 	}
-	
-	memcpy(&mreq.imr_interface, 
+
+	memcpy(&mreq.imr_interface,
 	       &((struct sockaddr_in*) &ifreq.ifr_addr)->sin_addr,
 	       sizeof(struct in_addr));
-	
+
 	mreq.imr_multiaddr.s_addr = group->s_addr;
-	if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, 
+	if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq,
 		       sizeof(mreq)) < 0) {
-	    
+
 	    perror("failed to add membership");
-	    return;
+	    return (-1);
 	}
-	
-	if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, 
-		       &((struct sockaddr_in *) &ifreq.ifr_addr)->sin_addr, 
+
+	if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF,
+		       &((struct sockaddr_in *) &ifreq.ifr_addr)->sin_addr,
 		       sizeof(struct in_addr)) < 0) {
 	    perror("failed to bind interface");
-	    return;
+	    return (-1);
 	}
-	
+
 	group->s_addr = htonl(ntohl(group->s_addr) + 1);
     }
     if (block > 0) {
@@ -143,6 +149,166 @@ void grab(char *interface, struct in_addr *group, int number, int block) {
 	    sleep(INT_MAX);
     }
 
+    return sock;
+}
+
+static volatile sig_atomic_t stop_capture = 0;
+
+static void stop(int sig __unused) {
+    stop_capture = 1;
+}
+
+//
+// drain the socket into a shared-memory ring file
+//
+// The socket is bound to the given port and read in batches with
+// recvmmsg(2); each packet is stamped with the kernel's SO_TIMESTAMP
+// receive time and stored in an mmap'd ring of fixed-size slots (see
+// mcring.h) that analysis tools map directly, so capture never waits
+// on disk.  Runs until SIGINT/SIGTERM.
+//
+// @param sock			///< socket holding the group memberships
+// @param file			///< path of the ring file to create
+// @param port			///< UDP port to bind
+// @param nslots		///< slots in the ring, rounded to 2^n
+// @param slotsize		///< payload bytes per slot
+//
+// @return 0 for OK, -1 for error, sets errno
+//
+int capture(int sock, const char *file, short port, uint32_t nslots,
+	    uint32_t slotsize) {
+
+    const int BATCH = 64;
+    const int CMSGSPACE = CMSG_SPACE(sizeof(struct timeval));
+    struct sockaddr_in local;
+    struct timeval timeout;
+    int fd, on = 1, rcvbuf = 4 * 1024 * 1024;
+
+    while (nslots & (nslots - 1))
+	nslots += nslots & ~(nslots - 1);
+
+    if (setsockopt(sock, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) < 0) {
+	perror("failed to set SO_TIMESTAMP");
+	return (-1);
+    }
+
+    // Bursts land in the socket buffer while we copy a batch out;
+    // the default is far too small at feed rates.
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf,
+		   sizeof(rcvbuf)) < 0)
+	perror("failed to grow SO_RCVBUF");
+
+    timerclear(&timeout);
+    timeout.tv_sec = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+		   sizeof(timeout)) < 0)
+	perror("setsockopt failed");
+
+    bzero(&local, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = INADDR_ANY;
+    local.sin_port = htons(port);
+    local.sin_len = sizeof(local);
+
+    if (bind(sock, (struct sockaddr *)&local, sizeof(local)) < 0) {
+	perror("could not bind socket");
+	return (-1);
+    }
+
+    size_t slotbytes = sizeof(struct mcring_slot) + slotsize;
+    size_t size = sizeof(struct mcring_hdr) + (size_t)nslots * slotbytes;
+
+    if ((fd = open(file, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0) {
+	perror("could not create ring file");
+	return (-1);
+    }
+    if (ftruncate(fd, size) < 0) {
+	perror("could not size ring file");
+	return (-1);
+    }
+
+    char *base = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE,
+			      MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+	perror("could not map ring file");
+	return (-1);
+    }
+
+    struct mcring_hdr *hdr = (struct mcring_hdr *)base;
+    char *slots = base + sizeof(*hdr);
+
+    bzero(hdr, sizeof(*hdr));
+    hdr->mr_version = MCRING_VERSION;
+    hdr->mr_nslots = nslots;
+    hdr->mr_slotsize = slotsize;
+    // Write the magic last so a consumer never maps a half-built header.
+    hdr->mr_magic = MCRING_MAGIC;
+
+    struct mmsghdr msgs[BATCH];
+    struct iovec iov[BATCH];
+    char *packets = new char[BATCH * slotsize];
+    char *cmsgbuf = new char[BATCH * CMSGSPACE];
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    printf("Capturing to %s, %u slots of %u bytes.  "
+	   "Press Control-C to exit.\n", file, nslots, slotsize);
+
+    while (!stop_capture) {
+	for (int i = 0; i < BATCH; i++) {
+	    iov[i].iov_base = &packets[i * slotsize];
+	    iov[i].iov_len = slotsize;
+	    bzero(&msgs[i], sizeof(msgs[i]));
+	    msgs[i].msg_hdr.msg_iov = &iov[i];
+	    msgs[i].msg_hdr.msg_iovlen = 1;
+	    msgs[i].msg_hdr.msg_control = &cmsgbuf[i * CMSGSPACE];
+	    msgs[i].msg_hdr.msg_controllen = CMSGSPACE;
+	}
+	int m = recvmmsg(sock, msgs, BATCH, MSG_WAITFORONE, NULL);
+	if (m < 0) {
+	    if (errno == EWOULDBLOCK || errno == EINTR)
+		continue;
+	    perror("recvmmsg failed");
+	    return (-1);
+	}
+	for (int i = 0; i < m; i++) {
+	    struct mcring_slot *slot = (struct mcring_slot *)
+		&slots[(hdr->mr_head & (nslots - 1)) * slotbytes];
+
+	    slot->ms_sec = slot->ms_usec = 0;
+	    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+		 cmsg != NULL; cmsg = CMSG_NXTHDR(&msgs[i].msg_hdr, cmsg)) {
+		if (cmsg->cmsg_level == SOL_SOCKET &&
+		    cmsg->cmsg_type == SCM_TIMESTAMP &&
+		    cmsg->cmsg_len == CMSG_LEN(sizeof(struct timeval))) {
+		    struct timeval tv;
+		    memcpy(&tv, CMSG_DATA(cmsg), sizeof(tv));
+		    slot->ms_sec = tv.tv_sec;
+		    slot->ms_usec = tv.tv_usec;
+		    break;
+		}
+	    }
+	    slot->ms_len = msgs[i].msg_len;
+	    slot->ms_origlen = msgs[i].msg_len;
+	    if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+		slot->ms_len = slotsize;
+		hdr->mr_truncated++;
+	    }
+	    memcpy(slot + 1, &packets[i * slotsize], slot->ms_len);
+	    // Publish the slot only after its contents are in place.
+	    __sync_synchronize();
+	    hdr->mr_head++;
+	}
+    }
+
+    printf("Captured %ju packets, %ju truncated.\n",
+	   (uintmax_t)hdr->mr_head, (uintmax_t)hdr->mr_truncated);
+    if (msync(base, size, MS_SYNC) < 0)
+	perror("msync failed");
+    delete[] packets;
+    delete[] cmsgbuf;
+    return 0;
+
 }
 
 
@@ -163,16 +329,20 @@ int main(int argc, char**argv)
 	struct in_addr *group = NULL;	///< the multicast group address
 	int number = 0;		///< Number of addresses to grab
 	int block = 1;		///< Do we block or just return?
-	
-	if ((argc < 7) || (argc > 8))
+	char* ringfile = NULL;	///< capture ring file, NULL to just hold
+	short port = DEFAULT_PORT; ///< port to capture on
+	int nslots = 65536;	///< slots in the capture ring
+	int slotsize = 2048;	///< payload bytes per slot
+
+	if ((argc < 7) || (argc > 16))
 		usage();
-	
-	while ((ch = getopt(argc, argv, "g:i:n:bh")) != -1) {
+
+	while ((ch = getopt(argc, argv, "g:i:n:o:p:S:s:bh")) != -1) {
 		switch (ch) {
 		case 'g':
 			group = new (struct in_addr );
-			if (inet_pton(AF_INET, optarg, group) < 1) 
-				usage(argv[0] + string(" Error: invalid multicast group") + 
+			if (inet_pton(AF_INET, optarg, group) < 1)
+				usage(argv[0] + string(" Error: invalid multicast group") +
 				      optarg);
 			break;
 		case 'i':
@@ -181,6 +351,24 @@ int main(int argc, char**argv)
 		case 'n':
 			number = atoi(optarg);
 			break;
+		case 'o':
+			ringfile = optarg;
+			break;
+		case 'p':
+			port = atoi(optarg);
+			break;
+		case 'S':
+			nslots = atoi(optarg);
+			if (nslots < 2)
+				usage(argv[0] + string(" Error: ") + optarg +
+				      string(" slot count out of range"));
+			break;
+		case 's':
+			slotsize = atoi(optarg);
+			if (slotsize < 1 || slotsize > 65535)
+				usage(argv[0] + string(" Error: ") + optarg +
+				      string(" slot size out of range"));
+			break;
 		case 'b':
 			block = 0;
 			break;
@@ -189,7 +377,14 @@ int main(int argc, char**argv)
 			break;
 		}
 	}
-	
-	grab(interface, group, number, block);
-	
+
+	if (ringfile != NULL) {
+		int sock = grab(interface, group, number, 0);
+		if (sock < 0)
+			exit(-1);
+		if (capture(sock, ringfile, port, nslots, slotsize) < 0)
+			exit(-1);
+	} else
+		grab(interface, group, number, block);
+
 }
@@ -0,0 +1,64 @@
+//
+//  Copyright (c) 2026 The FreeBSD Foundation
+//  All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+// 1. Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+// 2. Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+// OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGE.
+//
+// $FreeBSD$
+//
+//  On-disk/shared-memory layout of the mcgrab capture ring.  The file
+//  starts with a single mcring_hdr followed by mr_nslots fixed-size
+//  slots, each an mcring_slot immediately followed by mr_slotsize
+//  bytes of packet payload.  mcgrab is the only writer; analysis tools
+//  mmap(2) the file read-only and follow mr_head, which counts slots
+//  written and only ever increases (slot index is mr_head % mr_nslots,
+//  older slots are overwritten).  A consumer that falls more than
+//  mr_nslots behind has lost packets and can detect it the same way.
+//
+
+#ifndef _MCRING_H_
+#define	_MCRING_H_
+
+#include <stdint.h>
+
+#define	MCRING_MAGIC	0x4d435231	// "MCR1"
+#define	MCRING_VERSION	1
+
+struct mcring_hdr {
+	uint32_t	mr_magic;	///< MCRING_MAGIC
+	uint32_t	mr_version;	///< MCRING_VERSION
+	uint32_t	mr_nslots;	///< number of slots, a power of two
+	uint32_t	mr_slotsize;	///< payload bytes per slot
+	volatile uint64_t mr_head;	///< slots written so far
+	uint64_t	mr_truncated;	///< payloads longer than a slot
+	uint64_t	mr_pad[5];	///< pad the header to 64 bytes
+};
+
+struct mcring_slot {
+	uint64_t	ms_sec;		///< kernel receive time, seconds
+	uint64_t	ms_usec;	///< kernel receive time, microseconds
+	uint32_t	ms_len;		///< payload bytes stored
+	uint32_t	ms_origlen;	///< payload bytes on the wire
+	// mr_slotsize bytes of payload follow
+};
+
+#endif // !_MCRING_H_
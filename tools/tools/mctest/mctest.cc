@@ -44,9 +44,11 @@ __FBSDID("$FreeBSD$");
 // Operating System and other C based includes
 #include <unistd.h>
 #include <errno.h>
+#include <stdint.h>
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <sys/ioctl.h>
 #include <netinet/in.h>
 #include <net/if.h>
@@ -63,7 +65,7 @@ using namespace std;
 //
 void usage()
 {
-    cout << "mctest [-r] -M clients -m client number -i interface -g multicast group -s packet size -n number -t inter-packet gap\n";
+    cout << "mctest [-r] -M clients -m client number -i interface -g multicast group -G number of groups -s packet size -n number -t inter-packet gap\n";
     exit(-1);
 }
 
@@ -80,6 +82,136 @@ void usage(string message)
     usage();
 }
 
+//
+// Log-linear latency histogram in the HDR style: 32 linear sub-buckets
+// per power of two, so recording costs a handful of arithmetic
+// operations and stays within ~3% relative error.  This lets the
+// receive loops account for every packet online instead of storing a
+// timestamp per packet, which at the rates we test made the tool
+// itself the bottleneck.  All values are in microseconds.
+//
+class LatencyHistogram {
+public:
+    LatencyHistogram() : counts(1024, 0), total(0), minv(0), maxv(0) {}
+
+    void record(uint64_t usecs) {
+	uint64_t v = usecs;
+	int idx;
+
+	if (v < 64) {
+	    idx = v;
+	} else {
+	    int bucket = 0;
+	    while (v >= 64) {
+		v >>= 1;
+		bucket++;
+	    }
+	    idx = bucket * 32 + v;
+	}
+	if (idx >= (int)counts.size())
+	    idx = counts.size() - 1;
+	counts[idx]++;
+	if (total == 0 || usecs < minv)
+	    minv = usecs;
+	if (usecs > maxv)
+	    maxv = usecs;
+	total++;
+    }
+
+    uint64_t samples() const { return total; }
+
+    // The representative value of the bucket holding the p'th quantile.
+    uint64_t percentile(double p) const {
+	uint64_t rank = (uint64_t)(p * total), seen = 0;
+
+	for (int idx = 0; idx < (int)counts.size(); idx++) {
+	    seen += counts[idx];
+	    if (seen > rank) {
+		if (idx < 64)
+		    return idx;
+		int bucket = idx / 32 - 1;
+		return ((uint64_t)(idx - bucket * 32)) << bucket;
+	    }
+	}
+	return maxv;
+    }
+
+    void print() const {
+	double idx[] = { .0001, .001, .01, .1, .5, .9, .99, .999, .9999, 0.0 };
+
+	if (total == 0) {
+	    cout << "no samples recorded" << endl;
+	    return;
+	}
+	cout << "recorded " << (long)total << " samples" << endl;
+	for (int i = 0; idx[i] != 0; ++i)
+	    printf("%s% 5ju", (i == 0) ? "" : " ",
+		   (uintmax_t)percentile(idx[i]));
+	printf("\n");
+	printf("min: %ju  max: %ju\n", (uintmax_t)minv, (uintmax_t)maxv);
+    }
+
+private:
+    vector<uint64_t> counts;
+    uint64_t total, minv, maxv;
+};
+
+// Messages received per recvmmsg(2) call.
+const int RECV_BATCH = 64;
+// Room for the SO_TIMESTAMP control message on each of them.
+const int CMSGSPACE = CMSG_SPACE(sizeof(struct timeval));
+
+//
+// pull the SO_TIMESTAMP kernel receive time out of a received message
+//
+// @param msg			///< header of the received message
+// @param tv			///< filled with the kernel timestamp
+//
+// @return 0 when found, -1 when the control data lacks a timestamp
+//
+static int kernel_timestamp(struct msghdr *msg, struct timeval *tv) {
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL;
+	 cmsg = CMSG_NXTHDR(msg, cmsg)) {
+	if (cmsg->cmsg_level == SOL_SOCKET &&
+	    cmsg->cmsg_type == SCM_TIMESTAMP &&
+	    cmsg->cmsg_len == CMSG_LEN(sizeof(*tv))) {
+	    memcpy(tv, CMSG_DATA(cmsg), sizeof(*tv));
+	    return 0;
+	}
+    }
+    return -1;
+}
+
+//
+// set up a batch of message headers for recvmmsg
+//
+// @param msgs			///< message headers to initialize
+// @param iov			///< one iovec per message
+// @param packets		///< packet buffers, pkt_size each
+// @param pkt_size		///< packet size
+// @param from			///< per-message source addresses, or NULL
+// @param cmsgbuf		///< per-message control buffers, CMSGSPACE each
+//
+static void batch_setup(struct mmsghdr *msgs, struct iovec *iov,
+			char *packets, int pkt_size, struct sockaddr_in *from,
+			char *cmsgbuf) {
+
+    for (int i = 0; i < RECV_BATCH; i++) {
+	iov[i].iov_base = &packets[i * pkt_size];
+	iov[i].iov_len = pkt_size;
+	memset(&msgs[i], 0, sizeof(msgs[i]));
+	if (from != NULL) {
+	    msgs[i].msg_hdr.msg_name = &from[i];
+	    msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+	}
+	msgs[i].msg_hdr.msg_iov = &iov[i];
+	msgs[i].msg_hdr.msg_iovlen = 1;
+	msgs[i].msg_hdr.msg_control = &cmsgbuf[i * CMSGSPACE];
+	msgs[i].msg_hdr.msg_controllen = CMSGSPACE;
+    }
+}
+
 
 //
 // absorb and record packets
@@ -98,8 +230,7 @@ int sink(char *interface, struct in_addr *group, int pkt_size, int number,
 
     
     int sock, backchan;
-    socklen_t recvd_len;
-    struct sockaddr_in local, recvd;
+    struct sockaddr_in local;
     struct ip_mreq mreq;
     struct ifreq ifreq;
     struct in_addr lgroup;
@@ -145,6 +276,19 @@ int sink(char *interface, struct in_addr *group, int pkt_size, int number,
 	return (-1);
     }
 		   
+    int on = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0) {
+	perror("failed to set SO_REUSEADDR");
+	return (-1);
+    }
+
+    // Have the kernel stamp each datagram on reception; at high rates
+    // a gettimeofday() per packet in userland lags far behind.
+    if (setsockopt(sock, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) < 0) {
+	perror("failed to set SO_TIMESTAMP");
+	return (-1);
+    }
+
     local.sin_family = AF_INET;
     local.sin_addr.s_addr = group->s_addr;
     local.sin_port = htons(DEFAULT_PORT);
@@ -155,74 +299,107 @@ int sink(char *interface, struct in_addr *group, int pkt_size, int number,
 	return (-1);
     }
 
-    timeval packets[number];
-    timeval result;
-    char *packet;
-    packet = new char[pkt_size];
+    struct mmsghdr msgs[RECV_BATCH];
+    struct iovec iov[RECV_BATCH];
+    struct sockaddr_in from[RECV_BATCH];
+    char *packets = new char[RECV_BATCH * pkt_size];
+    char *cmsgbuf = new char[RECV_BATCH * CMSGSPACE];
+    timeval prev, stamp, result;
+    LatencyHistogram gaps;
     int n = 0;
-    
+
+    timerclear(&prev);
     timerclear(&timeout);
     timeout.tv_sec = TIMEOUT;
-    
-    if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, 
-		   sizeof(timeout)) < 0) 
+
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+		   sizeof(timeout)) < 0)
 	perror("setsockopt failed");
-    
-    while (n < number) { 
-	recvd_len = sizeof(recvd);
-	if (recvfrom(sock, packet, pkt_size, 0, (struct sockaddr *)&recvd, 
-		     &recvd_len) < 0) {
+
+    while (n < number) {
+	batch_setup(msgs, iov, packets, pkt_size, from, cmsgbuf);
+	int m = recvmmsg(sock, msgs, RECV_BATCH, MSG_WAITFORONE, NULL);
+	if (m < 0) {
 	    if (errno == EWOULDBLOCK)
 		break;
-	    perror("recvfrom failed");
+	    perror("recvmmsg failed");
 	    return -1;
 	}
-	/*
-	 * Bandwidth limiting.  If there are N clients then we want
-	 * 1/N packets from each, otherwise the clients will overwhelm
-	 * the sender. 
-	 */
-	if (n % clients == client) {
-		recvd.sin_port = htons(base_port + client);
-		if (sendto(backchan, packet, pkt_size, 0, 
-			   (struct sockaddr *)&recvd, sizeof(recvd)) < 0) {
+	for (int i = 0; i < m && n < number; i++, n++) {
+	    char *packet = &packets[i * pkt_size];
+	    /*
+	     * Bandwidth limiting.  If there are N clients then we want
+	     * 1/N packets from each, otherwise the clients will overwhelm
+	     * the sender.
+	     */
+	    if (n % clients == client) {
+		from[i].sin_port = htons(base_port + client);
+		if (sendto(backchan, packet, pkt_size, 0,
+			   (struct sockaddr *)&from[i], sizeof(from[i])) < 0) {
 		    perror("sendto failed");
 		    return -1;
 		}
+	    }
+	    if (kernel_timestamp(&msgs[i].msg_hdr, &stamp) < 0)
+		gettimeofday(&stamp, 0);
+	    if (timerisset(&prev)) {
+		timersub(&stamp, &prev, &result);
+		gaps.record((uint64_t)result.tv_sec * 1000000 +
+			    result.tv_usec);
+	    }
+	    prev = stamp;
 	}
-	gettimeofday(&packets[ntohl(*(int *)packet)], 0);
-	n++;
     }
-    
+
     cout << "Packet run complete\n";
     if (n < number)
 	cout << "Missed " << number - n << " packets." << endl;
-    long maxgap = 0, mingap= INT_MAX;
-    for (int i = 0; i < number; i++) {
-	cout << "sec: " << packets[i].tv_sec << "  usec: " << 
-	    packets[i].tv_usec << endl;
-	if (i < number - 1) {
-	    timersub(&packets[i+1], &packets[i], &result);
-	    long gap = (result.tv_sec * 1000000) + result.tv_usec;
-	    if (gap > maxgap)
-		maxgap = gap;
-	    if (gap < mingap)
-		mingap = gap;
-	}
-    }
-    
-    cout << "maximum gap (usecs): " << maxgap << endl;
-    cout << "minimum gap (usecs): " << mingap << endl;
+    cout << "inter-packet gap percentiles (usecs)" << endl;
+    gaps.print();
+    delete[] packets;
+    delete[] cmsgbuf;
     return 0;
-    
+
+}
+
+//
+// Structure to hold the arguments of one sink thread in a
+// multi-group run
+//
+struct sink_args {
+    char *interface;		///< Name of the interface
+    struct in_addr group;	///< This thread's multicast group
+    int pkt_size;		///< Size of the packets
+    int number;			///< Number of packets to expect
+    int clients;		///< Total number of clients
+    int client;			///< Our client number
+    short base_port;		///< Base port for the back channel
+};
+
+//
+// run one sink on its own group, for -G runs with several groups
+// handled by a single process
+//
+// @param passed		///< Arguments passed from the caller
+//
+// @return always NULL
+void* sink_thread(void *passed) {
+
+    sink_args *args = (sink_args *)passed;
+
+    sink(args->interface, &args->group, args->pkt_size, args->number,
+	 args->clients, args->client, args->base_port);
+    return NULL;
 }
 
 //
 // Structure to hold thread arguments
 //
 struct server_args {
-    struct timeval *packets; 	///< The timestamps of returning packets
+    const struct timeval *sent;	///< When each sequence number was sent
+    LatencyHistogram hist;	///< Round-trip times of returning packets
     int number;			///< Number of packets to expect.
+    int total;			///< Total packets in the run (bounds seq)
     int pkt_size;		///< Size of the packets
     int client;			///< Which client we listen for
 };
@@ -235,19 +412,24 @@ struct server_args {
 // 0return  always NULL
 void* server(void *passed) {
 
-    int sock, n =0;
-    struct timeval timeout;
+    int sock, n =0, on = 1;
+    struct timeval timeout, stamp, result;
     struct sockaddr_in addr;
     server_args *args = (server_args *)passed;
 
     timerclear(&timeout);
     timeout.tv_sec = TIMEOUT;
-    
+
     if ((sock = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
 	perror("could not open server socket");
 	return NULL;
     }
 
+    if (setsockopt(sock, SOL_SOCKET, SO_TIMESTAMP, &on, sizeof(on)) < 0) {
+	perror("failed to set SO_TIMESTAMP");
+	return NULL;
+    }
+
     bzero(&addr, sizeof(addr));
     addr.sin_family = AF_INET;
     addr.sin_addr.s_addr = INADDR_ANY;
@@ -259,20 +441,34 @@ void* server(void *passed) {
 	return NULL;
     }
 
-    if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, 
-		   sizeof(timeout)) < 0) 
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+		   sizeof(timeout)) < 0)
 	perror("setsockopt failed");
 
-    char packet[args->pkt_size];
-    while (n < args->number) { 
-	if (recvfrom(sock, &packet, args->pkt_size, 0, NULL, 0) < 0) {
+    struct mmsghdr msgs[RECV_BATCH];
+    struct iovec iov[RECV_BATCH];
+    char *packets = new char[RECV_BATCH * args->pkt_size];
+    char *cmsgbuf = new char[RECV_BATCH * CMSGSPACE];
+
+    while (n < args->number) {
+	batch_setup(msgs, iov, packets, args->pkt_size, NULL, cmsgbuf);
+	int m = recvmmsg(sock, msgs, RECV_BATCH, MSG_WAITFORONE, NULL);
+	if (m < 0) {
 	    if (errno == EWOULDBLOCK)
 		break;
-	    perror("recvfrom failed");
+	    perror("recvmmsg failed");
 	    return NULL;
 	}
-	gettimeofday(&args->packets[ntohl(*(int *)packet)], 0);
-	n++;
+	for (int i = 0; i < m && n < args->number; i++, n++) {
+	    int seq = ntohl(*(int *)&packets[i * args->pkt_size]);
+	    if (seq < 0 || seq >= args->total)
+		continue;
+	    if (kernel_timestamp(&msgs[i].msg_hdr, &stamp) < 0)
+		gettimeofday(&stamp, 0);
+	    timersub(&stamp, &args->sent[seq], &result);
+	    args->hist.record((uint64_t)result.tv_sec * 1000000 +
+			      result.tv_usec);
+	}
     }
 
     cout << "Packet Reflection Complete" << endl;
@@ -280,6 +476,8 @@ void* server(void *passed) {
     if (n < args->number)
 	cout << "Missed " << args->number - n << " packets." << endl;
 
+    delete[] packets;
+    delete[] cmsgbuf;
     return NULL;
 
 }
@@ -288,19 +486,20 @@ void* server(void *passed) {
 // transmit packets for the multicast test
 // 
 // @param interface             ///< text name of the interface (em0 etc.)
-// @param group			///< multicast group
+// @param group			///< first multicast group
 // @param pkt_size		///< packet size
 // @param number                ///< number of packets
 // @param gap			///< inter packet gap in nano-seconds
 // @param clients		///< number of clients we intend to run
-// 
+// @param ngroups		///< number of consecutive groups/sockets
+//
 // @return 0 for OK, -1 for error, sets errno
 //
-int source(char *interface, struct in_addr *group, int pkt_size, 
-	   int number, int gap, int clients, short base_port) {
+int source(char *interface, struct in_addr *group, int pkt_size,
+	   int number, int gap, int clients, short base_port, int ngroups) {
 
-    int sock;
-    struct sockaddr_in addr;
+    int sock[ngroups];
+    struct sockaddr_in addr[ngroups];
     struct ip_mreq mreq;
     struct ifreq ifreq;
     struct in_addr lgroup;
@@ -310,48 +509,56 @@ int source(char *interface, struct in_addr *group, int pkt_size,
 	if (inet_pton(AF_INET, DEFAULT_GROUP, group) < 1)
 	    return (-1);
     }
-    
-    if ((sock = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
-	perror("could not open dgram socket");
-	return (-1);
-    }
-    
-    bzero(&addr, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(DEFAULT_PORT);
-    addr.sin_addr.s_addr = group->s_addr;
-    addr.sin_len = sizeof(addr);
 
     strncpy(ifreq.ifr_name, interface, IFNAMSIZ);
-    if (ioctl(sock, SIOCGIFADDR, &ifreq) < 0) {
-	perror("no such interface");
-	return (-1);
-    }
 
-    memcpy(&mreq.imr_interface, 
-	   &((struct sockaddr_in*) &ifreq.ifr_addr)->sin_addr,
-	   sizeof(struct in_addr));
+    //
+    // One socket per group; the groups are consecutive addresses
+    // starting at the one given, so a single process can drive a
+    // multi-group scaling run.
+    //
+    for (int g = 0; g < ngroups; g++) {
+	if ((sock[g] = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+	    perror("could not open dgram socket");
+	    return (-1);
+	}
 
-    mreq.imr_multiaddr.s_addr = group->s_addr;
-    if (setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, 
-		   sizeof(mreq)) < 0) {
-	perror("failed to add membership");
-	return (-1);
-    }
+	bzero(&addr[g], sizeof(addr[g]));
+	addr[g].sin_family = AF_INET;
+	addr[g].sin_port = htons(DEFAULT_PORT);
+	addr[g].sin_addr.s_addr = htonl(ntohl(group->s_addr) + g);
+	addr[g].sin_len = sizeof(addr[g]);
 
-    if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, 
-		   &((struct sockaddr_in *) &ifreq.ifr_addr)->sin_addr, 
-		   sizeof(struct in_addr)) < 0) {
-	perror("failed to bind interface");
-	return (-1);
-    }
-		   
-    u_char ttl = 64;
+	if (ioctl(sock[g], SIOCGIFADDR, &ifreq) < 0) {
+	    perror("no such interface");
+	    return (-1);
+	}
 
-    if (setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL,
-		   &ttl, sizeof(ttl)) < 0) {
-	perror("failed to set TTL");
-	return (-1);
+	memcpy(&mreq.imr_interface,
+	       &((struct sockaddr_in*) &ifreq.ifr_addr)->sin_addr,
+	       sizeof(struct in_addr));
+
+	mreq.imr_multiaddr.s_addr = addr[g].sin_addr.s_addr;
+	if (setsockopt(sock[g], IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq,
+		       sizeof(mreq)) < 0) {
+	    perror("failed to add membership");
+	    return (-1);
+	}
+
+	if (setsockopt(sock[g], IPPROTO_IP, IP_MULTICAST_IF,
+		       &((struct sockaddr_in *) &ifreq.ifr_addr)->sin_addr,
+		       sizeof(struct in_addr)) < 0) {
+	    perror("failed to bind interface");
+	    return (-1);
+	}
+
+	u_char ttl = 64;
+
+	if (setsockopt(sock[g], IPPROTO_IP, IP_MULTICAST_TTL,
+		       &ttl, sizeof(ttl)) < 0) {
+	    perror("failed to set TTL");
+	    return (-1);
+	}
     }
 
     char *packets[number];
@@ -359,16 +566,16 @@ int source(char *interface, struct in_addr *group, int pkt_size,
 	packets[i] = new char[pkt_size];
 	*(int *)packets[i] = htonl(i);
     }
-    
-    struct timeval sent[number];
-    struct timeval received[clients][number];
+
+    struct timeval *sent = new struct timeval[number];
     server_args args[clients];
     pthread_t thread[clients];
 
     for (int i = 0;i < clients; i++) {
         args[i].pkt_size = pkt_size;
-        args[i].packets = received[i];
+        args[i].sent = sent;
         args[i].number = number / clients;
+        args[i].total = number;
 	args[i].client = base_port + i;
 	if (pthread_create(&thread[i], NULL, server, &args[i]) != 0) {
 	    perror("failed to create server thread");
@@ -379,15 +586,17 @@ int source(char *interface, struct in_addr *group, int pkt_size,
     struct timespec sleeptime;
     sleeptime.tv_sec = 0;
     sleeptime.tv_nsec = gap;
-    
+
     for (int i = 0;i < number; i++) {
-	if (sendto(sock, (void *)packets[i], pkt_size, 0, 
-		   (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+	// Stamp before sending so a reflection cannot beat the stamp.
+	gettimeofday(&sent[i], 0);
+	if (sendto(sock[i % ngroups], (void *)packets[i], pkt_size, 0,
+		   (struct sockaddr *)&addr[i % ngroups],
+		   sizeof(addr[i % ngroups])) < 0) {
 	    perror("sendto failed");
 	    return -1;
 	}
-	gettimeofday(&sent[i], 0);
-	if (gap > 0) 
+	if (gap > 0)
 	    if (nanosleep(&sleeptime, NULL) < 0) {
 		perror("nanosleep failed");
 		return -1;
@@ -401,34 +610,13 @@ int source(char *interface, struct in_addr *group, int pkt_size,
         }
     }
 
-    timeval result;
-    vector<int> deltas;
-    double idx[] = { .0001, .001, .01, .1, .5, .9, .99, .999, .9999, 0.0 };
-
     for (int client = 0;client < clients; client++) {
-	deltas.clear();
 	cout << "Results from client #" << client << endl;
-	cout << "in usecs" << endl;
-        for (int i = 0; i < number; i++) {
-// 	    if (i % clients != client) 
-// 		continue;
-            if (&args[client].packets[i].tv_sec == 0)
-			continue;
-	    timersub(&args[client].packets[i], &sent[i], &result);
-	    deltas.push_back(result.tv_usec);
-// 	    cout << "sec: " << result.tv_sec;
-// 	    cout << " usecs: " << result.tv_usec << endl;
-            }
-	cout << "comparing " << long(deltas.size()) << " deltas" << endl;
 	cout << "number represents usecs of round-trip time" << endl;
-	sort(deltas.begin(), deltas.end());
-	for (int i = 0; idx[i] != 0; ++i) {
-		printf("%s% 5d", (i == 0) ? "" : " ", 
-		       deltas[(int) (idx[i] * deltas.size())]); 
-	}
-	printf("\n");		
+	args[client].hist.print();
     }
 
+    delete[] sent;
     return 0;
 }
 
@@ -458,12 +646,13 @@ int main(int argc, char**argv)
 	bool server = false;	///< are we on he receiving end of multicast
 	int client = 0;		///< for receivers which client are we
 	int clients = 1;	///< for senders how many clients are there
+	int ngroups = 1;	///< number of multicast groups/sockets to drive
 	short base_port = SERVER_PORT; ///< to have multiple copies running at once
-	
-	if (argc < 2 || argc > 16)
+
+	if (argc < 2 || argc > 18)
 		usage();
-	
-	while ((ch = getopt(argc, argv, "M:m:g:i:n:s:t:b:rh")) != -1) {
+
+	while ((ch = getopt(argc, argv, "M:m:g:G:i:n:s:t:b:rh")) != -1) {
 		switch (ch) {
 		case 'g':
 			group = new (struct in_addr );
@@ -501,6 +690,12 @@ int main(int argc, char**argv)
 		case 'M':
 			clients = atoi(optarg);
 			break;
+		case 'G':
+			ngroups = atoi(optarg);
+			if (ngroups < 1)
+				usage(argv[0] + string(" Error: ") + optarg +
+				      string(" number of groups out of range"));
+			break;
 		case 'b':
 			base_port = atoi(optarg);
 			break;
@@ -513,13 +708,45 @@ int main(int argc, char**argv)
 	if (server) {
 	    if (clients <= 0 || client < 0)
 		usage("must specify client (-m) and number of clients (-M)");
-	    sink(interface, group, pkt_size, number, clients, client,
-		 base_port);
+	    if (ngroups == 1) {
+		sink(interface, group, pkt_size, number, clients, client,
+		     base_port);
+	    } else {
+		//
+		// One sink thread per group, all within this process;
+		// the sender round-robins packets over the groups so
+		// each thread sees its share of the run.
+		//
+		struct in_addr lgroup;
+		if (group == NULL) {
+		    group = &lgroup;
+		    if (inet_pton(AF_INET, DEFAULT_GROUP, group) < 1)
+			usage("invalid default group");
+		}
+		sink_args sargs[ngroups];
+		pthread_t sthread[ngroups];
+		for (int g = 0; g < ngroups; g++) {
+		    sargs[g].interface = interface;
+		    sargs[g].group.s_addr = htonl(ntohl(group->s_addr) + g);
+		    sargs[g].pkt_size = pkt_size;
+		    sargs[g].number = number / ngroups;
+		    sargs[g].clients = clients;
+		    sargs[g].client = client;
+		    sargs[g].base_port = base_port;
+		    if (pthread_create(&sthread[g], NULL, sink_thread,
+				       &sargs[g]) != 0) {
+			perror("failed to create sink thread");
+			exit(-1);
+		    }
+		}
+		for (int g = 0; g < ngroups; g++)
+		    pthread_join(sthread[g], NULL);
+	    }
 	} else {
 	    if (clients <= 0)
 		usage("must specify number of clients (-M)");
-	    source(interface, group, pkt_size, number, gap, clients, 
-		   base_port);
+	    source(interface, group, pkt_size, number, gap, clients,
+		   base_port, ngroups);
 	}
 	
 }
@@ -0,0 +1,68 @@
+#!/bin/sh
+# $FreeBSD$
+#
+# Benchmark harness for dtc.  Generates a synthetic device tree source
+# file of the requested size and reports the time spent in each phase of
+# the compiler (as measured by dtc -D), together with the parse
+# throughput in bytes per second.  The synthetic tree exercises the
+# lexer (long runs of whitespace and comments), the checkers (compatible
+# and model properties on every node), and the phandle fixup pass (a
+# cross reference per node).
+#
+# Usage: benchmark.sh [path-to-dtc] [node-count]
+
+DTC=${1:-dtc}
+NODES=${2:-10000}
+
+TMPDIR=$(mktemp -d -t dtcbench) || exit 1
+trap 'rm -rf "$TMPDIR"' EXIT INT TERM
+
+DTS="$TMPDIR/bench.dts"
+DTB="$TMPDIR/bench.dtb"
+STATS="$TMPDIR/stats"
+
+awk -v nodes="$NODES" 'BEGIN {
+	print "/dts-v1/;"
+	print ""
+	print "/ {"
+	print "\t#address-cells = <1>;"
+	print "\t#size-cells = <1>;"
+	print "\tsoc {"
+	print "\t\t#address-cells = <1>;"
+	print "\t\t#size-cells = <1>;"
+	for (i = 0; i < nodes; i++) {
+		printf "\t\t/* device %d */\n", i
+		printf "\t\tl%d: device@%x {\n", i, i
+		printf "\t\t\tcompatible = \"bench,device-%d\";\n", i % 7
+		printf "\t\t\tmodel = \"bench device\";\n"
+		printf "\t\t\treg = <0x%x 0x1000>;\n", i * 4096
+		if (i > 0)
+			printf "\t\t\tinterrupt-parent = <&l%d>;\n", i - 1
+		printf "\t\t};\n"
+	}
+	print "\t};"
+	print "};"
+}' > "$DTS"
+
+"$DTC" -D -o "$DTB" "$DTS" 2> "$STATS"
+if [ $? -ne 0 ]; then
+	echo "dtc failed; output follows" >&2
+	cat "$STATS" >&2
+	exit 1
+fi
+
+SRC_SIZE=$(wc -c < "$DTS")
+BLOB_SIZE=$(wc -c < "$DTB")
+
+echo "nodes:       $NODES"
+echo "source:      $SRC_SIZE bytes"
+echo "blob:        $BLOB_SIZE bytes"
+grep ' took ' "$STATS"
+awk -v size="$SRC_SIZE" '/^Parsing took / {
+	if ($3 + 0 > 0)
+		printf "parse throughput: %.0f bytes/sec\n", size / $3
+}' "$STATS"
+awk -v size="$BLOB_SIZE" '/^Generating output took / {
+	if ($4 + 0 > 0)
+		printf "emit throughput:  %.0f bytes/sec\n", size / $4
+}' "$STATS"
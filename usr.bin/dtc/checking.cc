@@ -117,6 +117,26 @@ namespace
 
 bool
 checker::visit_node(device_tree *tree, const node_ptr &n)
+{
+	if (!enter_node(tree, n))
+	{
+		return false;
+	}
+	// Recursively check the children
+	for (node::child_iterator i=n->child_begin(), e=n->child_end() ; i!=e ;
+	     ++i)
+	{
+		if (!visit_node(tree, *i))
+		{
+			return false;
+		}
+	}
+	leave_node();
+	return true;
+}
+
+bool
+checker::enter_node(device_tree *tree, const node_ptr &n)
 {
 	path.push_back(std::make_pair(n->name, n->unit_address));
 	// Check this node
@@ -132,19 +152,15 @@ checker::visit_node(device_tree *tree, const node_ptr &n)
 			return false;
 		}
 	}
-	// And then recursively check the children
-	for (node::child_iterator i=n->child_begin(), e=n->child_end() ; i!=e ;
-	     ++i)
-	{
-		if (!visit_node(tree, *i))
-		{
-			return false;
-		}
-	}
-	path.pop_back();
 	return true;
 }
 
+void
+checker::leave_node()
+{
+	path.pop_back();
+}
+
 void
 checker::report_error(const char *errmsg)
 {
@@ -237,18 +253,62 @@ check_manager::check_manager()
 		new deleted_node_checker("deleted-nodes")));
 }
 
+void
+check_manager::visit_node(device_tree *tree, const node_ptr &n,
+                          std::vector<checker*> &active, bool keep_going,
+                          bool &success)
+{
+	for (auto i=active.begin() ; i!=active.end() ; )
+	{
+		if ((*i)->enter_node(tree, n))
+		{
+			++i;
+		}
+		else
+		{
+			// A checker that fails stops visiting the rest of the
+			// tree, just as it did when it drove its own walk.
+			success = false;
+			i = active.erase(i);
+		}
+	}
+	if (!(success || keep_going))
+	{
+		active.clear();
+	}
+	if (active.empty())
+	{
+		return;
+	}
+	for (node::child_iterator i=n->child_begin(), e=n->child_end() ; i!=e ;
+	     ++i)
+	{
+		visit_node(tree, *i, active, keep_going, success);
+		if (active.empty())
+		{
+			return;
+		}
+	}
+	for (auto &c : active)
+	{
+		c->leave_node();
+	}
+}
+
 bool
 check_manager::run_checks(device_tree *tree, bool keep_going)
 {
+	// The checks are all independent reads, so instead of walking the
+	// tree once per checker we walk it once and dispatch each node to
+	// every checker that has not yet failed.
 	bool success = true;
+	std::vector<checker*> active;
+	active.reserve(checkers.size());
 	for (auto &i : checkers)
 	{
-		success &= i.second->check_tree(tree);
-		if (!(success || keep_going))
-		{
-			break;
-		}
+		active.push_back(i.second);
 	}
+	visit_node(tree, tree->get_root(), active, keep_going, success);
 	return success;
 }
 
@@ -107,6 +107,19 @@ class checker
 	{
 		return visit_node(tree, tree->get_root());
 	}
+	/**
+	 * Visits a single node: records it on the error-reporting path and
+	 * runs the node and property checks.  Returns false if any check
+	 * failed, in which case the node remains on the path so that error
+	 * messages identify it.  Used by the check manager to run all of the
+	 * checkers over a single walk of the tree.
+	 */
+	bool enter_node(device_tree *tree, const node_ptr &n);
+	/**
+	 * Removes the most recently entered node from the error-reporting
+	 * path.  Must balance a successful enter_node() call.
+	 */
+	void leave_node();
 };
 
 /**
@@ -279,6 +292,15 @@ class check_manager
 	void add_property_size_checker(const char *name,
 	                               const std::string &prop,
 	                               uint32_t size);
+	/**
+	 * Helper function that dispatches a node, then its children, to every
+	 * checker in the active set, removing checkers from the set as they
+	 * fail.  The walk stops early if the set becomes empty or, when
+	 * keep_going is false, on the first failure.
+	 */
+	void visit_node(device_tree *tree, const node_ptr &n,
+	                std::vector<checker*> &active, bool keep_going,
+	                bool &success);
 	public:
 	/**
 	 * Delete all of the checkers that are part of this checker manager.
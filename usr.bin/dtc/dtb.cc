@@ -36,6 +36,7 @@
 #include <sys/types.h>
 #include <inttypes.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 using std::string;
@@ -100,6 +101,68 @@ binary_writer::size()
 	return buffer.size();
 }
 
+void
+mmap_writer::write_string(const string &name)
+{
+	if (base)
+	{
+		memcpy(base + offset, name.c_str(), name.size() + 1);
+	}
+	offset += name.size() + 1;
+}
+
+void
+mmap_writer::write_data(uint8_t v)
+{
+	if (base)
+	{
+		base[offset] = v;
+	}
+	offset++;
+}
+
+void
+mmap_writer::write_data(uint32_t v)
+{
+	// Newly mapped pages are zero-filled, so alignment padding only
+	// needs to advance the offset.
+	while (offset % 4 != 0)
+	{
+		offset++;
+	}
+	if (base)
+	{
+		for (int bit=24 ; bit>=0 ; bit-=8)
+		{
+			base[offset + (3 - bit/8)] = (v >> bit) & 0xff;
+		}
+	}
+	offset += 4;
+}
+
+void
+mmap_writer::write_data(uint64_t v)
+{
+	while (offset % 8 != 0)
+	{
+		offset++;
+	}
+	if (base)
+	{
+		for (int bit=56 ; bit>=0 ; bit-=8)
+		{
+			base[offset + (7 - bit/8)] = (v >> bit) & 0xff;
+		}
+	}
+	offset += 8;
+}
+
+uint32_t
+mmap_writer::size()
+{
+	return offset;
+}
+
 void
 asm_writer::write_line(const char *c)
 {
@@ -292,7 +355,15 @@ string_table::add_string(const string &str)
 		uint32_t start = size;
 		// Don't forget the trailing nul
 		size += str.size() + 1;
-		string_offsets.insert(std::make_pair(str, start));
+		// Register every suffix of the new string so that later
+		// additions can share its tail.  Insertion does not replace
+		// existing entries, so offsets that we have already handed
+		// out are unaffected.
+		for (string::size_type i=0 ; i<str.size() ; ++i)
+		{
+			string_offsets.insert(std::make_pair(str.substr(i),
+				start + i));
+		}
 		strings.push_back(str);
 		return start;
 	}
@@ -34,8 +34,8 @@
 
 #ifndef _DTB_HH_
 #define _DTB_HH_
-#include <map>
 #include <string>
+#include <unordered_map>
 
 #include <assert.h>
 
@@ -203,6 +203,56 @@ class binary_writer : public output_writer
 	void write_to_file(int fd) override;
 	uint32_t size() override;
 };
+/**
+ * Zero-copy binary writer.  This writer stores values directly into a
+ * caller-supplied memory region, in big-endian format, rather than
+ * accumulating them in an internal buffer.  It is used in two passes: with no
+ * region set it merely measures the output, allowing the caller to size an
+ * mmap'd output file, and with a region set it emits into that mapping.
+ */
+class mmap_writer : public output_writer
+{
+	/**
+	 * The start of the memory region for this section, or null during the
+	 * sizing pass.
+	 */
+	char *base;
+	/**
+	 * The number of bytes written (or measured) so far.
+	 */
+	uint32_t offset;
+	public:
+	/**
+	 * Default constructor, creates a writer in the sizing state.
+	 */
+	mmap_writer() : base(nullptr), offset(0) {}
+	/**
+	 * Sets the memory region that output should be stored into, switching
+	 * the writer from sizing to emission.
+	 */
+	void set_base(void *b)
+	{
+		base = static_cast<char*>(b);
+	}
+	/**
+	 * The binary format does not support labels, so this method does
+	 * nothing.
+	 */
+	void write_label(const std::string &) override {}
+	/**
+	 * Comments are ignored by the binary format.
+	 */
+	void write_comment(const std::string&) override {}
+	void write_string(const std::string &name) override;
+	void write_data(uint8_t v) override;
+	void write_data(uint32_t v) override;
+	void write_data(uint64_t v) override;
+	/**
+	 * Does nothing; the output is already in the file via the mapping.
+	 */
+	void write_to_file(int) override {}
+	uint32_t size() override;
+};
 /**
  * Assembly writer.  This class is responsible for writing the output in an
  * assembly format that is suitable for linking into a kernel, loader, and so
@@ -329,14 +379,16 @@ struct header
  * section.  This maintains a map from strings to their offsets in the strings
  * section.
  *
- * Note: We don't currently do suffix matching, which may save a small amount
- * of space.
+ * The format allows a string to be referenced at any offset, so a string that
+ * is a suffix of one already in the table is given an offset into the
+ * existing data rather than being stored again.
  */
 class string_table {
 	/**
-	 * Map from strings to their offset. 
+	 * Map from each string in the table, and from every suffix of each
+	 * such string, to its offset.
 	 */
-	std::map<std::string, uint32_t> string_offsets;
+	std::unordered_map<std::string, uint32_t> string_offsets;
 	/**
 	 * The strings, in the order in which they should be written to the
 	 * output.  The order must be stable - adding another string must not
@@ -173,7 +173,9 @@ main(int argc, char **argv)
 			outfile_name = optarg;
 			if (strcmp(outfile_name, "-") != 0)
 			{
-				outfile = open(optarg, O_CREAT | O_TRUNC | O_WRONLY, 0666);
+				// Open read-write so that the output can be
+				// mmap()ed for direct DTB emission.
+				outfile = open(optarg, O_CREAT | O_TRUNC | O_RDWR, 0666);
 				if (outfile == -1)
 				{
 					perror("Unable to open output file");
@@ -344,6 +346,9 @@ main(int argc, char **argv)
 
 		getrusage(RUSAGE_SELF, &r);
 		fprintf(stderr, "Peak memory usage: %ld bytes\n", r.ru_maxrss);
+		fprintf(stderr, "Phandle references: %zu resolved, %zu unresolved\n",
+				tree.resolved_fixup_count(),
+				tree.unresolved_fixup_count());
 		fprintf(stderr, "Setup and option parsing took %f seconds\n",
 				((double)(c1-c0))/CLOCKS_PER_SEC);
 		fprintf(stderr, "Parsing took %f seconds\n",
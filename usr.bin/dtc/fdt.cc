@@ -48,6 +48,7 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <errno.h>
 
@@ -59,6 +60,90 @@ namespace dtc
 namespace fdt
 {
 
+namespace
+{
+
+/**
+ * Bump allocator backing the node and property graph.  Nodes and
+ * properties are allocated in great numbers while parsing and survive
+ * until the output is written, which for a one-shot compiler is the
+ * lifetime of the process.  Serving them from large chunks removes the
+ * per-object malloc / free round trips; the chunks themselves are
+ * reclaimed by the operating system at exit.
+ */
+class tree_arena
+{
+	/**
+	 * Granularity of the chunks that back the arena.
+	 */
+	static const size_t chunk_size = 1 << 20;
+	/**
+	 * The chunks allocated so far.
+	 */
+	std::vector<std::unique_ptr<char[]>> chunks;
+	/**
+	 * The next free byte in the current chunk.
+	 */
+	char *next = nullptr;
+	/**
+	 * The number of bytes left in the current chunk.
+	 */
+	size_t remaining = 0;
+	public:
+	/**
+	 * Returns a pointer to storage of (at least) the requested size.
+	 */
+	void *allocate(size_t size)
+	{
+		// Preserve alignment for the next allocation.
+		size = (size + 15) & ~static_cast<size_t>(15);
+		if (size > remaining)
+		{
+			size_t this_chunk = std::max(size, chunk_size);
+			chunks.emplace_back(new char[this_chunk]);
+			next = chunks.back().get();
+			remaining = this_chunk;
+		}
+		void *allocation = next;
+		next += size;
+		remaining -= size;
+		return allocation;
+	}
+};
+
+/**
+ * Returns the arena used for the current compilation.
+ */
+tree_arena &arena()
+{
+	static tree_arena a;
+	return a;
+}
+
+} // anonymous namespace
+
+void *
+property::operator new(size_t size)
+{
+	return arena().allocate(size);
+}
+
+void
+property::operator delete(void *)
+{
+}
+
+void *
+node::operator new(size_t size)
+{
+	return arena().allocate(size);
+}
+
+void
+node::operator delete(void *)
+{
+}
+
 uint32_t
 property_value::get_as_uint32()
 {
@@ -437,19 +522,16 @@ property::property(input_buffer &structs, input_buffer &strings)
 	if (!length)
 		return;
 
-	// Read the value
-	uint8_t byte;
+	// Read the value in one copy, sized exactly.  Generated blobs can
+	// carry payload properties of many megabytes, so this path must not
+	// buffer byte-at-a-time or copy the value more than once.
 	property_value v;
-	for (uint32_t i=0 ; i<length ; i++)
+	if (!(valid = structs.consume_bytes(v.byte_data, length)))
 	{
-		if (!(valid = structs.consume_binary(byte)))
-		{
-			fprintf(stderr, "Failed to read property value\n");
-			return;
-		}
-		v.byte_data.push_back(byte);
+		fprintf(stderr, "Failed to read property value\n");
+		return;
 	}
-	values.push_back(v);
+	values.push_back(std::move(v));
 }
 
 void property::parse_define(text_input_buffer &input, define_map *defines)
@@ -1178,6 +1260,7 @@ void
 device_tree::collect_names_recursive(node_ptr &n, node_path &path)
 {
 	path.push_back(std::make_pair(n->name, n->unit_address));
+	path_index.insert(std::make_pair(path.to_string(), n.get()));
 	for (const string &name : n->labels)
 	{
 		if (name != string())
@@ -1243,6 +1326,7 @@ device_tree::collect_names()
 	node_path p;
 	node_names.clear();
 	node_paths.clear();
+	path_index.clear();
 	cross_references.clear();
 	fixups.clear();
 	collect_names_recursive(root, p);
@@ -1312,7 +1396,12 @@ device_tree::resolve_cross_references(uint32_t &phandle)
 {
 	for (auto *pv : cross_references)
 	{
-		node_path path = node_paths[pv->string_data];
+		auto path_it = node_paths.find(pv->string_data);
+		if (path_it == node_paths.end())
+		{
+			continue;
+		}
+		const node_path &path = path_it->second;
 		auto p = path.begin();
 		auto pe = path.end();
 		if (p != pe)
@@ -1359,9 +1448,24 @@ device_tree::resolve_cross_references(uint32_t &phandle)
 		string target_name = i.get().val.string_data;
 		node *target = nullptr;
 		string possible;
-		// If the node name is a path, then look it up by following the path,
-		// otherwise jump directly to the named node.
+		// If the node name is a path, then look it up in the path
+		// index, otherwise jump directly to the named node.
 		if (target_name[0] == '/')
+		{
+			auto found = path_index.find(target_name);
+			if (found != path_index.end())
+			{
+				target = found->second;
+			}
+		}
+		else
+		{
+			target = node_names[target_name];
+		}
+		// Fall back to following the path from the root.  This only
+		// happens for paths that do not resolve in the index, where the
+		// walk collects the near-miss used in the error message below.
+		if ((target == nullptr) && (target_name[0] == '/'))
 		{
 			string path;
 			target = root.get();
@@ -1412,10 +1516,6 @@ device_tree::resolve_cross_references(uint32_t &phandle)
 				}
 			}
 		}
-		else
-		{
-			target = node_names[target_name];
-		}
 		if (target == nullptr)
 		{
 			if (is_plugin)
@@ -1527,14 +1627,13 @@ device_tree::parse_file(text_input_buffer &input,
 }
 
 template<class writer> void
-device_tree::write(int fd)
+device_tree::write_sections(writer &head_writer,
+                            writer &reservation_writer,
+                            writer &struct_writer,
+                            writer &strings_writer,
+                            dtb::header &head)
 {
 	dtb::string_table st;
-	dtb::header head;
-	writer head_writer;
-	writer reservation_writer;
-	writer struct_writer;
-	writer strings_writer;
 
 	// Build the reservation table
 	reservation_writer.write_comment(string("Memory reservations"));
@@ -1587,7 +1686,19 @@ device_tree::write(int fd)
 	head.boot_cpuid_phys = boot_cpu;
 	head.size_dt_struct = struct_writer.size();
 	head.write(head_writer);
+}
+
+template<class writer> void
+device_tree::write(int fd)
+{
+	dtb::header head;
+	writer head_writer;
+	writer reservation_writer;
+	writer struct_writer;
+	writer strings_writer;
 
+	write_sections(head_writer, reservation_writer, struct_writer,
+		strings_writer, head);
 	head_writer.write_to_file(fd);
 	reservation_writer.write_to_file(fd);
 	struct_writer.write_to_file(fd);
@@ -1612,7 +1723,56 @@ device_tree::referenced_node(property_value &v)
 void
 device_tree::write_binary(int fd)
 {
-	write<dtb::binary_writer>(fd);
+	struct stat sb;
+
+	// The zero-copy path needs a regular file that can be mapped
+	// writable; fall back to the buffering writer for pipes and other
+	// special files, or if the file was not opened for reading.
+	if ((fstat(fd, &sb) != 0) || !S_ISREG(sb.st_mode))
+	{
+		write<dtb::binary_writer>(fd);
+		return;
+	}
+	// First pass: measure the sections to learn the total size and the
+	// offset of each section, without writing anything.
+	dtb::header head;
+	{
+		dtb::mmap_writer head_writer;
+		dtb::mmap_writer reservation_writer;
+		dtb::mmap_writer struct_writer;
+		dtb::mmap_writer strings_writer;
+
+		write_sections(head_writer, reservation_writer, struct_writer,
+			strings_writer, head);
+	}
+	if (ftruncate(fd, head.totalsize) != 0)
+	{
+		write<dtb::binary_writer>(fd);
+		return;
+	}
+	void *map = mmap(0, head.totalsize, PROT_READ | PROT_WRITE,
+			MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+	{
+		write<dtb::binary_writer>(fd);
+		return;
+	}
+	// Second pass: emit each section directly into the mapped output
+	// file.  The sections are built identically in both passes, so the
+	// sizes computed above are exact.
+	char *out = static_cast<char*>(map);
+	dtb::mmap_writer head_writer;
+	dtb::mmap_writer reservation_writer;
+	dtb::mmap_writer struct_writer;
+	dtb::mmap_writer strings_writer;
+
+	head_writer.set_base(out);
+	reservation_writer.set_base(out + head.off_mem_rsvmap);
+	struct_writer.set_base(out + head.off_dt_struct);
+	strings_writer.set_base(out + head.off_dt_strings);
+	write_sections(head_writer, reservation_writer, struct_writer,
+		strings_writer, head);
+	munmap(map, head.totalsize);
 }
 
 void
@@ -1967,6 +2127,12 @@ device_tree::parse_dts(const string &fn, FILE *depfile)
 		
 		// Create a local_fixups node that is initially empty.
 		node_ptr local_fixups = node::create_special_node("__local_fixups__", symbols);
+		// Mapping from each partial path to its node in the
+		// __local_fixups__ subtree.  Fixups in related nodes share path
+		// prefixes, so each component is created once and later fixups
+		// find it with a hash lookup rather than a scan of the children
+		// at every level.
+		std::unordered_map<string, node*> fixup_nodes;
 		for (auto &i : fixups)
 		{
 			if (!i.val.is_phandle())
@@ -1974,6 +2140,7 @@ device_tree::parse_dts(const string &fn, FILE *depfile)
 				continue;
 			}
 			node *n = local_fixups.get();
+			string prefix;
 			for (auto &p : i.path)
 			{
 				// Skip the implicit root
@@ -1981,25 +2148,24 @@ device_tree::parse_dts(const string &fn, FILE *depfile)
 				{
 					continue;
 				}
-				bool found = false;
-				for (auto &c : n->child_nodes())
+				string element = p.first;
+				if (!(p.second.empty()))
 				{
-					if (c->name == p.first)
-					{
-						string path = p.first;
-						if (!(p.second.empty()))
-						{
-							path += '@';
-							path += p.second;
-						}
-						n->add_child(node::create_special_node(path, symbols));
-						n = (--n->child_end())->get();
-					}
+					element += '@';
+					element += p.second;
 				}
-				if (!found)
+				prefix += '/';
+				prefix += element;
+				auto existing = fixup_nodes.find(prefix);
+				if (existing == fixup_nodes.end())
 				{
-					n->add_child(node::create_special_node(p.first, symbols));
+					n->add_child(node::create_special_node(element, symbols));
 					n = (--n->child_end())->get();
+					fixup_nodes.insert(std::make_pair(prefix, n));
+				}
+				else
+				{
+					n = existing->second;
 				}
 			}
 			assert(n);
@@ -315,6 +315,16 @@ class property
 	         bool terminated,
 	         define_map *defines);
 	public:
+	/**
+	 * Allocates properties from the tree arena.  Properties live until
+	 * the compiler exits, so they are bump-allocated and reclaimed
+	 * wholesale rather than individually freed.
+	 */
+	static void *operator new(size_t size);
+	/**
+	 * No-op.  Arena storage is reclaimed when the process exits.
+	 */
+	static void operator delete(void *ptr);
 	/**
 	 * Creates an empty property.
 	 */
@@ -532,6 +542,16 @@ class node
 	 */
 	static inline bool cmp_children(node_ptr &c1, node_ptr &c2);
 	public:
+	/**
+	 * Allocates nodes from the tree arena.  Nodes live until the
+	 * compiler exits, so they are bump-allocated and reclaimed
+	 * wholesale rather than individually freed.
+	 */
+	static void *operator new(size_t size);
+	/**
+	 * No-op.  Arena storage is reclaimed when the process exits.
+	 */
+	static void operator delete(void *ptr);
 	/**
 	 * Sorts the node's properties and children into alphabetical order and
 	 * recursively sorts the children.
@@ -729,6 +749,13 @@ class device_tree
 	 * duplicate names are stored as (node*)-1.
 	 */
 	std::unordered_map<std::string, node*> node_names;
+	/**
+	 * Mapping from fully qualified paths to nodes.  This is rebuilt
+	 * whenever names are collected and is used to resolve path
+	 * references, such as overlay fragment targets, without walking the
+	 * tree for every lookup.
+	 */
+	std::unordered_map<std::string, node*> path_index;
 	/**
 	 * A map from labels to node paths.  When resolving cross references,
 	 * we look up referenced nodes in this and replace the cross reference
@@ -865,6 +892,19 @@ class device_tree
 	 */
 	template<class writer>
 	void write(int fd);
+	/**
+	 * Template function that writes the four sections of the blob through
+	 * the supplied writers and fills in the header to match.  This is
+	 * shared between the buffering output path and the two-pass mmap
+	 * output path, which runs it once to size the blob and again to emit
+	 * it.
+	 */
+	template<class writer>
+	void write_sections(writer &head_writer,
+	                    writer &reservation_writer,
+	                    writer &struct_writer,
+	                    writer &strings_writer,
+	                    dtb::header &head);
 	public:
 	/**
 	 * Should we write the __symbols__ node (to allow overlays to be linked
@@ -932,6 +972,23 @@ class device_tree
 	{
 		return valid;
 	}
+	/**
+	 * Returns the number of phandle references that were resolved to
+	 * nodes within this tree.
+	 */
+	inline size_t resolved_fixup_count()
+	{
+		return fixups.size() - unresolved_fixups.size();
+	}
+	/**
+	 * Returns the number of phandle references that refer to labels
+	 * outside this tree and were recorded in /__fixups__ for resolution
+	 * when the plugin is applied.
+	 */
+	inline size_t unresolved_fixup_count()
+	{
+		return unresolved_fixups.size();
+	}
 	/**
 	 * Sets the format for writing phandle properties.
 	 */
@@ -41,6 +41,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <functional>
+#include <unordered_map>
 #ifndef NDEBUG
 #include <iostream>
 #endif
@@ -103,6 +104,34 @@ struct stream_input_buffer : public dtc::input_buffer
 	 */
 	stream_input_buffer();
 };
+/**
+ * Input buffer that refers into the memory of a cached buffer, with its own
+ * cursor.  Keeps the owning buffer alive for as long as the view exists.
+ */
+struct shared_input_buffer : public dtc::input_buffer
+{
+	/**
+	 * The buffer that owns the memory this view refers to.
+	 */
+	std::shared_ptr<dtc::input_buffer> owner;
+	const string &filename() const override
+	{
+		return owner->filename();
+	}
+	/**
+	 * Constructs a new view of the memory owned by the argument.
+	 */
+	shared_input_buffer(const std::shared_ptr<dtc::input_buffer> &b)
+		: input_buffer(b->begin(), b->end() - b->begin()), owner(b) {}
+};
+/**
+ * Returns whether the argument is whitespace in DTS.
+ */
+inline bool is_whitespace(char c)
+{
+	return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\f')
+	       || (c == '\v') || (c == '\r');
+}
 
 mmap_input_buffer::mmap_input_buffer(int fd, string &&filename)
 	: input_buffer(0, 0), fn(filename)
@@ -150,18 +179,61 @@ namespace dtc
 void
 input_buffer::skip_to(char c)
 {
-	while ((cursor < size) && (buffer[cursor] != c))
+	if (cursor >= size)
 	{
-		cursor++;
+		return;
 	}
+	const char *found = static_cast<const char*>(
+		memchr(buffer + cursor, c, size - cursor));
+	cursor = found ? found - buffer : size;
 }
 
 void
 text_input_buffer::skip_to(char c)
 {
-	while (!finished() && (*(*this) != c))
+	// Scan each buffer in a single memchr() call, rather than one
+	// character at a time.
+	while (!input_stack.empty())
+	{
+		auto &top = *input_stack.top();
+		const char *start = top.buffer + top.cursor;
+		const char *found = static_cast<const char*>(
+			memchr(start, c, top.size - top.cursor));
+		if (found != nullptr)
+		{
+			skip_bytes(found - start);
+			return;
+		}
+		skip_bytes(top.size - top.cursor);
+	}
+}
+
+bool
+input_buffer::consume_bytes(byte_buffer &b, uint32_t length)
+{
+	if ((cursor < 0) || (cursor > size) ||
+	    (length > (uint32_t)(size - cursor)))
+	{
+		return false;
+	}
+	b.insert(b.end(), buffer + cursor, buffer + cursor + length);
+	cursor += length;
+	return true;
+}
+
+void
+text_input_buffer::skip_bytes(int n)
+{
+	if (input_stack.empty())
 	{
-		++(*this);
+		return;
+	}
+	auto &top = *input_stack.top();
+	top.cursor += n;
+	cursor += n;
+	if (top.finished())
+	{
+		input_stack.pop();
 	}
 }
 
@@ -171,11 +243,21 @@ text_input_buffer::skip_spaces()
 	if (finished()) { return; }
 	char c = *(*this);
 	bool last_nl = false;
-	while ((c == ' ') || (c == '\t') || (c == '\n') || (c == '\f')
-	       || (c == '\v') || (c == '\r'))
-	{
-		last_nl = ((c == '\n') || (c == '\r'));
-		++(*this);
+	// Consume whitespace a run at a time with direct scans of the
+	// current buffer, instead of going through the one-character
+	// interface for every byte.
+	while (is_whitespace(c))
+	{
+		auto &top = *input_stack.top();
+		const char *start = top.buffer + top.cursor;
+		const char *end = top.buffer + top.size;
+		const char *p = start;
+		while ((p != end) && is_whitespace(*p))
+		{
+			p++;
+		}
+		last_nl = ((p[-1] == '\n') || (p[-1] == '\r'));
+		skip_bytes(p - start);
 		if (finished())
 		{
 			c = '\0';
@@ -226,13 +308,13 @@ text_input_buffer::handle_include()
 		return;
 	}
 	string include_file = dir + '/' + file;
-	auto include_buffer = input_buffer::buffer_for_file(include_file, false);
+	auto include_buffer = input_buffer::cached_buffer_for_file(include_file);
 	if (include_buffer == 0)
 	{
 		for (auto i : include_paths)
 		{
 			include_file = i + '/' + file;
-			include_buffer = input_buffer::buffer_for_file(include_file, false);
+			include_buffer = input_buffer::cached_buffer_for_file(include_file);
 			if (include_buffer != 0)
 			{
 				break;
@@ -1010,10 +1092,7 @@ text_input_buffer::next_token()
 			++self;
 			do {
 				// Find the ending * of */
-				while ((*self != '\0') && (*self != '*') && !finished())
-				{
-					++self;
-				}
+				skip_to('*');
 				// Eat the *
 				++self;
 			} while ((*self != '\0') && (*self != '/') && !finished());
@@ -1027,10 +1106,7 @@ text_input_buffer::next_token()
 			++self;
 			++self;
 			// Find the ending of the line
-			while (*self != '\n' && !finished())
-			{
-				++self;
-			}
+			skip_to('\n');
 			// Eat the \n
 			++self;
 		}
@@ -1264,5 +1340,25 @@ input_buffer::buffer_for_file(const string &path, bool warn)
 	return b;
 }
 
+std::shared_ptr<input_buffer>
+input_buffer::cached_buffer_for_file(const string &path)
+{
+	static std::unordered_map<string, std::shared_ptr<input_buffer>> cache;
+	auto cached = cache.find(path);
+	if (cached == cache.end())
+	{
+		// Cache failed lookups as well, so that each candidate
+		// include path is probed at most once per file.
+		cached = cache.insert(std::make_pair(path,
+			std::shared_ptr<input_buffer>(
+				buffer_for_file(path, false)))).first;
+	}
+	if (!cached->second)
+	{
+		return nullptr;
+	}
+	return std::make_shared<shared_input_buffer>(cached->second);
+}
+
 } // namespace dtc
 
@@ -96,6 +96,18 @@ class input_buffer
 	}
 	static std::unique_ptr<input_buffer> buffer_for_file(const std::string &path,
 	                                                     bool warn=true);
+	/**
+	 * Returns a buffer for the specified file, sharing the underlying
+	 * memory with any other buffer for the same path returned by this
+	 * function.  Each file is opened and mapped at most once per
+	 * invocation; later requests, including ones for paths that turned
+	 * out not to exist, are answered from a cache.  Each returned buffer
+	 * has its own cursor.  This is used for /include/ handling, where the
+	 * same file is commonly included several times and each inclusion
+	 * probes every include path.
+	 */
+	static std::shared_ptr<input_buffer> cached_buffer_for_file(
+			const std::string &path);
 	/**
 	 * Skips all characters in the input until the specified character is
 	 * encountered.
@@ -215,6 +227,15 @@ class input_buffer
 	 * cursor in place.
 	 */
 	bool consume_hex_byte(uint8_t &outByte);
+	/**
+	 * Consumes the specified number of bytes from the input, appending
+	 * them to the provided buffer in a single copy.  Returns true and
+	 * advances the cursor if enough input remains, returns false and
+	 * leaves the cursor in place otherwise.  The destination grows by
+	 * exactly the requested amount, avoiding the churn of appending one
+	 * byte at a time.
+	 */
+	bool consume_bytes(byte_buffer &b, uint32_t length);
 	/**
 	 * Template function that consumes a binary value in big-endian format
 	 * from the input stream.  Returns true and advances the cursor if
@@ -297,6 +318,14 @@ class text_input_buffer
 	 * sensitive and so we want to scan past whitespace when reading it.
 	 */
 	void skip_spaces();
+	/**
+	 * Advances the cursor of the current input buffer by the specified
+	 * number of characters, popping the buffer from the stack if it is
+	 * exhausted.  This is used by the scanning functions, which compute
+	 * the length of a run directly from the buffer contents instead of
+	 * advancing one character at a time.
+	 */
+	void skip_bytes(int n);
 	/**
 	 * Returns the character immediately after the current one.
 	 *
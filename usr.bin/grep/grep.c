@@ -84,6 +84,7 @@ unsigned int	 patterns;
 static unsigned int pattern_sz;
 struct pat	*pattern;
 regex_t		*r_pattern;
+bool		 fixedfast;	/* Use the byte-exact literal matcher */
 
 /* Filename exclusion/inclusion patterns */
 unsigned int	fpatterns, dpatterns;
@@ -697,6 +698,16 @@ main(int argc, char *argv[])
 		usage();
 	}
 
+	/*
+	 * Fixed-string patterns can bypass regexec(3) entirely when a
+	 * match is just a byte comparison: no case folding and a
+	 * single-byte locale, so that the literal matcher cannot
+	 * disagree with regex(3) about multibyte sequences.  The
+	 * patterns are still compiled below so that everything else
+	 * can fall back to regexec(3).
+	 */
+	fixedfast = grepbehave == GREP_FIXED && !iflag && MB_CUR_MAX == 1;
+
 	r_pattern = grep_calloc(patterns, sizeof(*r_pattern));
 
 	/* Don't process any patterns if we have a blank one */
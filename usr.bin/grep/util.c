@@ -446,6 +446,42 @@ litexec(const struct pat *pat, const char *string, size_t nmatch,
 }
 #endif /* WITH_INTERNAL_NOSPEC */
 
+/*
+ * Byte-exact search for a fixed-string pattern, used instead of
+ * regexec(3) when fixedfast is set.  memchr(3) skips ahead to
+ * candidate positions for the first pattern byte and memcmp(3)
+ * verifies the remainder, so the bulk of the scanning runs in the
+ * vectorized libc primitives.  The interface mirrors the way
+ * procline() calls regexec(3) with REG_STARTEND: the search window is
+ * taken from pmatch[0] and the leftmost match is returned in it.
+ */
+static int
+fixedexec(const struct pat *pat, const char *string, size_t nmatch,
+    regmatch_t pmatch[])
+{
+	const char *m, *s, *end;
+	size_t len;
+
+	len = pat->len;
+	s = string + pmatch[0].rm_so;
+	end = string + pmatch[0].rm_eo;
+	for (;;) {
+		if (len > (size_t)(end - s))
+			return (REG_NOMATCH);
+		m = memchr(s, pat->pat[0], end - s - len + 1);
+		if (m == NULL)
+			return (REG_NOMATCH);
+		if (memcmp(m, pat->pat, len) == 0)
+			break;
+		s = m + 1;
+	}
+	if (nmatch > 0) {
+		pmatch[0].rm_so = m - string;
+		pmatch[0].rm_eo = (m - string) + len;
+	}
+	return (0);
+}
+
 #define iswword(x)	(iswalnum((x)) || (x) == L'_')
 
 /*
@@ -498,13 +534,17 @@ procline(struct parsec *pc)
 		for (i = 0; i < patterns; i++) {
 			pmatch.rm_so = st;
 			pmatch.rm_eo = pc->ln.len;
+			if (fixedfast)
+				r = fixedexec(&pattern[i], pc->ln.dat, 1,
+				    &pmatch);
 #ifdef WITH_INTERNAL_NOSPEC
-			if (grepbehave == GREP_FIXED)
-				r = litexec(&pattern[i], pc->ln.dat, 1, &pmatch);
-			else
+			else if (grepbehave == GREP_FIXED)
+				r = litexec(&pattern[i], pc->ln.dat, 1,
+				    &pmatch);
 #endif
-			r = regexec(&r_pattern[i], pc->ln.dat, 1, &pmatch,
-			    leflags);
+			else
+				r = regexec(&r_pattern[i], pc->ln.dat, 1,
+				    &pmatch, leflags);
 			if (r != 0)
 				continue;
 			/* Check for full match */
@@ -624,7 +624,13 @@ file_reader_init(const char *fsrc)
 
 	ret->fname = sort_strdup(fsrc);
 
-	if (strcmp(fsrc, "-") && (compress_program == NULL) && use_mmap) {
+	/*
+	 * Our own temporary files hold sorted runs and are always
+	 * plain files when no compress program is set, so map them
+	 * unconditionally; --mmap is only needed for user input.
+	 */
+	if (strcmp(fsrc, "-") && (compress_program == NULL) &&
+	    (use_mmap || file_is_tmp(fsrc))) {
 
 		do {
 			struct stat stat_buf;
@@ -1144,6 +1150,39 @@ merge_files_array(size_t argc, const char **argv, const char *fn_out)
 	}
 }
 
+#if defined(SORT_THREADS)
+/* semaphore to limit the number of merge threads */
+static sem_t mergesem;
+
+struct merge_work
+{
+	const char	**fns;
+	size_t		  num;
+	const char	 *fn_out;
+	bool		  unlink_src;
+};
+
+/*
+ * Merge one group of files in its own thread.
+ */
+static void *
+merge_files_thread(void *arg)
+{
+	struct merge_work *mw = arg;
+	size_t i;
+
+	merge_files_array(mw->num, mw->fns, mw->fn_out);
+	if (mw->unlink_src) {
+		for (i = 0; i < mw->num; i++)
+			unlink(mw->fns[i]);
+	}
+	sort_free(mw);
+	sem_post(&mergesem);
+
+	return (NULL);
+}
+#endif /* defined(SORT_THREADS) */
+
 /*
  * Shrinks the file list until its size smaller than max number of opened files
  */
@@ -1156,6 +1195,20 @@ shrink_file_list(struct file_list *fl)
 	else {
 		struct file_list new_fl;
 		size_t indx = 0;
+#if defined(SORT_THREADS)
+		bool mt;
+
+		/*
+		 * The merges of the separate file groups are
+		 * independent of each other and can run on the thread
+		 * pool; the semaphore keeps at most nthreads of them
+		 * in flight so that memory use and the number of open
+		 * file descriptors stay bounded.
+		 */
+		mt = nthreads > 1;
+		if (mt)
+			sem_init(&mergesem, 0, nthreads);
+#endif
 
 		file_list_init(&new_fl, true);
 		while (indx < fl->count) {
@@ -1167,16 +1220,62 @@ shrink_file_list(struct file_list *fl)
 
 			if ((size_t) num >= max_open_files)
 				num = max_open_files - 1;
-			merge_files_array(num, fl->fns + indx, fnew);
-			if (fl->tmp) {
-				size_t i;
+#if defined(SORT_THREADS)
+			if (mt) {
+				struct merge_work *mw;
+				pthread_t pth;
+				pthread_attr_t attr;
+
+				mw = sort_malloc(sizeof(*mw));
+				mw->fns = fl->fns + indx;
+				mw->num = num;
+				mw->fn_out = fnew;
+				mw->unlink_src = fl->tmp;
+
+				sem_wait(&mergesem);
+
+				pthread_attr_init(&attr);
+				pthread_attr_setdetachstate(&attr,
+				    PTHREAD_DETACHED);
+
+				for (;;) {
+					int res = pthread_create(&pth, &attr,
+					    merge_files_thread, mw);
+
+					if (res >= 0)
+						break;
+					if (errno == EAGAIN) {
+						pthread_yield();
+						continue;
+					}
+					err(2, NULL);
+				}
 
-				for (i = 0; i < num; i++)
-					unlink(fl->fns[indx + i]);
+				pthread_attr_destroy(&attr);
+			} else
+#endif
+			{
+				merge_files_array(num, fl->fns + indx, fnew);
+				if (fl->tmp) {
+					size_t i;
+
+					for (i = 0; i < num; i++)
+						unlink(fl->fns[indx + i]);
+				}
 			}
 			file_list_add(&new_fl, fnew, false);
 			indx += num;
 		}
+#if defined(SORT_THREADS)
+		if (mt) {
+			size_t i;
+
+			/* wait for merge threads completion */
+			for (i = 0; i < nthreads; ++i)
+				sem_wait(&mergesem);
+			sem_destroy(&mergesem);
+		}
+#endif
 		fl->tmp = false; /* already taken care of */
 		file_list_clean(fl);
 
@@ -35,6 +35,7 @@ __FBSDID("$FreeBSD$");
 #include <capsicum_helpers.h>
 #include <err.h>
 #include <errno.h>
+#include <stdlib.h>
 #include <utmpx.h>
 
 #include <algorithm>
@@ -47,7 +48,8 @@ using namespace std;
 int
 main(int argc, char **)
 {
-	struct utmpx *ut;
+	struct utmpx *uts;
+	size_t i, n;
 	set<string> names;
 
 	if (argc > 1) {
@@ -60,11 +62,16 @@ main(int argc, char **)
 	if (caph_enter())
 		err(1, "Failed to enter capability mode.");
 
-	while ((ut = getutxent()) != NULL)
-		if (ut->ut_type == USER_PROCESS)
-			names.insert(ut->ut_user);
+	/* Read the whole database in one go instead of per record. */
+	if (getutxents(&uts, &n) != 0)
+		err(1, "getutxents");
 	endutxent();
 
+	for (i = 0; i < n; i++)
+		if (uts[i].ut_type == USER_PROCESS)
+			names.insert(uts[i].ut_user);
+	free(uts);
+
 	if (!names.empty()) {
 		set<string>::iterator last = names.end();
 		--last;
@@ -112,11 +112,12 @@ static uid_t uid;
 static int dobackup, docompare, dodir, dolink, dopreserve, dostrip, dounpriv,
     safecopy, verbose;
 static int haveopt_f, haveopt_g, haveopt_m, haveopt_o;
+static int maxjobs = 1;
 static mode_t mode = S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH;
 static FILE *metafp;
 static const char *group, *owner;
 static const char *suffix = BACKUP_SUFFIX;
-static char *destdir, *digest, *fflags, *metafile, *tags;
+static char *destdir, *digest, *fflags, *manifest, *metafile, *tags;
 
 static int	compare(int, const char *, size_t, int, const char *, size_t,
 		    char **);
@@ -133,6 +134,7 @@ static void	do_symlink(const char *, const char *, const struct stat *);
 static void	makelink(const char *, const char *, const struct stat *);
 static void	install(const char *, const char *, u_long, u_int);
 static void	install_dir(char *);
+static int	install_manifest(const char *, u_long, u_int);
 static void	metadata_log(const char *, const char *, struct timespec *,
 		    const char *, const char *, off_t);
 static int	parseid(const char *, id_t *);
@@ -154,8 +156,8 @@ main(int argc, char *argv[])
 	fset = 0;
 	iflags = 0;
 	group = owner = NULL;
-	while ((ch = getopt(argc, argv, "B:bCcD:df:g:h:l:M:m:N:o:pSsT:Uv")) !=
-	     -1)
+	while ((ch = getopt(argc, argv, "B:bCcD:dF:f:g:h:j:l:M:m:N:o:pSsT:Uv"))
+	     != -1)
 		switch((char)ch) {
 		case 'B':
 			suffix = optarg;
@@ -175,6 +177,9 @@ main(int argc, char *argv[])
 		case 'd':
 			dodir = 1;
 			break;
+		case 'F':
+			manifest = optarg;
+			break;
 		case 'f':
 			haveopt_f = 1;
 			fflags = optarg;
@@ -186,6 +191,12 @@ main(int argc, char *argv[])
 		case 'h':
 			digest = optarg;
 			break;
+		case 'j':
+			maxjobs = (int)strtol(optarg, &p, 10);
+			if (*p != '\0' || maxjobs < 1)
+				errx(EX_USAGE, "invalid number of jobs: %s",
+				     optarg);
+			break;
 		case 'l':
 			for (p = optarg; *p != '\0'; p++)
 				switch (*p) {
@@ -270,8 +281,17 @@ main(int argc, char *argv[])
 		dostrip = 0;
 	}
 
-	/* must have at least two arguments, except when creating directories */
-	if (argc == 0 || (argc == 1 && !dodir))
+	/* a manifest names the files itself and is incompatible with -d */
+	if (manifest != NULL && (dodir || argc != 0)) {
+		warnx("-F may not be combined with -d or file operands");
+		usage();
+	}
+
+	/*
+	 * must have at least two arguments, except when creating directories
+	 * or installing from a manifest
+	 */
+	if (manifest == NULL && (argc == 0 || (argc == 1 && !dodir)))
 		usage();
 
 	if (digest != NULL) {
@@ -337,6 +357,11 @@ main(int argc, char *argv[])
 		/* NOTREACHED */
 	}
 
+	if (manifest != NULL) {
+		exit(install_manifest(manifest, fset, iflags));
+		/* NOTREACHED */
+	}
+
 	to_name = argv[argc - 1];
 	no_target = stat(to_name, &to_sb);
 	if (!no_target && S_ISDIR(to_sb.st_mode)) {
@@ -1358,6 +1383,94 @@ again:
 	metadata_log(path, "dir", NULL, NULL, NULL, 0);
 }
 
+/*
+ * install_manifest --
+ *	install every "source target" pair listed in a manifest file,
+ *	forking worker processes when -j asks for more than one
+ */
+static int
+install_manifest(const char *name, u_long fset, u_int flags)
+{
+	FILE *fp;
+	struct stat to_sb;
+	char *from_name, *line, *to_name;
+	size_t linecap;
+	ssize_t linelen;
+	long entry;
+	pid_t pid;
+	int error, slot, status, workers;
+
+	if (maxjobs > 1 && strcmp(name, "-") == 0)
+		errx(EX_USAGE, "-j requires the manifest to be a file");
+
+	/*
+	 * Manifest entries name independent targets, so they can be dealt
+	 * round-robin to identical workers: worker N installs the entries
+	 * whose number modulo the worker count is N.  Fork before opening
+	 * the manifest so that every worker reads at its own offset; the
+	 * shared metadata log stays coherent because metadata_log() takes
+	 * a file lock around each record.
+	 */
+	slot = 0;
+	for (workers = 1; workers < maxjobs; workers++) {
+		pid = fork();
+		if (pid == -1) {
+			/* Make do with the workers forked so far. */
+			warn("fork");
+			break;
+		}
+		if (pid == 0) {
+			slot = workers;
+			break;
+		}
+	}
+
+	if (strcmp(name, "-") == 0)
+		fp = stdin;
+	else if ((fp = fopen(name, "r")) == NULL)
+		err(EX_NOINPUT, "%s", name);
+
+	entry = 0;
+	line = NULL;
+	linecap = 0;
+	while ((linelen = getline(&line, &linecap, fp)) != -1) {
+		if (line[linelen - 1] == '\n')
+			line[linelen - 1] = '\0';
+		from_name = strtok(line, " \t");
+		if (from_name == NULL || *from_name == '#')
+			continue;
+		if (entry++ % workers != slot)
+			continue;
+		to_name = strtok(NULL, " \t");
+		if (to_name == NULL)
+			errx(EX_DATAERR, "%s: missing target for %s",
+			    name, from_name);
+		if (strtok(NULL, " \t") != NULL)
+			errx(EX_DATAERR, "%s: trailing junk after %s",
+			    name, to_name);
+		if (stat(to_name, &to_sb) == 0 && S_ISDIR(to_sb.st_mode))
+			install(from_name, to_name, fset, flags | DIRECTORY);
+		else
+			install(from_name, to_name, fset, flags);
+	}
+	free(line);
+	if (ferror(fp))
+		err(EX_IOERR, "%s", name);
+	if (fp != stdin)
+		(void)fclose(fp);
+
+	/* Workers are done; the parent collects their exit status. */
+	if (slot != 0)
+		_exit(EX_OK);
+	error = EX_OK;
+	while (wait(&status) != -1)
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+			error = EX_SOFTWARE;
+	if (error != EX_OK)
+		warnx("manifest worker failed");
+	return (error);
+}
+
 /*
  * metadata_log --
  *	if metafp is not NULL, output mtree(8) full path name and settings to
@@ -1455,6 +1568,10 @@ usage(void)
 "               [-M log] [-D dest] [-h hash] [-T tags]\n"
 "               [-B suffix] [-l linkflags] [-N dbdir]\n"
 "               file1 ... fileN directory\n"
+"       install [-bCcpSsUv] [-f flags] [-g group] [-m mode] [-o owner]\n"
+"               [-M log] [-D dest] [-h hash] [-T tags]\n"
+"               [-B suffix] [-l linkflags] [-N dbdir] [-j maxjobs]\n"
+"               -F manifest\n"
 "       install -dU [-vU] [-g group] [-m mode] [-N dbdir] [-o owner]\n"
 "               [-M log] [-D dest] [-h hash] [-T tags]\n"
 "               directory ...\n");
@@ -86,6 +86,7 @@ strlst_t *buildopts = NULL;
 strlst_t *srcdirs   = NULL;
 strlst_t *libs      = NULL;
 strlst_t *libs_so   = NULL;
+strlst_t *order_list = NULL;
 prog_t   *progs     = NULL;
 
 char confname[MAXPATHLEN], infilename[MAXPATHLEN];
@@ -254,6 +255,7 @@ void add_link(int argc, char **argv);
 void add_libs(int argc, char **argv);
 void add_libs_so(int argc, char **argv);
 void add_buildopts(int argc, char **argv);
+void add_order(int argc, char **argv);
 void add_special(int argc, char **argv);
 
 prog_t *find_prog(char *str);
@@ -313,6 +315,8 @@ parse_one_file(char *filename)
 			f = add_libs_so;
 		else if(!strcmp(fieldv[0], "buildopts"))
 			f = add_buildopts;
+		else if(!strcmp(fieldv[0], "order"))
+			f = add_order;
 		else if(!strcmp(fieldv[0], "special"))
 			f = add_special;
 		else {
@@ -504,6 +508,16 @@ add_buildopts(int argc, char **argv)
 }
 
 
+void
+add_order(int argc, char **argv)
+{
+	int i;
+
+	for (i = 1; i < argc; i++)
+		add_string(&order_list, argv[i]);
+}
+
+
 void
 add_special(int argc, char **argv)
 {
@@ -593,6 +607,7 @@ prog_t *find_prog(char *str)
 
 /* helper subroutines */
 
+void order_progs(void);
 void remove_error_progs(void);
 void fillin_program(prog_t *p);
 void gen_specials_cache(void);
@@ -612,6 +627,7 @@ gen_outputs(void)
 {
 	prog_t *p;
 
+	order_progs();
 	for (p = progs; p != NULL; p = p->next)
 		fillin_program(p);
 
@@ -797,6 +813,47 @@ fillin_program_objs(prog_t *p, char *path)
 	unlink(tempfname);
 }
 
+/*
+ * pull the programs named on "order" lines to the front of the program
+ * list, hottest first.  The program order decides both the layout of the
+ * .lo objects in the final link and the scan order of the entry_points
+ * table, so frequently exec'd programs share the leading text pages and
+ * are dispatched after fewer name comparisons.
+ */
+void
+order_progs(void)
+{
+	prog_t *head, *p, **prev, *tail;
+	strlst_t *s;
+
+	if (order_list == NULL)
+		return;
+
+	head = tail = NULL;
+	for (s = order_list; s != NULL; s = s->next) {
+		for (prev = &progs; (p = *prev) != NULL; prev = &p->next)
+			if (!strcmp(p->name, s->str))
+				break;
+		if (p == NULL) {
+			warnx("%s: no prog %s declared, skipping order",
+			    infilename, s->str);
+			goterror = 1;
+			continue;
+		}
+		*prev = p->next;
+		p->next = NULL;
+		if (tail != NULL)
+			tail->next = p;
+		else
+			head = p;
+		tail = p;
+	}
+	if (tail != NULL) {
+		tail->next = progs;
+		progs = head;
+	}
+}
+
 void
 remove_error_progs(void)
 {
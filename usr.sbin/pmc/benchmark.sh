@@ -0,0 +1,53 @@
+#!/bin/sh
+# $FreeBSD$
+#
+# Benchmark harness for the pmclog toolchain.  Synthesizes log files
+# with pmclog-gen and times the pmc(8) passes over them: a plain
+# filter pass (which approximates a pure parse, since no predicates
+# are given), JSON emission, columnar emission, and summary
+# aggregation.  Each pass is run over a callchain heavy and a mapping
+# heavy log, and throughput is reported in records per second.
+#
+# Usage: benchmark.sh [path-to-pmc] [path-to-pmclog-gen] [record-count]
+
+PMC=${1:-pmc}
+GEN=${2:-pmclog-gen}
+RECORDS=${3:-1000000}
+
+TMPDIR=$(mktemp -d -t pmcbench) || exit 1
+trap 'rm -rf "$TMPDIR"' EXIT INT TERM
+
+# Run one timed pass and print its wall clock time and throughput.
+run()
+{
+	label=$1
+	nrec=$2
+	shift 2
+
+	/usr/bin/time -p "$@" > /dev/null 2> "$TMPDIR/time"
+	if [ $? -ne 0 ]; then
+		echo "$label failed; output follows" >&2
+		cat "$TMPDIR/time" >&2
+		exit 1
+	fi
+	awk -v label="$label" -v nrec="$nrec" '/^real/ {
+		if ($2 + 0 > 0)
+			printf "%-28s %8.2fs  %12.0f records/sec\n",
+			    label, $2, nrec / $2
+	}' "$TMPDIR/time"
+}
+
+for mix in callchain mapping; do
+	LOG="$TMPDIR/$mix.pmclog"
+	NREC=$("$GEN" -m "$mix" -n "$RECORDS" "$LOG") || exit 1
+
+	echo "mix: $mix ($NREC records, $(wc -c < "$LOG") bytes)"
+	run "  filter (parse)" "$NREC" \
+	    "$PMC" filter "$LOG" "$TMPDIR/out.pmclog"
+	run "  filter -j (json)" "$NREC" \
+	    "$PMC" filter -j "$LOG" "$TMPDIR/out.json"
+	run "  filter -c (columnar)" "$NREC" \
+	    "$PMC" filter -c "$LOG" "$TMPDIR/out.pmccol"
+	run "  summary" "$NREC" \
+	    "$PMC" summary "$LOG"
+done
@@ -45,9 +45,14 @@ extern "C" {
 #endif
 	int	cmd_pmc_stat(int, char **);
 	int	cmd_pmc_filter(int, char **);
+	int	cmd_pmc_filter_summary(int, char **);
 	int	cmd_pmc_stat_system(int, char **);
 	int	cmd_pmc_list_events(int, char **);
 	int	cmd_pmc_summary(int, char **);
+
+	/* In-process filter -> summary pipeline support. */
+	void	pmc_summary_observe(struct pmclog_ev *);
+	int	pmc_summary_report(int, int);
 #if defined(__cplusplus)
 };
 #endif
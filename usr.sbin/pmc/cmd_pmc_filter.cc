@@ -85,6 +85,8 @@ static struct option longopts[] = {
 	{"threads", required_argument, NULL, 'T'},
 	{"processes", required_argument, NULL, 'P'},
 	{"events", required_argument, NULL, 'e'},
+	{"columnar", no_argument, NULL, 'c'},
+	{"topk", required_argument, NULL, 'k'},
 	{NULL, 0, NULL, 0}
 };
 
@@ -93,6 +95,7 @@ usage(void)
 {
 	errx(EX_USAGE,
 	    "\t filter log file\n"
+	    "\t -c -- emit records in columnar binary form\n"
 	    "\t -e <events>, --events <events> -- comma-delimited list of events to filter on\n"
 	    "\t -p <pids>, --pids <pids> -- comma-delimited list of pids to filter on\n"
 	    "\t -P <processes>, --processes <processes> -- comma-delimited list of process names to filter on\n"
@@ -150,10 +153,6 @@ parse_names(char *strlist, char *namelist[LIST_MAX], int *pcount)
 }
 
 
-struct pmcid_ent {
-	uint32_t pe_pmcid;
-	uint32_t pe_idx;
-};
 #define	_PMCLOG_TO_HEADER(T,L)						\
 	((PMCLOG_HEADER_MAGIC << 24) |					\
 	 (PMCLOG_TYPE_ ## T << 16)   |					\
@@ -177,77 +176,108 @@ pmc_find_name(idmap & map, uint32_t id, char *list[LIST_MAX], int count)
 	return (false);
 }
 
+static void	*colstate;	/* columnar output state, if enabled */
+static bool	summarize;	/* feed records to summary aggregation */
+
+/*
+ * Most records pass through the filter, so batch them up and write in
+ * large chunks rather than issuing a write(2) per record.
+ */
+#define	OUTBUF_SIZE	(1024 * 1024)
+static char outbuf[OUTBUF_SIZE];
+static size_t outbuf_len;
+
+static void
+pmc_flush_output(int fd)
+{
+
+	if (outbuf_len == 0)
+		return;
+	if (write(fd, outbuf, outbuf_len) != (ssize_t)outbuf_len)
+		errx(EX_OSERR, "ERROR: failed output write");
+	outbuf_len = 0;
+}
+
 static void
 pmc_log_event(int fd, struct pmclog_ev *ev, bool json)
 {
-	int len;
+	static string ret;	/* reused across events */
+	size_t len;
 	const void *buf;
 
+	if (summarize) {
+		pmc_summary_observe(ev);
+		return;
+	}
+	if (colstate != NULL) {
+		pmccolumnar_append(colstate, ev);
+		return;
+	}
 	if (json) {
-		string ret = event_to_json(ev);
+		ret.clear();
+		event_to_json_buf(ev, ret);
 		buf = ret.c_str();
 		len = ret.size();
 	} else {
 		len = ev->pl_len;
 		buf = ev->pl_data;
 	}
-	if (write(fd, buf, len) != (ssize_t)len)
-		errx(EX_OSERR, "ERROR: failed output write");
+	if (len > OUTBUF_SIZE - outbuf_len)
+		pmc_flush_output(fd);
+	if (len > OUTBUF_SIZE) {
+		if (write(fd, buf, len) != (ssize_t)len)
+			errx(EX_OSERR, "ERROR: failed output write");
+		return;
+	}
+	memcpy(outbuf + outbuf_len, buf, len);
+	outbuf_len += len;
 }
 
 static void
 pmc_filter_handler(uint32_t *lwplist, int lwpcount, uint32_t *pidlist, int pidcount,
-    char *events, char *processes, char *threads, bool exclusive, bool json, int infd,
-    int outfd)
+    char *events, char *processes, char *threads, bool exclusive, bool json,
+    bool columnar, int infd, int outfd)
 {
 	struct pmclog_ev ev;
 	struct pmclog_parse_state *ps;
-	struct pmcid_ent *pe;
 	uint32_t eventlist[LIST_MAX];
 	char cpuid[PMC_CPUID_LEN];
 	char *proclist[LIST_MAX];
 	char *threadlist[LIST_MAX];
-	int i, pmccount, copies, eventcount;
+	int i, eventcount;
 	int proccount, threadcount;
 	uint32_t idx;
 	idmap pidmap, tidmap;
+	unordered_map < uint32_t, uint32_t > pmcidmap;
 
-	if ((ps = static_cast < struct pmclog_parse_state *>(pmclog_open(infd)))== NULL)
+	if ((ps = static_cast < struct pmclog_parse_state *>(pmclog_open_mmap(infd)))== NULL)
 		errx(EX_OSERR, "ERROR: Cannot allocate pmclog parse state: %s\n", strerror(errno));
 
-	threadcount = proccount = eventcount = pmccount = 0;
+	if (columnar)
+		colstate = pmccolumnar_open(outfd);
+
+	threadcount = proccount = eventcount = 0;
 	if (processes)
 		parse_names(processes, proclist, &proccount);
 	if (threads)
 		parse_names(threads, threadlist, &threadcount);
+	/*
+	 * A single pass suffices: the cpuid needed to translate event names
+	 * arrives in the INITIALIZE record at the head of the log, and every
+	 * pmc is allocated before the samples that reference it, so the
+	 * pmcid map can be built as the records stream by.
+	 */
 	while (pmclog_read(ps, &ev) == 0) {
-		if (ev.pl_type == PMCLOG_TYPE_INITIALIZE)
+		if (ev.pl_type == PMCLOG_TYPE_INITIALIZE) {
 			memcpy(cpuid, ev.pl_u.pl_i.pl_cpuid, PMC_CPUID_LEN);
-		if (ev.pl_type == PMCLOG_TYPE_PMCALLOCATE)
-			pmccount++;
-	}
-	if (events)
-		parse_events(events, eventlist, &eventcount, cpuid);
-	lseek(infd, 0, SEEK_SET);
-	pmclog_close(ps);
-	if ((ps = static_cast < struct pmclog_parse_state *>(pmclog_open(infd)))== NULL)
-		errx(EX_OSERR, "ERROR: Cannot allocate pmclog parse state: %s\n", strerror(errno));
-	if ((pe = (struct pmcid_ent *) malloc(sizeof(*pe) * pmccount)) == NULL)
-		errx(EX_OSERR, "ERROR: failed to allocate pmcid map");
-	i = 0;
-	while (pmclog_read(ps, &ev) == 0 && i < pmccount) {
-		if (ev.pl_type == PMCLOG_TYPE_PMCALLOCATE) {
-			pe[i].pe_pmcid = ev.pl_u.pl_a.pl_pmcid;
-			pe[i].pe_idx = ev.pl_u.pl_a.pl_event;
-			i++;
+			if (events) {
+				parse_events(events, eventlist, &eventcount,
+				    cpuid);
+				events = NULL;
+			}
 		}
-	}
-	lseek(infd, 0, SEEK_SET);
-	pmclog_close(ps);
-	if ((ps = static_cast < struct pmclog_parse_state *>(pmclog_open(infd)))== NULL)
-		errx(EX_OSERR, "ERROR: Cannot allocate pmclog parse state: %s\n", strerror(errno));
-	copies = 0;
-	while (pmclog_read(ps, &ev) == 0) {
+		if (ev.pl_type == PMCLOG_TYPE_PMCALLOCATE)
+			pmcidmap[ev.pl_u.pl_a.pl_pmcid] = ev.pl_u.pl_a.pl_event;
 		if (ev.pl_type == PMCLOG_TYPE_THR_CREATE)
 			tidmap[ev.pl_u.pl_tc.pl_tid] = ev.pl_u.pl_tc.pl_tdname;
 		if (ev.pl_type == PMCLOG_TYPE_PROC_CREATE)
@@ -271,15 +301,12 @@ pmc_filter_handler(uint32_t *lwplist, int lwpcount, uint32_t *pidlist, int pidco
 				continue;
 		}
 		if (eventcount) {
-			for (i = 0; i < pmccount; i++) {
-				if (pe[i].pe_pmcid == ev.pl_u.pl_cc.pl_pmcid)
-					break;
-			}
-			if (i == pmccount)
+			auto kvpair = pmcidmap.find(ev.pl_u.pl_cc.pl_pmcid);
+			if (kvpair == pmcidmap.end())
 				errx(EX_USAGE, "ERROR: unallocated pmcid: %d\n",
 				    ev.pl_u.pl_cc.pl_pmcid);
 
-			idx = pe[i].pe_idx;
+			idx = kvpair->second;
 			for (i = 0; i < eventcount; i++) {
 				if (idx == eventlist[i])
 					break;
@@ -295,29 +322,43 @@ pmc_filter_handler(uint32_t *lwplist, int lwpcount, uint32_t *pidlist, int pidco
 			continue;
 		pmc_log_event(outfd, &ev, json);
 	}
+	if (colstate != NULL) {
+		if (pmccolumnar_close(colstate) < 0)
+			errx(EX_OSERR, "ERROR: failed output write");
+	} else
+		pmc_flush_output(outfd);
 }
 
-int
-cmd_pmc_filter(int argc, char **argv)
+static int
+pmc_filter_main(int argc, char **argv, bool do_summary)
 {
 	char *lwps, *pids, *events, *processes, *threads;
 	uint32_t lwplist[LIST_MAX];
 	uint32_t pidlist[LIST_MAX];
-	int option, lwpcount, pidcount;
+	int option, lwpcount, pidcount, topk;
 	int prelogfd, postlogfd;
-	bool exclusive, json;
+	bool exclusive, json, columnar;
+	const char *optstring;
 
 	threads = processes = lwps = pids = events = NULL;
 	lwpcount = pidcount = 0;
-	json = exclusive = false;
-	while ((option = getopt_long(argc, argv, "e:jp:t:xP:T:", longopts, NULL)) != -1) {
+	topk = 5;
+	columnar = json = exclusive = false;
+	optstring = do_summary ? "e:k:p:t:xP:T:" : "ce:jp:t:xP:T:";
+	while ((option = getopt_long(argc, argv, optstring, longopts, NULL)) != -1) {
 		switch (option) {
+		case 'c':
+			columnar = true;
+			break;
 		case 'e':
 			events = strdup(optarg);
 			break;
 		case 'j':
 			json = true;
 			break;
+		case 'k':
+			topk = atoi(optarg);
+			break;
 		case 'p':
 			pids = strdup(optarg);
 			break;
@@ -340,7 +381,7 @@ cmd_pmc_filter(int argc, char **argv)
 	}
 	argc -= optind;
 	argv += optind;
-	if (argc != 2)
+	if (argc != (do_summary ? 1 : 2))
 		usage();
 
 	if (lwps)
@@ -351,12 +392,39 @@ cmd_pmc_filter(int argc, char **argv)
 	    S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) < 0)
 		errx(EX_OSERR, "ERROR: Cannot open \"%s\" for reading: %s.", argv[0],
 		    strerror(errno));
-	if ((postlogfd = open(argv[1], O_WRONLY | O_CREAT | O_TRUNC,
+	postlogfd = -1;
+	if (!do_summary && (postlogfd = open(argv[1], O_WRONLY | O_CREAT | O_TRUNC,
 	    S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)) < 0)
 		errx(EX_OSERR, "ERROR: Cannot open \"%s\" for writing: %s.", argv[1],
 		    strerror(errno));
 
+	if (json && columnar)
+		usage();
+
+	summarize = do_summary;
 	pmc_filter_handler(lwplist, lwpcount, pidlist, pidcount, events,
-	    processes, threads, exclusive, json, prelogfd, postlogfd);
+	    processes, threads, exclusive, json, columnar, prelogfd,
+	    postlogfd);
+	if (do_summary)
+		return (pmc_summary_report(topk, 0));
 	return (0);
 }
+
+int
+cmd_pmc_filter(int argc, char **argv)
+{
+
+	return (pmc_filter_main(argc, argv, false));
+}
+
+/*
+ * In-process filter -> summary pipeline: aggregate the records that
+ * survive filtering over a single pass of the source log, instead of
+ * writing an intermediate filtered log and parsing it a second time.
+ */
+int
+cmd_pmc_filter_summary(int argc, char **argv)
+{
+
+	return (pmc_filter_main(argc, argv, true));
+}
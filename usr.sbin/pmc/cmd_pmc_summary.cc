@@ -89,21 +89,76 @@ usage(void)
 	errx(EX_USAGE,
 	    "\t summarize log file\n"
 		 "\t -k <k>, --topk <k> show topk processes for each counter\n"
+		 "\t -s, --stream use bounded memory regardless of log size\n"
 	    );
 }
 
+/*
+ * Bounded top-k tracking for streaming summaries, using the space-saving
+ * algorithm: at most 'maxnames' processes are tracked per event.  When a
+ * new name arrives with the table full, the smallest counter is evicted
+ * and its count inherited, which may overestimate a newcomer but never
+ * underestimates a heavy hitter, and keeps memory constant no matter how
+ * large the log is.
+ */
+struct topksketch {
+	topksketch(size_t capacity) : maxnames(capacity) {}
+
+	void
+	observe(const std::string &name)
+	{
+		auto it = names.find(name);
+
+		if (it != names.end()) {
+			it->second++;
+			return;
+		}
+		if (names.size() < maxnames) {
+			names[name] = 1;
+			return;
+		}
+		auto minit = names.begin();
+		for (auto i = names.begin(); i != names.end(); ++i)
+			if (i->second < minit->second)
+				minit = i;
+		auto mincount = minit->second;
+		names.erase(minit);
+		names[name] = mincount + 1;
+	}
+
+	std::vector<samplename>
+	top(void) const
+	{
+		std::vector<samplename> samplevec;
+
+		for (auto &kv : names)
+			samplevec.emplace_back(kv.second, kv.first);
+		std::sort(samplevec.begin(), samplevec.end(),
+		    [](auto &a, auto &b) {return (a.first > b.first);});
+		return (samplevec);
+	}
+
+	size_t maxnames;
+	unordered_map<std::string, uint64_t> names;
+};
+typedef unordered_map <uint32_t, topksketch> sketchmap;
+
 static int
-pmc_summary_handler(int logfd, int k, bool do_full)
+pmc_summary_stream_handler(int logfd, int k)
 {
 	struct pmclog_parse_state *ps;
 	struct pmclog_ev ev;
-	idmap pidmap, tidmap, eventnamemap;
-	strintmap tideventmap, pideventmap;
-	intmap eventmap, pmcidmap, ratemap;
-	intmap kerntidmap, kernpidmap;
-	eventcountmap countmap;
+	idmap pidmap, eventnamemap;
+	intmap pmcidmap, ratemap;
+	sketchmap sketches;
+	size_t capacity;
 
-	ps = static_cast<struct pmclog_parse_state*>(pmclog_open(logfd));
+	/*
+	 * Track several times as many names as we will report, so that
+	 * heavy hitters cannot be displaced by churn among the tail.
+	 */
+	capacity = MAX((size_t)k * 8, (size_t)64);
+	ps = static_cast<struct pmclog_parse_state*>(pmclog_open_mmap(logfd));
 	if (ps == NULL)
 		errx(EX_OSERR, "ERROR: Cannot allocate pmclog parse state: %s\n",
 			 strerror(errno));
@@ -113,36 +168,109 @@ pmc_summary_handler(int logfd, int k, bool do_full)
 			ratemap[ev.pl_u.pl_a.pl_event] = ev.pl_u.pl_a.pl_rate;
 			eventnamemap[ev.pl_u.pl_a.pl_event] = ev.pl_u.pl_a.pl_evname;
 		}
-		if (ev.pl_type == PMCLOG_TYPE_THR_CREATE) {
-			tidmap[ev.pl_u.pl_tc.pl_tid] = ev.pl_u.pl_tc.pl_tdname;
-			kerntidmap[ev.pl_u.pl_tc.pl_tid] = !!(ev.pl_u.pl_tc.pl_flags & P_KPROC);
-			if (tideventmap.find(ev.pl_u.pl_tc.pl_tdname) == tideventmap.end())
-				tideventmap[ev.pl_u.pl_tc.pl_tdname] = intmap();
-		}
 		if (ev.pl_type == PMCLOG_TYPE_PROC_CREATE) {
+			/* Bounded by the pid space; reused pids overwrite. */
 			pidmap[ev.pl_u.pl_pc.pl_pid] = ev.pl_u.pl_pc.pl_pcomm;
-			kernpidmap[ev.pl_u.pl_pc.pl_pid] = !!(ev.pl_u.pl_pc.pl_flags & P_KPROC);
-			if (pideventmap.find(ev.pl_u.pl_pc.pl_pcomm) == pideventmap.end())
-				pideventmap[ev.pl_u.pl_pc.pl_pcomm] = intmap();
 		}
 		if (ev.pl_type == PMCLOG_TYPE_CALLCHAIN) {
 			auto event = pmcidmap[ev.pl_u.pl_cc.pl_pmcid];
 
 			if (event == 0)
 				continue;
-			eventmap[event]++;
-			auto tidname = tidmap.find(ev.pl_u.pl_cc.pl_tid);
 			auto pidname = pidmap.find(ev.pl_u.pl_cc.pl_pid);
-			if (tidname != tidmap.end()) {
-				auto &teventmap = tideventmap[tidname->second];
-				teventmap[event]++;
-			}
-			if (pidname != pidmap.end()) {
-				auto &peventmap = pideventmap[pidname->second];
-				peventmap[event]++;
-			}
+			if (pidname == pidmap.end())
+				continue;
+			auto sketch = sketches.find(event);
+			if (sketch == sketches.end())
+				sketch = sketches.emplace(event,
+				    topksketch(capacity)).first;
+			sketch->second.observe(pidname->second);
 		}
 	}
+	for (auto &kv : sketches) {
+		auto &name = eventnamemap[kv.first];
+		auto rate = ratemap[kv.first];
+		auto samplevec = kv.second.top();
+		std::cout << name << ":" << std::endl;
+		for (auto i = 0; i < k && (size_t)i < samplevec.size(); i++)
+			std::cout << "\t" << samplevec[i].second << ": " <<
+			    samplevec[i].first*rate << std::endl;
+	}
+	return (0);
+}
+
+/*
+ * Aggregation state.  File scope so that the in-process
+ * filter -> summary pipeline (pmc filter-summary) can feed records
+ * through pmc_summary_observe() as they survive filtering.
+ *
+ * Samples are counted under integer keys combining the event index
+ * with the pid or tid; names are only resolved when the counts are
+ * merged into per-name tables at report time.  That keeps the
+ * per-sample cost to a few integer hash increments, with all string
+ * hashing deferred to the (small) final merge.
+ */
+typedef unordered_map <uint64_t, uint64_t> samplemap;
+#define	SAMPLE_KEY(event, id)	(((uint64_t)(event) << 32) | (uint32_t)(id))
+
+static idmap pidmap, tidmap, eventnamemap;
+static strintmap tideventmap, pideventmap;
+static intmap eventmap, pmcidmap, ratemap;
+static intmap kerntidmap, kernpidmap;
+static samplemap pidsamples, tidsamples;
+
+void
+pmc_summary_observe(struct pmclog_ev *ev)
+{
+
+	if (ev->pl_type == PMCLOG_TYPE_PMCALLOCATE) {
+		pmcidmap[ev->pl_u.pl_a.pl_pmcid] = ev->pl_u.pl_a.pl_event;
+		ratemap[ev->pl_u.pl_a.pl_event] = ev->pl_u.pl_a.pl_rate;
+		eventnamemap[ev->pl_u.pl_a.pl_event] = ev->pl_u.pl_a.pl_evname;
+	}
+	if (ev->pl_type == PMCLOG_TYPE_THR_CREATE) {
+		tidmap[ev->pl_u.pl_tc.pl_tid] = ev->pl_u.pl_tc.pl_tdname;
+		kerntidmap[ev->pl_u.pl_tc.pl_tid] = !!(ev->pl_u.pl_tc.pl_flags & P_KPROC);
+		if (tideventmap.find(ev->pl_u.pl_tc.pl_tdname) == tideventmap.end())
+			tideventmap[ev->pl_u.pl_tc.pl_tdname] = intmap();
+	}
+	if (ev->pl_type == PMCLOG_TYPE_PROC_CREATE) {
+		pidmap[ev->pl_u.pl_pc.pl_pid] = ev->pl_u.pl_pc.pl_pcomm;
+		kernpidmap[ev->pl_u.pl_pc.pl_pid] = !!(ev->pl_u.pl_pc.pl_flags & P_KPROC);
+		if (pideventmap.find(ev->pl_u.pl_pc.pl_pcomm) == pideventmap.end())
+			pideventmap[ev->pl_u.pl_pc.pl_pcomm] = intmap();
+	}
+	if (ev->pl_type == PMCLOG_TYPE_CALLCHAIN) {
+		auto event = pmcidmap[ev->pl_u.pl_cc.pl_pmcid];
+
+		if (event == 0)
+			return;
+		eventmap[event]++;
+		pidsamples[SAMPLE_KEY(event, ev->pl_u.pl_cc.pl_pid)]++;
+		tidsamples[SAMPLE_KEY(event, ev->pl_u.pl_cc.pl_tid)]++;
+	}
+}
+
+int
+pmc_summary_report(int k, int do_full)
+{
+	eventcountmap countmap;
+
+	/* Resolve ids to names and merge the deferred sample counts. */
+	for (auto &skv : pidsamples) {
+		auto pidname = pidmap.find((uint32_t)skv.first);
+
+		if (pidname == pidmap.end())
+			continue;
+		pideventmap[pidname->second][skv.first >> 32] += skv.second;
+	}
+	for (auto &skv : tidsamples) {
+		auto tidname = tidmap.find((uint32_t)skv.first);
+
+		if (tidname == tidmap.end())
+			continue;
+		tideventmap[tidname->second][skv.first >> 32] += skv.second;
+	}
 	for (auto &pkv : pideventmap)
 		for (auto &ekv : pkv.second) {
 			auto &samplevec = countmap[ekv.first];
@@ -176,9 +304,25 @@ pmc_summary_handler(int logfd, int k, bool do_full)
 	return (0);
 }
 
+static int
+pmc_summary_handler(int logfd, int k, bool do_full)
+{
+	struct pmclog_parse_state *ps;
+	struct pmclog_ev ev;
+
+	ps = static_cast<struct pmclog_parse_state*>(pmclog_open_mmap(logfd));
+	if (ps == NULL)
+		errx(EX_OSERR, "ERROR: Cannot allocate pmclog parse state: %s\n",
+			 strerror(errno));
+	while (pmclog_read(ps, &ev) == 0)
+		pmc_summary_observe(&ev);
+	return (pmc_summary_report(k, do_full));
+}
+
 static struct option longopts[] = {
 	{"full", no_argument, NULL, 'f'},
 	{"topk", required_argument, NULL, 'k'},
+	{"stream", no_argument, NULL, 's'},
 	{NULL, 0, NULL, 0}
 };
 
@@ -186,11 +330,12 @@ int
 cmd_pmc_summary(int argc, char **argv)
 {
 	int option, logfd, k;
-	bool do_full;
+	bool do_full, do_stream;
 
 	do_full = false;
+	do_stream = false;
 	k = 5;
-	while ((option = getopt_long(argc, argv, "k:f", longopts, NULL)) != -1) {
+	while ((option = getopt_long(argc, argv, "k:fs", longopts, NULL)) != -1) {
 		switch (option) {
 		case 'f':
 			do_full = 1;
@@ -198,6 +343,9 @@ cmd_pmc_summary(int argc, char **argv)
 		case 'k':
 			k = atoi(optarg);
 			break;
+		case 's':
+			do_stream = true;
+			break;
 		case '?':
 		default:
 			usage();
@@ -216,5 +364,10 @@ cmd_pmc_summary(int argc, char **argv)
 		errx(EX_OSERR, "ERROR: Cannot open \"%s\" for reading: %s.", argv[0],
 		    strerror(errno));
 
+	if (do_stream) {
+		if (do_full)
+			usage();
+		return (pmc_summary_stream_handler(logfd, k));
+	}
 	return (pmc_summary_handler(logfd, k, do_full));
 }
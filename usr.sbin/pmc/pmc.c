@@ -66,6 +66,7 @@ static struct cmd_handler disp_table[] = {
 	{"stat-system", cmd_pmc_stat_system},
 	{"list-events", cmd_pmc_list_events},
 	{"filter", cmd_pmc_filter},
+	{"filter-summary", cmd_pmc_filter_summary},
 	{"summary", cmd_pmc_summary},
 	{NULL, NULL}
 };
@@ -79,6 +80,7 @@ usage(void)
 		 "\t stat-system <program> run program and print system wide stats for duration of execution\n"
 		 "\t list-events list PMC events available on host\n"
 		 "\t filter filter records by lwp, pid, or event\n"
+		 "\t filter-summary filter and summarize records in one pass\n"
 	    );
 }
 
@@ -0,0 +1,222 @@
+/*-
+ * SPDX-License-Identifier: BSD-2-Clause-FreeBSD
+ *
+ * $FreeBSD$
+ */
+
+/*
+ * pmclog-gen -- synthesize hwpmc(4) log files for benchmarking the
+ * pmclog(3) toolchain.  The generated stream carries a fixed prologue
+ * (initialization, one dynamic PMC allocation, and a population of
+ * processes and threads) followed by a deterministic mix of callchain
+ * and mapping records, so repeated runs measure the same work.
+ *
+ * This program is not part of the system build; it is compiled on
+ * demand by the 'benchmark' target in the Makefile.
+ */
+
+#include <sys/param.h>
+#include <sys/pmc.h>
+#include <sys/pmclog.h>
+#include <sys/stat.h>
+
+#include <err.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <machine/pmc_mdep.h>
+
+#define	GEN_HEADER(T, L)						\
+	((PMCLOG_HEADER_MAGIC << 24) | ((T) << 16) | (L))
+
+#define	GEN_NPROC	64
+#define	GEN_NTHR	4
+#define	GEN_PMCID	0x10001
+#define	GEN_DEPTH	16
+
+static uint64_t gen_tsc;
+static uint32_t gen_seed = 0x5bd1e995;
+static long gen_emitted;
+
+static uint32_t
+gen_random(void)
+{
+
+	gen_seed = gen_seed * 1103515245 + 12345;
+	return (gen_seed >> 8);
+}
+
+static void
+emit(int fd, void *rec, size_t len, int type)
+{
+	struct pmclog_header *h;
+
+	h = rec;
+	h->pl_header = GEN_HEADER(type, (uint32_t)len);
+	h->pl_spare = 0;
+	h->pl_tsc = (gen_tsc += 1000);
+	if (write(fd, rec, len) != (ssize_t)len)
+		err(EX_IOERR, "ERROR: write failed");
+	gen_emitted++;
+}
+
+static void
+emit_prologue(int fd)
+{
+	struct pmclog_initialize init;
+	struct pmclog_pmcallocatedyn ad;
+	struct pmclog_proccreate pc;
+	struct pmclog_threadcreate tc;
+	uint32_t pid, tid;
+
+	memset(&init, 0, sizeof(init));
+	init.pl_version = PMC_VERSION;
+	init.pl_cpu = 0;
+	init.pl_tsc_freq = 1000000000;
+	strlcpy(init.pl_cpuid, "pmclog-gen synthetic", sizeof(init.pl_cpuid));
+	emit(fd, &init, sizeof(init), PMCLOG_TYPE_INITIALIZE);
+
+	memset(&ad, 0, sizeof(ad));
+	ad.pl_pmcid = GEN_PMCID;
+	ad.pl_event = 0;
+	ad.pl_flags = 0;
+	strlcpy(ad.pl_evname, "synthetic-cycles", sizeof(ad.pl_evname));
+	emit(fd, &ad, sizeof(ad), PMCLOG_TYPE_PMCALLOCATEDYN);
+
+	for (pid = 1; pid <= GEN_NPROC; pid++) {
+		memset(&pc, 0, sizeof(pc));
+		pc.pl_pid = pid;
+		snprintf(pc.pl_pcomm, sizeof(pc.pl_pcomm), "proc%u", pid);
+		emit(fd, &pc, sizeof(pc), PMCLOG_TYPE_PROC_CREATE);
+		for (tid = 0; tid < GEN_NTHR; tid++) {
+			memset(&tc, 0, sizeof(tc));
+			tc.pl_tid = pid * GEN_NTHR + tid;
+			tc.pl_pid = pid;
+			snprintf(tc.pl_tdname, sizeof(tc.pl_tdname),
+			    "thr%u.%u", pid, tid);
+			emit(fd, &tc, sizeof(tc), PMCLOG_TYPE_THR_CREATE);
+		}
+	}
+}
+
+static void
+emit_callchain(int fd, int depth)
+{
+	struct pmclog_callchain cc;
+	uint32_t pid;
+	int i;
+
+	memset(&cc, 0, sizeof(cc));
+	pid = gen_random() % GEN_NPROC + 1;
+	cc.pl_pid = pid;
+	cc.pl_tid = pid * GEN_NTHR + gen_random() % GEN_NTHR;
+	cc.pl_pmcid = GEN_PMCID;
+	cc.pl_cpuflags = PMC_CALLCHAIN_TO_CPUFLAGS(gen_random() % 8,
+	    PMC_CC_F_USERSPACE);
+	for (i = 0; i < depth; i++)
+		cc.pl_pc[i] = 0x400000 + gen_random() % 0x100000;
+	emit(fd, &cc, offsetof(struct pmclog_callchain, pl_pc) +
+	    depth * sizeof(uintptr_t), PMCLOG_TYPE_CALLCHAIN);
+}
+
+static void
+emit_mapping(int fd)
+{
+	struct pmclog_map_in mi;
+	struct pmclog_map_out mo;
+	uint32_t pid;
+	size_t pathlen;
+	uintfptr_t start;
+
+	pid = gen_random() % GEN_NPROC + 1;
+	start = 0x800000000 + (uintfptr_t)(gen_random() % 1024) * 0x10000;
+
+	memset(&mi, 0, sizeof(mi));
+	mi.pl_pid = pid;
+	mi.pl_start = start;
+	pathlen = snprintf(mi.pl_pathname, sizeof(mi.pl_pathname),
+	    "/usr/lib/libsynthetic-%u.so.1", gen_random() % 128) + 1;
+	emit(fd, &mi, offsetof(struct pmclog_map_in, pl_pathname) +
+	    roundup2(pathlen, 4), PMCLOG_TYPE_MAP_IN);
+
+	memset(&mo, 0, sizeof(mo));
+	mo.pl_pid = pid;
+	mo.pl_start = start;
+	mo.pl_end = start + 0x10000;
+	emit(fd, &mo, sizeof(mo), PMCLOG_TYPE_MAP_OUT);
+}
+
+static void
+usage(void)
+{
+
+	errx(EX_USAGE, "\t generate a synthetic pmclog file\n"
+	    "\t -d <depth> -- callchain depth, 1..%d (default %d)\n"
+	    "\t -m <mix> -- callchain | mapping | mixed (default mixed)\n"
+	    "\t -n <count> -- number of sample records (default 1000000)\n"
+	    "\t <output-file>", PMC_CALLCHAIN_DEPTH_MAX, GEN_DEPTH);
+}
+
+int
+main(int argc, char **argv)
+{
+	long nrecords, i;
+	int callchain_pct, depth, fd, option;
+
+	nrecords = 1000000;
+	depth = GEN_DEPTH;
+	callchain_pct = 50;
+	while ((option = getopt(argc, argv, "d:m:n:")) != -1)
+		switch (option) {
+		case 'd':
+			depth = atoi(optarg);
+			if (depth < 1 || depth > PMC_CALLCHAIN_DEPTH_MAX)
+				usage();
+			break;
+		case 'm':
+			if (strcmp(optarg, "callchain") == 0)
+				callchain_pct = 90;
+			else if (strcmp(optarg, "mapping") == 0)
+				callchain_pct = 10;
+			else if (strcmp(optarg, "mixed") == 0)
+				callchain_pct = 50;
+			else
+				usage();
+			break;
+		case 'n':
+			nrecords = atol(optarg);
+			if (nrecords <= 0)
+				usage();
+			break;
+		default:
+			usage();
+		}
+	argc -= optind;
+	argv += optind;
+	if (argc != 1)
+		usage();
+
+	if ((fd = open(argv[0], O_WRONLY | O_CREAT | O_TRUNC,
+	    S_IRUSR | S_IWUSR)) < 0)
+		err(EX_OSERR, "ERROR: Cannot open \"%s\" for writing",
+		    argv[0]);
+
+	emit_prologue(fd);
+	for (i = 0; i < nrecords; i++) {
+		if (gen_random() % 100 < (uint32_t)callchain_pct)
+			emit_callchain(fd, depth);
+		else
+			emit_mapping(fd);
+	}
+	close(fd);
+
+	/* Report the exact record count for throughput calculations. */
+	printf("%ld\n", gen_emitted);
+	return (0);
+}